@@ -0,0 +1,101 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "BrowserPages.h"
+#include <iterator>
+
+namespace
+{
+    struct PageInfo
+    {
+        const wchar_t* name;
+        const wchar_t* relativePath;
+    };
+
+    const PageInfo c_pageInfo[] = {
+        { L"", L"" },
+        { L"favorites", L"wvbrowser_ui\\content_ui\\favorites.html" },
+        { L"settings", L"wvbrowser_ui\\content_ui\\settings.html" },
+        { L"history", L"wvbrowser_ui\\content_ui\\history.html" },
+        { L"metrics", L"wvbrowser_ui\\content_ui\\metrics.html" },
+        { L"tasks", L"wvbrowser_ui\\content_ui\\tasks.html" },
+    };
+    static_assert(std::size(c_pageInfo) == static_cast<size_t>(BrowserPage::Count), "Missing browser page");
+
+    const wchar_t c_browserScheme[] = L"browser://";
+
+    // FNV-1a, never 0 so an empty slot can't match
+    uint32_t HashUri(std::wstring_view uri)
+    {
+        uint32_t hash = 2166136261u;
+        for (wchar_t c : uri)
+            hash = (hash ^ static_cast<uint32_t>(c)) * 16777619u;
+        return hash | 1;
+    }
+}
+
+std::wstring_view BrowserPageRegistry::GetName(BrowserPage page)
+{
+    return c_pageInfo[Index(page)].name;
+}
+
+const wchar_t* BrowserPageRegistry::GetRelativePath(BrowserPage page)
+{
+    return c_pageInfo[Index(page)].relativePath;
+}
+
+void BrowserPageRegistry::Register(BrowserPage page, std::wstring filePath, std::wstring fileUri)
+{
+    Page& entry = m_pages[Index(page)];
+    entry.filePath = std::move(filePath);
+    entry.fileUri = std::move(fileUri);
+    entry.browserUri = c_browserScheme;
+    entry.browserUri.append(GetName(page));
+
+    Insert(m_fileUris, entry.fileUri, page);
+    Insert(m_browserUris, entry.browserUri, page);
+}
+
+BrowserPage BrowserPageRegistry::FromFileUri(std::wstring_view uri) const
+{
+    return Find(m_fileUris, &Page::fileUri, uri);
+}
+
+BrowserPage BrowserPageRegistry::FromBrowserUri(std::wstring_view uri) const
+{
+    return Find(m_browserUris, &Page::browserUri, uri);
+}
+
+void BrowserPageRegistry::Insert(LookupTable& table, std::wstring_view key, BrowserPage page)
+{
+    // Empty keys (a file URI that failed to resolve) must never match
+    if (key.empty())
+        return;
+
+    uint32_t hash = HashUri(key);
+    for (size_t i = hash; ; ++i)
+    {
+        size_t slot = i & (c_slotCount - 1);
+        if (table.slots[slot] == BrowserPage::None || table.slots[slot] == page)
+        {
+            table.hashes[slot] = hash;
+            table.slots[slot] = page;
+            return;
+        }
+    }
+}
+
+BrowserPage BrowserPageRegistry::Find(const LookupTable& table, std::wstring Page::* key, std::wstring_view value) const
+{
+    uint32_t hash = HashUri(value);
+    for (size_t i = hash; ; ++i)
+    {
+        size_t slot = i & (c_slotCount - 1);
+        BrowserPage page = table.slots[slot];
+        if (page == BrowserPage::None)
+            return BrowserPage::None;
+        if (table.hashes[slot] == hash && m_pages[Index(page)].*key == value)
+            return page;
+    }
+}
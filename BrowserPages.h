@@ -0,0 +1,69 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// The pages shown under browser://. Only these pages can request favorites,
+// settings, history, metrics or tasks from the host.
+enum class BrowserPage : uint8_t
+{
+    None,
+    Favorites,
+    Settings,
+    History,
+    Metrics,
+    Tasks,
+    Count
+};
+
+// Resolves the file path and canonical file URI of every browser page once
+// at startup, so checking which page a tab shows is a hash and a compare
+// instead of a module path query and a CreateUri call per event.
+class BrowserPageRegistry
+{
+public:
+    // e.g. L"favorites" and L"wvbrowser_ui\\content_ui\\favorites.html"
+    static std::wstring_view GetName(BrowserPage page);
+    static const wchar_t* GetRelativePath(BrowserPage page);
+
+    void Register(BrowserPage page, std::wstring filePath, std::wstring fileUri);
+
+    // By the file URI a tab reports as its source
+    BrowserPage FromFileUri(std::wstring_view uri) const;
+    // By the browser://name typed in the address bar
+    BrowserPage FromBrowserUri(std::wstring_view uri) const;
+
+    const std::wstring& GetFilePath(BrowserPage page) const { return m_pages[Index(page)].filePath; }
+    std::wstring_view GetBrowserUri(BrowserPage page) const { return m_pages[Index(page)].browserUri; }
+
+private:
+    static constexpr size_t c_pageCount = static_cast<size_t>(BrowserPage::Count);
+    static constexpr size_t c_slotCount = 16; // Power of two, well above c_pageCount
+
+    struct Page
+    {
+        std::wstring filePath;
+        std::wstring fileUri;
+        std::wstring browserUri;
+    };
+
+    // Open addressing, slots hold page indexes and 0 (BrowserPage::None) is empty
+    struct LookupTable
+    {
+        uint32_t hashes[c_slotCount] = {};
+        BrowserPage slots[c_slotCount] = {};
+    };
+
+    static size_t Index(BrowserPage page) { return static_cast<size_t>(page); }
+    static void Insert(LookupTable& table, std::wstring_view key, BrowserPage page);
+    BrowserPage Find(const LookupTable& table, std::wstring Page::* key, std::wstring_view value) const;
+
+    Page m_pages[c_pageCount];
+    LookupTable m_fileUris;
+    LookupTable m_browserUris;
+};
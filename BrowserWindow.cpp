@@ -5,14 +5,76 @@
 #include "BrowserWindow.h"
 #include "shlobj.h"
 #include <Urlmon.h>
-#include "asyncutility.h"
+#include <psapi.h>
+#include <algorithm>
+#include "TraceRecorder.h"
 
 #pragma comment (lib, "Urlmon.lib")
+#pragma comment (lib, "psapi.lib")
 
 using namespace Microsoft::WRL;
 
 WCHAR BrowserWindow::s_windowClass[] = { 0 };
 WCHAR BrowserWindow::s_title[] = { 0 };
+SharedEnvironment BrowserWindow::s_contentEnvironment;
+SharedEnvironment BrowserWindow::s_uiEnvironment;
+std::vector<BrowserWindow*> BrowserWindow::s_windows;
+size_t BrowserWindow::s_lastWindowId = 0;
+DevToolsIndex BrowserWindow::s_devTools;
+std::vector<HWINEVENTHOOK> BrowserWindow::s_devToolsHooks;
+HistoryStore BrowserWindow::s_history;
+wil::unique_hfile BrowserWindow::s_historyFile;
+std::vector<uint8_t> BrowserWindow::s_historyBuffer;
+HWND BrowserWindow::s_historyFlushWindow = nullptr;
+SuggestionIndex BrowserWindow::s_suggestions;
+FavoritesStore BrowserWindow::s_favorites;
+wil::unique_hfile BrowserWindow::s_favoritesFile;
+
+namespace
+{
+    HWND ToWindow(WindowHandle window)
+    {
+        return static_cast<HWND>(const_cast<void*>(window));
+    }
+
+    // In ms since 1970 UTC, as the history keeps visits
+    int64_t GetCurrentTimestamp()
+    {
+        FILETIME now;
+        GetSystemTimeAsFileTime(&now);
+        uint64_t ticks = (static_cast<uint64_t>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+        return static_cast<int64_t>((ticks - 116444736000000000ull) / 10000); // 100 ns since 1601 to ms since 1970
+    }
+
+    class Win32WindowEnumerator : public WindowEnumerator
+    {
+    public:
+        void ForEachTopLevelWindow(const std::function<bool(WindowHandle window)>& fn) override
+        {
+            EnumWindows([](HWND hwnd, LPARAM lParam) -> BOOL
+            {
+                return (*reinterpret_cast<const std::function<bool(WindowHandle)>*>(lParam))(hwnd);
+            }, reinterpret_cast<LPARAM>(&fn));
+        }
+
+        uint32_t GetProcessId(WindowHandle window) override
+        {
+            DWORD processId = 0;
+            GetWindowThreadProcessId(ToWindow(window), &processId);
+            return processId;
+        }
+
+        // Owned popups of the browser process are skipped
+        bool IsDevToolsCandidate(WindowHandle window) override
+        {
+            HWND hwnd = ToWindow(window);
+            WCHAR className[256];
+            if (GetClassName(hwnd, className, ARRAYSIZE(className)) == 0 || wcscmp(className, L"Chrome_WidgetWin_1") != 0)
+                return false;
+            return GetParent(hwnd) == nullptr || (GetWindowLong(hwnd, GWL_STYLE) & WS_CHILD) != 0;
+        }
+    };
+}
 
 //
 //  FUNCTION: RegisterClass()
@@ -79,9 +141,15 @@ LRESULT CALLBACK BrowserWindow::WndProcStatic(HWND hWnd, UINT message, WPARAM wP
 //
 LRESULT CALLBACK BrowserWindow::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
+    TraceScope trace("WndProc", "message", message);
 
     switch (message)
     {
+    case c_runContinuationsMessage:
+    {
+        m_executor.RunContinuations();
+    }
+    break;
     case WM_GETMINMAXINFO:
     {
         MINMAXINFO* minmax = reinterpret_cast<MINMAXINFO*>(lParam);
@@ -91,36 +159,95 @@ LRESULT CALLBACK BrowserWindow::WndProc(HWND hWnd, UINT message, WPARAM wParam,
     break;
     case WM_DPICHANGED:
     {
+        m_layoutMetrics = LayoutMetrics();
         UpdateMinWindowSize();
     }
+    [[fallthrough]];
     case WM_SIZE:
     {
-        ResizeUIWebViews();
-        if (m_tabs.find(m_activeTabId) != m_tabs.end())
+        ScheduleLayout();
+    }
+    break;
+    case WM_TIMER:
+    {
+        if (wParam == c_flushUpdatesTimerId)
+        {
+            KillTimer(hWnd, c_flushUpdatesTimerId);
+            CheckFailure(FlushControlsUpdates(), L"Can't update the browser controls.");
+        }
+        else if (wParam == c_hibernationTimerId)
+        {
+            UpdateHibernation();
+        }
+        else if (wParam == c_sessionTimerId)
+        {
+            if (!SUCCEEDED(FlushSession()))
+            {
+                OutputDebugString(L"Session couldn't be saved\n");
+            }
+        }
+        else if (wParam == c_taskSamplerTimerId)
         {
-            m_tabs.at(m_activeTabId)->ResizeWebView();
+            SampleTasks([this]() { UpdateHibernation(); });
+        }
+        else if (wParam == c_layoutTimerId)
+        {
+            KillTimer(hWnd, c_layoutTimerId);
+            m_isLayoutPending = false;
+            UpdateLayout();
+        }
+        else if (wParam == c_historyTimerId)
+        {
+            if (!SUCCEEDED(FlushHistory()))
+            {
+                OutputDebugString(L"History couldn't be saved\n");
+            }
         }
     }
     break;
     case WM_CLOSE:
     {
-        web::json::value jsonObj = web::json::value::parse(L"{}");
-        jsonObj[L"message"] = web::json::value(MG_CLOSE_WINDOW);
-        jsonObj[L"args"] = web::json::value::parse(L"{}");
-
-        CheckFailure(PostJsonToWebView(jsonObj, m_controlsWebView.Get()), L"Try again.");
+        CheckFailure(PostMessageToWebView(CloseWindowMessage(), m_controlsWebView.Get()), L"Try again.");
     }
     break;
     case WM_NCDESTROY:
     {
-        SetWindowLongPtr(hWnd, GWLP_USERDATA, NULL);
+        SetWindowLongPtr(hWnd, GWLP_USERDATA, 0);
+        s_windows.erase(std::remove(s_windows.begin(), s_windows.end(), this), s_windows.end());
+        bool isLastWindow = s_windows.empty();
         delete this;
-        PostQuitMessage(0);
+
+        // The timer may have been this window's
+        HRESULT hr = FlushHistory();
+        if (!SUCCEEDED(hr))
+        {
+            OutputDebugString(L"History couldn't be saved\n");
+        }
+
+        if (isLastWindow)
+        {
+            // Only an index of the log as it is in the file is of use
+            if (SUCCEEDED(hr) && !SUCCEEDED(SaveHistoryIndex()))
+            {
+                OutputDebugString(L"History index couldn't be saved\n");
+            }
+            s_historyFile.reset();
+            s_favoritesFile.reset();
+            for (HWINEVENTHOOK hook : s_devToolsHooks)
+            {
+                UnhookWinEvent(hook);
+            }
+            s_devToolsHooks.clear();
+            s_contentEnvironment.Release();
+            s_uiEnvironment.Release();
+            PostQuitMessage(0);
+        }
     }
+    break;
     case WM_PAINT:
     {
         PAINTSTRUCT ps;
-        HDC hdc = BeginPaint(hWnd, &ps);
+        BeginPaint(hWnd, &ps);
         EndPaint(hWnd, &ps);
     }
     break;
@@ -135,6 +262,11 @@ LRESULT CALLBACK BrowserWindow::WndProc(HWND hWnd, UINT message, WPARAM wParam,
 
 
 BOOL BrowserWindow::LaunchWindow(_In_ HINSTANCE hInstance, _In_ int nCmdShow)
+{
+    return OpenWindow(hInstance, nCmdShow) != nullptr;
+}
+
+BrowserWindow* BrowserWindow::OpenWindow(HINSTANCE hInstance, int nCmdShow)
 {
     // BrowserWindow keeps a reference to itself in its host window and will
     // delete itself when the window is destroyed.
@@ -142,9 +274,64 @@ BOOL BrowserWindow::LaunchWindow(_In_ HINSTANCE hInstance, _In_ int nCmdShow)
     if (!window->InitInstance(hInstance, nCmdShow))
     {
         delete window;
-        return FALSE;
+        return nullptr;
     }
-    return TRUE;
+    return window;
+}
+
+BrowserWindow* BrowserWindow::FindWindowById(size_t windowId)
+{
+    auto it = std::find_if(s_windows.begin(), s_windows.end(),
+        [windowId](BrowserWindow* window) { return window->m_windowId == windowId; });
+    return it != s_windows.end() ? *it : nullptr;
+}
+
+// The index learns about the windows of a browser process from the events
+// of the hook added for it, seeded by one enumeration when it's first seen
+void BrowserWindow::WatchDevTools(DWORD processId)
+{
+    Win32WindowEnumerator windows;
+    if (!s_devTools.AddProcess(processId, windows))
+    {
+        return;
+    }
+
+    HWINEVENTHOOK hook = SetWinEventHook(EVENT_OBJECT_CREATE, EVENT_OBJECT_DESTROY, nullptr, OnWindowEvent,
+        processId, 0, WINEVENT_OUTOFCONTEXT);
+    if (hook == nullptr)
+    {
+        OutputDebugString(L"Can't watch the windows of the browser process\n");
+        return;
+    }
+    s_devToolsHooks.push_back(hook);
+}
+
+void CALLBACK BrowserWindow::OnWindowEvent(HWINEVENTHOOK /*hook*/, DWORD event, HWND hwnd, LONG objectId, LONG childId,
+    DWORD /*threadId*/, DWORD /*time*/)
+{
+    if (objectId != OBJID_WINDOW || childId != CHILDID_SELF)
+    {
+        return;
+    }
+
+    if (event == EVENT_OBJECT_CREATE)
+    {
+        Win32WindowEnumerator windows;
+        s_devTools.OnWindowCreated(hwnd, windows);
+    }
+    else if (event == EVENT_OBJECT_DESTROY)
+    {
+        s_devTools.OnWindowDestroyed(hwnd);
+    }
+}
+
+HWND BrowserWindow::FindDevToolsWindow(DWORD processId)
+{
+    return ToWindow(s_devTools.Find(processId, [](WindowHandle window)
+    {
+        return std::any_of(s_windows.begin(), s_windows.end(),
+            [window](BrowserWindow* browserWindow) { return browserWindow->CheckDTOwnership(ToWindow(window)); });
+    }));
 }
 
 //
@@ -162,6 +349,27 @@ BOOL BrowserWindow::InitInstance(HINSTANCE hInstance, int nCmdShow)
     m_hInst = hInstance; // Store app instance handle
     LoadStringW(m_hInst, IDS_APP_TITLE, s_title, MAX_LOADSTRING);
 
+    for (size_t i = 1; i < static_cast<size_t>(BrowserPage::Count); ++i)
+    {
+        BrowserPage page = static_cast<BrowserPage>(i);
+        std::wstring filePath = GetFullPathFor(BrowserPageRegistry::GetRelativePath(page));
+        std::wstring fileUri = GetFilePathAsURI(filePath);
+        m_browserPages.Register(page, std::move(filePath), std::move(fileUri));
+    }
+
+    // The first window restores the previous session and keeps saving it,
+    // the others start empty or with the tab moved to them. The history and
+    // the favorites are shared by all of them.
+    m_windowId = ++s_lastWindowId;
+    m_ownsSession = s_windows.empty();
+    if (m_ownsSession)
+    {
+        // Restored once the controls UI asks for it
+        LoadSession();
+        LoadHistory();
+        LoadFavorites();
+    }
+
     SetUIMessageBroker();
 
     m_hWnd = CreateWindowW(s_windowClass, s_title, WS_OVERLAPPEDWINDOW,
@@ -174,6 +382,7 @@ BOOL BrowserWindow::InitInstance(HINSTANCE hInstance, int nCmdShow)
 
     // Make the BrowserWindow instance ptr available through the hWnd
     SetWindowLongPtr(m_hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+    s_windows.push_back(this);
 
     UpdateMinWindowSize();
     ShowWindow(m_hWnd, nCmdShow);
@@ -187,14 +396,11 @@ BOOL BrowserWindow::InitInstance(HINSTANCE hInstance, int nCmdShow)
     // Create WebView environment for web content requested by the user. All
     // tabs will be created from this environment and kept isolated from the
     // browser UI. This enviroment is created first so the UI can request new
-    // tabs when it's ready.
-    HRESULT hr = CreateCoreWebView2EnvironmentWithOptions(nullptr, userDataDirectory.c_str(),
-        nullptr, Callback<ICoreWebView2CreateCoreWebView2EnvironmentCompletedHandler>(
-            [this](HRESULT result, ICoreWebView2Environment* env) -> HRESULT
+    // tabs when it's ready. Later windows share it.
+    HRESULT hr = s_contentEnvironment.Get(userDataDirectory, [this](ICoreWebView2Environment* env) -> HRESULT
     {
-        RETURN_IF_FAILED(result);
-
         m_contentEnv = env;
+        m_controllerPool.Start(m_hWnd, env);
         HRESULT hr = InitUIWebViews();
 
         if (!SUCCEEDED(hr))
@@ -203,11 +409,12 @@ BOOL BrowserWindow::InitInstance(HINSTANCE hInstance, int nCmdShow)
         }
 
         return hr;
-    }).Get());
+    });
 
     if (!SUCCEEDED(hr))
     {
         OutputDebugString(L"Content WebViews environment creation failed\n");
+        s_windows.erase(std::remove(s_windows.begin(), s_windows.end(), this), s_windows.end());
         return FALSE;
     }
 
@@ -222,9 +429,7 @@ HRESULT BrowserWindow::InitUIWebViews()
 
     // Create WebView environment for browser UI. A separate data directory is
     // used to isolate the browser UI from web content requested by the user.
-    return CreateCoreWebView2EnvironmentWithOptions(nullptr, browserDataDirectory.c_str(),
-        nullptr, Callback<ICoreWebView2CreateCoreWebView2EnvironmentCompletedHandler>(
-            [this](HRESULT result, ICoreWebView2Environment* env) -> HRESULT
+    return s_uiEnvironment.Get(browserDataDirectory, [this](ICoreWebView2Environment* env) -> HRESULT
     {
         // Environment is ready, create the WebView
         m_uiEnv = env;
@@ -235,7 +440,7 @@ HRESULT BrowserWindow::InitUIWebViews()
             SetWindowPos(GetWindow(m_hWnd, GW_HWNDNEXT), HWND_TOP, 0, 0, 0, 0, SWP_NOSIZE | SWP_NOMOVE);
 
         return S_OK;
-    }).Get());
+    });
 }
 
 HRESULT BrowserWindow::CreateBrowserControlsWebView()
@@ -257,7 +462,7 @@ HRESULT BrowserWindow::CreateBrowserControlsWebView()
         RETURN_IF_FAILED(settings->put_AreDevToolsEnabled(FALSE));
 
         RETURN_IF_FAILED(m_controlsController->add_ZoomFactorChanged(Callback<ICoreWebView2ZoomFactorChangedEventHandler>(
-            [](ICoreWebView2Controller* host, IUnknown* args) -> HRESULT
+            [](ICoreWebView2Controller* host, IUnknown* /*args*/) -> HRESULT
         {
             host->put_ZoomFactor(1.0);
             return S_OK;
@@ -293,7 +498,7 @@ HRESULT BrowserWindow::CreateBrowserOptionsWebView()
         RETURN_IF_FAILED(settings->put_AreDevToolsEnabled(FALSE));
 
         RETURN_IF_FAILED(m_optionsController->add_ZoomFactorChanged(Callback<ICoreWebView2ZoomFactorChangedEventHandler>(
-            [](ICoreWebView2Controller* host, IUnknown* args) -> HRESULT
+            [](ICoreWebView2Controller* host, IUnknown* /*args*/) -> HRESULT
         {
             host->put_ZoomFactor(1.0);
             return S_OK;
@@ -306,13 +511,9 @@ HRESULT BrowserWindow::CreateBrowserOptionsWebView()
 
         // Hide menu when focus is lost
         RETURN_IF_FAILED(m_optionsController->add_LostFocus(Callback<ICoreWebView2FocusChangedEventHandler>(
-            [this](ICoreWebView2Controller* sender, IUnknown* args) -> HRESULT
+            [this](ICoreWebView2Controller* /*sender*/, IUnknown* /*args*/) -> HRESULT
         {
-            web::json::value jsonObj = web::json::value::parse(L"{}");
-            jsonObj[L"message"] = web::json::value(MG_OPTIONS_LOST_FOCUS);
-            jsonObj[L"args"] = web::json::value::parse(L"{}");
-
-            PostJsonToWebView(jsonObj, m_controlsWebView.Get());
+            PostMessageToWebView(OptionsLostFocusMessage(), m_controlsWebView.Get());
 
             return S_OK;
         }).Get(), &m_lostOptionsFocus));
@@ -326,502 +527,1794 @@ HRESULT BrowserWindow::CreateBrowserOptionsWebView()
     }).Get());
 }
 
-// Set the message broker for the UI webview. This will capture messages from ui web content.
-// Lambda is used to capture the instance while satisfying Microsoft::WRL::Callback<T>()
-void BrowserWindow::SetUIMessageBroker()
+// Messages from the controls and options UI, dispatched through the table
+// generated from messages.json. String arguments point into the message.
+class BrowserWindow::ControlsMessageHandler
 {
-    m_uiMessageBroker = Callback<ICoreWebView2WebMessageReceivedEventHandler>(
-        [this](ICoreWebView2* webview, ICoreWebView2WebMessageReceivedEventArgs* eventArgs) -> HRESULT
+public:
+    ControlsMessageHandler(BrowserWindow& window, MessageMetrics::Scope& metrics) : m_window(window), m_metrics(metrics) {}
+
+    void OnMessage(const CreateTabMessage& createTab);
+    void OnMessage(const NavigateMessage& navigate);
+    void OnMessage(const GoForwardMessage&);
+    void OnMessage(const GoBackMessage&);
+    void OnMessage(const ReloadMessage&);
+    void OnMessage(const CancelMessage&);
+    void OnMessage(const SwitchTabMessage& switchTab);
+    void OnMessage(const CloseTabMessage& closeTab);
+    void OnMessage(const CloseWindowMessage&);
+    void OnMessage(const ShowOptionsMessage&);
+    void OnMessage(const HideOptionsMessage&);
+    void OnMessage(const OptionSelectedMessage&);
+    void OnMessage(const SetTabPolicyMessage& tabPolicy);
+    void OnMessage(const RestoreSessionMessage&);
+    void OnMessage(const MoveTabMessage& moveTab);
+    void OnMessage(const GetSuggestionsMessage& request) { m_window.RequestSuggestions(request.query, request.requestId); }
+    void OnMessage(const AddFavoriteMessage& favorite);
+    void OnMessage(const RemoveFavoriteMessage& favorite);
+    void OnMessage(const MigrateFavoritesMessage& migrate);
+
+    // Replies to requests relayed from a tab, forwarded back to it
+    void OnMessage(const RelayedMessage<MG_GET_SETTINGS>& reply) { RelayToTab(reply.Id, reply.args); }
+
+private:
+    void RelayToTab(int message, JsonValue args);
+
+    BrowserWindow& m_window;
+    MessageMetrics::Scope& m_metrics;
+};
+
+void BrowserWindow::ControlsMessageHandler::OnMessage(const CreateTabMessage& createTab)
+{
+    size_t id = createTab.tabId;
+    if (id == INVALID_TAB_ID)
     {
-        wil::unique_cotaskmem_string jsonString;
-        CheckFailure(eventArgs->get_WebMessageAsJson(&jsonString), L"");  // Get the message from the UI WebView as JSON formatted string
-        web::json::value jsonObj = web::json::value::parse(jsonString.get());
-
-        if (!jsonObj.has_field(L"message"))
-        {
-            OutputDebugString(L"No message code provided\n");
-            return S_OK;
-        }
-
-        if (!jsonObj.has_field(L"args"))
-        {
-            OutputDebugString(L"The message has no args field\n");
-            return S_OK;
-        }
-
-        int message = jsonObj.at(L"message").as_integer();
-        web::json::value args = jsonObj.at(L"args");
+        OutputDebugString(L"Create tab message with an invalid id\n");
+        return;
+    }
+    std::unique_ptr<Tab> newTab = Tab::CreateNewTab(m_window.m_hWnd, id);
+    Tab* tab = newTab.get();
 
-        switch (message)
-        {
-        case MG_CREATE_TAB:
-        {
-            size_t id = args.at(L"tabId").as_number().to_uint32();
-            bool shouldBeActive = args.at(L"active").as_bool();
-            std::unique_ptr<Tab> newTab = Tab::CreateNewTab(m_hWnd, m_contentEnv.Get(), id, shouldBeActive);
+    if (std::unique_ptr<Tab> replaced = m_window.m_tabs.Insert(id, std::move(newTab)); replaced && replaced->m_contentController)
+    {
+        replaced->m_contentController->Close();
+    }
+    uint64_t now = GetTickCount64();
+    m_window.m_hibernation.AddTab(id, now);
+    m_window.m_tasks.AddTab(id);
+    m_window.m_session.AddTab(id);
+    m_window.ScheduleSessionFlush();
+
+    // With a pooled controller the tab is created, and shown if
+    // active, before this returns
+    ComPtr<ICoreWebView2Controller> prewarmed = m_window.m_controllerPool.Take(now);
+    CheckFailure(tab->Init(m_window.m_contentEnv.Get(), prewarmed.Get(), createTab.active), L"Can't create tab.");
+}
 
-            std::map<size_t, std::unique_ptr<Tab>>::iterator it = m_tabs.find(id);
-            if (it == m_tabs.end())
-            {
-                m_tabs.insert(std::pair<size_t,std::unique_ptr<Tab>>(id, std::move(newTab)));
-            }
-            else
-            {
-                m_tabs.at(id)->m_contentController->Close();
-                it->second = std::move(newTab);
-            }
-        }
-        break;
-        case MG_NAVIGATE:
-        {
-            std::wstring uri(args.at(L"uri").as_string());
-            std::wstring browserScheme(L"browser://");
+void BrowserWindow::ControlsMessageHandler::OnMessage(const NavigateMessage& navigate)
+{
+    // Nothing to navigate until a restored tab is re-created
+    ICoreWebView2* content = m_window.GetActiveWebView();
+    if (content == nullptr)
+    {
+        return;
+    }
 
-            if (uri.substr(0, browserScheme.size()).compare(browserScheme) == 0)
-            {
-                // No encoded search URI
-                std::wstring path = uri.substr(browserScheme.size());
-                if (path.compare(L"favorites") == 0 ||
-                    path.compare(L"settings") == 0 ||
-                    path.compare(L"history") == 0)
-                {
-                    std::wstring filePath(L"wvbrowser_ui\\content_ui\\");
-                    filePath.append(path);
-                    filePath.append(L".html");
-                    std::wstring fullPath = GetFullPathFor(filePath.c_str());
-                    CheckFailure(m_tabs.at(m_activeTabId)->m_contentWebView->Navigate(fullPath.c_str()), L"Can't navigate to browser page.");
-                }
-                else
-                {
-                    OutputDebugString(L"Requested unknown browser page\n");
-                }
-            }
-            else if (!SUCCEEDED(m_tabs.at(m_activeTabId)->m_contentWebView->Navigate(uri.c_str())))
-            {
-                CheckFailure(m_tabs.at(m_activeTabId)->m_contentWebView->Navigate(args.at(L"encodedSearchURI").as_string().c_str()), L"Can't navigate to requested page.");
-            }
-        }
-        break;
-        case MG_GO_FORWARD:
-        {
-            CheckFailure(m_tabs.at(m_activeTabId)->m_contentWebView->GoForward(), L"");
-        }
-        break;
-        case MG_GO_BACK:
-        {
-            CheckFailure(m_tabs.at(m_activeTabId)->m_contentWebView->GoBack(), L"");
-        }
-        break;
-        case MG_RELOAD:
-        {
-            CheckFailure(m_tabs.at(m_activeTabId)->m_contentWebView->Reload(), L"");
-        }
-        break;
-        case MG_CANCEL:
-        {
-            CheckFailure(m_tabs.at(m_activeTabId)->m_contentWebView->CallDevToolsProtocolMethod(L"Page.stopLoading", L"{}", nullptr), L"");
-        }
-        break;
-        case MG_SWITCH_TAB:
-        {
-            size_t tabId = args.at(L"tabId").as_number().to_uint32();
+    std::wstring_view uri = navigate.uri;
+    std::wstring_view browserScheme(L"browser://");
 
-            SwitchToTab(tabId, false);
-        }
-        break;
-        case MG_CLOSE_TAB:
-        {
-            size_t id = args.at(L"tabId").as_number().to_uint32();
-            m_tabs.at(id)->m_contentController->Close();
-            m_tabs.erase(id);
-        }
-        break;
-        case MG_CLOSE_WINDOW:
-        {
-            DestroyWindow(m_hWnd);
-        }
-        break;
-        case MG_SHOW_OPTIONS:
-        {
-            CheckFailure(m_optionsController->put_IsVisible(TRUE), L"");
-            m_optionsController->MoveFocus(COREWEBVIEW2_MOVE_FOCUS_REASON_PROGRAMMATIC);
-        }
-        break;
-        case MG_HIDE_OPTIONS:
+    if (uri.substr(0, browserScheme.size()).compare(browserScheme) == 0)
+    {
+        // No encoded search URI
+        BrowserPage page = m_window.m_browserPages.FromBrowserUri(uri);
+        if (page != BrowserPage::None)
         {
-            CheckFailure(m_optionsController->put_IsVisible(FALSE), L"Something went wrong when trying to close the options dropdown.");
+            CheckFailure(content->Navigate(m_window.m_browserPages.GetFilePath(page).c_str()), L"Can't navigate to browser page.");
         }
-        break;
-        case MG_OPTION_SELECTED:
+        else
         {
-            m_tabs.at(m_activeTabId)->m_contentController->MoveFocus(COREWEBVIEW2_MOVE_FOCUS_REASON_PROGRAMMATIC);
+            OutputDebugString(L"Requested unknown browser page\n");
         }
-        break;
-        case MG_GET_FAVORITES:
-        case MG_GET_SETTINGS:
-        case MG_GET_HISTORY:
-        {
-            // Forward back to requesting tab
-            size_t tabId = args.at(L"tabId").as_number().to_uint32();
-            jsonObj[L"args"].erase(L"tabId");
+    }
+    else if (!SUCCEEDED(content->Navigate(uri.data())))
+    {
+        CheckFailure(content->Navigate(navigate.encodedSearchURI.data()), L"Can't navigate to requested page.");
+    }
+}
 
-            CheckFailure(PostJsonToWebView(jsonObj, m_tabs.at(tabId)->m_contentWebView.Get()), L"Requesting history failed.");
-        }
-        break;
-        default:
-        {
-            OutputDebugString(L"Unexpected message\n");
-        }
-        break;
-        }
+void BrowserWindow::ControlsMessageHandler::OnMessage(const GoForwardMessage&)
+{
+    if (ICoreWebView2* content = m_window.GetActiveWebView())
+    {
+        CheckFailure(content->GoForward(), L"");
+    }
+}
 
-        return S_OK;
-    });
+void BrowserWindow::ControlsMessageHandler::OnMessage(const GoBackMessage&)
+{
+    if (ICoreWebView2* content = m_window.GetActiveWebView())
+    {
+        CheckFailure(content->GoBack(), L"");
+    }
 }
 
-HRESULT BrowserWindow::SwitchToTab(size_t tabId, bool justCreated)
+void BrowserWindow::ControlsMessageHandler::OnMessage(const ReloadMessage&)
 {
-    size_t previousActiveTab = m_activeTabId;
+    if (ICoreWebView2* content = m_window.GetActiveWebView())
+    {
+        CheckFailure(content->Reload(), L"");
+    }
+}
 
-    RETURN_IF_FAILED(m_tabs.at(tabId)->ResizeWebView());
-    RETURN_IF_FAILED(m_tabs.at(tabId)->m_contentController->put_IsVisible(TRUE));
-    m_activeTabId = tabId;
+void BrowserWindow::ControlsMessageHandler::OnMessage(const CancelMessage&)
+{
+    if (ICoreWebView2* content = m_window.GetActiveWebView())
+    {
+        CheckFailure(content->CallDevToolsProtocolMethod(L"Page.stopLoading", L"{}", nullptr), L"");
+    }
+}
 
-    if (previousActiveTab != INVALID_TAB_ID)
-        if (previousActiveTab != m_activeTabId)
-        {
-            RETURN_IF_FAILED(m_tabs.at(previousActiveTab)->m_contentController->put_IsVisible(FALSE));
-            SetDTVisibility(previousActiveTab, SW_HIDE);
-            if (!justCreated) // This will speed things up
-                SetDTVisibility(m_activeTabId, SW_SHOW);
-        }
+void BrowserWindow::ControlsMessageHandler::OnMessage(const SwitchTabMessage& switchTab)
+{
+    m_window.SwitchToTab(switchTab.tabId, false);
+}
 
-    return S_OK;
+void BrowserWindow::ControlsMessageHandler::OnMessage(const CloseTabMessage& closeTab)
+{
+    m_window.m_controlsUpdates.RemoveTab(closeTab.tabId);
+    m_window.m_metrics.RemoveTab(closeTab.tabId);
+    m_window.m_hibernation.RemoveTab(closeTab.tabId);
+    m_window.m_tasks.RemoveTab(closeTab.tabId);
+    m_window.m_session.RemoveTab(closeTab.tabId);
+    m_window.ScheduleSessionFlush();
+    std::unique_ptr<Tab> closed = m_window.m_tabs.Remove(closeTab.tabId);
+    if (closed && closed->m_contentController)
+        closed->m_contentController->Close();
 }
 
-void BrowserWindow::SetDTVisibility(size_t tabId, int nCmdShow)
+void BrowserWindow::ControlsMessageHandler::OnMessage(const CloseWindowMessage&)
 {
-    DockState ds = m_tabs.at(tabId)->GetDevToolsState();
-    if (HWND hwnd = m_tabs.at(tabId)->GetDevTools(); ds != DockState::DS_UNKNOWN)
-        ShowWindow(m_tabs.at(tabId)->GetDevToolsHolder() == nullptr ? hwnd : m_tabs.at(tabId)->GetDevToolsHolder(), nCmdShow);
-    else if (hwnd == nullptr) // here we do not know if there is any dev tools window
+    // The window deletes this BrowserWindow, metrics included
+    m_metrics.Dismiss();
+    m_window.m_controllerPool.Close();
+    if (!SUCCEEDED(m_window.FlushSession()))
     {
-        auto before = [this, tabId] { m_tabs.at(tabId)->FindDevTools(); return true; };
-        auto after = [this, tabId, nCmdShow]
-        {
-            if (HWND hwnd = m_tabs.at(tabId)->GetDevTools(); hwnd != nullptr)
-            {
-                ShowWindow(hwnd, nCmdShow);
-                m_tabs.at(tabId)->SetDevToolsState(DockState::DS_UNDOCK);
-            }
-        };
-
-        // Perform the action asynchronously to avoid blocking the browser process's event queue.
-        async_future<bool>(before, after);
+        OutputDebugString(L"Session couldn't be saved\n");
     }
-    else if (ds == DockState::DS_UNKNOWN)
-        ShowWindow(hwnd, nCmdShow);
+    DestroyWindow(m_window.m_hWnd);
 }
 
-HRESULT BrowserWindow::HandleTabURIUpdate(size_t tabId, ICoreWebView2* webview)
+void BrowserWindow::ControlsMessageHandler::OnMessage(const ShowOptionsMessage&)
 {
-    wil::unique_cotaskmem_string source;
-    RETURN_IF_FAILED(webview->get_Source(&source));
+    CheckFailure(m_window.m_optionsController->put_IsVisible(TRUE), L"");
+    m_window.m_optionsController->MoveFocus(COREWEBVIEW2_MOVE_FOCUS_REASON_PROGRAMMATIC);
+}
 
-    web::json::value jsonObj = web::json::value::parse(L"{}");
-    jsonObj[L"message"] = web::json::value(MG_UPDATE_URI);
-    jsonObj[L"args"] = web::json::value::parse(L"{}");
-    jsonObj[L"args"][L"tabId"] = web::json::value::number(tabId);
-    jsonObj[L"args"][L"uri"] = web::json::value(source.get());
+void BrowserWindow::ControlsMessageHandler::OnMessage(const HideOptionsMessage&)
+{
+    CheckFailure(m_window.m_optionsController->put_IsVisible(FALSE), L"Something went wrong when trying to close the options dropdown.");
+}
 
-    std::wstring uri(source.get());
-    std::wstring favoritesURI = GetFilePathAsURI(GetFullPathFor(L"wvbrowser_ui\\content_ui\\favorites.html"));
-    std::wstring settingsURI = GetFilePathAsURI(GetFullPathFor(L"wvbrowser_ui\\content_ui\\settings.html"));
-    std::wstring historyURI = GetFilePathAsURI(GetFullPathFor(L"wvbrowser_ui\\content_ui\\history.html"));
+void BrowserWindow::ControlsMessageHandler::OnMessage(const OptionSelectedMessage&)
+{
+    if (Tab* tab = m_window.m_tabs.Find(m_window.m_activeTabId); tab && tab->m_contentController)
+        tab->m_contentController->MoveFocus(COREWEBVIEW2_MOVE_FOCUS_REASON_PROGRAMMATIC);
+}
 
-    if (uri.compare(favoritesURI) == 0)
-    {
-        jsonObj[L"args"][L"uriToShow"] = web::json::value(L"browser://favorites");
-    }
-    else if (uri.compare(settingsURI) == 0)
+void BrowserWindow::ControlsMessageHandler::OnMessage(const SetTabPolicyMessage& tabPolicy)
+{
+    // Seconds and MB from the controls UI, 0 turns a tier off and a missing
+    // value leaves it as it is
+    TabHibernationPolicy policy = m_window.m_hibernation.GetPolicy();
+    if (tabPolicy.suspendAfter)
+        policy.suspendAfter = static_cast<uint64_t>(std::max(*tabPolicy.suspendAfter, 0LL)) * 1000;
+    if (tabPolicy.discardAfter)
+        policy.discardAfter = static_cast<uint64_t>(std::max(*tabPolicy.discardAfter, 0LL)) * 1000;
+    if (tabPolicy.memoryBudget)
+        policy.memoryBudget = static_cast<uint64_t>(std::max(*tabPolicy.memoryBudget, 0LL));
+    m_window.m_hibernation.SetPolicy(policy);
+
+    // The policy is what needs the tabs sampled in the background, the
+    // tasks page samples them itself
+    if (policy.IsEnabled())
     {
-        jsonObj[L"args"][L"uriToShow"] = web::json::value(L"browser://settings");
+        // The handler is gone by the time the sample is taken
+        m_window.SampleTasks([window = &m_window]() { window->UpdateHibernation(); });
+        SetTimer(m_window.m_hWnd, c_taskSamplerTimerId, c_taskSampleInterval, nullptr);
     }
-    else if (uri.compare(historyURI) == 0)
+    else
     {
-        jsonObj[L"args"][L"uriToShow"] = web::json::value(L"browser://history");
+        KillTimer(m_window.m_hWnd, c_taskSamplerTimerId);
     }
-
-    RETURN_IF_FAILED(PostJsonToWebView(jsonObj, m_controlsWebView.Get()));
-
-    return S_OK;
+    m_window.UpdateHibernation();
 }
 
-HRESULT BrowserWindow::HandleTabHistoryUpdate(size_t tabId, ICoreWebView2* webview)
+void BrowserWindow::ControlsMessageHandler::OnMessage(const RestoreSessionMessage&)
 {
-    wil::unique_cotaskmem_string source;
-    RETURN_IF_FAILED(webview->get_Source(&source));
-    
-    web::json::value jsonObj = web::json::value::parse(L"{}");
-    jsonObj[L"message"] = web::json::value(MG_UPDATE_URI);
-    jsonObj[L"args"] = web::json::value::parse(L"{}");
-    jsonObj[L"args"][L"tabId"] = web::json::value::number(tabId);
-    jsonObj[L"args"][L"uri"] = web::json::value(source.get());
-
-    BOOL canGoForward = FALSE;
-    RETURN_IF_FAILED(webview->get_CanGoForward(&canGoForward));
-    jsonObj[L"args"][L"canGoForward"] = web::json::value::boolean(canGoForward);
+    CheckFailure(m_window.RestoreSession(), L"Can't restore the previous session.");
+}
 
-    BOOL canGoBack = FALSE;
-    RETURN_IF_FAILED(webview->get_CanGoBack(&canGoBack));
-    jsonObj[L"args"][L"canGoBack"] = web::json::value::boolean(canGoBack);
+void BrowserWindow::ControlsMessageHandler::OnMessage(const AddFavoriteMessage& favorite)
+{
+    if (favorite.uri.empty())
+    {
+        OutputDebugString(L"Favorite without a URI\n");
+        return;
+    }
 
-    RETURN_IF_FAILED(PostJsonToWebView(jsonObj, m_controlsWebView.Get()));
+    // Title and favicon are JSON strings already, kept verbatim
+    if (s_favorites.Add(favorite.uri,
+        favorite.title.GetType() == JsonType::String ? favorite.title.GetRaw() : std::wstring_view(),
+        favorite.favicon.GetType() == JsonType::String ? favorite.favicon.GetRaw() : std::wstring_view()))
+    {
+        OnFavoriteChanged(favorite.uri);
+    }
+}
 
-    return S_OK;
+void BrowserWindow::ControlsMessageHandler::OnMessage(const RemoveFavoriteMessage& favorite)
+{
+    if (s_favorites.Remove(favorite.uri))
+    {
+        OnFavoriteChanged(favorite.uri);
+    }
 }
 
-HRESULT BrowserWindow::HandleTabNavStarting(size_t tabId, ICoreWebView2* webview)
+// Follows the favorites the controls UI moved out of IndexedDB, which it
+// only clears once they're written here. A save that failed before is
+// retried as a whole snapshot, so success means all of them are on disk.
+void BrowserWindow::ControlsMessageHandler::OnMessage(const MigrateFavoritesMessage& migrate)
 {
-    web::json::value jsonObj = web::json::value::parse(L"{}");
-    jsonObj[L"message"] = web::json::value(MG_NAV_STARTING);
-    jsonObj[L"args"] = web::json::value::parse(L"{}");
-    jsonObj[L"args"][L"tabId"] = web::json::value::number(tabId);
+    if (FAILED(SaveFavorites()))
+    {
+        OutputDebugString(L"Migrated favorites couldn't be saved\n");
+        return;
+    }
 
-    return PostJsonToWebView(jsonObj, m_controlsWebView.Get());
+    CheckFailure(m_window.PostMessageToWebView(migrate, m_window.m_controlsWebView.Get()), L"");
 }
 
-HRESULT BrowserWindow::HandleTabNavCompleted(size_t tabId, ICoreWebView2* webview, ICoreWebView2NavigationCompletedEventArgs* args)
+void BrowserWindow::ControlsMessageHandler::OnMessage(const MoveTabMessage& moveTab)
 {
-    std::wstring getTitleScript(
-        // Look for a title tag
-        L"(() => {"
-        L"    const titleTag = document.getElementsByTagName('title')[0];"
-        L"    if (titleTag) {"
-        L"        return titleTag.innerHTML;"
-        L"    }"
-        // No title tag, look for the file name
-        L"    pathname = window.location.pathname;"
-        L"    var filename = pathname.split('/').pop();"
-        L"    if (filename) {"
-        L"        return filename;"
-        L"    }"
-        // No file name, look for the hostname
-        L"    const hostname =  window.location.hostname;"
-        L"    if (hostname) {"
-        L"        return hostname;"
-        L"    }"
-        // Fallback: let the UI use a generic title
-        L"    return '';"
-        L"})();"
-    );
+    TabLifecycle lifecycle = TabLifecycle::Live;
 
-    std::wstring getFaviconURI(
-        L"(() => {"
-        // Let the UI use a fallback favicon
-        L"    let faviconURI = '';"
-        L"    let links = document.getElementsByTagName('link');"
-        // Test each link for a favicon
-        L"    Array.from(links).map(element => {"
-        L"        let rel = element.rel;"
-        // Favicon is declared, try to get the href
-        L"        if (rel && (rel == 'shortcut icon' || rel == 'icon')) {"
-        L"            if (!element.href) {"
-        L"                return;"
-        L"            }"
-        // href to icon found, check it's full URI
-        L"            try {"
-        L"                let urlParser = new URL(element.href);"
-        L"                faviconURI = urlParser.href;"
-        L"            } catch(e) {"
-        // Try prepending origin
-        L"                let origin = window.location.origin;"
-        L"                let faviconLocation = `${origin}/${element.href}`;"
-        L"                try {"
-        L"                    urlParser = new URL(faviconLocation);"
-        L"                    faviconURI = urlParser.href;"
-        L"                } catch (e2) {"
-        L"                    return;"
-        L"                }"
-        L"            }"
-        L"        }"
-        L"    });"
-        L"    return faviconURI;"
-        L"})();"
-    );
+    // From another window into this one, under the id the controls UI picked
+    if (moveTab.windowId)
+    {
+        BrowserWindow* source = FindWindowById(*moveTab.windowId);
+        size_t tabId = moveTab.newTabId.value_or(INVALID_TAB_ID);
+        if (source == nullptr || source == &m_window || !source->CanMoveTab(moveTab.tabId) ||
+            tabId == INVALID_TAB_ID || m_window.m_tabs.Find(tabId) != nullptr)
+        {
+            OutputDebugString(L"Can't move the tab into this window\n");
+            return;
+        }
+        std::unique_ptr<Tab> tab = source->DetachTab(moveTab.tabId, m_window.m_windowId, lifecycle);
+        CheckFailure(m_window.AdoptTab(std::move(tab), tabId, lifecycle), L"Can't move the tab.");
+        return;
+    }
+
+    // Out of this window into a new one, keeping its id there
+    if (!m_window.CanMoveTab(moveTab.tabId))
+    {
+        OutputDebugString(L"Can't move the tab to a new window\n");
+        return;
+    }
+    BrowserWindow* target = OpenWindow(m_window.m_hInst, SW_SHOW);
+    if (target == nullptr)
+    {
+        OutputDebugString(L"Can't open a window for the tab\n");
+        return;
+    }
+    std::unique_ptr<Tab> tab = m_window.DetachTab(moveTab.tabId, target->m_windowId, lifecycle);
+    CheckFailure(target->AdoptTab(std::move(tab), moveTab.tabId, lifecycle), L"Can't move the tab.");
+}
+
+void BrowserWindow::ControlsMessageHandler::RelayToTab(int message, JsonValue args)
+{
+    TabReplyMessage reply;
+    // The requesting tab may have been closed since
+    Tab* tab = reply.Decode(message, args) ? m_window.m_tabs.Find(reply.tabId) : nullptr;
+    if (tab && tab->m_contentWebView)
+    {
+        CheckFailure(m_window.PostMessageToWebView(reply, tab->m_contentWebView.Get()), L"Requesting history failed.");
+    }
+}
+
+// Set the message broker for the UI webview. This will capture messages from ui web content.
+// Lambda is used to capture the instance while satisfying Microsoft::WRL::Callback<T>()
+void BrowserWindow::SetUIMessageBroker()
+{
+    m_uiMessageBroker = Callback<ICoreWebView2WebMessageReceivedEventHandler>(
+        [this](ICoreWebView2* webview, ICoreWebView2WebMessageReceivedEventArgs* eventArgs) -> HRESULT
+    {
+        TraceScope trace("UIMessageReceived");
+        MessageMetrics::Scope metrics(m_metrics, MessageDirection::FromControls);
+
+        wil::unique_cotaskmem_string jsonString;
+        CheckFailure(eventArgs->get_WebMessageAsJson(&jsonString), L"");  // Get the message from the UI WebView as JSON formatted string
+
+        // The message is decoded in place, string arguments point into jsonString
+        int message = 0;
+        JsonValue args;
+        size_t length = jsonString ? wcslen(jsonString.get()) : 0;
+        if (m_traffic.IsEnabled() && jsonString)
+        {
+            TrafficEndpoint endpoint = webview == m_optionsWebView.Get() ? TrafficEndpoint::Options : TrafficEndpoint::Controls;
+            m_traffic.Record(false, endpoint, INVALID_TAB_ID, std::wstring_view(jsonString.get(), length));
+        }
+        if (!jsonString || !JsonReader::ReadMessage(jsonString.get(), message, args))
+        {
+            OutputDebugString(L"No message code or args provided\n");
+            return S_OK;
+        }
+        metrics.SetMessage(message, length);
+
+        ControlsMessageHandler handler(*this, metrics);
+        switch (MessageDispatcher<ControlsMessageHandler>::Dispatch(handler, message, args))
+        {
+        case DispatchResult::Unhandled:
+            OutputDebugString(L"Unexpected message\n");
+            break;
+        case DispatchResult::Malformed:
+            OutputDebugString(L"Malformed message from the browser UI\n");
+            break;
+        default:
+            break;
+        }
+
+        return S_OK;
+    });
+}
+
+HRESULT BrowserWindow::SwitchToTab(size_t tabId, bool justCreated)
+{
+    size_t previousActiveTab = m_activeTabId;
+    Tab* tab = m_tabs.Find(tabId);
+    if (tab == nullptr)
+    {
+        OutputDebugString(L"Switch to unknown tab\n");
+        return E_INVALIDARG;
+    }
+
+    // Set first, HandleTabCreated shows a restored tab only if it's active
+    m_activeTabId = tabId;
+    m_session.SetActiveTab(tabId);
+    ScheduleSessionFlush();
+
+    if (tab->IsDiscarded())
+    {
+        // Shown by HandleTabCreated once it's re-created, right away with a
+        // pooled controller
+        SetTabLifecycle(tabId, TabLifecycle::Live);
+        ComPtr<ICoreWebView2Controller> prewarmed = m_controllerPool.Take(GetTickCount64());
+        RETURN_IF_FAILED(tab->Restore(m_contentEnv.Get(), prewarmed.Get()));
+    }
+    else if (tab->m_contentController) // Otherwise still being created
+    {
+        if (m_hibernation.GetLifecycle(tabId) == TabLifecycle::Suspended)
+        {
+            RETURN_IF_FAILED(tab->Resume());
+            SetTabLifecycle(tabId, TabLifecycle::Live);
+        }
+        RETURN_IF_FAILED(tab->ResizeWebView());
+        RETURN_IF_FAILED(tab->m_contentController->put_IsVisible(TRUE));
+    }
+
+    if (previousActiveTab != INVALID_TAB_ID)
+        if (previousActiveTab != m_activeTabId)
+        {
+            // Gone if it was just closed
+            if (Tab* previous = m_tabs.Find(previousActiveTab))
+            {
+                if (previous->m_contentController)
+                    RETURN_IF_FAILED(previous->m_contentController->put_IsVisible(FALSE));
+                SetDTVisibility(previousActiveTab, SW_HIDE);
+            }
+            if (!justCreated) // This will speed things up
+                SetDTVisibility(m_activeTabId, SW_SHOW);
+
+            // The previous tab's idle time starts now
+            m_hibernation.Touch(previousActiveTab, GetTickCount64());
+            UpdateHibernation();
+        }
+
+    return S_OK;
+}
+
+// Applies the hibernation policy, then sets the timer for the next tab due
+void BrowserWindow::UpdateHibernation()
+{
+    if (!m_hibernation.GetPolicy().IsEnabled())
+    {
+        KillTimer(m_hWnd, c_hibernationTimerId);
+        return;
+    }
+
+    uint64_t now = GetTickCount64();
+    m_tabTransitions.clear();
+    m_hibernation.Evaluate(now, m_activeTabId, m_tabTransitions);
+    for (const TabTransition& transition : m_tabTransitions)
+    {
+        if (FAILED(HibernateTab(transition.tabId, transition.lifecycle, now)))
+        {
+            OutputDebugString(L"Can't hibernate tab\n");
+        }
+    }
+
+    uint64_t deadline = m_hibernation.GetNextDeadline(m_activeTabId);
+    if (deadline == 0)
+    {
+        KillTimer(m_hWnd, c_hibernationTimerId);
+        return;
+    }
+    uint64_t delay = deadline > now ? deadline - now : 0;
+    SetTimer(m_hWnd, c_hibernationTimerId, static_cast<UINT>(std::min<uint64_t>(delay, USER_TIMER_MAXIMUM)), nullptr);
+}
+
+HRESULT BrowserWindow::HibernateTab(size_t tabId, TabLifecycle lifecycle, uint64_t now)
+{
+    Tab* tab = m_tabs.Find(tabId);
+    if (tab == nullptr)
+    {
+        OutputDebugString(L"Hibernate unknown tab\n");
+        return E_INVALIDARG;
+    }
+
+    // Tabs still being created and tabs with DevTools open count as in use,
+    // and so do tabs the runtime refuses to hibernate
+    if (tab->m_contentController == nullptr || tab->GetDevTools() != nullptr)
+    {
+        m_hibernation.Touch(tabId, now);
+        return S_FALSE;
+    }
+
+    HRESULT hr = S_OK;
+    if (lifecycle == TabLifecycle::Discarded)
+    {
+        hr = tab->Discard();
+        if (SUCCEEDED(hr))
+            SetTabLifecycle(tabId, lifecycle);
+    }
+    else
+    {
+        // Counted as suspended until the runtime says otherwise, so it isn't
+        // asked twice
+        m_hibernation.SetLifecycle(tabId, TabLifecycle::Suspended);
+        hr = tab->Suspend(Callback<ICoreWebView2TrySuspendCompletedHandler>(
+            [this, tabId, key = m_tabs.GetKey(tabId)](HRESULT errorCode, BOOL isSuccessful) -> HRESULT
+        {
+            // Unless it was closed, re-created, shown or discarded in the meantime
+            if (m_tabs.Find(key) == nullptr || m_hibernation.GetLifecycle(tabId) != TabLifecycle::Suspended)
+                return S_OK;
+
+            if (SUCCEEDED(errorCode) && isSuccessful)
+            {
+                SetTabLifecycle(tabId, TabLifecycle::Suspended);
+            }
+            else
+            {
+                m_hibernation.SetLifecycle(tabId, TabLifecycle::Live);
+                m_hibernation.Touch(tabId, GetTickCount64());
+            }
+            return S_OK;
+        }).Get());
+    }
+
+    if (FAILED(hr))
+    {
+        m_hibernation.SetLifecycle(tabId, TabLifecycle::Live);
+        m_hibernation.Touch(tabId, now);
+    }
+    return hr;
+}
+
+void BrowserWindow::SetTabLifecycle(size_t tabId, TabLifecycle lifecycle)
+{
+    m_hibernation.SetLifecycle(tabId, lifecycle);
+
+    TabLifecycleMessage update;
+    update.tabId = tabId;
+    update.lifecycle = GetTabLifecycleName(lifecycle);
+    QueueControlsUpdate(update);
+}
+
+namespace
+{
+    uint64_t ToMicroseconds(const FILETIME& time)
+    {
+        return ((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 10;
+    }
+
+    struct ProcessCounters
+    {
+        DWORD processId = 0;
+        uint64_t workingSet = 0; // Bytes
+        uint64_t cpuTime = 0; // us
+        bool isRead = false;
+    };
+
+    ProcessCounters ReadProcessCounters(DWORD processId)
+    {
+        ProcessCounters counters;
+        counters.processId = processId;
+
+        wil::unique_handle process(OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId));
+        PROCESS_MEMORY_COUNTERS memory = {};
+        FILETIME creationTime, exitTime, kernelTime, userTime;
+        if (!process || !GetProcessMemoryInfo(process.get(), &memory, sizeof(memory)) ||
+            !GetProcessTimes(process.get(), &creationTime, &exitTime, &kernelTime, &userTime))
+        {
+            return counters;
+        }
+        counters.workingSet = memory.WorkingSetSize;
+        counters.cpuTime = ToMicroseconds(kernelTime) + ToMicroseconds(userTime);
+        counters.isRead = true;
+        return counters;
+    }
+}
+
+// Reads each tab process once and charges every tab in it with its counters.
+// Their memory replaces the hibernation estimate, and background tabs that
+// navigated since the last sample count as in use. Opening other processes
+// can block, so the counters are read on a worker.
+void BrowserWindow::SampleTasks(std::function<void()> then, CancellationToken token)
+{
+    std::vector<DWORD> processIds; // A handful at most
+    m_tabs.ForEach([&processIds](size_t /*tabId*/, Tab* tab)
+    {
+        // Discarded tabs and tabs being created have no process yet
+        DWORD processId = tab->m_contentWebView ? tab->GetBrowserProcessId() : 0;
+        if (processId != 0 && std::find(processIds.begin(), processIds.end(), processId) == processIds.end())
+            processIds.push_back(processId);
+    });
+
+    m_executor.Run<std::vector<ProcessCounters>>([processIds]()
+    {
+        std::vector<ProcessCounters> processes;
+        for (DWORD processId : processIds)
+            processes.push_back(ReadProcessCounters(processId));
+        return processes;
+    },
+    [this, then](std::vector<ProcessCounters>& processes)
+    {
+        uint64_t now = GetTickCount64();
+        m_tabs.ForEach([this, now, &processes](size_t tabId, Tab* tab)
+        {
+            DWORD processId = tab->m_contentWebView ? tab->GetBrowserProcessId() : 0;
+            ProcessCounters counters;
+            if (processId != 0)
+            {
+                // A tab created since is sampled next time
+                auto it = std::find_if(processes.begin(), processes.end(),
+                    [processId](const ProcessCounters& process) { return process.processId == processId; });
+                if (it == processes.end())
+                    return;
+                counters = *it;
+            }
+            m_tasks.Record(tabId, now, counters.processId, counters.workingSet, counters.cpuTime);
+
+            if (tabId != m_activeTabId && m_tasks.GetRecentNavigations(tabId) != 0)
+                m_hibernation.Touch(tabId, now);
+        });
+
+        uint64_t workingSet = 0;
+        for (const ProcessCounters& process : processes)
+            workingSet += process.isRead ? process.workingSet : 0;
+        if (workingSet != 0)
+            m_hibernation.SetMeasuredMemory(workingSet / (1024 * 1024));
+
+        if (then)
+            then();
+    }, std::move(token));
+}
+
+HRESULT BrowserWindow::PostTasks(ICoreWebView2* webview)
+{
+    GetTasksMessage tasks;
+    m_messageWriter.BeginMessage(tasks.Id);
+    EncodeFields(m_messageWriter, tasks);
+    m_messageWriter.BeginArray(FieldName<&TasksArgs::tasks>::value);
+    m_tasks.ForEach([this](size_t tabId, const TaskSample& latest)
+    {
+        Tab* tab = m_tabs.Find(tabId);
+        if (tab == nullptr)
+            return;
+
+        // Discarded tabs only have their snapshot
+        std::wstring uri = tab->GetSnapshot().uri;
+        wil::unique_cotaskmem_string source;
+        if (tab->m_contentWebView && SUCCEEDED(tab->m_contentWebView->get_Source(&source)))
+            uri = source.get();
+
+        TaskArgs task;
+        task.tabId = tabId;
+        task.uri = uri;
+        BrowserPage page = m_browserPages.FromFileUri(uri);
+        if (page != BrowserPage::None)
+            task.uri = m_browserPages.GetBrowserUri(page);
+        task.title = tab->GetSnapshot().titleJson;
+        task.lifecycle = GetTabLifecycleName(m_hibernation.GetLifecycle(tabId));
+        task.processId = static_cast<long long>(latest.processId);
+        task.workingSet = static_cast<long long>(latest.workingSet);
+        task.cpu = static_cast<long long>(m_tasks.GetCpuUsage(tabId));
+        task.navigations = static_cast<long long>(latest.navigations);
+        m_messageWriter.BeginObject();
+        EncodeFields(m_messageWriter, task);
+        m_messageWriter.EndObject();
+    });
+    m_messageWriter.EndArray();
+    m_messageWriter.EndMessage();
+    return PostJsonToWebView(m_messageWriter, webview);
+}
+
+std::wstring BrowserWindow::GetSessionPath()
+{
+    return GetAppDataDirectory().append(L"\\Session");
+}
+
+void BrowserWindow::LoadSession()
+{
+    ReadLogFile(GetSessionPath(), m_sessionBuffer);
+    if (!m_sessionBuffer.empty() && !m_session.Load(m_sessionBuffer))
+    {
+        OutputDebugString(L"Session file is damaged, starting a new session\n");
+    }
+
+    // Also drops a record left half written by a crash, appending after it
+    // would lose everything that follows. Retried on the next flush if the
+    // data directory doesn't exist yet.
+    if (!SUCCEEDED(CompactSession()))
+    {
+        OutputDebugString(L"Session file couldn't be written\n");
+    }
+}
+
+// Tabs other than the active one only get a WebView once they're switched
+// to, so a session with many tabs starts as fast as one with a single tab
+HRESULT BrowserWindow::RestoreSession()
+{
+    uint64_t now = GetTickCount64();
+    size_t activeTabId = m_session.GetActiveTabId();
+    bool createActiveTab = false;
+
+    RestoreSessionMessage restore;
+    restore.windowId = m_windowId;
+    restore.activeTabId = activeTabId;
+    m_messageWriter.BeginMessage(restore.Id);
+    EncodeFields(m_messageWriter, restore);
+    m_messageWriter.BeginArray(FieldName<&SessionArgs::tabs>::value);
+    for (const SessionTab& saved : m_session.GetTabs())
+    {
+        // Already there if the controls UI was reloaded
+        bool isActive = saved.tabId == activeTabId;
+        if (m_tabs.Find(saved.tabId) == nullptr)
+        {
+            TabSnapshot snapshot;
+            snapshot.uri = saved.uri;
+            snapshot.titleJson = saved.titleJson;
+            m_tabs.Insert(saved.tabId, Tab::CreateRestoredTab(m_hWnd, saved.tabId, std::move(snapshot), !isActive));
+            m_hibernation.AddTab(saved.tabId, now);
+            m_hibernation.SetLifecycle(saved.tabId, isActive ? TabLifecycle::Live : TabLifecycle::Discarded);
+            m_tasks.AddTab(saved.tabId);
+            createActiveTab = createActiveTab || isActive;
+        }
+        EncodeSessionTab(saved);
+    }
+    m_messageWriter.EndArray();
+    m_messageWriter.EndMessage();
+    RETURN_IF_FAILED(PostJsonToWebView(m_messageWriter, m_controlsWebView.Get()));
+    m_isSessionRestored = true;
+
+    // After the reply, so the controls UI knows the tab before its updates
+    if (createActiveTab)
+    {
+        Tab* activeTab = m_tabs.Find(activeTabId);
+        if (activeTab == nullptr)
+        {
+            OutputDebugString(L"Restored active tab is missing\n");
+            return E_INVALIDARG;
+        }
+        ComPtr<ICoreWebView2Controller> prewarmed = m_controllerPool.Take(now);
+        RETURN_IF_FAILED(activeTab->Init(m_contentEnv.Get(), prewarmed.Get(), true));
+    }
+
+    return S_OK;
+}
+
+void BrowserWindow::EncodeSessionTab(const SessionTab& saved)
+{
+    SessionTabArgs tab;
+    tab.tabId = saved.tabId;
+    tab.uri = saved.uri;
+    BrowserPage page = m_browserPages.FromFileUri(saved.uri.c_str());
+    if (page != BrowserPage::None)
+    {
+        tab.uriToShow = m_browserPages.GetBrowserUri(page);
+    }
+    tab.title = saved.titleJson;
+    tab.isFavorite = s_favorites.Contains(saved.uri);
+    // Only known for a tab moved from another window
+    if (Tab* open = m_tabs.Find(saved.tabId))
+    {
+        tab.favicon = open->GetSnapshot().faviconJson;
+    }
+    tab.lifecycle = GetTabLifecycleName(m_hibernation.GetLifecycle(saved.tabId));
+    m_messageWriter.BeginObject();
+    EncodeFields(m_messageWriter, tab);
+    m_messageWriter.EndObject();
+}
+
+// A tab still being created is bound to its window until it's attached
+bool BrowserWindow::CanMoveTab(size_t tabId) const
+{
+    Tab* tab = m_tabs.Find(tabId);
+    return tab != nullptr && (tab->m_contentController != nullptr || tab->IsDiscarded());
+}
+
+// Takes a tab out of this window for another one. The controls UI is told
+// with MG_MOVE_TAB and switches to another tab if it was the active one.
+std::unique_ptr<Tab> BrowserWindow::DetachTab(size_t tabId, size_t toWindowId, TabLifecycle& lifecycle)
+{
+    lifecycle = m_hibernation.GetLifecycle(tabId);
+    m_controlsUpdates.RemoveTab(tabId);
+    m_metrics.RemoveTab(tabId);
+    m_hibernation.RemoveTab(tabId);
+    m_tasks.RemoveTab(tabId);
+    m_session.RemoveTab(tabId);
+    ScheduleSessionFlush();
+    if (tabId == m_activeTabId)
+    {
+        m_activeTabId = INVALID_TAB_ID;
+    }
+    std::unique_ptr<Tab> tab = m_tabs.Remove(tabId);
+
+    MoveTabMessage moved;
+    moved.tabId = tabId;
+    moved.windowId = toWindowId;
+    CheckFailure(PostMessageToWebView(moved, m_controlsWebView.Get()), L"");
+    return tab;
+}
+
+// Takes over a tab from another window and shows it. Its WebView keeps
+// running with its page as it was, only its controller is reparented.
+HRESULT BrowserWindow::AdoptTab(std::unique_ptr<Tab> tab, size_t tabId, TabLifecycle lifecycle)
+{
+    if (!tab)
+    {
+        OutputDebugString(L"Adopt a tab that is gone\n");
+        return E_INVALIDARG;
+    }
+    RETURN_IF_FAILED(tab->MoveTo(m_hWnd, tabId));
+
+    Tab* adopted = tab.get();
+    m_tabs.Insert(tabId, std::move(tab));
+    if (adopted->m_contentController)
+    {
+        m_tabs.SetBrowserProcessId(tabId, adopted->GetBrowserProcessId());
+    }
+    if (adopted->GetDevTools() != nullptr)
+    {
+        RegisterDevTools(tabId);
+    }
+    m_hibernation.AddTab(tabId, GetTickCount64());
+    m_hibernation.SetLifecycle(tabId, lifecycle);
+    m_tasks.AddTab(tabId);
+
+    SessionTab saved;
+    saved.tabId = tabId;
+    saved.uri = adopted->GetSnapshot().uri;
+    wil::unique_cotaskmem_string source;
+    if (adopted->m_contentWebView && SUCCEEDED(adopted->m_contentWebView->get_Source(&source)))
+    {
+        saved.uri = source.get();
+    }
+    saved.titleJson = adopted->GetSnapshot().titleJson;
+    m_session.AddTab(tabId);
+    m_session.SetUri(tabId, saved.uri);
+    m_session.SetTitle(tabId, saved.titleJson);
+    ScheduleSessionFlush();
+
+    // A window still starting up lists it with the rest of its session
+    if (m_isSessionRestored)
+    {
+        RestoreSessionMessage restore;
+        restore.windowId = m_windowId;
+        restore.activeTabId = tabId;
+        m_messageWriter.BeginMessage(restore.Id);
+        EncodeFields(m_messageWriter, restore);
+        m_messageWriter.BeginArray(FieldName<&SessionArgs::tabs>::value);
+        EncodeSessionTab(saved);
+        m_messageWriter.EndArray();
+        m_messageWriter.EndMessage();
+        RETURN_IF_FAILED(PostJsonToWebView(m_messageWriter, m_controlsWebView.Get()));
+    }
+
+    return SwitchToTab(tabId, false);
+}
+
+void BrowserWindow::ScheduleSessionFlush()
+{
+    // Only the first window's tabs are saved
+    if (!m_ownsSession)
+    {
+        m_session.TakeRecords(m_sessionBuffer);
+        return;
+    }
+    if (m_session.HasRecords() && !m_isSessionFlushPending)
+    {
+        m_isSessionFlushPending = true;
+        SetTimer(m_hWnd, c_sessionTimerId, c_sessionFlushInterval, nullptr);
+    }
+}
+
+// Appends the records since the last flush, or replaces the journal with a
+// snapshot once it's grown too long
+HRESULT BrowserWindow::FlushSession()
+{
+    KillTimer(m_hWnd, c_sessionTimerId);
+    m_isSessionFlushPending = false;
+    if (!m_ownsSession)
+    {
+        return S_OK;
+    }
+    if (!m_sessionFile || m_session.ShouldCompact())
+    {
+        return CompactSession();
+    }
+    if (!m_session.HasRecords())
+    {
+        return S_OK;
+    }
+
+    m_session.TakeRecords(m_sessionBuffer);
+    DWORD written = 0;
+    if (!WriteFile(m_sessionFile.get(), m_sessionBuffer.data(), static_cast<DWORD>(m_sessionBuffer.size()), &written, nullptr))
+    {
+        // The file may end in a partial record now, start over from a snapshot
+        m_sessionFile.reset();
+        RETURN_LAST_ERROR();
+    }
+
+    return S_OK;
+}
+
+HRESULT BrowserWindow::CompactSession()
+{
+    m_session.WriteSnapshot(m_sessionBuffer);
+    return ReplaceLogFile(GetSessionPath(), m_sessionBuffer, m_sessionFile);
+}
+
+std::wstring BrowserWindow::GetHistoryPath()
+{
+    return GetAppDataDirectory().append(L"\\History");
+}
+
+std::wstring BrowserWindow::GetHistoryIndexPath()
+{
+    return GetAppDataDirectory().append(L"\\History Index");
+}
+
+void BrowserWindow::LoadHistory()
+{
+    std::vector<uint8_t> index;
+    ReadLogFile(GetHistoryPath(), s_historyBuffer);
+    ReadLogFile(GetHistoryIndexPath(), index);
+    if (!s_historyBuffer.empty() && !s_history.Load(s_historyBuffer, index))
+    {
+        OutputDebugString(L"History file is damaged, starting a new history\n");
+    }
+
+    // Like the session, drops a record left half written by a crash. A log
+    // read back whole is appended to as it is, the index saved for it stays
+    // of use.
+    HRESULT hr = S_OK;
+    if (s_historyBuffer.empty() || s_history.GetLogSize() != s_historyBuffer.size() || s_history.ShouldCompact())
+    {
+        hr = CompactHistory();
+    }
+    else
+    {
+        hr = OpenLogFile(GetHistoryPath(), s_historyFile);
+    }
+    if (!SUCCEEDED(hr))
+    {
+        OutputDebugString(L"History file couldn't be written\n");
+    }
+
+    // As large as the history, the writes that reuse it are small
+    s_historyBuffer.clear();
+    s_historyBuffer.shrink_to_fit();
+
+    // Oldest first, as the visits came
+    std::vector<const HistoryEntry*> entries;
+    s_history.GetPage(std::nullopt, s_history.GetCount(), entries);
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+    {
+        s_suggestions.AddVisit((*it)->uri, (*it)->timestamp, (*it)->id, true);
+    }
+}
+
+// The history is shared, the first window to change it sets the timer
+void BrowserWindow::ScheduleHistoryFlush()
+{
+    if (s_history.HasRecords() && s_historyFlushWindow == nullptr)
+    {
+        s_historyFlushWindow = m_hWnd;
+        SetTimer(m_hWnd, c_historyTimerId, c_historyFlushInterval, nullptr);
+    }
+}
+
+HRESULT BrowserWindow::FlushHistory()
+{
+    if (s_historyFlushWindow != nullptr)
+    {
+        KillTimer(s_historyFlushWindow, c_historyTimerId);
+        s_historyFlushWindow = nullptr;
+    }
+    if (!s_historyFile || s_history.ShouldCompact())
+    {
+        return CompactHistory();
+    }
+    if (!s_history.HasRecords())
+    {
+        return S_OK;
+    }
+
+    s_history.TakeRecords(s_historyBuffer);
+    DWORD written = 0;
+    if (!WriteFile(s_historyFile.get(), s_historyBuffer.data(), static_cast<DWORD>(s_historyBuffer.size()), &written, nullptr))
+    {
+        s_historyFile.reset();
+        RETURN_LAST_ERROR();
+    }
+
+    return S_OK;
+}
+
+HRESULT BrowserWindow::CompactHistory()
+{
+    s_history.WriteSnapshot(s_historyBuffer);
+    return ReplaceLogFile(GetHistoryPath(), s_historyBuffer, s_historyFile);
+}
+
+// At exit, so the next launch reads the search index back instead of
+// rebuilding it
+HRESULT BrowserWindow::SaveHistoryIndex()
+{
+    if (!s_history.HasIndexChanges())
+    {
+        return S_OK;
+    }
+    s_history.WriteIndex(s_historyBuffer);
+    HRESULT hr = ReplaceFileContents(GetHistoryIndexPath(), s_historyBuffer);
+    s_historyBuffer.clear();
+    s_historyBuffer.shrink_to_fit();
+    return hr;
+}
+
+// A page of entries, or of the ones that match the query, with the cursor
+// of the next page if there's one
+HRESULT BrowserWindow::PostHistory(std::wstring_view query, const std::optional<HistoryCursor>& after, size_t count, ICoreWebView2* webview)
+{
+    std::vector<const HistoryEntry*> page;
+    bool hasMore = query.empty() ? s_history.GetPage(after, count, page) : s_history.Search(query, after, count, page);
+
+    HistoryArgs history;
+    history.query = query;
+    std::wstring cursor;
+    if (hasMore)
+    {
+        cursor = HistoryStore::FormatCursor(*page.back());
+        history.cursor = cursor;
+    }
+    m_messageWriter.BeginMessage(query.empty() ? GetHistoryMessage::Id : SearchHistoryMessage::Id);
+    EncodeFields(m_messageWriter, history);
+    m_messageWriter.BeginArray(FieldName<&HistoryArgs::items>::value);
+    for (const HistoryEntry* entry : page)
+    {
+        HistoryItemArgs item;
+        item.id = static_cast<long long>(entry->id);
+        item.uri = entry->uri;
+        item.title = entry->titleJson;
+        item.favicon = entry->faviconJson;
+        item.timestamp = entry->timestamp;
+        m_messageWriter.BeginObject();
+        EncodeFields(m_messageWriter, item);
+        m_messageWriter.EndObject();
+    }
+    m_messageWriter.EndArray();
+    m_messageWriter.EndMessage();
+    return PostJsonToWebView(m_messageWriter, webview);
+}
+
+// Keystrokes can queue up behind a busy UI thread, each one superseding the
+// last. Only the latest is answered, once the queued messages are in.
+void BrowserWindow::RequestSuggestions(std::wstring_view query, long long requestId)
+{
+    m_suggestionQuery = query;
+    m_suggestionRequestId = requestId;
+    if (m_isSuggestionPending)
+    {
+        return;
+    }
+    m_isSuggestionPending = true;
+    m_executor.Post([this]()
+    {
+        m_isSuggestionPending = false;
+        CheckFailure(PostSuggestions(), L"Couldn't suggest addresses.");
+    });
+}
+
+// The best URIs for the latest query, from the history, every window's open
+// tabs and the favorites. Browser pages aren't suggested, they're typed as
+// browser://.
+HRESULT BrowserWindow::PostSuggestions()
+{
+    std::vector<KnownPage> tabs;
+    std::vector<size_t> tabIds;  // In this window, INVALID_TAB_ID for the others
+    for (BrowserWindow* window : s_windows)
+    {
+        for (const SessionTab& tab : window->m_session.GetTabs())
+        {
+            if (tab.uri.empty() || tab.uri == L"about:blank" || m_browserPages.FromFileUri(tab.uri) != BrowserPage::None)
+            {
+                continue;
+            }
+            tabs.push_back({ tab.uri, tab.titleJson });
+            tabIds.push_back(window == this ? tab.tabId : INVALID_TAB_ID);
+        }
+    }
+
+    std::vector<KnownPage> favorites;
+    for (const Favorite& favorite : s_favorites.GetFavorites())
+    {
+        favorites.push_back({ favorite.uri, favorite.titleJson });
+    }
+
+    std::vector<Suggestion> found;
+    s_suggestions.Find(m_suggestionQuery, tabs, favorites, GetCurrentTimestamp(), c_suggestionCount, found);
+
+    SuggestionsArgs suggestions;
+    suggestions.query = m_suggestionQuery;
+    suggestions.requestId = m_suggestionRequestId;
+    m_messageWriter.BeginMessage(GetSuggestionsMessage::Id);
+    EncodeFields(m_messageWriter, suggestions);
+    m_messageWriter.BeginArray(FieldName<&SuggestionsArgs::items>::value);
+    for (const Suggestion& suggestion : found)
+    {
+        SuggestionArgs item;
+        item.uri = suggestion.uri;
+        const HistoryEntry* entry = s_history.Find(suggestion.historyId);
+        if (entry != nullptr)
+        {
+            item.title = entry->titleJson;
+        }
+        // The title the user saved the favorite with, over a visit's
+        if (suggestion.favorite != nullptr && !suggestion.favorite->titleJson.empty())
+        {
+            item.title = suggestion.favorite->titleJson;
+        }
+        // The tab's title is the latest, and the tab is switched to instead
+        // of loading the URI again
+        if (suggestion.tab != nullptr)
+        {
+            if (!suggestion.tab->titleJson.empty())
+            {
+                item.title = suggestion.tab->titleJson;
+            }
+            size_t tabId = tabIds[suggestion.tab - tabs.data()];
+            if (tabId != INVALID_TAB_ID)
+            {
+                item.tabId = tabId;
+            }
+        }
+        m_messageWriter.BeginObject();
+        EncodeFields(m_messageWriter, item);
+        m_messageWriter.EndObject();
+    }
+    m_messageWriter.EndArray();
+    m_messageWriter.EndMessage();
+    return PostJsonToWebView(m_messageWriter, m_controlsWebView.Get());
+}
+
+std::wstring BrowserWindow::GetFavoritesPath()
+{
+    return GetAppDataDirectory().append(L"\\Favorites");
+}
+
+void BrowserWindow::LoadFavorites()
+{
+    std::vector<uint8_t> log;
+    ReadLogFile(GetFavoritesPath(), log);
+    if (!log.empty() && !s_favorites.Load(log))
+    {
+        OutputDebugString(L"Favorites file is damaged, starting without favorites\n");
+    }
+
+    // Like the history, a log read back whole is appended to as it is
+    HRESULT hr = S_OK;
+    if (log.empty() || s_favorites.GetLogSize() != log.size() || s_favorites.ShouldCompact())
+    {
+        hr = CompactFavorites();
+    }
+    else
+    {
+        hr = OpenLogFile(GetFavoritesPath(), s_favoritesFile);
+    }
+    if (!SUCCEEDED(hr))
+    {
+        OutputDebugString(L"Favorites file couldn't be written\n");
+    }
+}
+
+// Favorites change when the user asks, each change is written right away
+HRESULT BrowserWindow::SaveFavorites()
+{
+    if (!s_favoritesFile || s_favorites.ShouldCompact())
+    {
+        return CompactFavorites();
+    }
+    if (!s_favorites.HasRecords())
+    {
+        return S_OK;
+    }
+
+    std::vector<uint8_t> records;
+    s_favorites.TakeRecords(records);
+    DWORD written = 0;
+    if (!WriteFile(s_favoritesFile.get(), records.data(), static_cast<DWORD>(records.size()), &written, nullptr))
+    {
+        s_favoritesFile.reset();
+        RETURN_LAST_ERROR();
+    }
+
+    return S_OK;
+}
+
+HRESULT BrowserWindow::CompactFavorites()
+{
+    std::vector<uint8_t> log;
+    s_favorites.WriteSnapshot(log);
+    return ReplaceLogFile(GetFavoritesPath(), log, s_favoritesFile);
+}
+
+HRESULT BrowserWindow::PostFavorites(ICoreWebView2* webview)
+{
+    m_messageWriter.BeginMessage(GetFavoritesMessage::Id);
+    EncodeFields(m_messageWriter, FavoritesArgs());
+    m_messageWriter.BeginArray(FieldName<&FavoritesArgs::items>::value);
+    for (const Favorite& favorite : s_favorites.GetFavorites())
+    {
+        FavoriteArgs item;
+        item.uri = favorite.uri;
+        BrowserPage page = m_browserPages.FromFileUri(favorite.uri);
+        if (page != BrowserPage::None)
+        {
+            item.uriToShow = m_browserPages.GetBrowserUri(page);
+        }
+        item.title = favorite.titleJson;
+        item.favicon = favorite.faviconJson;
+        m_messageWriter.BeginObject();
+        EncodeFields(m_messageWriter, item);
+        m_messageWriter.EndObject();
+    }
+    m_messageWriter.EndArray();
+    m_messageWriter.EndMessage();
+    return PostJsonToWebView(m_messageWriter, webview);
+}
+
+void BrowserWindow::OnFavoriteChanged(std::wstring_view uri)
+{
+    if (!SUCCEEDED(SaveFavorites()))
+    {
+        OutputDebugString(L"Favorites couldn't be saved\n");
+    }
+
+    std::wstring canonical;
+    std::wstring tabUri;
+    FavoritesStore::Canonicalize(uri, canonical);
+    bool isFavorite = s_favorites.Contains(uri);
+    for (BrowserWindow* window : s_windows)
+    {
+        for (const SessionTab& tab : window->m_session.GetTabs())
+        {
+            FavoritesStore::Canonicalize(tab.uri, tabUri);
+            if (tabUri != canonical)
+            {
+                continue;
+            }
+
+            UpdateUriMessage updateUri;
+            updateUri.tabId = tab.tabId;
+            updateUri.uri = tab.uri;
+            BrowserPage page = window->m_browserPages.FromFileUri(tab.uri);
+            if (page != BrowserPage::None)
+            {
+                updateUri.uriToShow = window->m_browserPages.GetBrowserUri(page);
+            }
+            updateUri.isFavorite = isFavorite;
+            window->QueueControlsUpdate(updateUri);
+        }
+    }
+}
+
+void BrowserWindow::ReadLogFile(const std::wstring& path, std::vector<uint8_t>& bytes)
+{
+    bytes.clear();
+    wil::unique_hfile file(CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+    if (!file)
+    {
+        return;
+    }
+
+    uint8_t buffer[16 * 1024];
+    DWORD read = 0;
+    while (ReadFile(file.get(), buffer, sizeof(buffer), &read, nullptr) && read > 0)
+    {
+        bytes.insert(bytes.end(), buffer, buffer + read);
+    }
+}
+
+HRESULT BrowserWindow::ReplaceLogFile(const std::wstring& path, const std::vector<uint8_t>& bytes, wil::unique_hfile& appendFile)
+{
+    appendFile.reset();
+    RETURN_IF_FAILED(ReplaceFileContents(path, bytes));
+    return OpenLogFile(path, appendFile);
+}
+
+// Writes the bytes next to the file and moves them over it, so a crash
+// leaves either the old file or the new one
+HRESULT BrowserWindow::ReplaceFileContents(const std::wstring& path, const std::vector<uint8_t>& bytes)
+{
+    std::wstring newPath = path + L".new";
+
+    {
+        wil::unique_hfile file(CreateFileW(newPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+        RETURN_LAST_ERROR_IF(!file);
+
+        DWORD written = 0;
+        RETURN_IF_WIN32_BOOL_FALSE(WriteFile(file.get(), bytes.data(), static_cast<DWORD>(bytes.size()), &written, nullptr));
+        RETURN_IF_WIN32_BOOL_FALSE(FlushFileBuffers(file.get()));
+    }
+    RETURN_IF_WIN32_BOOL_FALSE(MoveFileExW(newPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH));
+    return S_OK;
+}
+
+HRESULT BrowserWindow::OpenLogFile(const std::wstring& path, wil::unique_hfile& appendFile)
+{
+    // Writes with only FILE_APPEND_DATA always go to the end of the file
+    appendFile.reset(CreateFileW(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+    RETURN_LAST_ERROR_IF(!appendFile);
+
+    return S_OK;
+}
+
+void BrowserWindow::SetDTVisibility(size_t tabId, int nCmdShow)
+{
+    Tab* tab = m_tabs.Find(tabId);
+    if (tab == nullptr)
+        return;
+    DockState ds = tab->GetDevToolsState();
+    if (HWND hwnd = tab->GetDevTools(); ds != DockState::DS_UNKNOWN)
+        ShowWindow(tab->GetDevToolsHolder() == nullptr ? hwnd : tab->GetDevToolsHolder(), nCmdShow);
+    else if (hwnd == nullptr) // here we do not know if there is any dev tools window
+    {
+        // Once the switch returned to the browser process, the DevTools
+        // window belongs to it. The tab may be gone or moved by then.
+        SlotKey key = m_tabs.GetKey(tabId);
+        m_executor.Post([this, key, tabId, nCmdShow]()
+        {
+            Tab* tab = m_tabs.Find(key);
+            if (tab == nullptr)
+                return;
+            tab->FindDevTools();
+            if (HWND hwnd = tab->GetDevTools(); hwnd != nullptr)
+            {
+                ShowWindow(hwnd, nCmdShow);
+                tab->SetDevToolsState(DockState::DS_UNDOCK);
+                RegisterDevTools(tabId);
+            }
+        }, tab->GetCancellationToken());
+    }
+    else if (ds == DockState::DS_UNKNOWN)
+        ShowWindow(hwnd, nCmdShow);
+}
 
-    CheckFailure(webview->ExecuteScript(getTitleScript.c_str(), Callback<ICoreWebView2ExecuteScriptCompletedHandler>(
-        [this, tabId](HRESULT error, PCWSTR result) -> HRESULT
+void BrowserWindow::WaitForBackgroundWork()
+{
+    for (BrowserWindow* window : s_windows)
     {
-        RETURN_IF_FAILED(error);
+        window->m_executor.WaitForWork();
+    }
+}
 
-        web::json::value jsonObj = web::json::value::parse(L"{}");
-        jsonObj[L"message"] = web::json::value(MG_UPDATE_TAB);
-        jsonObj[L"args"] = web::json::value::parse(L"{}");
-        jsonObj[L"args"][L"title"] = web::json::value::parse(result);
-        jsonObj[L"args"][L"tabId"] = web::json::value::number(tabId);
+HRESULT BrowserWindow::HandleTabURIUpdate(size_t tabId, ICoreWebView2* webview)
+{
+    wil::unique_cotaskmem_string source;
+    RETURN_IF_FAILED(webview->get_Source(&source));
 
-        CheckFailure(PostJsonToWebView(jsonObj, m_controlsWebView.Get()), L"Can't update title.");
-        return S_OK;
-    }).Get()), L"Can't update title.");
+    UpdateUriMessage updateUri;
+    updateUri.tabId = tabId;
+    updateUri.uri = source.get();
 
-    CheckFailure(webview->ExecuteScript(getFaviconURI.c_str(), Callback<ICoreWebView2ExecuteScriptCompletedHandler>(
-        [this, tabId](HRESULT error, PCWSTR result) -> HRESULT
+    BrowserPage page = m_browserPages.FromFileUri(source.get());
+    if (page != BrowserPage::None)
     {
-        RETURN_IF_FAILED(error);
+        updateUri.uriToShow = m_browserPages.GetBrowserUri(page);
+    }
+    updateUri.isFavorite = s_favorites.Contains(updateUri.uri);
 
-        web::json::value jsonObj = web::json::value::parse(L"{}");
-        jsonObj[L"message"] = web::json::value(MG_UPDATE_FAVICON);
-        jsonObj[L"args"] = web::json::value::parse(L"{}");
-        jsonObj[L"args"][L"uri"] = web::json::value::parse(result);
-        jsonObj[L"args"][L"tabId"] = web::json::value::number(tabId);
+    QueueControlsUpdate(updateUri);
+    m_session.SetUri(tabId, updateUri.uri);
+    ScheduleSessionFlush();
 
-        CheckFailure(PostJsonToWebView(jsonObj, m_controlsWebView.Get()), L"Can't update favicon.");
+    // Browser pages and blank tabs aren't history. The title and favicon
+    // follow with the page metadata.
+    Tab* tab = m_tabs.Find(tabId);
+    if (tab == nullptr)
+    {
         return S_OK;
-    }).Get()), L"Can't update favicon");
+    }
+    std::wstring_view uri = updateUri.uri;
+    if (page != BrowserPage::None || uri.empty() || uri == L"about:blank")
+    {
+        tab->SetHistoryId(0);
+        return S_OK;
+    }
+    const HistoryEntry* entry = s_history.Find(tab->GetHistoryId());
+    if (entry == nullptr || entry->uri != uri)
+    {
+        int64_t timestamp = GetCurrentTimestamp();
+        SYSTEMTIME today;
+        GetLocalTime(&today);
+        size_t count = s_history.GetCount();
+        uint64_t id = s_history.AddVisit(uri, timestamp, HistoryStore::GetDay(today.wYear, today.wMonth, today.wDay));
+        tab->SetHistoryId(id);
+        s_suggestions.AddVisit(uri, timestamp, id, s_history.GetCount() > count);
+        ScheduleHistoryFlush();
+    }
+
+    return S_OK;
+}
+
+HRESULT BrowserWindow::HandleTabHistoryUpdate(size_t tabId, ICoreWebView2* webview)
+{
+    wil::unique_cotaskmem_string source;
+    RETURN_IF_FAILED(webview->get_Source(&source));
+    
+    UpdateUriMessage updateUri;
+    updateUri.tabId = tabId;
+    updateUri.uri = source.get();
+
+    BOOL canGoForward = FALSE;
+    RETURN_IF_FAILED(webview->get_CanGoForward(&canGoForward));
+    updateUri.canGoForward = canGoForward != FALSE;
+
+    BOOL canGoBack = FALSE;
+    RETURN_IF_FAILED(webview->get_CanGoBack(&canGoBack));
+    updateUri.canGoBack = canGoBack != FALSE;
+    updateUri.isFavorite = s_favorites.Contains(updateUri.uri);
+
+    QueueControlsUpdate(updateUri);
+
+    return S_OK;
+}
+
+HRESULT BrowserWindow::HandleTabNavStarting(size_t tabId, ICoreWebView2* /*webview*/)
+{
+    NavStartingMessage navStarting;
+    navStarting.tabId = tabId;
+    m_tasks.AddNavigation(tabId);
+
+    QueueControlsUpdate(navStarting);
+
+    return S_OK;
+}
+
+// Every tab runs this script in each new document. It posts the title and
+// favicon once the document is parsed, then again whenever they change, so
+// single-page apps that change their title later are picked up too. Only
+// the fields that changed are sent.
+const std::wstring& BrowserWindow::GetPageMetadataScript()
+{
+    static const std::wstring script =
+        L"(() => {"
+        L"    if (window !== window.top || !window.chrome || !window.chrome.webview) {"
+        L"        return;"
+        L"    }"
+        L"    const sent = {};"
+        L"    const getTitle = () => {"
+        // Prefer the title tag, then the file name, then the hostname.
+        // An empty title lets the UI use a generic one.
+        L"        if (document.title) {"
+        L"            return document.title;"
+        L"        }"
+        L"        const filename = window.location.pathname.split('/').pop();"
+        L"        return filename || window.location.hostname || '';"
+        L"    };"
+        L"    const getFavicon = () => {"
+        // The last declared icon wins, an empty URI lets the UI use a fallback
+        L"        let faviconURI = '';"
+        L"        for (const link of document.querySelectorAll('link[rel]')) {"
+        L"            const rel = link.rel.toLowerCase();"
+        L"            if ((rel == 'icon' || rel == 'shortcut icon') && link.href) {"
+        L"                faviconURI = link.href;"
+        L"            }"
+        L"        }"
+        L"        return faviconURI;"
+        L"    };"
+        L"    const report = () => {"
+        L"        const metadata = { title: getTitle(), favicon: getFavicon() };"
+        L"        const args = {};"
+        L"        let changed = false;"
+        L"        for (const key in metadata) {"
+        L"            if (metadata[key] !== sent[key]) {"
+        L"                args[key] = sent[key] = metadata[key];"
+        L"                changed = true;"
+        L"            }"
+        L"        }"
+        L"        if (changed) {"
+        L"            window.chrome.webview.postMessage({ message: " + std::to_wstring(MG_PAGE_METADATA) + L", args: args });"
+        L"        }"
+        L"    };"
+        L"    document.addEventListener('DOMContentLoaded', () => {"
+        L"        report();"
+        // Mutation records are delivered in batches, one report per batch
+        L"        new MutationObserver(report).observe(document.head || document.documentElement, {"
+        L"            childList: true, subtree: true, characterData: true,"
+        L"            attributes: true, attributeFilter: ['href', 'rel']"
+        L"        });"
+        L"    });"
+        L"})();";
+
+    return script;
+}
 
-    web::json::value jsonObj = web::json::value::parse(L"{}");
-    jsonObj[L"message"] = web::json::value(MG_NAV_COMPLETED);
-    jsonObj[L"args"] = web::json::value::parse(L"{}");
-    jsonObj[L"args"][L"tabId"] = web::json::value::number(tabId);
+HRESULT BrowserWindow::HandleTabNavCompleted(size_t tabId, ICoreWebView2* /*webview*/, ICoreWebView2NavigationCompletedEventArgs* args)
+{
+    // Title and favicon are posted by the page metadata script
+    NavCompletedMessage navCompleted;
+    navCompleted.tabId = tabId;
 
     BOOL navigationSucceeded = FALSE;
     if (SUCCEEDED(args->get_IsSuccess(&navigationSucceeded)))
     {
-        jsonObj[L"args"][L"isError"] = web::json::value::boolean(!navigationSucceeded);
+        navCompleted.isError = !navigationSucceeded;
     }
 
-    return PostJsonToWebView(jsonObj, m_controlsWebView.Get());
+    QueueControlsUpdate(navCompleted);
+
+    return S_OK;
 }
 
-HRESULT BrowserWindow::HandleTabSecurityUpdate(size_t tabId, ICoreWebView2* webview, ICoreWebView2DevToolsProtocolEventReceivedEventArgs* args)
+HRESULT BrowserWindow::HandleTabSecurityUpdate(size_t tabId, ICoreWebView2* /*webview*/, ICoreWebView2DevToolsProtocolEventReceivedEventArgs* args)
 {
     wil::unique_cotaskmem_string jsonArgs;
     RETURN_IF_FAILED(args->get_ParameterObjectAsJson(&jsonArgs));
-    web::json::value securityEvent = web::json::value::parse(jsonArgs.get());
 
-    web::json::value jsonObj = web::json::value::parse(L"{}");
-    jsonObj[L"message"] = web::json::value(MG_SECURITY_UPDATE);
-    jsonObj[L"args"] = web::json::value::parse(L"{}");
-    jsonObj[L"args"][L"tabId"] = web::json::value::number(tabId);
-    jsonObj[L"args"][L"state"] = securityEvent.at(L"securityState");
+    // Security.securityStateChanged, decoded in place like a message
+    JsonValue event;
+    SecurityStateEventArgs state;
+    if (!JsonReader::ReadValue(jsonArgs.get(), event) || !DecodeArgs(event, state))
+    {
+        return E_INVALIDARG;
+    }
+
+    SecurityUpdateMessage securityUpdate;
+    securityUpdate.tabId = tabId;
+    securityUpdate.state = state.securityState;
 
-    return PostJsonToWebView(jsonObj, m_controlsWebView.Get());
+    QueueControlsUpdate(securityUpdate);
+
+    return S_OK;
 }
 
 void BrowserWindow::HandleTabCreated(size_t tabId, bool shouldBeActive)
 {
-    if (shouldBeActive)
+    // Closed while its WebView was being created
+    Tab* tab = m_tabs.Find(tabId);
+    if (tab == nullptr)
+    {
+        OutputDebugString(L"Created a tab that is gone\n");
+        return;
+    }
+    m_tabs.SetBrowserProcessId(tabId, tab->GetBrowserProcessId());
+    WatchDevTools(tab->GetBrowserProcessId());
+
+    // Also shows a tab switched to while it was created or restored
+    if (shouldBeActive || tabId == m_activeTabId)
     {
         CheckFailure(SwitchToTab(tabId, true), L"");
     }
+    else
+    {
+        // New controllers are visible
+        CheckFailure(tab->m_contentController->put_IsVisible(FALSE), L"");
+
+        // A new background tab may put the others over the memory budget
+        UpdateHibernation();
+    }
 }
 
-HRESULT BrowserWindow::HandleTabMessageReceived(size_t tabId, ICoreWebView2* webview, ICoreWebView2WebMessageReceivedEventArgs* eventArgs)
+// Messages from the pages shown in tabs. Browser pages get access to the
+// data they show, other pages get nothing.
+class BrowserWindow::TabMessageHandler
 {
-    wil::unique_cotaskmem_string jsonString;
-    RETURN_IF_FAILED(eventArgs->get_WebMessageAsJson(&jsonString));
-    web::json::value jsonObj = web::json::value::parse(jsonString.get());
+public:
+    TabMessageHandler(BrowserWindow& window, size_t tabId, ICoreWebView2* webview, BrowserPage page)
+        : m_window(window), m_tabId(tabId), m_webview(webview), m_page(page) {}
+
+    void OnMessage(const PageMetadataMessage& metadata);
+    void OnMessage(const ClearCacheMessage&);
+    void OnMessage(const ClearCookiesMessage&);
+    void OnMessage(const GetMetricsMessage&);
+    void OnMessage(const DumpMetricsMessage&);
+    void OnMessage(const GetTasksMessage&);
+    void OnMessage(const SetTracingMessage& request);
+    void OnMessage(const SetRecordingMessage& request);
+    void OnMessage(const GetHistoryMessage& request) { PostHistory(request, L""); }
+    void OnMessage(const SearchHistoryMessage& request) { PostHistory(request, request.query); }
+    void OnMessage(const RemoveHistoryItemMessage& request);
+    void OnMessage(const ClearHistoryMessage&);
+    void OnMessage(const GetFavoritesMessage&);
+    void OnMessage(const RemoveFavoriteMessage& favorite);
+
+    // Requests relayed to the controls UI, which owns the settings
+    void OnMessage(const RelayedMessage<MG_GET_SETTINGS>& request) { RelayFrom(BrowserPage::Settings, request.Id, request.args); }
+    void OnMessage(const RelayedMessage<MG_SET_TAB_POLICY>& request) { RelayFrom(BrowserPage::Settings, request.Id, request.args); }
+
+private:
+    void RelayFrom(BrowserPage page, int message, const JsonValue& args);
+    void PostHistory(const HistoryArgs& request, std::wstring_view query);
+
+    BrowserWindow& m_window;
+    size_t m_tabId;
+    ICoreWebView2* m_webview;
+    BrowserPage m_page;
+};
+
+void BrowserWindow::TabMessageHandler::OnMessage(const PageMetadataMessage& metadata)
+{
+    // The tab may have been closed while the message was in flight
+    Tab* tab = m_window.m_tabs.Find(m_tabId);
+    if (tab == nullptr)
+    {
+        OutputDebugString(L"Page metadata for a closed tab\n");
+        return;
+    }
 
-    wil::unique_cotaskmem_string uri;
-    RETURN_IF_FAILED(webview->get_Source(&uri));
+    // Title and favicon are JSON strings already, forward them verbatim
+    tab->SetPageMetadata(
+        metadata.title.GetType() == JsonType::String ? metadata.title.GetRaw() : std::wstring_view(),
+        metadata.favicon.GetType() == JsonType::String ? metadata.favicon.GetRaw() : std::wstring_view());
+    if (metadata.title.GetType() == JsonType::String)
+    {
+        UpdateTabMessage updateTab;
+        updateTab.tabId = m_tabId;
+        updateTab.title = metadata.title.GetRaw();
+        m_window.QueueControlsUpdate(updateTab);
+        m_window.m_session.SetTitle(m_tabId, updateTab.title);
+        m_window.ScheduleSessionFlush();
+        s_history.SetTitle(tab->GetHistoryId(), updateTab.title);
+    }
+    if (metadata.favicon.GetType() == JsonType::String)
+    {
+        UpdateFaviconMessage updateFavicon;
+        updateFavicon.tabId = m_tabId;
+        updateFavicon.uri = metadata.favicon.GetRaw();
+        m_window.QueueControlsUpdate(updateFavicon);
+        s_history.SetFavicon(tab->GetHistoryId(), updateFavicon.uri);
+    }
+    m_window.ScheduleHistoryFlush();
+}
 
-    int message = jsonObj.at(L"message").as_integer();
-    web::json::value args = jsonObj.at(L"args");
+void BrowserWindow::TabMessageHandler::OnMessage(const ClearCacheMessage&)
+{
+    // Only the settings UI can request cache clearing
+    if (m_page == BrowserPage::Settings)
+    {
+        ClearCacheMessage reply;
+        reply.content = SUCCEEDED(m_window.ClearContentCache());
+        reply.controls = SUCCEEDED(m_window.ClearControlsCache());
 
-    wil::unique_cotaskmem_string source;
-    RETURN_IF_FAILED(webview->get_Source(&source));
+        CheckFailure(m_window.PostMessageToWebView(reply, m_webview), L"");
+    }
+}
 
-    switch (message)
+void BrowserWindow::TabMessageHandler::OnMessage(const ClearCookiesMessage&)
+{
+    // Only the settings UI can request cookies clearing
+    if (m_page == BrowserPage::Settings)
     {
-    case MG_GET_FAVORITES:
-    case MG_REMOVE_FAVORITE:
+        ClearCookiesMessage reply;
+        reply.content = SUCCEEDED(m_window.ClearContentCookies());
+        reply.controls = SUCCEEDED(m_window.ClearControlsCookies());
+
+        CheckFailure(m_window.PostMessageToWebView(reply, m_webview), L"");
+    }
+}
+
+void BrowserWindow::TabMessageHandler::OnMessage(const GetMetricsMessage&)
+{
+    // Only the metrics UI can read the metrics
+    if (m_page == BrowserPage::Metrics)
     {
-        std::wstring fileURI = GetFilePathAsURI(GetFullPathFor(L"wvbrowser_ui\\content_ui\\favorites.html"));
-        // Only the favorites UI can request favorites
-        if (fileURI.compare(source.get()) == 0)
-        {
-            jsonObj[L"args"][L"tabId"] = web::json::value::number(tabId);
-            CheckFailure(PostJsonToWebView(jsonObj, m_controlsWebView.Get()), L"Couldn't perform favorites operation.");
-        }
+        CheckFailure(m_window.PostMessageToWebView(m_window.m_metrics, m_webview), L"Couldn't retrieve metrics.");
     }
-    break;
-    case MG_GET_SETTINGS:
+}
+
+void BrowserWindow::TabMessageHandler::OnMessage(const GetTasksMessage&)
+{
+    // Only the tasks UI can read the samples, taken fresh for it
+    if (m_page == BrowserPage::Tasks)
     {
-        std::wstring fileURI = GetFilePathAsURI(GetFullPathFor(L"wvbrowser_ui\\content_ui\\settings.html"));
-        // Only the settings UI can request settings
-        if (fileURI.compare(source.get()) == 0)
+        // The reply waits for the sample, unless the tasks tab is closed by then
+        Tab* tab = m_window.m_tabs.Find(m_tabId);
+        ComPtr<ICoreWebView2> webview = m_webview;
+        m_window.SampleTasks([window = &m_window, webview]()
         {
-            jsonObj[L"args"][L"tabId"] = web::json::value::number(tabId);
-            CheckFailure(PostJsonToWebView(jsonObj, m_controlsWebView.Get()), L"Couldn't retrieve settings.");
-        }
+            CheckFailure(window->PostTasks(webview.Get()), L"Couldn't retrieve tasks.");
+        }, tab != nullptr ? tab->GetCancellationToken() : CancellationToken());
     }
-    break;
-    case MG_CLEAR_CACHE:
+}
+
+void BrowserWindow::TabMessageHandler::OnMessage(const DumpMetricsMessage&)
+{
+    if (m_page == BrowserPage::Metrics)
     {
-        std::wstring fileURI = GetFilePathAsURI(GetFullPathFor(L"wvbrowser_ui\\content_ui\\settings.html"));
-        // Only the settings UI can request cache clearing
-        if (fileURI.compare(uri.get()) == 0)
-        {
-            jsonObj[L"args"][L"content"] = web::json::value::boolean(false);
-            jsonObj[L"args"][L"controls"] = web::json::value::boolean(false);
+        DumpMetricsMessage reply;
+        std::wstring path;
+        reply.succeeded = SUCCEEDED(m_window.DumpMetrics(path));
+        reply.path = path;
+        CheckFailure(m_window.PostMessageToWebView(reply, m_webview), L"");
+    }
+}
 
-            if (SUCCEEDED(ClearContentCache()))
-            {
-                jsonObj[L"args"][L"content"] = web::json::value::boolean(true);
-            }
+void BrowserWindow::TabMessageHandler::OnMessage(const SetTracingMessage& request)
+{
+    // Only the metrics UI can start and stop tracing
+    if (m_page == BrowserPage::Metrics)
+    {
+        SetTracingMessage reply;
+        std::wstring path;
+        HRESULT hr = m_window.SetTracing(request.enabled, path);
+        reply.enabled = TraceRecorder::IsEnabled();
+        reply.succeeded = SUCCEEDED(hr);
+        if (hr == S_OK)
+            reply.path = path;
+        CheckFailure(m_window.PostMessageToWebView(reply, m_webview), L"");
+    }
+}
 
-            if (SUCCEEDED(ClearControlsCache()))
-            {
-                jsonObj[L"args"][L"controls"] = web::json::value::boolean(true);
-            }
+void BrowserWindow::TabMessageHandler::OnMessage(const SetRecordingMessage& request)
+{
+    // Only the metrics UI can start and stop recording
+    if (m_page == BrowserPage::Metrics)
+    {
+        SetRecordingMessage reply;
+        std::wstring path;
+        HRESULT hr = m_window.SetRecording(request.enabled, path);
+        reply.enabled = m_window.m_traffic.IsEnabled();
+        reply.succeeded = SUCCEEDED(hr);
+        if (hr == S_OK)
+            reply.path = path;
+        CheckFailure(m_window.PostMessageToWebView(reply, m_webview), L"");
+    }
+}
+
+void BrowserWindow::TabMessageHandler::PostHistory(const HistoryArgs& request, std::wstring_view query)
+{
+    // Only the history UI can read the history
+    if (m_page != BrowserPage::History)
+    {
+        return;
+    }
 
-            CheckFailure(PostJsonToWebView(jsonObj, m_tabs.at(tabId)->m_contentWebView.Get()), L"");
+    std::optional<HistoryCursor> after;
+    if (!request.cursor.empty())
+    {
+        HistoryCursor cursor;
+        if (!HistoryStore::ParseCursor(request.cursor, cursor))
+        {
+            OutputDebugString(L"History requested with an invalid cursor\n");
+            return;
         }
+        after = cursor;
     }
-    break;
-    case MG_CLEAR_COOKIES:
+    size_t count = c_historyPageSize;
+    if (request.count)
+        count = static_cast<size_t>(std::clamp(*request.count, 1LL, static_cast<long long>(c_maxHistoryPageSize)));
+
+    CheckFailure(m_window.PostHistory(query, after, count, m_webview), L"Couldn't retrieve history.");
+}
+
+void BrowserWindow::TabMessageHandler::OnMessage(const RemoveHistoryItemMessage& request)
+{
+    if (m_page == BrowserPage::History)
     {
-        std::wstring fileURI = GetFilePathAsURI(GetFullPathFor(L"wvbrowser_ui\\content_ui\\settings.html"));
-        // Only the settings UI can request cookies clearing
-        if (fileURI.compare(uri.get()) == 0)
+        const HistoryEntry* entry = s_history.Find(static_cast<uint64_t>(request.id));
+        if (entry != nullptr)
         {
-            jsonObj[L"args"][L"content"] = web::json::value::boolean(false);
-            jsonObj[L"args"][L"controls"] = web::json::value::boolean(false);
+            s_suggestions.RemoveEntry(entry->uri, entry->timestamp, entry->id);
+        }
+        s_history.Remove(static_cast<uint64_t>(request.id));
+        m_window.ScheduleHistoryFlush();
+    }
+}
 
-            if (SUCCEEDED(ClearContentCookies()))
-            {
-                jsonObj[L"args"][L"content"] = web::json::value::boolean(true);
-            }
+void BrowserWindow::TabMessageHandler::OnMessage(const ClearHistoryMessage&)
+{
+    if (m_page == BrowserPage::History)
+    {
+        s_history.Clear();
+        s_suggestions.Clear();
+        m_window.ScheduleHistoryFlush();
+    }
+}
 
+void BrowserWindow::TabMessageHandler::OnMessage(const GetFavoritesMessage&)
+{
+    // Only the favorites UI can read the favorites
+    if (m_page == BrowserPage::Favorites)
+    {
+        CheckFailure(m_window.PostFavorites(m_webview), L"Couldn't retrieve favorites.");
+    }
+}
 
-            if (SUCCEEDED(ClearControlsCookies()))
-            {
-                jsonObj[L"args"][L"controls"] = web::json::value::boolean(true);
-            }
+void BrowserWindow::TabMessageHandler::OnMessage(const RemoveFavoriteMessage& favorite)
+{
+    if (m_page == BrowserPage::Favorites && s_favorites.Remove(favorite.uri))
+    {
+        OnFavoriteChanged(favorite.uri);
+    }
+}
 
-            CheckFailure(PostJsonToWebView(jsonObj, m_tabs.at(tabId)->m_contentWebView.Get()), L"");
-        }
+void BrowserWindow::TabMessageHandler::RelayFrom(BrowserPage page, int message, const JsonValue& args)
+{
+    // Only the page that shows the data can request it
+    if (m_page == page)
+    {
+        TabRequestMessage request{ message, m_tabId, args };
+        CheckFailure(m_window.PostMessageToWebView(request, m_window.m_controlsWebView.Get()), L"Couldn't relay the request to the browser UI.");
     }
-    break;
-    case MG_GET_HISTORY:
-    case MG_REMOVE_HISTORY_ITEM:
-    case MG_CLEAR_HISTORY:
+}
+
+HRESULT BrowserWindow::HandleTabMessageReceived(size_t tabId, ICoreWebView2* webview, ICoreWebView2WebMessageReceivedEventArgs* eventArgs)
+{
+    MessageMetrics::Scope metrics(m_metrics, MessageDirection::FromTab);
+
+    wil::unique_cotaskmem_string jsonString;
+    RETURN_IF_FAILED(eventArgs->get_WebMessageAsJson(&jsonString));
+
+    int message = 0;
+    JsonValue args;
+    size_t length = jsonString ? wcslen(jsonString.get()) : 0;
+    m_metrics.RecordTabMessage(tabId, length);
+    if (m_traffic.IsEnabled() && jsonString)
     {
-        std::wstring fileURI = GetFilePathAsURI(GetFullPathFor(L"wvbrowser_ui\\content_ui\\history.html"));
-        // Only the history UI can request history
-        if (fileURI.compare(uri.get()) == 0)
-        {
-            jsonObj[L"args"][L"tabId"] = web::json::value::number(tabId);
-            CheckFailure(PostJsonToWebView(jsonObj, m_controlsWebView.Get()), L"Couldn't perform history operation");
-        }
+        m_traffic.Record(false, TrafficEndpoint::Tab, tabId, std::wstring_view(jsonString.get(), length));
     }
-    break;
-    default:
+    if (!jsonString || !JsonReader::ReadMessage(jsonString.get(), message, args))
     {
-        OutputDebugString(L"Unexpected message\n");
+        // Any page can post messages, ignore the ones we don't understand
+        return S_OK;
     }
-    break;
+    metrics.SetMessage(message, length);
+
+    wil::unique_cotaskmem_string source;
+    RETURN_IF_FAILED(webview->get_Source(&source));
+
+    TabMessageHandler handler(*this, tabId, webview, m_browserPages.FromFileUri(source.get()));
+    switch (MessageDispatcher<TabMessageHandler>::Dispatch(handler, message, args))
+    {
+    case DispatchResult::Unhandled:
+        OutputDebugString(L"Unexpected message\n");
+        break;
+    case DispatchResult::Malformed:
+        OutputDebugString(L"Malformed message from a browser page\n");
+        break;
+    default:
+        break;
     }
 
     return S_OK;
@@ -829,7 +2322,16 @@ HRESULT BrowserWindow::HandleTabMessageReceived(size_t tabId, ICoreWebView2* web
 
 HRESULT BrowserWindow::ClearContentCache()
 {
-    return m_tabs.at(m_activeTabId)->m_contentWebView->CallDevToolsProtocolMethod(L"Network.clearBrowserCache", L"{}", nullptr);
+    ICoreWebView2* content = GetActiveWebView();
+    if (content == nullptr)
+        return E_FAIL;
+    return content->CallDevToolsProtocolMethod(L"Network.clearBrowserCache", L"{}", nullptr);
+}
+
+ICoreWebView2* BrowserWindow::GetActiveWebView() const
+{
+    Tab* tab = m_tabs.Find(m_activeTabId);
+    return tab == nullptr ? nullptr : tab->m_contentWebView.Get();
 }
 
 HRESULT BrowserWindow::ClearControlsCache()
@@ -839,7 +2341,10 @@ HRESULT BrowserWindow::ClearControlsCache()
 
 HRESULT BrowserWindow::ClearContentCookies()
 {
-    return m_tabs.at(m_activeTabId)->m_contentWebView->CallDevToolsProtocolMethod(L"Network.clearBrowserCookies", L"{}", nullptr);
+    ICoreWebView2* content = GetActiveWebView();
+    if (content == nullptr)
+        return E_FAIL;
+    return content->CallDevToolsProtocolMethod(L"Network.clearBrowserCookies", L"{}", nullptr);
 }
 
 HRESULT BrowserWindow::ClearControlsCookies()
@@ -849,35 +2354,53 @@ HRESULT BrowserWindow::ClearControlsCookies()
 
 HRESULT BrowserWindow::ResizeUIWebViews()
 {
+    RECT client;
+    GetClientRect(m_hWnd, &client);
+    DockLayoutInput input;
+    input.clientWidth = client.right;
+    input.clientHeight = client.bottom;
+    DockLayout layout = DockLayoutSolver::Solve(GetLayoutMetrics(), input);
+
     if (m_controlsWebView != nullptr)
     {
-        RECT bounds;
-        GetClientRect(m_hWnd, &bounds);
-        bounds.bottom = bounds.top + GetDPIAwareBound(c_uiBarHeight);
-
-        RETURN_IF_FAILED(m_controlsController->put_Bounds(bounds));
+        RETURN_IF_FAILED(m_controlsController->put_Bounds(ToRECT(layout.controls)));
     }
 
     if (m_optionsWebView != nullptr)
     {
-        RECT bounds;
-        GetClientRect(m_hWnd, &bounds);
-        bounds.top = GetDPIAwareBound(c_uiBarHeight - 30);
-        bounds.bottom = bounds.top + GetDPIAwareBound(c_optionsDropdownHeight);
-        bounds.left = bounds.right - GetDPIAwareBound(c_optionsDropdownWidth);
+        RETURN_IF_FAILED(m_optionsController->put_Bounds(ToRECT(layout.options)));
+    }
+
+    return S_OK;
+}
 
-        RETURN_IF_FAILED(m_optionsController->put_Bounds(bounds));
+HRESULT BrowserWindow::UpdateLayout()
+{
+    m_lastLayoutTime = GetTickCount64();
+    RETURN_IF_FAILED(ResizeUIWebViews());
+    if (Tab* tab = m_tabs.Find(m_activeTabId))
+    {
+        RETURN_IF_FAILED(tab->ResizeWebView());
     }
+    return S_OK;
+}
+
+void BrowserWindow::ScheduleLayout()
+{
+    // Dragging the frame sends sizes more often than frames are shown. The
+    // first one is laid out right away, the rest once the frame is over.
+    if (m_isLayoutPending)
+        return;
 
-    // Workaround for black controls WebView issue in Windows 7
-    HWND wvWindow = GetWindow(m_hWnd, GW_CHILD);
-    while (wvWindow != nullptr)
+    uint64_t elapsed = GetTickCount64() - m_lastLayoutTime;
+    if (elapsed >= c_layoutInterval)
     {
-        UpdateWindow(wvWindow);
-        wvWindow = GetWindow(wvWindow, GW_HWNDNEXT);
+        UpdateLayout();
+        return;
     }
 
-    return S_OK;
+    m_isLayoutPending = true;
+    SetTimer(m_hWnd, c_layoutTimerId, c_layoutInterval - static_cast<UINT>(elapsed), nullptr);
 }
 
 void BrowserWindow::UpdateMinWindowSize()
@@ -915,10 +2438,27 @@ void BrowserWindow::CheckFailure(HRESULT hr, LPCWSTR errorMessage)
 
 int BrowserWindow::GetDPIAwareBound(int bound)
 {
-    // Remove the GetDpiForWindow call when using Windows 7 or any version
-    // below 1607 (Windows 10). You will also have to make sure the build
-    // directory is clean before building again.
-    return (bound * GetDpiForWindow(m_hWnd) / DEFAULT_DPI);
+    return static_cast<int>(bound * GetLayoutMetrics().dpi / DEFAULT_DPI);
+}
+
+const LayoutMetrics& BrowserWindow::GetLayoutMetrics()
+{
+    if (m_layoutMetrics.dpi == 0)
+    {
+        // Remove the GetDpiForWindow call when using Windows 7 or any version
+        // below 1607 (Windows 10). You will also have to make sure the build
+        // directory is clean before building again.
+        UINT dpi = GetDpiForWindow(m_hWnd);
+        auto scale = [dpi](int bound) { return static_cast<int>(bound * dpi / DEFAULT_DPI); };
+
+        m_layoutMetrics.dpi = dpi;
+        m_layoutMetrics.barHeight = scale(c_uiBarHeight);
+        m_layoutMetrics.optionsTop = scale(c_uiBarHeight - 30);
+        m_layoutMetrics.optionsWidth = scale(c_optionsDropdownWidth);
+        m_layoutMetrics.optionsHeight = scale(c_optionsDropdownHeight);
+        m_layoutMetrics.titleBarHeight = GetSystemMetrics(SM_CYCAPTION) + GetSystemMetrics(SM_CYSIZEFRAME) + GetSystemMetrics(SM_CYEDGE) * 2;
+    }
+    return m_layoutMetrics;
 }
 
 std::wstring BrowserWindow::GetAppDataDirectory()
@@ -969,10 +2509,132 @@ std::wstring BrowserWindow::GetFilePathAsURI(std::wstring fullPath)
     return fileURI;
 }
 
-HRESULT BrowserWindow::PostJsonToWebView(web::json::value jsonObj, ICoreWebView2* webview)
+// Send the tab state updates collected during the last frame as one message.
+// The active tab's updates go first, background tabs are limited per frame
+// so loading many of them at once doesn't delay the active one.
+HRESULT BrowserWindow::FlushControlsUpdates()
+{
+    if (m_controlsUpdates.IsEmpty() || m_controlsWebView == nullptr)
+        return S_OK;
+
+    m_controlsUpdates.Flush(m_messageWriter, m_activeTabId, c_maxBackgroundUpdatesPerFlush);
+    if (!m_controlsUpdates.IsEmpty())
+        SetTimer(m_hWnd, c_flushUpdatesTimerId, c_flushUpdatesInterval, nullptr);
+
+    return PostJsonToWebView(m_messageWriter, m_controlsWebView.Get());
+}
+
+HRESULT BrowserWindow::PostJsonToWebView(const JsonWriter& writer, ICoreWebView2* webview)
+{
+    MessageMetrics::Scope metrics(m_metrics, MessageDirection::Posted);
+    metrics.SetMessage(writer.GetMessageId(), writer.GetLength());
+    if (m_traffic.IsEnabled())
+    {
+        size_t tabId = INVALID_TAB_ID;
+        TrafficEndpoint endpoint = GetTrafficEndpoint(webview, tabId);
+        m_traffic.Record(true, endpoint, tabId, std::wstring_view(writer.GetString(), writer.GetLength()));
+    }
+
+    return webview->PostWebMessageAsJson(writer.GetString());
+}
+
+TrafficEndpoint BrowserWindow::GetTrafficEndpoint(ICoreWebView2* webview, size_t& tabId)
+{
+    tabId = INVALID_TAB_ID;
+    if (webview == m_controlsWebView.Get())
+        return TrafficEndpoint::Controls;
+    if (webview == m_optionsWebView.Get())
+        return TrafficEndpoint::Options;
+
+    m_tabs.ForEach([webview, &tabId](size_t id, Tab* tab)
+    {
+        if (tab->m_contentWebView.Get() == webview)
+            tabId = id;
+    });
+    return TrafficEndpoint::Tab;
+}
+
+// Writes the current metrics as JSON next to the browser data
+HRESULT BrowserWindow::DumpMetrics(std::wstring& path)
+{
+    JsonWriter writer;
+    m_metrics.Encode(writer);
+
+    int size = WideCharToMultiByte(CP_UTF8, 0, writer.GetString(), static_cast<int>(writer.GetLength()), nullptr, 0, nullptr, nullptr);
+    std::string utf8(size, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, writer.GetString(), static_cast<int>(writer.GetLength()), &utf8[0], size, nullptr, nullptr);
+
+    return WriteAppDataFile(L"metrics", L"json", utf8.data(), utf8.size(), path);
+}
+
+// Stopping the trace writes everything recorded since it was started
+HRESULT BrowserWindow::SetTracing(bool enabled, std::wstring& path)
+{
+    if (enabled)
+    {
+        TraceRecorder::Start();
+        return S_OK;
+    }
+
+    if (!TraceRecorder::IsEnabled())
+        return S_FALSE;
+
+    TraceRecorder::Stop();
+    std::string trace;
+    TraceRecorder::Flush(trace, GetCurrentProcessId());
+
+    return WriteAppDataFile(L"trace", L"json", trace.data(), trace.size(), path);
+}
+
+// Stopping the recording writes the traffic log, for mockhost/TrafficReplay.cpp
+HRESULT BrowserWindow::SetRecording(bool enabled, std::wstring& path)
+{
+    if (enabled)
+    {
+        m_traffic.Start();
+
+        // Tabs opened before the recording are logged as if the controls UI
+        // created them now, so a replay has a WebView for their messages
+        std::vector<size_t> tabIds;
+        m_tabs.ForEach([&tabIds](size_t tabId, Tab*) { tabIds.push_back(tabId); });
+        std::sort(tabIds.begin(), tabIds.end());
+        for (size_t tabId : tabIds)
+        {
+            CreateTabMessage createTab;
+            createTab.tabId = tabId;
+            createTab.active = tabId == m_activeTabId;
+            createTab.Encode(m_messageWriter);
+            m_traffic.Record(false, TrafficEndpoint::Controls, INVALID_TAB_ID,
+                std::wstring_view(m_messageWriter.GetString(), m_messageWriter.GetLength()));
+        }
+        return S_OK;
+    }
+
+    if (!m_traffic.IsEnabled())
+        return S_FALSE;
+
+    m_traffic.Stop();
+    std::vector<uint8_t> log = m_traffic.TakeLog();
+
+    return WriteAppDataFile(L"traffic", L"bin", log.data(), log.size(), path);
+}
+
+HRESULT BrowserWindow::WriteAppDataFile(PCWSTR prefix, PCWSTR extension, const void* data, size_t size, std::wstring& path)
 {
-    utility::stringstream_t stream;
-    jsonObj.serialize(stream);
+    SYSTEMTIME time;
+    GetLocalTime(&time);
+    WCHAR fileName[64];
+    swprintf_s(fileName, L"\\%s-%04d%02d%02d-%02d%02d%02d.%s", prefix,
+        time.wYear, time.wMonth, time.wDay, time.wHour, time.wMinute, time.wSecond, extension);
 
-    return webview->PostWebMessageAsJson(stream.str().c_str());
+    path = GetAppDataDirectory();
+    path.append(fileName);
+
+    wil::unique_hfile file(CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+    RETURN_LAST_ERROR_IF(!file);
+
+    DWORD written = 0;
+    RETURN_IF_WIN32_BOOL_FALSE(WriteFile(file.get(), data, static_cast<DWORD>(size), &written, nullptr));
+
+    return S_OK;
 }
\ No newline at end of file
@@ -6,6 +6,22 @@
 
 #include "framework.h"
 #include "Tab.h"
+#include "MessageSchema.h"
+#include "UpdateCoalescer.h"
+#include "MessageMetrics.h"
+#include "TrafficRecorder.h"
+#include "TabHibernation.h"
+#include "TaskSampler.h"
+#include "TaskExecutor.h"
+#include "ControllerPool.h"
+#include "SessionJournal.h"
+#include "HistoryStore.h"
+#include "SuggestionIndex.h"
+#include "FavoritesStore.h"
+#include "TabRegistry.h"
+#include "BrowserPages.h"
+#include "DevToolsIndex.h"
+#include "SharedEnvironment.h"
 
 class BrowserWindow
 {
@@ -13,6 +29,23 @@ public:
     static const int c_uiBarHeight = 70;
     static const int c_optionsDropdownHeight = 208;
     static const int c_optionsDropdownWidth = 300;
+    static const UINT_PTR c_flushUpdatesTimerId = 1;
+    static const UINT c_flushUpdatesInterval = 16; // One frame, in ms
+    static const size_t c_maxBackgroundUpdatesPerFlush = 16; // Tabs other than the active one
+    static const UINT_PTR c_hibernationTimerId = 2; // Set for the next tab due to be hibernated
+    static const UINT_PTR c_sessionTimerId = 3;
+    static const UINT c_sessionFlushInterval = 1000; // Longest a session change waits to be written, in ms
+    static const UINT_PTR c_taskSamplerTimerId = 4; // Set while the hibernation policy is on
+    static const UINT c_taskSampleInterval = 2000; // ms
+    static const UINT c_runContinuationsMessage = WM_APP + 1; // Posted when the executor has continuations
+    static const size_t c_workerCount = 2; // For blocking work, the UI thread never waits for it
+    static const UINT_PTR c_layoutTimerId = 5; // Set while a resize waits for the next frame
+    static const UINT c_layoutInterval = 16; // One frame, in ms
+    static const UINT_PTR c_historyTimerId = 6; // Set on one window while visits wait to be written
+    static const UINT c_historyFlushInterval = 1000; // ms
+    static const size_t c_historyPageSize = 20; // Entries per reply when the history page doesn't say
+    static const size_t c_maxHistoryPageSize = 200;
+    static const size_t c_suggestionCount = 8; // Under the address bar
 
     static ATOM RegisterClass(_In_ HINSTANCE hInstance);
     static LRESULT CALLBACK WndProcStatic(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
@@ -20,6 +53,7 @@ public:
 
     static BOOL LaunchWindow(_In_ HINSTANCE hInstance, _In_ int nCmdShow);
     static std::wstring GetAppDataDirectory();
+    static const std::wstring& GetPageMetadataScript();
     std::wstring GetFullPathFor(LPCWSTR relativePath);
     HRESULT HandleTabURIUpdate(size_t tabId, ICoreWebView2* webview);
     HRESULT HandleTabHistoryUpdate(size_t tabId, ICoreWebView2* webview);
@@ -29,15 +63,51 @@ public:
     void HandleTabCreated(size_t tabId, bool shouldBeActive);
     HRESULT HandleTabMessageReceived(size_t tabId, ICoreWebView2* webview, ICoreWebView2WebMessageReceivedEventArgs* eventArgs);
     int GetDPIAwareBound(int bound);
+    // Queried once, then kept until the DPI changes
+    const LayoutMetrics& GetLayoutMetrics();
+    // Lays out the UI and the active tab now, or when the frame is over if
+    // that was already done during it
+    void ScheduleLayout();
     static void CheckFailure(HRESULT hr, LPCWSTR errorMessage);
-    bool CheckDTOwnership(HWND dtHwnd) { return find_if(m_tabs.begin(), m_tabs.end(), [dtHwnd](const auto&it) { return it.second->GetDevTools() == dtHwnd; }) != m_tabs.end(); }
+    // Whether a live tab already owns this DevTools window
+    bool CheckDTOwnership(HWND dtHwnd) const { Tab* owner = m_tabs.FindByDevToolsWindow(dtHwnd); return owner != nullptr && owner->GetDevTools() == dtHwnd; }
+    // A DevTools window of the process that no tab in any window owns yet,
+    // nullptr if there's none. Any known process for processId 0.
+    static HWND FindDevToolsWindow(DWORD processId);
+    // Indexes the DevTools window FindDevTools found for the tab
+    void RegisterDevTools(size_t tabId) { if (Tab* tab = m_tabs.Find(tabId)) m_tabs.SetDevToolsWindow(tabId, tab->GetDevTools()); }
+    // For callbacks that can outlive the tab
+    SlotKey GetTabKey(size_t tabId) const { return m_tabs.GetKey(tabId); }
+    Tab* FindTab(SlotKey key) const { return m_tabs.Find(key); }
     void SetDTVisibility(size_t tabId, int nCmdShow);
+    TaskExecutor& GetExecutor() { return m_executor; }
+    // Until the executors of all windows have no work, for the headless tools
+    static void WaitForBackgroundWork();
+    // Sent to the controls UI with the session, for moving tabs between windows
+    size_t GetWindowId() const { return m_windowId; }
 protected:
+    class ControlsMessageHandler;
+    class TabMessageHandler;
+
     HINSTANCE m_hInst = nullptr;  // Current app instance
     HWND m_hWnd = nullptr;
+    size_t m_windowId = 0;
 
     static WCHAR s_windowClass[MAX_LOADSTRING];  // The window class name
     static WCHAR s_title[MAX_LOADSTRING];  // The title bar text
+    static SharedEnvironment s_contentEnvironment;  // Every window's tabs
+    static SharedEnvironment s_uiEnvironment;  // Every window's controls and options
+    static std::vector<BrowserWindow*> s_windows;  // Open, in the order they were opened
+    static size_t s_lastWindowId;
+    static DevToolsIndex s_devTools;  // Windows of the browser processes of every window's tabs
+    static std::vector<HWINEVENTHOOK> s_devToolsHooks;  // One per browser process
+    static HistoryStore s_history;  // Every window's visits, loaded with the first window
+    static wil::unique_hfile s_historyFile;  // Opened for appending
+    static std::vector<uint8_t> s_historyBuffer;  // Reused for writes
+    static HWND s_historyFlushWindow;  // Whose timer is set, if any
+    static SuggestionIndex s_suggestions;  // For the address bar, built with the history and kept up with its visits
+    static FavoritesStore s_favorites;  // Every window's, loaded with the first window
+    static wil::unique_hfile s_favoritesFile;  // Opened for appending
 
     int m_minWindowWidth = 0;
     int m_minWindowHeight = 0;
@@ -48,7 +118,7 @@ protected:
     Microsoft::WRL::ComPtr<ICoreWebView2Controller> m_optionsController;
     Microsoft::WRL::ComPtr<ICoreWebView2> m_controlsWebView;
     Microsoft::WRL::ComPtr<ICoreWebView2> m_optionsWebView;
-    std::map<size_t,std::unique_ptr<Tab>> m_tabs;
+    TabRegistry m_tabs;
     size_t m_activeTabId = 0;
 
     EventRegistrationToken m_controlsUIMessageBrokerToken = {};  // Token for the UI message handler in controls WebView
@@ -57,7 +127,35 @@ protected:
     EventRegistrationToken m_optionsZoomToken = {};
     EventRegistrationToken m_lostOptionsFocus = {};  // Token for the lost focus handler in options WebView
     Microsoft::WRL::ComPtr<ICoreWebView2WebMessageReceivedEventHandler> m_uiMessageBroker;
+    JsonWriter m_messageWriter;  // Reused for every message posted to a WebView
+    UpdateCoalescer m_controlsUpdates;  // Tab state updates waiting for the next frame
+    MessageMetrics m_metrics;  // Bridge traffic, shown on browser://metrics
+    TrafficRecorder m_traffic;  // Bridge traffic log, started from browser://metrics
+    BrowserPageRegistry m_browserPages;  // Resolved once in InitInstance
+    TabHibernation m_hibernation;  // Policy set by the controls UI, off until then
+    std::vector<TabTransition> m_tabTransitions;  // Reused by UpdateHibernation
+    TaskSampler m_tasks;  // Shown on browser://tasks and fed to the hibernation policy
+    ControllerPool m_controllerPool;  // Hidden content controllers for new tabs
+    SessionJournal m_session;  // Open tabs, loaded in InitInstance and restored by the controls UI
+    wil::unique_hfile m_sessionFile;  // Opened for appending
+    std::vector<uint8_t> m_sessionBuffer;  // Reused for writes
+    bool m_isSessionFlushPending = false;
+    bool m_ownsSession = false;  // Only the first window saves its tabs
+    bool m_isSessionRestored = false;  // The controls UI asked for the session
+    LayoutMetrics m_layoutMetrics;
+    uint64_t m_lastLayoutTime = 0; // GetTickCount64
+    bool m_isLayoutPending = false;
+    std::wstring m_suggestionQuery;  // Latest keystroke of the address bar, answered once the queued ones are in
+    long long m_suggestionRequestId = 0;
+    bool m_isSuggestionPending = false;
+    // Last, so the workers are stopped before anything their continuations use goes
+    TaskExecutor m_executor{ c_workerCount, [this]() { PostMessage(m_hWnd, c_runContinuationsMessage, 0, 0); } };
 
+    static BrowserWindow* OpenWindow(HINSTANCE hInstance, int nCmdShow);
+    static BrowserWindow* FindWindowById(size_t windowId);
+    static void WatchDevTools(DWORD processId);
+    static void CALLBACK OnWindowEvent(HWINEVENTHOOK hook, DWORD event, HWND hwnd, LONG objectId, LONG childId,
+        DWORD threadId, DWORD time);
     BOOL InitInstance(HINSTANCE hInstance, int nCmdShow);
     HRESULT InitUIWebViews();
     HRESULT CreateBrowserControlsWebView();
@@ -69,8 +167,70 @@ protected:
 
     void SetUIMessageBroker();
     HRESULT ResizeUIWebViews();
+    HRESULT UpdateLayout();
     void UpdateMinWindowSize();
-    HRESULT PostJsonToWebView(web::json::value jsonObj, ICoreWebView2* webview);
+    HRESULT PostJsonToWebView(const JsonWriter& writer, ICoreWebView2* webview);
+    TrafficEndpoint GetTrafficEndpoint(ICoreWebView2* webview, size_t& tabId);
+    template <typename T>
+    HRESULT PostMessageToWebView(const T& message, ICoreWebView2* webview)
+    {
+        message.Encode(m_messageWriter);
+        return PostJsonToWebView(m_messageWriter, webview);
+    }
+    template <typename T>
+    void QueueControlsUpdate(const T& update)
+    {
+        m_metrics.RecordTabUpdate(update.tabId);
+        if (m_controlsUpdates.Add(update))
+            SetTimer(m_hWnd, c_flushUpdatesTimerId, c_flushUpdatesInterval, nullptr);
+    }
+    HRESULT FlushControlsUpdates();
+    HRESULT DumpMetrics(std::wstring& path);
+    HRESULT SetTracing(bool enabled, std::wstring& path);
+    HRESULT SetRecording(bool enabled, std::wstring& path);
+    HRESULT WriteAppDataFile(PCWSTR prefix, PCWSTR extension, const void* data, size_t size, std::wstring& path);
     HRESULT SwitchToTab(size_t tabId, bool justCreated);
+    // nullptr if there's no active tab or it's being created
+    ICoreWebView2* GetActiveWebView() const;
+    void UpdateHibernation();
+    HRESULT HibernateTab(size_t tabId, TabLifecycle lifecycle, uint64_t now);
+    void SetTabLifecycle(size_t tabId, TabLifecycle lifecycle);
+    // Reads the process counters on a worker, then records them and calls then
+    void SampleTasks(std::function<void()> then = nullptr, CancellationToken token = {});
+    HRESULT PostTasks(ICoreWebView2* webview);
+    std::wstring GetSessionPath();
+    void LoadSession();
+    HRESULT RestoreSession();
+    void EncodeSessionTab(const SessionTab& saved);
+    bool CanMoveTab(size_t tabId) const;
+    std::unique_ptr<Tab> DetachTab(size_t tabId, size_t toWindowId, TabLifecycle& lifecycle);
+    HRESULT AdoptTab(std::unique_ptr<Tab> tab, size_t tabId, TabLifecycle lifecycle);
+    void ScheduleSessionFlush();
+    HRESULT FlushSession();
+    HRESULT CompactSession();
+    static std::wstring GetHistoryPath();
+    static std::wstring GetHistoryIndexPath();
+    static void LoadHistory();
+    void ScheduleHistoryFlush();
+    static HRESULT FlushHistory();
+    static HRESULT CompactHistory();
+    static HRESULT SaveHistoryIndex();
+    HRESULT PostHistory(std::wstring_view query, const std::optional<HistoryCursor>& after, size_t count, ICoreWebView2* webview);
+    void RequestSuggestions(std::wstring_view query, long long requestId);
+    HRESULT PostSuggestions();
+    static std::wstring GetFavoritesPath();
+    static void LoadFavorites();
+    static HRESULT SaveFavorites();
+    static HRESULT CompactFavorites();
+    HRESULT PostFavorites(ICoreWebView2* webview);
+    // Saves a change of the favorites and sends the favorite status of the
+    // URI to the controls UI of every tab showing it
+    static void OnFavoriteChanged(std::wstring_view uri);
+    // The session, the history and the favorites are append-only logs,
+    // replaced whole by their snapshots
+    static void ReadLogFile(const std::wstring& path, std::vector<uint8_t>& bytes);
+    static HRESULT ReplaceLogFile(const std::wstring& path, const std::vector<uint8_t>& bytes, wil::unique_hfile& appendFile);
+    static HRESULT ReplaceFileContents(const std::wstring& path, const std::vector<uint8_t>& bytes);
+    static HRESULT OpenLogFile(const std::wstring& path, wil::unique_hfile& appendFile);
     std::wstring GetFilePathAsURI(std::wstring fullPath);
 };
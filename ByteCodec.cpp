@@ -0,0 +1,181 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ByteCodec.h"
+
+namespace
+{
+    const size_t c_checksumSize = 4;
+
+    // FNV-1a, enough to tell a torn write from a record
+    uint32_t Checksum(const uint8_t* bytes, size_t length)
+    {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; ++i)
+            hash = (hash ^ bytes[i]) * 16777619u;
+        return hash;
+    }
+
+    void AppendCodePoint(std::wstring& value, uint32_t c)
+    {
+        if (sizeof(wchar_t) == 2 && c >= 0x10000)
+        {
+            c -= 0x10000;
+            value.push_back(static_cast<wchar_t>(0xD800 + (c >> 10)));
+            value.push_back(static_cast<wchar_t>(0xDC00 + (c & 0x3FF)));
+        }
+        else
+        {
+            value.push_back(static_cast<wchar_t>(c));
+        }
+    }
+}
+
+void AppendVarint(std::vector<uint8_t>& bytes, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        bytes.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(value));
+}
+
+bool ReadVarint(const std::vector<uint8_t>& bytes, size_t& position, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && position < bytes.size(); shift += 7)
+    {
+        uint8_t byte = bytes[position++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+uint64_t ZigzagEncode(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t ZigzagDecode(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void AppendUtf8(std::vector<uint8_t>& bytes, std::wstring_view value)
+{
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        uint32_t c = static_cast<uint32_t>(value[i]);
+        if (sizeof(wchar_t) == 2 && c >= 0xD800 && c <= 0xDBFF && i + 1 < value.size())
+        {
+            uint32_t low = static_cast<uint32_t>(value[i + 1]);
+            if (low >= 0xDC00 && low <= 0xDFFF)
+            {
+                c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                ++i;
+            }
+        }
+
+        if (c < 0x80)
+        {
+            bytes.push_back(static_cast<uint8_t>(c));
+        }
+        else if (c < 0x800)
+        {
+            bytes.push_back(static_cast<uint8_t>(0xC0 | (c >> 6)));
+            bytes.push_back(static_cast<uint8_t>(0x80 | (c & 0x3F)));
+        }
+        else if (c < 0x10000)
+        {
+            bytes.push_back(static_cast<uint8_t>(0xE0 | (c >> 12)));
+            bytes.push_back(static_cast<uint8_t>(0x80 | ((c >> 6) & 0x3F)));
+            bytes.push_back(static_cast<uint8_t>(0x80 | (c & 0x3F)));
+        }
+        else
+        {
+            bytes.push_back(static_cast<uint8_t>(0xF0 | (c >> 18)));
+            bytes.push_back(static_cast<uint8_t>(0x80 | ((c >> 12) & 0x3F)));
+            bytes.push_back(static_cast<uint8_t>(0x80 | ((c >> 6) & 0x3F)));
+            bytes.push_back(static_cast<uint8_t>(0x80 | (c & 0x3F)));
+        }
+    }
+}
+
+bool DecodeUtf8(const uint8_t* bytes, size_t length, std::wstring& value)
+{
+    value.clear();
+    for (size_t i = 0; i < length;)
+    {
+        uint8_t lead = bytes[i++];
+        uint32_t c;
+        int continuation;
+        if (lead < 0x80)
+        {
+            c = lead;
+            continuation = 0;
+        }
+        else if ((lead & 0xE0) == 0xC0)
+        {
+            c = lead & 0x1F;
+            continuation = 1;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            c = lead & 0x0F;
+            continuation = 2;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            c = lead & 0x07;
+            continuation = 3;
+        }
+        else
+        {
+            return false;
+        }
+
+        if (i + continuation > length)
+            return false;
+        for (int j = 0; j < continuation; ++j)
+        {
+            uint8_t byte = bytes[i++];
+            if ((byte & 0xC0) != 0x80)
+                return false;
+            c = (c << 6) | (byte & 0x3F);
+        }
+        AppendCodePoint(value, c);
+    }
+    return true;
+}
+
+void AppendChecksummedRecord(std::vector<uint8_t>& bytes, const std::vector<uint8_t>& payload)
+{
+    AppendVarint(bytes, payload.size());
+    bytes.insert(bytes.end(), payload.begin(), payload.end());
+    uint32_t checksum = Checksum(payload.data(), payload.size());
+    for (int shift = 0; shift < 32; shift += 8)
+        bytes.push_back(static_cast<uint8_t>(checksum >> shift));
+}
+
+bool ReadChecksummedRecord(const std::vector<uint8_t>& bytes, size_t& position, const uint8_t*& payload, size_t& length)
+{
+    size_t start = position;
+    uint64_t size = 0;
+    if (!ReadVarint(bytes, start, size) || size == 0 || size > bytes.size() - start ||
+        bytes.size() - start - size < c_checksumSize)
+        return false;
+
+    const uint8_t* checksum = bytes.data() + start + size;
+    uint32_t expected = checksum[0] | (checksum[1] << 8) | (checksum[2] << 16) | (static_cast<uint32_t>(checksum[3]) << 24);
+    if (Checksum(bytes.data() + start, static_cast<size_t>(size)) != expected)
+        return false;
+
+    payload = bytes.data() + start;
+    length = static_cast<size_t>(size);
+    position = start + length + c_checksumSize;
+    return true;
+}
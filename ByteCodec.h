@@ -0,0 +1,32 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Byte level encodings shared by the binary formats (TrafficRecorder,
+// SessionJournal, HistoryStore). Nothing in here depends on Windows headers.
+
+// LEB128, 7 bits per byte with the high bit set on all but the last
+void AppendVarint(std::vector<uint8_t>& bytes, uint64_t value);
+bool ReadVarint(const std::vector<uint8_t>& bytes, size_t& position, uint64_t& value);
+
+// Maps small negative numbers to small varints
+uint64_t ZigzagEncode(int64_t value);
+int64_t ZigzagDecode(uint64_t value);
+
+// wchar_t holds UTF-16 on Windows and UTF-32 elsewhere
+void AppendUtf8(std::vector<uint8_t>& bytes, std::wstring_view value);
+bool DecodeUtf8(const uint8_t* bytes, size_t length, std::wstring& value);
+
+// Records of the append-only files: varint payload length, payload, and a
+// checksum of the payload. A record cut short by a crash doesn't read back.
+void AppendChecksummedRecord(std::vector<uint8_t>& bytes, const std::vector<uint8_t>& payload);
+// Moves position past the record. False at the end, or at a damaged or empty
+// record, where whatever follows can't be trusted either.
+bool ReadChecksummedRecord(const std::vector<uint8_t>& bytes, size_t& position, const uint8_t*& payload, size_t& length);
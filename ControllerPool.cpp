@@ -0,0 +1,142 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ControllerPool.h"
+#include <cmath>
+#include "Tab.h"
+
+using namespace Microsoft::WRL;
+
+namespace
+{
+    // Weight of the newest sample in the moving averages
+    const double c_averageWeight = 0.25;
+
+    double UpdateAverage(double average, double sample)
+    {
+        return average == 0 ? sample : average + (sample - average) * c_averageWeight;
+    }
+}
+
+void ControllerPool::Start(HWND hWnd, ICoreWebView2Environment* env)
+{
+    m_hWnd = hWnd;
+    m_env = env;
+    m_alive = std::make_shared<bool>(true);
+    if (!SUCCEEDED(Fill()))
+    {
+        OutputDebugString(L"Controller pool couldn't start\n");
+    }
+}
+
+ComPtr<ICoreWebView2Controller> ControllerPool::Take(uint64_t now)
+{
+    if (m_lastTake != 0)
+    {
+        m_takeInterval = UpdateAverage(m_takeInterval, static_cast<double>(now - m_lastTake));
+    }
+    m_lastTake = now;
+    UpdateTargetSize();
+
+    ComPtr<ICoreWebView2Controller> controller;
+    if (!m_ready.empty())
+    {
+        controller = m_ready.front();
+        m_ready.erase(m_ready.begin());
+    }
+
+    TrimToTargetSize();
+    if (!SUCCEEDED(Fill()))
+    {
+        OutputDebugString(L"Controller pool couldn't refill\n");
+    }
+    return controller;
+}
+
+void ControllerPool::Close()
+{
+    m_alive.reset();
+    for (ComPtr<ICoreWebView2Controller>& controller : m_ready)
+    {
+        controller->Close();
+    }
+    m_ready.clear();
+    m_pending = 0;
+    m_env = nullptr;
+}
+
+HRESULT ControllerPool::Fill()
+{
+    while (m_env && m_ready.size() + m_pending < m_targetSize)
+    {
+        std::weak_ptr<bool> alive = m_alive;
+        uint64_t start = GetTickCount64();
+        RETURN_IF_FAILED(m_env->CreateCoreWebView2Controller(m_hWnd, Callback<ICoreWebView2CreateCoreWebView2ControllerCompletedHandler>(
+            [this, alive, start](HRESULT result, ICoreWebView2Controller* controller) -> HRESULT
+        {
+            if (alive.expired())
+            {
+                // The window closed while this was being created
+                if (SUCCEEDED(result))
+                    controller->Close();
+                return S_OK;
+            }
+
+            --m_pending;
+            if (!SUCCEEDED(result))
+            {
+                // Not retried, the next Take tries again
+                OutputDebugString(L"Pooled WebView creation failed\n");
+                return result;
+            }
+            AddController(controller, GetTickCount64() - start);
+            return S_OK;
+        }).Get()));
+        ++m_pending;
+    }
+
+    return S_OK;
+}
+
+void ControllerPool::AddController(ICoreWebView2Controller* controller, uint64_t creationTime)
+{
+    m_creationTime = UpdateAverage(m_creationTime, static_cast<double>(creationTime));
+
+    ComPtr<ICoreWebView2> webview;
+    HRESULT hr = controller->put_IsVisible(FALSE);
+    if (SUCCEEDED(hr))
+        hr = controller->get_CoreWebView2(&webview);
+    if (SUCCEEDED(hr))
+        hr = Tab::PrepareWebView(webview.Get());
+    if (!SUCCEEDED(hr))
+    {
+        OutputDebugString(L"Pooled WebView couldn't be prepared\n");
+        controller->Close();
+        return;
+    }
+
+    m_ready.push_back(controller);
+    TrimToTargetSize();
+}
+
+// Enough controllers to cover the tabs opened while one is being created
+void ControllerPool::UpdateTargetSize()
+{
+    size_t size = c_minSize;
+    if (m_takeInterval > 0 && m_creationTime > 0)
+    {
+        size = static_cast<size_t>(std::ceil(m_creationTime / m_takeInterval));
+    }
+    m_targetSize = std::clamp(size, c_minSize, c_maxSize);
+}
+
+void ControllerPool::TrimToTargetSize()
+{
+    // Once tabs are opened slowly again, a large pool only holds on to memory
+    while (m_ready.size() > m_targetSize)
+    {
+        m_ready.back()->Close();
+        m_ready.pop_back();
+    }
+}
@@ -0,0 +1,46 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <vector>
+#include "framework.h"
+
+// Keeps a few tab controllers created ahead of time, hidden and prepared by
+// Tab::PrepareWebView, so a new tab only has to attach its handlers and
+// navigate instead of waiting for the runtime to create a WebView. They stay
+// on the initial about:blank, which keeps the new tab's history empty.
+// The pool grows while tabs are opened faster than controllers get created
+// and shrinks back to c_minSize when they aren't.
+class ControllerPool
+{
+public:
+    static constexpr size_t c_minSize = 1;
+    static constexpr size_t c_maxSize = 4;
+
+    void Start(HWND hWnd, ICoreWebView2Environment* env);
+    // A ready controller, or nullptr if none is. Refills the pool either way.
+    Microsoft::WRL::ComPtr<ICoreWebView2Controller> Take(uint64_t now);
+    // Closes the ready controllers, the pending ones when they complete
+    void Close();
+
+    size_t GetReadyCount() const { return m_ready.size(); }
+    size_t GetTargetSize() const { return m_targetSize; }
+
+private:
+    HRESULT Fill();
+    void UpdateTargetSize();
+    void TrimToTargetSize();
+    void AddController(ICoreWebView2Controller* controller, uint64_t creationTime);
+
+    HWND m_hWnd = nullptr;
+    Microsoft::WRL::ComPtr<ICoreWebView2Environment> m_env;
+    std::vector<Microsoft::WRL::ComPtr<ICoreWebView2Controller>> m_ready; // Oldest first
+    size_t m_pending = 0; // Being created
+    size_t m_targetSize = c_minSize;
+    uint64_t m_lastTake = 0;
+    double m_takeInterval = 0; // Moving averages in ms, 0 until measured
+    double m_creationTime = 0;
+    std::shared_ptr<bool> m_alive; // Checked by pending creations
+};
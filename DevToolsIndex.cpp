@@ -0,0 +1,69 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "DevToolsIndex.h"
+#include <algorithm>
+
+bool DevToolsIndex::AddProcess(uint32_t processId, WindowEnumerator& windows)
+{
+    if (processId == 0 || !m_processes.emplace(processId, std::vector<WindowHandle>()).second)
+        return false;
+
+    windows.ForEachTopLevelWindow([this, processId, &windows](WindowHandle window)
+    {
+        if (windows.GetProcessId(window) == processId && windows.IsDevToolsCandidate(window))
+            Add(window, processId);
+        return true;
+    });
+    return true;
+}
+
+void DevToolsIndex::OnWindowCreated(WindowHandle window, WindowEnumerator& windows)
+{
+    uint32_t processId = windows.GetProcessId(window);
+    if (HasProcess(processId) && windows.IsDevToolsCandidate(window))
+        Add(window, processId);
+}
+
+void DevToolsIndex::OnWindowDestroyed(WindowHandle window)
+{
+    auto it = m_windows.find(window);
+    if (it == m_windows.end())
+        return;
+
+    std::vector<WindowHandle>& windows = m_processes[it->second];
+    windows.erase(std::remove(windows.begin(), windows.end(), window), windows.end());
+    m_windows.erase(it);
+}
+
+WindowHandle DevToolsIndex::Find(uint32_t processId, const std::function<bool(WindowHandle window)>& isClaimed) const
+{
+    if (processId != 0)
+    {
+        auto it = m_processes.find(processId);
+        return it != m_processes.end() ? FindIn(it->second, isClaimed) : nullptr;
+    }
+
+    for (const auto& [id, windows] : m_processes)
+    {
+        if (WindowHandle window = FindIn(windows, isClaimed))
+            return window;
+    }
+    return nullptr;
+}
+
+void DevToolsIndex::Add(WindowHandle window, uint32_t processId)
+{
+    // A recycled handle moves to the process that has it now
+    OnWindowDestroyed(window);
+    m_processes[processId].push_back(window);
+    m_windows[window] = processId;
+}
+
+WindowHandle DevToolsIndex::FindIn(const std::vector<WindowHandle>& windows,
+    const std::function<bool(WindowHandle window)>& isClaimed)
+{
+    auto it = std::find_if(windows.begin(), windows.end(), [&isClaimed](WindowHandle window) { return !isClaimed(window); });
+    return it != windows.end() ? *it : nullptr;
+}
@@ -0,0 +1,59 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// The top level Chrome_WidgetWin_1 windows of the WebView browser processes
+// this app uses, one of which is a tab's DevTools window once they're opened.
+// Seeded by a single enumeration when a process is added and kept up to date
+// from window create and destroy events, so finding a DevTools window is a
+// hash lookup rather than a walk over every window of the system. Windows are
+// opaque here, nothing in here depends on Windows headers.
+
+using WindowHandle = const void*;
+
+// What the index needs to know about windows, faked by the tests
+class WindowEnumerator
+{
+public:
+    virtual ~WindowEnumerator() = default;
+
+    // Stops when fn returns false
+    virtual void ForEachTopLevelWindow(const std::function<bool(WindowHandle window)>& fn) = 0;
+    // 0 for a window that is gone
+    virtual uint32_t GetProcessId(WindowHandle window) = 0;
+    // Top level, or a child in the sense of WS_CHILD, of the DevTools class
+    virtual bool IsDevToolsCandidate(WindowHandle window) = 0;
+};
+
+class DevToolsIndex
+{
+public:
+    // Indexes the windows the process already has. False if it was known,
+    // the caller only subscribes to the events of a new process.
+    bool AddProcess(uint32_t processId, WindowEnumerator& windows);
+    bool HasProcess(uint32_t processId) const { return m_processes.count(processId) != 0; }
+
+    // Windows of other processes and other classes are ignored
+    void OnWindowCreated(WindowHandle window, WindowEnumerator& windows);
+    void OnWindowDestroyed(WindowHandle window);
+
+    // The oldest window of the process that isClaimed(window) says no tab
+    // owns yet, of any indexed process for processId 0. nullptr if none.
+    WindowHandle Find(uint32_t processId, const std::function<bool(WindowHandle window)>& isClaimed) const;
+    size_t GetWindowCount() const { return m_windows.size(); }
+
+private:
+    void Add(WindowHandle window, uint32_t processId);
+    static WindowHandle FindIn(const std::vector<WindowHandle>& windows,
+        const std::function<bool(WindowHandle window)>& isClaimed);
+
+    std::unordered_map<uint32_t, std::vector<WindowHandle>> m_processes; // In creation order
+    std::unordered_map<WindowHandle, uint32_t> m_windows;
+};
@@ -0,0 +1,62 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "DockLayout.h"
+
+#include <algorithm>
+#include <cmath>
+
+DockLayout DockLayoutSolver::Solve(const LayoutMetrics& metrics, const DockLayoutInput& input)
+{
+    DockLayout layout;
+    int width = std::max(input.clientWidth, 0);
+    int height = std::max(input.clientHeight, 0);
+    int barHeight = std::min(metrics.barHeight, height);
+
+    layout.controls = { 0, 0, width, barHeight };
+    layout.options = { width - metrics.optionsWidth, metrics.optionsTop, width, metrics.optionsTop + metrics.optionsHeight };
+    layout.content = { 0, barHeight, width, height };
+    if (!IsDocked(input.state))
+        return layout;
+
+    int dockSize = ClampDockSize(metrics, input, input.dockSize);
+    layout.dockSize = dockSize;
+    switch (input.state)
+    {
+    case DockState::DS_DOCK_RIGHT:
+        layout.content.right = width - dockSize - c_borderSize;
+        layout.holder = { layout.content.right, barHeight, width, height };
+        break;
+    case DockState::DS_DOCK_LEFT:
+        layout.content.left = dockSize + c_borderSize;
+        layout.holder = { 0, barHeight, layout.content.left, height };
+        break;
+    default:
+        layout.content.bottom = height - dockSize - c_borderSize;
+        layout.holder = { 0, layout.content.bottom, width, height };
+        break;
+    }
+
+    // The DevTools window is moved so that its frame and title bar are out
+    // of the holder, and stretched to fill the holder anyway
+    bool isBottom = input.state == DockState::DS_DOCK_BOTTOM;
+    int dockWidth = isBottom ? width : dockSize;
+    int dockHeight = isBottom ? dockSize : height - barHeight;
+    layout.devTools.left = -input.frameWidth / 2;
+    layout.devTools.top = -metrics.titleBarHeight;
+    layout.devTools.right = layout.devTools.left + dockWidth + input.frameWidth + (isBottom ? 0 : c_borderSize / 2);
+    layout.devTools.bottom = layout.devTools.top + dockHeight + input.frameHeight + metrics.titleBarHeight + c_borderSize / 2;
+    return layout;
+}
+
+int DockLayoutSolver::ClampDockSize(const LayoutMetrics& metrics, const DockLayoutInput& input, int dockSize)
+{
+    int width = std::max(input.clientWidth, 0);
+    int contentHeight = std::max(input.clientHeight - metrics.barHeight, 0);
+    int extent = input.state == DockState::DS_DOCK_BOTTOM ? contentHeight : width;
+    if (dockSize <= 0)
+        dockSize = extent - int(std::round(c_contentRatio * extent));
+
+    return std::clamp(dockSize, 0, std::max(extent - c_borderSize, 0));
+}
@@ -0,0 +1,92 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+// Where the controls bar, the options dropdown, the active tab and its docked
+// DevTools go in the client area of a browser window. Solving it is plain
+// arithmetic on sizes the window caches, the caller applies the rectangles.
+// Nothing in here depends on Windows headers.
+
+enum class DockState: int
+{
+    DS_UNKNOWN, // No window or unable to locate
+    DS_UNDOCK,
+    DS_DOCK_RIGHT,
+    DS_DOCK_LEFT,
+    DS_DOCK_BOTTOM,
+    DS_AMOUNT
+};
+
+inline DockState operator+ (DockState const &d, int const &n)
+{
+    return static_cast<DockState>(static_cast<int>(d)+n);
+}
+
+inline bool IsDocked(DockState state)
+{
+    return state == DockState::DS_DOCK_RIGHT || state == DockState::DS_DOCK_LEFT || state == DockState::DS_DOCK_BOTTOM;
+}
+
+struct LayoutRect
+{
+    int left = 0, top = 0, right = 0, bottom = 0;
+
+    int Width() const { return right - left; }
+    int Height() const { return bottom - top; }
+    bool operator==(const LayoutRect& other) const
+    {
+        return left == other.left && top == other.top && right == other.right && bottom == other.bottom;
+    }
+    bool operator!=(const LayoutRect& other) const { return !(*this == other); }
+};
+
+// Everything the layout depends on besides the client size, already scaled
+// to the window's DPI. The window keeps them until its DPI changes.
+struct LayoutMetrics
+{
+    unsigned int dpi = 0; // 0 until queried
+    int barHeight = 0;
+    int optionsTop = 0;
+    int optionsWidth = 0;
+    int optionsHeight = 0;
+    int titleBarHeight = 0; // Of a DevTools window, hidden while it's docked
+};
+
+struct DockLayoutInput
+{
+    int clientWidth = 0;
+    int clientHeight = 0;
+    DockState state = DockState::DS_UNKNOWN;
+    // Width of the DevTools docked left or right, height docked at the
+    // bottom, borders excluded. 0 for the default ratio.
+    int dockSize = 0;
+    // Of the DevTools window frame, hidden along with its title bar
+    int frameWidth = 0;
+    int frameHeight = 0;
+};
+
+struct DockLayout
+{
+    LayoutRect controls;
+    LayoutRect options;
+    LayoutRect content;
+    // Only set while the DevTools are docked. The holder is in the client
+    // area, the DevTools window in the holder's.
+    LayoutRect holder;
+    LayoutRect devTools;
+    int dockSize = 0; // What was used, the default one included
+};
+
+class DockLayoutSolver
+{
+public:
+    static const int c_borderSize = 4; // Resizable side of the DevTools holder
+    // Of the tab's WebView, the DevTools get what's left
+    static constexpr double c_contentRatio = 0.7;
+
+    static DockLayout Solve(const LayoutMetrics& metrics, const DockLayoutInput& input);
+    // A dock size that keeps the border and the content in the client area
+    static int ClampDockSize(const LayoutMetrics& metrics, const DockLayoutInput& input, int dockSize);
+};
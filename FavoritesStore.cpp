@@ -0,0 +1,241 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "FavoritesStore.h"
+#include <iterator>
+#include "ByteCodec.h"
+#include "MessageCodec.h"
+
+namespace
+{
+    const uint8_t c_magic[] = { 'W', 'F' };
+    const uint8_t c_version = 1;
+    const size_t c_headerSize = sizeof(c_magic) + 1;
+
+    void LowerAscii(std::wstring& text, size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (text[i] >= L'A' && text[i] <= L'Z')
+                text[i] = static_cast<wchar_t>(text[i] - L'A' + L'a');
+        }
+    }
+
+    bool IsDefaultPort(std::wstring_view scheme, std::wstring_view port)
+    {
+        if (port == L"80")
+            return scheme == L"http" || scheme == L"ws";
+        if (port == L"443")
+            return scheme == L"https" || scheme == L"wss";
+        return false;
+    }
+
+    void AppendString(std::vector<uint8_t>& bytes, std::vector<uint8_t>& text, std::wstring_view value)
+    {
+        text.clear();
+        AppendUtf8(text, value);
+        AppendVarint(bytes, text.size());
+        bytes.insert(bytes.end(), text.begin(), text.end());
+    }
+
+    bool ReadString(const std::vector<uint8_t>& bytes, size_t& position, size_t end, std::wstring& value)
+    {
+        uint64_t length = 0;
+        if (!ReadVarint(bytes, position, length) || position > end || length > end - position)
+            return false;
+        size_t start = position;
+        position += static_cast<size_t>(length);
+        return DecodeUtf8(bytes.data() + start, static_cast<size_t>(length), value);
+    }
+}
+
+void FavoritesStore::Canonicalize(std::wstring_view uri, std::wstring& canonical)
+{
+    canonical.assign(uri);
+    size_t colon = canonical.find(L':');
+    if (colon == std::wstring::npos)
+        return;
+    LowerAscii(canonical, 0, colon);
+    if (canonical.compare(colon + 1, 2, L"//") != 0)
+        return;
+
+    // The host follows the user info, if any, and may be an IPv6 address
+    size_t start = colon + 3;
+    size_t end = canonical.find_first_of(L"/?#", start);
+    if (end == std::wstring::npos)
+        end = canonical.size();
+    size_t at = canonical.rfind(L'@', end - 1);
+    size_t host = at != std::wstring::npos && at >= start ? at + 1 : start;
+    LowerAscii(canonical, host, end);
+
+    size_t port = canonical.rfind(L':', end - 1);
+    size_t bracket = canonical.rfind(L']', end - 1);
+    if (port != std::wstring::npos && port >= host && (bracket == std::wstring::npos || bracket < host || port > bracket))
+    {
+        std::wstring_view digits = std::wstring_view(canonical).substr(port + 1, end - port - 1);
+        if (digits.empty() || IsDefaultPort(std::wstring_view(canonical).substr(0, colon), digits))
+        {
+            canonical.erase(port, end - port);
+            end = port;
+        }
+    }
+
+    if (end == canonical.size() || canonical[end] != L'/')
+        canonical.insert(end, 1, L'/');
+}
+
+bool FavoritesStore::Add(std::wstring_view uri, std::wstring_view titleJson, std::wstring_view faviconJson)
+{
+    if (!Apply(RecordType::Add, uri, titleJson, faviconJson))
+        return false;
+
+    size_t size = m_records.size();
+    AppendRecord(m_records, RecordType::Add, uri, titleJson, faviconJson);
+    m_logSize += m_records.size() - size;
+    return true;
+}
+
+bool FavoritesStore::Remove(std::wstring_view uri)
+{
+    if (!Apply(RecordType::Remove, uri, {}, {}))
+        return false;
+
+    size_t size = m_records.size();
+    AppendRecord(m_records, RecordType::Remove, uri, {}, {});
+    m_logSize += m_records.size() - size;
+    return true;
+}
+
+bool FavoritesStore::Contains(std::wstring_view uri) const
+{
+    Canonicalize(uri, m_key);
+    return m_indices.find(m_key) != m_indices.end();
+}
+
+void FavoritesStore::TakeRecords(std::vector<uint8_t>& records)
+{
+    records.swap(m_records);
+    m_records.clear();
+}
+
+bool FavoritesStore::ShouldCompact() const
+{
+    return m_logSize > c_minCompactSize && m_logSize > m_snapshotSize * 4;
+}
+
+void FavoritesStore::WriteSnapshot(std::vector<uint8_t>& log)
+{
+    log.assign(std::begin(c_magic), std::end(c_magic));
+    log.push_back(c_version);
+
+    for (const Favorite& favorite : m_favorites)
+        AppendRecord(log, RecordType::Add, favorite.uri, favorite.titleJson, favorite.faviconJson);
+
+    m_records.clear();
+    m_logSize = log.size();
+    m_snapshotSize = log.size();
+}
+
+bool FavoritesStore::Load(const std::vector<uint8_t>& log)
+{
+    m_favorites.clear();
+    m_indices.clear();
+    m_records.clear();
+    m_logSize = 0;
+    m_snapshotSize = 0;
+    if (log.size() < c_headerSize || log[0] != c_magic[0] || log[1] != c_magic[1] || log[2] != c_version)
+        return false;
+
+    size_t position = c_headerSize;
+    size_t loaded = position; // Up to the last intact record
+    std::wstring uri;
+    std::wstring titleJson;
+    std::wstring faviconJson;
+    const uint8_t* payload = nullptr;
+    size_t length = 0;
+    while (ReadChecksummedRecord(log, position, payload, length))
+    {
+        size_t start = static_cast<size_t>(payload - log.data());
+        size_t end = start + length;
+        size_t fieldPosition = start + 1;
+        RecordType type = static_cast<RecordType>(payload[0]);
+        if (!ReadString(log, fieldPosition, end, uri))
+            break;
+        if (type == RecordType::Add)
+        {
+            if (!ReadString(log, fieldPosition, end, titleJson) || !ReadString(log, fieldPosition, end, faviconJson))
+                break;
+            if (!JsonReader::IsString(titleJson))
+                titleJson.clear();
+            if (!JsonReader::IsString(faviconJson))
+                faviconJson.clear();
+        }
+
+        Apply(type, uri, titleJson, faviconJson);
+        loaded = position;
+    }
+
+    // Whatever follows a damaged record is dropped by the next snapshot
+    m_logSize = loaded;
+    m_snapshotSize = loaded;
+    return true;
+}
+
+bool FavoritesStore::Apply(RecordType type, std::wstring_view uri, std::wstring_view titleJson, std::wstring_view faviconJson)
+{
+    Canonicalize(uri, m_key);
+    auto it = m_indices.find(m_key);
+    switch (type)
+    {
+    case RecordType::Add:
+        if (it == m_indices.end())
+        {
+            m_indices.emplace(m_key, m_favorites.size());
+            m_favorites.push_back({ std::wstring(uri), std::wstring(titleJson), std::wstring(faviconJson) });
+            return true;
+        }
+        else
+        {
+            Favorite& favorite = m_favorites[it->second];
+            if (favorite.uri == uri && favorite.titleJson == titleJson && favorite.faviconJson == faviconJson)
+                return false;
+            favorite.uri = uri;
+            favorite.titleJson = titleJson;
+            favorite.faviconJson = faviconJson;
+            return true;
+        }
+    case RecordType::Remove:
+    {
+        if (it == m_indices.end())
+            return false;
+        // Favorites are few, the ones added later move up one
+        size_t index = it->second;
+        m_indices.erase(it);
+        m_favorites.erase(m_favorites.begin() + index);
+        for (auto& entry : m_indices)
+        {
+            if (entry.second > index)
+                --entry.second;
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+// The payload is the record type and the URI, then the title and favicon
+// of an added favorite
+void FavoritesStore::AppendRecord(std::vector<uint8_t>& bytes, RecordType type, std::wstring_view uri, std::wstring_view titleJson, std::wstring_view faviconJson)
+{
+    m_payload.clear();
+    m_payload.push_back(static_cast<uint8_t>(type));
+    AppendString(m_payload, m_text, uri);
+    if (type == RecordType::Add)
+    {
+        AppendString(m_payload, m_text, titleJson);
+        AppendString(m_payload, m_text, faviconJson);
+    }
+    AppendChecksummedRecord(bytes, m_payload);
+}
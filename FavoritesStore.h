@@ -0,0 +1,81 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// The favorites, kept as an append-only log like the session and the
+// history. They're also hashed by canonical URI, so whether a page is a
+// favorite is a lookup, however often tabs navigate. Favorites are few and
+// change when the user asks, each change is written as it's made.
+// Nothing in here depends on Windows headers.
+
+struct Favorite
+{
+    std::wstring uri; // As it was added
+    std::wstring titleJson; // JSON strings as posted by the controls UI
+    std::wstring faviconJson;
+};
+
+class FavoritesStore
+{
+public:
+    static const size_t c_minCompactSize = 16 * 1024; // Bytes of log
+
+    // The URI with its scheme and host lowercased, without the default port,
+    // and with "/" as its path if it has none. URIs that only differ in
+    // those are the same favorite.
+    static void Canonicalize(std::wstring_view uri, std::wstring& canonical);
+
+    // Adds the favorite, or updates the one with the same URI. Returns
+    // whether anything changed.
+    bool Add(std::wstring_view uri, std::wstring_view titleJson, std::wstring_view faviconJson);
+    bool Remove(std::wstring_view uri);
+    bool Contains(std::wstring_view uri) const;
+
+    // In the order they were added
+    const std::vector<Favorite>& GetFavorites() const { return m_favorites; }
+
+    // Records not written yet, to be appended to the log file
+    bool HasRecords() const { return !m_records.empty(); }
+    void TakeRecords(std::vector<uint8_t>& records);
+    // Whether the file has grown past c_minCompactSize and four times its
+    // last snapshot
+    bool ShouldCompact() const;
+    // Every favorite as a new log, to replace the file with. Pending records
+    // are part of it.
+    void WriteSnapshot(std::vector<uint8_t>& log);
+
+    // Replays a log read back from the file. Returns false if it isn't one,
+    // there are no favorites then.
+    bool Load(const std::vector<uint8_t>& log);
+    // Of the log as it is in the file, up to the last intact record
+    size_t GetLogSize() const { return m_logSize; }
+
+private:
+    enum class RecordType : uint8_t
+    {
+        Add = 1,
+        Remove
+    };
+
+    // Returns whether the favorites changed
+    bool Apply(RecordType type, std::wstring_view uri, std::wstring_view titleJson, std::wstring_view faviconJson);
+    void AppendRecord(std::vector<uint8_t>& bytes, RecordType type, std::wstring_view uri, std::wstring_view titleJson, std::wstring_view faviconJson);
+
+    std::vector<Favorite> m_favorites;
+    std::unordered_map<std::wstring, size_t> m_indices; // Of the favorites, by canonical URI
+    mutable std::wstring m_key; // Reused by lookups
+    std::vector<uint8_t> m_records;
+    std::vector<uint8_t> m_payload; // Reused by AppendRecord
+    std::vector<uint8_t> m_text;
+    size_t m_logSize = 0; // In the file, once the records are written
+    size_t m_snapshotSize = 0;
+};
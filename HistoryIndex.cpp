@@ -0,0 +1,279 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "HistoryIndex.h"
+#include <algorithm>
+#include "ByteCodec.h"
+
+void HistoryIndex::Fold(std::wstring_view text, std::wstring& folded)
+{
+    folded.resize(text.size());
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        wchar_t c = text[i];
+        if ((c >= L'A' && c <= L'Z') || (c >= 0xC0 && c <= 0xDE && c != 0xD7))
+            c += 0x20;
+        folded[i] = c;
+    }
+}
+
+void HistoryIndex::SplitQuery(std::wstring_view query, std::vector<std::wstring>& words)
+{
+    words.clear();
+    std::wstring folded;
+    Fold(query, folded);
+    size_t start = 0;
+    for (size_t i = 0; i <= folded.size(); ++i)
+    {
+        if (i < folded.size() && folded[i] > L' ' && folded[i] != 0xA0)
+            continue;
+        if (i > start)
+            words.emplace_back(folded, start, i - start);
+        start = i + 1;
+    }
+}
+
+void HistoryIndex::Add(uint64_t id, std::wstring_view text)
+{
+    Fold(text, m_folded);
+    if (m_folded.size() < c_trigramSize)
+        return;
+
+    m_trigrams.clear();
+    for (size_t i = 0; i + c_trigramSize <= m_folded.size(); ++i)
+        m_trigrams.push_back(GetTrigram(&m_folded[i]));
+    std::sort(m_trigrams.begin(), m_trigrams.end());
+    m_trigrams.erase(std::unique(m_trigrams.begin(), m_trigrams.end()), m_trigrams.end());
+
+    for (uint64_t trigram : m_trigrams)
+        Insert(m_postings[trigram], id);
+}
+
+void HistoryIndex::Clear()
+{
+    m_postings.clear();
+}
+
+// The smallest list is decoded and the others only probed for its ids,
+// skipping the blocks that can't have them
+bool HistoryIndex::FindCandidates(const std::vector<std::wstring>& words, size_t maxCount, std::vector<uint64_t>& ids) const
+{
+    ids.clear();
+    std::vector<uint64_t> trigrams;
+    for (const std::wstring& word : words)
+    {
+        for (size_t i = 0; i + c_trigramSize <= word.size(); ++i)
+            trigrams.push_back(GetTrigram(&word[i]));
+    }
+    if (trigrams.empty())
+        return false;
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+    std::vector<const Posting*> postings;
+    for (uint64_t trigram : trigrams)
+    {
+        auto it = m_postings.find(trigram);
+        if (it == m_postings.end())
+            return true;
+        postings.push_back(&it->second);
+    }
+    auto getCount = [](const Posting* posting) { return posting->count + posting->pending.size(); };
+    std::sort(postings.begin(), postings.end(), [&getCount](const Posting* a, const Posting* b) { return getCount(a) < getCount(b); });
+    if (getCount(postings[0]) > maxCount)
+        return false;
+
+    Decode(*postings[0], ids);
+    for (size_t i = 1; i < postings.size() && !ids.empty() && getCount(postings[i]) <= ids.size() * c_probeRatio; ++i)
+    {
+        const Posting& posting = *postings[i];
+        size_t position = 0;
+        size_t skip = 0;
+        uint64_t id = 0;
+        size_t kept = 0;
+        for (uint64_t candidate : ids)
+        {
+            for (; skip < posting.skips.size() && posting.skips[skip].id < candidate; ++skip)
+            {
+                if (posting.skips[skip].offset > position)
+                {
+                    position = posting.skips[skip].offset;
+                    id = posting.skips[skip].id;
+                }
+            }
+            uint64_t delta = 0;
+            while (id < candidate && position < posting.bytes.size() && ReadVarint(posting.bytes, position, delta))
+                id += delta;
+
+            if (id == candidate || std::binary_search(posting.pending.begin(), posting.pending.end(), candidate))
+                ids[kept++] = candidate;
+        }
+        ids.resize(kept);
+    }
+    return true;
+}
+
+// The number of lists, then each one with its trigram, as WritePosting
+// writes it
+void HistoryIndex::Write(std::vector<uint8_t>& bytes) const
+{
+    AppendVarint(bytes, m_postings.size());
+    std::vector<uint64_t> ids;
+    for (const auto& [trigram, posting] : m_postings)
+    {
+        if (posting.pending.empty())
+        {
+            WritePosting(bytes, trigram, posting);
+            continue;
+        }
+        Posting merged;
+        Decode(posting, ids);
+        Encode(ids, merged);
+        WritePosting(bytes, trigram, merged);
+    }
+}
+
+bool HistoryIndex::Read(const std::vector<uint8_t>& bytes, size_t position, size_t end)
+{
+    Clear();
+    auto read = [&bytes, &position, end](uint64_t& value)
+    {
+        return ReadVarint(bytes, position, value) && position <= end;
+    };
+
+    uint64_t count = 0;
+    if (!read(count) || count > end - position)
+        return false;
+    m_postings.reserve(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        uint64_t trigram = 0;
+        uint64_t idCount = 0;
+        uint64_t last = 0;
+        uint64_t length = 0;
+        // Every id takes a byte at least
+        if (!read(trigram) || !read(idCount) || !read(last) || !read(length) || length > end - position ||
+            idCount == 0 || idCount > length)
+        {
+            Clear();
+            return false;
+        }
+        // Each trigram has one list
+        auto [it, isValid] = m_postings.try_emplace(trigram);
+        Posting& posting = it->second;
+        posting.bytes.assign(bytes.begin() + position, bytes.begin() + position + static_cast<size_t>(length));
+        posting.count = static_cast<size_t>(idCount);
+        posting.last = last;
+        position += static_cast<size_t>(length);
+
+        uint64_t skipId = 0;
+        uint64_t offset = 0;
+        for (uint64_t skip = 0; isValid && skip < (idCount + c_blockSize - 1) / c_blockSize; ++skip)
+        {
+            uint64_t idDelta = 0;
+            uint64_t offsetDelta = 0;
+            if (!read(idDelta) || !read(offsetDelta))
+                isValid = false;
+            skipId += idDelta;
+            offset += offsetDelta;
+            isValid = isValid && skipId < last && offset < length;
+            posting.skips.push_back({ skipId, static_cast<size_t>(offset) });
+        }
+        if (!isValid)
+        {
+            Clear();
+            return false;
+        }
+    }
+    if (position != end)
+    {
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+uint64_t HistoryIndex::GetTrigram(const wchar_t* text)
+{
+    const uint64_t mask = 0x1FFFFF; // Code points fit in 21 bits
+    return ((text[0] & mask) << 42) | ((text[1] & mask) << 21) | (text[2] & mask);
+}
+
+void HistoryIndex::Append(Posting& posting, uint64_t id)
+{
+    if (posting.count % c_blockSize == 0)
+        posting.skips.push_back({ posting.last, posting.bytes.size() });
+    AppendVarint(posting.bytes, id - posting.last);
+    posting.last = id;
+    ++posting.count;
+}
+
+void HistoryIndex::Decode(const Posting& posting, std::vector<uint64_t>& ids)
+{
+    ids.clear();
+    ids.reserve(posting.count + posting.pending.size());
+    size_t position = 0;
+    uint64_t id = 0;
+    uint64_t delta = 0;
+    while (position < posting.bytes.size() && ReadVarint(posting.bytes, position, delta))
+    {
+        id += delta;
+        ids.push_back(id);
+    }
+
+    if (!posting.pending.empty())
+    {
+        size_t middle = ids.size();
+        ids.insert(ids.end(), posting.pending.begin(), posting.pending.end());
+        std::inplace_merge(ids.begin(), ids.begin() + middle, ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    }
+}
+
+void HistoryIndex::Encode(const std::vector<uint64_t>& ids, Posting& posting)
+{
+    posting = Posting();
+    for (uint64_t id : ids)
+        Append(posting, id);
+}
+
+// The id count, the last id and the length of the deltas, the deltas, then
+// the skips with their ids and offsets as deltas
+void HistoryIndex::WritePosting(std::vector<uint8_t>& bytes, uint64_t trigram, const Posting& posting)
+{
+    AppendVarint(bytes, trigram);
+    AppendVarint(bytes, posting.count);
+    AppendVarint(bytes, posting.last);
+    AppendVarint(bytes, posting.bytes.size());
+    bytes.insert(bytes.end(), posting.bytes.begin(), posting.bytes.end());
+
+    Skip previous = { 0, 0 };
+    for (const Skip& skip : posting.skips)
+    {
+        AppendVarint(bytes, skip.id - previous.id);
+        AppendVarint(bytes, skip.offset - previous.offset);
+        previous = skip;
+    }
+}
+
+// An earlier id waits in the pending ones, until there are enough of them to
+// rewrite the list with
+void HistoryIndex::Insert(Posting& posting, uint64_t id)
+{
+    if (id > posting.last)
+    {
+        Append(posting, id);
+        return;
+    }
+    auto it = std::lower_bound(posting.pending.begin(), posting.pending.end(), id);
+    if (id == posting.last || (it != posting.pending.end() && *it == id))
+        return;
+
+    posting.pending.insert(it, id);
+    if (posting.pending.size() > c_maxPending)
+    {
+        Decode(posting, m_ids);
+        Encode(m_ids, posting);
+    }
+}
@@ -0,0 +1,82 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// An inverted index of the text of the history: for every trigram of the
+// case folded titles and URIs, the ids of the entries that have it. A word of
+// a query can only match entries that have all of its trigrams, which makes
+// any substring searchable without scanning the history.
+// Candidates are a superset of the matches: the index doesn't forget text
+// that was replaced or removed, and trigrams don't need to be adjacent, so
+// HistoryStore checks each candidate against its entry.
+// Nothing in here depends on Windows headers.
+class HistoryIndex
+{
+public:
+    static const size_t c_trigramSize = 3;
+
+    // Folds ASCII and Latin-1 letters to lower case, the same on every
+    // platform so a saved index reads back as it was written
+    static void Fold(std::wstring_view text, std::wstring& folded);
+    // Folded words of the query, split at whitespace
+    static void SplitQuery(std::wstring_view query, std::vector<std::wstring>& words);
+
+    // Indexes text of the entry. Ids mostly come in increasing order, an
+    // earlier one costs more until the list it goes to is next rewritten.
+    void Add(uint64_t id, std::wstring_view text);
+    void Clear();
+    size_t GetTrigramCount() const { return m_postings.size(); }
+
+    // The ids of the entries with the trigrams of the words, ascending.
+    // Returns false if no word is long enough to have one, or each of them
+    // is in more than maxCount entries: every entry is a candidate then.
+    // Lists much longer than the candidates are left for the entries to
+    // rule out, probing them costs more than they rule out.
+    bool FindCandidates(const std::vector<std::wstring>& words, size_t maxCount, std::vector<uint64_t>& ids) const;
+
+    // The lists as they are, to be read back by Read
+    void Write(std::vector<uint8_t>& bytes) const;
+    bool Read(const std::vector<uint8_t>& bytes, size_t position, size_t end);
+
+private:
+    static const size_t c_blockSize = 128; // Ids between skips
+    static const size_t c_maxPending = 64;
+    static const size_t c_probeRatio = 16; // Longest list probed, in candidates
+
+    // Where a block of ids starts, and the id its first delta is from
+    struct Skip
+    {
+        uint64_t id;
+        size_t offset;
+    };
+
+    struct Posting
+    {
+        std::vector<uint8_t> bytes; // Deltas between ascending ids, as varints
+        std::vector<Skip> skips; // One per c_blockSize ids
+        uint64_t last = 0;
+        size_t count = 0;
+        std::vector<uint64_t> pending; // Added out of order, sorted
+    };
+
+    static uint64_t GetTrigram(const wchar_t* text);
+    static void Append(Posting& posting, uint64_t id);
+    static void Decode(const Posting& posting, std::vector<uint64_t>& ids);
+    static void Encode(const std::vector<uint64_t>& ids, Posting& posting);
+    static void WritePosting(std::vector<uint8_t>& bytes, uint64_t trigram, const Posting& posting);
+    void Insert(Posting& posting, uint64_t id);
+
+    std::unordered_map<uint64_t, Posting> m_postings; // By trigram
+    std::wstring m_folded; // Reused by Add
+    std::vector<uint64_t> m_trigrams;
+    std::vector<uint64_t> m_ids;
+};
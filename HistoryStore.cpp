@@ -0,0 +1,764 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "HistoryStore.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include "ByteCodec.h"
+#include "MessageCodec.h"
+
+namespace
+{
+    const uint8_t c_magic[] = { 'W', 'H' };
+    const uint8_t c_version = 1;
+    const size_t c_headerSize = sizeof(c_magic) + 1;
+    const uint8_t c_indexMagic[] = { 'W', 'X' };
+    const uint8_t c_indexVersion = 1;
+    // Up to one candidate in this many entries, the candidates are ordered
+    // by time. With more, the entries are read in the order of the time
+    // index, as most of them match.
+    const size_t c_sortRatio = 16;
+
+    // Reads the fields of a record, none of them past its end
+    class RecordReader
+    {
+    public:
+        RecordReader(const std::vector<uint8_t>& bytes, size_t position, size_t end)
+            : m_bytes(bytes), m_position(position), m_end(end) {}
+
+        bool ReadNumber(uint64_t& value)
+        {
+            return ReadVarint(m_bytes, m_position, value) && m_position <= m_end;
+        }
+
+        bool ReadSigned(int64_t& value)
+        {
+            uint64_t encoded = 0;
+            if (!ReadNumber(encoded))
+                return false;
+            value = ZigzagDecode(encoded);
+            return true;
+        }
+
+        bool ReadString(std::wstring& value)
+        {
+            uint64_t length = 0;
+            if (!ReadNumber(length) || length > m_end - m_position)
+                return false;
+            size_t start = m_position;
+            m_position += static_cast<size_t>(length);
+            return DecodeUtf8(m_bytes.data() + start, static_cast<size_t>(length), value);
+        }
+
+        // Up to the end of the record
+        bool ReadText(std::wstring& value)
+        {
+            size_t start = m_position;
+            m_position = m_end;
+            return DecodeUtf8(m_bytes.data() + start, m_end - start, value);
+        }
+
+        size_t GetPosition() const { return m_position; }
+
+    private:
+        const std::vector<uint8_t>& m_bytes;
+        size_t m_position;
+        size_t m_end;
+    };
+
+    void AppendString(std::vector<uint8_t>& bytes, std::vector<uint8_t>& text, std::wstring_view value)
+    {
+        text.clear();
+        AppendUtf8(text, value);
+        AppendVarint(bytes, text.size());
+        bytes.insert(bytes.end(), text.begin(), text.end());
+    }
+}
+
+// Howard Hinnant's days_from_civil
+int64_t HistoryStore::GetDay(int year, unsigned int month, unsigned int day)
+{
+    int64_t y = static_cast<int64_t>(year) - (month <= 2 ? 1 : 0);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yearOfEra = y - era * 400;
+    int64_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+uint64_t HistoryStore::AddVisit(std::wstring_view uri, int64_t timestamp, int64_t day)
+{
+    if (uint64_t id = FindVisit(uri, day); id != 0)
+    {
+        // The clock may have gone back, the entry only moves forward
+        HistoryEntry* entry = FindEntry(id);
+        if (timestamp > entry->timestamp)
+        {
+            entry->timestamp = timestamp;
+            AddKey(timestamp, id);
+            DropStaleKey();
+            AddPending(id, PendingTimestamp);
+        }
+        return id;
+    }
+
+    uint64_t id = m_firstId + m_entries.size();
+    HistoryEntry& entry = InsertEntry(id, timestamp, day, uri);
+    AddKey(timestamp, id);
+    IndexEntry(entry);
+    AddPending(id, PendingAdd);
+    return id;
+}
+
+void HistoryStore::SetTitle(uint64_t id, std::wstring_view titleJson)
+{
+    HistoryEntry* entry = FindEntry(id);
+    if (entry == nullptr || entry->titleJson == titleJson)
+        return;
+
+    m_staleTexts += entry->titleJson.empty() ? 0 : 1;
+    entry->titleJson = titleJson;
+    IndexTitle(id, titleJson);
+    AddPending(id, PendingTitle);
+}
+
+void HistoryStore::SetFavicon(uint64_t id, std::wstring_view faviconJson)
+{
+    HistoryEntry* entry = FindEntry(id);
+    if (entry == nullptr || entry->faviconJson == faviconJson)
+        return;
+
+    entry->faviconJson = faviconJson;
+    AddPending(id, PendingFavicon);
+}
+
+void HistoryStore::Remove(uint64_t id)
+{
+    HistoryEntry* entry = FindEntry(id);
+    if (entry == nullptr)
+        return;
+
+    RemoveEntry(*entry);
+    DropStaleKey();
+    ++m_staleTexts;
+
+    // An entry that wasn't written yet never is
+    auto pending = m_pending.find(id);
+    if (pending == m_pending.end())
+        AddPending(id, PendingRemove);
+    else if (pending->second & PendingAdd)
+        m_pending.erase(pending);
+    else
+        pending->second = PendingRemove;
+}
+
+void HistoryStore::Clear()
+{
+    if (m_count == 0)
+        return;
+
+    uint64_t nextId = m_firstId + m_entries.size();
+    ClearEntries(nextId, nextId);
+    m_search.Clear();
+    m_staleTexts = 0;
+
+    // Nothing from before is written, the entries added after it are
+    m_pending.clear();
+    m_pendingIds.clear();
+    m_pendingClear = nextId;
+}
+
+const HistoryEntry* HistoryStore::Find(uint64_t id) const
+{
+    if (id < m_firstId || id - m_firstId >= m_entries.size())
+        return nullptr;
+    const HistoryEntry& entry = m_entries[static_cast<size_t>(id - m_firstId)];
+    return entry.id != 0 ? &entry : nullptr;
+}
+
+bool HistoryStore::GetPage(const std::optional<HistoryCursor>& after, size_t count, std::vector<const HistoryEntry*>& page) const
+{
+    page.clear();
+    auto it = m_index.end();
+    if (after)
+        it = std::lower_bound(m_index.begin(), m_index.end(), IndexKey{ after->timestamp, after->id });
+
+    while (it != m_index.begin())
+    {
+        --it;
+        if (!IsCurrent(*it))
+            continue;
+        if (page.size() == count)
+            return true;
+        page.push_back(Find(it->id));
+    }
+    return false;
+}
+
+std::wstring HistoryStore::FormatCursor(const HistoryEntry& last)
+{
+    return std::to_wstring(last.timestamp) + L':' + std::to_wstring(last.id);
+}
+
+bool HistoryStore::ParseCursor(std::wstring_view text, HistoryCursor& cursor)
+{
+    size_t separator = text.find(L':');
+    if (separator == std::wstring_view::npos)
+        return false;
+
+    auto parse = [](std::wstring_view digits, uint64_t& value)
+    {
+        value = 0;
+        for (wchar_t c : digits)
+        {
+            if (c < L'0' || c > L'9' || value > (UINT64_MAX - 9) / 10)
+                return false;
+            value = value * 10 + (c - L'0');
+        }
+        return !digits.empty();
+    };
+    uint64_t timestamp = 0;
+    if (!parse(text.substr(0, separator), timestamp) || timestamp > INT64_MAX || !parse(text.substr(separator + 1), cursor.id))
+        return false;
+    cursor.timestamp = static_cast<int64_t>(timestamp);
+    return true;
+}
+
+// Candidates are read most recent first until there's one more match than
+// the page takes
+bool HistoryStore::Search(std::wstring_view query, const std::optional<HistoryCursor>& after, size_t count, std::vector<const HistoryEntry*>& page)
+{
+    HistoryIndex::SplitQuery(query, m_words);
+    if (m_words.empty())
+        return GetPage(after, count, page);
+
+    page.clear();
+    bool isNarrowed = m_search.FindCandidates(m_words, m_count / c_sortRatio, m_candidates);
+    IndexKey last = after ? IndexKey{ after->timestamp, after->id } : IndexKey{ INT64_MAX, UINT64_MAX };
+    if (isNarrowed)
+    {
+        m_keys.clear();
+        for (uint64_t id : m_candidates)
+        {
+            const HistoryEntry* entry = Find(id);
+            if (entry != nullptr && IndexKey{ entry->timestamp, id } < last)
+                m_keys.push_back({ entry->timestamp, id });
+        }
+        std::make_heap(m_keys.begin(), m_keys.end());
+        for (auto end = m_keys.end(); end != m_keys.begin(); --end)
+        {
+            std::pop_heap(m_keys.begin(), end);
+            const HistoryEntry* entry = Find((end - 1)->id);
+            if (!Matches(*entry))
+                continue;
+            if (page.size() == count)
+                return true;
+            page.push_back(entry);
+        }
+        return false;
+    }
+
+    auto it = after ? std::lower_bound(m_index.begin(), m_index.end(), last) : m_index.end();
+    while (it != m_index.begin())
+    {
+        --it;
+        if (!IsCurrent(*it))
+            continue;
+        const HistoryEntry* entry = Find(it->id);
+        if (!Matches(*entry))
+            continue;
+        if (page.size() == count)
+            return true;
+        page.push_back(entry);
+    }
+    return false;
+}
+
+// A clear goes first, the entries changed after it have later ids. Every
+// other record is of a single entry, added in the same record or one taken
+// before, so the records replay to a whole history wherever a crash cuts
+// them short.
+void HistoryStore::TakeRecords(std::vector<uint8_t>& records)
+{
+    m_records.clear();
+    if (m_pendingClear != 0)
+    {
+        AppendRecord(m_records, RecordType::Clear, m_pendingClear, m_pendingClear);
+        Commit(0);
+        m_pendingClear = 0;
+    }
+
+    for (uint64_t id : m_pendingIds)
+    {
+        auto pending = m_pending.find(id);
+        if (pending == m_pending.end())
+            continue;
+        uint8_t changes = pending->second;
+        size_t size = m_records.size();
+        if (changes & PendingRemove)
+        {
+            AppendRecord(m_records, RecordType::Remove, id, 0);
+            Commit(size);
+            continue;
+        }
+
+        const HistoryEntry& entry = *Find(id);
+        if (changes & PendingAdd)
+        {
+            AppendEntryRecord(m_records, entry);
+            Commit(size);
+            continue;
+        }
+        if (changes & PendingTimestamp)
+        {
+            AppendRecord(m_records, RecordType::SetTimestamp, id, ZigzagEncode(entry.timestamp));
+            Commit(size);
+            size = m_records.size();
+        }
+        if (changes & PendingTitle)
+        {
+            AppendRecord(m_records, RecordType::SetTitle, id, 0, entry.titleJson);
+            Commit(size);
+            size = m_records.size();
+        }
+        if (changes & PendingFavicon)
+        {
+            AppendRecord(m_records, RecordType::SetFavicon, id, 0, entry.faviconJson);
+            Commit(size);
+        }
+    }
+    m_pending.clear();
+    m_pendingIds.clear();
+
+    records.swap(m_records);
+}
+
+bool HistoryStore::ShouldCompact() const
+{
+    return m_logSize > c_minCompactSize && m_logSize > m_snapshotSize * 2;
+}
+
+// The first record reserves the ids of the removed entries, so they aren't
+// handed out again after a restart
+void HistoryStore::WriteSnapshot(std::vector<uint8_t>& log)
+{
+    log.assign(std::begin(c_magic), std::end(c_magic));
+    log.push_back(c_version);
+
+    uint64_t nextId = m_firstId + m_entries.size();
+    auto first = std::find_if(m_entries.begin(), m_entries.end(), [](const HistoryEntry& entry) { return entry.id != 0; });
+    m_stamp = 0;
+    AppendRecord(log, RecordType::Clear, first != m_entries.end() ? first->id : nextId, nextId);
+    Stamp(log.data() + log.size());
+    for (const HistoryEntry& entry : m_entries)
+    {
+        if (entry.id != 0)
+        {
+            AppendEntryRecord(log, entry);
+            Stamp(log.data() + log.size());
+        }
+    }
+
+    m_pending.clear();
+    m_pendingIds.clear();
+    m_pendingClear = 0;
+    m_logSize = log.size();
+    m_snapshotSize = log.size();
+
+    // Text replaced or removed only costs candidates to check, until it's
+    // as much as there is left
+    if (m_staleTexts * 2 > m_count)
+        RebuildIndex();
+}
+
+bool HistoryStore::HasIndexChanges() const
+{
+    return m_indexedSize != m_logSize || m_indexedStamp != m_stamp;
+}
+
+// The size and stamp of the log the index is for and the count of stale
+// texts, then the index, as one record
+void HistoryStore::WriteIndex(std::vector<uint8_t>& bytes)
+{
+    bytes.assign(std::begin(c_indexMagic), std::end(c_indexMagic));
+    bytes.push_back(c_indexVersion);
+
+    std::vector<uint8_t> payload;
+    AppendVarint(payload, m_logSize);
+    AppendVarint(payload, m_stamp);
+    AppendVarint(payload, m_staleTexts);
+    m_search.Write(payload);
+    AppendChecksummedRecord(bytes, payload);
+
+    m_indexedSize = m_logSize;
+    m_indexedStamp = m_stamp;
+}
+
+bool HistoryStore::Load(const std::vector<uint8_t>& log, const std::vector<uint8_t>& index)
+{
+    ClearEntries(1, 1);
+    m_search.Clear();
+    m_staleTexts = 0;
+    m_pending.clear();
+    m_pendingIds.clear();
+    m_pendingClear = 0;
+    m_logSize = 0;
+    m_snapshotSize = 0;
+    m_stamp = 0;
+    m_indexedSize = 0;
+    m_indexedStamp = 0;
+    if (log.size() < c_headerSize || log[0] != c_magic[0] || log[1] != c_magic[1] || log[2] != c_version)
+        return false;
+
+    // The index is used once the log is replayed as far as it was written
+    // for, the records after that are indexed as they're replayed
+    size_t indexedSize = 0;
+    uint64_t indexedStamp = 0;
+    bool hasIndex = ReadIndex(index, indexedSize, indexedStamp);
+    bool isIndexed = false;
+    size_t position = c_headerSize;
+    size_t loaded = position; // Up to the last intact record
+    auto catchUp = [&]()
+    {
+        if (hasIndex && !isIndexed && loaded == indexedSize && m_stamp == indexedStamp)
+        {
+            isIndexed = true;
+            m_indexedSize = indexedSize;
+            m_indexedStamp = indexedStamp;
+        }
+    };
+    catchUp();
+
+    const uint8_t* payload = nullptr;
+    size_t length = 0;
+    while (ReadChecksummedRecord(log, position, payload, length))
+    {
+        size_t start = static_cast<size_t>(payload - log.data());
+        if (!Replay(log, start, start + length, isIndexed))
+            break;
+        Stamp(log.data() + position);
+        loaded = position;
+        catchUp();
+    }
+    if (!isIndexed)
+        RebuildIndex();
+
+    // The index is sorted once rather than kept sorted through the replay
+    m_index.clear();
+    m_index.reserve(m_count);
+    for (const HistoryEntry& entry : m_entries)
+    {
+        if (entry.id != 0)
+            m_index.push_back({ entry.timestamp, entry.id });
+    }
+    std::sort(m_index.begin(), m_index.end());
+    m_staleKeys = 0;
+
+    // Whatever follows a damaged record is dropped by the next snapshot
+    m_logSize = loaded;
+    m_snapshotSize = loaded;
+    return true;
+}
+
+HistoryEntry* HistoryStore::FindEntry(uint64_t id)
+{
+    return const_cast<HistoryEntry*>(Find(id));
+}
+
+uint64_t HistoryStore::FindVisit(std::wstring_view uri, int64_t day) const
+{
+    auto range = m_visits.equal_range(HashVisit(uri, day));
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const HistoryEntry* entry = Find(it->second);
+        if (entry != nullptr && entry->day == day && entry->uri == uri)
+            return entry->id;
+    }
+    return 0;
+}
+
+uint64_t HistoryStore::HashVisit(std::wstring_view uri, int64_t day)
+{
+    return std::hash<std::wstring_view>()(uri) ^ (static_cast<uint64_t>(day) * 0x9E3779B97F4A7C15ull);
+}
+
+HistoryEntry& HistoryStore::InsertEntry(uint64_t id, int64_t timestamp, int64_t day, std::wstring_view uri)
+{
+    size_t index = static_cast<size_t>(id - m_firstId);
+    if (index >= m_entries.size())
+        m_entries.resize(index + 1);
+
+    HistoryEntry& entry = m_entries[index];
+    entry.id = id;
+    entry.timestamp = timestamp;
+    entry.day = day;
+    entry.uri = uri;
+    m_visits.emplace(HashVisit(uri, day), id);
+    ++m_count;
+    return entry;
+}
+
+void HistoryStore::RemoveEntry(HistoryEntry& entry)
+{
+    auto range = m_visits.equal_range(HashVisit(entry.uri, entry.day));
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == entry.id)
+        {
+            m_visits.erase(it);
+            break;
+        }
+    }
+    entry = HistoryEntry();
+    --m_count;
+}
+
+bool HistoryStore::IsCurrent(const IndexKey& key) const
+{
+    const HistoryEntry* entry = Find(key.id);
+    return entry != nullptr && entry->timestamp == key.timestamp;
+}
+
+void HistoryStore::AddKey(int64_t timestamp, uint64_t id)
+{
+    // Visits mostly come in order, only a clock that went back inserts
+    IndexKey key{ timestamp, id };
+    if (m_index.empty() || m_index.back() < key)
+        m_index.push_back(key);
+    else
+        m_index.insert(std::upper_bound(m_index.begin(), m_index.end(), key), key);
+}
+
+void HistoryStore::DropStaleKey()
+{
+    if (++m_staleKeys * 2 <= m_index.size())
+        return;
+
+    m_index.erase(std::remove_if(m_index.begin(), m_index.end(), [this](const IndexKey& key) { return !IsCurrent(key); }), m_index.end());
+    m_staleKeys = 0;
+}
+
+// Ids from firstId up to nextId are taken, by entries or removed ones
+void HistoryStore::ClearEntries(uint64_t firstId, uint64_t nextId)
+{
+    m_entries.clear();
+    m_entries.resize(static_cast<size_t>(nextId - firstId));
+    m_firstId = firstId;
+    m_count = 0;
+    m_index.clear();
+    m_staleKeys = 0;
+    m_visits.clear();
+}
+
+bool HistoryStore::DecodeTitle(std::wstring_view titleJson, std::wstring_view& title)
+{
+    if (!JsonReader::IsString(titleJson))
+        return false;
+    m_decoded.assign(titleJson);
+    JsonValue value;
+    return JsonReader::ReadValue(&m_decoded[0], value) && value.GetString(title);
+}
+
+void HistoryStore::IndexEntry(const HistoryEntry& entry)
+{
+    m_search.Add(entry.id, entry.uri);
+    IndexTitle(entry.id, entry.titleJson);
+}
+
+void HistoryStore::IndexTitle(uint64_t id, std::wstring_view titleJson)
+{
+    std::wstring_view title;
+    if (DecodeTitle(titleJson, title))
+        m_search.Add(id, title);
+}
+
+void HistoryStore::RebuildIndex()
+{
+    m_search.Clear();
+    m_staleTexts = 0;
+    for (const HistoryEntry& entry : m_entries)
+    {
+        if (entry.id != 0)
+            IndexEntry(entry);
+    }
+}
+
+// Words are found in the URI or the title, not across them, as they're
+// indexed
+bool HistoryStore::Matches(const HistoryEntry& entry)
+{
+    HistoryIndex::Fold(entry.uri, m_foldedUri);
+    bool hasTitle = false;
+    for (const std::wstring& word : m_words)
+    {
+        if (m_foldedUri.find(word) != std::wstring::npos)
+            continue;
+        if (!hasTitle)
+        {
+            hasTitle = true;
+            std::wstring_view title;
+            if (!DecodeTitle(entry.titleJson, title))
+                return false;
+            HistoryIndex::Fold(title, m_foldedTitle);
+        }
+        if (m_foldedTitle.find(word) == std::wstring::npos)
+            return false;
+    }
+    return true;
+}
+
+bool HistoryStore::ReadIndex(const std::vector<uint8_t>& index, size_t& logSize, uint64_t& stamp)
+{
+    if (index.size() < c_headerSize || index[0] != c_indexMagic[0] || index[1] != c_indexMagic[1] || index[2] != c_indexVersion)
+        return false;
+
+    size_t position = c_headerSize;
+    const uint8_t* payload = nullptr;
+    size_t length = 0;
+    if (!ReadChecksummedRecord(index, position, payload, length))
+        return false;
+    size_t start = static_cast<size_t>(payload - index.data());
+    RecordReader reader(index, start, start + length);
+    uint64_t size = 0;
+    uint64_t staleTexts = 0;
+    if (!reader.ReadNumber(size) || !reader.ReadNumber(stamp) || !reader.ReadNumber(staleTexts) ||
+        !m_search.Read(index, reader.GetPosition(), start + length))
+        return false;
+
+    logSize = static_cast<size_t>(size);
+    m_staleTexts = static_cast<size_t>(staleTexts);
+    return true;
+}
+
+// The id, the time and day of the visits, then the URI, title and favicon,
+// each with its length
+void HistoryStore::AppendEntryRecord(std::vector<uint8_t>& bytes, const HistoryEntry& entry)
+{
+    m_payload.clear();
+    m_payload.push_back(static_cast<uint8_t>(RecordType::AddEntry));
+    AppendVarint(m_payload, entry.id);
+    AppendVarint(m_payload, ZigzagEncode(entry.timestamp));
+    AppendVarint(m_payload, ZigzagEncode(entry.day));
+    AppendString(m_payload, m_text, entry.uri);
+    AppendString(m_payload, m_text, entry.titleJson);
+    AppendString(m_payload, m_text, entry.faviconJson);
+    AppendChecksummedRecord(bytes, m_payload);
+}
+
+// The record type, the entry id, a number and the text, if any, up to its end
+void HistoryStore::AppendRecord(std::vector<uint8_t>& bytes, RecordType type, uint64_t id, uint64_t value, std::wstring_view text)
+{
+    m_payload.clear();
+    m_payload.push_back(static_cast<uint8_t>(type));
+    AppendVarint(m_payload, id);
+    AppendVarint(m_payload, value);
+    AppendUtf8(m_payload, text);
+    AppendChecksummedRecord(bytes, m_payload);
+}
+
+void HistoryStore::AddPending(uint64_t id, uint8_t changes)
+{
+    auto [it, isNew] = m_pending.emplace(id, changes);
+    if (isNew)
+        m_pendingIds.push_back(id);
+    else
+        it->second |= changes;
+}
+
+void HistoryStore::Commit(size_t size)
+{
+    m_logSize += m_records.size() - size;
+    Stamp(m_records.data() + m_records.size());
+}
+
+void HistoryStore::Stamp(const uint8_t* end)
+{
+    uint32_t checksum = end[-4] | (end[-3] << 8) | (end[-2] << 16) | (static_cast<uint32_t>(end[-1]) << 24);
+    m_stamp = (m_stamp ^ checksum) * 0x100000001B3ull;
+}
+
+// Applies a record without keeping the time index, Load rebuilds it.
+// Once the search index read with the log has caught up (isIndexed), the
+// record's text is indexed too, otherwise Load rebuilds that as well.
+bool HistoryStore::Replay(const std::vector<uint8_t>& log, size_t position, size_t end, bool isIndexed)
+{
+    RecordType type = static_cast<RecordType>(log[position]);
+    RecordReader reader(log, position + 1, end);
+    uint64_t id = 0;
+    if (!reader.ReadNumber(id))
+        return false;
+
+    if (type == RecordType::AddEntry)
+    {
+        int64_t timestamp = 0;
+        int64_t day = 0;
+        if (!reader.ReadSigned(timestamp) || !reader.ReadSigned(day) || !reader.ReadString(m_uri) ||
+            !reader.ReadString(m_titleJson) || !reader.ReadString(m_faviconJson))
+            return false;
+        // Each id is added once, holes are no larger than the log
+        if (id < m_firstId || id - m_firstId > m_entries.size() + log.size() ||
+            (id - m_firstId < m_entries.size() && m_entries[static_cast<size_t>(id - m_firstId)].id != 0))
+            return false;
+
+        HistoryEntry& entry = InsertEntry(id, timestamp, day, m_uri);
+        if (JsonReader::IsString(m_titleJson))
+            entry.titleJson = m_titleJson;
+        if (JsonReader::IsString(m_faviconJson))
+            entry.faviconJson = m_faviconJson;
+        if (isIndexed)
+            IndexEntry(entry);
+        return true;
+    }
+
+    uint64_t value = 0;
+    if (!reader.ReadNumber(value) || !reader.ReadText(m_titleJson))
+        return false;
+
+    HistoryEntry* entry = FindEntry(id);
+    switch (type)
+    {
+    case RecordType::SetTimestamp:
+        if (entry != nullptr)
+            entry->timestamp = ZigzagDecode(value);
+        return true;
+    case RecordType::SetTitle:
+        if (entry != nullptr && JsonReader::IsString(m_titleJson))
+        {
+            if (isIndexed)
+            {
+                m_staleTexts += entry->titleJson.empty() ? 0 : 1;
+                IndexTitle(id, m_titleJson);
+            }
+            entry->titleJson = m_titleJson;
+        }
+        return true;
+    case RecordType::SetFavicon:
+        if (entry != nullptr && JsonReader::IsString(m_titleJson))
+            entry->faviconJson = m_titleJson;
+        return true;
+    case RecordType::Remove:
+        if (entry != nullptr)
+        {
+            RemoveEntry(*entry);
+            m_staleTexts += isIndexed ? 1 : 0;
+        }
+        return true;
+    case RecordType::Clear:
+        // Reserves no more ids than the log could have entries for
+        if (value < id || id < m_firstId + m_entries.size() || value - id > log.size())
+            return false;
+        ClearEntries(id, value);
+        if (isIndexed)
+        {
+            m_search.Clear();
+            m_staleTexts = 0;
+        }
+        // A snapshot follows, with about as many entries
+        m_visits.reserve(static_cast<size_t>(value - id));
+        return true;
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,188 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "HistoryIndex.h"
+
+// The browsing history, kept as an append-only log like the session: every
+// change appends a checksummed record, and once the records outgrow the
+// entries they describe the log is replaced by a snapshot of them. Changes
+// are merged per entry until they're taken to be written, so a visit whose
+// title and favicon come before the next write is a single record.
+// Entries are indexed by time so a page of the history page costs the size
+// of the page however deep it is, by URI and day so a site visited again on
+// the same day updates its entry instead of adding one, and by the trigrams
+// of their titles and URIs so a search doesn't read every entry. The search
+// index is saved to its own file at exit and read back with the log.
+// Nothing in here depends on Windows headers.
+
+struct HistoryEntry
+{
+    uint64_t id = 0; // 0 once removed, ids aren't reused
+    int64_t timestamp = 0; // Of the last visit, in ms since 1970 UTC
+    int64_t day = 0; // Local day of the visits, see GetDay
+    std::wstring uri;
+    std::wstring titleJson; // JSON strings as posted by the page metadata script
+    std::wstring faviconJson;
+};
+
+// Where a page of the history ends, the next one starts with the entry
+// visited right before it
+struct HistoryCursor
+{
+    int64_t timestamp = 0;
+    uint64_t id = 0;
+};
+
+class HistoryStore
+{
+public:
+    static const size_t c_minCompactSize = 1024 * 1024; // Bytes of log
+
+    // Days since 1970-01-01 of a date of the proleptic Gregorian calendar
+    static int64_t GetDay(int year, unsigned int month, unsigned int day);
+
+    // Returns the id of the entry, the existing one if the URI was already
+    // visited that day
+    uint64_t AddVisit(std::wstring_view uri, int64_t timestamp, int64_t day);
+    void SetTitle(uint64_t id, std::wstring_view titleJson);
+    void SetFavicon(uint64_t id, std::wstring_view faviconJson);
+    void Remove(uint64_t id);
+    void Clear();
+
+    const HistoryEntry* Find(uint64_t id) const;
+    size_t GetCount() const { return m_count; }
+    // Up to count entries, most recent first, starting after the cursor or
+    // with the most recent one. Returns whether more entries follow.
+    bool GetPage(const std::optional<HistoryCursor>& after, size_t count, std::vector<const HistoryEntry*>& page) const;
+    // As the history page passes it back, the time and id of the last entry
+    // it got
+    static std::wstring FormatCursor(const HistoryEntry& last);
+    static bool ParseCursor(std::wstring_view text, HistoryCursor& cursor);
+    // Like GetPage, only entries with every word of the query in their title
+    // or URI, ignoring case
+    bool Search(std::wstring_view query, const std::optional<HistoryCursor>& after, size_t count, std::vector<const HistoryEntry*>& page);
+
+    // Changes not written yet, taken as records to append to the log file
+    bool HasRecords() const { return m_pendingClear != 0 || !m_pending.empty(); }
+    void TakeRecords(std::vector<uint8_t>& records);
+    // Whether the file has grown past c_minCompactSize and twice its last
+    // snapshot
+    bool ShouldCompact() const;
+    // Every entry as a new log, to replace the file with. Pending records
+    // are part of it.
+    void WriteSnapshot(std::vector<uint8_t>& log);
+    size_t GetLogSize() const { return m_logSize; }
+
+    // Whether the index changed since it was read or written
+    bool HasIndexChanges() const;
+    // The search index of the log as far as its records were taken, to be
+    // written to a file of its own
+    void WriteIndex(std::vector<uint8_t>& bytes);
+
+    // Replays a log read back from the file. The index written for it, or
+    // for the log before some of its records, saves rebuilding the search
+    // index; any other one is ignored. Returns false if the log isn't one,
+    // the history is empty then.
+    bool Load(const std::vector<uint8_t>& log, const std::vector<uint8_t>& index = {});
+
+private:
+    enum class RecordType : uint8_t
+    {
+        AddEntry = 1, // With the title and favicon, once known
+        SetTimestamp,
+        SetTitle,
+        SetFavicon,
+        Remove,
+        Clear // Of every entry, ids before the number are taken
+    };
+
+    // What changed in an entry since the records were last taken
+    enum PendingChange : uint8_t
+    {
+        PendingAdd = 1 << 0, // The whole entry, the other changes are part of it
+        PendingTimestamp = 1 << 1,
+        PendingTitle = 1 << 2,
+        PendingFavicon = 1 << 3,
+        PendingRemove = 1 << 4 // Of an entry written before
+    };
+
+    struct IndexKey
+    {
+        int64_t timestamp;
+        uint64_t id;
+
+        bool operator<(const IndexKey& other) const
+        {
+            return timestamp < other.timestamp || (timestamp == other.timestamp && id < other.id);
+        }
+    };
+
+    HistoryEntry* FindEntry(uint64_t id);
+    uint64_t FindVisit(std::wstring_view uri, int64_t day) const;
+    static uint64_t HashVisit(std::wstring_view uri, int64_t day);
+    HistoryEntry& InsertEntry(uint64_t id, int64_t timestamp, int64_t day, std::wstring_view uri);
+    void RemoveEntry(HistoryEntry& entry);
+    bool IsCurrent(const IndexKey& key) const;
+    // Keys are left behind by revisits and removals, and skipped by GetPage
+    // until they make up half the index
+    void AddKey(int64_t timestamp, uint64_t id);
+    void DropStaleKey();
+    void ClearEntries(uint64_t firstId, uint64_t nextId);
+    bool DecodeTitle(std::wstring_view titleJson, std::wstring_view& title);
+    void IndexEntry(const HistoryEntry& entry);
+    void IndexTitle(uint64_t id, std::wstring_view titleJson);
+    void RebuildIndex();
+    // Whether the entry has every word of m_words
+    bool Matches(const HistoryEntry& entry);
+    bool ReadIndex(const std::vector<uint8_t>& index, size_t& logSize, uint64_t& stamp);
+
+    void AppendEntryRecord(std::vector<uint8_t>& bytes, const HistoryEntry& entry);
+    void AppendRecord(std::vector<uint8_t>& bytes, RecordType type, uint64_t id, uint64_t value, std::wstring_view text = {});
+    void AddPending(uint64_t id, uint8_t changes);
+    // Counts the records appended since size
+    void Commit(size_t size);
+    // Adds the checksum of the record that ends there to m_stamp
+    void Stamp(const uint8_t* end);
+    // Indexes the text changes too, once the index read back is caught up
+    bool Replay(const std::vector<uint8_t>& log, size_t position, size_t end, bool isIndexed);
+
+    std::vector<HistoryEntry> m_entries; // Indexed by id - m_firstId
+    uint64_t m_firstId = 1;
+    size_t m_count = 0;
+    std::vector<IndexKey> m_index; // Sorted by time, oldest first
+    size_t m_staleKeys = 0;
+    std::unordered_multimap<uint64_t, uint64_t> m_visits; // HashVisit to id
+    std::unordered_map<uint64_t, uint8_t> m_pending; // PendingChange flags by id
+    std::vector<uint64_t> m_pendingIds; // In the order they first changed, some may be dropped
+    uint64_t m_pendingClear = 0; // The next id of a clear not written yet
+    std::vector<uint8_t> m_records; // Reused by TakeRecords
+    std::vector<uint8_t> m_payload; // Reused by AppendRecord
+    std::vector<uint8_t> m_text;
+    std::wstring m_uri; // Reused by Replay
+    std::wstring m_titleJson;
+    std::wstring m_faviconJson;
+    size_t m_logSize = 0; // In the file, once the records are written
+    size_t m_snapshotSize = 0;
+    uint64_t m_stamp = 0; // Of the records of the log, tells an index which log it is for
+
+    HistoryIndex m_search;
+    size_t m_staleTexts = 0; // Titles replaced and entries removed, still indexed
+    size_t m_indexedSize = 0; // The log m_search was last read or written for
+    uint64_t m_indexedStamp = 0;
+    std::vector<std::wstring> m_words; // Reused by Search
+    std::vector<uint64_t> m_candidates;
+    std::vector<IndexKey> m_keys;
+    std::wstring m_decoded; // Reused by DecodeTitle
+    std::wstring m_foldedUri; // Reused by Matches
+    std::wstring m_foldedTitle;
+};
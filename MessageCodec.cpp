@@ -0,0 +1,639 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "MessageCodec.h"
+#include "MessageSchema.h"
+#include <cmath>
+#include <cwchar>
+#include <cwctype>
+#include <limits>
+
+namespace
+{
+    // Past 2^53 doubles skip integers, so the number may not be the one sent
+    const double c_maxSafeInteger = 9007199254740991.0;
+
+    // Casting a double that's out of the range of T is undefined, and pages
+    // can send any number
+    template <typename T>
+    bool ToInteger(double number, T& value)
+    {
+        if (!std::isfinite(number) || std::trunc(number) != number || std::fabs(number) > c_maxSafeInteger ||
+            number < static_cast<double>(std::numeric_limits<T>::min()) ||
+            number >= std::ldexp(1.0, std::numeric_limits<T>::digits))
+            return false;
+        value = static_cast<T>(number);
+        return true;
+    }
+
+    wchar_t* SkipWhitespace(wchar_t* p, wchar_t* end)
+    {
+        while (p < end && (*p == L' ' || *p == L'\t' || *p == L'\n' || *p == L'\r'))
+            ++p;
+        return p;
+    }
+
+    // p points at the opening quote. Returns the position of the closing quote.
+    wchar_t* ScanString(wchar_t* p, wchar_t* end)
+    {
+        for (++p; p < end; ++p)
+        {
+            if (*p == L'\\')
+            {
+                if (++p == end)
+                    return nullptr;
+            }
+            else if (*p == L'"')
+            {
+                return p;
+            }
+        }
+        return nullptr;
+    }
+
+    // Skips an object or array without recursion, so deeply nested content
+    // from a web page can't exhaust the stack.
+    wchar_t* ScanContainer(wchar_t* p, wchar_t* end)
+    {
+        size_t depth = 0;
+        for (; p < end; ++p)
+        {
+            switch (*p)
+            {
+            case L'"':
+                p = ScanString(p, end);
+                if (p == nullptr)
+                    return nullptr;
+                break;
+            case L'{':
+            case L'[':
+                ++depth;
+                break;
+            case L'}':
+            case L']':
+                if (--depth == 0)
+                    return p + 1;
+                break;
+            }
+        }
+        return nullptr;
+    }
+
+    bool MatchLiteral(wchar_t* p, wchar_t* end, const wchar_t* literal, size_t length)
+    {
+        return static_cast<size_t>(end - p) >= length && wcsncmp(p, literal, length) == 0;
+    }
+
+    int HexValue(wchar_t c)
+    {
+        if (c >= L'0' && c <= L'9')
+            return c - L'0';
+        if (c >= L'a' && c <= L'f')
+            return c - L'a' + 10;
+        if (c >= L'A' && c <= L'F')
+            return c - L'A' + 10;
+        return -1;
+    }
+}
+
+bool JsonValue::GetBool(bool& value) const
+{
+    if (m_type != JsonType::Bool)
+        return false;
+
+    value = *m_begin == L't';
+    return true;
+}
+
+bool JsonValue::GetNumber(double& value) const
+{
+    if (m_type != JsonType::Number)
+        return false;
+
+    // The number is always followed by a delimiter, so wcstod stops in time
+    wchar_t* parsedEnd = nullptr;
+    value = wcstod(m_begin, &parsedEnd);
+    return parsedEnd == m_end;
+}
+
+bool JsonValue::GetInt(int& value) const
+{
+    double number;
+    return GetNumber(number) && ToInteger(number, value);
+}
+
+bool JsonValue::GetSize(size_t& value) const
+{
+    double number;
+    return GetNumber(number) && ToInteger(number, value);
+}
+
+bool JsonValue::GetString(std::wstring_view& value)
+{
+    if (m_type != JsonType::String)
+        return false;
+
+    if (!m_decoded)
+    {
+        // Unescaping never makes the string longer, so it is done over the
+        // original text and terminated where the closing quote used to be.
+        wchar_t* read = m_begin + 1;
+        wchar_t* last = m_end - 1;
+        wchar_t* write = m_begin;
+        while (read < last)
+        {
+            if (*read != L'\\')
+            {
+                *write++ = *read++;
+                continue;
+            }
+
+            ++read;
+            switch (*read++)
+            {
+            case L'"': *write++ = L'"'; break;
+            case L'\\': *write++ = L'\\'; break;
+            case L'/': *write++ = L'/'; break;
+            case L'b': *write++ = L'\b'; break;
+            case L'f': *write++ = L'\f'; break;
+            case L'n': *write++ = L'\n'; break;
+            case L'r': *write++ = L'\r'; break;
+            case L't': *write++ = L'\t'; break;
+            case L'u':
+            {
+                if (last - read < 4)
+                    return false;
+
+                int code = 0;
+                for (int i = 0; i < 4; ++i)
+                {
+                    int digit = HexValue(*read++);
+                    if (digit < 0)
+                        return false;
+                    code = (code << 4) | digit;
+                }
+                *write++ = static_cast<wchar_t>(code);
+            }
+            break;
+            default:
+                return false;
+            }
+        }
+        *write = L'\0';
+        m_decodedLength = write - m_begin;
+        m_decoded = true;
+    }
+
+    value = std::wstring_view(m_begin, m_decodedLength);
+    return true;
+}
+
+JsonObjectReader::JsonObjectReader(const JsonValue& object)
+{
+    if (object.m_type != JsonType::Object)
+    {
+        m_error = true;
+        return;
+    }
+
+    // Skip the braces
+    m_current = object.m_begin + 1;
+    m_end = object.m_end - 1;
+}
+
+bool JsonObjectReader::Next(std::wstring_view& key, JsonValue& value)
+{
+    if (m_error)
+        return false;
+
+    wchar_t* p = SkipWhitespace(m_current, m_end);
+    if (p == m_end)
+        return false;
+
+    if (!m_first)
+    {
+        if (*p != L',')
+        {
+            m_error = true;
+            return false;
+        }
+        p = SkipWhitespace(p + 1, m_end);
+    }
+    m_first = false;
+
+    if (p == m_end || *p != L'"')
+    {
+        m_error = true;
+        return false;
+    }
+
+    wchar_t* keyEnd = ScanString(p, m_end);
+    if (keyEnd == nullptr)
+    {
+        m_error = true;
+        return false;
+    }
+    key = std::wstring_view(p + 1, keyEnd - p - 1);
+
+    p = SkipWhitespace(keyEnd + 1, m_end);
+    if (p == m_end || *p != L':')
+    {
+        m_error = true;
+        return false;
+    }
+
+    p = JsonReader::ScanValue(SkipWhitespace(p + 1, m_end), m_end, value);
+    if (p == nullptr)
+    {
+        m_error = true;
+        return false;
+    }
+
+    m_current = p;
+    return true;
+}
+
+wchar_t* JsonReader::ScanValue(wchar_t* begin, wchar_t* end, JsonValue& value)
+{
+    value = JsonValue();
+    if (begin >= end)
+        return nullptr;
+
+    wchar_t* p = begin;
+    switch (*p)
+    {
+    case L'"':
+        p = ScanString(p, end);
+        if (p == nullptr)
+            return nullptr;
+        ++p;
+        value.m_type = JsonType::String;
+        break;
+    case L'{':
+    case L'[':
+        value.m_type = *p == L'{' ? JsonType::Object : JsonType::Array;
+        p = ScanContainer(p, end);
+        if (p == nullptr)
+            return nullptr;
+        break;
+    case L't':
+        if (!MatchLiteral(p, end, L"true", 4))
+            return nullptr;
+        p += 4;
+        value.m_type = JsonType::Bool;
+        break;
+    case L'f':
+        if (!MatchLiteral(p, end, L"false", 5))
+            return nullptr;
+        p += 5;
+        value.m_type = JsonType::Bool;
+        break;
+    case L'n':
+        if (!MatchLiteral(p, end, L"null", 4))
+            return nullptr;
+        p += 4;
+        value.m_type = JsonType::Null;
+        break;
+    default:
+        while (p < end && (iswdigit(*p) || *p == L'-' || *p == L'+' || *p == L'.' || *p == L'e' || *p == L'E'))
+            ++p;
+        if (p == begin)
+            return nullptr;
+        value.m_type = JsonType::Number;
+        break;
+    }
+
+    value.m_begin = begin;
+    value.m_end = p;
+    return p;
+}
+
+bool JsonReader::ReadMessage(wchar_t* json, int& message, JsonValue& args)
+{
+    wchar_t* end = json + wcslen(json);
+    JsonValue root;
+    if (ScanValue(SkipWhitespace(json, end), end, root) == nullptr)
+        return false;
+
+    JsonObjectReader reader(root);
+    std::wstring_view key;
+    JsonValue value;
+    bool hasMessage = false;
+    bool hasArgs = false;
+    while (reader.Next(key, value))
+    {
+        if (key == L"message")
+        {
+            hasMessage = value.GetInt(message);
+        }
+        else if (key == L"args")
+        {
+            args = value;
+            hasArgs = value.GetType() == JsonType::Object;
+        }
+    }
+
+    return hasMessage && hasArgs && !reader.HasError();
+}
+
+bool JsonReader::ReadValue(wchar_t* json, JsonValue& value)
+{
+    wchar_t* end = json + wcslen(json);
+    wchar_t* p = ScanValue(SkipWhitespace(json, end), end, value);
+    return p != nullptr && SkipWhitespace(p, end) == end;
+}
+
+// Scanned like ScanString, without a copy to scan
+bool JsonReader::IsString(std::wstring_view text)
+{
+    if (text.size() < 2 || text.front() != L'"')
+        return false;
+    for (size_t i = 1; i < text.size(); ++i)
+    {
+        if (text[i] == L'\\')
+            ++i;
+        else if (text[i] == L'"')
+            return i == text.size() - 1;
+    }
+    return false;
+}
+
+namespace
+{
+    bool DecodeField(const FieldLayout& field, JsonValue& value, void* out)
+    {
+        char* target = static_cast<char*>(out) + field.offset;
+        switch (field.type)
+        {
+        case FieldType::String:
+            if (out == nullptr)
+                return value.GetType() == JsonType::String;
+            return value.GetString(*reinterpret_cast<std::wstring_view*>(target));
+        case FieldType::Size:
+        {
+            size_t size;
+            if (!value.GetSize(size))
+                return false;
+            if (out != nullptr)
+                *reinterpret_cast<size_t*>(target) = size;
+            return true;
+        }
+        case FieldType::Int:
+        {
+            double number;
+            long long integer;
+            if (!value.GetNumber(number) || !ToInteger(number, integer))
+                return false;
+            if (out != nullptr)
+                *reinterpret_cast<long long*>(target) = integer;
+            return true;
+        }
+        case FieldType::Bool:
+        {
+            bool flag;
+            if (!value.GetBool(flag))
+                return false;
+            if (out != nullptr)
+                *reinterpret_cast<bool*>(target) = flag;
+            return true;
+        }
+        case FieldType::Json:
+            if (out != nullptr)
+                *reinterpret_cast<JsonValue*>(target) = value;
+            return true;
+        case FieldType::Raw:
+            if (out != nullptr)
+                *reinterpret_cast<std::wstring_view*>(target) = value.GetRaw();
+            return true;
+        case FieldType::OptionalSize:
+        {
+            size_t size;
+            if (!value.GetSize(size))
+                return false;
+            if (out != nullptr)
+                *reinterpret_cast<std::optional<size_t>*>(target) = size;
+            return true;
+        }
+        case FieldType::OptionalInt:
+        {
+            double number;
+            long long integer;
+            if (!value.GetNumber(number) || !ToInteger(number, integer))
+                return false;
+            if (out != nullptr)
+                *reinterpret_cast<std::optional<long long>*>(target) = integer;
+            return true;
+        }
+        case FieldType::OptionalBool:
+        {
+            bool flag;
+            if (!value.GetBool(flag))
+                return false;
+            if (out != nullptr)
+                *reinterpret_cast<std::optional<bool>*>(target) = flag;
+            return true;
+        }
+        }
+        return false;
+    }
+}
+
+bool DecodeFields(JsonValue& args, const MessageLayout& layout, void* out)
+{
+    if (args.GetType() != JsonType::Object)
+        return false;
+
+    JsonObjectReader reader(args);
+    std::wstring_view key;
+    JsonValue value;
+    uint32_t present = 0;
+    while (reader.Next(key, value))
+    {
+        // A null member counts as absent
+        if (value.GetType() == JsonType::Null)
+            continue;
+
+        uint32_t hash = HashFieldName(key);
+        for (size_t i = 0; i < layout.fieldCount; ++i)
+        {
+            const FieldLayout& field = layout.fields[i];
+            if (field.nameHash != hash || field.name != key)
+                continue;
+
+            if (!DecodeField(field, value, out))
+                return false;
+            present |= 1u << i;
+            break;
+        }
+        // Unknown keys are ignored, pages may send more than the host reads
+    }
+
+    return !reader.HasError() && (present & layout.requiredFields) == layout.requiredFields;
+}
+
+void JsonWriter::BeginMessage(int message)
+{
+    // clear() keeps the capacity, so steady state encoding doesn't allocate
+    m_message = message;
+    m_buffer.clear();
+    m_buffer.append(L"{\"message\":");
+    AppendNumber(message);
+    m_buffer.append(L",\"args\":{");
+    m_needsComma = false;
+}
+
+void JsonWriter::EndMessage()
+{
+    m_buffer.append(L"}}");
+}
+
+void JsonWriter::WriteNumber(std::wstring_view key, long long value)
+{
+    WriteKey(key);
+    AppendNumber(value);
+}
+
+void JsonWriter::WriteBool(std::wstring_view key, bool value)
+{
+    WriteKey(key);
+    m_buffer.append(value ? L"true" : L"false");
+}
+
+void JsonWriter::WriteString(std::wstring_view key, std::wstring_view value)
+{
+    WriteKey(key);
+    m_buffer.push_back(L'"');
+    AppendEscaped(value);
+    m_buffer.push_back(L'"');
+}
+
+void JsonWriter::WriteRaw(std::wstring_view key, std::wstring_view value)
+{
+    WriteKey(key);
+    m_buffer.append(value);
+}
+
+void JsonWriter::WriteMembers(const JsonValue& object, std::wstring_view skipKey)
+{
+    JsonObjectReader reader(object);
+    std::wstring_view key;
+    JsonValue value;
+    while (reader.Next(key, value))
+    {
+        if (key != skipKey)
+            WriteRaw(key, value.GetRaw());
+    }
+}
+
+void JsonWriter::BeginArray(std::wstring_view key)
+{
+    WriteKey(key);
+    m_buffer.push_back(L'[');
+    m_needsComma = false;
+}
+
+void JsonWriter::EndArray()
+{
+    m_buffer.push_back(L']');
+    m_needsComma = true;
+}
+
+void JsonWriter::BeginObject()
+{
+    if (m_needsComma)
+        m_buffer.push_back(L',');
+    m_buffer.push_back(L'{');
+    m_needsComma = false;
+}
+
+void JsonWriter::EndObject()
+{
+    m_buffer.push_back(L'}');
+    m_needsComma = true;
+}
+
+void JsonWriter::WriteKey(std::wstring_view key)
+{
+    if (m_needsComma)
+        m_buffer.push_back(L',');
+    m_needsComma = true;
+
+    m_buffer.push_back(L'"');
+    m_buffer.append(key);
+    m_buffer.append(L"\":");
+}
+
+void JsonWriter::AppendNumber(long long value)
+{
+    wchar_t digits[24];
+    wchar_t* end = digits + sizeof(digits) / sizeof(digits[0]);
+    wchar_t* p = end;
+    unsigned long long magnitude = value < 0 ? 0ull - static_cast<unsigned long long>(value) : value;
+    do
+    {
+        *--p = static_cast<wchar_t>(L'0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0)
+        *--p = L'-';
+
+    m_buffer.append(p, end - p);
+}
+
+void JsonWriter::AppendEscaped(std::wstring_view value)
+{
+    static const wchar_t hex[] = L"0123456789abcdef";
+
+    size_t runStart = 0;
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        wchar_t c = value[i];
+        if (c != L'"' && c != L'\\' && c >= 0x20)
+            continue;
+
+        m_buffer.append(value.data() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c)
+        {
+        case L'"': m_buffer.append(L"\\\""); break;
+        case L'\\': m_buffer.append(L"\\\\"); break;
+        case L'\n': m_buffer.append(L"\\n"); break;
+        case L'\r': m_buffer.append(L"\\r"); break;
+        case L'\t': m_buffer.append(L"\\t"); break;
+        default:
+            m_buffer.append(L"\\u00");
+            m_buffer.push_back(hex[(c >> 4) & 0xF]);
+            m_buffer.push_back(hex[c & 0xF]);
+            break;
+        }
+    }
+    m_buffer.append(value.data() + runStart, value.size() - runStart);
+}
+
+void TabRequestMessage::Encode(JsonWriter& writer) const
+{
+    writer.BeginMessage(message);
+    writer.WriteMembers(args, FieldName<&TabArgs::tabId>::value);
+    writer.WriteNumber(FieldName<&TabArgs::tabId>::value, tabId);
+    writer.EndMessage();
+}
+
+bool TabReplyMessage::Decode(int messageId, JsonValue& messageArgs)
+{
+    message = messageId;
+    args = messageArgs;
+
+    TabArgs tab;
+    if (!DecodeArgs(args, tab))
+        return false;
+    tabId = tab.tabId;
+    return true;
+}
+
+void TabReplyMessage::Encode(JsonWriter& writer) const
+{
+    writer.BeginMessage(message);
+    writer.WriteMembers(args, FieldName<&TabArgs::tabId>::value);
+    writer.EndMessage();
+}
@@ -0,0 +1,297 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "messages.h"
+
+// Typed codec for the messages exchanged with the browser UI. Messages are
+// decoded in place from the buffer returned by get_WebMessageAsJson, so no
+// intermediate document is built, and encoded into a reusable UTF-16 buffer.
+// Nothing in here depends on Windows headers.
+
+enum class JsonType
+{
+    Invalid,
+    Null,
+    Bool,
+    Number,
+    String,
+    Object,
+    Array
+};
+
+// A span of JSON text inside a message buffer. Strings are unescaped in place
+// on first access; after that GetRaw no longer returns the original text.
+class JsonValue
+{
+public:
+    JsonType GetType() const { return m_type; }
+    bool GetBool(bool& value) const;
+    bool GetNumber(double& value) const;
+    bool GetInt(int& value) const;
+    bool GetSize(size_t& value) const;
+    // The returned view is null-terminated and points into the message buffer
+    bool GetString(std::wstring_view& value);
+    std::wstring_view GetRaw() const { return std::wstring_view(m_begin, m_end - m_begin); }
+
+private:
+    friend class JsonReader;
+    friend class JsonObjectReader;
+
+    JsonType m_type = JsonType::Invalid;
+    wchar_t* m_begin = nullptr;
+    wchar_t* m_end = nullptr;
+    size_t m_decodedLength = 0;
+    bool m_decoded = false;
+};
+
+// Walks the members of a JSON object without allocating. Keys are returned
+// as raw (still escaped) text, which is fine for the plain ASCII keys used by
+// the browser messages.
+class JsonObjectReader
+{
+public:
+    explicit JsonObjectReader(const JsonValue& object);
+    bool Next(std::wstring_view& key, JsonValue& value);
+    bool HasError() const { return m_error; }
+
+private:
+    wchar_t* m_current = nullptr;
+    wchar_t* m_end = nullptr;
+    bool m_first = true;
+    bool m_error = false;
+};
+
+class JsonReader
+{
+public:
+    // Scans a single JSON value starting at begin. Returns the position right
+    // after the value, or nullptr if the text is malformed.
+    static wchar_t* ScanValue(wchar_t* begin, wchar_t* end, JsonValue& value);
+
+    // Splits a {"message": <int>, "args": {...}} envelope
+    static bool ReadMessage(wchar_t* json, int& message, JsonValue& args);
+
+    // Reads a document that is a single value, such as a DevTools event
+    static bool ReadValue(wchar_t* json, JsonValue& value);
+
+    // Whether the text is a single JSON string and nothing else, as raw
+    // fields read back from a file must be before they're written out
+    static bool IsString(std::wstring_view text);
+};
+
+// Args structs and their field layouts are generated from messages.json into
+// MessageSchema.h. Decoding walks the args object once and matches each key
+// against the layout by hash, then writes the value at the field's offset.
+enum class FieldType : uint8_t
+{
+    String,       // std::wstring_view, unescaped in place
+    Size,         // size_t
+    Int,          // long long
+    Bool,
+    Json,         // JsonValue, copied verbatim
+    Raw,          // std::wstring_view of the JSON text, written back verbatim
+    OptionalSize, // std::optional<size_t>
+    OptionalInt,  // std::optional<long long>
+    OptionalBool  // std::optional<bool>
+};
+
+struct FieldLayout
+{
+    std::wstring_view name;
+    uint32_t nameHash;
+    FieldType type;
+    size_t offset;
+};
+
+struct MessageLayout
+{
+    const FieldLayout* fields;
+    size_t fieldCount;
+    uint32_t requiredFields; // Bit i set when fields[i] must be present
+};
+
+// FNV-1a over the UTF-16 code units of a key
+constexpr uint32_t HashFieldName(std::wstring_view name)
+{
+    uint32_t hash = 2166136261u;
+    for (wchar_t c : name)
+    {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+        hash = (hash ^ static_cast<uint8_t>(c >> 8)) * 16777619u;
+    }
+    return hash;
+}
+
+// Decodes args into the struct at out. With out == nullptr the args are only
+// validated, and strings are left escaped so they can still be relayed.
+bool DecodeFields(JsonValue& args, const MessageLayout& layout, void* out);
+
+// Specialized for every args struct in MessageSchema.h
+template <typename T>
+struct ArgsLayout;
+
+// The key of a field, FieldName<&TabArgs::tabId>::value. For callers that
+// write arrays of args structs element by element.
+template <auto member>
+struct FieldName;
+
+template <typename T>
+bool DecodeArgs(JsonValue& args, T& out)
+{
+    return DecodeFields(args, ArgsLayout<T>::Layout, &out);
+}
+
+// Appends a message to a buffer that keeps its capacity between messages
+class JsonWriter
+{
+public:
+    void BeginMessage(int message);
+    void EndMessage();
+
+    void WriteNumber(std::wstring_view key, long long value);
+    void WriteBool(std::wstring_view key, bool value);
+    void WriteString(std::wstring_view key, std::wstring_view value);
+    // value must already be valid JSON
+    void WriteRaw(std::wstring_view key, std::wstring_view value);
+    // Copies every member of object except the one named skipKey
+    void WriteMembers(const JsonValue& object, std::wstring_view skipKey = {});
+
+    // Arrays of objects inside the args
+    void BeginArray(std::wstring_view key);
+    void EndArray();
+    void BeginObject();
+    void EndObject();
+
+    int GetMessageId() const { return m_message; }
+    const wchar_t* GetString() const { return m_buffer.c_str(); }
+    size_t GetLength() const { return m_buffer.size(); }
+
+private:
+    void WriteKey(std::wstring_view key);
+    void AppendNumber(long long value);
+    void AppendEscaped(std::wstring_view value);
+
+    std::wstring m_buffer;
+    int m_message = 0;
+    bool m_needsComma = false;
+};
+
+// Every message is its args struct plus the message id. EncodeFields for
+// each args struct is generated into MessageSchema.h along with the aliases,
+// such as UpdateUriMessage for Message<MG_UPDATE_URI>.
+template <int id>
+struct MessageArgs;
+
+template <int id>
+struct Message : MessageArgs<id>::Type
+{
+    using Args = typename MessageArgs<id>::Type;
+    static constexpr int Id = id;
+
+    void Encode(JsonWriter& writer) const
+    {
+        writer.BeginMessage(Id);
+        EncodeFields(writer, static_cast<const Args&>(*this));
+        writer.EndMessage();
+    }
+};
+
+// Handed to handlers that forward the args as they are. They are checked
+// against the schema, but strings are left escaped.
+template <int id>
+struct RelayedMessage
+{
+    static constexpr int Id = id;
+    JsonValue args;
+};
+
+enum class DispatchResult
+{
+    Handled,
+    Unhandled, // No OnMessage overload for the message
+    Malformed  // The args don't match the schema
+};
+
+template <typename Handler, typename T, typename = void>
+struct HandlesMessage : std::false_type
+{
+};
+
+template <typename Handler, typename T>
+struct HandlesMessage<Handler, T, std::void_t<decltype(std::declval<Handler&>().OnMessage(std::declval<const T&>()))>>
+    : std::true_type
+{
+};
+
+// Entries of the MessageDispatcher table generated into MessageSchema.h. A
+// handler takes a message by declaring OnMessage(const Message<id>&) to get
+// it decoded, or OnMessage(const RelayedMessage<id>&) to forward it.
+template <typename Handler>
+struct MessageHandlerTable
+{
+    using Entry = DispatchResult (*)(Handler& handler, JsonValue& args);
+
+    template <int id>
+    static DispatchResult Decode(Handler& handler, JsonValue& args)
+    {
+        Message<id> message;
+        if (!DecodeArgs(args, static_cast<typename Message<id>::Args&>(message)))
+            return DispatchResult::Malformed;
+        handler.OnMessage(message);
+        return DispatchResult::Handled;
+    }
+
+    template <int id>
+    static DispatchResult Relay(Handler& handler, JsonValue& args)
+    {
+        if (!DecodeFields(args, ArgsLayout<typename MessageArgs<id>::Type>::Layout, nullptr))
+            return DispatchResult::Malformed;
+        RelayedMessage<id> message;
+        message.args = args;
+        handler.OnMessage(message);
+        return DispatchResult::Handled;
+    }
+
+    template <int id>
+    static constexpr Entry GetEntry()
+    {
+        if constexpr (HandlesMessage<Handler, Message<id>>::value)
+            return &Decode<id>;
+        else if constexpr (HandlesMessage<Handler, RelayedMessage<id>>::value)
+            return &Relay<id>;
+        else
+            return nullptr;
+    }
+};
+
+// Requests from browser pages for what the controls UI owns (MG_GET_SETTINGS,
+// MG_SET_TAB_POLICY) are relayed to the controls UI tagged with the
+// requesting tab, and the replies are relayed back without the tag. The
+// payloads are copied verbatim.
+struct TabRequestMessage
+{
+    int message = 0;
+    size_t tabId = INVALID_TAB_ID;
+    JsonValue args;
+
+    void Encode(JsonWriter& writer) const;
+};
+
+struct TabReplyMessage
+{
+    int message = 0;
+    size_t tabId = INVALID_TAB_ID;
+    JsonValue args;
+
+    bool Decode(int messageId, JsonValue& messageArgs);
+    void Encode(JsonWriter& writer) const;
+};
@@ -0,0 +1,161 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "MessageMetrics.h"
+#include "MessageSchema.h"
+
+namespace
+{
+    const wchar_t* const c_directionNames[] = { L"controls", L"tab", L"posted" };
+}
+
+void LatencyHistogram::Record(uint64_t value)
+{
+    ++m_buckets[GetBucket(value)];
+    ++m_count;
+    m_sum += value;
+    if (value > m_max)
+        m_max = value;
+}
+
+uint64_t LatencyHistogram::GetPercentile(double quantile) const
+{
+    if (m_count == 0)
+        return 0;
+
+    uint64_t target = static_cast<uint64_t>(quantile * (m_count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < c_bucketCount; ++i)
+    {
+        seen += m_buckets[i];
+        if (seen >= target)
+            return GetBucketValue(i) < m_max ? GetBucketValue(i) : m_max;
+    }
+    return m_max;
+}
+
+size_t LatencyHistogram::GetBucket(uint64_t value)
+{
+    constexpr uint64_t subBuckets = 1ull << c_subBucketBits;
+    if (value < subBuckets)
+        return static_cast<size_t>(value);
+
+    int exponent = 0;
+    for (uint64_t v = value; v > 1; v >>= 1)
+        ++exponent;
+    if (exponent >= c_maxValueBits)
+        return c_bucketCount - 1;
+
+    size_t subBucket = static_cast<size_t>((value >> (exponent - c_subBucketBits)) & (subBuckets - 1));
+    return ((exponent - c_subBucketBits + 1) << c_subBucketBits) + subBucket;
+}
+
+// Midpoint of the values that land in a bucket
+uint64_t LatencyHistogram::GetBucketValue(size_t bucket)
+{
+    constexpr size_t subBuckets = 1ull << c_subBucketBits;
+    if (bucket < subBuckets)
+        return bucket;
+
+    int exponent = static_cast<int>(bucket >> c_subBucketBits) + c_subBucketBits - 1;
+    uint64_t subBucket = bucket & (subBuckets - 1);
+    uint64_t width = 1ull << (exponent - c_subBucketBits);
+    return ((subBuckets + subBucket) << (exponent - c_subBucketBits)) + width / 2;
+}
+
+MessageMetrics::Scope::~Scope()
+{
+    if (m_dismissed)
+        return;
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start);
+    m_metrics.Record(m_direction, m_message, m_length, static_cast<uint64_t>(elapsed.count()));
+}
+
+MessageMetrics::MessageMetrics() :
+    m_start(Clock::now()),
+    m_counters((c_maxMessageId + 1) * static_cast<size_t>(MessageDirection::Count))
+{
+}
+
+MessageMetrics::MessageCounters& MessageMetrics::GetCounters(MessageDirection direction, int message)
+{
+    if (message < 0 || message > c_maxMessageId)
+        message = 0;
+    return m_counters[message * static_cast<size_t>(MessageDirection::Count) + static_cast<size_t>(direction)];
+}
+
+void MessageMetrics::Record(MessageDirection direction, int message, size_t length, uint64_t elapsedNs)
+{
+    MessageCounters& counters = GetCounters(direction, message);
+    counters.bytes += length * sizeof(wchar_t);
+    counters.latency.Record(elapsedNs);
+}
+
+void MessageMetrics::RecordTabMessage(size_t tabId, size_t length)
+{
+    TabCounters& counters = m_tabs[tabId];
+    ++counters.messages;
+    counters.bytes += length * sizeof(wchar_t);
+}
+
+void MessageMetrics::RecordTabUpdate(size_t tabId)
+{
+    ++m_tabs[tabId].updates;
+}
+
+void MessageMetrics::RemoveTab(size_t tabId)
+{
+    m_tabs.erase(tabId);
+}
+
+void MessageMetrics::Encode(JsonWriter& writer) const
+{
+    auto uptime = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - m_start);
+
+    MetricsArgs metrics;
+    metrics.uptime = uptime.count();
+    writer.BeginMessage(MG_GET_METRICS);
+    EncodeFields(writer, metrics);
+
+    writer.BeginArray(FieldName<&MetricsArgs::messages>::value);
+    for (size_t i = 0; i < m_counters.size(); ++i)
+    {
+        const MessageCounters& counters = m_counters[i];
+        const LatencyHistogram& latency = counters.latency;
+        if (latency.GetCount() == 0)
+            continue;
+
+        MessageMetricsArgs message;
+        message.message = static_cast<long long>(i / static_cast<size_t>(MessageDirection::Count));
+        message.direction = c_directionNames[i % static_cast<size_t>(MessageDirection::Count)];
+        message.count = static_cast<long long>(latency.GetCount());
+        message.bytes = static_cast<long long>(counters.bytes);
+        message.mean = static_cast<long long>(latency.GetMean());
+        message.p50 = static_cast<long long>(latency.GetPercentile(0.5));
+        message.p90 = static_cast<long long>(latency.GetPercentile(0.9));
+        message.p99 = static_cast<long long>(latency.GetPercentile(0.99));
+        message.max = static_cast<long long>(latency.GetMax());
+        writer.BeginObject();
+        EncodeFields(writer, message);
+        writer.EndObject();
+    }
+    writer.EndArray();
+
+    writer.BeginArray(FieldName<&MetricsArgs::tabs>::value);
+    for (const auto& [tabId, counters] : m_tabs)
+    {
+        TabMetricsArgs tab;
+        tab.tabId = tabId;
+        tab.messages = static_cast<long long>(counters.messages);
+        tab.bytes = static_cast<long long>(counters.bytes);
+        tab.updates = static_cast<long long>(counters.updates);
+        writer.BeginObject();
+        EncodeFields(writer, tab);
+        writer.EndObject();
+    }
+    writer.EndArray();
+
+    writer.EndMessage();
+}
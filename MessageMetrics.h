@@ -0,0 +1,114 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "MessageCodec.h"
+
+// Always-on counters and latency histograms for the messages crossing the
+// host bridge, keyed by message id and direction. Everything runs on the UI
+// thread, so recording is a few increments and no locking. Shown on
+// browser://metrics.
+
+enum class MessageDirection : uint8_t
+{
+    FromControls, // Handled by the controls and options UI broker
+    FromTab,      // Posted by a page in a tab
+    Posted,       // Posted by the host to any WebView
+    Count
+};
+
+// Log-linear buckets in the style of HdrHistogram: values are bucketed by
+// their highest set bit, and each power of two is split in 8 sub-buckets, so
+// every recorded value is within 12.5% of its bucket.
+class LatencyHistogram
+{
+public:
+    static constexpr int c_subBucketBits = 3;
+    static constexpr int c_maxValueBits = 40; // ~18 minutes in ns
+    static constexpr size_t c_bucketCount = (c_maxValueBits - c_subBucketBits + 1) << c_subBucketBits;
+
+    void Record(uint64_t value);
+    uint64_t GetCount() const { return m_count; }
+    uint64_t GetMax() const { return m_max; }
+    uint64_t GetMean() const { return m_count == 0 ? 0 : m_sum / m_count; }
+    // quantile is in [0, 1]
+    uint64_t GetPercentile(double quantile) const;
+
+private:
+    static size_t GetBucket(uint64_t value);
+    static uint64_t GetBucketValue(size_t bucket);
+
+    uint32_t m_buckets[c_bucketCount] = {};
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint64_t m_max = 0;
+};
+
+class MessageMetrics
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Times a handler from construction to destruction. The message id is
+    // usually only known after parsing, set it when it is.
+    class Scope
+    {
+    public:
+        Scope(MessageMetrics& metrics, MessageDirection direction) :
+            m_metrics(metrics), m_direction(direction), m_start(Clock::now()) {}
+        ~Scope();
+
+        void SetMessage(int message, size_t length)
+        {
+            m_message = message;
+            m_length = length;
+        }
+        // Records nothing, for messages that destroy the metrics
+        void Dismiss() { m_dismissed = true; }
+
+    private:
+        MessageMetrics& m_metrics;
+        MessageDirection m_direction;
+        Clock::time_point m_start;
+        int m_message = 0;
+        size_t m_length = 0;
+        bool m_dismissed = false;
+    };
+
+    MessageMetrics();
+
+    // Unknown ids are counted under id 0
+    void Record(MessageDirection direction, int message, size_t length, uint64_t elapsedNs);
+    void RecordTabMessage(size_t tabId, size_t length);
+    void RecordTabUpdate(size_t tabId);
+    void RemoveTab(size_t tabId);
+
+    // Encodes the MG_GET_METRICS reply
+    void Encode(JsonWriter& writer) const;
+
+private:
+    struct MessageCounters
+    {
+        uint64_t bytes = 0;
+        LatencyHistogram latency;
+    };
+
+    struct TabCounters
+    {
+        uint64_t messages = 0;
+        uint64_t bytes = 0;
+        uint64_t updates = 0;
+    };
+
+    MessageCounters& GetCounters(MessageDirection direction, int message);
+
+    Clock::time_point m_start;
+    std::vector<MessageCounters> m_counters; // [message][direction]
+    std::unordered_map<size_t, TabCounters> m_tabs;
+};
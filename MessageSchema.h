@@ -0,0 +1,1562 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Generated from messages.json by tools/generate_messages.py. Do not edit.
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include "MessageCodec.h"
+
+struct EmptyArgs
+{
+};
+
+template <>
+struct ArgsLayout<EmptyArgs>
+{
+    static constexpr MessageLayout Layout = { nullptr, 0, 0 };
+};
+
+inline void EncodeFields(JsonWriter&, const EmptyArgs&)
+{
+}
+
+struct TabArgs
+{
+    size_t tabId = INVALID_TAB_ID;
+};
+
+template <>
+struct ArgsLayout<TabArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"tabId", HashFieldName(L"tabId"), FieldType::Size, offsetof(TabArgs, tabId) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 1, 0x1u };
+};
+
+template <> struct FieldName<&TabArgs::tabId> { static constexpr std::wstring_view value = L"tabId"; };
+
+inline void EncodeFields(JsonWriter& writer, const TabArgs& args)
+{
+    writer.WriteNumber(L"tabId", args.tabId);
+}
+
+struct NavigateArgs
+{
+    std::wstring_view uri = L"";
+    std::wstring_view encodedSearchURI = L"";
+};
+
+template <>
+struct ArgsLayout<NavigateArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"uri", HashFieldName(L"uri"), FieldType::String, offsetof(NavigateArgs, uri) },
+        { L"encodedSearchURI", HashFieldName(L"encodedSearchURI"), FieldType::String, offsetof(NavigateArgs, encodedSearchURI) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 2, 0x1u };
+};
+
+template <> struct FieldName<&NavigateArgs::uri> { static constexpr std::wstring_view value = L"uri"; };
+template <> struct FieldName<&NavigateArgs::encodedSearchURI> { static constexpr std::wstring_view value = L"encodedSearchURI"; };
+
+inline void EncodeFields(JsonWriter& writer, const NavigateArgs& args)
+{
+    writer.WriteString(L"uri", args.uri);
+    if (!args.encodedSearchURI.empty())
+        writer.WriteString(L"encodedSearchURI", args.encodedSearchURI);
+}
+
+struct UpdateUriArgs
+{
+    size_t tabId = INVALID_TAB_ID;
+    std::wstring_view uri = L"";
+    std::wstring_view uriToShow = L"";
+    std::optional<bool> canGoForward;
+    std::optional<bool> canGoBack;
+    std::optional<bool> isFavorite;
+};
+
+template <>
+struct ArgsLayout<UpdateUriArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"tabId", HashFieldName(L"tabId"), FieldType::Size, offsetof(UpdateUriArgs, tabId) },
+        { L"uri", HashFieldName(L"uri"), FieldType::String, offsetof(UpdateUriArgs, uri) },
+        { L"uriToShow", HashFieldName(L"uriToShow"), FieldType::String, offsetof(UpdateUriArgs, uriToShow) },
+        { L"canGoForward", HashFieldName(L"canGoForward"), FieldType::OptionalBool, offsetof(UpdateUriArgs, canGoForward) },
+        { L"canGoBack", HashFieldName(L"canGoBack"), FieldType::OptionalBool, offsetof(UpdateUriArgs, canGoBack) },
+        { L"isFavorite", HashFieldName(L"isFavorite"), FieldType::OptionalBool, offsetof(UpdateUriArgs, isFavorite) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 6, 0x3u };
+};
+
+template <> struct FieldName<&UpdateUriArgs::tabId> { static constexpr std::wstring_view value = L"tabId"; };
+template <> struct FieldName<&UpdateUriArgs::uri> { static constexpr std::wstring_view value = L"uri"; };
+template <> struct FieldName<&UpdateUriArgs::uriToShow> { static constexpr std::wstring_view value = L"uriToShow"; };
+template <> struct FieldName<&UpdateUriArgs::canGoForward> { static constexpr std::wstring_view value = L"canGoForward"; };
+template <> struct FieldName<&UpdateUriArgs::canGoBack> { static constexpr std::wstring_view value = L"canGoBack"; };
+template <> struct FieldName<&UpdateUriArgs::isFavorite> { static constexpr std::wstring_view value = L"isFavorite"; };
+
+inline void EncodeFields(JsonWriter& writer, const UpdateUriArgs& args)
+{
+    writer.WriteNumber(L"tabId", args.tabId);
+    writer.WriteString(L"uri", args.uri);
+    if (!args.uriToShow.empty())
+        writer.WriteString(L"uriToShow", args.uriToShow);
+    if (args.canGoForward)
+        writer.WriteBool(L"canGoForward", *args.canGoForward);
+    if (args.canGoBack)
+        writer.WriteBool(L"canGoBack", *args.canGoBack);
+    if (args.isFavorite)
+        writer.WriteBool(L"isFavorite", *args.isFavorite);
+}
+
+struct NavCompletedArgs
+{
+    size_t tabId = INVALID_TAB_ID;
+    std::optional<bool> isError;
+};
+
+template <>
+struct ArgsLayout<NavCompletedArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"tabId", HashFieldName(L"tabId"), FieldType::Size, offsetof(NavCompletedArgs, tabId) },
+        { L"isError", HashFieldName(L"isError"), FieldType::OptionalBool, offsetof(NavCompletedArgs, isError) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 2, 0x1u };
+};
+
+template <> struct FieldName<&NavCompletedArgs::tabId> { static constexpr std::wstring_view value = L"tabId"; };
+template <> struct FieldName<&NavCompletedArgs::isError> { static constexpr std::wstring_view value = L"isError"; };
+
+inline void EncodeFields(JsonWriter& writer, const NavCompletedArgs& args)
+{
+    writer.WriteNumber(L"tabId", args.tabId);
+    if (args.isError)
+        writer.WriteBool(L"isError", *args.isError);
+}
+
+struct CreateTabArgs
+{
+    size_t tabId = INVALID_TAB_ID;
+    bool active = false;
+};
+
+template <>
+struct ArgsLayout<CreateTabArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"tabId", HashFieldName(L"tabId"), FieldType::Size, offsetof(CreateTabArgs, tabId) },
+        { L"active", HashFieldName(L"active"), FieldType::Bool, offsetof(CreateTabArgs, active) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 2, 0x3u };
+};
+
+template <> struct FieldName<&CreateTabArgs::tabId> { static constexpr std::wstring_view value = L"tabId"; };
+template <> struct FieldName<&CreateTabArgs::active> { static constexpr std::wstring_view value = L"active"; };
+
+inline void EncodeFields(JsonWriter& writer, const CreateTabArgs& args)
+{
+    writer.WriteNumber(L"tabId", args.tabId);
+    writer.WriteBool(L"active", args.active);
+}
+
+struct UpdateTabArgs
+{
+    size_t tabId = INVALID_TAB_ID;
+    std::wstring_view title = L"";
+};
+
+template <>
+struct ArgsLayout<UpdateTabArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"tabId", HashFieldName(L"tabId"), FieldType::Size, offsetof(UpdateTabArgs, tabId) },
+        { L"title", HashFieldName(L"title"), FieldType::Raw, offsetof(UpdateTabArgs, title) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 2, 0x3u };
+};
+
+template <> struct FieldName<&UpdateTabArgs::tabId> { static constexpr std::wstring_view value = L"tabId"; };
+template <> struct FieldName<&UpdateTabArgs::title> { static constexpr std::wstring_view value = L"title"; };
+
+inline void EncodeFields(JsonWriter& writer, const UpdateTabArgs& args)
+{
+    writer.WriteNumber(L"tabId", args.tabId);
+    writer.WriteRaw(L"title", args.title);
+}
+
+struct SecurityUpdateArgs
+{
+    size_t tabId = INVALID_TAB_ID;
+    std::wstring_view state = L"";
+};
+
+template <>
+struct ArgsLayout<SecurityUpdateArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"tabId", HashFieldName(L"tabId"), FieldType::Size, offsetof(SecurityUpdateArgs, tabId) },
+        { L"state", HashFieldName(L"state"), FieldType::String, offsetof(SecurityUpdateArgs, state) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 2, 0x3u };
+};
+
+template <> struct FieldName<&SecurityUpdateArgs::tabId> { static constexpr std::wstring_view value = L"tabId"; };
+template <> struct FieldName<&SecurityUpdateArgs::state> { static constexpr std::wstring_view value = L"state"; };
+
+inline void EncodeFields(JsonWriter& writer, const SecurityUpdateArgs& args)
+{
+    writer.WriteNumber(L"tabId", args.tabId);
+    writer.WriteString(L"state", args.state);
+}
+
+struct UpdateFaviconArgs
+{
+    size_t tabId = INVALID_TAB_ID;
+    std::wstring_view uri = L"";
+};
+
+template <>
+struct ArgsLayout<UpdateFaviconArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"tabId", HashFieldName(L"tabId"), FieldType::Size, offsetof(UpdateFaviconArgs, tabId) },
+        { L"uri", HashFieldName(L"uri"), FieldType::Raw, offsetof(UpdateFaviconArgs, uri) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 2, 0x3u };
+};
+
+template <> struct FieldName<&UpdateFaviconArgs::tabId> { static constexpr std::wstring_view value = L"tabId"; };
+template <> struct FieldName<&UpdateFaviconArgs::uri> { static constexpr std::wstring_view value = L"uri"; };
+
+inline void EncodeFields(JsonWriter& writer, const UpdateFaviconArgs& args)
+{
+    writer.WriteNumber(L"tabId", args.tabId);
+    writer.WriteRaw(L"uri", args.uri);
+}
+
+struct SettingsArgs
+{
+    std::optional<size_t> tabId;
+    JsonValue settings;
+};
+
+template <>
+struct ArgsLayout<SettingsArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"tabId", HashFieldName(L"tabId"), FieldType::OptionalSize, offsetof(SettingsArgs, tabId) },
+        { L"settings", HashFieldName(L"settings"), FieldType::Json, offsetof(SettingsArgs, settings) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 2, 0x0u };
+};
+
+template <> struct FieldName<&SettingsArgs::tabId> { static constexpr std::wstring_view value = L"tabId"; };
+template <> struct FieldName<&SettingsArgs::settings> { static constexpr std::wstring_view value = L"settings"; };
+
+inline void EncodeFields(JsonWriter& writer, const SettingsArgs& args)
+{
+    if (args.tabId)
+        writer.WriteNumber(L"tabId", *args.tabId);
+    if (args.settings.GetType() != JsonType::Invalid)
+        writer.WriteRaw(L"settings", args.settings.GetRaw());
+}
+
+struct FavoritesArgs
+{
+    JsonValue items; // Array of FavoriteArgs
+};
+
+template <>
+struct ArgsLayout<FavoritesArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"items", HashFieldName(L"items"), FieldType::Json, offsetof(FavoritesArgs, items) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 1, 0x0u };
+};
+
+template <> struct FieldName<&FavoritesArgs::items> { static constexpr std::wstring_view value = L"items"; };
+
+inline void EncodeFields(JsonWriter& writer, const FavoritesArgs& args)
+{
+    if (args.items.GetType() != JsonType::Invalid)
+        writer.WriteRaw(L"items", args.items.GetRaw());
+}
+
+struct FavoriteArgs
+{
+    std::wstring_view uri = L"";
+    std::wstring_view uriToShow = L"";
+    std::wstring_view title = L"";
+    std::wstring_view favicon = L"";
+};
+
+template <>
+struct ArgsLayout<FavoriteArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"uri", HashFieldName(L"uri"), FieldType::String, offsetof(FavoriteArgs, uri) },
+        { L"uriToShow", HashFieldName(L"uriToShow"), FieldType::String, offsetof(FavoriteArgs, uriToShow) },
+        { L"title", HashFieldName(L"title"), FieldType::Raw, offsetof(FavoriteArgs, title) },
+        { L"favicon", HashFieldName(L"favicon"), FieldType::Raw, offsetof(FavoriteArgs, favicon) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 4, 0x1u };
+};
+
+template <> struct FieldName<&FavoriteArgs::uri> { static constexpr std::wstring_view value = L"uri"; };
+template <> struct FieldName<&FavoriteArgs::uriToShow> { static constexpr std::wstring_view value = L"uriToShow"; };
+template <> struct FieldName<&FavoriteArgs::title> { static constexpr std::wstring_view value = L"title"; };
+template <> struct FieldName<&FavoriteArgs::favicon> { static constexpr std::wstring_view value = L"favicon"; };
+
+inline void EncodeFields(JsonWriter& writer, const FavoriteArgs& args)
+{
+    writer.WriteString(L"uri", args.uri);
+    if (!args.uriToShow.empty())
+        writer.WriteString(L"uriToShow", args.uriToShow);
+    if (!args.title.empty())
+        writer.WriteRaw(L"title", args.title);
+    if (!args.favicon.empty())
+        writer.WriteRaw(L"favicon", args.favicon);
+}
+
+struct AddFavoriteArgs
+{
+    std::wstring_view uri = L"";
+    JsonValue title;
+    JsonValue favicon;
+};
+
+template <>
+struct ArgsLayout<AddFavoriteArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"uri", HashFieldName(L"uri"), FieldType::String, offsetof(AddFavoriteArgs, uri) },
+        { L"title", HashFieldName(L"title"), FieldType::Json, offsetof(AddFavoriteArgs, title) },
+        { L"favicon", HashFieldName(L"favicon"), FieldType::Json, offsetof(AddFavoriteArgs, favicon) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 3, 0x1u };
+};
+
+template <> struct FieldName<&AddFavoriteArgs::uri> { static constexpr std::wstring_view value = L"uri"; };
+template <> struct FieldName<&AddFavoriteArgs::title> { static constexpr std::wstring_view value = L"title"; };
+template <> struct FieldName<&AddFavoriteArgs::favicon> { static constexpr std::wstring_view value = L"favicon"; };
+
+inline void EncodeFields(JsonWriter& writer, const AddFavoriteArgs& args)
+{
+    writer.WriteString(L"uri", args.uri);
+    if (args.title.GetType() != JsonType::Invalid)
+        writer.WriteRaw(L"title", args.title.GetRaw());
+    if (args.favicon.GetType() != JsonType::Invalid)
+        writer.WriteRaw(L"favicon", args.favicon.GetRaw());
+}
+
+struct MigrateFavoritesArgs
+{
+    long long count = 0;
+};
+
+template <>
+struct ArgsLayout<MigrateFavoritesArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"count", HashFieldName(L"count"), FieldType::Int, offsetof(MigrateFavoritesArgs, count) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 1, 0x1u };
+};
+
+template <> struct FieldName<&MigrateFavoritesArgs::count> { static constexpr std::wstring_view value = L"count"; };
+
+inline void EncodeFields(JsonWriter& writer, const MigrateFavoritesArgs& args)
+{
+    writer.WriteNumber(L"count", args.count);
+}
+
+struct RemoveFavoriteArgs
+{
+    std::wstring_view uri = L"";
+};
+
+template <>
+struct ArgsLayout<RemoveFavoriteArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"uri", HashFieldName(L"uri"), FieldType::String, offsetof(RemoveFavoriteArgs, uri) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 1, 0x1u };
+};
+
+template <> struct FieldName<&RemoveFavoriteArgs::uri> { static constexpr std::wstring_view value = L"uri"; };
+
+inline void EncodeFields(JsonWriter& writer, const RemoveFavoriteArgs& args)
+{
+    writer.WriteString(L"uri", args.uri);
+}
+
+struct ClearDataArgs
+{
+    std::optional<bool> content;
+    std::optional<bool> controls;
+};
+
+template <>
+struct ArgsLayout<ClearDataArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"content", HashFieldName(L"content"), FieldType::OptionalBool, offsetof(ClearDataArgs, content) },
+        { L"controls", HashFieldName(L"controls"), FieldType::OptionalBool, offsetof(ClearDataArgs, controls) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 2, 0x0u };
+};
+
+template <> struct FieldName<&ClearDataArgs::content> { static constexpr std::wstring_view value = L"content"; };
+template <> struct FieldName<&ClearDataArgs::controls> { static constexpr std::wstring_view value = L"controls"; };
+
+inline void EncodeFields(JsonWriter& writer, const ClearDataArgs& args)
+{
+    if (args.content)
+        writer.WriteBool(L"content", *args.content);
+    if (args.controls)
+        writer.WriteBool(L"controls", *args.controls);
+}
+
+struct HistoryArgs
+{
+    std::optional<long long> count;
+    std::wstring_view cursor = L"";
+    std::wstring_view query = L"";
+    JsonValue items; // Array of HistoryItemArgs
+};
+
+template <>
+struct ArgsLayout<HistoryArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"count", HashFieldName(L"count"), FieldType::OptionalInt, offsetof(HistoryArgs, count) },
+        { L"cursor", HashFieldName(L"cursor"), FieldType::String, offsetof(HistoryArgs, cursor) },
+        { L"query", HashFieldName(L"query"), FieldType::String, offsetof(HistoryArgs, query) },
+        { L"items", HashFieldName(L"items"), FieldType::Json, offsetof(HistoryArgs, items) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 4, 0x0u };
+};
+
+template <> struct FieldName<&HistoryArgs::count> { static constexpr std::wstring_view value = L"count"; };
+template <> struct FieldName<&HistoryArgs::cursor> { static constexpr std::wstring_view value = L"cursor"; };
+template <> struct FieldName<&HistoryArgs::query> { static constexpr std::wstring_view value = L"query"; };
+template <> struct FieldName<&HistoryArgs::items> { static constexpr std::wstring_view value = L"items"; };
+
+inline void EncodeFields(JsonWriter& writer, const HistoryArgs& args)
+{
+    if (args.count)
+        writer.WriteNumber(L"count", *args.count);
+    if (!args.cursor.empty())
+        writer.WriteString(L"cursor", args.cursor);
+    if (!args.query.empty())
+        writer.WriteString(L"query", args.query);
+    if (args.items.GetType() != JsonType::Invalid)
+        writer.WriteRaw(L"items", args.items.GetRaw());
+}
+
+struct HistoryItemArgs
+{
+    long long id = 0;
+    std::wstring_view uri = L"";
+    std::wstring_view title = L"";
+    std::wstring_view favicon = L"";
+    long long timestamp = 0;
+};
+
+template <>
+struct ArgsLayout<HistoryItemArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"id", HashFieldName(L"id"), FieldType::Int, offsetof(HistoryItemArgs, id) },
+        { L"uri", HashFieldName(L"uri"), FieldType::String, offsetof(HistoryItemArgs, uri) },
+        { L"title", HashFieldName(L"title"), FieldType::Raw, offsetof(HistoryItemArgs, title) },
+        { L"favicon", HashFieldName(L"favicon"), FieldType::Raw, offsetof(HistoryItemArgs, favicon) },
+        { L"timestamp", HashFieldName(L"timestamp"), FieldType::Int, offsetof(HistoryItemArgs, timestamp) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 5, 0x13u };
+};
+
+template <> struct FieldName<&HistoryItemArgs::id> { static constexpr std::wstring_view value = L"id"; };
+template <> struct FieldName<&HistoryItemArgs::uri> { static constexpr std::wstring_view value = L"uri"; };
+template <> struct FieldName<&HistoryItemArgs::title> { static constexpr std::wstring_view value = L"title"; };
+template <> struct FieldName<&HistoryItemArgs::favicon> { static constexpr std::wstring_view value = L"favicon"; };
+template <> struct FieldName<&HistoryItemArgs::timestamp> { static constexpr std::wstring_view value = L"timestamp"; };
+
+inline void EncodeFields(JsonWriter& writer, const HistoryItemArgs& args)
+{
+    writer.WriteNumber(L"id", args.id);
+    writer.WriteString(L"uri", args.uri);
+    if (!args.title.empty())
+        writer.WriteRaw(L"title", args.title);
+    if (!args.favicon.empty())
+        writer.WriteRaw(L"favicon", args.favicon);
+    writer.WriteNumber(L"timestamp", args.timestamp);
+}
+
+struct SuggestionsArgs
+{
+    std::wstring_view query = L"";
+    long long requestId = 0;
+    JsonValue items; // Array of SuggestionArgs
+};
+
+template <>
+struct ArgsLayout<SuggestionsArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"query", HashFieldName(L"query"), FieldType::String, offsetof(SuggestionsArgs, query) },
+        { L"requestId", HashFieldName(L"requestId"), FieldType::Int, offsetof(SuggestionsArgs, requestId) },
+        { L"items", HashFieldName(L"items"), FieldType::Json, offsetof(SuggestionsArgs, items) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 3, 0x3u };
+};
+
+template <> struct FieldName<&SuggestionsArgs::query> { static constexpr std::wstring_view value = L"query"; };
+template <> struct FieldName<&SuggestionsArgs::requestId> { static constexpr std::wstring_view value = L"requestId"; };
+template <> struct FieldName<&SuggestionsArgs::items> { static constexpr std::wstring_view value = L"items"; };
+
+inline void EncodeFields(JsonWriter& writer, const SuggestionsArgs& args)
+{
+    writer.WriteString(L"query", args.query);
+    writer.WriteNumber(L"requestId", args.requestId);
+    if (args.items.GetType() != JsonType::Invalid)
+        writer.WriteRaw(L"items", args.items.GetRaw());
+}
+
+struct SuggestionArgs
+{
+    std::wstring_view uri = L"";
+    std::wstring_view title = L"";
+    std::optional<size_t> tabId;
+};
+
+template <>
+struct ArgsLayout<SuggestionArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"uri", HashFieldName(L"uri"), FieldType::String, offsetof(SuggestionArgs, uri) },
+        { L"title", HashFieldName(L"title"), FieldType::Raw, offsetof(SuggestionArgs, title) },
+        { L"tabId", HashFieldName(L"tabId"), FieldType::OptionalSize, offsetof(SuggestionArgs, tabId) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 3, 0x1u };
+};
+
+template <> struct FieldName<&SuggestionArgs::uri> { static constexpr std::wstring_view value = L"uri"; };
+template <> struct FieldName<&SuggestionArgs::title> { static constexpr std::wstring_view value = L"title"; };
+template <> struct FieldName<&SuggestionArgs::tabId> { static constexpr std::wstring_view value = L"tabId"; };
+
+inline void EncodeFields(JsonWriter& writer, const SuggestionArgs& args)
+{
+    writer.WriteString(L"uri", args.uri);
+    if (!args.title.empty())
+        writer.WriteRaw(L"title", args.title);
+    if (args.tabId)
+        writer.WriteNumber(L"tabId", *args.tabId);
+}
+
+struct RemoveHistoryItemArgs
+{
+    long long id = 0;
+};
+
+template <>
+struct ArgsLayout<RemoveHistoryItemArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"id", HashFieldName(L"id"), FieldType::Int, offsetof(RemoveHistoryItemArgs, id) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 1, 0x1u };
+};
+
+template <> struct FieldName<&RemoveHistoryItemArgs::id> { static constexpr std::wstring_view value = L"id"; };
+
+inline void EncodeFields(JsonWriter& writer, const RemoveHistoryItemArgs& args)
+{
+    writer.WriteNumber(L"id", args.id);
+}
+
+struct BatchArgs
+{
+    JsonValue updates; // Array of TabUpdateArgs
+};
+
+template <>
+struct ArgsLayout<BatchArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"updates", HashFieldName(L"updates"), FieldType::Json, offsetof(BatchArgs, updates) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 1, 0x1u };
+};
+
+template <> struct FieldName<&BatchArgs::updates> { static constexpr std::wstring_view value = L"updates"; };
+
+inline void EncodeFields(JsonWriter& writer, const BatchArgs& args)
+{
+    if (args.updates.GetType() != JsonType::Invalid)
+        writer.WriteRaw(L"updates", args.updates.GetRaw());
+}
+
+struct TabUpdateArgs
+{
+    size_t tabId = INVALID_TAB_ID;
+    std::wstring_view uri = L"";
+    std::wstring_view uriToShow = L"";
+    std::optional<bool> canGoForward;
+    std::optional<bool> canGoBack;
+    std::optional<bool> isFavorite;
+    std::optional<bool> isLoading;
+    std::optional<bool> isError;
+    std::wstring_view title = L"";
+    std::wstring_view favicon = L"";
+    std::wstring_view state = L"";
+    std::wstring_view lifecycle = L"";
+};
+
+template <>
+struct ArgsLayout<TabUpdateArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"tabId", HashFieldName(L"tabId"), FieldType::Size, offsetof(TabUpdateArgs, tabId) },
+        { L"uri", HashFieldName(L"uri"), FieldType::String, offsetof(TabUpdateArgs, uri) },
+        { L"uriToShow", HashFieldName(L"uriToShow"), FieldType::String, offsetof(TabUpdateArgs, uriToShow) },
+        { L"canGoForward", HashFieldName(L"canGoForward"), FieldType::OptionalBool, offsetof(TabUpdateArgs, canGoForward) },
+        { L"canGoBack", HashFieldName(L"canGoBack"), FieldType::OptionalBool, offsetof(TabUpdateArgs, canGoBack) },
+        { L"isFavorite", HashFieldName(L"isFavorite"), FieldType::OptionalBool, offsetof(TabUpdateArgs, isFavorite) },
+        { L"isLoading", HashFieldName(L"isLoading"), FieldType::OptionalBool, offsetof(TabUpdateArgs, isLoading) },
+        { L"isError", HashFieldName(L"isError"), FieldType::OptionalBool, offsetof(TabUpdateArgs, isError) },
+        { L"title", HashFieldName(L"title"), FieldType::Raw, offsetof(TabUpdateArgs, title) },
+        { L"favicon", HashFieldName(L"favicon"), FieldType::Raw, offsetof(TabUpdateArgs, favicon) },
+        { L"state", HashFieldName(L"state"), FieldType::String, offsetof(TabUpdateArgs, state) },
+        { L"lifecycle", HashFieldName(L"lifecycle"), FieldType::String, offsetof(TabUpdateArgs, lifecycle) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 12, 0x1u };
+};
+
+template <> struct FieldName<&TabUpdateArgs::tabId> { static constexpr std::wstring_view value = L"tabId"; };
+template <> struct FieldName<&TabUpdateArgs::uri> { static constexpr std::wstring_view value = L"uri"; };
+template <> struct FieldName<&TabUpdateArgs::uriToShow> { static constexpr std::wstring_view value = L"uriToShow"; };
+template <> struct FieldName<&TabUpdateArgs::canGoForward> { static constexpr std::wstring_view value = L"canGoForward"; };
+template <> struct FieldName<&TabUpdateArgs::canGoBack> { static constexpr std::wstring_view value = L"canGoBack"; };
+template <> struct FieldName<&TabUpdateArgs::isFavorite> { static constexpr std::wstring_view value = L"isFavorite"; };
+template <> struct FieldName<&TabUpdateArgs::isLoading> { static constexpr std::wstring_view value = L"isLoading"; };
+template <> struct FieldName<&TabUpdateArgs::isError> { static constexpr std::wstring_view value = L"isError"; };
+template <> struct FieldName<&TabUpdateArgs::title> { static constexpr std::wstring_view value = L"title"; };
+template <> struct FieldName<&TabUpdateArgs::favicon> { static constexpr std::wstring_view value = L"favicon"; };
+template <> struct FieldName<&TabUpdateArgs::state> { static constexpr std::wstring_view value = L"state"; };
+template <> struct FieldName<&TabUpdateArgs::lifecycle> { static constexpr std::wstring_view value = L"lifecycle"; };
+
+inline void EncodeFields(JsonWriter& writer, const TabUpdateArgs& args)
+{
+    writer.WriteNumber(L"tabId", args.tabId);
+    if (!args.uri.empty())
+        writer.WriteString(L"uri", args.uri);
+    if (!args.uriToShow.empty())
+        writer.WriteString(L"uriToShow", args.uriToShow);
+    if (args.canGoForward)
+        writer.WriteBool(L"canGoForward", *args.canGoForward);
+    if (args.canGoBack)
+        writer.WriteBool(L"canGoBack", *args.canGoBack);
+    if (args.isFavorite)
+        writer.WriteBool(L"isFavorite", *args.isFavorite);
+    if (args.isLoading)
+        writer.WriteBool(L"isLoading", *args.isLoading);
+    if (args.isError)
+        writer.WriteBool(L"isError", *args.isError);
+    if (!args.title.empty())
+        writer.WriteRaw(L"title", args.title);
+    if (!args.favicon.empty())
+        writer.WriteRaw(L"favicon", args.favicon);
+    if (!args.state.empty())
+        writer.WriteString(L"state", args.state);
+    if (!args.lifecycle.empty())
+        writer.WriteString(L"lifecycle", args.lifecycle);
+}
+
+struct CaptureArgs
+{
+    bool enabled = false;
+    std::optional<bool> succeeded;
+    std::wstring_view path = L"";
+};
+
+template <>
+struct ArgsLayout<CaptureArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"enabled", HashFieldName(L"enabled"), FieldType::Bool, offsetof(CaptureArgs, enabled) },
+        { L"succeeded", HashFieldName(L"succeeded"), FieldType::OptionalBool, offsetof(CaptureArgs, succeeded) },
+        { L"path", HashFieldName(L"path"), FieldType::String, offsetof(CaptureArgs, path) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 3, 0x1u };
+};
+
+template <> struct FieldName<&CaptureArgs::enabled> { static constexpr std::wstring_view value = L"enabled"; };
+template <> struct FieldName<&CaptureArgs::succeeded> { static constexpr std::wstring_view value = L"succeeded"; };
+template <> struct FieldName<&CaptureArgs::path> { static constexpr std::wstring_view value = L"path"; };
+
+inline void EncodeFields(JsonWriter& writer, const CaptureArgs& args)
+{
+    writer.WriteBool(L"enabled", args.enabled);
+    if (args.succeeded)
+        writer.WriteBool(L"succeeded", *args.succeeded);
+    if (!args.path.empty())
+        writer.WriteString(L"path", args.path);
+}
+
+struct DumpMetricsArgs
+{
+    std::optional<bool> succeeded;
+    std::wstring_view path = L"";
+};
+
+template <>
+struct ArgsLayout<DumpMetricsArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"succeeded", HashFieldName(L"succeeded"), FieldType::OptionalBool, offsetof(DumpMetricsArgs, succeeded) },
+        { L"path", HashFieldName(L"path"), FieldType::String, offsetof(DumpMetricsArgs, path) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 2, 0x0u };
+};
+
+template <> struct FieldName<&DumpMetricsArgs::succeeded> { static constexpr std::wstring_view value = L"succeeded"; };
+template <> struct FieldName<&DumpMetricsArgs::path> { static constexpr std::wstring_view value = L"path"; };
+
+inline void EncodeFields(JsonWriter& writer, const DumpMetricsArgs& args)
+{
+    if (args.succeeded)
+        writer.WriteBool(L"succeeded", *args.succeeded);
+    if (!args.path.empty())
+        writer.WriteString(L"path", args.path);
+}
+
+struct MetricsArgs
+{
+    std::optional<long long> uptime;
+    JsonValue messages; // Array of MessageMetricsArgs
+    JsonValue tabs; // Array of TabMetricsArgs
+};
+
+template <>
+struct ArgsLayout<MetricsArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"uptime", HashFieldName(L"uptime"), FieldType::OptionalInt, offsetof(MetricsArgs, uptime) },
+        { L"messages", HashFieldName(L"messages"), FieldType::Json, offsetof(MetricsArgs, messages) },
+        { L"tabs", HashFieldName(L"tabs"), FieldType::Json, offsetof(MetricsArgs, tabs) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 3, 0x0u };
+};
+
+template <> struct FieldName<&MetricsArgs::uptime> { static constexpr std::wstring_view value = L"uptime"; };
+template <> struct FieldName<&MetricsArgs::messages> { static constexpr std::wstring_view value = L"messages"; };
+template <> struct FieldName<&MetricsArgs::tabs> { static constexpr std::wstring_view value = L"tabs"; };
+
+inline void EncodeFields(JsonWriter& writer, const MetricsArgs& args)
+{
+    if (args.uptime)
+        writer.WriteNumber(L"uptime", *args.uptime);
+    if (args.messages.GetType() != JsonType::Invalid)
+        writer.WriteRaw(L"messages", args.messages.GetRaw());
+    if (args.tabs.GetType() != JsonType::Invalid)
+        writer.WriteRaw(L"tabs", args.tabs.GetRaw());
+}
+
+struct MessageMetricsArgs
+{
+    long long message = 0;
+    std::wstring_view direction = L"";
+    long long count = 0;
+    long long bytes = 0;
+    long long mean = 0;
+    long long p50 = 0;
+    long long p90 = 0;
+    long long p99 = 0;
+    long long max = 0;
+};
+
+template <>
+struct ArgsLayout<MessageMetricsArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"message", HashFieldName(L"message"), FieldType::Int, offsetof(MessageMetricsArgs, message) },
+        { L"direction", HashFieldName(L"direction"), FieldType::String, offsetof(MessageMetricsArgs, direction) },
+        { L"count", HashFieldName(L"count"), FieldType::Int, offsetof(MessageMetricsArgs, count) },
+        { L"bytes", HashFieldName(L"bytes"), FieldType::Int, offsetof(MessageMetricsArgs, bytes) },
+        { L"mean", HashFieldName(L"mean"), FieldType::Int, offsetof(MessageMetricsArgs, mean) },
+        { L"p50", HashFieldName(L"p50"), FieldType::Int, offsetof(MessageMetricsArgs, p50) },
+        { L"p90", HashFieldName(L"p90"), FieldType::Int, offsetof(MessageMetricsArgs, p90) },
+        { L"p99", HashFieldName(L"p99"), FieldType::Int, offsetof(MessageMetricsArgs, p99) },
+        { L"max", HashFieldName(L"max"), FieldType::Int, offsetof(MessageMetricsArgs, max) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 9, 0x1FFu };
+};
+
+template <> struct FieldName<&MessageMetricsArgs::message> { static constexpr std::wstring_view value = L"message"; };
+template <> struct FieldName<&MessageMetricsArgs::direction> { static constexpr std::wstring_view value = L"direction"; };
+template <> struct FieldName<&MessageMetricsArgs::count> { static constexpr std::wstring_view value = L"count"; };
+template <> struct FieldName<&MessageMetricsArgs::bytes> { static constexpr std::wstring_view value = L"bytes"; };
+template <> struct FieldName<&MessageMetricsArgs::mean> { static constexpr std::wstring_view value = L"mean"; };
+template <> struct FieldName<&MessageMetricsArgs::p50> { static constexpr std::wstring_view value = L"p50"; };
+template <> struct FieldName<&MessageMetricsArgs::p90> { static constexpr std::wstring_view value = L"p90"; };
+template <> struct FieldName<&MessageMetricsArgs::p99> { static constexpr std::wstring_view value = L"p99"; };
+template <> struct FieldName<&MessageMetricsArgs::max> { static constexpr std::wstring_view value = L"max"; };
+
+inline void EncodeFields(JsonWriter& writer, const MessageMetricsArgs& args)
+{
+    writer.WriteNumber(L"message", args.message);
+    writer.WriteString(L"direction", args.direction);
+    writer.WriteNumber(L"count", args.count);
+    writer.WriteNumber(L"bytes", args.bytes);
+    writer.WriteNumber(L"mean", args.mean);
+    writer.WriteNumber(L"p50", args.p50);
+    writer.WriteNumber(L"p90", args.p90);
+    writer.WriteNumber(L"p99", args.p99);
+    writer.WriteNumber(L"max", args.max);
+}
+
+struct TabMetricsArgs
+{
+    size_t tabId = INVALID_TAB_ID;
+    long long messages = 0;
+    long long bytes = 0;
+    long long updates = 0;
+};
+
+template <>
+struct ArgsLayout<TabMetricsArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"tabId", HashFieldName(L"tabId"), FieldType::Size, offsetof(TabMetricsArgs, tabId) },
+        { L"messages", HashFieldName(L"messages"), FieldType::Int, offsetof(TabMetricsArgs, messages) },
+        { L"bytes", HashFieldName(L"bytes"), FieldType::Int, offsetof(TabMetricsArgs, bytes) },
+        { L"updates", HashFieldName(L"updates"), FieldType::Int, offsetof(TabMetricsArgs, updates) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 4, 0xFu };
+};
+
+template <> struct FieldName<&TabMetricsArgs::tabId> { static constexpr std::wstring_view value = L"tabId"; };
+template <> struct FieldName<&TabMetricsArgs::messages> { static constexpr std::wstring_view value = L"messages"; };
+template <> struct FieldName<&TabMetricsArgs::bytes> { static constexpr std::wstring_view value = L"bytes"; };
+template <> struct FieldName<&TabMetricsArgs::updates> { static constexpr std::wstring_view value = L"updates"; };
+
+inline void EncodeFields(JsonWriter& writer, const TabMetricsArgs& args)
+{
+    writer.WriteNumber(L"tabId", args.tabId);
+    writer.WriteNumber(L"messages", args.messages);
+    writer.WriteNumber(L"bytes", args.bytes);
+    writer.WriteNumber(L"updates", args.updates);
+}
+
+struct TasksArgs
+{
+    JsonValue tasks; // Array of TaskArgs
+};
+
+template <>
+struct ArgsLayout<TasksArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"tasks", HashFieldName(L"tasks"), FieldType::Json, offsetof(TasksArgs, tasks) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 1, 0x0u };
+};
+
+template <> struct FieldName<&TasksArgs::tasks> { static constexpr std::wstring_view value = L"tasks"; };
+
+inline void EncodeFields(JsonWriter& writer, const TasksArgs& args)
+{
+    if (args.tasks.GetType() != JsonType::Invalid)
+        writer.WriteRaw(L"tasks", args.tasks.GetRaw());
+}
+
+struct TaskArgs
+{
+    size_t tabId = INVALID_TAB_ID;
+    std::wstring_view uri = L"";
+    std::wstring_view title = L"";
+    std::wstring_view lifecycle = L"";
+    long long processId = 0;
+    long long workingSet = 0;
+    long long cpu = 0;
+    long long navigations = 0;
+};
+
+template <>
+struct ArgsLayout<TaskArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"tabId", HashFieldName(L"tabId"), FieldType::Size, offsetof(TaskArgs, tabId) },
+        { L"uri", HashFieldName(L"uri"), FieldType::String, offsetof(TaskArgs, uri) },
+        { L"title", HashFieldName(L"title"), FieldType::Raw, offsetof(TaskArgs, title) },
+        { L"lifecycle", HashFieldName(L"lifecycle"), FieldType::String, offsetof(TaskArgs, lifecycle) },
+        { L"processId", HashFieldName(L"processId"), FieldType::Int, offsetof(TaskArgs, processId) },
+        { L"workingSet", HashFieldName(L"workingSet"), FieldType::Int, offsetof(TaskArgs, workingSet) },
+        { L"cpu", HashFieldName(L"cpu"), FieldType::Int, offsetof(TaskArgs, cpu) },
+        { L"navigations", HashFieldName(L"navigations"), FieldType::Int, offsetof(TaskArgs, navigations) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 8, 0xFBu };
+};
+
+template <> struct FieldName<&TaskArgs::tabId> { static constexpr std::wstring_view value = L"tabId"; };
+template <> struct FieldName<&TaskArgs::uri> { static constexpr std::wstring_view value = L"uri"; };
+template <> struct FieldName<&TaskArgs::title> { static constexpr std::wstring_view value = L"title"; };
+template <> struct FieldName<&TaskArgs::lifecycle> { static constexpr std::wstring_view value = L"lifecycle"; };
+template <> struct FieldName<&TaskArgs::processId> { static constexpr std::wstring_view value = L"processId"; };
+template <> struct FieldName<&TaskArgs::workingSet> { static constexpr std::wstring_view value = L"workingSet"; };
+template <> struct FieldName<&TaskArgs::cpu> { static constexpr std::wstring_view value = L"cpu"; };
+template <> struct FieldName<&TaskArgs::navigations> { static constexpr std::wstring_view value = L"navigations"; };
+
+inline void EncodeFields(JsonWriter& writer, const TaskArgs& args)
+{
+    writer.WriteNumber(L"tabId", args.tabId);
+    writer.WriteString(L"uri", args.uri);
+    if (!args.title.empty())
+        writer.WriteRaw(L"title", args.title);
+    writer.WriteString(L"lifecycle", args.lifecycle);
+    writer.WriteNumber(L"processId", args.processId);
+    writer.WriteNumber(L"workingSet", args.workingSet);
+    writer.WriteNumber(L"cpu", args.cpu);
+    writer.WriteNumber(L"navigations", args.navigations);
+}
+
+struct PageMetadataArgs
+{
+    JsonValue title;
+    JsonValue favicon;
+};
+
+template <>
+struct ArgsLayout<PageMetadataArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"title", HashFieldName(L"title"), FieldType::Json, offsetof(PageMetadataArgs, title) },
+        { L"favicon", HashFieldName(L"favicon"), FieldType::Json, offsetof(PageMetadataArgs, favicon) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 2, 0x0u };
+};
+
+template <> struct FieldName<&PageMetadataArgs::title> { static constexpr std::wstring_view value = L"title"; };
+template <> struct FieldName<&PageMetadataArgs::favicon> { static constexpr std::wstring_view value = L"favicon"; };
+
+inline void EncodeFields(JsonWriter& writer, const PageMetadataArgs& args)
+{
+    if (args.title.GetType() != JsonType::Invalid)
+        writer.WriteRaw(L"title", args.title.GetRaw());
+    if (args.favicon.GetType() != JsonType::Invalid)
+        writer.WriteRaw(L"favicon", args.favicon.GetRaw());
+}
+
+struct TabPolicyArgs
+{
+    std::optional<long long> suspendAfter;
+    std::optional<long long> discardAfter;
+    std::optional<long long> memoryBudget;
+};
+
+template <>
+struct ArgsLayout<TabPolicyArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"suspendAfter", HashFieldName(L"suspendAfter"), FieldType::OptionalInt, offsetof(TabPolicyArgs, suspendAfter) },
+        { L"discardAfter", HashFieldName(L"discardAfter"), FieldType::OptionalInt, offsetof(TabPolicyArgs, discardAfter) },
+        { L"memoryBudget", HashFieldName(L"memoryBudget"), FieldType::OptionalInt, offsetof(TabPolicyArgs, memoryBudget) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 3, 0x0u };
+};
+
+template <> struct FieldName<&TabPolicyArgs::suspendAfter> { static constexpr std::wstring_view value = L"suspendAfter"; };
+template <> struct FieldName<&TabPolicyArgs::discardAfter> { static constexpr std::wstring_view value = L"discardAfter"; };
+template <> struct FieldName<&TabPolicyArgs::memoryBudget> { static constexpr std::wstring_view value = L"memoryBudget"; };
+
+inline void EncodeFields(JsonWriter& writer, const TabPolicyArgs& args)
+{
+    if (args.suspendAfter)
+        writer.WriteNumber(L"suspendAfter", *args.suspendAfter);
+    if (args.discardAfter)
+        writer.WriteNumber(L"discardAfter", *args.discardAfter);
+    if (args.memoryBudget)
+        writer.WriteNumber(L"memoryBudget", *args.memoryBudget);
+}
+
+struct TabLifecycleArgs
+{
+    size_t tabId = INVALID_TAB_ID;
+    std::wstring_view lifecycle = L"";
+};
+
+template <>
+struct ArgsLayout<TabLifecycleArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"tabId", HashFieldName(L"tabId"), FieldType::Size, offsetof(TabLifecycleArgs, tabId) },
+        { L"lifecycle", HashFieldName(L"lifecycle"), FieldType::String, offsetof(TabLifecycleArgs, lifecycle) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 2, 0x3u };
+};
+
+template <> struct FieldName<&TabLifecycleArgs::tabId> { static constexpr std::wstring_view value = L"tabId"; };
+template <> struct FieldName<&TabLifecycleArgs::lifecycle> { static constexpr std::wstring_view value = L"lifecycle"; };
+
+inline void EncodeFields(JsonWriter& writer, const TabLifecycleArgs& args)
+{
+    writer.WriteNumber(L"tabId", args.tabId);
+    writer.WriteString(L"lifecycle", args.lifecycle);
+}
+
+struct SessionArgs
+{
+    std::optional<size_t> windowId;
+    std::optional<size_t> activeTabId;
+    JsonValue tabs; // Array of SessionTabArgs
+};
+
+template <>
+struct ArgsLayout<SessionArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"windowId", HashFieldName(L"windowId"), FieldType::OptionalSize, offsetof(SessionArgs, windowId) },
+        { L"activeTabId", HashFieldName(L"activeTabId"), FieldType::OptionalSize, offsetof(SessionArgs, activeTabId) },
+        { L"tabs", HashFieldName(L"tabs"), FieldType::Json, offsetof(SessionArgs, tabs) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 3, 0x0u };
+};
+
+template <> struct FieldName<&SessionArgs::windowId> { static constexpr std::wstring_view value = L"windowId"; };
+template <> struct FieldName<&SessionArgs::activeTabId> { static constexpr std::wstring_view value = L"activeTabId"; };
+template <> struct FieldName<&SessionArgs::tabs> { static constexpr std::wstring_view value = L"tabs"; };
+
+inline void EncodeFields(JsonWriter& writer, const SessionArgs& args)
+{
+    if (args.windowId)
+        writer.WriteNumber(L"windowId", *args.windowId);
+    if (args.activeTabId)
+        writer.WriteNumber(L"activeTabId", *args.activeTabId);
+    if (args.tabs.GetType() != JsonType::Invalid)
+        writer.WriteRaw(L"tabs", args.tabs.GetRaw());
+}
+
+struct SessionTabArgs
+{
+    size_t tabId = INVALID_TAB_ID;
+    std::wstring_view uri = L"";
+    std::wstring_view uriToShow = L"";
+    std::wstring_view title = L"";
+    std::wstring_view favicon = L"";
+    std::optional<bool> isFavorite;
+    std::wstring_view lifecycle = L"";
+};
+
+template <>
+struct ArgsLayout<SessionTabArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"tabId", HashFieldName(L"tabId"), FieldType::Size, offsetof(SessionTabArgs, tabId) },
+        { L"uri", HashFieldName(L"uri"), FieldType::String, offsetof(SessionTabArgs, uri) },
+        { L"uriToShow", HashFieldName(L"uriToShow"), FieldType::String, offsetof(SessionTabArgs, uriToShow) },
+        { L"title", HashFieldName(L"title"), FieldType::Raw, offsetof(SessionTabArgs, title) },
+        { L"favicon", HashFieldName(L"favicon"), FieldType::Raw, offsetof(SessionTabArgs, favicon) },
+        { L"isFavorite", HashFieldName(L"isFavorite"), FieldType::OptionalBool, offsetof(SessionTabArgs, isFavorite) },
+        { L"lifecycle", HashFieldName(L"lifecycle"), FieldType::String, offsetof(SessionTabArgs, lifecycle) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 7, 0x43u };
+};
+
+template <> struct FieldName<&SessionTabArgs::tabId> { static constexpr std::wstring_view value = L"tabId"; };
+template <> struct FieldName<&SessionTabArgs::uri> { static constexpr std::wstring_view value = L"uri"; };
+template <> struct FieldName<&SessionTabArgs::uriToShow> { static constexpr std::wstring_view value = L"uriToShow"; };
+template <> struct FieldName<&SessionTabArgs::title> { static constexpr std::wstring_view value = L"title"; };
+template <> struct FieldName<&SessionTabArgs::favicon> { static constexpr std::wstring_view value = L"favicon"; };
+template <> struct FieldName<&SessionTabArgs::isFavorite> { static constexpr std::wstring_view value = L"isFavorite"; };
+template <> struct FieldName<&SessionTabArgs::lifecycle> { static constexpr std::wstring_view value = L"lifecycle"; };
+
+inline void EncodeFields(JsonWriter& writer, const SessionTabArgs& args)
+{
+    writer.WriteNumber(L"tabId", args.tabId);
+    writer.WriteString(L"uri", args.uri);
+    if (!args.uriToShow.empty())
+        writer.WriteString(L"uriToShow", args.uriToShow);
+    if (!args.title.empty())
+        writer.WriteRaw(L"title", args.title);
+    if (!args.favicon.empty())
+        writer.WriteRaw(L"favicon", args.favicon);
+    if (args.isFavorite)
+        writer.WriteBool(L"isFavorite", *args.isFavorite);
+    writer.WriteString(L"lifecycle", args.lifecycle);
+}
+
+struct MoveTabArgs
+{
+    size_t tabId = INVALID_TAB_ID;
+    std::optional<size_t> windowId;
+    std::optional<size_t> newTabId;
+};
+
+template <>
+struct ArgsLayout<MoveTabArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"tabId", HashFieldName(L"tabId"), FieldType::Size, offsetof(MoveTabArgs, tabId) },
+        { L"windowId", HashFieldName(L"windowId"), FieldType::OptionalSize, offsetof(MoveTabArgs, windowId) },
+        { L"newTabId", HashFieldName(L"newTabId"), FieldType::OptionalSize, offsetof(MoveTabArgs, newTabId) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 3, 0x1u };
+};
+
+template <> struct FieldName<&MoveTabArgs::tabId> { static constexpr std::wstring_view value = L"tabId"; };
+template <> struct FieldName<&MoveTabArgs::windowId> { static constexpr std::wstring_view value = L"windowId"; };
+template <> struct FieldName<&MoveTabArgs::newTabId> { static constexpr std::wstring_view value = L"newTabId"; };
+
+inline void EncodeFields(JsonWriter& writer, const MoveTabArgs& args)
+{
+    writer.WriteNumber(L"tabId", args.tabId);
+    if (args.windowId)
+        writer.WriteNumber(L"windowId", *args.windowId);
+    if (args.newTabId)
+        writer.WriteNumber(L"newTabId", *args.newTabId);
+}
+
+struct SecurityStateEventArgs
+{
+    std::wstring_view securityState = L"";
+};
+
+template <>
+struct ArgsLayout<SecurityStateEventArgs>
+{
+    static constexpr FieldLayout Fields[] = {
+        { L"securityState", HashFieldName(L"securityState"), FieldType::String, offsetof(SecurityStateEventArgs, securityState) },
+    };
+    static constexpr MessageLayout Layout = { Fields, 1, 0x1u };
+};
+
+template <> struct FieldName<&SecurityStateEventArgs::securityState> { static constexpr std::wstring_view value = L"securityState"; };
+
+inline void EncodeFields(JsonWriter& writer, const SecurityStateEventArgs& args)
+{
+    writer.WriteString(L"securityState", args.securityState);
+}
+
+// Args of each message, Message<id> derives from them
+template <>
+struct MessageArgs<MG_NAVIGATE>
+{
+    using Type = NavigateArgs;
+};
+
+template <>
+struct MessageArgs<MG_UPDATE_URI>
+{
+    using Type = UpdateUriArgs;
+};
+
+template <>
+struct MessageArgs<MG_GO_FORWARD>
+{
+    using Type = EmptyArgs;
+};
+
+template <>
+struct MessageArgs<MG_GO_BACK>
+{
+    using Type = EmptyArgs;
+};
+
+template <>
+struct MessageArgs<MG_NAV_STARTING>
+{
+    using Type = TabArgs;
+};
+
+template <>
+struct MessageArgs<MG_NAV_COMPLETED>
+{
+    using Type = NavCompletedArgs;
+};
+
+template <>
+struct MessageArgs<MG_RELOAD>
+{
+    using Type = EmptyArgs;
+};
+
+template <>
+struct MessageArgs<MG_CANCEL>
+{
+    using Type = EmptyArgs;
+};
+
+template <>
+struct MessageArgs<MG_CREATE_TAB>
+{
+    using Type = CreateTabArgs;
+};
+
+template <>
+struct MessageArgs<MG_UPDATE_TAB>
+{
+    using Type = UpdateTabArgs;
+};
+
+template <>
+struct MessageArgs<MG_SWITCH_TAB>
+{
+    using Type = TabArgs;
+};
+
+template <>
+struct MessageArgs<MG_CLOSE_TAB>
+{
+    using Type = TabArgs;
+};
+
+template <>
+struct MessageArgs<MG_CLOSE_WINDOW>
+{
+    using Type = EmptyArgs;
+};
+
+template <>
+struct MessageArgs<MG_SHOW_OPTIONS>
+{
+    using Type = EmptyArgs;
+};
+
+template <>
+struct MessageArgs<MG_HIDE_OPTIONS>
+{
+    using Type = EmptyArgs;
+};
+
+template <>
+struct MessageArgs<MG_OPTIONS_LOST_FOCUS>
+{
+    using Type = EmptyArgs;
+};
+
+template <>
+struct MessageArgs<MG_OPTION_SELECTED>
+{
+    using Type = EmptyArgs;
+};
+
+template <>
+struct MessageArgs<MG_SECURITY_UPDATE>
+{
+    using Type = SecurityUpdateArgs;
+};
+
+template <>
+struct MessageArgs<MG_UPDATE_FAVICON>
+{
+    using Type = UpdateFaviconArgs;
+};
+
+template <>
+struct MessageArgs<MG_GET_SETTINGS>
+{
+    using Type = SettingsArgs;
+};
+
+template <>
+struct MessageArgs<MG_GET_FAVORITES>
+{
+    using Type = FavoritesArgs;
+};
+
+template <>
+struct MessageArgs<MG_REMOVE_FAVORITE>
+{
+    using Type = RemoveFavoriteArgs;
+};
+
+template <>
+struct MessageArgs<MG_CLEAR_CACHE>
+{
+    using Type = ClearDataArgs;
+};
+
+template <>
+struct MessageArgs<MG_CLEAR_COOKIES>
+{
+    using Type = ClearDataArgs;
+};
+
+template <>
+struct MessageArgs<MG_GET_HISTORY>
+{
+    using Type = HistoryArgs;
+};
+
+template <>
+struct MessageArgs<MG_REMOVE_HISTORY_ITEM>
+{
+    using Type = RemoveHistoryItemArgs;
+};
+
+template <>
+struct MessageArgs<MG_CLEAR_HISTORY>
+{
+    using Type = EmptyArgs;
+};
+
+template <>
+struct MessageArgs<MG_BATCH>
+{
+    using Type = BatchArgs;
+};
+
+template <>
+struct MessageArgs<MG_GET_METRICS>
+{
+    using Type = MetricsArgs;
+};
+
+template <>
+struct MessageArgs<MG_DUMP_METRICS>
+{
+    using Type = DumpMetricsArgs;
+};
+
+template <>
+struct MessageArgs<MG_SET_TRACING>
+{
+    using Type = CaptureArgs;
+};
+
+template <>
+struct MessageArgs<MG_PAGE_METADATA>
+{
+    using Type = PageMetadataArgs;
+};
+
+template <>
+struct MessageArgs<MG_SET_RECORDING>
+{
+    using Type = CaptureArgs;
+};
+
+template <>
+struct MessageArgs<MG_SET_TAB_POLICY>
+{
+    using Type = TabPolicyArgs;
+};
+
+template <>
+struct MessageArgs<MG_TAB_LIFECYCLE>
+{
+    using Type = TabLifecycleArgs;
+};
+
+template <>
+struct MessageArgs<MG_RESTORE_SESSION>
+{
+    using Type = SessionArgs;
+};
+
+template <>
+struct MessageArgs<MG_GET_TASKS>
+{
+    using Type = TasksArgs;
+};
+
+template <>
+struct MessageArgs<MG_MOVE_TAB>
+{
+    using Type = MoveTabArgs;
+};
+
+template <>
+struct MessageArgs<MG_SEARCH_HISTORY>
+{
+    using Type = HistoryArgs;
+};
+
+template <>
+struct MessageArgs<MG_GET_SUGGESTIONS>
+{
+    using Type = SuggestionsArgs;
+};
+
+template <>
+struct MessageArgs<MG_ADD_FAVORITE>
+{
+    using Type = AddFavoriteArgs;
+};
+
+template <>
+struct MessageArgs<MG_MIGRATE_FAVORITES>
+{
+    using Type = MigrateFavoritesArgs;
+};
+
+using NavigateMessage = Message<MG_NAVIGATE>;
+using UpdateUriMessage = Message<MG_UPDATE_URI>;
+using GoForwardMessage = Message<MG_GO_FORWARD>;
+using GoBackMessage = Message<MG_GO_BACK>;
+using NavStartingMessage = Message<MG_NAV_STARTING>;
+using NavCompletedMessage = Message<MG_NAV_COMPLETED>;
+using ReloadMessage = Message<MG_RELOAD>;
+using CancelMessage = Message<MG_CANCEL>;
+using CreateTabMessage = Message<MG_CREATE_TAB>;
+using UpdateTabMessage = Message<MG_UPDATE_TAB>;
+using SwitchTabMessage = Message<MG_SWITCH_TAB>;
+using CloseTabMessage = Message<MG_CLOSE_TAB>;
+using CloseWindowMessage = Message<MG_CLOSE_WINDOW>;
+using ShowOptionsMessage = Message<MG_SHOW_OPTIONS>;
+using HideOptionsMessage = Message<MG_HIDE_OPTIONS>;
+using OptionsLostFocusMessage = Message<MG_OPTIONS_LOST_FOCUS>;
+using OptionSelectedMessage = Message<MG_OPTION_SELECTED>;
+using SecurityUpdateMessage = Message<MG_SECURITY_UPDATE>;
+using UpdateFaviconMessage = Message<MG_UPDATE_FAVICON>;
+using GetSettingsMessage = Message<MG_GET_SETTINGS>;
+using GetFavoritesMessage = Message<MG_GET_FAVORITES>;
+using RemoveFavoriteMessage = Message<MG_REMOVE_FAVORITE>;
+using ClearCacheMessage = Message<MG_CLEAR_CACHE>;
+using ClearCookiesMessage = Message<MG_CLEAR_COOKIES>;
+using GetHistoryMessage = Message<MG_GET_HISTORY>;
+using RemoveHistoryItemMessage = Message<MG_REMOVE_HISTORY_ITEM>;
+using ClearHistoryMessage = Message<MG_CLEAR_HISTORY>;
+using BatchMessage = Message<MG_BATCH>;
+using GetMetricsMessage = Message<MG_GET_METRICS>;
+using DumpMetricsMessage = Message<MG_DUMP_METRICS>;
+using SetTracingMessage = Message<MG_SET_TRACING>;
+using PageMetadataMessage = Message<MG_PAGE_METADATA>;
+using SetRecordingMessage = Message<MG_SET_RECORDING>;
+using SetTabPolicyMessage = Message<MG_SET_TAB_POLICY>;
+using TabLifecycleMessage = Message<MG_TAB_LIFECYCLE>;
+using RestoreSessionMessage = Message<MG_RESTORE_SESSION>;
+using GetTasksMessage = Message<MG_GET_TASKS>;
+using MoveTabMessage = Message<MG_MOVE_TAB>;
+using SearchHistoryMessage = Message<MG_SEARCH_HISTORY>;
+using GetSuggestionsMessage = Message<MG_GET_SUGGESTIONS>;
+using AddFavoriteMessage = Message<MG_ADD_FAVORITE>;
+using MigrateFavoritesMessage = Message<MG_MIGRATE_FAVORITES>;
+
+// Indexed by message id, nullptr for unused ids
+constexpr const MessageLayout* c_messageLayouts[44] = {
+    nullptr,
+    &ArgsLayout<NavigateArgs>::Layout, // MG_NAVIGATE
+    &ArgsLayout<UpdateUriArgs>::Layout, // MG_UPDATE_URI
+    &ArgsLayout<EmptyArgs>::Layout, // MG_GO_FORWARD
+    &ArgsLayout<EmptyArgs>::Layout, // MG_GO_BACK
+    &ArgsLayout<TabArgs>::Layout, // MG_NAV_STARTING
+    &ArgsLayout<NavCompletedArgs>::Layout, // MG_NAV_COMPLETED
+    &ArgsLayout<EmptyArgs>::Layout, // MG_RELOAD
+    &ArgsLayout<EmptyArgs>::Layout, // MG_CANCEL
+    nullptr,
+    &ArgsLayout<CreateTabArgs>::Layout, // MG_CREATE_TAB
+    &ArgsLayout<UpdateTabArgs>::Layout, // MG_UPDATE_TAB
+    &ArgsLayout<TabArgs>::Layout, // MG_SWITCH_TAB
+    &ArgsLayout<TabArgs>::Layout, // MG_CLOSE_TAB
+    &ArgsLayout<EmptyArgs>::Layout, // MG_CLOSE_WINDOW
+    &ArgsLayout<EmptyArgs>::Layout, // MG_SHOW_OPTIONS
+    &ArgsLayout<EmptyArgs>::Layout, // MG_HIDE_OPTIONS
+    &ArgsLayout<EmptyArgs>::Layout, // MG_OPTIONS_LOST_FOCUS
+    &ArgsLayout<EmptyArgs>::Layout, // MG_OPTION_SELECTED
+    &ArgsLayout<SecurityUpdateArgs>::Layout, // MG_SECURITY_UPDATE
+    &ArgsLayout<UpdateFaviconArgs>::Layout, // MG_UPDATE_FAVICON
+    &ArgsLayout<SettingsArgs>::Layout, // MG_GET_SETTINGS
+    &ArgsLayout<FavoritesArgs>::Layout, // MG_GET_FAVORITES
+    &ArgsLayout<RemoveFavoriteArgs>::Layout, // MG_REMOVE_FAVORITE
+    &ArgsLayout<ClearDataArgs>::Layout, // MG_CLEAR_CACHE
+    &ArgsLayout<ClearDataArgs>::Layout, // MG_CLEAR_COOKIES
+    &ArgsLayout<HistoryArgs>::Layout, // MG_GET_HISTORY
+    &ArgsLayout<RemoveHistoryItemArgs>::Layout, // MG_REMOVE_HISTORY_ITEM
+    &ArgsLayout<EmptyArgs>::Layout, // MG_CLEAR_HISTORY
+    &ArgsLayout<BatchArgs>::Layout, // MG_BATCH
+    &ArgsLayout<MetricsArgs>::Layout, // MG_GET_METRICS
+    &ArgsLayout<DumpMetricsArgs>::Layout, // MG_DUMP_METRICS
+    &ArgsLayout<CaptureArgs>::Layout, // MG_SET_TRACING
+    &ArgsLayout<PageMetadataArgs>::Layout, // MG_PAGE_METADATA
+    &ArgsLayout<CaptureArgs>::Layout, // MG_SET_RECORDING
+    &ArgsLayout<TabPolicyArgs>::Layout, // MG_SET_TAB_POLICY
+    &ArgsLayout<TabLifecycleArgs>::Layout, // MG_TAB_LIFECYCLE
+    &ArgsLayout<SessionArgs>::Layout, // MG_RESTORE_SESSION
+    &ArgsLayout<TasksArgs>::Layout, // MG_GET_TASKS
+    &ArgsLayout<MoveTabArgs>::Layout, // MG_MOVE_TAB
+    &ArgsLayout<HistoryArgs>::Layout, // MG_SEARCH_HISTORY
+    &ArgsLayout<SuggestionsArgs>::Layout, // MG_GET_SUGGESTIONS
+    &ArgsLayout<AddFavoriteArgs>::Layout, // MG_ADD_FAVORITE
+    &ArgsLayout<MigrateFavoritesArgs>::Layout, // MG_MIGRATE_FAVORITES
+};
+
+constexpr const MessageLayout* GetMessageLayout(int message)
+{
+    return message >= 0 && message <= c_maxMessageId ? c_messageLayouts[message] : nullptr;
+}
+
+// Calls the OnMessage overload Handler has for a message, through a table
+// built at compile time and indexed by message id
+template <typename Handler>
+class MessageDispatcher
+{
+public:
+    static DispatchResult Dispatch(Handler& handler, int message, JsonValue& args)
+    {
+        Entry entry = message >= 0 && message <= c_maxMessageId ? c_entries[message] : nullptr;
+        return entry == nullptr ? DispatchResult::Unhandled : entry(handler, args);
+    }
+
+private:
+    using Table = MessageHandlerTable<Handler>;
+    using Entry = typename Table::Entry;
+
+    static constexpr Entry c_entries[44] = {
+        nullptr,
+        Table::template GetEntry<MG_NAVIGATE>(),
+        Table::template GetEntry<MG_UPDATE_URI>(),
+        Table::template GetEntry<MG_GO_FORWARD>(),
+        Table::template GetEntry<MG_GO_BACK>(),
+        Table::template GetEntry<MG_NAV_STARTING>(),
+        Table::template GetEntry<MG_NAV_COMPLETED>(),
+        Table::template GetEntry<MG_RELOAD>(),
+        Table::template GetEntry<MG_CANCEL>(),
+        nullptr,
+        Table::template GetEntry<MG_CREATE_TAB>(),
+        Table::template GetEntry<MG_UPDATE_TAB>(),
+        Table::template GetEntry<MG_SWITCH_TAB>(),
+        Table::template GetEntry<MG_CLOSE_TAB>(),
+        Table::template GetEntry<MG_CLOSE_WINDOW>(),
+        Table::template GetEntry<MG_SHOW_OPTIONS>(),
+        Table::template GetEntry<MG_HIDE_OPTIONS>(),
+        Table::template GetEntry<MG_OPTIONS_LOST_FOCUS>(),
+        Table::template GetEntry<MG_OPTION_SELECTED>(),
+        Table::template GetEntry<MG_SECURITY_UPDATE>(),
+        Table::template GetEntry<MG_UPDATE_FAVICON>(),
+        Table::template GetEntry<MG_GET_SETTINGS>(),
+        Table::template GetEntry<MG_GET_FAVORITES>(),
+        Table::template GetEntry<MG_REMOVE_FAVORITE>(),
+        Table::template GetEntry<MG_CLEAR_CACHE>(),
+        Table::template GetEntry<MG_CLEAR_COOKIES>(),
+        Table::template GetEntry<MG_GET_HISTORY>(),
+        Table::template GetEntry<MG_REMOVE_HISTORY_ITEM>(),
+        Table::template GetEntry<MG_CLEAR_HISTORY>(),
+        Table::template GetEntry<MG_BATCH>(),
+        Table::template GetEntry<MG_GET_METRICS>(),
+        Table::template GetEntry<MG_DUMP_METRICS>(),
+        Table::template GetEntry<MG_SET_TRACING>(),
+        Table::template GetEntry<MG_PAGE_METADATA>(),
+        Table::template GetEntry<MG_SET_RECORDING>(),
+        Table::template GetEntry<MG_SET_TAB_POLICY>(),
+        Table::template GetEntry<MG_TAB_LIFECYCLE>(),
+        Table::template GetEntry<MG_RESTORE_SESSION>(),
+        Table::template GetEntry<MG_GET_TASKS>(),
+        Table::template GetEntry<MG_MOVE_TAB>(),
+        Table::template GetEntry<MG_SEARCH_HISTORY>(),
+        Table::template GetEntry<MG_GET_SUGGESTIONS>(),
+        Table::template GetEntry<MG_ADD_FAVORITE>(),
+        Table::template GetEntry<MG_MIGRATE_FAVORITES>(),
+    };
+};
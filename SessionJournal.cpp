@@ -0,0 +1,194 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "SessionJournal.h"
+#include <iterator>
+#include "ByteCodec.h"
+#include "MessageCodec.h"
+
+namespace
+{
+    const uint8_t c_magic[] = { 'W', 'S' };
+    const uint8_t c_version = 1;
+    const size_t c_headerSize = sizeof(c_magic) + 1;
+}
+
+void SessionJournal::AddTab(size_t tabId)
+{
+    Record(RecordType::AddTab, tabId);
+}
+
+void SessionJournal::RemoveTab(size_t tabId)
+{
+    Record(RecordType::RemoveTab, tabId);
+}
+
+void SessionJournal::SetUri(size_t tabId, std::wstring_view uri)
+{
+    Record(RecordType::SetUri, tabId, uri);
+}
+
+void SessionJournal::SetTitle(size_t tabId, std::wstring_view titleJson)
+{
+    Record(RecordType::SetTitle, tabId, titleJson);
+}
+
+void SessionJournal::SetActiveTab(size_t tabId)
+{
+    Record(RecordType::SetActiveTab, tabId);
+}
+
+size_t SessionJournal::GetActiveTabId() const
+{
+    for (const SessionTab& tab : m_tabs)
+    {
+        if (tab.tabId == m_activeTabId)
+            return m_activeTabId;
+    }
+    return m_tabs.empty() ? INVALID_TAB_ID : m_tabs.back().tabId;
+}
+
+void SessionJournal::TakeRecords(std::vector<uint8_t>& records)
+{
+    records.swap(m_records);
+    m_records.clear();
+}
+
+bool SessionJournal::ShouldCompact() const
+{
+    return m_journalSize > c_minCompactSize && m_journalSize > m_snapshotSize * 4;
+}
+
+void SessionJournal::WriteSnapshot(std::vector<uint8_t>& journal)
+{
+    journal.assign(std::begin(c_magic), std::end(c_magic));
+    journal.push_back(c_version);
+
+    for (const SessionTab& tab : m_tabs)
+    {
+        AppendRecord(journal, RecordType::AddTab, tab.tabId, {});
+        if (!tab.uri.empty())
+            AppendRecord(journal, RecordType::SetUri, tab.tabId, tab.uri);
+        if (!tab.titleJson.empty())
+            AppendRecord(journal, RecordType::SetTitle, tab.tabId, tab.titleJson);
+    }
+    if (m_activeTabId != INVALID_TAB_ID)
+        AppendRecord(journal, RecordType::SetActiveTab, m_activeTabId, {});
+
+    m_records.clear();
+    m_journalSize = journal.size();
+    m_snapshotSize = journal.size();
+}
+
+bool SessionJournal::Load(const std::vector<uint8_t>& journal)
+{
+    m_tabs.clear();
+    m_activeTabId = INVALID_TAB_ID;
+    m_records.clear();
+    m_journalSize = 0;
+    m_snapshotSize = 0;
+    if (journal.size() < c_headerSize || journal[0] != c_magic[0] || journal[1] != c_magic[1] || journal[2] != c_version)
+        return false;
+
+    size_t position = c_headerSize;
+    size_t loaded = position; // Up to the last intact record
+    std::wstring text;
+    const uint8_t* payload = nullptr;
+    size_t length = 0;
+    while (ReadChecksummedRecord(journal, position, payload, length))
+    {
+        size_t start = static_cast<size_t>(payload - journal.data());
+        size_t end = start + length;
+        size_t textPosition = start + 1;
+        uint64_t tabId = 0;
+        if (!ReadVarint(journal, textPosition, tabId) || textPosition > end ||
+            !DecodeUtf8(journal.data() + textPosition, end - textPosition, text))
+            break;
+
+        RecordType type = static_cast<RecordType>(payload[0]);
+        if (type != RecordType::SetTitle || JsonReader::IsString(text))
+            Apply(type, static_cast<size_t>(tabId), text);
+        loaded = position;
+    }
+
+    // Whatever follows a damaged record is dropped by the next snapshot
+    m_journalSize = loaded;
+    m_snapshotSize = loaded;
+    return true;
+}
+
+bool SessionJournal::Apply(RecordType type, size_t tabId, std::wstring_view text)
+{
+    SessionTab* tab = Find(tabId);
+    switch (type)
+    {
+    case RecordType::AddTab:
+        if (tab != nullptr)
+        {
+            // A tab created again under the same id starts over
+            tab->uri.clear();
+            tab->titleJson.clear();
+        }
+        else
+        {
+            SessionTab added;
+            added.tabId = tabId;
+            m_tabs.push_back(std::move(added));
+        }
+        return true;
+    case RecordType::RemoveTab:
+        if (tab == nullptr)
+            return false;
+        m_tabs.erase(m_tabs.begin() + (tab - m_tabs.data()));
+        return true;
+    case RecordType::SetUri:
+        if (tab == nullptr || tab->uri == text)
+            return false;
+        tab->uri = text;
+        return true;
+    case RecordType::SetTitle:
+        if (tab == nullptr || tab->titleJson == text)
+            return false;
+        tab->titleJson = text;
+        return true;
+    case RecordType::SetActiveTab:
+        if (tab == nullptr || m_activeTabId == tabId)
+            return false;
+        m_activeTabId = tabId;
+        return true;
+    default:
+        return false;
+    }
+}
+
+void SessionJournal::Record(RecordType type, size_t tabId, std::wstring_view text)
+{
+    if (!Apply(type, tabId, text))
+        return;
+
+    size_t size = m_records.size();
+    AppendRecord(m_records, type, tabId, text);
+    m_journalSize += m_records.size() - size;
+}
+
+// The payload is the record type, the tab id and the text, if any, up to
+// its end
+void SessionJournal::AppendRecord(std::vector<uint8_t>& bytes, RecordType type, size_t tabId, std::wstring_view text)
+{
+    m_payload.clear();
+    m_payload.push_back(static_cast<uint8_t>(type));
+    AppendVarint(m_payload, tabId);
+    AppendUtf8(m_payload, text);
+    AppendChecksummedRecord(bytes, m_payload);
+}
+
+SessionTab* SessionJournal::Find(size_t tabId)
+{
+    for (SessionTab& tab : m_tabs)
+    {
+        if (tab.tabId == tabId)
+            return &tab;
+    }
+    return nullptr;
+}
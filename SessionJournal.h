@@ -0,0 +1,81 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "messages.h"
+
+// The open tabs, kept as an append-only journal so they survive a restart or
+// a crash. Every change appends a record; once the records outgrow the state
+// they describe, the whole journal is replaced by a snapshot of the state.
+// Each record carries its length and a checksum, so a record cut short by a
+// crash ends the replay and everything before it is kept.
+// Nothing in here depends on Windows headers.
+
+struct SessionTab
+{
+    size_t tabId = INVALID_TAB_ID;
+    std::wstring uri;
+    std::wstring titleJson; // JSON string as posted by the page metadata script
+};
+
+class SessionJournal
+{
+public:
+    static const size_t c_minCompactSize = 64 * 1024; // Bytes of journal
+
+    // Each change is only recorded if it changes the session
+    void AddTab(size_t tabId);
+    void RemoveTab(size_t tabId);
+    void SetUri(size_t tabId, std::wstring_view uri);
+    void SetTitle(size_t tabId, std::wstring_view titleJson);
+    void SetActiveTab(size_t tabId);
+
+    // In the order they were created
+    const std::vector<SessionTab>& GetTabs() const { return m_tabs; }
+    // The last tab if the active one was closed
+    size_t GetActiveTabId() const;
+
+    // Records not written yet, to be appended to the journal file
+    bool HasRecords() const { return !m_records.empty(); }
+    void TakeRecords(std::vector<uint8_t>& records);
+    // Whether the file has grown past c_minCompactSize and four times its
+    // last snapshot
+    bool ShouldCompact() const;
+    // The whole session as a new journal, to replace the file with. Pending
+    // records are part of it.
+    void WriteSnapshot(std::vector<uint8_t>& journal);
+
+    // Replays a journal read back from the file. Returns false if it isn't
+    // one, the session is empty then.
+    bool Load(const std::vector<uint8_t>& journal);
+
+private:
+    enum class RecordType : uint8_t
+    {
+        AddTab = 1,
+        RemoveTab,
+        SetUri,
+        SetTitle,
+        SetActiveTab
+    };
+
+    // Returns whether the session changed
+    bool Apply(RecordType type, size_t tabId, std::wstring_view text);
+    void Record(RecordType type, size_t tabId, std::wstring_view text = {});
+    void AppendRecord(std::vector<uint8_t>& bytes, RecordType type, size_t tabId, std::wstring_view text);
+    SessionTab* Find(size_t tabId);
+
+    std::vector<SessionTab> m_tabs;
+    size_t m_activeTabId = INVALID_TAB_ID;
+    std::vector<uint8_t> m_records;
+    std::vector<uint8_t> m_payload; // Reused by AppendRecord
+    size_t m_journalSize = 0; // In the file, once the records are written
+    size_t m_snapshotSize = 0;
+};
@@ -0,0 +1,54 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "SharedEnvironment.h"
+
+using namespace Microsoft::WRL;
+
+HRESULT SharedEnvironment::Get(const std::wstring& userDataFolder, ReadyHandler ready)
+{
+    if (m_env)
+    {
+        return ready(m_env.Get());
+    }
+
+    m_waiting.push_back(std::move(ready));
+    if (m_isCreating)
+    {
+        return S_OK;
+    }
+
+    m_isCreating = true;
+    HRESULT hr = CreateCoreWebView2EnvironmentWithOptions(nullptr, userDataFolder.c_str(),
+        nullptr, Callback<ICoreWebView2CreateCoreWebView2EnvironmentCompletedHandler>(
+            [this](HRESULT result, ICoreWebView2Environment* env) -> HRESULT
+    {
+        m_isCreating = false;
+        std::vector<ReadyHandler> waiting = std::move(m_waiting);
+        m_waiting.clear();
+        RETURN_IF_FAILED(result);
+
+        m_env = env;
+        HRESULT hr = S_OK;
+        for (ReadyHandler& handler : waiting)
+        {
+            HRESULT handled = handler(env);
+            if (FAILED(handled) && SUCCEEDED(hr))
+                hr = handled;
+        }
+        return hr;
+    }).Get());
+
+    if (FAILED(hr))
+    {
+        m_isCreating = false;
+        m_waiting.clear();
+    }
+    return hr;
+}
+
+void SharedEnvironment::Release()
+{
+    m_env = nullptr;
+}
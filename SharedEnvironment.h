@@ -0,0 +1,29 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "framework.h"
+
+// A WebView2 environment all browser windows use, so every window runs in
+// the same browser process group and a tab's controller can be moved from
+// one window to another. The first window to ask creates it, windows asking
+// while it's being created get it once it's ready and later ones right away.
+class SharedEnvironment
+{
+public:
+    using ReadyHandler = std::function<HRESULT(ICoreWebView2Environment* env)>;
+
+    HRESULT Get(const std::wstring& userDataFolder, ReadyHandler ready);
+    // Once the last window is gone, the next one creates it again
+    void Release();
+
+private:
+    Microsoft::WRL::ComPtr<ICoreWebView2Environment> m_env;
+    std::vector<ReadyHandler> m_waiting;
+    bool m_isCreating = false;
+};
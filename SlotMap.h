@@ -0,0 +1,107 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Handle to a value in a SlotMap. The generation changes every time its slot
+// is freed, so a key kept past the removal of its value finds nothing instead
+// of whatever took the slot over.
+struct SlotKey
+{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const SlotKey& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const SlotKey& other) const { return !(*this == other); }
+};
+
+// Values stored contiguously, in no particular order, behind stable keys.
+// Insert, Remove and Get are O(1): removing moves the last value into the
+// hole and freed slots are reused. Values must be movable.
+// Nothing in here depends on Windows headers.
+template <typename T>
+class SlotMap
+{
+public:
+    SlotKey Insert(T value)
+    {
+        uint32_t index;
+        if (!m_freeSlots.empty())
+        {
+            index = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        }
+        else
+        {
+            index = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back({});
+        }
+
+        Slot& slot = m_slots[index];
+        slot.position = static_cast<uint32_t>(m_values.size());
+        m_values.push_back(std::move(value));
+        m_valueSlots.push_back(index);
+        return { index, slot.generation };
+    }
+
+    // Returns false if the key is stale
+    bool Remove(SlotKey key, T* removed = nullptr)
+    {
+        if (!IsValid(key))
+            return false;
+
+        Slot& slot = m_slots[key.index];
+        uint32_t last = static_cast<uint32_t>(m_values.size() - 1);
+        if (removed != nullptr)
+            *removed = std::move(m_values[slot.position]);
+        if (slot.position != last)
+        {
+            m_values[slot.position] = std::move(m_values[last]);
+            m_valueSlots[slot.position] = m_valueSlots[last];
+            m_slots[m_valueSlots[last]].position = slot.position;
+        }
+        m_values.pop_back();
+        m_valueSlots.pop_back();
+
+        slot.position = c_free;
+        ++slot.generation;
+        m_freeSlots.push_back(key.index);
+        return true;
+    }
+
+    T* Get(SlotKey key) { return IsValid(key) ? &m_values[m_slots[key.index].position] : nullptr; }
+    const T* Get(SlotKey key) const { return IsValid(key) ? &m_values[m_slots[key.index].position] : nullptr; }
+    bool IsValid(SlotKey key) const
+    {
+        return key.index < m_slots.size() && m_slots[key.index].generation == key.generation && m_slots[key.index].position != c_free;
+    }
+
+    size_t Size() const { return m_values.size(); }
+    bool IsEmpty() const { return m_values.empty(); }
+
+    // The values, in storage order, which Remove changes
+    typename std::vector<T>::iterator begin() { return m_values.begin(); }
+    typename std::vector<T>::iterator end() { return m_values.end(); }
+    typename std::vector<T>::const_iterator begin() const { return m_values.begin(); }
+    typename std::vector<T>::const_iterator end() const { return m_values.end(); }
+
+private:
+    static constexpr uint32_t c_free = UINT32_MAX;
+
+    struct Slot
+    {
+        uint32_t position = c_free; // In m_values
+        uint32_t generation = 0;
+    };
+
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+    std::vector<T> m_values;
+    std::vector<uint32_t> m_valueSlots; // Slot of each value, to fix it up when the value moves
+};
@@ -0,0 +1,451 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "SuggestionIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "HistoryIndex.h"
+
+namespace
+{
+    const int64_t c_epoch = 18262LL * 86400000; // 2020-01-01, weights are relative to it
+    const double c_maxHalvings = 1000; // A double holds 2^1023
+
+    // Of folded text
+    bool IsLetter(wchar_t c)
+    {
+        return (c >= L'a' && c <= L'z') || c >= 0xC0;
+    }
+
+    bool HasLetter(std::wstring_view text)
+    {
+        return std::any_of(text.begin(), text.end(), IsLetter);
+    }
+
+    bool IsSchemeCharacter(wchar_t c)
+    {
+        return (c >= L'a' && c <= L'z') || (c >= L'0' && c <= L'9') || c == L'+' || c == L'-' || c == L'.';
+    }
+
+    bool StartsWith(std::wstring_view text, std::wstring_view prefix)
+    {
+        return text.substr(0, prefix.size()) == prefix;
+    }
+
+    bool IsSpace(wchar_t c)
+    {
+        return c <= L' ' || c == 0xA0;
+    }
+}
+
+double SuggestionIndex::GetWeight(int64_t timestamp)
+{
+    double halvings = static_cast<double>(timestamp - c_epoch) / c_halfLife;
+    return std::exp2(std::clamp(halvings, -c_maxHalvings, c_maxHalvings));
+}
+
+void SuggestionIndex::AddVisit(std::wstring_view uri, int64_t timestamp, uint64_t historyId, bool isNewEntry)
+{
+    uint32_t id = FindEntry(uri);
+    if (id == c_noEntry)
+    {
+        id = static_cast<uint32_t>(m_entries.size());
+        Entry& added = m_entries.emplace_back();
+        added.uri = uri;
+        added.hash = HashUri(uri);
+        AddSlot(id);
+        ++m_count;
+    }
+
+    Entry& entry = m_entries[id];
+    // A visit that updates an entry counts it if it wasn't counted yet
+    if (isNewEntry || entry.entryCount == 0)
+        ++entry.entryCount;
+    entry.historyId = historyId;
+    SetScore(id, entry.score + GetWeight(timestamp));
+}
+
+void SuggestionIndex::RemoveEntry(std::wstring_view uri, int64_t timestamp, uint64_t historyId)
+{
+    uint32_t id = FindEntry(uri);
+    if (id == c_noEntry)
+        return;
+
+    Entry& entry = m_entries[id];
+    if (entry.historyId == historyId)
+        entry.historyId = 0;
+    if (entry.entryCount > 1)
+    {
+        --entry.entryCount;
+        // Same day visits beyond the last one stay until the next launch
+        // rebuilds the scores from the history
+        SetScore(id, std::max(entry.score - GetWeight(timestamp), std::numeric_limits<double>::min()));
+        return;
+    }
+
+    SetScore(id, 0);
+    m_slots[FindSlot(uri, entry.hash)] = c_removedEntry;
+    // Ids aren't reused, the lists have none of it left
+    entry = Entry();
+    --m_count;
+}
+
+void SuggestionIndex::Clear()
+{
+    m_entries.clear();
+    m_count = 0;
+    m_slots.clear();
+    m_usedSlots = 0;
+    m_nodes.assign(1, Node());
+}
+
+double SuggestionIndex::GetScore(std::wstring_view uri) const
+{
+    uint32_t id = FindEntry(uri);
+    return id == c_noEntry ? 0 : m_entries[id].score;
+}
+
+// Starts at the node of the query, or of its first path segment when it has
+// a path and fewer URIs have that, and takes the best branch or list entry
+// left each time. Only a query that a node doesn't match exactly checks the
+// URIs it takes.
+void SuggestionIndex::Find(std::wstring_view query, const std::vector<KnownPage>& tabs, const std::vector<KnownPage>& favorites,
+    int64_t now, size_t count, std::vector<Suggestion>& suggestions)
+{
+    suggestions.clear();
+    std::wstring folded;
+    HistoryIndex::Fold(query, folded);
+    std::wstring_view text = folded;
+    while (!text.empty() && IsSpace(text.front()))
+        text.remove_prefix(1);
+    while (!text.empty() && IsSpace(text.back()))
+        text.remove_suffix(1);
+
+    Query match;
+    match.text = TrimUri(text);
+    if (match.text.empty() || count == 0)
+        return;
+    size_t pathStart = match.text.find_first_of(L"/?#");
+    match.isPrefix = pathStart != std::wstring_view::npos;
+    std::wstring_view head = match.text.substr(0, pathStart);
+
+    uint32_t start = head.empty() ? c_noEntry : FindNode(head.substr(0, c_maxTokenLength));
+    if (match.isPrefix && start != c_noEntry && match.text[pathStart] == L'/')
+    {
+        std::wstring_view segment = match.text.substr(pathStart + 1);
+        segment = segment.substr(0, segment.find_first_of(L"/?#"));
+        if (HasLetter(segment))
+        {
+            uint32_t segmentNode = FindNode(segment.substr(0, c_maxTokenLength));
+            if (segmentNode == c_noEntry || m_nodes[segmentNode].count < m_nodes[start].count)
+                start = segmentNode;
+        }
+    }
+    bool isExact = !match.isPrefix && head.size() <= c_maxTokenLength;
+
+    struct Candidate
+    {
+        double score;
+        uint32_t node;
+        uint32_t position; // In the node's list, c_noEntry for the whole subtree
+
+        bool operator<(const Candidate& other) const { return score < other.score; }
+    };
+    std::vector<Candidate> heap;
+    auto push = [&heap](const Candidate& candidate)
+    {
+        heap.push_back(candidate);
+        std::push_heap(heap.begin(), heap.end());
+    };
+    if (start != c_noEntry && m_nodes[start].best > 0)
+        push({ m_nodes[start].best, start, c_noEntry });
+
+    while (!heap.empty() && suggestions.size() < count)
+    {
+        std::pop_heap(heap.begin(), heap.end());
+        Candidate top = heap.back();
+        heap.pop_back();
+        const Node& node = m_nodes[top.node];
+        if (top.position == c_noEntry)
+        {
+            if (!node.entries.empty())
+            {
+                uint32_t last = static_cast<uint32_t>(node.entries.size() - 1);
+                push({ m_entries[node.entries[last]].score, top.node, last });
+            }
+            for (const auto& [c, child] : node.children)
+            {
+                if (m_nodes[child].best > 0)
+                    push({ m_nodes[child].best, child, c_noEntry });
+            }
+            continue;
+        }
+
+        if (top.position > 0)
+            push({ m_entries[node.entries[top.position - 1]].score, top.node, top.position - 1 });
+        const Entry& entry = m_entries[node.entries[top.position]];
+        // A URI with several tokens under the node comes up once for each
+        bool isFound = std::any_of(suggestions.begin(), suggestions.end(),
+            [&entry](const Suggestion& suggestion) { return suggestion.uri.data() == entry.uri.data(); });
+        if (!isFound && (isExact || Matches(entry.uri, match)))
+            suggestions.push_back({ entry.uri, entry.historyId, nullptr, nullptr, entry.score });
+    }
+
+    // Open tabs and favorites rank as if visited once more now, which lifts
+    // the ones found above the others and can bring in the rest. A URI both
+    // open and a favorite gets both.
+    auto addPages = [&](const std::vector<KnownPage>& pages, const KnownPage* Suggestion::*kind)
+    {
+        for (const KnownPage& page : pages)
+        {
+            auto it = std::find_if(suggestions.begin(), suggestions.end(),
+                [&page](const Suggestion& suggestion) { return suggestion.uri == page.uri; });
+            if (it != suggestions.end())
+            {
+                if ((*it).*kind == nullptr)
+                {
+                    (*it).*kind = &page;
+                    it->score += GetWeight(now);
+                }
+                continue;
+            }
+            if (!Matches(page.uri, match))
+                continue;
+            uint32_t id = FindEntry(page.uri);
+            Suggestion suggestion = { page.uri, 0, nullptr, nullptr, GetWeight(now) };
+            suggestion.*kind = &page;
+            if (id != c_noEntry)
+            {
+                suggestion.historyId = m_entries[id].historyId;
+                suggestion.score += m_entries[id].score;
+            }
+            suggestions.push_back(suggestion);
+        }
+    };
+    addPages(tabs, &Suggestion::tab);
+    addPages(favorites, &Suggestion::favorite);
+    std::stable_sort(suggestions.begin(), suggestions.end(),
+        [](const Suggestion& a, const Suggestion& b) { return a.score > b.score; });
+    if (suggestions.size() > count)
+        suggestions.resize(count);
+}
+
+std::wstring_view SuggestionIndex::TrimUri(std::wstring_view folded)
+{
+    size_t schemeEnd = 0;
+    while (schemeEnd < folded.size() && IsSchemeCharacter(folded[schemeEnd]))
+        ++schemeEnd;
+    if (schemeEnd > 0 && folded.substr(schemeEnd, 3) == L"://")
+        folded.remove_prefix(schemeEnd + 3);
+    if (StartsWith(folded, L"www."))
+        folded.remove_prefix(4);
+    return folded;
+}
+
+// One pass over the host and path, up to the query or fragment
+void SuggestionIndex::GetTokens(std::wstring_view trimmed, std::vector<std::wstring_view>& tokens)
+{
+    tokens.clear();
+    size_t start = 0;
+    size_t segments = 0;
+    bool hasLetter = false;
+    for (size_t i = 0; i <= trimmed.size(); ++i)
+    {
+        wchar_t c = i < trimmed.size() ? trimmed[i] : L'#';
+        if (c != L'/' && c != L'?' && c != L'#')
+        {
+            hasLetter = hasLetter || IsLetter(c);
+            continue;
+        }
+
+        std::wstring_view part = trimmed.substr(start, i - start);
+        if (start == 0 && !part.empty())
+        {
+            tokens.push_back(part);
+            // "example.com" of "news.example.com", not "com". Addresses
+            // have no domains.
+            for (size_t dot = part.find(L'.'); dot != std::wstring_view::npos && hasLetter; dot = part.find(L'.', dot + 1))
+            {
+                std::wstring_view parent = part.substr(dot + 1);
+                if (parent.find(L'.') == std::wstring_view::npos)
+                    break;
+                tokens.push_back(parent);
+            }
+        }
+        else if (start != 0 && !part.empty())
+        {
+            // Nobody types the ids in paths
+            if (hasLetter)
+                tokens.push_back(part);
+            if (++segments == c_maxSegments)
+                break;
+        }
+        if (c != L'/')
+            break;
+        start = i + 1;
+        hasLetter = false;
+    }
+}
+
+uint64_t SuggestionIndex::HashUri(std::wstring_view uri)
+{
+    return std::hash<std::wstring_view>()(uri);
+}
+
+uint32_t SuggestionIndex::FindEntry(std::wstring_view uri) const
+{
+    if (m_slots.empty())
+        return c_noEntry;
+    return m_slots[FindSlot(uri, HashUri(uri))];
+}
+
+size_t SuggestionIndex::FindSlot(std::wstring_view uri, uint64_t hash) const
+{
+    size_t mask = m_slots.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask)
+    {
+        uint32_t id = m_slots[slot];
+        if (id == c_noEntry || (id != c_removedEntry && m_entries[id].hash == hash && m_entries[id].uri == uri))
+            return slot;
+    }
+}
+
+// The table is kept at most half full, counting removed entries, and grows
+// to a quarter full when it gets there
+void SuggestionIndex::AddSlot(uint32_t id)
+{
+    if ((m_usedSlots + 1) * 2 > m_slots.size())
+    {
+        size_t size = 16;
+        while (size < (m_count + 1) * 4)
+            size *= 2;
+        m_slots.assign(size, c_noEntry);
+        m_usedSlots = 0;
+        for (uint32_t entry = 0; entry < m_entries.size(); ++entry)
+        {
+            if (entry != id && !m_entries[entry].uri.empty())
+            {
+                m_slots[FindSlot(m_entries[entry].uri, m_entries[entry].hash)] = entry;
+                ++m_usedSlots;
+            }
+        }
+    }
+    m_slots[FindSlot(m_entries[id].uri, m_entries[id].hash)] = id;
+    ++m_usedSlots;
+}
+
+bool SuggestionIndex::Matches(std::wstring_view uri, const Query& query)
+{
+    HistoryIndex::Fold(uri, m_folded);
+    std::wstring_view trimmed = TrimUri(m_folded);
+    if (query.isPrefix)
+        return StartsWith(trimmed, query.text);
+
+    GetTokens(trimmed, m_tokens);
+    return std::any_of(m_tokens.begin(), m_tokens.end(),
+        [&query](std::wstring_view token) { return StartsWith(token, query.text); });
+}
+
+uint32_t SuggestionIndex::FindNode(std::wstring_view token) const
+{
+    uint32_t node = 0;
+    for (wchar_t c : token)
+    {
+        const auto& children = m_nodes[node].children;
+        auto it = std::lower_bound(children.begin(), children.end(), c,
+            [](const std::pair<wchar_t, uint32_t>& child, wchar_t value) { return child.first < value; });
+        if (it == children.end() || it->first != c)
+            return c_noEntry;
+        node = it->second;
+    }
+    return node;
+}
+
+// A raised score moves the entry toward the end of its lists, which is where
+// a new visit usually puts it, and raises the best score of every node on
+// the way. A lowered one leaves those as they are, they still bound the
+// subtree.
+void SuggestionIndex::SetScore(uint32_t id, double score)
+{
+    double previous = m_entries[id].score;
+    HistoryIndex::Fold(m_entries[id].uri, m_folded);
+    GetTokens(TrimUri(m_folded), m_tokens);
+    for (std::wstring_view& token : m_tokens)
+        token = token.substr(0, c_maxTokenLength);
+    std::sort(m_tokens.begin(), m_tokens.end());
+    m_tokens.erase(std::unique(m_tokens.begin(), m_tokens.end()), m_tokens.end());
+
+    for (std::wstring_view token : m_tokens)
+    {
+        uint32_t node = 0;
+        m_path.assign(1, 0);
+        for (wchar_t c : token)
+        {
+            auto& children = m_nodes[node].children;
+            auto it = std::lower_bound(children.begin(), children.end(), c,
+                [](const std::pair<wchar_t, uint32_t>& child, wchar_t value) { return child.first < value; });
+            if (it != children.end() && it->first == c)
+            {
+                node = it->second;
+            }
+            else
+            {
+                uint32_t child = static_cast<uint32_t>(m_nodes.size());
+                children.insert(it, { c, child });
+                m_nodes.emplace_back();
+                node = child;
+            }
+            m_path.push_back(node);
+        }
+        for (uint32_t step : m_path)
+        {
+            Node& visited = m_nodes[step];
+            visited.best = std::max(visited.best, score);
+            if (previous == 0 && score > 0)
+                ++visited.count;
+            else if (previous > 0 && score == 0)
+                --visited.count;
+        }
+
+        // The entry still has its previous score, it's found by it
+        std::vector<uint32_t>& entries = m_nodes[node].entries;
+        auto before = [this](uint32_t other, const std::pair<double, uint32_t>& key) { return IsBefore(other, key.first, key.second); };
+        auto it = entries.end();
+        if (previous > 0)
+        {
+            it = std::lower_bound(entries.begin(), entries.end(), std::make_pair(previous, id), before);
+            if (it == entries.end() || *it != id)
+                continue;
+        }
+        if (score == 0)
+        {
+            entries.erase(it);
+        }
+        else if (previous == 0)
+        {
+            // Past the others, as the latest visit mostly is
+            if (entries.empty() || IsBefore(entries.back(), score, id))
+                entries.push_back(id);
+            else
+                entries.insert(std::lower_bound(entries.begin(), entries.end(), std::make_pair(score, id), before), id);
+        }
+        else if (score > previous)
+        {
+            std::rotate(it, it + 1, std::lower_bound(it + 1, entries.end(), std::make_pair(score, id), before));
+        }
+        else
+        {
+            auto to = std::lower_bound(entries.begin(), it, std::make_pair(score, id), before);
+            std::rotate(to, it, it + 1);
+        }
+    }
+    m_entries[id].score = score;
+}
+
+bool SuggestionIndex::IsBefore(uint32_t a, double score, uint32_t b) const
+{
+    double aScore = m_entries[a].score;
+    return aScore < score || (aScore == score && a < b);
+}
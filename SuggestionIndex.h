@@ -0,0 +1,120 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// What the address bar suggests as the user types: the visited URIs whose
+// host or a path segment starts with the text, best first by frecency. Each
+// visit adds a weight that halves every c_halfLife, so a site visited often
+// and lately ranks first. The weights are kept relative to a fixed time
+// instead of decaying, time passing doesn't reorder anything, and scores
+// only change when a URI is visited or its history removed.
+// Tokens are kept in a trie where every node knows the best score below it
+// and the URIs whose token ends there in score order, so the best matches
+// of a prefix are found by walking the best branches first, however many
+// URIs share it. Open tabs and favorites are few and each ranks as if
+// visited now, they're matched as the query comes.
+// Nothing in here depends on Windows headers.
+
+// Open in a tab, or kept as a favorite
+struct KnownPage
+{
+    std::wstring_view uri;
+    std::wstring_view titleJson;
+};
+
+struct Suggestion
+{
+    std::wstring_view uri;
+    uint64_t historyId = 0; // Of the latest visit still in the history, for its title
+    const KnownPage* tab = nullptr; // If the URI is open in one
+    const KnownPage* favorite = nullptr; // If the URI is one
+    double score = 0;
+};
+
+class SuggestionIndex
+{
+public:
+    static const int64_t c_halfLife = 30LL * 86400000; // ms
+    static const size_t c_maxTokenLength = 16; // Longer tokens are indexed by their start
+    static const size_t c_maxSegments = 4; // Of the path, indexed if they have a letter
+
+    // The weight of a visit at that time, in ms since 1970
+    static double GetWeight(int64_t timestamp);
+
+    // A visit that the history entry records. isNewEntry if the history
+    // added it for the visit rather than updating one.
+    void AddVisit(std::wstring_view uri, int64_t timestamp, uint64_t historyId, bool isNewEntry);
+    // The history entry is gone, and the URI once it has no entries left
+    void RemoveEntry(std::wstring_view uri, int64_t timestamp, uint64_t historyId);
+    void Clear();
+    size_t GetCount() const { return m_count; }
+    double GetScore(std::wstring_view uri) const;
+
+    // Up to count URIs that start with the query, or whose host or path
+    // segment does if it has no path, best first. Ignores case, the scheme
+    // and "www.".
+    void Find(std::wstring_view query, const std::vector<KnownPage>& tabs, const std::vector<KnownPage>& favorites,
+        int64_t now, size_t count, std::vector<Suggestion>& suggestions);
+
+private:
+    static constexpr uint32_t c_noEntry = UINT32_MAX;
+    static constexpr uint32_t c_removedEntry = UINT32_MAX - 1; // Its slot is taken until the table grows
+
+    struct Entry
+    {
+        std::wstring uri; // Empty once removed
+        uint64_t hash = 0;
+        double score = 0; // Sum of the weights of its visits
+        uint64_t historyId = 0;
+        size_t entryCount = 0; // Of the history
+    };
+
+    struct Node
+    {
+        std::vector<std::pair<wchar_t, uint32_t>> children; // Sorted by character
+        std::vector<uint32_t> entries; // Whose token ends here, by ascending score
+        double best = 0; // Of the subtree, never lowered until Clear
+        size_t count = 0; // Tokens in the subtree
+    };
+
+    // What a query is matched against
+    struct Query
+    {
+        std::wstring_view text; // Folded, without scheme and "www."
+        bool isPrefix = false; // Of the URI, the query has a path
+    };
+
+    // The URI without its scheme and "www.", folded already
+    static std::wstring_view TrimUri(std::wstring_view folded);
+    // Host, its parent domains and the first few path segments with a
+    // letter, whole
+    static void GetTokens(std::wstring_view trimmed, std::vector<std::wstring_view>& tokens);
+    static uint64_t HashUri(std::wstring_view uri);
+    uint32_t FindEntry(std::wstring_view uri) const;
+    // The slot of the URI, or the empty one it would take
+    size_t FindSlot(std::wstring_view uri, uint64_t hash) const;
+    void AddSlot(uint32_t id);
+    bool Matches(std::wstring_view uri, const Query& query);
+    uint32_t FindNode(std::wstring_view token) const;
+    // Moves the entry to its new score, or adds or removes it, in the lists
+    // of its tokens
+    void SetScore(uint32_t id, double score);
+    bool IsBefore(uint32_t a, double score, uint32_t b) const;
+
+    std::vector<Entry> m_entries;
+    size_t m_count = 0;
+    std::vector<uint32_t> m_slots; // Entries by HashUri, open addressing
+    size_t m_usedSlots = 0;
+    std::vector<Node> m_nodes = std::vector<Node>(1); // The root first
+    std::wstring m_folded; // Reused by SetScore and Matches
+    std::vector<std::wstring_view> m_tokens;
+    std::vector<uint32_t> m_path;
+};
@@ -4,14 +4,24 @@
 
 #include "BrowserWindow.h"
 #include "Tab.h"
-#include <tlhelp32.h>
 #include <Commctrl.h>
-#include "asyncutility.h"
+#include "TraceRecorder.h"
 
 using namespace Microsoft::WRL;
 
 Tab::Tab() : DevToolsState(DockState::DS_UNKNOWN) {}
 
+Tab::~Tab()
+{
+    // The holder's subclass points back at this tab, docked DevTools close
+    // with it
+    if (m_devtHolderHWnd != nullptr)
+    {
+        RemoveWindowSubclass(m_devtHolderHWnd, dtWndProcStatic, 1);
+        DestroyWindow(m_devtHolderHWnd);
+    }
+}
+
 LRESULT CALLBACK Tab::dtWndProcStatic(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam, UINT_PTR uIdSubclass, DWORD_PTR dwRefData)
 {
     if (Tab* tab = reinterpret_cast<Tab*>(dwRefData))
@@ -25,7 +35,7 @@ LRESULT CALLBACK Tab::dtWndProcStatic(HWND hWnd, UINT msg, WPARAM wParam, LPARAM
                 GetWindowRect(hWnd, &rc);
                 OffsetRect(&rc, -rc.left, -rc.top);
                 HDC hdc = GetWindowDC(hWnd);
-                auto hpen = CreatePen(PS_SOLID, tab->rzBorderSize, RGB(204, 204, 204));
+                auto hpen = CreatePen(PS_SOLID, DockLayoutSolver::c_borderSize, RGB(204, 204, 204));
                 auto oldpen = SelectObject(hdc, hpen);
                 SelectObject(hdc, GetStockObject(NULL_BRUSH));
                 // Draw a straight line that splits the webview and the dev tools window from each other
@@ -59,15 +69,15 @@ LRESULT CALLBACK Tab::dtWndProcStatic(HWND hWnd, UINT msg, WPARAM wParam, LPARAM
 
                     if (ds == DockState::DS_DOCK_RIGHT)
                     {
-                        sz->rgrc[0].left += tab->rzBorderSize/2;
-                        sz->rgrc[0].right += tab->rzBorderSize/2;
+                        sz->rgrc[0].left += DockLayoutSolver::c_borderSize/2;
+                        sz->rgrc[0].right += DockLayoutSolver::c_borderSize/2;
                     }
                     else if (ds == DockState::DS_DOCK_LEFT)
-                        sz->rgrc[0].right -= tab->rzBorderSize/2;
+                        sz->rgrc[0].right -= DockLayoutSolver::c_borderSize/2;
                     else if (ds == DockState::DS_DOCK_BOTTOM)
                     {
-                        sz->rgrc[0].bottom += tab->rzBorderSize/2;
-                        sz->rgrc[0].top += tab->rzBorderSize/2;
+                        sz->rgrc[0].bottom += DockLayoutSolver::c_borderSize/2;
+                        sz->rgrc[0].top += DockLayoutSolver::c_borderSize/2;
                     }
                 }
             }
@@ -87,6 +97,8 @@ LRESULT CALLBACK Tab::dtWndProcStatic(HWND hWnd, UINT msg, WPARAM wParam, LPARAM
                     case DockState::DS_DOCK_BOTTOM:
                         rightDirection = HTTOP;
                         break;
+                    default:
+                        break;
                 }
 
                 if (rightDirection != -10)
@@ -99,29 +111,28 @@ LRESULT CALLBACK Tab::dtWndProcStatic(HWND hWnd, UINT msg, WPARAM wParam, LPARAM
             break;
         case WM_SIZING:
             {
+                // Only the side facing the tab can be dragged
                 PRECT rectp = (PRECT)lParam;
-                tab->DockDataMap.at(ds)->nWidth = rectp->right - rectp->left;
-                tab->DockDataMap.at(ds)->nHeight = rectp->bottom - rectp->top;
-                switch (ds)
-                {
-                    case DockState::DS_DOCK_LEFT:
-                    case DockState::DS_DOCK_RIGHT:
-                        if (wParam == WMSZ_LEFT || wParam == WMSZ_RIGHT)
-                            tab->DockDataMap.at(ds)->nWidth -= tab->rzBorderSize;
-                        break;
-                    case DockState::DS_DOCK_BOTTOM:
-                        if (wParam == WMSZ_TOP)
-                            tab->DockDataMap.at(ds)->nHeight -= tab->rzBorderSize;
-                        break;
-                }
-
-                tab->ResizeWebView(true);
+                if ((ds == DockState::DS_DOCK_LEFT || ds == DockState::DS_DOCK_RIGHT) && (wParam == WMSZ_LEFT || wParam == WMSZ_RIGHT))
+                    tab->m_dockSizes[static_cast<int>(ds)] = rectp->right - rectp->left - DockLayoutSolver::c_borderSize;
+                else if (ds == DockState::DS_DOCK_BOTTOM && wParam == WMSZ_TOP)
+                    tab->m_dockSizes[static_cast<int>(ds)] = rectp->bottom - rectp->top - DockLayoutSolver::c_borderSize;
+
+                // Laid out once per frame however often the drag sends this
+                if (BrowserWindow* browserWindow = tab->GetBrowserWindow())
+                    browserWindow->ScheduleLayout();
             }
             break;
         case WM_ENTERSIZEMOVE:
+            tab->m_isDockSizing = true;
             if ((GetKeyState(VK_LBUTTON) & 0x8000) == 0) // Avoid further WM_ENTERSIZEMOVE
                 mouse_event(MOUSEEVENTF_LEFTUP, 0, 0, 0, 0);
             break;
+        case WM_EXITSIZEMOVE:
+            tab->m_isDockSizing = false;
+            if (BrowserWindow* browserWindow = tab->GetBrowserWindow())
+                browserWindow->ScheduleLayout();
+            break;
         case WM_DESTROY:
             RemoveWindowSubclass(hWnd, dtWndProcStatic, uIdSubclass);
             break;
@@ -129,158 +140,169 @@ LRESULT CALLBACK Tab::dtWndProcStatic(HWND hWnd, UINT msg, WPARAM wParam, LPARAM
     return DefSubclassProc(hWnd, msg, wParam, lParam);
 }
 
-BOOL CALLBACK Tab::EnumWindowsProcStatic(_In_ HWND hwnd, _In_ LPARAM lParam)
-{
-    if (Tab* tab = reinterpret_cast<Tab*>(lParam); tab != nullptr)
-        return tab->EnumWindowsProc(hwnd, reinterpret_cast<LPARAM>(tab->m_parentHWnd));
-    return FALSE;
-}
-
-BOOL CALLBACK Tab::EnumWindowsProc(_In_ HWND hwnd, _In_ LPARAM lParam)
-{
-    DWORD pid;
-    GetWindowThreadProcessId(hwnd, &pid);
-    WCHAR classname[256];
-	GetClassName(hwnd, classname, sizeof(classname));
-    if (wcscmp(classname, L"Chrome_WidgetWin_1") != 0 || GetParent(hwnd) != NULL && !(GetWindowLong(hwnd, GWL_STYLE) & WS_CHILD))
-        return TRUE;
-
-    if (possible_PID == pid)
-    {
-        if (BrowserWindow* bw = reinterpret_cast<BrowserWindow*>(GetWindowLongPtr(reinterpret_cast<HWND>(lParam), GWLP_USERDATA)); bw->CheckDTOwnership(hwnd))
-            return TRUE; // Skip, owned by other tab
-
-        m_devtHWnd = hwnd;
-        pid_DevTools = GetWindowThreadProcessId(hwnd, NULL);
-        DevToolsState = DockState::DS_UNDOCK;
-        return FALSE;
-    }
-    return TRUE;
-}
-
-std::unique_ptr<Tab> Tab::CreateNewTab(HWND hWnd, ICoreWebView2Environment* env, size_t id, bool shouldBeActive)
+std::unique_ptr<Tab> Tab::CreateNewTab(HWND hWnd, size_t id)
 {
     std::unique_ptr<Tab> tab = std::make_unique<Tab>();
 
     tab->m_parentHWnd = hWnd;
     tab->m_tabId = id;
     tab->SetMessageBroker();
-    tab->Init(env, shouldBeActive);
 
     return tab;
 }
 
-HRESULT Tab::Init(ICoreWebView2Environment* env, bool shouldBeActive)
+std::unique_ptr<Tab> Tab::CreateRestoredTab(HWND hWnd, size_t id, TabSnapshot snapshot, bool isDiscarded)
 {
+    std::unique_ptr<Tab> tab = CreateNewTab(hWnd, id);
+    tab->m_snapshot = std::move(snapshot);
+    tab->m_isDiscarded = isDiscarded;
+
+    return tab;
+}
+
+HRESULT Tab::Init(ICoreWebView2Environment* env, ICoreWebView2Controller* prewarmed, bool shouldBeActive)
+{
+    if (prewarmed != nullptr)
+    {
+        return Attach(prewarmed, shouldBeActive);
+    }
+
+    // The tab can be closed or re-created under its id before this completes
+    BrowserWindow* browserWindow = reinterpret_cast<BrowserWindow*>(GetWindowLongPtr(m_parentHWnd, GWLP_USERDATA));
+    SlotKey key = browserWindow->GetTabKey(m_tabId);
     return env->CreateCoreWebView2Controller(m_parentHWnd, Callback<ICoreWebView2CreateCoreWebView2ControllerCompletedHandler>(
-        [this, shouldBeActive](HRESULT result, ICoreWebView2Controller* host) -> HRESULT {
+        [browserWindow, key, shouldBeActive](HRESULT result, ICoreWebView2Controller* host) -> HRESULT {
         if (!SUCCEEDED(result))
         {
             OutputDebugString(L"Tab WebView creation failed\n");
             return result;
         }
-        m_contentController = host;
-        BrowserWindow::CheckFailure(m_contentController->get_CoreWebView2(&m_contentWebView), L"");
-        BrowserWindow* browserWindow = reinterpret_cast<BrowserWindow*>(GetWindowLongPtr(m_parentHWnd, GWLP_USERDATA));
-        RETURN_IF_FAILED(m_contentWebView->add_WebMessageReceived(m_messageBroker.Get(), &m_messageBrokerToken));
-
-        // Register event handler for history change
-        RETURN_IF_FAILED(m_contentWebView->add_HistoryChanged(Callback<ICoreWebView2HistoryChangedEventHandler>(
-            [this, browserWindow](ICoreWebView2* webview, IUnknown* args) -> HRESULT
-        {
-            BrowserWindow::CheckFailure(browserWindow->HandleTabHistoryUpdate(m_tabId, webview), L"Can't update go back/forward buttons.");
 
-            return S_OK;
-        }).Get(), &m_historyUpdateForwarderToken));
+        Tab* tab = browserWindow->FindTab(key);
+        if (tab == nullptr)
+            return host->Close();
 
-        // Register event handler for source change
-        RETURN_IF_FAILED(m_contentWebView->add_SourceChanged(Callback<ICoreWebView2SourceChangedEventHandler>(
-            [this, browserWindow](ICoreWebView2* webview, ICoreWebView2SourceChangedEventArgs* args) -> HRESULT
-        {
-            BrowserWindow::CheckFailure(browserWindow->HandleTabURIUpdate(m_tabId, webview), L"Can't update address bar");
+        ComPtr<ICoreWebView2> webview;
+        RETURN_IF_FAILED(host->get_CoreWebView2(&webview));
+        RETURN_IF_FAILED(PrepareWebView(webview.Get()));
+        return tab->Attach(host, shouldBeActive);
+    }).Get());
+}
 
-            return S_OK;
-        }).Get(), &m_uriUpdateForwarderToken));
+HRESULT Tab::PrepareWebView(ICoreWebView2* webview)
+{
+    // Enable listening for security events to update secure icon
+    RETURN_IF_FAILED(webview->CallDevToolsProtocolMethod(L"Security.enable", L"{}", nullptr));
 
-        RETURN_IF_FAILED(m_contentWebView->add_NavigationStarting(Callback<ICoreWebView2NavigationStartingEventHandler>(
-            [this, browserWindow](ICoreWebView2* webview, ICoreWebView2NavigationStartingEventArgs* args) -> HRESULT
-        {
-            BrowserWindow::CheckFailure(browserWindow->HandleTabNavStarting(m_tabId, webview), L"Can't update reload button");
+    // Reports title and favicon changes of every document in this tab
+    return webview->AddScriptToExecuteOnDocumentCreated(BrowserWindow::GetPageMetadataScript().c_str(), nullptr);
+}
 
-            return S_OK;
-        }).Get(), &m_navStartingToken));
+HRESULT Tab::Attach(ICoreWebView2Controller* controller, bool shouldBeActive)
+{
+    m_contentController = controller;
+    BrowserWindow::CheckFailure(m_contentController->get_CoreWebView2(&m_contentWebView), L"");
+    UINT32 processId = 0;
+    BrowserWindow::CheckFailure(m_contentWebView->get_BrowserProcessId(&processId), L"");
+    m_browserProcessId = processId;
+    RETURN_IF_FAILED(m_contentWebView->add_WebMessageReceived(m_messageBroker.Get(), &m_messageBrokerToken));
+
+    // The handlers find the window when they run, the tab can be moved to
+    // another one
+    // Register event handler for history change
+    RETURN_IF_FAILED(m_contentWebView->add_HistoryChanged(Callback<ICoreWebView2HistoryChangedEventHandler>(
+        [this](ICoreWebView2* webview, IUnknown* /*args*/) -> HRESULT
+    {
+        TraceScope trace("HistoryChanged", "tabId", m_tabId);
+        BrowserWindow::CheckFailure(GetBrowserWindow()->HandleTabHistoryUpdate(m_tabId, webview), L"Can't update go back/forward buttons.");
 
-        RETURN_IF_FAILED(m_contentWebView->add_NavigationCompleted(Callback<ICoreWebView2NavigationCompletedEventHandler>(
-            [this, browserWindow](ICoreWebView2* webview, ICoreWebView2NavigationCompletedEventArgs* args) -> HRESULT
-        {
-            BrowserWindow::CheckFailure(browserWindow->HandleTabNavCompleted(m_tabId, webview, args), L"Can't update reload button");
-            return S_OK;
-        }).Get(), &m_navCompletedToken));
+        return S_OK;
+    }).Get(), &m_historyUpdateForwarderToken));
 
-        // Enable listening for security events to update secure icon
-        RETURN_IF_FAILED(m_contentWebView->CallDevToolsProtocolMethod(L"Security.enable", L"{}", nullptr));
+    // Register event handler for source change
+    RETURN_IF_FAILED(m_contentWebView->add_SourceChanged(Callback<ICoreWebView2SourceChangedEventHandler>(
+        [this](ICoreWebView2* webview, ICoreWebView2SourceChangedEventArgs* /*args*/) -> HRESULT
+    {
+        TraceScope trace("SourceChanged", "tabId", m_tabId);
+        BrowserWindow::CheckFailure(GetBrowserWindow()->HandleTabURIUpdate(m_tabId, webview), L"Can't update address bar");
 
-        BrowserWindow::CheckFailure(m_contentWebView->GetDevToolsProtocolEventReceiver(L"Security.securityStateChanged", &m_securityStateChangedReceiver), L"");
+        return S_OK;
+    }).Get(), &m_uriUpdateForwarderToken));
 
-        // Forward security status updates to browser
-        RETURN_IF_FAILED(m_securityStateChangedReceiver->add_DevToolsProtocolEventReceived(Callback<ICoreWebView2DevToolsProtocolEventReceivedEventHandler>(
-            [this, browserWindow](ICoreWebView2* webview, ICoreWebView2DevToolsProtocolEventReceivedEventArgs* args) -> HRESULT
-        {
-            BrowserWindow::CheckFailure(browserWindow->HandleTabSecurityUpdate(m_tabId, webview, args), L"Can't update security icon");
-            return S_OK;
-        }).Get(), &m_securityUpdateToken));
-
-        RETURN_IF_FAILED(m_contentWebView->Navigate(L"https://www.bing.com"));
-        // Register a handler for the AcceleratorKeyPressed event.
-        RETURN_IF_FAILED(m_contentController->add_AcceleratorKeyPressed(Callback<ICoreWebView2AcceleratorKeyPressedEventHandler>(
-            [this](ICoreWebView2Controller* sender, ICoreWebView2AcceleratorKeyPressedEventArgs* args) -> HRESULT
-        {
-                COREWEBVIEW2_KEY_EVENT_KIND kind;
-                RETURN_IF_FAILED(args->get_KeyEventKind(&kind));
-                if (kind == COREWEBVIEW2_KEY_EVENT_KIND_KEY_DOWN)
+    RETURN_IF_FAILED(m_contentWebView->add_NavigationStarting(Callback<ICoreWebView2NavigationStartingEventHandler>(
+        [this](ICoreWebView2* webview, ICoreWebView2NavigationStartingEventArgs* /*args*/) -> HRESULT
+    {
+        TraceScope trace("NavigationStarting", "tabId", m_tabId);
+        BrowserWindow::CheckFailure(GetBrowserWindow()->HandleTabNavStarting(m_tabId, webview), L"Can't update reload button");
+
+        return S_OK;
+    }).Get(), &m_navStartingToken));
+
+    RETURN_IF_FAILED(m_contentWebView->add_NavigationCompleted(Callback<ICoreWebView2NavigationCompletedEventHandler>(
+        [this](ICoreWebView2* webview, ICoreWebView2NavigationCompletedEventArgs* args) -> HRESULT
+    {
+        TraceScope trace("NavigationCompleted", "tabId", m_tabId);
+        BrowserWindow::CheckFailure(GetBrowserWindow()->HandleTabNavCompleted(m_tabId, webview, args), L"Can't update reload button");
+        return S_OK;
+    }).Get(), &m_navCompletedToken));
+
+    BrowserWindow::CheckFailure(m_contentWebView->GetDevToolsProtocolEventReceiver(L"Security.securityStateChanged", &m_securityStateChangedReceiver), L"");
+
+    // Forward security status updates to browser
+    RETURN_IF_FAILED(m_securityStateChangedReceiver->add_DevToolsProtocolEventReceived(Callback<ICoreWebView2DevToolsProtocolEventReceivedEventHandler>(
+        [this](ICoreWebView2* webview, ICoreWebView2DevToolsProtocolEventReceivedEventArgs* args) -> HRESULT
+    {
+        TraceScope trace("SecurityStateChanged", "tabId", m_tabId);
+        BrowserWindow::CheckFailure(GetBrowserWindow()->HandleTabSecurityUpdate(m_tabId, webview, args), L"Can't update security icon");
+        return S_OK;
+    }).Get(), &m_securityUpdateToken));
+
+    RETURN_IF_FAILED(m_contentWebView->Navigate(m_snapshot.uri.empty() ? L"https://www.bing.com" : m_snapshot.uri.c_str()));
+    // Register a handler for the AcceleratorKeyPressed event.
+    RETURN_IF_FAILED(m_contentController->add_AcceleratorKeyPressed(Callback<ICoreWebView2AcceleratorKeyPressedEventHandler>(
+        [this](ICoreWebView2Controller* /*sender*/, ICoreWebView2AcceleratorKeyPressedEventArgs* args) -> HRESULT
+    {
+            COREWEBVIEW2_KEY_EVENT_KIND kind;
+            RETURN_IF_FAILED(args->get_KeyEventKind(&kind));
+            if (kind == COREWEBVIEW2_KEY_EVENT_KIND_KEY_DOWN)
+            {
+                UINT key;
+                RETURN_IF_FAILED(args->get_VirtualKey(&key));
+                if (key == 0x44) // "D"
                 {
-                    UINT key;
-                    RETURN_IF_FAILED(args->get_VirtualKey(&key));
-                    if (key == 0x44) // "D"
+                    m_HWnd = GetFocus();
+                    COREWEBVIEW2_PHYSICAL_KEY_STATUS status;
+                    RETURN_IF_FAILED(args->get_PhysicalKeyStatus(&status));
+                    if ((GetKeyState(VK_CONTROL) & 0x8000) && (GetKeyState(VK_SHIFT) & 0x8000)) // CTRL + SHIFT + D
                     {
-                        m_HWnd = GetFocus();
-                        COREWEBVIEW2_PHYSICAL_KEY_STATUS status;
-                        RETURN_IF_FAILED(args->get_PhysicalKeyStatus(&status));
-                        if ((GetKeyState(VK_CONTROL) & 0x8000) && (GetKeyState(VK_SHIFT) & 0x8000)) // CTRL + SHIFT + D
+                        RETURN_IF_FAILED(args->put_Handled(TRUE));
+
+                        // Once the key event returned to the browser process, which
+                        // owns the DevTools window. Nothing runs for a closed tab.
+                        GetBrowserWindow()->GetExecutor().Post([this]
                         {
-                            RETURN_IF_FAILED(args->put_Handled(TRUE));
-
-                            auto before = [this]
-                            {
-                                DockState state = GetDevToolsState();
-                                if (HWND hwnd = GetDevTools(); hwnd == nullptr && state == DockState::DS_UNKNOWN)
-                                    FindDevTools();
-                                return true;
-                            };
-
-                            auto after = [this]
-                            {
-                                DockState state = GetDevToolsState();
-                                if (HWND hwnd = GetDevTools(); hwnd != nullptr && state == DockState::DS_UNKNOWN)
-                                    state = DockState::DS_UNDOCK;
-
-                                if (state != DockState::DS_UNKNOWN)
-                                    DockDevTools(state != DockState::DS_AMOUNT+(-1) ? state+1 : DockState::DS_UNDOCK); // Determine the next dock position
-                            };
-
-                            // Perform the action asynchronously to avoid blocking the browser process's event queue.
-                            async_future<bool>(before, after);
-                        }
+                            DockState state = GetDevToolsState();
+                            if (HWND hwnd = GetDevTools(); hwnd == nullptr && state == DockState::DS_UNKNOWN)
+                                FindDevTools();
+
+                            // FindDevTools leaves a window it found undocked, it
+                            // only needs indexing. Registering again is a no-op.
+                            if (GetDevTools() != nullptr)
+                                GetBrowserWindow()->RegisterDevTools(m_tabId);
+
+                            if (state = GetDevToolsState(); state != DockState::DS_UNKNOWN)
+                                DockDevTools(state != DockState::DS_AMOUNT+(-1) ? state+1 : DockState::DS_UNDOCK); // Determine the next dock position
+                        }, m_cancellation.GetToken());
                     }
                 }
+            }
 
-            return S_OK;
-        }).Get(), &m_acceleratorKeyPressedToken));
+        return S_OK;
+    }).Get(), &m_acceleratorKeyPressedToken));
 
-        browserWindow->HandleTabCreated(m_tabId, shouldBeActive);
+    GetBrowserWindow()->HandleTabCreated(m_tabId, shouldBeActive);
 
-        return S_OK;
-    }).Get());
+    return S_OK;
 }
 
 void Tab::SetMessageBroker()
@@ -288,96 +310,127 @@ void Tab::SetMessageBroker()
     m_messageBroker = Callback<ICoreWebView2WebMessageReceivedEventHandler>(
         [this](ICoreWebView2* webview, ICoreWebView2WebMessageReceivedEventArgs* eventArgs) -> HRESULT
     {
-        BrowserWindow* browserWindow = reinterpret_cast<BrowserWindow*>(GetWindowLongPtr(m_parentHWnd, GWLP_USERDATA));
-        BrowserWindow::CheckFailure(browserWindow->HandleTabMessageReceived(m_tabId, webview, eventArgs), L"");
+        TraceScope trace("WebMessageReceived", "tabId", m_tabId);
+        BrowserWindow::CheckFailure(GetBrowserWindow()->HandleTabMessageReceived(m_tabId, webview, eventArgs), L"");
 
         return S_OK;
     });
 }
 
-HRESULT Tab::ResizeWebView(bool recalculate)
+HRESULT Tab::Suspend(ICoreWebView2TrySuspendCompletedHandler* handler)
 {
-    RECT bounds;
-    GetClientRect(m_parentHWnd, &bounds);
+    ComPtr<ICoreWebView2_3> webview;
+    RETURN_IF_FAILED(m_contentWebView.As(&webview));
+    return webview->TrySuspend(handler);
+}
 
-    BrowserWindow* browserWindow = reinterpret_cast<BrowserWindow*>(GetWindowLongPtr(m_parentHWnd, GWLP_USERDATA));
-    bounds.top += browserWindow->GetDPIAwareBound(BrowserWindow::c_uiBarHeight);
-    
-    CalculateDockData(bounds); // Calculate initial dock data 
+HRESULT Tab::Resume()
+{
+    ComPtr<ICoreWebView2_3> webview;
+    RETURN_IF_FAILED(m_contentWebView.As(&webview));
+    return webview->Resume();
+}
 
-    if (DockState ds = GetDevToolsState(); ds != DockState::DS_UNKNOWN)
-    {
-        RECT windowRect;
-        GetWindowRect(m_parentHWnd, &windowRect);
-        if (int bordersWidth = (windowRect.right - windowRect.left) - bounds.right; ds == DockState::DS_DOCK_RIGHT)
-        {
-            bounds.right = windowRect.right - windowRect.left - DockDataMap.at(ds)->nWidth - bordersWidth - rzBorderSize;
-            DockDataMap.at(ds)->X = bounds.right;
-            DockDataMap.at(ds)->nHeight = bounds.bottom - bounds.top;
-        }
-        else if (LONG old = bounds.left; ds == DockState::DS_DOCK_LEFT)
-        {
-            bounds.left += DockDataMap.at(ds)->nWidth + rzBorderSize;
-            DockDataMap.at(ds)->X = old;
-            DockDataMap.at(ds)->nHeight = bounds.bottom - bounds.top;
-        }
-        else if (ds == DockState::DS_DOCK_BOTTOM)
-        {
-            bounds.bottom -= DockDataMap.at(ds)->nHeight + rzBorderSize;
-            DockDataMap.at(ds)->Y = bounds.bottom;
-            DockDataMap.at(ds)->nWidth = bounds.right - bounds.left;
-        }
+HRESULT Tab::Discard()
+{
+    wil::unique_cotaskmem_string uri;
+    BOOL canGoBack = FALSE;
+    BOOL canGoForward = FALSE;
+    RETURN_IF_FAILED(m_contentWebView->get_Source(&uri));
+    RETURN_IF_FAILED(m_contentWebView->get_CanGoBack(&canGoBack));
+    RETURN_IF_FAILED(m_contentWebView->get_CanGoForward(&canGoForward));
+    m_snapshot.uri = uri.get();
+    m_snapshot.canGoBack = canGoBack;
+    m_snapshot.canGoForward = canGoForward;
+
+    // The event handlers go with the WebView
+    RETURN_IF_FAILED(m_contentController->Close());
+    m_securityStateChangedReceiver = nullptr;
+    m_contentWebView = nullptr;
+    m_contentController = nullptr;
+    m_isDiscarded = true;
+
+    return S_OK;
+}
 
-        if (!recalculate)
-            if (auto itr = DockDataMap.find(ds); itr != DockDataMap.end())
-            {
-                MoveWindow(m_devtHolderHWnd == nullptr ? m_devtHWnd : m_devtHolderHWnd, itr->second->X, itr->second->Y,
-                    itr->second->nWidth + (ds != DockState::DS_DOCK_BOTTOM ? rzBorderSize : 0),
-                    itr->second->nHeight + (ds == DockState::DS_DOCK_BOTTOM ? rzBorderSize : 0), true);
-                ShowWindow(m_devtHolderHWnd == nullptr ? m_devtHWnd : m_devtHolderHWnd, SW_SHOW);
-            }
+HRESULT Tab::Restore(ICoreWebView2Environment* env, ICoreWebView2Controller* prewarmed)
+{
+    m_isDiscarded = false;
+    return Init(env, prewarmed, false);
+}
 
-        if (ds != DockState::DS_UNDOCK)
-        {
-            // m_devtHWnd has borders so we have to take that into account
-            RECT rect[2];
-            GetClientRect(m_devtHWnd, &rect[0]);
-            GetWindowRect(m_devtHWnd, &rect[1]);
-            int dt_bordersWidth = rect[1].right - rect[1].left - rect[0].right;
-            int dt_bordersHeight = rect[1].bottom - rect[1].top - rect[0].bottom;
-
-            int titleBarHeight = GetSystemMetrics(SM_CYCAPTION) + GetSystemMetrics(SM_CYSIZEFRAME) + GetSystemMetrics(SM_CYEDGE) * 2;
-            // Below we hide the title bar and the borders of m_devtHWnd. Then we extend the height and the width to fill the gaps...
-            MoveWindow(m_devtHWnd, -dt_bordersWidth/2, -titleBarHeight,
-                DockDataMap.at(ds)->nWidth + dt_bordersWidth + (ds != DockState::DS_DOCK_BOTTOM ? rzBorderSize/2 : 0),
-                DockDataMap.at(ds)->nHeight + dt_bordersHeight + titleBarHeight + rzBorderSize/2, true);
-        }
+// Keeps the WebView and everything running in it, only the window hosting
+// the tab and its id there change
+HRESULT Tab::MoveTo(HWND hWnd, size_t id)
+{
+    if (m_contentController)
+    {
+        RETURN_IF_FAILED(m_contentController->put_ParentWindow(hWnd));
     }
+    if (m_devtHolderHWnd)
+    {
+        SetParent(m_devtHolderHWnd, hWnd);
+    }
+    m_parentHWnd = hWnd;
+    m_tabId = id;
+    return S_OK;
+}
 
-    return m_contentController->put_Bounds(bounds);
+BrowserWindow* Tab::GetBrowserWindow() const
+{
+    return reinterpret_cast<BrowserWindow*>(GetWindowLongPtr(m_parentHWnd, GWLP_USERDATA));
 }
 
-void Tab::FindDevTools() 
+void Tab::SetPageMetadata(std::wstring_view titleJson, std::wstring_view faviconJson)
 {
-    PROCESSENTRY32 pe32;
-    HANDLE h = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-    if (h == INVALID_HANDLE_VALUE)
-        return;
+    if (!titleJson.empty())
+        m_snapshot.titleJson.assign(titleJson);
+    if (!faviconJson.empty())
+        m_snapshot.faviconJson.assign(faviconJson);
+}
 
-    pe32.dwSize = sizeof(PROCESSENTRY32);
-    if (Process32First(h, &pe32))
+HRESULT Tab::ResizeWebView()
+{
+    // Being created or restored, it's sized once it's shown
+    if (m_contentController == nullptr)
+        return S_OK;
+
+    RECT client;
+    GetClientRect(m_parentHWnd, &client);
+    DockLayoutInput input;
+    input.clientWidth = client.right;
+    input.clientHeight = client.bottom;
+    input.state = GetDevToolsState();
+    input.dockSize = m_dockSizes[static_cast<int>(input.state)];
+    input.frameWidth = m_devtFrameWidth;
+    input.frameHeight = m_devtFrameHeight;
+    DockLayout layout = DockLayoutSolver::Solve(GetBrowserWindow()->GetLayoutMetrics(), input);
+
+    if (IsDocked(input.state))
     {
-        do
-        {
-            if (GetCurrentProcessId() == pe32.th32ParentProcessID) // PID of the parents must match
-            {
-                possible_PID = pe32.th32ProcessID;
-                if (EnumWindows(EnumWindowsProcStatic, reinterpret_cast<LPARAM>(this)) == FALSE)
-                    break;
-            }
-        } while (Process32Next(h, &pe32));
+        m_dockSizes[static_cast<int>(input.state)] = layout.dockSize;
+        // While the holder is dragged the system sizes it
+        if (m_devtHolderHWnd != nullptr && !m_isDockSizing)
+            SetWindowPos(m_devtHolderHWnd, nullptr, layout.holder.left, layout.holder.top, layout.holder.Width(),
+                layout.holder.Height(), SWP_NOZORDER | SWP_NOACTIVATE | SWP_SHOWWINDOW);
+        SetWindowPos(m_devtHWnd, nullptr, layout.devTools.left, layout.devTools.top, layout.devTools.Width(),
+            layout.devTools.Height(), SWP_NOZORDER | SWP_NOACTIVATE);
     }
-    CloseHandle(h);
+
+    return m_contentController->put_Bounds(ToRECT(layout.content));
+}
+
+void Tab::FindDevTools()
+{
+    // DevTools windows belong to the browser process. They're looked up in
+    // the index its window events keep, not by walking every window.
+    HWND hwnd = BrowserWindow::FindDevToolsWindow(m_browserProcessId);
+    if (hwnd == nullptr)
+        return;
+
+    m_devtHWnd = hwnd;
+    pid_DevTools = GetWindowThreadProcessId(hwnd, NULL);
+    DevToolsState = DockState::DS_UNDOCK;
 }
 
 HWND Tab::GetDevTools()
@@ -398,22 +451,28 @@ void Tab::DockDevTools(DockState state)
     if (state == DockState::DS_UNDOCK)
     {
         // Move the window back to it's original position
-        if (auto itr = DockDataMap.find(DevToolsState); itr != DockDataMap.end())
-            MoveWindow(m_devtHWnd, itr->second->X, itr->second->Y, itr->second->nWidth + rzBorderSize, itr->second->nHeight, true);
+        if (m_undockedRect)
+            MoveWindow(m_devtHWnd, m_undockedRect->left, m_undockedRect->top, m_undockedRect->right - m_undockedRect->left,
+                m_undockedRect->bottom - m_undockedRect->top, true);
         SetParent(m_devtHWnd, nullptr);
         //SetWindowLong(m_devtHWnd, GWL_STYLE, GetWindowLong(m_devtHWnd, GWL_STYLE) & ~WS_CHILD);
         DestroyWindow(m_devtHolderHWnd);
         m_devtHolderHWnd = nullptr;
         DevToolsState = DockState::DS_UNDOCK;
-        DockDataMap.erase(DockState::DS_UNDOCK);
+        m_undockedRect.reset();
     }
     else // DOCK
     {
-        if (state == DockState::DS_DOCK_RIGHT && DockDataMap.find(DockState::DS_UNDOCK) == DockDataMap.end())
+        if (!m_undockedRect)
         {
+            // The frame is hidden by the layout, it doesn't change while docked
             RECT undockedRect;
+            RECT clientRect;
             GetWindowRect(m_devtHWnd, &undockedRect);
-            DockDataMap.insert(std::make_pair(DockState::DS_UNDOCK, std::make_unique<DockData>(undockedRect.left, undockedRect.top, undockedRect.right - undockedRect.left, undockedRect.bottom - undockedRect.top)));
+            GetClientRect(m_devtHWnd, &clientRect);
+            m_undockedRect = undockedRect;
+            m_devtFrameWidth = undockedRect.right - undockedRect.left - clientRect.right;
+            m_devtFrameHeight = undockedRect.bottom - undockedRect.top - clientRect.bottom;
         }
 
         WNDCLASS wc = {};
@@ -451,33 +510,3 @@ DockState Tab::GetDevToolsState()
 
     return DevToolsState;
 }
-
-void Tab::CalculateDockData(RECT bounds)
-{
-    if (!DockDataMap.empty())
-        return;
-
-    DockDataMap.insert(std::make_pair(DockState::DS_DOCK_RIGHT, std::make_unique<DockData>(0,0,0,0)));
-    DockDataMap.insert(std::make_pair(DockState::DS_DOCK_LEFT, std::make_unique<DockData>(0,0,0,0)));
-    DockDataMap.insert(std::make_pair(DockState::DS_DOCK_BOTTOM, std::make_unique<DockData>(0,0,0,0)));
-    
-    for (auto i = DockDataMap.begin(); i != DockDataMap.end(); ++i)
-    {
-        i->second->X = int(round(DockRatioMap.at(i->first).XWidth * (i->first == DockState::DS_DOCK_RIGHT ? bounds.right : bounds.left)));
-
-        switch (BrowserWindow* browserWindow = reinterpret_cast<BrowserWindow*>(GetWindowLongPtr(m_parentHWnd, GWLP_USERDATA)); i->first)
-        {
-            case DockState::DS_DOCK_RIGHT:
-            case DockState::DS_DOCK_LEFT:
-                i->second->Y = int(round(DockRatioMap.at(i->first).YHeight * bounds.top));
-                i->second->nWidth = int(round(bounds.right - DockRatioMap.at(i->first).XWidth * bounds.right));
-                i->second->nHeight = int(round(DockRatioMap.at(i->first).YHeight * (bounds.bottom - bounds.top)));
-            break;
-            case DockState::DS_DOCK_BOTTOM:
-                i->second->Y = browserWindow->GetDPIAwareBound(BrowserWindow::c_uiBarHeight) + int(round(DockRatioMap.at(i->first).YHeight * (bounds.bottom - bounds.top)));
-                i->second->nWidth = int(round(DockRatioMap.at(i->first).XWidth * bounds.right - bounds.left));
-                i->second->nHeight = int(round((1.0f - DockRatioMap.at(i->first).YHeight) * (bounds.bottom - bounds.top)));
-            break;
-        }
-    }
-}
\ No newline at end of file
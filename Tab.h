@@ -4,64 +4,68 @@
 
 #pragma once
 
+#include <optional>
 #include "framework.h"
+#include "TaskExecutor.h"
+#include "DockLayout.h"
 
-enum class DockState: int
-{
-    DS_UNKNOWN, // No window or unable to locate
-    DS_UNDOCK,
-    DS_DOCK_RIGHT,
-    DS_DOCK_LEFT,
-    DS_DOCK_BOTTOM,
-    DS_AMOUNT
-};
+class BrowserWindow;
 
-struct DockRatio // Of Webview, not the dev tools
+inline RECT ToRECT(const LayoutRect& rect)
 {
-    double XWidth, YHeight; // Range: 0.0f > x >= 1.0f and 1.0f means FULL
-};
-
-struct HASH
-{
-    template <typename T>
-    std::size_t operator()(T t) const {
-        return static_cast<std::size_t>(t);
-    }
-};
-
-// Default window ratio which is used to calculate each DockData inside the DockDataMap
-// This way you set an initial position and dimension for each DockState
-// Below, the browser is made of 70% webview and what's left is dev tools which is 30%.
-const std::unordered_map<DockState, DockRatio, HASH> DockRatioMap =
-{
-    //DS_UNDOCK inherits everything after the window created automatically
-    {DockState::DS_DOCK_RIGHT, {0.7f, 1.0f}},
-    {DockState::DS_DOCK_LEFT, {0.7f, 1.0f}},
-    {DockState::DS_DOCK_BOTTOM, {1.0f, 0.7f}}
-};
+    return { rect.left, rect.top, rect.right, rect.bottom };
+}
 
-struct DockData
+// What a discarded tab keeps to be re-created when it's shown again. The
+// WebView's back/forward list can't be restored, only whether it had entries.
+struct TabSnapshot
 {
-    DockData(int _X, int _Y, int _nWidth, int _nHeight) : X(_X), Y(_Y), nWidth(_nWidth), nHeight(_nHeight) {}
-    int X, Y, nWidth, nHeight;
+    std::wstring uri;
+    std::wstring titleJson; // JSON strings, as posted by the page metadata script
+    std::wstring faviconJson;
+    bool canGoBack = false;
+    bool canGoForward = false;
 };
 
-static DockState operator+ (DockState const &d, int const &n) 
-{
-    return static_cast<DockState>(static_cast<int>(d)+n); 
-}
-
 class Tab
 {
 public:
     Tab();
+    ~Tab();
     Microsoft::WRL::ComPtr<ICoreWebView2Controller> m_contentController;
     Microsoft::WRL::ComPtr<ICoreWebView2> m_contentWebView;
     Microsoft::WRL::ComPtr<ICoreWebView2DevToolsProtocolEventReceiver> m_securityStateChangedReceiver;
 
-    static std::unique_ptr<Tab> CreateNewTab(HWND hWnd, ICoreWebView2Environment* env, size_t id, bool shouldBeActive);
-    HRESULT ResizeWebView(bool recalculate = false);
+    static std::unique_ptr<Tab> CreateNewTab(HWND hWnd, size_t id);
+    // A tab from a saved session, which Init or Restore load at its URI
+    static std::unique_ptr<Tab> CreateRestoredTab(HWND hWnd, size_t id, TabSnapshot snapshot, bool isDiscarded);
+    // Takes over a prewarmed controller if there's one, which skips the
+    // asynchronous creation, or creates a new one in env
+    HRESULT Init(ICoreWebView2Environment* env, ICoreWebView2Controller* prewarmed, bool shouldBeActive);
+    // What every tab WebView needs before its first navigation
+    static HRESULT PrepareWebView(ICoreWebView2* webview);
+    // Lays out the tab and its docked DevTools in the client area of its
+    // window, with the metrics the window keeps
+    HRESULT ResizeWebView();
+    // Suspend and Resume keep the WebView, Discard closes it and Restore
+    // creates a new one at the snapshot's URI
+    HRESULT Suspend(ICoreWebView2TrySuspendCompletedHandler* handler);
+    HRESULT Resume();
+    HRESULT Discard();
+    HRESULT Restore(ICoreWebView2Environment* env, ICoreWebView2Controller* prewarmed);
+    bool IsDiscarded() const { return m_isDiscarded; }
+    // Cancelled when the tab is closed, for work done on its behalf
+    CancellationToken GetCancellationToken() const { return m_cancellation.GetToken(); }
+    // Hands the tab to another browser window without re-creating it
+    HRESULT MoveTo(HWND hWnd, size_t id);
+    void SetPageMetadata(std::wstring_view titleJson, std::wstring_view faviconJson);
+    const TabSnapshot& GetSnapshot() const { return m_snapshot; }
+    // The history entry of the page shown, 0 if it isn't in the history
+    uint64_t GetHistoryId() const { return m_historyId; }
+    void SetHistoryId(uint64_t id) { m_historyId = id; }
+    // The caller indexes what it finds
     void FindDevTools();
+    DWORD GetBrowserProcessId() const { return m_browserProcessId; }
     HWND GetDevTools();
     HWND GetDevToolsHolder() { return m_devtHolderHWnd; }
     DockState GetDevToolsState();
@@ -81,19 +85,25 @@ protected:
     EventRegistrationToken m_messageBrokerToken = {};  // Message broker for browser pages loaded in a tab
     EventRegistrationToken m_acceleratorKeyPressedToken = {};
     Microsoft::WRL::ComPtr<ICoreWebView2WebMessageReceivedEventHandler> m_messageBroker;
+    TabSnapshot m_snapshot;
+    uint64_t m_historyId = 0;
+    bool m_isDiscarded = false;
+    CancellationSource m_cancellation;
 
-    HRESULT Init(ICoreWebView2Environment* env, bool shouldBeActive);
+    HRESULT Attach(ICoreWebView2Controller* controller, bool shouldBeActive);
     void SetMessageBroker();
+    // The window the tab is in now
+    BrowserWindow* GetBrowserWindow() const;
 private:
-    static BOOL CALLBACK EnumWindowsProcStatic(_In_ HWND hwnd, _In_ LPARAM lParam);
-    BOOL CALLBACK EnumWindowsProc(_In_ HWND hwnd, _In_ LPARAM lParam);
     static LRESULT CALLBACK dtWndProcStatic(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam, UINT_PTR uIdSubclass, DWORD_PTR dwRefData);
 
-    void CalculateDockData(RECT bounds);
     DockState DevToolsState;
-    DWORD possible_PID; // Possible PID of the DevTools
     DWORD pid_DevTools = 0;
-    int rzBorderSize = 4; // Border size of resizable side of m_devtHolderHWnd
+    DWORD m_browserProcessId = 0; // Known once attached
     std::tuple<RECT, bool> tplRect = {{0,0,0,0}, false}; // Default border rect of m_devtHolderHWnd
-    std::unordered_map<DockState, std::unique_ptr<DockData>, HASH> DockDataMap; // Current window dimensions
+    int m_dockSizes[static_cast<int>(DockState::DS_AMOUNT)] = {}; // Per dock state, 0 until first docked there
+    std::optional<RECT> m_undockedRect; // Where the DevTools go back to when undocked
+    int m_devtFrameWidth = 0; // Of m_devtHWnd, measured when docked
+    int m_devtFrameHeight = 0;
+    bool m_isDockSizing = false; // The holder is being dragged, the system sizes it
 };
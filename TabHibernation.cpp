@@ -0,0 +1,176 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "TabHibernation.h"
+#include <algorithm>
+
+const wchar_t* GetTabLifecycleName(TabLifecycle lifecycle)
+{
+    switch (lifecycle)
+    {
+    case TabLifecycle::Suspended:
+        return L"suspended";
+    case TabLifecycle::Discarded:
+        return L"discarded";
+    default:
+        return L"live";
+    }
+}
+
+void TabHibernation::AddTab(size_t tabId, uint64_t now)
+{
+    RemoveTab(tabId);
+    m_tabs.emplace(tabId, Entry{ tabId, now, TabLifecycle::Live });
+    Count(TabLifecycle::Live, true);
+}
+
+void TabHibernation::RemoveTab(size_t tabId)
+{
+    auto it = m_tabs.find(tabId);
+    if (it == m_tabs.end())
+        return;
+    Count(it->second.lifecycle, false);
+    m_tabs.erase(it);
+}
+
+void TabHibernation::Touch(size_t tabId, uint64_t now)
+{
+    auto it = m_tabs.find(tabId);
+    if (it != m_tabs.end())
+        it->second.lastActive = now;
+}
+
+void TabHibernation::SetLifecycle(size_t tabId, TabLifecycle lifecycle)
+{
+    auto it = m_tabs.find(tabId);
+    if (it == m_tabs.end())
+        return;
+    Count(it->second.lifecycle, false);
+    it->second.lifecycle = lifecycle;
+    Count(lifecycle, true);
+}
+
+TabLifecycle TabHibernation::GetLifecycle(size_t tabId) const
+{
+    auto it = m_tabs.find(tabId);
+    return it != m_tabs.end() ? it->second.lifecycle : TabLifecycle::Live;
+}
+
+void TabHibernation::Evaluate(uint64_t now, size_t activeTabId, std::vector<TabTransition>& transitions) const
+{
+    struct Candidate
+    {
+        const Entry* entry;
+        TabLifecycle lifecycle; // Planned
+    };
+
+    // Tabs that can still go down a tier, least recently used first
+    std::vector<Candidate> candidates;
+    for (const auto& [tabId, entry] : m_tabs)
+    {
+        if (tabId != activeTabId && entry.lifecycle != TabLifecycle::Discarded)
+            candidates.push_back({ &entry, entry.lifecycle });
+    }
+    // Ties go to the older id, the map's order isn't stable
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b)
+    {
+        return a.entry->lastActive != b.entry->lastActive ?
+            a.entry->lastActive < b.entry->lastActive : a.entry->tabId < b.entry->tabId;
+    });
+
+    uint64_t memory = GetMemory();
+    auto moveTo = [this, &memory](Candidate& candidate, TabLifecycle lifecycle)
+    {
+        uint64_t saved = GetCost(candidate.lifecycle) - GetCost(lifecycle);
+        memory = memory > saved ? memory - saved : 0;
+        candidate.lifecycle = lifecycle;
+    };
+
+    for (Candidate& candidate : candidates)
+    {
+        uint64_t idle = now - candidate.entry->lastActive;
+        if (m_policy.discardAfter != 0 && idle >= m_policy.discardAfter)
+            moveTo(candidate, TabLifecycle::Discarded);
+        else if (m_policy.suspendAfter != 0 && idle >= m_policy.suspendAfter && candidate.lifecycle == TabLifecycle::Live)
+            moveTo(candidate, TabLifecycle::Suspended);
+    }
+
+    for (Candidate& candidate : candidates)
+    {
+        if (m_policy.memoryBudget == 0 || memory <= m_policy.memoryBudget)
+            break;
+        if (candidate.lifecycle != TabLifecycle::Discarded)
+            moveTo(candidate, TabLifecycle::Discarded);
+    }
+
+    for (const Candidate& candidate : candidates)
+    {
+        if (candidate.lifecycle != candidate.entry->lifecycle)
+            transitions.push_back({ candidate.entry->tabId, candidate.lifecycle });
+    }
+}
+
+uint64_t TabHibernation::GetNextDeadline(size_t activeTabId) const
+{
+    uint64_t deadline = 0;
+    auto consider = [&deadline](uint64_t time)
+    {
+        if (deadline == 0 || time < deadline)
+            deadline = time;
+    };
+
+    for (const auto& [tabId, entry] : m_tabs)
+    {
+        if (tabId == activeTabId || entry.lifecycle == TabLifecycle::Discarded)
+            continue;
+        if (m_policy.suspendAfter != 0 && entry.lifecycle == TabLifecycle::Live)
+            consider(entry.lastActive + m_policy.suspendAfter);
+        if (m_policy.discardAfter != 0)
+            consider(entry.lastActive + m_policy.discardAfter);
+    }
+    return deadline;
+}
+
+uint64_t TabHibernation::GetEstimatedMemory() const
+{
+    return m_lifecycleCounts[static_cast<size_t>(TabLifecycle::Live)] * m_policy.liveTabCost +
+        m_lifecycleCounts[static_cast<size_t>(TabLifecycle::Suspended)] * m_policy.suspendedTabCost;
+}
+
+void TabHibernation::SetMeasuredMemory(uint64_t memory)
+{
+    m_isMeasured = true;
+    m_measuredMemory = memory;
+    m_estimateWhenMeasured = GetEstimatedMemory();
+}
+
+uint64_t TabHibernation::GetMemory() const
+{
+    uint64_t estimate = GetEstimatedMemory();
+    if (!m_isMeasured)
+        return estimate;
+    if (estimate >= m_estimateWhenMeasured)
+        return m_measuredMemory + (estimate - m_estimateWhenMeasured);
+    uint64_t freed = m_estimateWhenMeasured - estimate;
+    return m_measuredMemory > freed ? m_measuredMemory - freed : 0;
+}
+
+uint64_t TabHibernation::GetCost(TabLifecycle lifecycle) const
+{
+    switch (lifecycle)
+    {
+    case TabLifecycle::Live:
+        return m_policy.liveTabCost;
+    case TabLifecycle::Suspended:
+        return m_policy.suspendedTabCost;
+    default:
+        return 0;
+    }
+}
+
+void TabHibernation::Count(TabLifecycle lifecycle, bool added)
+{
+    size_t& count = m_lifecycleCounts[static_cast<size_t>(lifecycle)];
+    count = added ? count + 1 : count - 1;
+}
@@ -0,0 +1,95 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Decides which background tabs to hibernate. A tab idle in the background
+// past suspendAfter is suspended: its renderer stays but stops running and
+// trims its memory. Past discardAfter its WebView is closed and only a
+// snapshot is kept until the tab is shown again. On top of that, while the
+// estimated memory of all tabs is over the budget, the least recently used
+// tabs are discarded early. The runtime doesn't report memory per WebView,
+// so the estimate uses a fixed cost per live and per suspended tab. Once the
+// memory of the tab processes is measured, the costs only adjust the
+// measurement for lifecycle changes made since.
+// Nothing in here depends on Windows headers.
+
+enum class TabLifecycle : uint8_t
+{
+    Live,
+    Suspended,
+    Discarded
+};
+
+// As shown to the controls UI
+const wchar_t* GetTabLifecycleName(TabLifecycle lifecycle);
+
+struct TabHibernationPolicy
+{
+    uint64_t suspendAfter = 0; // ms in the background, 0 never
+    uint64_t discardAfter = 0; // ms in the background, 0 never
+    uint64_t memoryBudget = 0; // MB for all tabs, 0 for no budget
+    uint64_t liveTabCost = 100; // Estimated MB
+    uint64_t suspendedTabCost = 40;
+
+    bool IsEnabled() const { return suspendAfter != 0 || discardAfter != 0 || memoryBudget != 0; }
+};
+
+struct TabTransition
+{
+    size_t tabId;
+    TabLifecycle lifecycle;
+};
+
+class TabHibernation
+{
+public:
+    void SetPolicy(const TabHibernationPolicy& policy) { m_policy = policy; }
+    const TabHibernationPolicy& GetPolicy() const { return m_policy; }
+
+    // Times are in ms, from any monotonic clock
+    void AddTab(size_t tabId, uint64_t now);
+    void RemoveTab(size_t tabId);
+    // Restarts the idle time of a tab, when it's shown or hidden
+    void Touch(size_t tabId, uint64_t now);
+    void SetLifecycle(size_t tabId, TabLifecycle lifecycle);
+    TabLifecycle GetLifecycle(size_t tabId) const;
+
+    // Appends the transitions due now, least recently used tab first. The
+    // active tab is never hibernated. The caller applies them and reports
+    // back with SetLifecycle once they're done.
+    void Evaluate(uint64_t now, size_t activeTabId, std::vector<TabTransition>& transitions) const;
+    // When Evaluate will have something to do again without any tab being
+    // touched, or 0 if it won't
+    uint64_t GetNextDeadline(size_t activeTabId) const;
+    uint64_t GetEstimatedMemory() const;
+    // In MB, from the task sampler
+    void SetMeasuredMemory(uint64_t memory);
+    // What the budget is checked against, the estimate until it's measured
+    uint64_t GetMemory() const;
+
+private:
+    struct Entry
+    {
+        size_t tabId;
+        uint64_t lastActive;
+        TabLifecycle lifecycle;
+    };
+
+    uint64_t GetCost(TabLifecycle lifecycle) const;
+    void Count(TabLifecycle lifecycle, bool added);
+
+    TabHibernationPolicy m_policy;
+    std::unordered_map<size_t, Entry> m_tabs;
+    // Tabs in each lifecycle, so the estimate doesn't walk all of them
+    size_t m_lifecycleCounts[3] = {};
+    bool m_isMeasured = false;
+    uint64_t m_measuredMemory = 0;
+    uint64_t m_estimateWhenMeasured = 0;
+};
@@ -0,0 +1,138 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "TabRegistry.h"
+#include <algorithm>
+
+namespace
+{
+    const std::vector<size_t> c_noTabs;
+}
+
+std::unique_ptr<Tab> TabRegistry::Insert(size_t tabId, std::unique_ptr<Tab> tab)
+{
+    if (tabId == INVALID_TAB_ID)
+    {
+        OutputDebugString(L"Invalid tab id\n");
+        return tab;
+    }
+
+    std::unique_ptr<Tab> replaced = Remove(tabId);
+    Entry entry;
+    entry.tabId = tabId;
+    entry.tab = std::move(tab);
+    m_keys[tabId] = m_tabs.Insert(std::move(entry));
+    return replaced;
+}
+
+std::unique_ptr<Tab> TabRegistry::Remove(size_t tabId)
+{
+    Entry* entry = FindEntry(tabId);
+    if (entry == nullptr)
+        return nullptr;
+
+    ClearDevToolsWindow(*entry);
+    ClearBrowserProcessId(*entry);
+    std::unique_ptr<Tab> tab = std::move(entry->tab);
+    auto it = m_keys.find(tabId);
+    m_tabs.Remove(it->second);
+    m_keys.erase(it);
+    return tab;
+}
+
+Tab* TabRegistry::Find(size_t tabId) const
+{
+    return Find(GetKey(tabId));
+}
+
+Tab* TabRegistry::Find(SlotKey key) const
+{
+    const Entry* entry = m_tabs.Get(key);
+    return entry == nullptr ? nullptr : entry->tab.get();
+}
+
+SlotKey TabRegistry::GetKey(size_t tabId) const
+{
+    auto it = m_keys.find(tabId);
+    return it != m_keys.end() ? it->second : SlotKey();
+}
+
+Tab* TabRegistry::FindByDevToolsWindow(HWND hwnd) const
+{
+    auto it = m_devToolsWindows.find(hwnd);
+    return it == m_devToolsWindows.end() ? nullptr : Find(it->second);
+}
+
+void TabRegistry::SetDevToolsWindow(size_t tabId, HWND hwnd)
+{
+    Entry* entry = FindEntry(tabId);
+    if (entry == nullptr || entry->devTools == hwnd)
+        return;
+
+    ClearDevToolsWindow(*entry);
+    if (hwnd != nullptr)
+    {
+        // HWNDs are recycled, a window that took over a closed one's handle
+        // belongs to its new tab only
+        auto it = m_devToolsWindows.find(hwnd);
+        if (it != m_devToolsWindows.end())
+        {
+            if (Entry* previous = FindEntry(it->second))
+                previous->devTools = nullptr;
+            m_devToolsWindows.erase(it);
+        }
+        m_devToolsWindows.emplace(hwnd, tabId);
+    }
+    entry->devTools = hwnd;
+}
+
+const std::vector<size_t>& TabRegistry::GetTabsInProcess(DWORD processId) const
+{
+    auto it = m_processes.find(processId);
+    return it == m_processes.end() ? c_noTabs : it->second;
+}
+
+void TabRegistry::SetBrowserProcessId(size_t tabId, DWORD processId)
+{
+    Entry* entry = FindEntry(tabId);
+    if (entry == nullptr || entry->processId == processId)
+        return;
+
+    ClearBrowserProcessId(*entry);
+    if (processId != 0)
+        m_processes[processId].push_back(tabId);
+    entry->processId = processId;
+}
+
+TabRegistry::Entry* TabRegistry::FindEntry(size_t tabId)
+{
+    return m_tabs.Get(GetKey(tabId));
+}
+
+void TabRegistry::ClearDevToolsWindow(Entry& entry)
+{
+    if (entry.devTools != nullptr)
+    {
+        m_devToolsWindows.erase(entry.devTools);
+        entry.devTools = nullptr;
+    }
+}
+
+void TabRegistry::ClearBrowserProcessId(Entry& entry)
+{
+    if (entry.processId == 0)
+        return;
+
+    // Tabs of a window mostly share one process, so this is the only list
+    // that can get long; removal from it is linear but never nested
+    auto it = m_processes.find(entry.processId);
+    if (it != m_processes.end())
+    {
+        std::vector<size_t>& tabs = it->second;
+        tabs.erase(std::remove(tabs.begin(), tabs.end(), entry.tabId), tabs.end());
+        if (tabs.empty())
+            m_processes.erase(it);
+    }
+    entry.processId = 0;
+}
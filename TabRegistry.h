@@ -0,0 +1,65 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "framework.h"
+#include "SlotMap.h"
+#include "Tab.h"
+
+// The open tabs of a window. Tab ids, picked by the controls UI, map to slot
+// keys: looking a tab up is a hash lookup and an array read, and a key whose
+// tab was closed or re-created fails the generation check. Callbacks that
+// can outlive a tab keep its SlotKey rather than its id.
+// Also finds the tab that owns a DevTools window and the tabs hosted by a
+// browser process without visiting every tab.
+class TabRegistry
+{
+public:
+    // Replaces the tab registered under the same id, which is returned
+    std::unique_ptr<Tab> Insert(size_t tabId, std::unique_ptr<Tab> tab);
+    // nullptr if there's no such tab
+    std::unique_ptr<Tab> Remove(size_t tabId);
+
+    Tab* Find(size_t tabId) const;
+    Tab* Find(SlotKey key) const;
+    // An invalid key if there's no such tab
+    SlotKey GetKey(size_t tabId) const;
+    size_t Size() const { return m_tabs.Size(); }
+
+    // Tab whose DevTools window this is, if any
+    Tab* FindByDevToolsWindow(HWND hwnd) const;
+    void SetDevToolsWindow(size_t tabId, HWND hwnd);
+    // Tabs sharing a browser process. Empty for an unknown process.
+    const std::vector<size_t>& GetTabsInProcess(DWORD processId) const;
+    void SetBrowserProcessId(size_t tabId, DWORD processId);
+
+    // Every tab, in no particular order
+    template <typename F>
+    void ForEach(F&& fn) const
+    {
+        for (const Entry& entry : m_tabs)
+            fn(entry.tabId, entry.tab.get());
+    }
+
+private:
+    struct Entry
+    {
+        size_t tabId = INVALID_TAB_ID;
+        std::unique_ptr<Tab> tab;
+        HWND devTools = nullptr;
+        DWORD processId = 0;
+    };
+
+    Entry* FindEntry(size_t tabId);
+    void ClearDevToolsWindow(Entry& entry);
+    void ClearBrowserProcessId(Entry& entry);
+
+    SlotMap<Entry> m_tabs;
+    std::unordered_map<size_t, SlotKey> m_keys;
+    std::unordered_map<HWND, size_t> m_devToolsWindows;
+    std::unordered_map<DWORD, std::vector<size_t>> m_processes;
+};
@@ -0,0 +1,127 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "TaskExecutor.h"
+#include <algorithm>
+#include "TraceRecorder.h"
+
+TaskExecutor::TaskExecutor(size_t workerCount, Wake wake) : m_wake(std::move(wake))
+{
+    for (size_t i = 0; i < std::max<size_t>(workerCount, 1); ++i)
+        m_workers.emplace_back([this]() { RunWorker(); });
+}
+
+TaskExecutor::~TaskExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_isStopping = true;
+        m_work.clear();
+        m_continuations.clear();
+    }
+    m_workQueued.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+}
+
+void TaskExecutor::Run(std::function<void()> work, std::function<void()> then, CancellationToken token)
+{
+    Job job{ std::move(work), std::move(then), std::move(token), TraceRecorder::FlowStart("task") };
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_work.push_back(std::move(job));
+    }
+    m_workQueued.notify_one();
+}
+
+void TaskExecutor::Post(std::function<void()> then, CancellationToken token)
+{
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        wake = QueueContinuation(std::move(then), std::move(token));
+    }
+    if (wake)
+        m_wake();
+}
+
+size_t TaskExecutor::RunContinuations()
+{
+    std::deque<Job> continuations;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        continuations.swap(m_continuations);
+        m_isWakePending = false;
+    }
+
+    size_t count = 0;
+    for (Job& continuation : continuations)
+    {
+        if (continuation.token.IsCancelled())
+            continue;
+        TraceRecorder::FlowEnd("task", continuation.flow);
+        TraceScope trace("task continuation");
+        continuation.then();
+        ++count;
+    }
+    return count;
+}
+
+void TaskExecutor::WaitForWork()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_workDone.wait(lock, [this]() { return m_work.empty() && m_running == 0; });
+}
+
+bool TaskExecutor::HasContinuations() const
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    return !m_continuations.empty();
+}
+
+void TaskExecutor::RunWorker()
+{
+    TraceRecorder::SetThreadName("worker");
+    std::unique_lock<std::mutex> lock(m_lock);
+    for (;;)
+    {
+        m_workQueued.wait(lock, [this]() { return m_isStopping || !m_work.empty(); });
+        if (m_isStopping)
+            return;
+
+        Job job = std::move(m_work.front());
+        m_work.pop_front();
+        ++m_running;
+        lock.unlock();
+
+        if (!job.token.IsCancelled())
+        {
+            TraceRecorder::FlowEnd("task", job.flow);
+            TraceScope trace("task work");
+            job.work();
+        }
+
+        // The loop is woken before the work counts as done, so whoever
+        // waits for it finds the continuation queued
+        lock.lock();
+        if (!m_isStopping && job.then && !job.token.IsCancelled() &&
+            QueueContinuation(std::move(job.then), std::move(job.token)))
+        {
+            lock.unlock();
+            m_wake();
+            lock.lock();
+        }
+        --m_running;
+        if (m_work.empty() && m_running == 0)
+            m_workDone.notify_all();
+    }
+}
+
+bool TaskExecutor::QueueContinuation(std::function<void()> then, CancellationToken token)
+{
+    m_continuations.push_back(Job{ nullptr, std::move(then), std::move(token), TraceRecorder::FlowStart("task") });
+    bool wake = !m_isWakePending;
+    m_isWakePending = true;
+    return wake;
+}
@@ -0,0 +1,112 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs blocking work on a few worker threads and hands the results back to
+// the UI thread. Continuations are queued and only run when the UI thread
+// drains the queue from its message loop, so they can use everything the
+// UI thread owns. The wake callback, which can run on any thread, is how
+// the message loop learns there's something to drain.
+// Work and continuations whose token was cancelled are skipped: a tab
+// cancels its source when it goes away, so nothing runs for a closed tab.
+// Nothing in here depends on Windows headers.
+
+class CancellationToken
+{
+public:
+    // Never cancelled
+    CancellationToken() = default;
+
+    bool IsCancelled() const { return m_cancelled && m_cancelled->load(std::memory_order_acquire); }
+
+private:
+    friend class CancellationSource;
+    explicit CancellationToken(std::shared_ptr<const std::atomic<bool>> cancelled) : m_cancelled(std::move(cancelled)) {}
+
+    std::shared_ptr<const std::atomic<bool>> m_cancelled;
+};
+
+// Cancelled at the latest when destroyed
+class CancellationSource
+{
+public:
+    CancellationSource() : m_cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+    ~CancellationSource() { Cancel(); }
+    CancellationSource(const CancellationSource&) = delete;
+    CancellationSource& operator=(const CancellationSource&) = delete;
+
+    void Cancel() { m_cancelled->store(true, std::memory_order_release); }
+    CancellationToken GetToken() const { return CancellationToken(m_cancelled); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
+};
+
+class TaskExecutor
+{
+public:
+    using Wake = std::function<void()>;
+
+    TaskExecutor(size_t workerCount, Wake wake);
+    // Drops the work and continuations still queued, waits for the work
+    // already running
+    ~TaskExecutor();
+    TaskExecutor(const TaskExecutor&) = delete;
+    TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+    // work runs on a worker, then on the UI thread once it's done
+    void Run(std::function<void()> work, std::function<void()> then, CancellationToken token = {});
+    // Same, then gets what work returned. Run<T>(...)
+    template <typename T>
+    void Run(std::function<T()> work, std::function<void(T& result)> then, CancellationToken token = {})
+    {
+        auto result = std::make_shared<T>();
+        Run([work = std::move(work), result]() { *result = work(); },
+            [then = std::move(then), result]() { then(*result); }, std::move(token));
+    }
+    // then runs on the UI thread the next time the queue is drained
+    void Post(std::function<void()> then, CancellationToken token = {});
+
+    // UI thread. Runs the continuations queued so far, the ones they queue
+    // wake the loop again. Returns how many ran.
+    size_t RunContinuations();
+    // Blocks until no work is queued or running, continuations may be left.
+    // For the headless tools and tests, the UI never waits.
+    void WaitForWork();
+    bool HasContinuations() const;
+
+private:
+    struct Job
+    {
+        std::function<void()> work;
+        std::function<void()> then;
+        CancellationToken token;
+        uint64_t flow = 0;
+    };
+
+    void RunWorker();
+    // Called with m_lock held, returns whether to wake the loop
+    bool QueueContinuation(std::function<void()> then, CancellationToken token);
+
+    Wake m_wake;
+    mutable std::mutex m_lock;
+    std::condition_variable m_workQueued;
+    std::condition_variable m_workDone;
+    std::deque<Job> m_work;
+    std::deque<Job> m_continuations;
+    size_t m_running = 0;
+    bool m_isWakePending = false;
+    bool m_isStopping = false;
+    std::vector<std::thread> m_workers;
+};
@@ -0,0 +1,79 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "TaskSampler.h"
+
+void TaskSampler::AddTab(size_t tabId)
+{
+    m_tabs[tabId] = History();
+}
+
+void TaskSampler::RemoveTab(size_t tabId)
+{
+    m_tabs.erase(tabId);
+}
+
+void TaskSampler::AddNavigation(size_t tabId)
+{
+    auto it = m_tabs.find(tabId);
+    if (it != m_tabs.end())
+        ++it->second.navigations;
+}
+
+void TaskSampler::Record(size_t tabId, uint64_t time, uint32_t processId, uint64_t workingSet, uint64_t cpuTime)
+{
+    auto it = m_tabs.find(tabId);
+    if (it == m_tabs.end())
+        return;
+
+    History& history = it->second;
+    history.samples[history.next] = { time, processId, workingSet, cpuTime, history.navigations };
+    history.next = (history.next + 1) % c_sampleCount;
+    if (history.count < c_sampleCount)
+        ++history.count;
+}
+
+const TaskSample* TaskSampler::GetLatest(size_t tabId) const
+{
+    auto it = m_tabs.find(tabId);
+    return it != m_tabs.end() && it->second.count != 0 ? &GetSample(it->second, 0) : nullptr;
+}
+
+size_t TaskSampler::GetSampleCount(size_t tabId) const
+{
+    auto it = m_tabs.find(tabId);
+    return it != m_tabs.end() ? it->second.count : 0;
+}
+
+uint64_t TaskSampler::GetCpuUsage(size_t tabId) const
+{
+    auto it = m_tabs.find(tabId);
+    if (it == m_tabs.end() || it->second.count < 2)
+        return 0;
+
+    // A tab whose process was replaced only counts the new one
+    const History& history = it->second;
+    const TaskSample& latest = GetSample(history, 0);
+    const TaskSample* oldest = &latest;
+    for (size_t age = 1; age < history.count && GetSample(history, age).processId == latest.processId; ++age)
+        oldest = &GetSample(history, age);
+
+    if (latest.time <= oldest->time || latest.cpuTime <= oldest->cpuTime)
+        return 0;
+    // us of CPU per ms is permille
+    return (latest.cpuTime - oldest->cpuTime) / (latest.time - oldest->time);
+}
+
+uint64_t TaskSampler::GetRecentNavigations(size_t tabId) const
+{
+    auto it = m_tabs.find(tabId);
+    if (it == m_tabs.end() || it->second.count < 2)
+        return 0;
+    return GetSample(it->second, 0).navigations - GetSample(it->second, 1).navigations;
+}
+
+const TaskSample& TaskSampler::GetSample(const History& history, size_t age)
+{
+    return history.samples[(history.next + c_sampleCount - 1 - age) % c_sampleCount];
+}
@@ -0,0 +1,69 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// The resources each tab used over its last c_sampleCount samples, shown on
+// browser://tasks. The runtime doesn't tell which renderer a WebView runs
+// in, so a tab is charged with the process it reports, its browser process,
+// and tabs sharing one show the same counters. Navigations are the tab's own.
+// Nothing in here depends on Windows headers.
+
+struct TaskSample
+{
+    uint64_t time = 0; // ms, from any monotonic clock
+    uint32_t processId = 0;
+    uint64_t workingSet = 0; // Bytes
+    uint64_t cpuTime = 0; // us the process ran for since it started
+    uint64_t navigations = 0; // Since the tab was added
+};
+
+class TaskSampler
+{
+public:
+    static const size_t c_sampleCount = 32;
+
+    void AddTab(size_t tabId);
+    void RemoveTab(size_t tabId);
+    void AddNavigation(size_t tabId);
+    // Once the ring is full the oldest sample is dropped
+    void Record(size_t tabId, uint64_t time, uint32_t processId, uint64_t workingSet, uint64_t cpuTime);
+
+    // nullptr until the tab is sampled
+    const TaskSample* GetLatest(size_t tabId) const;
+    size_t GetSampleCount(size_t tabId) const;
+    // Over the samples kept from the same process, in permille of one core
+    uint64_t GetCpuUsage(size_t tabId) const;
+    // Between the two latest samples, 0 until there are two
+    uint64_t GetRecentNavigations(size_t tabId) const;
+
+    // fn(tabId, latest) for every tab sampled at least once
+    template <typename F>
+    void ForEach(F&& fn) const
+    {
+        for (const auto& [tabId, history] : m_tabs)
+        {
+            if (history.count != 0)
+                fn(tabId, GetSample(history, 0));
+        }
+    }
+
+private:
+    struct History
+    {
+        TaskSample samples[c_sampleCount];
+        size_t next = 0; // Slot the next sample goes in
+        size_t count = 0;
+        uint64_t navigations = 0;
+    };
+
+    // age 0 is the latest sample, count - 1 the oldest
+    static const TaskSample& GetSample(const History& history, size_t age);
+
+    std::unordered_map<size_t, History> m_tabs;
+};
@@ -0,0 +1,250 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "TraceRecorder.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> TraceRecorder::s_enabled = false;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct TraceEvent
+    {
+        const char* name;
+        const char* argName;
+        int64_t arg;
+        uint64_t id;
+        int64_t timestamp; // ns since the recorder was started
+        char phase;
+    };
+
+    // Single producer (the owning thread), single consumer (Flush, under
+    // the registry lock). Events are dropped while the buffer is full.
+    struct ThreadBuffer
+    {
+        static constexpr uint32_t c_capacity = 1 << 15;
+
+        uint32_t threadId = 0;
+        const char* name = nullptr;
+        std::atomic<uint32_t> head = 0;
+        std::atomic<uint32_t> tail = 0;
+        std::atomic<uint32_t> dropped = 0;
+        TraceEvent events[c_capacity];
+    };
+
+    // Buffers are never freed, a thread may record after its last flush
+    std::mutex g_registryLock;
+    std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+    std::atomic<uint64_t> g_nextFlowId = 1;
+    std::atomic<Clock::rep> g_origin = 0;
+
+    thread_local ThreadBuffer* t_buffer = nullptr;
+    thread_local const char* t_threadName = nullptr;
+
+    ThreadBuffer* GetThreadBuffer()
+    {
+        if (t_buffer == nullptr)
+        {
+            auto buffer = std::make_unique<ThreadBuffer>();
+            buffer->name = t_threadName;
+
+            std::lock_guard<std::mutex> lock(g_registryLock);
+            buffer->threadId = static_cast<uint32_t>(g_buffers.size() + 1);
+            t_buffer = buffer.get();
+            g_buffers.push_back(std::move(buffer));
+        }
+        return t_buffer;
+    }
+
+    void Record(char phase, const char* name, const char* argName = nullptr, int64_t arg = 0, uint64_t id = 0)
+    {
+        ThreadBuffer* buffer = GetThreadBuffer();
+        uint32_t head = buffer->head.load(std::memory_order_relaxed);
+        if (head - buffer->tail.load(std::memory_order_acquire) >= ThreadBuffer::c_capacity)
+        {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        auto now = Clock::now().time_since_epoch().count() - g_origin.load(std::memory_order_relaxed);
+        TraceEvent& event = buffer->events[head % ThreadBuffer::c_capacity];
+        event.name = name;
+        event.argName = argName;
+        event.arg = arg;
+        event.id = id;
+        event.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::duration(now)).count();
+        event.phase = phase;
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+
+    void AppendNumber(std::string& out, int64_t value)
+    {
+        out.append(std::to_string(value));
+    }
+
+    // Trace timestamps are in microseconds
+    void AppendTimestamp(std::string& out, int64_t ns)
+    {
+        if (ns < 0)
+        {
+            out.push_back('-');
+            ns = -ns;
+        }
+        AppendNumber(out, ns / 1000);
+        out.push_back('.');
+        int64_t fraction = ns % 1000;
+        out.push_back(static_cast<char>('0' + fraction / 100));
+        out.push_back(static_cast<char>('0' + fraction / 10 % 10));
+        out.push_back(static_cast<char>('0' + fraction % 10));
+    }
+
+    void AppendEvent(std::string& out, const TraceEvent& event, uint32_t processId, uint32_t threadId)
+    {
+        out.append("{\"ph\":\"");
+        out.push_back(event.phase);
+        out.append("\",\"pid\":");
+        AppendNumber(out, processId);
+        out.append(",\"tid\":");
+        AppendNumber(out, threadId);
+        out.append(",\"ts\":");
+        AppendTimestamp(out, event.timestamp);
+        if (event.name != nullptr)
+        {
+            out.append(",\"cat\":\"host\",\"name\":\"");
+            out.append(event.name);
+            out.push_back('"');
+        }
+        if (event.phase == 's' || event.phase == 'f')
+        {
+            out.append(",\"id\":");
+            AppendNumber(out, static_cast<int64_t>(event.id));
+            if (event.phase == 'f')
+                out.append(",\"bp\":\"e\"");
+        }
+        if (event.argName != nullptr)
+        {
+            out.append(",\"args\":{\"");
+            out.append(event.argName);
+            out.append("\":");
+            AppendNumber(out, event.arg);
+            out.push_back('}');
+        }
+        out.push_back('}');
+    }
+}
+
+void TraceRecorder::Start()
+{
+    {
+        std::lock_guard<std::mutex> lock(g_registryLock);
+        for (auto& buffer : g_buffers)
+        {
+            buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_release);
+            buffer->dropped.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    g_origin.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    s_enabled.store(true, std::memory_order_relaxed);
+}
+
+void TraceRecorder::Stop()
+{
+    s_enabled.store(false, std::memory_order_relaxed);
+}
+
+void TraceRecorder::Begin(const char* name, const char* argName, int64_t arg)
+{
+    Record('B', name, argName, arg);
+}
+
+void TraceRecorder::End()
+{
+    Record('E', nullptr);
+}
+
+uint64_t TraceRecorder::FlowStart(const char* name)
+{
+    if (!IsEnabled())
+        return 0;
+
+    uint64_t id = g_nextFlowId.fetch_add(1, std::memory_order_relaxed);
+    Record('s', name, nullptr, 0, id);
+    return id;
+}
+
+void TraceRecorder::FlowEnd(const char* name, uint64_t id)
+{
+    if (id != 0)
+        Record('f', name, nullptr, 0, id);
+}
+
+void TraceRecorder::SetThreadName(const char* name)
+{
+    t_threadName = name;
+    if (t_buffer != nullptr)
+        t_buffer->name = name;
+}
+
+void TraceRecorder::Flush(std::string& out, uint32_t processId)
+{
+    out.append("{\"traceEvents\":[");
+    bool first = true;
+    auto separate = [&out, &first]()
+    {
+        if (!first)
+            out.append(",\n");
+        first = false;
+    };
+
+    std::lock_guard<std::mutex> lock(g_registryLock);
+    for (auto& buffer : g_buffers)
+    {
+        uint32_t tail = buffer->tail.load(std::memory_order_relaxed);
+        uint32_t head = buffer->head.load(std::memory_order_acquire);
+        if (head == tail)
+            continue;
+
+        separate();
+        out.append("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":");
+        AppendNumber(out, processId);
+        out.append(",\"tid\":");
+        AppendNumber(out, buffer->threadId);
+        out.append(",\"args\":{\"name\":\"");
+        if (buffer->name != nullptr)
+        {
+            out.append(buffer->name);
+        }
+        else
+        {
+            out.append("Thread ");
+            AppendNumber(out, buffer->threadId);
+        }
+        out.append("\"}}");
+
+        for (uint32_t i = tail; i != head; ++i)
+        {
+            separate();
+            AppendEvent(out, buffer->events[i % ThreadBuffer::c_capacity], processId, buffer->threadId);
+        }
+
+        // Events are dropped once the buffer is full, mark where that was
+        uint32_t dropped = buffer->dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped != 0)
+        {
+            separate();
+            TraceEvent marker = { "Dropped events", "count", dropped, 0,
+                buffer->events[(head - 1) % ThreadBuffer::c_capacity].timestamp, 'i' };
+            AppendEvent(out, marker, processId, buffer->threadId);
+        }
+        buffer->tail.store(head, std::memory_order_release);
+    }
+
+    out.append("],\"displayTimeUnit\":\"ms\"}");
+}
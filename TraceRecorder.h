@@ -0,0 +1,67 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Opt-in recorder for host event handlers. Spans are written to a buffer
+// owned by the recording thread without taking locks, and Flush converts
+// everything recorded so far to the Chrome trace-event JSON format, which
+// loads in chrome://tracing or ui.perfetto.dev. Flow events link the work a
+// handler starts (a script, a task on a worker) to where it completes.
+// Nothing in here depends on Windows headers.
+//
+// Names must be string literals, only the pointers are stored.
+class TraceRecorder
+{
+public:
+    static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // Start drops anything recorded before
+    static void Start();
+    static void Stop();
+
+    static void Begin(const char* name, const char* argName = nullptr, int64_t arg = 0);
+    static void End();
+
+    // FlowStart returns 0 when tracing is off, FlowEnd ignores id 0
+    static uint64_t FlowStart(const char* name);
+    static void FlowEnd(const char* name, uint64_t id);
+
+    // Shown in the trace viewer instead of the thread number
+    static void SetThreadName(const char* name);
+
+    // Appends {"traceEvents": [...]} to out and empties the buffers
+    static void Flush(std::string& out, uint32_t processId);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+// Records a span from construction to destruction when tracing is on
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name, const char* argName = nullptr, int64_t arg = 0) :
+        m_active(TraceRecorder::IsEnabled())
+    {
+        if (m_active)
+            TraceRecorder::Begin(name, argName, arg);
+    }
+
+    ~TraceScope()
+    {
+        if (m_active)
+            TraceRecorder::End();
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    bool m_active;
+};
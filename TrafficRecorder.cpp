@@ -0,0 +1,111 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "TrafficRecorder.h"
+#include "ByteCodec.h"
+
+namespace
+{
+    const uint8_t c_magic[] = { 'W', 'T' };
+    const uint8_t c_version = 1;
+    const uint8_t c_postedFlag = 0x80;
+}
+
+void TrafficRecorder::Start()
+{
+    m_log.clear();
+    m_recordCount = 0;
+    m_lastTime = 0;
+    m_start = Clock::now();
+    m_enabled = true;
+}
+
+void TrafficRecorder::Stop()
+{
+    m_enabled = false;
+}
+
+void TrafficRecorder::Record(bool posted, TrafficEndpoint endpoint, size_t tabId, std::wstring_view json)
+{
+    if (!m_enabled)
+        return;
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - m_start);
+    Write(static_cast<uint64_t>(elapsed.count()), posted, endpoint, tabId, json);
+}
+
+void TrafficRecorder::Append(const TrafficRecord& record)
+{
+    Write(record.time, record.posted, record.endpoint, record.tabId, record.json);
+}
+
+void TrafficRecorder::Write(uint64_t time, bool posted, TrafficEndpoint endpoint, size_t tabId, std::wstring_view json)
+{
+    if (m_log.empty())
+    {
+        m_log.assign(std::begin(c_magic), std::end(c_magic));
+        m_log.push_back(c_version);
+    }
+
+    // The clock is monotonic, this only guards appended records
+    if (time < m_lastTime)
+        time = m_lastTime;
+    AppendVarint(m_log, time - m_lastTime);
+    m_lastTime = time;
+
+    m_log.push_back(static_cast<uint8_t>(endpoint) | (posted ? c_postedFlag : 0));
+    AppendVarint(m_log, tabId);
+
+    m_payload.clear();
+    AppendUtf8(m_payload, json);
+    AppendVarint(m_log, m_payload.size());
+    m_log.insert(m_log.end(), m_payload.begin(), m_payload.end());
+
+    ++m_recordCount;
+}
+
+std::vector<uint8_t> TrafficRecorder::TakeLog()
+{
+    std::vector<uint8_t> log;
+    log.swap(m_log);
+    m_recordCount = 0;
+    m_lastTime = 0;
+    return log;
+}
+
+bool TrafficRecorder::ReadLog(const std::vector<uint8_t>& log, std::vector<TrafficRecord>& records)
+{
+    records.clear();
+    if (log.size() < sizeof(c_magic) + 1 || log[0] != c_magic[0] || log[1] != c_magic[1] || log[2] != c_version)
+        return false;
+
+    size_t position = sizeof(c_magic) + 1;
+    uint64_t time = 0;
+    while (position < log.size())
+    {
+        TrafficRecord record;
+        uint64_t delta = 0;
+        uint64_t tabId = 0;
+        uint64_t length = 0;
+        if (!ReadVarint(log, position, delta) || position >= log.size())
+            return false;
+
+        uint8_t flags = log[position++];
+        if ((flags & ~c_postedFlag) > static_cast<uint8_t>(TrafficEndpoint::Tab))
+            return false;
+        if (!ReadVarint(log, position, tabId) || !ReadVarint(log, position, length) || length > log.size() - position)
+            return false;
+        if (!DecodeUtf8(log.data() + position, static_cast<size_t>(length), record.json))
+            return false;
+        position += static_cast<size_t>(length);
+
+        time += delta;
+        record.time = time;
+        record.posted = (flags & c_postedFlag) != 0;
+        record.endpoint = static_cast<TrafficEndpoint>(flags & ~c_postedFlag);
+        record.tabId = static_cast<size_t>(tabId);
+        records.push_back(std::move(record));
+    }
+    return true;
+}
@@ -0,0 +1,67 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Opt-in log of every web message crossing the host bridge, for replaying
+// real sessions through the broker (see mockhost/TrafficReplay.cpp). Each
+// record is a varint time delta in microseconds, a byte with the direction
+// and endpoint, a varint tab id and the length prefixed UTF-8 payload,
+// after a "WT" magic and a version byte. Everything runs on the UI thread.
+// Nothing in here depends on Windows headers.
+
+enum class TrafficEndpoint : uint8_t
+{
+    Controls = 0,
+    Options = 1,
+    Tab = 2
+};
+
+struct TrafficRecord
+{
+    uint64_t time = 0; // us since recording started
+    bool posted = false; // By the host, otherwise received from the page
+    TrafficEndpoint endpoint = TrafficEndpoint::Controls;
+    size_t tabId = 0; // Only set for TrafficEndpoint::Tab
+    std::wstring json;
+};
+
+class TrafficRecorder
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    bool IsEnabled() const { return m_enabled; }
+
+    // Start drops anything recorded before
+    void Start();
+    void Stop();
+
+    void Record(bool posted, TrafficEndpoint endpoint, size_t tabId, std::wstring_view json);
+    // Adds a record with its own time, which can't be before the last one.
+    // Works whether or not the recorder is started, to write synthetic logs.
+    void Append(const TrafficRecord& record);
+
+    size_t GetRecordCount() const { return m_recordCount; }
+    // Returns the log and empties it
+    std::vector<uint8_t> TakeLog();
+
+    static bool ReadLog(const std::vector<uint8_t>& log, std::vector<TrafficRecord>& records);
+
+private:
+    void Write(uint64_t time, bool posted, TrafficEndpoint endpoint, size_t tabId, std::wstring_view json);
+
+    bool m_enabled = false;
+    Clock::time_point m_start;
+    uint64_t m_lastTime = 0;
+    size_t m_recordCount = 0;
+    std::vector<uint8_t> m_log;
+    std::vector<uint8_t> m_payload; // Reused to encode each payload
+};
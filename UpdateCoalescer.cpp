@@ -0,0 +1,202 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "UpdateCoalescer.h"
+#include <algorithm>
+#include <utility>
+
+UpdateCoalescer::PendingUpdate& UpdateCoalescer::GetPendingUpdate(size_t tabId, bool& first)
+{
+    first = m_pendingCount == 0;
+
+    // Only the tabs that changed since the last flush are here, even during
+    // bulk loads that's a short array and a linear scan beats hashing
+    for (size_t i = 0; i < m_pendingCount; ++i)
+    {
+        if (m_pending[i].tabId == tabId)
+            return m_pending[i];
+    }
+
+    if (m_pendingCount == m_pending.size())
+        m_pending.emplace_back();
+
+    PendingUpdate& update = m_pending[m_pendingCount++];
+    update.tabId = tabId;
+    update.fields = 0;
+    return update;
+}
+
+bool UpdateCoalescer::Add(const UpdateUriMessage& message)
+{
+    bool first;
+    PendingUpdate& update = GetPendingUpdate(message.tabId, first);
+
+    update.fields |= FieldUri;
+    update.uri.assign(message.uri);
+    update.uriToShow.assign(message.uriToShow);
+    if (message.canGoForward && message.canGoBack)
+    {
+        update.fields |= FieldHistory;
+        update.canGoForward = *message.canGoForward;
+        update.canGoBack = *message.canGoBack;
+    }
+    if (message.isFavorite)
+    {
+        update.fields |= FieldFavorite;
+        update.isFavorite = *message.isFavorite;
+    }
+    return first;
+}
+
+bool UpdateCoalescer::Add(const NavStartingMessage& message)
+{
+    bool first;
+    PendingUpdate& update = GetPendingUpdate(message.tabId, first);
+
+    update.fields |= FieldLoading;
+    update.fields &= ~FieldNavResult; // Belongs to the previous navigation
+    update.isLoading = true;
+    return first;
+}
+
+bool UpdateCoalescer::Add(const NavCompletedMessage& message)
+{
+    bool first;
+    PendingUpdate& update = GetPendingUpdate(message.tabId, first);
+
+    update.fields |= FieldLoading;
+    update.isLoading = false;
+    if (message.isError)
+    {
+        update.fields |= FieldNavResult;
+        update.isError = *message.isError;
+    }
+    return first;
+}
+
+bool UpdateCoalescer::Add(const UpdateTabMessage& message)
+{
+    bool first;
+    PendingUpdate& update = GetPendingUpdate(message.tabId, first);
+
+    update.fields |= FieldTitle;
+    update.titleJson.assign(message.title);
+    return first;
+}
+
+bool UpdateCoalescer::Add(const UpdateFaviconMessage& message)
+{
+    bool first;
+    PendingUpdate& update = GetPendingUpdate(message.tabId, first);
+
+    update.fields |= FieldFavicon;
+    update.faviconJson.assign(message.uri);
+    return first;
+}
+
+bool UpdateCoalescer::Add(const SecurityUpdateMessage& message)
+{
+    bool first;
+    PendingUpdate& update = GetPendingUpdate(message.tabId, first);
+
+    update.fields |= FieldSecurity;
+    update.securityState.assign(message.state);
+    return first;
+}
+
+bool UpdateCoalescer::Add(const TabLifecycleMessage& message)
+{
+    bool first;
+    PendingUpdate& update = GetPendingUpdate(message.tabId, first);
+
+    update.fields |= FieldLifecycle;
+    update.lifecycle.assign(message.lifecycle);
+    return first;
+}
+
+void UpdateCoalescer::RemoveTab(size_t tabId)
+{
+    for (size_t i = 0; i < m_pendingCount; ++i)
+    {
+        if (m_pending[i].tabId == tabId)
+        {
+            // Keep the pending entries packed at the front and in arrival
+            // order, the removed one keeps its capacity past the end
+            std::rotate(m_pending.begin() + i, m_pending.begin() + i + 1, m_pending.begin() + m_pendingCount);
+            --m_pendingCount;
+            return;
+        }
+    }
+}
+
+void UpdateCoalescer::Flush(JsonWriter& writer, size_t priorityTabId, size_t maxUpdates)
+{
+    writer.BeginMessage(MG_BATCH);
+    writer.BeginArray(FieldName<&BatchArgs::updates>::value);
+    for (size_t i = 0; i < m_pendingCount; ++i)
+    {
+        if (m_pending[i].tabId == priorityTabId)
+        {
+            WriteUpdate(writer, m_pending[i]);
+            break;
+        }
+    }
+
+    // Whatever doesn't fit moves to the front, still in arrival order
+    size_t written = 0;
+    size_t kept = 0;
+    for (size_t i = 0; i < m_pendingCount; ++i)
+    {
+        if (m_pending[i].tabId == priorityTabId)
+            continue;
+
+        if (written < maxUpdates)
+        {
+            WriteUpdate(writer, m_pending[i]);
+            ++written;
+        }
+        else
+        {
+            std::swap(m_pending[kept++], m_pending[i]);
+        }
+    }
+    writer.EndArray();
+    writer.EndMessage();
+
+    m_pendingCount = kept;
+}
+
+void UpdateCoalescer::WriteUpdate(JsonWriter& writer, const PendingUpdate& update)
+{
+    TabUpdateArgs args;
+    args.tabId = update.tabId;
+    if (update.fields & FieldUri)
+    {
+        args.uri = update.uri;
+        args.uriToShow = update.uriToShow;
+    }
+    if (update.fields & FieldHistory)
+    {
+        args.canGoForward = update.canGoForward;
+        args.canGoBack = update.canGoBack;
+    }
+    if (update.fields & FieldFavorite)
+        args.isFavorite = update.isFavorite;
+    if (update.fields & FieldLoading)
+        args.isLoading = update.isLoading;
+    if (update.fields & FieldNavResult)
+        args.isError = update.isError;
+    if (update.fields & FieldTitle)
+        args.title = update.titleJson;
+    if (update.fields & FieldFavicon)
+        args.favicon = update.faviconJson;
+    if (update.fields & FieldSecurity)
+        args.state = update.securityState;
+    if (update.fields & FieldLifecycle)
+        args.lifecycle = update.lifecycle;
+
+    writer.BeginObject();
+    EncodeFields(writer, args);
+    writer.EndObject();
+}
@@ -0,0 +1,76 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MessageSchema.h"
+
+// Collects the tab state updates meant for the controls UI and merges them
+// per tab, so a navigation costs one MG_BATCH message per frame instead of
+// one message per event. Later updates of a field overwrite earlier ones,
+// so a background tab that waits for its turn only sends its latest state.
+class UpdateCoalescer
+{
+public:
+    // Each Add returns true when it queued the first pending update, which is
+    // the caller's cue to schedule a flush.
+    bool Add(const UpdateUriMessage& update);
+    bool Add(const NavStartingMessage& update);
+    bool Add(const NavCompletedMessage& update);
+    bool Add(const UpdateTabMessage& update);
+    bool Add(const UpdateFaviconMessage& update);
+    bool Add(const SecurityUpdateMessage& update);
+    bool Add(const TabLifecycleMessage& update);
+
+    // Drops anything pending for a tab that is going away
+    void RemoveTab(size_t tabId);
+    bool IsEmpty() const { return m_pendingCount == 0; }
+
+    // Encodes pending updates as a single MG_BATCH message and clears them.
+    // The priority tab (the active one) goes first and always fits, other
+    // tabs follow in the order they changed, at most maxUpdates of them.
+    // Updates that didn't fit stay queued for the next flush.
+    void Flush(JsonWriter& writer, size_t priorityTabId, size_t maxUpdates);
+
+private:
+    enum Field : uint32_t
+    {
+        FieldUri = 1 << 0,          // uri and uriToShow
+        FieldHistory = 1 << 1,      // canGoForward and canGoBack
+        FieldLoading = 1 << 2,      // isLoading
+        FieldNavResult = 1 << 3,    // isError
+        FieldTitle = 1 << 4,
+        FieldFavicon = 1 << 5,
+        FieldSecurity = 1 << 6,
+        FieldLifecycle = 1 << 7,
+        FieldFavorite = 1 << 8      // isFavorite
+    };
+
+    // Entries are kept around after a flush so their strings keep capacity
+    struct PendingUpdate
+    {
+        size_t tabId = INVALID_TAB_ID;
+        uint32_t fields = 0;
+        std::wstring uri;
+        std::wstring uriToShow;
+        std::wstring titleJson;
+        std::wstring faviconJson;
+        std::wstring securityState;
+        std::wstring lifecycle;
+        bool canGoForward = false;
+        bool canGoBack = false;
+        bool isFavorite = false;
+        bool isLoading = false;
+        bool isError = false;
+    };
+
+    PendingUpdate& GetPendingUpdate(size_t tabId, bool& first);
+    static void WriteUpdate(JsonWriter& writer, const PendingUpdate& update);
+
+    std::vector<PendingUpdate> m_pending;
+    size_t m_pendingCount = 0;
+};
@@ -7,6 +7,7 @@
 
 #include "BrowserWindow.h"
 #include "WebViewBrowserApp.h"
+#include "TraceRecorder.h"
 
 using namespace Microsoft::WRL;
 
@@ -24,6 +25,7 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     // below 1703 (Windows 10).
     SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
 
+    TraceRecorder::SetThreadName("UI");
     BrowserWindow::RegisterClass(hInstance);
 
     tryLaunchWindow(hInstance, nCmdShow);
@@ -0,0 +1,58 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Generated from messages.json by tools/generate_messages.py. Do not edit.
+
+#pragma once
+
+#define INVALID_TAB_ID 0
+
+// Message codes shared with the browser UI
+enum MessageId : int
+{
+    MG_NAVIGATE = 1,
+    MG_UPDATE_URI = 2,
+    MG_GO_FORWARD = 3,
+    MG_GO_BACK = 4,
+    MG_NAV_STARTING = 5,
+    MG_NAV_COMPLETED = 6,
+    MG_RELOAD = 7,
+    MG_CANCEL = 8,
+    MG_CREATE_TAB = 10,
+    MG_UPDATE_TAB = 11,
+    MG_SWITCH_TAB = 12,
+    MG_CLOSE_TAB = 13,
+    MG_CLOSE_WINDOW = 14,
+    MG_SHOW_OPTIONS = 15,
+    MG_HIDE_OPTIONS = 16,
+    MG_OPTIONS_LOST_FOCUS = 17,
+    MG_OPTION_SELECTED = 18,
+    MG_SECURITY_UPDATE = 19,
+    MG_UPDATE_FAVICON = 20,
+    MG_GET_SETTINGS = 21,
+    MG_GET_FAVORITES = 22,
+    MG_REMOVE_FAVORITE = 23,
+    MG_CLEAR_CACHE = 24,
+    MG_CLEAR_COOKIES = 25,
+    MG_GET_HISTORY = 26,
+    MG_REMOVE_HISTORY_ITEM = 27,
+    MG_CLEAR_HISTORY = 28,
+    MG_BATCH = 29,
+    MG_GET_METRICS = 30,
+    MG_DUMP_METRICS = 31,
+    MG_SET_TRACING = 32,
+    MG_PAGE_METADATA = 33,
+    MG_SET_RECORDING = 34,
+    MG_SET_TAB_POLICY = 35,
+    MG_TAB_LIFECYCLE = 36,
+    MG_RESTORE_SESSION = 37,
+    MG_GET_TASKS = 38,
+    MG_MOVE_TAB = 39,
+    MG_SEARCH_HISTORY = 40,
+    MG_GET_SUGGESTIONS = 41,
+    MG_ADD_FAVORITE = 42,
+    MG_MIGRATE_FAVORITES = 43
+};
+
+constexpr int c_maxMessageId = 43;
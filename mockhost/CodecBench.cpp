@@ -0,0 +1,515 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// CodecBench.cpp : Compares the message codec with the document based JSON
+// handling the host used before it, for the traffic of many tabs reporting
+// navigations: throughput and heap allocations per message, for decoding
+// what the pages post and for encoding what the host posts back.
+//
+// cpprest isn't available outside the Windows build, so the previous path is
+// reproduced by DomValue below the way the host used web::json: parse into a
+// tree of objects with owned strings, look members up by key, build replies
+// from parse(L"{}") with operator[] and serialize them through a string
+// stream after passing the value by copy.
+//
+// codec_bench [--tabs N] [--rounds N]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <utility>
+#include <vector>
+#include "MessageSchema.h"
+
+namespace
+{
+    size_t g_allocations = 0;
+}
+
+void* operator new(size_t size)
+{
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    // Just enough of web::json::value for the host's use of it
+    class DomValue
+    {
+    public:
+        enum class Type { Null, Bool, Number, String, Object, Array };
+
+        DomValue() = default;
+        explicit DomValue(double number) : m_type(Type::Number), m_number(number) {}
+        explicit DomValue(bool flag) : m_type(Type::Bool), m_bool(flag) {}
+        explicit DomValue(std::wstring text) : m_type(Type::String), m_string(std::move(text)) {}
+
+        static DomValue Parse(const std::wstring& text)
+        {
+            size_t position = 0;
+            return ParseValue(text, position);
+        }
+
+        DomValue& operator[](const std::wstring& key)
+        {
+            m_type = Type::Object;
+            for (auto& member : m_members)
+            {
+                if (member.first == key)
+                    return member.second;
+            }
+            m_members.emplace_back(key, DomValue());
+            return m_members.back().second;
+        }
+
+        const DomValue& At(const std::wstring& key) const
+        {
+            for (const auto& member : m_members)
+            {
+                if (member.first == key)
+                    return member.second;
+            }
+            throw std::out_of_range("key");
+        }
+
+        bool HasField(const std::wstring& key) const
+        {
+            for (const auto& member : m_members)
+            {
+                if (member.first == key)
+                    return true;
+            }
+            return false;
+        }
+
+        std::wstring AsString() const { return m_string; }
+        double AsNumber() const { return m_number; }
+
+        void Serialize(std::wostream& stream) const
+        {
+            switch (m_type)
+            {
+            case Type::Null: stream << L"null"; break;
+            case Type::Bool: stream << (m_bool ? L"true" : L"false"); break;
+            case Type::Number: stream << m_number; break;
+            case Type::String: SerializeString(stream, m_string); break;
+            case Type::Array:
+            case Type::Object:
+            {
+                bool isObject = m_type == Type::Object;
+                stream << (isObject ? L'{' : L'[');
+                for (size_t i = 0; i < m_members.size(); ++i)
+                {
+                    if (i != 0)
+                        stream << L',';
+                    if (isObject)
+                    {
+                        SerializeString(stream, m_members[i].first);
+                        stream << L':';
+                    }
+                    m_members[i].second.Serialize(stream);
+                }
+                stream << (isObject ? L'}' : L']');
+            }
+            break;
+            }
+        }
+
+    private:
+        static void SerializeString(std::wostream& stream, const std::wstring& text)
+        {
+            stream << L'"';
+            for (wchar_t c : text)
+            {
+                if (c == L'"' || c == L'\\')
+                    stream << L'\\' << c;
+                else if (c == L'\n')
+                    stream << L"\\n";
+                else
+                    stream << c;
+            }
+            stream << L'"';
+        }
+
+        static void SkipWhitespace(const std::wstring& text, size_t& position)
+        {
+            while (position < text.size() && iswspace(text[position]))
+                ++position;
+        }
+
+        static std::wstring ParseString(const std::wstring& text, size_t& position)
+        {
+            std::wstring value;
+            for (++position; position < text.size() && text[position] != L'"'; ++position)
+            {
+                if (text[position] == L'\\')
+                {
+                    wchar_t escaped = text[++position];
+                    if (escaped == L'u')
+                    {
+                        value.push_back(static_cast<wchar_t>(std::wcstol(text.substr(position + 1, 4).c_str(), nullptr, 16)));
+                        position += 4;
+                    }
+                    else
+                    {
+                        value.push_back(escaped == L'n' ? L'\n' : escaped == L't' ? L'\t' : escaped);
+                    }
+                }
+                else
+                {
+                    value.push_back(text[position]);
+                }
+            }
+            ++position;
+            return value;
+        }
+
+        static DomValue ParseValue(const std::wstring& text, size_t& position)
+        {
+            SkipWhitespace(text, position);
+            wchar_t c = text[position];
+            if (c == L'{' || c == L'[')
+            {
+                DomValue container;
+                container.m_type = c == L'{' ? Type::Object : Type::Array;
+                ++position;
+                SkipWhitespace(text, position);
+                while (text[position] != L'}' && text[position] != L']')
+                {
+                    std::wstring key;
+                    if (container.m_type == Type::Object)
+                    {
+                        key = ParseString(text, position);
+                        SkipWhitespace(text, position);
+                        ++position; // ':'
+                    }
+                    DomValue member = ParseValue(text, position);
+                    container.m_members.emplace_back(std::move(key), std::move(member));
+                    SkipWhitespace(text, position);
+                    if (text[position] == L',')
+                        ++position;
+                    SkipWhitespace(text, position);
+                }
+                ++position;
+                return container;
+            }
+            if (c == L'"')
+                return DomValue(ParseString(text, position));
+            if (text.compare(position, 4, L"true") == 0 || text.compare(position, 5, L"false") == 0)
+            {
+                position += c == L't' ? 4 : 5;
+                return DomValue(c == L't');
+            }
+            if (text.compare(position, 4, L"null") == 0)
+            {
+                position += 4;
+                return DomValue();
+            }
+            wchar_t* end = nullptr;
+            double number = std::wcstod(text.c_str() + position, &end);
+            position = end - text.c_str();
+            return DomValue(number);
+        }
+
+        Type m_type = Type::Null;
+        bool m_bool = false;
+        double m_number = 0;
+        std::wstring m_string;
+        std::vector<std::pair<std::wstring, DomValue>> m_members;
+    };
+
+    // What the pages post while every tab navigates once
+    std::vector<std::wstring> MakeIncoming(size_t tabCount)
+    {
+        std::vector<std::wstring> messages;
+        for (size_t tabId = 1; tabId <= tabCount; ++tabId)
+        {
+            std::wstring id = std::to_wstring(tabId);
+            messages.push_back(L"{\"message\":" + std::to_wstring(MG_SWITCH_TAB) + L",\"args\":{\"tabId\":" + id + L"}}");
+            messages.push_back(L"{\"message\":" + std::to_wstring(MG_NAVIGATE) + L",\"args\":{\"uri\":\"https://example.com/" +
+                id + L"/page?q=a%20b\",\"encodedSearchURI\":\"https://www.bing.com/search?q=example\"}}");
+            messages.push_back(L"{\"message\":" + std::to_wstring(MG_PAGE_METADATA) + L",\"args\":{\"title\":\"Example page " +
+                id + L" \\u2013 \\\"quoted\\\"\",\"favicon\":\"https://example.com/favicon.ico\"}}");
+        }
+        return messages;
+    }
+
+    struct Navigation
+    {
+        size_t tabId;
+        std::wstring uri;
+        std::wstring titleJson;
+    };
+
+    std::vector<Navigation> MakeNavigations(size_t tabCount)
+    {
+        std::vector<Navigation> navigations;
+        for (size_t tabId = 1; tabId <= tabCount; ++tabId)
+        {
+            std::wstring id = std::to_wstring(tabId);
+            navigations.push_back({ tabId, L"https://example.com/" + id + L"/page", L"\"Example page " + id + L"\"" });
+        }
+        return navigations;
+    }
+
+    size_t g_sink = 0; // Keeps the results alive
+
+    // The host copies each message out of get_WebMessageAsJson; here into a
+    // buffer that keeps its capacity, as the WebView2 string would be
+    void DecodeWithCodec(const std::vector<std::wstring>& messages, std::wstring& buffer)
+    {
+        for (const std::wstring& json : messages)
+        {
+            buffer.assign(json);
+            int message = 0;
+            JsonValue args;
+            if (!JsonReader::ReadMessage(&buffer[0], message, args))
+                continue;
+            switch (message)
+            {
+            case MG_SWITCH_TAB:
+            {
+                TabArgs tab;
+                if (DecodeArgs(args, tab))
+                    g_sink += tab.tabId;
+            }
+            break;
+            case MG_NAVIGATE:
+            {
+                NavigateArgs navigate;
+                if (DecodeArgs(args, navigate))
+                    g_sink += navigate.uri.size() + navigate.encodedSearchURI.size();
+            }
+            break;
+            case MG_PAGE_METADATA:
+            {
+                PageMetadataArgs metadata;
+                if (DecodeArgs(args, metadata))
+                    g_sink += metadata.title.GetRaw().size() + metadata.favicon.GetRaw().size();
+            }
+            break;
+            }
+        }
+    }
+
+    void DecodeWithDom(const std::vector<std::wstring>& messages, std::wstring& buffer)
+    {
+        for (const std::wstring& json : messages)
+        {
+            buffer.assign(json);
+            DomValue root = DomValue::Parse(buffer);
+            int message = static_cast<int>(root.At(L"message").AsNumber());
+            const DomValue& args = root.At(L"args");
+            switch (message)
+            {
+            case MG_SWITCH_TAB:
+                g_sink += static_cast<size_t>(args.At(L"tabId").AsNumber());
+                break;
+            case MG_NAVIGATE:
+            {
+                std::wstring uri(args.At(L"uri").AsString());
+                g_sink += uri.size() + (args.HasField(L"encodedSearchURI") ? args.At(L"encodedSearchURI").AsString().size() : 0);
+            }
+            break;
+            case MG_PAGE_METADATA:
+            {
+                // The metadata is relayed as JSON, so it went back to text
+                std::wostringstream title;
+                args.At(L"title").Serialize(title);
+                g_sink += title.str().size() + args.At(L"favicon").AsString().size();
+            }
+            break;
+            }
+        }
+    }
+
+    // What the host posts to the controls UI for each navigation
+    void EncodeWithCodec(const std::vector<Navigation>& navigations, JsonWriter& writer)
+    {
+        for (const Navigation& navigation : navigations)
+        {
+            NavStartingMessage starting;
+            starting.tabId = navigation.tabId;
+            starting.Encode(writer);
+            g_sink += writer.GetLength();
+
+            UpdateUriMessage uri;
+            uri.tabId = navigation.tabId;
+            uri.uri = navigation.uri;
+            uri.canGoForward = false;
+            uri.canGoBack = true;
+            uri.Encode(writer);
+            g_sink += writer.GetLength();
+
+            SecurityUpdateMessage security;
+            security.tabId = navigation.tabId;
+            security.state = L"secure";
+            security.Encode(writer);
+            g_sink += writer.GetLength();
+
+            UpdateTabMessage title;
+            title.tabId = navigation.tabId;
+            title.title = navigation.titleJson;
+            title.Encode(writer);
+            g_sink += writer.GetLength();
+
+            NavCompletedMessage completed;
+            completed.tabId = navigation.tabId;
+            completed.isError = false;
+            completed.Encode(writer);
+            g_sink += writer.GetLength();
+        }
+    }
+
+    // PostJsonToWebView took the value by copy
+    void PostDom(DomValue value)
+    {
+        std::wostringstream stream;
+        value.Serialize(stream);
+        g_sink += stream.str().size();
+    }
+
+    DomValue BeginDom(int message)
+    {
+        DomValue json = DomValue::Parse(L"{}");
+        json[L"message"] = DomValue(static_cast<double>(message));
+        json[L"args"] = DomValue::Parse(L"{}");
+        return json;
+    }
+
+    void EncodeWithDom(const std::vector<Navigation>& navigations)
+    {
+        for (const Navigation& navigation : navigations)
+        {
+            double tabId = static_cast<double>(navigation.tabId);
+
+            DomValue starting = BeginDom(MG_NAV_STARTING);
+            starting[L"args"][L"tabId"] = DomValue(tabId);
+            PostDom(starting);
+
+            DomValue uri = BeginDom(MG_UPDATE_URI);
+            uri[L"args"][L"tabId"] = DomValue(tabId);
+            uri[L"args"][L"uri"] = DomValue(navigation.uri);
+            uri[L"args"][L"canGoForward"] = DomValue(false);
+            uri[L"args"][L"canGoBack"] = DomValue(true);
+            PostDom(uri);
+
+            DomValue security = BeginDom(MG_SECURITY_UPDATE);
+            security[L"args"][L"tabId"] = DomValue(tabId);
+            security[L"args"][L"state"] = DomValue(std::wstring(L"secure"));
+            PostDom(security);
+
+            DomValue title = BeginDom(MG_UPDATE_TAB);
+            title[L"args"][L"title"] = DomValue::Parse(navigation.titleJson);
+            title[L"args"][L"tabId"] = DomValue(tabId);
+            PostDom(title);
+
+            DomValue completed = BeginDom(MG_NAV_COMPLETED);
+            completed[L"args"][L"tabId"] = DomValue(tabId);
+            completed[L"args"][L"isError"] = DomValue(false);
+            PostDom(completed);
+        }
+    }
+
+    struct Result
+    {
+        double messagesPerSecond = 0;
+        double allocationsPerMessage = 0;
+    };
+
+    // One round to warm up buffers, then the measured ones
+    template <typename F>
+    Result Measure(size_t messagesPerRound, size_t rounds, F&& round)
+    {
+        round();
+        size_t allocations = g_allocations;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < rounds; ++i)
+            round();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        Result result;
+        double messages = static_cast<double>(messagesPerRound * rounds);
+        result.messagesPerSecond = seconds > 0 ? messages / seconds : 0;
+        result.allocationsPerMessage = static_cast<double>(g_allocations - allocations) / messages;
+        return result;
+    }
+
+    void Print(const char* name, const Result& codec, const Result& dom)
+    {
+        printf("%-7s codec %10.0f msg/s %6.2f allocs/msg   dom %10.0f msg/s %6.2f allocs/msg   %.1fx\n",
+            name, codec.messagesPerSecond, codec.allocationsPerMessage, dom.messagesPerSecond, dom.allocationsPerMessage,
+            dom.messagesPerSecond > 0 ? codec.messagesPerSecond / dom.messagesPerSecond : 0);
+    }
+
+    bool ParseCount(const char* text, size_t& value)
+    {
+        char* end = nullptr;
+        unsigned long long parsed = strtoull(text, &end, 10);
+        if (end == text || *end != '\0' || parsed == 0)
+            return false;
+        value = static_cast<size_t>(parsed);
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t tabCount = 500;
+    size_t rounds = 20;
+    for (int i = 1; i < argc; ++i)
+    {
+        bool valid = i + 1 < argc;
+        if (valid && strcmp(argv[i], "--tabs") == 0)
+            valid = ParseCount(argv[++i], tabCount);
+        else if (valid && strcmp(argv[i], "--rounds") == 0)
+            valid = ParseCount(argv[++i], rounds);
+        else
+            valid = false;
+        if (!valid)
+        {
+            fprintf(stderr, "usage: codec_bench [--tabs N>0] [--rounds N>0]\n");
+            return 2;
+        }
+    }
+
+    std::vector<std::wstring> incoming = MakeIncoming(tabCount);
+    std::vector<Navigation> navigations = MakeNavigations(tabCount);
+    std::wstring buffer;
+    JsonWriter writer;
+
+    Result decodeCodec = Measure(incoming.size(), rounds, [&] { DecodeWithCodec(incoming, buffer); });
+    Result decodeDom = Measure(incoming.size(), rounds, [&] { DecodeWithDom(incoming, buffer); });
+    Result encodeCodec = Measure(navigations.size() * 5, rounds, [&] { EncodeWithCodec(navigations, writer); });
+    Result encodeDom = Measure(navigations.size() * 5, rounds, [&] { EncodeWithDom(navigations); });
+
+    printf("%zu tabs, %zu rounds\n", tabCount, rounds);
+    Print("decode", decodeCodec, decodeDom);
+    Print("encode", encodeCodec, encodeDom);
+
+    // Once its buffers have grown, the codec must not touch the heap
+    if (decodeCodec.allocationsPerMessage != 0 || encodeCodec.allocationsPerMessage != 0 || g_sink == 0)
+    {
+        fprintf(stderr, "failed: the codec allocated in steady state\n");
+        return 1;
+    }
+    return 0;
+}
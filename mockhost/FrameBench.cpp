@@ -0,0 +1,464 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// FrameBench.cpp : Compares the history page as the host posts it, rows in
+// a JSON array, with the bulk frame format that was tried for it and
+// dropped: the rows as a base64 frame in a JSON string, with every string
+// interned once and timestamps as deltas. Measures the size of the message
+// and the time to encode it and decode it back into rows, the median of a
+// few rounds.
+//
+// The frame is reproduced by HistoryFrame below, in the layout the removed
+// BulkFrame.cpp and wvbrowser_ui/bulk.js shared:
+//
+//   'W' 'B' version
+//   varint stringCount, then per string: varint byteLength, UTF-8 bytes
+//   varint columnCount, then per column: type byte, varint nameIndex
+//   varint rowCount, then per row one varint per column, an index into the
+//   strings, the number, or the zigzag difference to the previous row
+//
+// Only the host's side runs here. The pages decode the frame in script,
+// which is what cost it the most.
+//
+// frame_bench [--rows N] [--rounds N]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ByteCodec.h"
+#include "MessageSchema.h"
+
+namespace
+{
+    const int64_t c_start = 20000LL * 86400000; // ms since 1970
+    const int64_t c_visitInterval = 5000; // ms between visits
+
+    const uint8_t c_magic[] = { 'W', 'B' };
+    const uint8_t c_version = 1;
+    const wchar_t c_base64[] = L"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    enum class ColumnType : uint8_t
+    {
+        String = 0,
+        Unsigned = 1,
+        Delta = 2
+    };
+
+    struct Column
+    {
+        const wchar_t* name;
+        ColumnType type;
+    };
+
+    const Column c_columns[] = {
+        { L"id", ColumnType::Unsigned },
+        { L"uri", ColumnType::String },
+        { L"title", ColumnType::String },
+        { L"favicon", ColumnType::String },
+        { L"timestamp", ColumnType::Delta }
+    };
+
+    // A history entry as the history page gets it, title and favicon as
+    // JSON strings
+    struct Row
+    {
+        long long id = 0;
+        std::wstring uri;
+        std::wstring title;
+        std::wstring favicon;
+        long long timestamp = 0;
+    };
+
+    void AppendBase64(std::wstring& out, const std::vector<uint8_t>& bytes)
+    {
+        out.reserve(out.size() + (bytes.size() + 2) / 3 * 4);
+        size_t i = 0;
+        for (; i + 3 <= bytes.size(); i += 3)
+        {
+            uint32_t group = (bytes[i] << 16) | (bytes[i + 1] << 8) | bytes[i + 2];
+            out.push_back(c_base64[(group >> 18) & 0x3F]);
+            out.push_back(c_base64[(group >> 12) & 0x3F]);
+            out.push_back(c_base64[(group >> 6) & 0x3F]);
+            out.push_back(c_base64[group & 0x3F]);
+        }
+
+        size_t remaining = bytes.size() - i;
+        if (remaining > 0)
+        {
+            uint32_t group = bytes[i] << 16;
+            if (remaining == 2)
+                group |= bytes[i + 1] << 8;
+            out.push_back(c_base64[(group >> 18) & 0x3F]);
+            out.push_back(c_base64[(group >> 12) & 0x3F]);
+            out.push_back(remaining == 2 ? c_base64[(group >> 6) & 0x3F] : L'=');
+            out.push_back(L'=');
+        }
+    }
+
+    int Base64Value(wchar_t c)
+    {
+        if (c >= L'A' && c <= L'Z') return c - L'A';
+        if (c >= L'a' && c <= L'z') return c - L'a' + 26;
+        if (c >= L'0' && c <= L'9') return c - L'0' + 52;
+        if (c == L'+') return 62;
+        if (c == L'/') return 63;
+        return -1;
+    }
+
+    bool DecodeBase64(std::wstring_view text, std::vector<uint8_t>& bytes)
+    {
+        bytes.clear();
+        bytes.reserve(text.size() / 4 * 3);
+        uint32_t group = 0;
+        int bits = 0;
+        for (wchar_t c : text)
+        {
+            if (c == L'=')
+                break;
+            int value = Base64Value(c);
+            if (value < 0)
+                return false;
+            group = (group << 6) | value;
+            bits += 6;
+            if (bits >= 8)
+            {
+                bits -= 8;
+                bytes.push_back(static_cast<uint8_t>(group >> bits));
+            }
+        }
+        return true;
+    }
+
+    class HistoryFrame
+    {
+    public:
+        void Encode(const std::vector<Row>& rows, std::wstring& frame)
+        {
+            m_indices.clear();
+            m_strings.clear();
+            m_rows.clear();
+            for (const Column& column : c_columns)
+                Intern(column.name);
+
+            int64_t previous = 0;
+            for (const Row& row : rows)
+            {
+                AppendVarint(m_rows, static_cast<uint64_t>(row.id));
+                AppendVarint(m_rows, Intern(row.uri));
+                AppendVarint(m_rows, Intern(row.title));
+                AppendVarint(m_rows, Intern(row.favicon));
+                AppendVarint(m_rows, ZigzagEncode(row.timestamp - previous));
+                previous = row.timestamp;
+            }
+
+            m_bytes.clear();
+            m_bytes.push_back(c_magic[0]);
+            m_bytes.push_back(c_magic[1]);
+            m_bytes.push_back(c_version);
+            AppendVarint(m_bytes, m_indices.size());
+            m_bytes.insert(m_bytes.end(), m_strings.begin(), m_strings.end());
+            AppendVarint(m_bytes, std::size(c_columns));
+            for (size_t i = 0; i < std::size(c_columns); ++i)
+            {
+                m_bytes.push_back(static_cast<uint8_t>(c_columns[i].type));
+                AppendVarint(m_bytes, i);
+            }
+            AppendVarint(m_bytes, rows.size());
+            m_bytes.insert(m_bytes.end(), m_rows.begin(), m_rows.end());
+
+            frame.clear();
+            AppendBase64(frame, m_bytes);
+        }
+
+        bool Decode(std::wstring_view frame, std::vector<Row>& rows)
+        {
+            rows.clear();
+            if (!DecodeBase64(frame, m_bytes) || m_bytes.size() < 3 ||
+                m_bytes[0] != c_magic[0] || m_bytes[1] != c_magic[1] || m_bytes[2] != c_version)
+            {
+                return false;
+            }
+            size_t position = 3;
+
+            uint64_t count = 0;
+            if (!ReadVarint(m_bytes, position, count) || count > m_bytes.size())
+                return false;
+            m_table.resize(static_cast<size_t>(count));
+            for (std::wstring& value : m_table)
+            {
+                uint64_t length = 0;
+                if (!ReadVarint(m_bytes, position, length) || length > m_bytes.size() - position ||
+                    !DecodeUtf8(m_bytes.data() + position, static_cast<size_t>(length), value))
+                {
+                    return false;
+                }
+                position += static_cast<size_t>(length);
+            }
+
+            // The columns have to be the ones written
+            if (!ReadVarint(m_bytes, position, count) || count != std::size(c_columns))
+                return false;
+            for (const Column& column : c_columns)
+            {
+                uint64_t name = 0;
+                if (position >= m_bytes.size() || m_bytes[position++] != static_cast<uint8_t>(column.type) ||
+                    !ReadVarint(m_bytes, position, name) || name >= m_table.size() || m_table[name] != column.name)
+                {
+                    return false;
+                }
+            }
+
+            if (!ReadVarint(m_bytes, position, count) || count > m_bytes.size())
+                return false;
+            rows.resize(static_cast<size_t>(count));
+            int64_t previous = 0;
+            for (Row& row : rows)
+            {
+                uint64_t id = 0;
+                uint64_t delta = 0;
+                if (!ReadVarint(m_bytes, position, id) || !ReadString(position, row.uri) ||
+                    !ReadString(position, row.title) || !ReadString(position, row.favicon) ||
+                    !ReadVarint(m_bytes, position, delta))
+                {
+                    return false;
+                }
+                row.id = static_cast<long long>(id);
+                previous += ZigzagDecode(delta);
+                row.timestamp = previous;
+            }
+            return true;
+        }
+
+    private:
+        uint64_t Intern(std::wstring_view value)
+        {
+            m_key.assign(value);
+            auto it = m_indices.find(m_key);
+            if (it != m_indices.end())
+                return it->second;
+
+            uint64_t index = m_indices.size();
+            m_indices.emplace(m_key, index);
+            m_text.clear();
+            AppendUtf8(m_text, value);
+            AppendVarint(m_strings, m_text.size());
+            m_strings.insert(m_strings.end(), m_text.begin(), m_text.end());
+            return index;
+        }
+
+        bool ReadString(size_t& position, std::wstring& value)
+        {
+            uint64_t index = 0;
+            if (!ReadVarint(m_bytes, position, index) || index >= m_table.size())
+                return false;
+            value = m_table[static_cast<size_t>(index)];
+            return true;
+        }
+
+        std::unordered_map<std::wstring, uint64_t> m_indices;
+        std::wstring m_key;
+        std::vector<uint8_t> m_text;
+        std::vector<uint8_t> m_strings;
+        std::vector<uint8_t> m_rows;
+        std::vector<uint8_t> m_bytes;
+        std::vector<std::wstring> m_table;
+    };
+
+    // The page of the history the host posts, the newest first
+    std::vector<Row> MakeRows(size_t count)
+    {
+        std::vector<Row> rows(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            size_t site = i % 500;
+            Row& row = rows[i];
+            row.id = static_cast<long long>(count - i);
+            row.uri = L"https://site" + std::to_wstring(site) + L".example.com/articles/" + std::to_wstring(i);
+            row.title = L"\"Article " + std::to_wstring(i) + L" on Site " + std::to_wstring(site) + L"\"";
+            row.favicon = L"\"https://site" + std::to_wstring(site) + L".example.com/favicon.ico\"";
+            row.timestamp = c_start - static_cast<int64_t>(i) * c_visitInterval;
+        }
+        return rows;
+    }
+
+    void EncodeJson(JsonWriter& writer, const std::vector<Row>& rows)
+    {
+        HistoryArgs history;
+        writer.BeginMessage(MG_GET_HISTORY);
+        EncodeFields(writer, history);
+        writer.BeginArray(FieldName<&HistoryArgs::items>::value);
+        for (const Row& row : rows)
+        {
+            HistoryItemArgs item;
+            item.id = row.id;
+            item.uri = row.uri;
+            item.title = row.title;
+            item.favicon = row.favicon;
+            item.timestamp = row.timestamp;
+            writer.BeginObject();
+            EncodeFields(writer, item);
+            writer.EndObject();
+        }
+        writer.EndArray();
+        writer.EndMessage();
+    }
+
+    void EncodeFrame(JsonWriter& writer, HistoryFrame& frame, std::wstring& text, const std::vector<Row>& rows)
+    {
+        frame.Encode(rows, text);
+        writer.BeginMessage(MG_GET_HISTORY);
+        writer.WriteString(L"frame", text);
+        writer.EndMessage();
+    }
+
+    // Finds the member of the message args, in the mutable copy of the message
+    bool ReadMember(std::wstring& json, std::wstring_view name, JsonValue& member)
+    {
+        int message = 0;
+        JsonValue args;
+        if (!JsonReader::ReadMessage(&json[0], message, args) || message != MG_GET_HISTORY)
+            return false;
+        JsonObjectReader reader(args);
+        std::wstring_view key;
+        while (reader.Next(key, member))
+        {
+            if (key == name)
+                return true;
+        }
+        return false;
+    }
+
+    // Each row through the generated decoder, as the host decodes args
+    bool DecodeJson(std::wstring& json, std::vector<Row>& rows)
+    {
+        rows.clear();
+        JsonValue items;
+        if (!ReadMember(json, L"items", items) || items.GetType() != JsonType::Array)
+            return false;
+
+        std::wstring_view raw = items.GetRaw();
+        wchar_t* current = &json[0] + (raw.data() - json.data()) + 1;
+        wchar_t* end = current + raw.size() - 2;
+        while (current < end)
+        {
+            JsonValue value;
+            HistoryItemArgs item;
+            current = JsonReader::ScanValue(current, end, value);
+            if (current == nullptr || !DecodeArgs(value, item))
+                return false;
+            rows.push_back({ item.id, std::wstring(item.uri), std::wstring(item.title), std::wstring(item.favicon), item.timestamp });
+            if (current < end && *current++ != L',')
+                return false;
+        }
+        return true;
+    }
+
+    bool DecodeFrame(std::wstring& json, HistoryFrame& frame, std::vector<Row>& rows)
+    {
+        JsonValue member;
+        std::wstring_view text;
+        return ReadMember(json, L"frame", member) && member.GetString(text) && frame.Decode(text, rows);
+    }
+
+    bool IsSame(const std::vector<Row>& a, const std::vector<Row>& b)
+    {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const Row& x, const Row& y)
+        {
+            return x.id == y.id && x.uri == y.uri && x.title == y.title && x.favicon == y.favicon && x.timestamp == y.timestamp;
+        });
+    }
+
+    double GetSeconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double GetMedian(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+
+    bool ParseCount(const char* text, size_t& value)
+    {
+        char* end = nullptr;
+        unsigned long long parsed = strtoull(text, &end, 10);
+        if (end == text || *end != '\0' || parsed == 0)
+            return false;
+        value = static_cast<size_t>(parsed);
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t rowCount = 10000;
+    size_t roundCount = 15;
+    for (int i = 1; i < argc; ++i)
+    {
+        bool valid = i + 1 < argc;
+        if (valid && strcmp(argv[i], "--rows") == 0)
+            valid = ParseCount(argv[++i], rowCount);
+        else if (valid && strcmp(argv[i], "--rounds") == 0)
+            valid = ParseCount(argv[++i], roundCount);
+        else
+            valid = false;
+        if (!valid)
+        {
+            fprintf(stderr, "usage: frame_bench [--rows N>0] [--rounds N>0]\n");
+            return 2;
+        }
+    }
+
+    std::vector<Row> rows = MakeRows(rowCount);
+    JsonWriter writer;
+    HistoryFrame frame;
+    std::wstring text;
+    std::wstring json;
+    std::vector<Row> decoded;
+    std::vector<double> jsonEncode, jsonDecode, frameEncode, frameDecode;
+    size_t jsonLength = 0;
+    size_t frameLength = 0;
+    bool isSame = true;
+    for (size_t round = 0; round < roundCount; ++round)
+    {
+        auto start = std::chrono::steady_clock::now();
+        EncodeJson(writer, rows);
+        jsonEncode.push_back(GetSeconds(start));
+        json.assign(writer.GetString(), writer.GetLength());
+        jsonLength = json.size();
+        start = std::chrono::steady_clock::now();
+        isSame = DecodeJson(json, decoded) && IsSame(rows, decoded) && isSame;
+        jsonDecode.push_back(GetSeconds(start));
+
+        start = std::chrono::steady_clock::now();
+        EncodeFrame(writer, frame, text, rows);
+        frameEncode.push_back(GetSeconds(start));
+        json.assign(writer.GetString(), writer.GetLength());
+        frameLength = json.size();
+        start = std::chrono::steady_clock::now();
+        isSame = DecodeFrame(json, frame, decoded) && IsSame(rows, decoded) && isSame;
+        frameDecode.push_back(GetSeconds(start));
+    }
+
+    printf("%zu rows, median of %zu rounds\n", rowCount, roundCount);
+    printf("json   %10zu chars, encoded in %8.2f ms, decoded in %8.2f ms\n",
+        jsonLength, GetMedian(jsonEncode) * 1e3, GetMedian(jsonDecode) * 1e3);
+    printf("frame  %10zu chars, encoded in %8.2f ms, decoded in %8.2f ms\n",
+        frameLength, GetMedian(frameEncode) * 1e3, GetMedian(frameDecode) * 1e3);
+
+    if (!isSame)
+    {
+        fprintf(stderr, "failed: the rows don't decode as they were encoded\n");
+        return 1;
+    }
+    return 0;
+}
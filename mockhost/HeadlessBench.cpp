@@ -0,0 +1,810 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// HeadlessBench.cpp : Runs the browser host against the mock WebView2 and
+// reports how it copes with many tabs loading at once, how fast the broker
+// handles messages from the controls UI, how background tabs hibernate, how
+// quickly a new tab shows up, whether tabs closed while being created leave
+// anything behind, whether Ctrl+Shift+D indexes the DevTools window it finds,
+// whether a traffic recording covers the tabs open when it
+// started and how the saved session is restored.
+//
+// headless_bench [--tabs N] [--messages N]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <tlhelp32.h>
+#include "BrowserWindow.h"
+#include "HeadlessBrowser.h"
+#include "MessageSchema.h"
+#include "MockPlatform.h"
+#include "TrafficRecorder.h"
+
+namespace
+{
+    struct LoadResult
+    {
+        size_t frames = 0;
+        size_t batches = 0;
+        size_t batchBytes = 0;
+        size_t activeTabFrame = 0; // First frame with an update for tab 1
+    };
+
+    bool HasActiveTabUpdate(const std::wstring& json)
+    {
+        return json.find(L"\"tabId\":1,") != std::wstring::npos || json.find(L"\"tabId\":1}") != std::wstring::npos;
+    }
+
+    // Counts the batches the controls UI gets in each frame
+    bool RunUntilSettled(HeadlessBrowser& browser, LoadResult& result)
+    {
+        MockWebView* controls = browser.GetControls();
+        size_t frame = 0;
+        bool settled = browser.RunUntilSettled([&]()
+        {
+            // Up to the last frame with something to show, timers that
+            // only write state to disk may run longer
+            if (!controls->GetPostedMessages().empty() || HeadlessBrowser::IsAnyWebViewLoading())
+                result.frames = frame;
+            for (const std::wstring& json : controls->GetPostedMessages())
+            {
+                ++result.batches;
+                result.batchBytes += json.size();
+                if (result.activeTabFrame == 0 && HasActiveTabUpdate(json))
+                    result.activeTabFrame = frame;
+            }
+            controls->ClearPostedMessages();
+            ++frame;
+        });
+        return settled;
+    }
+
+    std::wstring CreateTabJson(size_t tabId, bool active)
+    {
+        return L"{\"message\":" + std::to_wstring(MG_CREATE_TAB) + L",\"args\":{\"tabId\":" +
+            std::to_wstring(tabId) + L",\"active\":" + (active ? L"true" : L"false") + L"}}";
+    }
+
+    std::wstring SwitchTabJson(size_t tabId)
+    {
+        return L"{\"message\":" + std::to_wstring(MG_SWITCH_TAB) + L",\"args\":{\"tabId\":" + std::to_wstring(tabId) + L"}}";
+    }
+
+    std::wstring CloseTabJson(size_t tabId)
+    {
+        return L"{\"message\":" + std::to_wstring(MG_CLOSE_TAB) + L",\"args\":{\"tabId\":" + std::to_wstring(tabId) + L"}}";
+    }
+
+    // Thresholds in seconds, 0 turns hibernation off
+    std::wstring TabPolicyJson(uint64_t suspendAfter, uint64_t discardAfter)
+    {
+        return L"{\"message\":" + std::to_wstring(MG_SET_TAB_POLICY) + L",\"args\":{\"suspendAfter\":" +
+            std::to_wstring(suspendAfter) + L",\"discardAfter\":" + std::to_wstring(discardAfter) + L",\"memoryBudget\":0}}";
+    }
+
+    struct HibernationResult
+    {
+        size_t suspended = 0;
+        size_t discarded = 0;
+        size_t live = 0; // Tab WebViews left open
+        size_t discardedUpdates = 0; // Sent to the controls UI
+        size_t restoreFrames = 0;
+    };
+
+    size_t CountOccurrences(const std::vector<std::wstring>& messages, const std::wstring& text)
+    {
+        size_t count = 0;
+        for (const std::wstring& json : messages)
+        {
+            for (size_t position = json.find(text); position != std::wstring::npos; position = json.find(text, position + 1))
+                ++count;
+        }
+        return count;
+    }
+
+    // Tab WebViews, not the UI's or pooled ones yet to be used
+    bool IsTab(HeadlessBrowser& browser, MockWebView* webview)
+    {
+        return webview != browser.GetControls() && webview != browser.GetOptions() && webview->HasWebMessageHandler();
+    }
+
+    std::vector<MockWebView*> GetTabs(HeadlessBrowser& browser)
+    {
+        std::vector<MockWebView*> tabs;
+        for (MockWebView* webview : MockHost::GetWebViews())
+        {
+            if (IsTab(browser, webview))
+                tabs.push_back(webview);
+        }
+        return tabs;
+    }
+
+    // The tab WebView that isn't in before, if there's one yet
+    MockWebView* FindNewTab(HeadlessBrowser& browser, const std::vector<MockWebView*>& before)
+    {
+        for (MockWebView* webview : GetTabs(browser))
+        {
+            if (std::find(before.begin(), before.end(), webview) == before.end())
+                return webview;
+        }
+        return nullptr;
+    }
+
+    // Lets every background tab idle past both thresholds, then switches to
+    // one of them and counts the frames until it's re-created and loaded
+    bool RunHibernation(HeadlessBrowser& browser, size_t tabCount, HibernationResult& result)
+    {
+        const uint64_t suspendAfter = 60;
+        const uint64_t discardAfter = 600;
+        MockWebView* controls = browser.GetControls();
+        auto isTab = [&browser](MockWebView* webview) { return IsTab(browser, webview); };
+
+        controls->DispatchMessageFromPage(SwitchTabJson(1));
+        controls->DispatchMessageFromPage(TabPolicyJson(suspendAfter, discardAfter));
+        controls->ClearPostedMessages();
+
+        uint64_t start = MockPlatform::GetTime();
+        browser.RunUntil(start + suspendAfter * 1000 + HeadlessBrowser::c_frameInterval);
+        for (MockWebView* webview : MockHost::GetWebViews())
+            result.suspended += isTab(webview) && webview->IsSuspended() ? 1 : 0;
+
+        browser.RunUntil(start + discardAfter * 1000 + HeadlessBrowser::c_frameInterval);
+        for (MockWebView* webview : MockHost::GetWebViews())
+            result.live += isTab(webview) ? 1 : 0;
+        result.discarded = tabCount - result.live;
+        result.discardedUpdates = CountOccurrences(controls->GetPostedMessages(), L"\"lifecycle\":\"discarded\"");
+
+        std::vector<MockWebView*> before = GetTabs(browser);
+        controls->DispatchMessageFromPage(SwitchTabJson(tabCount));
+        MockWebView* restored = nullptr;
+        for (size_t frame = 1; frame <= HeadlessBrowser::c_maxFrames && restored == nullptr; ++frame)
+        {
+            browser.RunUntil(MockPlatform::GetTime() + HeadlessBrowser::c_frameInterval);
+            MockWebView* webview = FindNewTab(browser, before);
+            if (webview != nullptr && !webview->IsLoading() && webview->GetController()->IsVisible())
+                restored = webview;
+            result.restoreFrames = frame;
+        }
+
+        controls->DispatchMessageFromPage(TabPolicyJson(0, 0));
+        controls->ClearPostedMessages();
+        return restored != nullptr;
+    }
+
+    struct NewTabResult
+    {
+        size_t opened = 0;
+        size_t shownOnOpen = 0; // Visible when the create message returned
+        size_t loadFrames = 0; // Of the slowest tab
+        LatencyHistogram latency; // Of the create message
+    };
+
+    // Opens tabs one at a time, a second apart like a user would, so the
+    // pool has time to refill between them
+    bool RunNewTabs(HeadlessBrowser& browser, size_t firstTabId, size_t count, NewTabResult& result)
+    {
+        const uint64_t interval = 1000;
+        MockWebView* controls = browser.GetControls();
+        bool loaded = true;
+        for (size_t tabId = firstTabId; tabId < firstTabId + count; ++tabId)
+        {
+            browser.RunUntil(MockPlatform::GetTime() + interval);
+            std::vector<MockWebView*> before = GetTabs(browser);
+
+            auto start = std::chrono::steady_clock::now();
+            controls->DispatchMessageFromPage(CreateTabJson(tabId, true));
+            result.latency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+            ++result.opened;
+
+            MockWebView* tab = FindNewTab(browser, before);
+            result.shownOnOpen += tab != nullptr && tab->GetController()->IsVisible() ? 1 : 0;
+
+            size_t frame = 1;
+            for (; frame <= HeadlessBrowser::c_maxFrames; ++frame)
+            {
+                browser.RunUntil(MockPlatform::GetTime() + HeadlessBrowser::c_frameInterval);
+                tab = FindNewTab(browser, before);
+                if (tab != nullptr && !tab->IsLoading() && tab->GetController()->IsVisible())
+                    break;
+            }
+            loaded = loaded && frame <= HeadlessBrowser::c_maxFrames;
+            result.loadFrames = std::max(result.loadFrames, frame);
+        }
+        controls->ClearPostedMessages();
+        return loaded;
+    }
+
+    struct StaleTabResult
+    {
+        size_t closed = 0; // Before their WebView was created
+        size_t leaked = 0; // Tab WebViews left for closed tabs
+        bool recreated = false; // The reused id got its own WebView
+    };
+
+    // Closes tabs right after opening them, faster than the pool refills,
+    // sends messages for the closed ids, then opens a tab again under one of
+    // them. The pending creations of the closed tabs must find them gone.
+    bool RunStaleTabs(HeadlessBrowser& browser, size_t firstTabId, size_t count, StaleTabResult& result)
+    {
+        MockWebView* controls = browser.GetControls();
+        std::vector<MockWebView*> before = GetTabs(browser);
+        for (size_t tabId = firstTabId; tabId < firstTabId + count; ++tabId)
+        {
+            controls->DispatchMessageFromPage(CreateTabJson(tabId, false));
+            controls->DispatchMessageFromPage(CloseTabJson(tabId));
+            controls->DispatchMessageFromPage(SwitchTabJson(tabId));
+            controls->DispatchMessageFromPage(CloseTabJson(tabId));
+            ++result.closed;
+        }
+        size_t reusedId = firstTabId + count - 1;
+        controls->DispatchMessageFromPage(CreateTabJson(reusedId, false));
+
+        LoadResult drain;
+        bool settled = RunUntilSettled(browser, drain);
+        size_t opened = GetTabs(browser).size() - before.size();
+        result.recreated = opened >= 1 && FindNewTab(browser, before) != nullptr;
+        result.leaked = opened >= 1 ? opened - 1 : 0;
+
+        controls->DispatchMessageFromPage(CloseTabJson(reusedId));
+        controls->ClearPostedMessages();
+        return settled && GetTabs(browser).size() == before.size();
+    }
+
+    BOOL CALLBACK AddDevToolsWindow(HWND hwnd, LPARAM lParam)
+    {
+        WCHAR className[256];
+        GetClassName(hwnd, className, 256);
+        if (wcscmp(className, L"Chrome_WidgetWin_1") == 0)
+            reinterpret_cast<std::vector<HWND>*>(lParam)->push_back(hwnd);
+        return TRUE;
+    }
+
+    // Opens DevTools in a new tab, then docks them with Ctrl+Shift+D. The
+    // window found on the way must be indexed for the tab.
+    bool RunDevTools(HeadlessBrowser& browser, size_t tabId, bool& registered)
+    {
+        MockWebView* controls = browser.GetControls();
+        std::vector<MockWebView*> before = GetTabs(browser);
+        controls->DispatchMessageFromPage(CreateTabJson(tabId, true));
+        LoadResult drain;
+        MockWebView* tab = FindNewTab(browser, before);
+        if (tab == nullptr || !RunUntilSettled(browser, drain))
+            return false;
+
+        std::vector<HWND> existing;
+        EnumWindows(AddDevToolsWindow, reinterpret_cast<LPARAM>(&existing));
+        tab->OpenDevToolsWindow();
+        MockPlatform::RunUntilIdle();
+        std::vector<HWND> windows;
+        EnumWindows(AddDevToolsWindow, reinterpret_cast<LPARAM>(&windows));
+        HWND devTools = nullptr;
+        for (HWND hwnd : windows)
+        {
+            if (std::find(existing.begin(), existing.end(), hwnd) == existing.end())
+                devTools = hwnd;
+        }
+
+        MockPlatform::SetKeyState(VK_CONTROL, true);
+        MockPlatform::SetKeyState(VK_SHIFT, true);
+        tab->GetController()->PressKey('D');
+        MockPlatform::RunUntilIdle();
+        MockPlatform::SetKeyState(VK_CONTROL, false);
+        MockPlatform::SetKeyState(VK_SHIFT, false);
+        registered = devTools != nullptr && browser.GetWindow()->CheckDTOwnership(devTools);
+
+        controls->DispatchMessageFromPage(CloseTabJson(tabId));
+        controls->ClearPostedMessages();
+        return RunUntilSettled(browser, drain);
+    }
+
+    struct RecordingResult
+    {
+        size_t creates = 0; // Logged for tabs open when recording started
+        size_t activeCreates = 0;
+        bool metricsTab = false; // The recording tab is one of them
+    };
+
+    bool ReadMockFile(const std::wstring& path, std::vector<uint8_t>& contents)
+    {
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        uint8_t buffer[4096];
+        DWORD read = 0;
+        bool succeeded = true;
+        while ((succeeded = ReadFile(file, buffer, sizeof(buffer), &read, nullptr) != FALSE) && read > 0)
+            contents.insert(contents.end(), buffer, buffer + read);
+        CloseHandle(file);
+        return succeeded;
+    }
+
+    // Opens browser://metrics in a new tab and records from it, with the
+    // other tabs already open. The log must start by creating all of them.
+    bool RunRecording(HeadlessBrowser& browser, size_t tabId, RecordingResult& result)
+    {
+        MockWebView* controls = browser.GetControls();
+        std::vector<MockWebView*> before = GetTabs(browser);
+        controls->DispatchMessageFromPage(CreateTabJson(tabId, true));
+        LoadResult drain;
+        if (!RunUntilSettled(browser, drain))
+            return false;
+        controls->DispatchMessageFromPage(L"{\"message\":" + std::to_wstring(MG_NAVIGATE) +
+            L",\"args\":{\"uri\":\"browser://metrics\",\"encodedSearchURI\":\"\"}}");
+        MockWebView* metrics = FindNewTab(browser, before);
+        if (metrics == nullptr || !RunUntilSettled(browser, drain))
+            return false;
+
+        for (const wchar_t* enabled : { L"true", L"false" })
+        {
+            metrics->DispatchMessageFromPage(L"{\"message\":" + std::to_wstring(MG_SET_RECORDING) +
+                L",\"args\":{\"enabled\":" + enabled + L"}}");
+        }
+
+        std::vector<uint8_t> log;
+        for (const std::wstring& path : MockPlatform::GetFilePaths())
+        {
+            if (path.find(L"\\traffic-") != std::wstring::npos && !ReadMockFile(path, log))
+                return false;
+        }
+        std::vector<TrafficRecord> records;
+        if (!TrafficRecorder::ReadLog(log, records))
+            return false;
+
+        for (const TrafficRecord& record : records)
+        {
+            std::wstring json = record.json;
+            int message = 0;
+            JsonValue args;
+            CreateTabArgs createTab;
+            if (record.posted || record.endpoint != TrafficEndpoint::Controls ||
+                !JsonReader::ReadMessage(&json[0], message, args) || message != MG_CREATE_TAB || !DecodeArgs(args, createTab))
+            {
+                break;
+            }
+            ++result.creates;
+            result.activeCreates += createTab.active ? 1 : 0;
+            result.metricsTab = result.metricsTab || (createTab.tabId == tabId && createTab.active);
+        }
+
+        controls->DispatchMessageFromPage(CloseTabJson(tabId));
+        controls->ClearPostedMessages();
+        return RunUntilSettled(browser, drain);
+    }
+
+    struct TasksResult
+    {
+        size_t tasks = 0; // Tabs in the MG_GET_TASKS reply
+        size_t measured = 0; // Of them, charged with the working set of their process
+        size_t webviews = 0; // Tab WebViews, the tabs with a process
+        size_t refused = 0; // Replies to the request from a web page, must be none
+    };
+
+    // Opens browser://tasks with the other tabs open and their process
+    // reporting a working set, then asks for the tasks from it and, before
+    // that, from the web page the tab starts on
+    bool RunTasks(HeadlessBrowser& browser, size_t tabId, TasksResult& result)
+    {
+        const uint64_t workingSet = 300 * 1024 * 1024;
+        const std::wstring request = L"{\"message\":" + std::to_wstring(MG_GET_TASKS) + L",\"args\":{}}";
+        MockWebView* controls = browser.GetControls();
+        std::vector<MockWebView*> before = GetTabs(browser);
+        controls->DispatchMessageFromPage(CreateTabJson(tabId, true));
+        LoadResult drain;
+        MockWebView* tasks = FindNewTab(browser, before);
+        if (tasks == nullptr || !RunUntilSettled(browser, drain))
+            return false;
+        tasks->ClearPostedMessages();
+        tasks->DispatchMessageFromPage(request);
+        MockPlatform::RunUntilIdle();
+        result.refused = tasks->GetPostedMessages().size();
+
+        UINT32 processId = 0;
+        tasks->get_BrowserProcessId(&processId);
+        MockPlatform::SetProcessCounters(processId, workingSet, 0);
+        controls->DispatchMessageFromPage(L"{\"message\":" + std::to_wstring(MG_NAVIGATE) +
+            L",\"args\":{\"uri\":\"browser://tasks\",\"encodedSearchURI\":\"\"}}");
+        if (!RunUntilSettled(browser, drain))
+            return false;
+        tasks->ClearPostedMessages();
+        tasks->DispatchMessageFromPage(request);
+        // Replied to once the counters were read on a worker
+        MockPlatform::RunUntilIdle();
+        result.tasks = CountOccurrences(tasks->GetPostedMessages(), L"\"tabId\":");
+        result.measured = CountOccurrences(tasks->GetPostedMessages(), L"\"workingSet\":" + std::to_wstring(workingSet));
+        result.webviews = GetTabs(browser).size();
+
+        // The later runs count on the memory being estimated
+        MockPlatform::SetProcessCounters(processId, 0, 0);
+        controls->DispatchMessageFromPage(CloseTabJson(tabId));
+        controls->ClearPostedMessages();
+        return RunUntilSettled(browser, drain);
+    }
+
+    size_t CountWebViewProcesses()
+    {
+        size_t count = 0;
+        HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+        PROCESSENTRY32W entry = {};
+        entry.dwSize = sizeof(entry);
+        for (BOOL found = Process32FirstW(snapshot, &entry); found; found = Process32NextW(snapshot, &entry))
+            count += wcscmp(entry.szExeFile, L"msedgewebview2.exe") == 0 ? 1 : 0;
+        CloseHandle(snapshot);
+        return count;
+    }
+
+    std::wstring MoveTabJson(size_t tabId)
+    {
+        return L"{\"message\":" + std::to_wstring(MG_MOVE_TAB) + L",\"args\":{\"tabId\":" + std::to_wstring(tabId) + L"}}";
+    }
+
+    struct WindowsResult
+    {
+        bool listed = false; // In the new window's session reply
+        bool kept = false; // Same WebView, not reloaded, reparented there
+        size_t newProcesses = 0; // Started for the second window, must be none
+        bool movedBack = false;
+    };
+
+    // Moves a tab to a new window and back again. The second window must use
+    // the environments of the first one and closing it mustn't quit.
+    bool RunWindows(HeadlessBrowser& browser, size_t tabId, WindowsResult& result)
+    {
+        MockWebView* controls = browser.GetControls();
+        std::vector<MockWebView*> before = GetTabs(browser);
+        controls->DispatchMessageFromPage(CreateTabJson(tabId, true));
+        LoadResult drain;
+        MockWebView* tab = FindNewTab(browser, before);
+        if (tab == nullptr || !RunUntilSettled(browser, drain))
+            return false;
+        size_t processes = CountWebViewProcesses();
+
+        std::vector<MockWebView*> webviews = MockHost::GetWebViews();
+        controls->DispatchMessageFromPage(MoveTabJson(tabId));
+        if (!RunUntilSettled(browser, drain))
+            return false;
+        MockWebView* secondControls = nullptr;
+        for (MockWebView* webview : MockHost::GetWebViews())
+        {
+            const std::wstring suffix = L"controls_ui/default.html";
+            const std::wstring& source = webview->GetSource();
+            if (std::find(webviews.begin(), webviews.end(), webview) == webviews.end() &&
+                source.size() >= suffix.size() && source.compare(source.size() - suffix.size(), suffix.size(), suffix) == 0)
+            {
+                secondControls = webview;
+            }
+        }
+        if (secondControls == nullptr)
+            return false;
+
+        secondControls->ClearPostedMessages();
+        secondControls->DispatchMessageFromPage(L"{\"message\":" + std::to_wstring(MG_RESTORE_SESSION) + L",\"args\":{}}");
+        result.listed = CountOccurrences(secondControls->GetPostedMessages(), L"\"tabId\":" + std::to_wstring(tabId)) > 0;
+
+        HWND secondWindow = GetParent(secondControls->GetController()->GetWindow());
+        HWND parent = nullptr;
+        result.kept = !tab->IsClosed() && !tab->IsLoading() && SUCCEEDED(tab->GetController()->get_ParentWindow(&parent)) &&
+            parent == secondWindow && secondWindow != nullptr;
+        result.newProcesses = CountWebViewProcesses() - processes;
+
+        BrowserWindow* second = reinterpret_cast<BrowserWindow*>(GetWindowLongPtr(secondWindow, GWLP_USERDATA));
+        if (second == nullptr)
+            return false;
+        controls->DispatchMessageFromPage(L"{\"message\":" + std::to_wstring(MG_MOVE_TAB) + L",\"args\":{\"tabId\":" +
+            std::to_wstring(tabId) + L",\"windowId\":" + std::to_wstring(second->GetWindowId()) + L",\"newTabId\":" +
+            std::to_wstring(tabId + 1) + L"}}");
+        parent = nullptr;
+        result.movedBack = !tab->IsClosed() && SUCCEEDED(tab->GetController()->get_ParentWindow(&parent)) &&
+            parent != secondWindow;
+
+        secondControls->DispatchMessageFromPage(L"{\"message\":" + std::to_wstring(MG_CLOSE_WINDOW) + L",\"args\":{}}");
+        if (!RunUntilSettled(browser, drain) || MockPlatform::IsQuitPosted())
+            return false;
+
+        controls->DispatchMessageFromPage(CloseTabJson(tabId + 1));
+        controls->ClearPostedMessages();
+        return RunUntilSettled(browser, drain);
+    }
+
+    struct ResizeResult
+    {
+        size_t sizes = 0; // WM_SIZE sent while dragging
+        size_t frames = 0;
+        size_t layouts = 0; // Of the controls bar
+        bool final = false; // The bar and the active tab fit the last size
+        int scaledBarHeight = 0; // After WM_DPICHANGED to 144 dpi
+    };
+
+    // Drags the window frame through several sizes a frame with a new tab
+    // active, then changes the DPI. The host lays out at most once a frame
+    // and ends on the last size.
+    bool RunResize(HeadlessBrowser& browser, size_t tabId, ResizeResult& result)
+    {
+        LoadResult drain;
+        browser.GetControls()->DispatchMessageFromPage(CreateTabJson(tabId, true));
+        if (!RunUntilSettled(browser, drain))
+            return false;
+
+        MockController* controls = browser.GetControls()->GetController();
+        HWND hWnd = GetParent(controls->GetWindow());
+        RECT original;
+        GetClientRect(hWnd, &original);
+        const size_t c_sizesPerFrame = 15;
+        result.frames = 4;
+
+        size_t layouts = controls->GetBoundsCount();
+        int width = original.right;
+        int height = original.bottom;
+        for (size_t frame = 0; frame < result.frames; ++frame)
+        {
+            for (size_t i = 0; i < c_sizesPerFrame; ++i, ++result.sizes)
+            {
+                width += 7;
+                height += 3;
+                MockPlatform::ResizeWindow(hWnd, width, height);
+                MockPlatform::RunUntilIdle();
+            }
+            browser.RunUntil(MockPlatform::GetTime() + HeadlessBrowser::c_frameInterval);
+        }
+        if (!RunUntilSettled(browser, drain))
+            return false;
+        result.layouts = controls->GetBoundsCount() - layouts;
+
+        bool tabFits = false;
+        for (MockWebView* tab : GetTabs(browser))
+        {
+            const RECT& bounds = tab->GetController()->GetBounds();
+            if (tab->GetController()->IsVisible())
+                tabFits = bounds.right == width && bounds.bottom == height && bounds.top == controls->GetBounds().bottom;
+        }
+        result.final = tabFits && controls->GetBounds().right == width;
+
+        MockPlatform::SetDpi(144);
+        SendMessage(hWnd, WM_DPICHANGED, MAKEWPARAM(144, 144), 0);
+        bool scaled = RunUntilSettled(browser, drain);
+        result.scaledBarHeight = controls->GetBounds().bottom;
+
+        MockPlatform::SetDpi(96);
+        SendMessage(hWnd, WM_DPICHANGED, MAKEWPARAM(96, 96), 0);
+        MockPlatform::ResizeWindow(hWnd, original.right, original.bottom);
+        browser.GetControls()->DispatchMessageFromPage(CloseTabJson(tabId));
+        browser.GetControls()->ClearPostedMessages();
+        return RunUntilSettled(browser, drain) && scaled;
+    }
+
+    struct SessionResult
+    {
+        size_t tabs = 0; // In the MG_RESTORE_SESSION reply
+        size_t webviews = 0; // Tab WebViews created on restore
+        uint64_t restoreTime = 0; // ns in the host
+        size_t switchFrames = 0; // Until a tab that wasn't loaded is
+    };
+
+    // Cuts the last record of the session journal short, as a crash in the
+    // middle of a write would
+    bool TearSessionJournal()
+    {
+        for (const std::wstring& path : MockPlatform::GetFilePaths())
+        {
+            if (path.size() < 8 || path.compare(path.size() - 8, 8, L"\\Session") != 0)
+                continue;
+
+            const uint8_t torn[] = { 0x20, 0x01, 0x07 };
+            HANDLE file = CreateFileW(path.c_str(), FILE_APPEND_DATA, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            DWORD written = 0;
+            bool succeeded = file != INVALID_HANDLE_VALUE && WriteFile(file, torn, sizeof(torn), &written, nullptr);
+            CloseHandle(file);
+            return succeeded;
+        }
+        return false;
+    }
+
+    // Launches a new window on the session the previous one saved, then
+    // switches to a tab that was restored without a WebView
+    bool RunSessionRestore(HeadlessBrowser& browser, size_t switchTabId, SessionResult& result)
+    {
+        MockWebView* controls = browser.GetControls();
+        controls->ClearPostedMessages();
+
+        auto start = std::chrono::steady_clock::now();
+        controls->DispatchMessageFromPage(L"{\"message\":" + std::to_wstring(MG_RESTORE_SESSION) + L",\"args\":{}}");
+        result.restoreTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        result.tabs = CountOccurrences(controls->GetPostedMessages(), L"\"lifecycle\":");
+
+        LoadResult load;
+        if (!RunUntilSettled(browser, load))
+            return false;
+        result.webviews = GetTabs(browser).size();
+
+        std::vector<MockWebView*> before = GetTabs(browser);
+        controls->DispatchMessageFromPage(SwitchTabJson(switchTabId));
+        for (size_t frame = 1; frame <= HeadlessBrowser::c_maxFrames; ++frame)
+        {
+            browser.RunUntil(MockPlatform::GetTime() + HeadlessBrowser::c_frameInterval);
+            MockWebView* webview = FindNewTab(browser, before);
+            if (webview != nullptr && !webview->IsLoading() && webview->GetController()->IsVisible())
+            {
+                result.switchFrames = frame;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Times each message from the controls UI until the host returns
+    void TimeMessages(MockWebView* controls, const std::vector<std::wstring>& messages, size_t count, LatencyHistogram& latency)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            controls->DispatchMessageFromPage(messages[i % messages.size()]);
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            latency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+            // Keep the queue short, like a message loop would
+            if (i % 64 == 63)
+                MockPlatform::RunUntilIdle();
+        }
+        MockPlatform::RunUntilIdle();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t tabCount = 100;
+    size_t messageCount = 100000;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--tabs") == 0)
+            tabCount = strtoul(argv[i + 1], nullptr, 10);
+        else if (strcmp(argv[i], "--messages") == 0)
+            messageCount = strtoul(argv[i + 1], nullptr, 10);
+    }
+    if (tabCount < 2 || messageCount == 0)
+    {
+        fprintf(stderr, "usage: headless_bench [--tabs N>=2] [--messages N>0]\n");
+        return 2;
+    }
+    MockPlatform::SetDebugOutput(getenv("HEADLESS_BENCH_DEBUG") != nullptr);
+
+    // Content pages report their metadata as soon as the document exists
+    MockHost::SetDocumentCreatedHandler([](MockWebView& webview)
+    {
+        if (webview.GetSource().compare(0, 8, L"https://") == 0)
+        {
+            webview.PostMessageFromPage(L"{\"message\":" + std::to_wstring(MG_PAGE_METADATA) +
+                L",\"args\":{\"title\":\"Bing\",\"favicon\":\"https://www.bing.com/favicon.ico\"}}");
+        }
+    });
+
+    HeadlessBrowser browser;
+    if (!browser.Launch())
+    {
+        fprintf(stderr, "Could not launch the browser\n");
+        return 1;
+    }
+    MockWebView* controls = browser.GetControls();
+    controls->ClearPostedMessages();
+
+    // Open all tabs in one go, the first one active, like a restored session
+    for (size_t tabId = 1; tabId <= tabCount; ++tabId)
+        controls->PostMessageFromPage(CreateTabJson(tabId, tabId == 1));
+
+    auto loadStart = std::chrono::steady_clock::now();
+    LoadResult load;
+    bool settled = RunUntilSettled(browser, load);
+    double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
+
+    printf("bulk load  %zu tabs in %zu frames (%.1f ms host time), %zu batches, %zu bytes, active tab in frame %zu\n",
+        tabCount, load.frames, loadSeconds * 1000, load.batches, load.batchBytes, load.activeTabFrame);
+
+    // Broker throughput, for messages that only touch host state and for
+    // ones that start work in a tab
+    std::vector<std::wstring> switchMessages;
+    for (size_t tabId = 1; tabId <= 2; ++tabId)
+    {
+        switchMessages.push_back(L"{\"message\":" + std::to_wstring(MG_SWITCH_TAB) +
+            L",\"args\":{\"tabId\":" + std::to_wstring(tabId) + L"}}");
+    }
+    std::vector<std::wstring> navigateMessages;
+    for (size_t i = 0; i < 16; ++i)
+    {
+        navigateMessages.push_back(L"{\"message\":" + std::to_wstring(MG_NAVIGATE) +
+            L",\"args\":{\"uri\":\"https://example.com/" + std::to_wstring(i) +
+            L"\",\"encodedSearchURI\":\"https://www.bing.com/search?q=" + std::to_wstring(i) + L"\"}}");
+    }
+
+    const std::pair<const char*, const std::vector<std::wstring>*> scenarios[] = {
+        { "switch", &switchMessages },
+        { "navigate", &navigateMessages },
+    };
+    for (const auto& scenario : scenarios)
+    {
+        LatencyHistogram latency;
+        auto start = std::chrono::steady_clock::now();
+        TimeMessages(controls, *scenario.second, messageCount, latency);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        PrintLatency(scenario.first, latency, seconds);
+
+        LoadResult drain;
+        settled = RunUntilSettled(browser, drain) && settled;
+    }
+
+    HibernationResult hibernation;
+    bool restored = RunHibernation(browser, tabCount, hibernation);
+    printf("hibernate  %zu tabs suspended, %zu discarded (%zu updates), %zu left open, restored in %zu frames\n",
+        hibernation.suspended, hibernation.discarded, hibernation.discardedUpdates, hibernation.live,
+        hibernation.restoreFrames);
+    LoadResult drain;
+    settled = RunUntilSettled(browser, drain) && restored && settled;
+
+    NewTabResult newTabs;
+    bool opened = RunNewTabs(browser, tabCount + 1, 8, newTabs);
+    printf("new tab    %zu opened, %zu shown on open, p50 %llu ns, max %llu ns, loaded in %zu frames\n",
+        newTabs.opened, newTabs.shownOnOpen, static_cast<unsigned long long>(newTabs.latency.GetPercentile(0.5)),
+        static_cast<unsigned long long>(newTabs.latency.GetMax()), newTabs.loadFrames);
+    settled = RunUntilSettled(browser, drain) && opened && settled;
+
+    StaleTabResult stale;
+    bool closedStale = RunStaleTabs(browser, tabCount + newTabs.opened + 1, 8, stale);
+    printf("stale ids  %zu tabs closed while created, %zu WebViews leaked, reused id %s\n",
+        stale.closed, stale.leaked, stale.recreated ? "recreated" : "missing");
+    settled = closedStale && stale.leaked == 0 && stale.recreated && settled;
+
+    bool registered = false;
+    bool devTools = RunDevTools(browser, tabCount + newTabs.opened + stale.closed + 1, registered);
+    printf("devtools   window %s for its tab\n", registered ? "indexed" : "not indexed");
+    settled = devTools && registered && settled;
+
+    RecordingResult recording;
+    bool recorded = RunRecording(browser, tabCount + newTabs.opened + stale.closed + 2, recording);
+    printf("recording  %zu open tabs logged, %zu of them active, recording tab %s\n",
+        recording.creates, recording.activeCreates, recording.metricsTab ? "included" : "missing");
+    settled = recorded && recording.creates == tabCount + newTabs.opened + 1 && recording.activeCreates == 1 &&
+        recording.metricsTab && settled;
+
+    TasksResult tasks;
+    bool sampled = RunTasks(browser, tabCount + newTabs.opened + stale.closed + 3, tasks);
+    printf("tasks      %zu tabs listed, %zu of %zu with a WebView measured, %zu replies to a web page\n",
+        tasks.tasks, tasks.measured, tasks.webviews, tasks.refused);
+    settled = sampled && tasks.tasks == tabCount + newTabs.opened + 1 && tasks.measured == tasks.webviews &&
+        tasks.refused == 0 && settled;
+
+    WindowsResult windows;
+    bool moved = RunWindows(browser, tabCount + newTabs.opened + stale.closed + 4, windows);
+    printf("windows    moved tab %s, %s, %zu processes started, moved back %s\n",
+        windows.listed ? "listed" : "missing", windows.kept ? "kept running" : "reloaded",
+        windows.newProcesses, windows.movedBack ? "yes" : "no");
+    settled = moved && windows.listed && windows.kept && windows.newProcesses == 0 && windows.movedBack && settled;
+
+    ResizeResult resize;
+    bool resized = RunResize(browser, tabCount + newTabs.opened + stale.closed + 5, resize);
+    printf("resize     %zu sizes in %zu frames laid out %zu times, %s, bar %d px at 144 dpi\n",
+        resize.sizes, resize.frames, resize.layouts, resize.final ? "last size kept" : "last size lost",
+        resize.scaledBarHeight);
+    settled = resized && resize.layouts <= resize.frames + 1 && resize.final && resize.scaledBarHeight == 105 && settled;
+
+    browser.Close();
+
+    SessionResult session;
+    HeadlessBrowser relaunched;
+    bool torn = TearSessionJournal();
+    bool restoredSession = torn && relaunched.Launch() && RunSessionRestore(relaunched, 1, session);
+    printf("session    %zu tabs restored in %llu ns with %zu WebViews, first switch loaded in %zu frames\n",
+        session.tabs, static_cast<unsigned long long>(session.restoreTime), session.webviews, session.switchFrames);
+    settled = restoredSession && session.tabs == tabCount + newTabs.opened && session.webviews == 1 && settled;
+    if (relaunched.GetControls() != nullptr)
+        relaunched.Close();
+
+    size_t failures = MockPlatform::GetFailureCount();
+    if (!settled || failures > 0 || !MockPlatform::IsQuitPosted())
+    {
+        fprintf(stderr, "failed: settled %d, %zu host errors, window closed %d\n",
+            settled, failures, MockPlatform::IsQuitPosted());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "HeadlessBrowser.h"
+#include <cstdio>
+#include "BrowserWindow.h"
+#include "MockPlatform.h"
+
+bool HeadlessBrowser::Launch()
+{
+    HINSTANCE hInstance = GetModuleHandle(nullptr);
+    BrowserWindow::RegisterClass(hInstance);
+    // Frames include the work the host does on its workers
+    MockPlatform::SetIdleHandler(BrowserWindow::WaitForBackgroundWork);
+    if (!BrowserWindow::LaunchWindow(hInstance, SW_SHOW))
+        return false;
+
+    MockPlatform::RunUntilIdle();
+    m_controls = MockHost::FindWebView(L"controls_ui/default.html");
+    m_options = MockHost::FindWebView(L"controls_ui/options.html");
+    return m_controls != nullptr && m_options != nullptr && RunUntilSettled();
+}
+
+void HeadlessBrowser::Close()
+{
+    m_controls->DispatchMessageFromPage(L"{\"message\":" + std::to_wstring(MG_CLOSE_WINDOW) + L",\"args\":{}}");
+    MockPlatform::RunUntilIdle();
+    m_controls = nullptr;
+    m_options = nullptr;
+}
+
+BrowserWindow* HeadlessBrowser::GetWindow() const
+{
+    HWND hWnd = m_controls != nullptr ? GetParent(m_controls->GetController()->GetWindow()) : nullptr;
+    return hWnd != nullptr ? reinterpret_cast<BrowserWindow*>(GetWindowLongPtr(hWnd, GWLP_USERDATA)) : nullptr;
+}
+
+bool HeadlessBrowser::RunUntilSettled(const std::function<void()>& onFrame)
+{
+    for (size_t frames = 0;; ++frames)
+    {
+        MockPlatform::RunUntilIdle();
+        if (onFrame)
+            onFrame();
+
+        if (!IsAnyWebViewLoading() && !MockPlatform::HasTimers())
+            return true;
+        if (frames == c_maxFrames)
+            return false;
+
+        MockPlatform::AdvanceTime(c_frameInterval);
+    }
+}
+
+void HeadlessBrowser::RunUntil(uint64_t time)
+{
+    uint64_t now = MockPlatform::GetTime();
+    if (time > now)
+        MockPlatform::AdvanceTime(static_cast<uint32_t>(time - now));
+    else
+        MockPlatform::RunUntilIdle();
+}
+
+bool HeadlessBrowser::IsAnyWebViewLoading()
+{
+    for (MockWebView* webview : MockHost::GetWebViews())
+    {
+        if (webview->IsLoading())
+            return true;
+    }
+    return false;
+}
+
+void PrintLatency(const char* name, const LatencyHistogram& latency, double seconds)
+{
+    printf("%-10s %10.0f msg/s  p50 %6llu ns  p99 %6llu ns  max %8llu ns\n", name,
+        seconds > 0 ? latency.GetCount() / seconds : 0.0,
+        static_cast<unsigned long long>(latency.GetPercentile(0.5)),
+        static_cast<unsigned long long>(latency.GetPercentile(0.99)),
+        static_cast<unsigned long long>(latency.GetMax()));
+}
@@ -0,0 +1,44 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <functional>
+#include "MessageMetrics.h"
+#include "MockWebView.h"
+
+class BrowserWindow;
+
+// A browser window running on the mock platform, stepped frame by frame by
+// the headless tools
+class HeadlessBrowser
+{
+public:
+    static const uint32_t c_frameInterval = 16;
+    static const size_t c_maxFrames = 1000000;
+
+    // Opens the window and waits for the controls and options UI
+    bool Launch();
+    void Close();
+
+    MockWebView* GetControls() const { return m_controls; }
+    MockWebView* GetOptions() const { return m_options; }
+    // The window hosting the controls UI
+    BrowserWindow* GetWindow() const;
+
+    // Runs frames until every WebView finished loading and no timer is
+    // left. onFrame runs after each frame's queue, including the first.
+    bool RunUntilSettled(const std::function<void()>& onFrame = nullptr);
+    // Runs the timers due until the virtual clock reaches time, in ms
+    void RunUntil(uint64_t time);
+
+    static bool IsAnyWebViewLoading();
+
+private:
+    MockWebView* m_controls = nullptr;
+    MockWebView* m_options = nullptr;
+};
+
+// name  msg/s  p50  p99  max, one line
+void PrintLatency(const char* name, const LatencyHistogram& latency, double seconds);
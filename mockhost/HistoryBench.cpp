@@ -0,0 +1,341 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// HistoryBench.cpp : Fills the history store with a large history and
+// measures what the browser does with it: recording visits, merging a visit
+// to a site already visited that day, serving pages of the history page
+// near the top and deep down, writing the changes a batch at a time as the
+// host's timer does, searching titles and URIs, suggesting
+// addresses as they're typed, and writing and loading the log and the search
+// index. Pages are compared with the walk the controls UI used to do, an
+// IndexedDB cursor stepped past every entry before the requested one.
+//
+// history_bench [--entries N] [--pages N]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <vector>
+#include "HistoryIndex.h"
+#include "HistoryStore.h"
+#include "SuggestionIndex.h"
+
+namespace
+{
+    const size_t c_pageSize = 20;
+    const int64_t c_start = 20000LL * 86400000; // ms since 1970
+    const int64_t c_visitInterval = 5000; // ms between visits
+    const size_t c_suggestionCount = 8;
+    const size_t c_tabCount = 50;
+    const size_t c_batchSize = 20; // Visits between writes, about a second of a busy session
+
+    std::wstring MakeUri(size_t i)
+    {
+        return L"https://site" + std::to_wstring(i % 5000) + L".example.com/articles/" + std::to_wstring(i);
+    }
+
+    int64_t GetDay(int64_t timestamp)
+    {
+        return timestamp / 86400000;
+    }
+
+    double GetSeconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // What the history page got from the IndexedDB cursor walk: the entries
+    // from the newest one on, those before the offset skipped
+    size_t WalkToOffset(const HistoryStore& history, size_t offset, std::vector<const HistoryEntry*>& page)
+    {
+        history.GetPage(std::nullopt, offset + c_pageSize, page);
+        return page.size() > offset ? page.size() - offset : 0;
+    }
+
+    // Whether the entry has every word, read without the index
+    bool IsMatch(const HistoryEntry& entry, const std::vector<std::wstring>& words)
+    {
+        std::wstring uri;
+        std::wstring title;
+        HistoryIndex::Fold(entry.uri, uri);
+        HistoryIndex::Fold(entry.titleJson.size() >= 2 ? std::wstring_view(entry.titleJson).substr(1, entry.titleJson.size() - 2) : L"", title);
+        return std::all_of(words.begin(), words.end(), [&](const std::wstring& word)
+        {
+            return uri.find(word) != std::wstring::npos || title.find(word) != std::wstring::npos;
+        });
+    }
+
+    // Whether the host of the URI starts with the text, read without the
+    // suggestion index
+    bool IsHostMatch(const std::wstring& uri, std::wstring_view text)
+    {
+        std::wstring_view host = std::wstring_view(uri).substr(uri.find(L"://") + 3);
+        return host.substr(0, text.size()) == text;
+    }
+
+    bool ParseCount(const char* text, size_t& value)
+    {
+        char* end = nullptr;
+        unsigned long long parsed = strtoull(text, &end, 10);
+        if (end == text || *end != '\0' || parsed == 0)
+            return false;
+        value = static_cast<size_t>(parsed);
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t entryCount = 1000000;
+    size_t pageCount = 200;
+    for (int i = 1; i < argc; ++i)
+    {
+        bool valid = i + 1 < argc;
+        if (valid && strcmp(argv[i], "--entries") == 0)
+            valid = ParseCount(argv[++i], entryCount);
+        else if (valid && strcmp(argv[i], "--pages") == 0)
+            valid = ParseCount(argv[++i], pageCount);
+        else
+            valid = false;
+        if (!valid)
+        {
+            fprintf(stderr, "usage: history_bench [--entries N>0] [--pages N>0]\n");
+            return 2;
+        }
+    }
+
+    HistoryStore history;
+    std::vector<uint8_t> log;
+    history.WriteSnapshot(log);
+
+    // Every visit as the host records it, title and favicon once the page
+    // reports them, and the records written a batch at a time
+    std::vector<uint8_t> records;
+    size_t writes = 0;
+    auto write = [&]()
+    {
+        history.TakeRecords(records);
+        log.insert(log.end(), records.begin(), records.end());
+        writes += records.empty() ? 0 : 1;
+    };
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < entryCount; ++i)
+    {
+        int64_t timestamp = c_start + static_cast<int64_t>(i) * c_visitInterval;
+        std::wstring uri = MakeUri(i);
+        uint64_t id = history.AddVisit(uri, timestamp, GetDay(timestamp));
+        history.SetTitle(id, L"\"Article " + std::to_wstring(i) + L"\"");
+        history.SetFavicon(id, L"\"https://site" + std::to_wstring(i % 5000) + L".example.com/favicon.ico\"");
+        if ((i + 1) % c_batchSize == 0)
+            write();
+    }
+    write();
+    double addSeconds = GetSeconds(start);
+    double addBytes = static_cast<double>(log.size()) / entryCount;
+    size_t addWrites = writes;
+
+    // Recent sites visited again the same day, each one a lookup of its URI
+    // and day that updates the entry
+    size_t revisitCount = entryCount / 10;
+    size_t recent = std::min<size_t>(entryCount, 1000);
+    int64_t now = c_start + static_cast<int64_t>(entryCount) * c_visitInterval;
+    size_t merged = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < revisitCount; ++i, ++now)
+    {
+        size_t visited = entryCount - 1 - (i * 7919) % recent;
+        uint64_t id = history.AddVisit(MakeUri(visited), now, GetDay(now));
+        merged += id == visited + 1 ? 1 : 0;
+        if ((i + 1) % c_batchSize == 0)
+            write();
+    }
+    write();
+    double revisitSeconds = GetSeconds(start);
+
+    // Pages at increasing depths, each following the cursor of the last
+    std::vector<const HistoryEntry*> page;
+    std::vector<size_t> offsets = { 0, entryCount / 100, entryCount / 2, entryCount - std::min(entryCount, c_pageSize) };
+    double cursorMicroseconds[4] = {};
+    double walkMicroseconds[4] = {};
+    for (size_t depth = 0; depth < offsets.size(); ++depth)
+    {
+        std::optional<HistoryCursor> after;
+        if (offsets[depth] != 0)
+        {
+            WalkToOffset(history, offsets[depth] - 1, page);
+            HistoryCursor cursor;
+            HistoryStore::ParseCursor(HistoryStore::FormatCursor(*page.back()), cursor);
+            after = cursor;
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < pageCount; ++i)
+            history.GetPage(after, c_pageSize, page);
+        cursorMicroseconds[depth] = GetSeconds(start) * 1e6 / pageCount;
+
+        // The walk is linear in the offset, a few runs are enough
+        size_t walks = std::max<size_t>(1, pageCount / 50);
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < walks; ++i)
+            WalkToOffset(history, offsets[depth], page);
+        walkMicroseconds[depth] = GetSeconds(start) * 1e6 / walks;
+    }
+
+    // The whole history through the cursors, as a user scrolling to the end
+    start = std::chrono::steady_clock::now();
+    std::optional<HistoryCursor> after;
+    size_t seen = 0;
+    bool ordered = true;
+    int64_t previous = INT64_MAX;
+    for (bool more = true; more;)
+    {
+        more = history.GetPage(after, c_pageSize, page);
+        for (const HistoryEntry* entry : page)
+        {
+            ordered = ordered && entry->timestamp <= previous;
+            previous = entry->timestamp;
+        }
+        seen += page.size();
+        if (!page.empty())
+            after = HistoryCursor{ page.back()->timestamp, page.back()->id };
+    }
+    double scrollSeconds = GetSeconds(start);
+
+    // First pages of searches, from a word in a few titles to one in every
+    // URI, each checked against reading every entry
+    const wchar_t* queries[] = { L"article 123456", L"site42.", L"ARTICLES/99", L"example article", L"favicon", L"no-such-site" };
+    double searchMicroseconds[std::size(queries)] = {};
+    size_t found[std::size(queries)] = {};
+    bool isSearched = true;
+    std::vector<const HistoryEntry*> all;
+    history.GetPage(std::nullopt, history.GetCount(), all);
+    for (size_t q = 0; q < std::size(queries); ++q)
+    {
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < pageCount; ++i)
+            history.Search(queries[q], std::nullopt, c_pageSize, page);
+        searchMicroseconds[q] = GetSeconds(start) * 1e6 / pageCount;
+        found[q] = page.size();
+
+        std::vector<std::wstring> words;
+        HistoryIndex::SplitQuery(queries[q], words);
+        std::vector<const HistoryEntry*> expected;
+        for (size_t i = 0; i < all.size() && expected.size() < c_pageSize; ++i)
+        {
+            if (IsMatch(*all[i], words))
+                expected.push_back(all[i]);
+        }
+        isSearched = isSearched && page == expected;
+    }
+
+    // The address bar: the suggestions built from the history as a launch
+    // does, then every keystroke of a few addresses typed out, with tabs open
+    start = std::chrono::steady_clock::now();
+    SuggestionIndex suggestions;
+    for (auto it = all.rbegin(); it != all.rend(); ++it)
+        suggestions.AddVisit((*it)->uri, (*it)->timestamp, (*it)->id, true);
+    double suggestionBuildSeconds = GetSeconds(start);
+    std::vector<std::wstring> tabUris;
+    std::vector<KnownPage> tabs;
+    for (size_t i = 0; i < c_tabCount; ++i)
+        tabUris.push_back(MakeUri(i * 7919 % entryCount));
+    for (const std::wstring& uri : tabUris)
+        tabs.push_back({ uri, L"" });
+    const wchar_t* typed[] = { L"site42.example.com/articles/", L"articles", L"https://www.example.com", L"zzz" };
+    std::vector<Suggestion> suggested;
+    double keystrokeMicroseconds = 0;
+    double worstKeystrokeMicroseconds = 0;
+    size_t keystrokes = 0;
+    for (const wchar_t* address : typed)
+    {
+        std::wstring_view text = address;
+        for (size_t length = 1; length <= text.size(); ++length)
+        {
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < pageCount; ++i)
+                suggestions.Find(text.substr(0, length), tabs, {}, now, c_suggestionCount, suggested);
+            double microseconds = GetSeconds(start) * 1e6 / pageCount;
+            keystrokeMicroseconds += microseconds;
+            worstKeystrokeMicroseconds = std::max(worstKeystrokeMicroseconds, microseconds);
+            ++keystrokes;
+        }
+    }
+    keystrokeMicroseconds /= keystrokes;
+
+    // The best of the hosts that start the same, against ranking them all
+    suggestions.Find(L"site42", {}, {}, now, c_suggestionCount, suggested);
+    std::vector<double> expectedScores;
+    for (const HistoryEntry* entry : all)
+    {
+        if (IsHostMatch(entry->uri, L"site42"))
+            expectedScores.push_back(suggestions.GetScore(entry->uri));
+    }
+    std::sort(expectedScores.begin(), expectedScores.end(), std::greater<double>());
+    expectedScores.resize(std::min(expectedScores.size(), c_suggestionCount));
+    bool isSuggested = suggested.size() == expectedScores.size();
+    for (size_t i = 0; isSuggested && i < suggested.size(); ++i)
+        isSuggested = suggested[i].score == expectedScores[i] && IsHostMatch(std::wstring(suggested[i].uri), L"site42");
+
+    // Restart: the log replayed and compacted, then the snapshot loaded
+    start = std::chrono::steady_clock::now();
+    HistoryStore loaded;
+    bool isLoaded = loaded.Load(log);
+    double loadSeconds = GetSeconds(start);
+    start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> snapshot;
+    loaded.WriteSnapshot(snapshot);
+    double snapshotSeconds = GetSeconds(start);
+    start = std::chrono::steady_clock::now();
+    HistoryStore compacted;
+    bool isCompacted = compacted.Load(snapshot);
+    double reloadSeconds = GetSeconds(start);
+
+    // The search index saved at exit, and the log loaded with it
+    start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> index;
+    history.WriteIndex(index);
+    double indexWriteSeconds = GetSeconds(start);
+    start = std::chrono::steady_clock::now();
+    HistoryStore indexed;
+    bool isIndexed = indexed.Load(log, index) && !indexed.HasIndexChanges();
+    double indexedLoadSeconds = GetSeconds(start);
+    indexed.Search(queries[0], std::nullopt, c_pageSize, page);
+    isIndexed = isIndexed && page.size() == found[0];
+
+    printf("%zu entries, %zu revisits merged\n", history.GetCount(), merged);
+    printf("add        %10.0f visits/s, %.0f bytes written per visit, %zu writes\n", entryCount / addSeconds, addBytes, addWrites);
+    printf("revisit    %10.0f visits/s\n", revisitCount / revisitSeconds);
+    for (size_t depth = 0; depth < offsets.size(); ++depth)
+    {
+        printf("page @%-8zu cursor %8.2f us   offset walk %10.2f us\n", offsets[depth], cursorMicroseconds[depth], walkMicroseconds[depth]);
+    }
+    printf("scroll     %zu entries in %.0f ms\n", seen, scrollSeconds * 1e3);
+    for (size_t q = 0; q < std::size(queries); ++q)
+        printf("search     %-16ls %3zu found %10.2f us\n", queries[q], found[q], searchMicroseconds[q]);
+    printf("suggest    %zu URIs indexed in %.0f ms, %zu keystrokes %8.2f us each, %.2f us at worst\n",
+        suggestions.GetCount(), suggestionBuildSeconds * 1e3, keystrokes, keystrokeMicroseconds, worstKeystrokeMicroseconds);
+    printf("load       %.1f MB log in %.0f ms, snapshot %.1f MB written in %.0f ms and loaded in %.0f ms\n",
+        log.size() / 1e6, loadSeconds * 1e3, snapshot.size() / 1e6, snapshotSeconds * 1e3, reloadSeconds * 1e3);
+    printf("index      %.1f MB written in %.0f ms, log loaded with it in %.0f ms\n",
+        index.size() / 1e6, indexWriteSeconds * 1e3, indexedLoadSeconds * 1e3);
+
+    if (seen != history.GetCount() || !ordered || !isLoaded || loaded.GetCount() != history.GetCount() ||
+        !isCompacted || compacted.GetCount() != history.GetCount() || !isSearched || !isIndexed || !isSuggested)
+    {
+        fprintf(stderr, "failed: the history doesn't read back as it was written\n");
+        return 1;
+    }
+    // The deepest page costs what the first one does, not what the walk does
+    if (entryCount >= 10000 && cursorMicroseconds[3] > walkMicroseconds[3])
+    {
+        fprintf(stderr, "failed: a deep page is as slow as walking to it\n");
+        return 1;
+    }
+    return 0;
+}
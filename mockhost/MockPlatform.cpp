@@ -0,0 +1,1766 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "MockPlatform.h"
+#include <Commctrl.h>
+#include <Urlmon.h>
+#include <psapi.h>
+#include <shlobj.h>
+#include <tlhelp32.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <unistd.h>
+#include "resource.h"
+
+struct HWND__
+{
+    struct Subclass
+    {
+        SUBCLASSPROC proc;
+        UINT_PTR id;
+        DWORD_PTR refData;
+    };
+
+    std::wstring className;
+    std::wstring title;
+    WNDPROC proc = nullptr;
+    LONG_PTR userData = 0;
+    LONG style = 0;
+    HWND parent = nullptr; // The owner for top level windows
+    DWORD processId = 0;
+    RECT rect = {}; // In the parent's client area, or on the screen
+    bool visible = false;
+    bool destroying = false;
+    std::vector<HWND> children; // Top of the z-order first
+    std::vector<Subclass> subclasses;
+};
+
+struct HWINEVENTHOOK__
+{
+    DWORD eventMin = 0;
+    DWORD eventMax = 0;
+    WINEVENTPROC proc = nullptr;
+    DWORD processId = 0; // 0 for every process
+};
+
+namespace
+{
+    const wchar_t c_modulePath[] = L"C:\\Program Files\\WebView2Browser\\WebViewBrowserApp.exe";
+    const wchar_t c_appDataPath[] = L"C:\\Users\\User\\AppData\\Roaming";
+    const int c_defaultWidth = 1280;
+    const int c_defaultHeight = 800;
+    const uint64_t c_bootTime = 1000000; // GetTickCount64 at virtual time 0
+
+    struct MockHandle
+    {
+        virtual ~MockHandle() = default;
+    };
+
+    struct ProcessEntry
+    {
+        DWORD id;
+        DWORD parentId;
+        std::wstring exeFile;
+        uint64_t workingSet = 0; // Bytes
+        uint64_t cpuTime = 0; // us
+    };
+
+    struct ProcessHandle : public MockHandle
+    {
+        DWORD id = 0;
+    };
+
+    struct SnapshotHandle : public MockHandle
+    {
+        std::vector<ProcessEntry> processes;
+        size_t next = 0;
+    };
+
+    struct FileEntry
+    {
+        std::wstring path;
+        std::shared_ptr<std::string> data;
+    };
+
+    struct FileHandle : public MockHandle
+    {
+        std::shared_ptr<std::string> data;
+        size_t position = 0;
+        DWORD access = 0;
+    };
+
+    struct Timer
+    {
+        HWND hWnd;
+        UINT_PTR id;
+        UINT interval;
+        uint64_t due;
+        TIMERPROC proc;
+    };
+
+    // Processes and windows are read from the executor's workers, everything
+    // shared is guarded by this. Window procedures run without it.
+    std::recursive_mutex g_lock;
+    std::unordered_map<std::wstring, WNDPROC> g_classes;
+    ATOM g_nextAtom = 0xC000;
+    std::vector<std::unique_ptr<HWND__>> g_allWindows; // Never reused while running
+    std::unordered_set<HWND> g_windows;
+    std::vector<HWND> g_topLevel; // Top of the z-order first
+    std::vector<std::unique_ptr<HWINEVENTHOOK__>> g_winEventHooks;
+    HWND g_focus = nullptr;
+
+    std::deque<std::function<void()>> g_queue;
+    std::function<void()> g_idleHandler;
+    std::vector<Timer> g_timers;
+    UINT_PTR g_nextTimerId = 0x1000;
+    uint64_t g_now = 0;
+    bool g_quitPosted = false;
+
+    UINT g_dpi = 96;
+    std::unordered_map<int, bool> g_keys;
+
+    std::vector<ProcessEntry> g_processes;
+    DWORD g_nextProcessId = 20000;
+    std::unordered_set<MockHandle*> g_handles;
+    std::map<std::wstring, FileEntry> g_files;
+
+    size_t g_failures = 0;
+    bool g_debugOutput = false;
+
+    thread_local DWORD t_lastError = 0;
+    // The subclass procedures running on this thread and the index of the
+    // next one down the chain, for DefSubclassProc
+    thread_local std::vector<std::pair<HWND, size_t>> t_subclassStack;
+
+    HWND__* Lookup(HWND hWnd)
+    {
+        return g_windows.count(hWnd) != 0 ? hWnd : nullptr;
+    }
+
+    std::vector<HWND>& GetSiblings(HWND__* window)
+    {
+        if (window->parent != nullptr && (window->style & WS_CHILD))
+            return window->parent->children;
+        return g_topLevel;
+    }
+
+    POINT GetScreenOrigin(HWND__* window)
+    {
+        POINT origin = { 0, 0 };
+        for (; window != nullptr; window = (window->style & WS_CHILD) ? window->parent : nullptr)
+        {
+            origin.x += window->rect.left;
+            origin.y += window->rect.top;
+        }
+        return origin;
+    }
+
+    std::wstring ToFileKey(LPCWSTR path)
+    {
+        std::wstring key(path);
+        for (auto& c : key)
+            c = (c == L'/') ? L'\\' : static_cast<wchar_t>(towlower(c));
+        return key;
+    }
+
+    void CopyString(const std::wstring& source, LPWSTR buffer, size_t size)
+    {
+        if (size == 0)
+            return;
+        size_t length = std::min(source.size(), size - 1);
+        wmemcpy(buffer, source.data(), length);
+        buffer[length] = L'\0';
+    }
+
+    std::wstring FromUtf8(const char* text, size_t length)
+    {
+        std::wstring result;
+        for (size_t i = 0; i < length;)
+        {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            int extra = c < 0x80 ? 0 : c < 0xE0 ? 1 : c < 0xF0 ? 2 : 3;
+            uint32_t codePoint = extra == 0 ? c : c & (0x3F >> extra);
+            for (int j = 1; j <= extra && i + j < length; ++j)
+                codePoint = (codePoint << 6) | (static_cast<unsigned char>(text[i + j]) & 0x3F);
+            result.push_back(static_cast<wchar_t>(codePoint));
+            i += extra + 1;
+        }
+        return result;
+    }
+
+    LRESULT CallWindow(HWND hWnd, size_t index, UINT message, WPARAM wParam, LPARAM lParam)
+    {
+        WNDPROC proc = nullptr;
+        HWND__::Subclass subclass = {};
+        {
+            std::lock_guard<std::recursive_mutex> lock(g_lock);
+            HWND__* window = Lookup(hWnd);
+            if (window == nullptr)
+                return 0;
+
+            index = std::min(index, window->subclasses.size());
+            if (index == 0)
+                proc = window->proc;
+            else
+                subclass = window->subclasses[index - 1];
+        }
+
+        if (index == 0)
+            return proc != nullptr ? proc(hWnd, message, wParam, lParam) : DefWindowProcW(hWnd, message, wParam, lParam);
+
+        t_subclassStack.emplace_back(hWnd, index - 1);
+        LRESULT result = subclass.proc(hWnd, message, wParam, lParam, subclass.id, subclass.refData);
+        t_subclassStack.pop_back();
+        return result;
+    }
+
+    // Each hook gets the event through the queue, unless it's gone by then
+    void PostWinEvent(DWORD event, HWND hWnd, DWORD processId)
+    {
+        std::lock_guard<std::recursive_mutex> lock(g_lock);
+        for (const auto& hook : g_winEventHooks)
+        {
+            if (event < hook->eventMin || event > hook->eventMax || (hook->processId != 0 && hook->processId != processId))
+                continue;
+            HWINEVENTHOOK target = hook.get();
+            MockPlatform::PostTask([target, event, hWnd]()
+            {
+                WINEVENTPROC proc = nullptr;
+                {
+                    std::lock_guard<std::recursive_mutex> lock(g_lock);
+                    auto it = std::find_if(g_winEventHooks.begin(), g_winEventHooks.end(),
+                        [target](const auto& hook) { return hook.get() == target; });
+                    if (it == g_winEventHooks.end())
+                        return;
+                    proc = target->proc;
+                }
+                proc(target, event, hWnd, OBJID_WINDOW, CHILDID_SELF, 0, static_cast<DWORD>(g_now));
+            });
+        }
+    }
+
+    HWND CreateWindowInternal(LPCWSTR className, LPCWSTR title, DWORD style, int x, int y, int width, int height,
+        HWND parent, DWORD processId, WNDPROC proc, LPVOID param)
+    {
+        if (x == CW_USEDEFAULT)
+            x = y = 0;
+        if (width == CW_USEDEFAULT)
+        {
+            width = c_defaultWidth;
+            height = c_defaultHeight;
+        }
+
+        auto window = std::make_unique<HWND__>();
+        window->className = className;
+        window->title = title != nullptr ? title : L"";
+        window->proc = proc;
+        window->style = static_cast<LONG>(style);
+        window->parent = parent;
+        window->processId = processId;
+        window->rect = { x, y, x + width, y + height };
+        window->visible = (style & WS_VISIBLE) != 0;
+
+        HWND hWnd = window.get();
+        {
+            std::lock_guard<std::recursive_mutex> lock(g_lock);
+            if (parent != nullptr && Lookup(parent) == nullptr)
+            {
+                t_lastError = ERROR_INVALID_WINDOW_HANDLE;
+                return nullptr;
+            }
+
+            g_allWindows.push_back(std::move(window));
+            g_windows.insert(hWnd);
+            auto& siblings = GetSiblings(hWnd);
+            siblings.insert(siblings.begin(), hWnd);
+        }
+
+        CREATESTRUCTW create = { param, nullptr, nullptr, parent, height, width, y, x,
+            static_cast<LONG>(style), title, className, 0 };
+        if (SendMessageW(hWnd, WM_CREATE, 0, reinterpret_cast<LPARAM>(&create)) == -1)
+        {
+            DestroyWindow(hWnd);
+            return nullptr;
+        }
+        SendMessageW(hWnd, WM_SIZE, 0, MAKELPARAM(width, height));
+        PostWinEvent(EVENT_OBJECT_CREATE, hWnd, processId);
+
+        return hWnd;
+    }
+}
+
+// Event loop
+
+size_t MockPlatform::RunUntilIdle()
+{
+    size_t count = 0;
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::recursive_mutex> lock(g_lock);
+            if (g_queue.empty())
+            {
+                // Work on other threads may still post to the queue
+                if (!g_idleHandler)
+                    break;
+                std::function<void()> idleHandler = g_idleHandler;
+                g_lock.unlock();
+                idleHandler();
+                g_lock.lock();
+                if (g_queue.empty())
+                    break;
+            }
+            task = std::move(g_queue.front());
+            g_queue.pop_front();
+        }
+        task();
+        ++count;
+    }
+    return count;
+}
+
+void MockPlatform::AdvanceTime(uint32_t ms)
+{
+    RunUntilIdle();
+
+    uint64_t target = g_now + ms;
+    for (;;)
+    {
+        Timer timer;
+        {
+            std::lock_guard<std::recursive_mutex> lock(g_lock);
+            auto next = std::min_element(g_timers.begin(), g_timers.end(),
+                [](const Timer& a, const Timer& b) { return a.due < b.due; });
+            if (next == g_timers.end() || next->due > target)
+                break;
+
+            g_now = std::max(g_now, next->due);
+            next->due = g_now + next->interval;
+            timer = *next;
+        }
+
+        if (timer.proc != nullptr)
+            timer.proc(timer.hWnd, WM_TIMER, timer.id, static_cast<DWORD>(GetTickCount64()));
+        else
+            PostMessageW(timer.hWnd, WM_TIMER, timer.id, 0);
+        RunUntilIdle();
+    }
+    g_now = target;
+}
+
+uint64_t MockPlatform::GetTime()
+{
+    return g_now;
+}
+
+bool MockPlatform::HasTimers()
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    return !g_timers.empty();
+}
+
+void MockPlatform::SetIdleHandler(std::function<void()> handler)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    g_idleHandler = std::move(handler);
+}
+
+void MockPlatform::PostTask(std::function<void()> task)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    g_queue.push_back(std::move(task));
+}
+
+bool MockPlatform::IsQuitPosted()
+{
+    return g_quitPosted;
+}
+
+HWND MockPlatform::CreateForeignWindow(LPCWSTR className, LPCWSTR title, DWORD style, HWND parent, DWORD processId)
+{
+    return CreateWindowInternal(className, title, style, 0, 0, 0, 0, parent, processId, nullptr, nullptr);
+}
+
+void MockPlatform::ResizeWindow(HWND hWnd, int width, int height)
+{
+    SetWindowPos(hWnd, nullptr, 0, 0, width, height, SWP_NOMOVE | SWP_NOZORDER);
+}
+
+void MockPlatform::SetDpi(UINT dpi)
+{
+    g_dpi = dpi;
+}
+
+void MockPlatform::SetKeyState(int virtKey, bool down)
+{
+    g_keys[virtKey] = down;
+}
+
+DWORD MockPlatform::CreateProcess(DWORD parentProcessId, LPCWSTR exeFile)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    DWORD id = g_nextProcessId;
+    g_nextProcessId += 4;
+    g_processes.push_back({ id, parentProcessId, exeFile });
+    return id;
+}
+
+void MockPlatform::SetProcessCounters(DWORD processId, uint64_t workingSet, uint64_t cpuTime)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    for (ProcessEntry& process : g_processes)
+    {
+        if (process.id == processId)
+        {
+            process.workingSet = workingSet;
+            process.cpuTime = cpuTime;
+        }
+    }
+}
+
+void MockPlatform::ExitProcess(DWORD processId)
+{
+    std::vector<HWND> windows;
+    {
+        std::lock_guard<std::recursive_mutex> lock(g_lock);
+        g_processes.erase(std::remove_if(g_processes.begin(), g_processes.end(),
+            [processId](const ProcessEntry& process) { return process.id == processId; }), g_processes.end());
+        for (HWND hWnd : g_topLevel)
+        {
+            if (hWnd->processId == processId)
+                windows.push_back(hWnd);
+        }
+    }
+
+    for (HWND hWnd : windows)
+        DestroyWindow(hWnd);
+}
+
+bool MockPlatform::GetFileContents(const std::wstring& path, std::string& contents)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    auto it = g_files.find(ToFileKey(path.c_str()));
+    if (it == g_files.end())
+        return false;
+
+    contents = *it->second.data;
+    return true;
+}
+
+std::vector<std::wstring> MockPlatform::GetFilePaths()
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    std::vector<std::wstring> paths;
+    for (const auto& file : g_files)
+        paths.push_back(file.second.path);
+    return paths;
+}
+
+size_t MockPlatform::GetFailureCount()
+{
+    return g_failures;
+}
+
+void MockPlatform::SetDebugOutput(bool enabled)
+{
+    g_debugOutput = enabled;
+}
+
+std::wstring MockPlatform::PathToFileUri(const std::wstring& path)
+{
+    bool isDrivePath = path.size() >= 3 && iswalpha(path[0]) && path[1] == L':' && (path[2] == L'\\' || path[2] == L'/');
+    if (!isDrivePath)
+        return path;
+
+    std::wstring uri = L"file:///";
+    for (wchar_t c : path)
+    {
+        if (c == L'\\')
+            uri.push_back(L'/');
+        else if (c == L' ')
+            uri.append(L"%20");
+        else
+            uri.push_back(c);
+    }
+    return uri;
+}
+
+std::string MockPlatform::ToUtf8(const std::wstring& text)
+{
+    std::string result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        uint32_t c = static_cast<uint32_t>(text[i]);
+        if (c >= 0xD800 && c < 0xDC00 && i + 1 < text.size())
+            c = 0x10000 + ((c - 0xD800) << 10) + (static_cast<uint32_t>(text[++i]) - 0xDC00);
+
+        if (c < 0x80)
+        {
+            result.push_back(static_cast<char>(c));
+        }
+        else if (c < 0x800)
+        {
+            result.push_back(static_cast<char>(0xC0 | (c >> 6)));
+            result.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        }
+        else if (c < 0x10000)
+        {
+            result.push_back(static_cast<char>(0xE0 | (c >> 12)));
+            result.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        }
+        else
+        {
+            result.push_back(static_cast<char>(0xF0 | (c >> 18)));
+            result.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        }
+    }
+    return result;
+}
+
+// COM
+
+namespace MockCom
+{
+    uint32_t NextInterfaceId()
+    {
+        static std::atomic<uint32_t> s_next = 1;
+        return s_next.fetch_add(1);
+    }
+}
+
+LPVOID CoTaskMemAlloc(size_t size)
+{
+    return std::malloc(size);
+}
+
+void CoTaskMemFree(LPVOID p)
+{
+    std::free(p);
+}
+
+BSTR SysAllocString(const wchar_t* s)
+{
+    if (s == nullptr)
+        return nullptr;
+
+    size_t length = wcslen(s) + 1;
+    auto copy = static_cast<BSTR>(std::malloc(length * sizeof(wchar_t)));
+    if (copy != nullptr)
+        wmemcpy(copy, s, length);
+    return copy;
+}
+
+void SysFreeString(BSTR s)
+{
+    std::free(s);
+}
+
+namespace
+{
+    class MockUri : public IUri
+    {
+    public:
+        explicit MockUri(std::wstring uri) : m_uri(std::move(uri)) {}
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+        {
+            if (riid == __uuidof(IUri) || riid == __uuidof(IUnknown))
+            {
+                AddRef();
+                *object = static_cast<IUri*>(this);
+                return S_OK;
+            }
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+        ULONG STDMETHODCALLTYPE AddRef() override { return ++m_refCount; }
+        ULONG STDMETHODCALLTYPE Release() override
+        {
+            ULONG count = --m_refCount;
+            if (count == 0)
+                delete this;
+            return count;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetAbsoluteUri(BSTR* absoluteUri) override
+        {
+            *absoluteUri = SysAllocString(m_uri.c_str());
+            return *absoluteUri != nullptr ? S_OK : E_OUTOFMEMORY;
+        }
+
+    private:
+        std::wstring m_uri;
+        std::atomic<ULONG> m_refCount = 0;
+    };
+}
+
+HRESULT CreateUri(LPCWSTR uri, DWORD /*flags*/, DWORD_PTR /*reserved*/, IUri** result)
+{
+    *result = nullptr;
+    std::wstring absolute = MockPlatform::PathToFileUri(uri);
+    if (absolute.find(L':') == std::wstring::npos)
+        return E_INVALIDARG;
+
+    *result = new MockUri(std::move(absolute));
+    (*result)->AddRef();
+    return S_OK;
+}
+
+// Window classes and windows
+
+ATOM RegisterClassExW(const WNDCLASSEXW* wndClass)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    if (!g_classes.emplace(wndClass->lpszClassName, wndClass->lpfnWndProc).second)
+    {
+        t_lastError = ERROR_CLASS_ALREADY_EXISTS;
+        return 0;
+    }
+    return g_nextAtom++;
+}
+
+ATOM RegisterClassW(const WNDCLASSW* wndClass)
+{
+    WNDCLASSEXW wndClassEx = { sizeof(WNDCLASSEXW), wndClass->style, wndClass->lpfnWndProc, 0, 0,
+        wndClass->hInstance, wndClass->hIcon, wndClass->hCursor, wndClass->hbrBackground,
+        wndClass->lpszMenuName, wndClass->lpszClassName, nullptr };
+    return RegisterClassExW(&wndClassEx);
+}
+
+HWND CreateWindowExW(DWORD /*exStyle*/, LPCWSTR className, LPCWSTR windowName, DWORD style,
+    int x, int y, int width, int height, HWND parent, HMENU /*menu*/, HINSTANCE /*instance*/, LPVOID param)
+{
+    WNDPROC proc = nullptr;
+    {
+        std::lock_guard<std::recursive_mutex> lock(g_lock);
+        auto it = g_classes.find(className);
+        if (it == g_classes.end())
+        {
+            t_lastError = ERROR_CANNOT_FIND_WND_CLASS;
+            return nullptr;
+        }
+        proc = it->second;
+    }
+
+    return CreateWindowInternal(className, windowName, style, x, y, width, height, parent,
+        GetCurrentProcessId(), proc, param);
+}
+
+BOOL DestroyWindow(HWND hWnd)
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(g_lock);
+        HWND__* window = Lookup(hWnd);
+        if (window == nullptr || window->destroying)
+        {
+            t_lastError = ERROR_INVALID_WINDOW_HANDLE;
+            return FALSE;
+        }
+        window->destroying = true;
+    }
+
+    SendMessageW(hWnd, WM_DESTROY, 0, 0);
+
+    std::vector<HWND> children;
+    {
+        std::lock_guard<std::recursive_mutex> lock(g_lock);
+        children = hWnd->children;
+    }
+    for (HWND child : children)
+        DestroyWindow(child);
+
+    SendMessageW(hWnd, WM_NCDESTROY, 0, 0);
+    PostWinEvent(EVENT_OBJECT_DESTROY, hWnd, hWnd->processId);
+
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    auto& siblings = GetSiblings(hWnd);
+    siblings.erase(std::remove(siblings.begin(), siblings.end(), hWnd), siblings.end());
+    g_timers.erase(std::remove_if(g_timers.begin(), g_timers.end(),
+        [hWnd](const Timer& timer) { return timer.hWnd == hWnd; }), g_timers.end());
+    g_windows.erase(hWnd);
+    hWnd->subclasses.clear();
+    if (g_focus == hWnd)
+        g_focus = nullptr;
+
+    return TRUE;
+}
+
+BOOL IsWindow(HWND hWnd)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    return Lookup(hWnd) != nullptr;
+}
+
+LRESULT DefWindowProcW(HWND hWnd, UINT message, WPARAM /*wParam*/, LPARAM /*lParam*/)
+{
+    switch (message)
+    {
+    case WM_NCCREATE:
+        return TRUE;
+    case WM_CLOSE:
+        DestroyWindow(hWnd);
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+LONG_PTR GetWindowLongPtrW(HWND hWnd, int index)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    HWND__* window = Lookup(hWnd);
+    if (window == nullptr)
+    {
+        t_lastError = ERROR_INVALID_WINDOW_HANDLE;
+        return 0;
+    }
+    return index == GWLP_USERDATA ? window->userData : index == GWL_STYLE ? window->style : 0;
+}
+
+LONG_PTR SetWindowLongPtrW(HWND hWnd, int index, LONG_PTR value)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    HWND__* window = Lookup(hWnd);
+    if (window == nullptr)
+    {
+        t_lastError = ERROR_INVALID_WINDOW_HANDLE;
+        return 0;
+    }
+
+    LONG_PTR previous = 0;
+    if (index == GWLP_USERDATA)
+    {
+        previous = window->userData;
+        window->userData = value;
+    }
+    else if (index == GWL_STYLE)
+    {
+        previous = window->style;
+        window->style = static_cast<LONG>(value);
+    }
+    return previous;
+}
+
+LONG GetWindowLongW(HWND hWnd, int index)
+{
+    return static_cast<LONG>(GetWindowLongPtrW(hWnd, index));
+}
+
+LONG SetWindowLongW(HWND hWnd, int index, LONG value)
+{
+    return static_cast<LONG>(SetWindowLongPtrW(hWnd, index, value));
+}
+
+int GetClassNameW(HWND hWnd, LPWSTR className, int maxCount)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    HWND__* window = Lookup(hWnd);
+    if (window == nullptr || maxCount <= 0)
+        return 0;
+
+    CopyString(window->className, className, static_cast<size_t>(maxCount));
+    return static_cast<int>(wcslen(className));
+}
+
+HWND GetWindow(HWND hWnd, UINT command)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    HWND__* window = Lookup(hWnd);
+    if (window == nullptr)
+        return nullptr;
+
+    if (command == GW_CHILD)
+        return window->children.empty() ? nullptr : window->children.front();
+
+    auto& siblings = GetSiblings(window);
+    auto it = std::find(siblings.begin(), siblings.end(), hWnd);
+    if (command == GW_HWNDNEXT)
+        return (it == siblings.end() || it + 1 == siblings.end()) ? nullptr : *(it + 1);
+    if (command == GW_HWNDPREV)
+        return (it == siblings.end() || it == siblings.begin()) ? nullptr : *(it - 1);
+    return nullptr;
+}
+
+HWND GetParent(HWND hWnd)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    HWND__* window = Lookup(hWnd);
+    return window != nullptr ? window->parent : nullptr;
+}
+
+HWND SetParent(HWND child, HWND newParent)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    HWND__* window = Lookup(child);
+    if (window == nullptr || (newParent != nullptr && Lookup(newParent) == nullptr))
+    {
+        t_lastError = ERROR_INVALID_WINDOW_HANDLE;
+        return nullptr;
+    }
+
+    HWND previous = window->parent;
+    auto& oldSiblings = GetSiblings(window);
+    oldSiblings.erase(std::remove(oldSiblings.begin(), oldSiblings.end(), child), oldSiblings.end());
+
+    // Like Windows, the style isn't changed: a window without WS_CHILD
+    // stays in the top level list, owned by its new parent
+    window->parent = newParent;
+    auto& newSiblings = GetSiblings(window);
+    newSiblings.insert(newSiblings.begin(), child);
+
+    return previous;
+}
+
+BOOL EnumWindows(WNDENUMPROC enumProc, LPARAM lParam)
+{
+    std::vector<HWND> windows;
+    {
+        std::lock_guard<std::recursive_mutex> lock(g_lock);
+        windows = g_topLevel;
+    }
+
+    for (HWND hWnd : windows)
+    {
+        if (IsWindow(hWnd) && !enumProc(hWnd, lParam))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+DWORD GetWindowThreadProcessId(HWND hWnd, LPDWORD processId)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    HWND__* window = Lookup(hWnd);
+    if (window == nullptr)
+        return 0;
+
+    if (processId != nullptr)
+        *processId = window->processId;
+    // One UI thread per process
+    return window->processId + 1;
+}
+
+HWINEVENTHOOK SetWinEventHook(DWORD eventMin, DWORD eventMax, HMODULE /*module*/, WINEVENTPROC proc,
+    DWORD processId, DWORD /*threadId*/, DWORD /*flags*/)
+{
+    auto hook = std::make_unique<HWINEVENTHOOK__>();
+    hook->eventMin = eventMin;
+    hook->eventMax = eventMax;
+    hook->proc = proc;
+    hook->processId = processId;
+
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    g_winEventHooks.push_back(std::move(hook));
+    return g_winEventHooks.back().get();
+}
+
+BOOL UnhookWinEvent(HWINEVENTHOOK hook)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    auto it = std::find_if(g_winEventHooks.begin(), g_winEventHooks.end(),
+        [hook](const auto& registered) { return registered.get() == hook; });
+    if (it == g_winEventHooks.end())
+        return FALSE;
+    g_winEventHooks.erase(it);
+    return TRUE;
+}
+
+// Geometry and visibility
+
+BOOL ShowWindow(HWND hWnd, int cmdShow)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    HWND__* window = Lookup(hWnd);
+    if (window == nullptr)
+        return FALSE;
+
+    bool wasVisible = window->visible;
+    window->visible = cmdShow != SW_HIDE;
+    return wasVisible;
+}
+
+BOOL IsWindowVisible(HWND hWnd)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    for (HWND__* window = Lookup(hWnd); window != nullptr; window = window->parent)
+    {
+        if (!window->visible)
+            return FALSE;
+        if (!(window->style & WS_CHILD))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+BOOL UpdateWindow(HWND hWnd)
+{
+    return IsWindow(hWnd);
+}
+
+BOOL SetWindowPos(HWND hWnd, HWND insertAfter, int x, int y, int cx, int cy, UINT flags)
+{
+    bool isTopLevel = false;
+    RECT rect = {};
+    {
+        std::lock_guard<std::recursive_mutex> lock(g_lock);
+        HWND__* window = Lookup(hWnd);
+        if (window == nullptr)
+        {
+            t_lastError = ERROR_INVALID_WINDOW_HANDLE;
+            return FALSE;
+        }
+
+        if (!(flags & SWP_NOZORDER) && insertAfter != hWnd)
+        {
+            auto& siblings = GetSiblings(window);
+            siblings.erase(std::remove(siblings.begin(), siblings.end(), hWnd), siblings.end());
+            auto position = siblings.begin();
+            if (insertAfter == HWND_BOTTOM)
+                position = siblings.end();
+            else if (insertAfter != HWND_TOP && insertAfter != HWND_TOPMOST)
+            {
+                position = std::find(siblings.begin(), siblings.end(), insertAfter);
+                position = position == siblings.end() ? siblings.begin() : position + 1;
+            }
+            siblings.insert(position, hWnd);
+        }
+
+        if (flags & SWP_SHOWWINDOW)
+            window->visible = true;
+        if (flags & SWP_HIDEWINDOW)
+            window->visible = false;
+
+        isTopLevel = !(window->style & WS_CHILD);
+        rect = window->rect;
+    }
+
+    int width = rect.right - rect.left;
+    int height = rect.bottom - rect.top;
+    if (!(flags & SWP_NOMOVE))
+    {
+        rect.left = x;
+        rect.top = y;
+    }
+    if (!(flags & SWP_NOSIZE))
+    {
+        if (isTopLevel)
+        {
+            MINMAXINFO minmax = {};
+            minmax.ptMaxTrackSize = { INT_MAX, INT_MAX };
+            SendMessageW(hWnd, WM_GETMINMAXINFO, 0, reinterpret_cast<LPARAM>(&minmax));
+            cx = std::clamp<int>(cx, minmax.ptMinTrackSize.x, minmax.ptMaxTrackSize.x);
+            cy = std::clamp<int>(cy, minmax.ptMinTrackSize.y, minmax.ptMaxTrackSize.y);
+        }
+        width = cx;
+        height = cy;
+    }
+    rect.right = rect.left + width;
+    rect.bottom = rect.top + height;
+
+    RECT previous;
+    {
+        std::lock_guard<std::recursive_mutex> lock(g_lock);
+        HWND__* window = Lookup(hWnd);
+        if (window == nullptr)
+            return FALSE;
+        previous = window->rect;
+        window->rect = rect;
+    }
+
+    if (previous.right - previous.left != width || previous.bottom - previous.top != height)
+        SendMessageW(hWnd, WM_SIZE, 0, MAKELPARAM(width, height));
+    if (previous.left != rect.left || previous.top != rect.top)
+        SendMessageW(hWnd, WM_MOVE, 0, MAKELPARAM(rect.left, rect.top));
+
+    return TRUE;
+}
+
+BOOL MoveWindow(HWND hWnd, int x, int y, int width, int height, BOOL /*repaint*/)
+{
+    return SetWindowPos(hWnd, nullptr, x, y, width, height, SWP_NOZORDER | SWP_NOACTIVATE);
+}
+
+// There is no frame, the client area is the whole window
+BOOL GetClientRect(HWND hWnd, LPRECT rect)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    HWND__* window = Lookup(hWnd);
+    if (window == nullptr)
+        return FALSE;
+
+    *rect = { 0, 0, window->rect.right - window->rect.left, window->rect.bottom - window->rect.top };
+    return TRUE;
+}
+
+BOOL GetWindowRect(HWND hWnd, LPRECT rect)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    HWND__* window = Lookup(hWnd);
+    if (window == nullptr)
+        return FALSE;
+
+    POINT origin = GetScreenOrigin(window);
+    *rect = { origin.x, origin.y,
+        origin.x + window->rect.right - window->rect.left, origin.y + window->rect.bottom - window->rect.top };
+    return TRUE;
+}
+
+int MapWindowPoints(HWND from, HWND to, LPPOINT points, UINT count)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    POINT fromOrigin = from != nullptr && Lookup(from) ? GetScreenOrigin(from) : POINT{ 0, 0 };
+    POINT toOrigin = to != nullptr && Lookup(to) ? GetScreenOrigin(to) : POINT{ 0, 0 };
+    LONG dx = fromOrigin.x - toOrigin.x;
+    LONG dy = fromOrigin.y - toOrigin.y;
+    for (UINT i = 0; i < count; ++i)
+    {
+        points[i].x += dx;
+        points[i].y += dy;
+    }
+    return MAKELONG(dx, dy);
+}
+
+BOOL OffsetRect(LPRECT rect, int dx, int dy)
+{
+    rect->left += dx;
+    rect->right += dx;
+    rect->top += dy;
+    rect->bottom += dy;
+    return TRUE;
+}
+
+UINT GetDpiForWindow(HWND hWnd)
+{
+    return IsWindow(hWnd) ? g_dpi : 0;
+}
+
+int GetSystemMetrics(int index)
+{
+    switch (index)
+    {
+    case SM_CXSCREEN:
+        return 1920;
+    case SM_CYSCREEN:
+        return 1080;
+    case SM_CYCAPTION:
+        return 23;
+    case SM_CXSIZEFRAME:
+    case SM_CYSIZEFRAME:
+        return 4;
+    case SM_CXEDGE:
+    case SM_CYEDGE:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+// Messages and timers
+
+LRESULT SendMessageW(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    return CallWindow(hWnd, SIZE_MAX, message, wParam, lParam);
+}
+
+BOOL PostMessageW(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    if (hWnd != nullptr && !IsWindow(hWnd))
+    {
+        t_lastError = ERROR_INVALID_WINDOW_HANDLE;
+        return FALSE;
+    }
+
+    MockPlatform::PostTask([hWnd, message, wParam, lParam]()
+    {
+        if (hWnd != nullptr)
+            SendMessageW(hWnd, message, wParam, lParam);
+    });
+    return TRUE;
+}
+
+void PostQuitMessage(int /*exitCode*/)
+{
+    g_quitPosted = true;
+}
+
+UINT_PTR SetTimer(HWND hWnd, UINT_PTR id, UINT elapse, TIMERPROC timerFunc)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    if (hWnd != nullptr && Lookup(hWnd) == nullptr)
+    {
+        t_lastError = ERROR_INVALID_WINDOW_HANDLE;
+        return 0;
+    }
+    if (hWnd == nullptr)
+        id = g_nextTimerId++;
+
+    // USER_TIMER_MINIMUM
+    UINT interval = std::max<UINT>(elapse, 10);
+    auto it = std::find_if(g_timers.begin(), g_timers.end(),
+        [hWnd, id](const Timer& timer) { return timer.hWnd == hWnd && timer.id == id; });
+    if (it != g_timers.end())
+        *it = { hWnd, id, interval, g_now + interval, timerFunc };
+    else
+        g_timers.push_back({ hWnd, id, interval, g_now + interval, timerFunc });
+
+    return hWnd != nullptr ? 1 : id;
+}
+
+BOOL KillTimer(HWND hWnd, UINT_PTR id)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    auto it = std::find_if(g_timers.begin(), g_timers.end(),
+        [hWnd, id](const Timer& timer) { return timer.hWnd == hWnd && timer.id == id; });
+    if (it == g_timers.end())
+        return FALSE;
+
+    g_timers.erase(it);
+    return TRUE;
+}
+
+// Input
+
+SHORT GetKeyState(int virtKey)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    auto it = g_keys.find(virtKey);
+    return (it != g_keys.end() && it->second) ? static_cast<SHORT>(0x8000) : 0;
+}
+
+void mouse_event(DWORD flags, DWORD /*dx*/, DWORD /*dy*/, DWORD /*data*/, ULONG_PTR /*extraInfo*/)
+{
+    if (flags & MOUSEEVENTF_LEFTUP)
+        MockPlatform::SetKeyState(VK_LBUTTON, false);
+    if (flags & MOUSEEVENTF_LEFTDOWN)
+        MockPlatform::SetKeyState(VK_LBUTTON, true);
+}
+
+HWND SetFocus(HWND hWnd)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    HWND previous = g_focus;
+    if (hWnd == nullptr || Lookup(hWnd) != nullptr)
+        g_focus = hWnd;
+    return previous;
+}
+
+HWND GetFocus()
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    return g_focus;
+}
+
+// Painting
+
+HDC BeginPaint(HWND hWnd, PAINTSTRUCT* paint)
+{
+    static int s_dc;
+    *paint = {};
+    paint->hdc = &s_dc;
+    GetClientRect(hWnd, &paint->rcPaint);
+    return paint->hdc;
+}
+
+BOOL EndPaint(HWND /*hWnd*/, const PAINTSTRUCT* /*paint*/)
+{
+    return TRUE;
+}
+
+HDC GetWindowDC(HWND hWnd)
+{
+    static int s_dc;
+    return IsWindow(hWnd) ? &s_dc : nullptr;
+}
+
+int ReleaseDC(HWND /*hWnd*/, HDC /*hdc*/)
+{
+    return 1;
+}
+
+HPEN CreatePen(int /*style*/, int /*width*/, DWORD /*color*/)
+{
+    static int s_pen;
+    return &s_pen;
+}
+
+HGDIOBJ SelectObject(HDC /*hdc*/, HGDIOBJ object)
+{
+    return object;
+}
+
+HGDIOBJ GetStockObject(int /*object*/)
+{
+    static int s_stockObject;
+    return &s_stockObject;
+}
+
+BOOL DeleteObject(HGDIOBJ /*object*/)
+{
+    return TRUE;
+}
+
+BOOL MoveToEx(HDC /*hdc*/, int /*x*/, int /*y*/, LPPOINT /*point*/)
+{
+    return TRUE;
+}
+
+BOOL LineTo(HDC /*hdc*/, int /*x*/, int /*y*/)
+{
+    return TRUE;
+}
+
+// Subclassing
+
+BOOL SetWindowSubclass(HWND hWnd, SUBCLASSPROC subclassProc, UINT_PTR idSubclass, DWORD_PTR refData)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    HWND__* window = Lookup(hWnd);
+    if (window == nullptr)
+        return FALSE;
+
+    for (auto& subclass : window->subclasses)
+    {
+        if (subclass.proc == subclassProc && subclass.id == idSubclass)
+        {
+            subclass.refData = refData;
+            return TRUE;
+        }
+    }
+    window->subclasses.push_back({ subclassProc, idSubclass, refData });
+    return TRUE;
+}
+
+BOOL RemoveWindowSubclass(HWND hWnd, SUBCLASSPROC subclassProc, UINT_PTR idSubclass)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    HWND__* window = Lookup(hWnd);
+    if (window == nullptr)
+        return FALSE;
+
+    auto& subclasses = window->subclasses;
+    auto it = std::find_if(subclasses.begin(), subclasses.end(), [subclassProc, idSubclass](const HWND__::Subclass& subclass)
+    {
+        return subclass.proc == subclassProc && subclass.id == idSubclass;
+    });
+    if (it == subclasses.end())
+        return FALSE;
+
+    subclasses.erase(it);
+    return TRUE;
+}
+
+LRESULT DefSubclassProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    for (auto it = t_subclassStack.rbegin(); it != t_subclassStack.rend(); ++it)
+    {
+        if (it->first == hWnd)
+            return CallWindow(hWnd, it->second, message, wParam, lParam);
+    }
+    return CallWindow(hWnd, 0, message, wParam, lParam);
+}
+
+// Resources, modules and processes
+
+int LoadStringW(HINSTANCE /*instance*/, UINT id, LPWSTR buffer, int bufferMax)
+{
+    // The string table of WebViewBrowserApp.rc
+    const wchar_t* text = nullptr;
+    switch (id)
+    {
+    case IDS_APP_TITLE:
+        text = L"WebView2Browser";
+        break;
+    case IDC_WEBVIEWBROWSERAPP:
+        text = L"WEBVIEWBROWSERAPP";
+        break;
+    default:
+        return 0;
+    }
+
+    CopyString(text, buffer, static_cast<size_t>(std::max(bufferMax, 0)));
+    return static_cast<int>(wcslen(buffer));
+}
+
+HICON LoadIconW(HINSTANCE /*instance*/, LPCWSTR /*name*/)
+{
+    static int s_icon;
+    return &s_icon;
+}
+
+HCURSOR LoadCursorW(HINSTANCE /*instance*/, LPCWSTR /*name*/)
+{
+    static int s_cursor;
+    return &s_cursor;
+}
+
+HMODULE GetModuleHandleW(LPCWSTR /*moduleName*/)
+{
+    static int s_module;
+    return reinterpret_cast<HMODULE>(&s_module);
+}
+
+DWORD GetModuleFileNameW(HMODULE /*module*/, LPWSTR fileName, DWORD size)
+{
+    CopyString(c_modulePath, fileName, size);
+    return static_cast<DWORD>(wcslen(fileName));
+}
+
+DWORD GetCurrentProcessId()
+{
+    return static_cast<DWORD>(getpid());
+}
+
+DWORD GetCurrentThreadId()
+{
+    return static_cast<DWORD>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+}
+
+HRESULT SHGetFolderPathW(HWND /*hWnd*/, int csidl, HANDLE /*token*/, DWORD /*flags*/, LPWSTR path)
+{
+    if (csidl != CSIDL_APPDATA)
+        return E_INVALIDARG;
+
+    CopyString(c_appDataPath, path, MAX_PATH);
+    return S_OK;
+}
+
+int MessageBoxW(HWND /*hWnd*/, LPCWSTR text, LPCWSTR /*caption*/, UINT /*type*/)
+{
+    ++g_failures;
+    std::fprintf(stderr, "MessageBox: %s\n", MockPlatform::ToUtf8(text != nullptr ? text : L"").c_str());
+    return IDOK;
+}
+
+void OutputDebugStringW(LPCWSTR outputString)
+{
+    if (g_debugOutput)
+        std::fputs(MockPlatform::ToUtf8(outputString).c_str(), stderr);
+}
+
+HANDLE CreateToolhelp32Snapshot(DWORD /*flags*/, DWORD /*processId*/)
+{
+    auto snapshot = new SnapshotHandle();
+
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    DWORD currentProcessId = GetCurrentProcessId();
+    snapshot->processes.push_back({ 4, 0, L"System" });
+    snapshot->processes.push_back({ currentProcessId, 4, L"WebViewBrowserApp.exe" });
+    snapshot->processes.insert(snapshot->processes.end(), g_processes.begin(), g_processes.end());
+    g_handles.insert(snapshot);
+    return static_cast<MockHandle*>(snapshot);
+}
+
+namespace
+{
+    BOOL NextProcess(HANDLE handle, PROCESSENTRY32W* entry)
+    {
+        std::lock_guard<std::recursive_mutex> lock(g_lock);
+        auto snapshot = g_handles.count(static_cast<MockHandle*>(handle)) != 0 ?
+            dynamic_cast<SnapshotHandle*>(static_cast<MockHandle*>(handle)) : nullptr;
+        if (snapshot == nullptr)
+        {
+            t_lastError = ERROR_INVALID_HANDLE;
+            return FALSE;
+        }
+        if (snapshot->next >= snapshot->processes.size())
+        {
+            t_lastError = ERROR_NO_MORE_FILES;
+            return FALSE;
+        }
+
+        const ProcessEntry& process = snapshot->processes[snapshot->next++];
+        entry->cntUsage = 0;
+        entry->th32ProcessID = process.id;
+        entry->th32DefaultHeapID = 0;
+        entry->th32ModuleID = 0;
+        entry->cntThreads = 1;
+        entry->th32ParentProcessID = process.parentId;
+        entry->pcPriClassBase = 8;
+        entry->dwFlags = 0;
+        CopyString(process.exeFile, entry->szExeFile, MAX_PATH);
+        return TRUE;
+    }
+}
+
+BOOL Process32FirstW(HANDLE snapshot, PROCESSENTRY32W* entry)
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(g_lock);
+        if (g_handles.count(static_cast<MockHandle*>(snapshot)) != 0)
+        {
+            if (auto handle = dynamic_cast<SnapshotHandle*>(static_cast<MockHandle*>(snapshot)))
+                handle->next = 0;
+        }
+    }
+    return NextProcess(snapshot, entry);
+}
+
+BOOL Process32NextW(HANDLE snapshot, PROCESSENTRY32W* entry)
+{
+    return NextProcess(snapshot, entry);
+}
+
+namespace
+{
+    // The process a handle from OpenProcess refers to, if it's still running
+    const ProcessEntry* LookupProcess(HANDLE handle)
+    {
+        auto process = g_handles.count(static_cast<MockHandle*>(handle)) != 0 ?
+            dynamic_cast<ProcessHandle*>(static_cast<MockHandle*>(handle)) : nullptr;
+        if (process != nullptr)
+        {
+            for (const ProcessEntry& entry : g_processes)
+            {
+                if (entry.id == process->id)
+                    return &entry;
+            }
+        }
+        t_lastError = ERROR_INVALID_HANDLE;
+        return nullptr;
+    }
+
+    void ToFileTime(uint64_t us, FILETIME* time)
+    {
+        uint64_t ticks = us * 10; // 100 ns units
+        time->dwLowDateTime = static_cast<DWORD>(ticks);
+        time->dwHighDateTime = static_cast<DWORD>(ticks >> 32);
+    }
+}
+
+HANDLE OpenProcess(DWORD /*access*/, BOOL /*inheritHandle*/, DWORD processId)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    if (std::none_of(g_processes.begin(), g_processes.end(), [processId](const ProcessEntry& process) { return process.id == processId; }))
+    {
+        t_lastError = ERROR_INVALID_PARAMETER;
+        return nullptr;
+    }
+
+    auto process = new ProcessHandle();
+    process->id = processId;
+    g_handles.insert(process);
+    return static_cast<MockHandle*>(process);
+}
+
+BOOL GetProcessTimes(HANDLE process, FILETIME* creationTime, FILETIME* exitTime, FILETIME* kernelTime, FILETIME* userTime)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    const ProcessEntry* entry = LookupProcess(process);
+    if (entry == nullptr)
+        return FALSE;
+
+    // All of it counts as user time
+    ToFileTime(0, creationTime);
+    ToFileTime(0, exitTime);
+    ToFileTime(0, kernelTime);
+    ToFileTime(entry->cpuTime, userTime);
+    return TRUE;
+}
+
+BOOL GetProcessMemoryInfo(HANDLE process, PROCESS_MEMORY_COUNTERS* counters, DWORD size)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    const ProcessEntry* entry = LookupProcess(process);
+    if (entry == nullptr)
+        return FALSE;
+    if (size < sizeof(PROCESS_MEMORY_COUNTERS))
+    {
+        t_lastError = ERROR_INSUFFICIENT_BUFFER;
+        return FALSE;
+    }
+
+    *counters = {};
+    counters->cb = sizeof(PROCESS_MEMORY_COUNTERS);
+    counters->WorkingSetSize = static_cast<SIZE_T>(entry->workingSet);
+    counters->PeakWorkingSetSize = counters->WorkingSetSize;
+    return TRUE;
+}
+
+// Files
+
+HANDLE CreateFileW(LPCWSTR fileName, DWORD access, DWORD /*shareMode*/, SECURITY_ATTRIBUTES* /*security*/,
+    DWORD creationDisposition, DWORD /*flags*/, HANDLE /*templateFile*/)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    std::wstring key = ToFileKey(fileName);
+    auto it = g_files.find(key);
+    bool exists = it != g_files.end();
+
+    switch (creationDisposition)
+    {
+    case CREATE_NEW:
+        if (exists)
+        {
+            t_lastError = ERROR_FILE_EXISTS;
+            return INVALID_HANDLE_VALUE;
+        }
+        break;
+    case OPEN_EXISTING:
+    case TRUNCATE_EXISTING:
+        if (!exists)
+        {
+            t_lastError = ERROR_FILE_NOT_FOUND;
+            return INVALID_HANDLE_VALUE;
+        }
+        break;
+    case CREATE_ALWAYS:
+    case OPEN_ALWAYS:
+        break;
+    default:
+        t_lastError = ERROR_INVALID_PARAMETER;
+        return INVALID_HANDLE_VALUE;
+    }
+
+    if (!exists)
+        it = g_files.emplace(key, FileEntry{ fileName, std::make_shared<std::string>() }).first;
+    else if (creationDisposition == CREATE_ALWAYS || creationDisposition == TRUNCATE_EXISTING)
+        it->second.data->clear();
+
+    auto file = new FileHandle();
+    file->data = it->second.data;
+    file->access = access;
+    g_handles.insert(file);
+
+    t_lastError = (exists && (creationDisposition == CREATE_ALWAYS || creationDisposition == OPEN_ALWAYS)) ?
+        ERROR_ALREADY_EXISTS : ERROR_SUCCESS;
+    return static_cast<MockHandle*>(file);
+}
+
+namespace
+{
+    FileHandle* LookupFile(HANDLE handle)
+    {
+        auto file = g_handles.count(static_cast<MockHandle*>(handle)) != 0 ?
+            dynamic_cast<FileHandle*>(static_cast<MockHandle*>(handle)) : nullptr;
+        if (file == nullptr)
+            t_lastError = ERROR_INVALID_HANDLE;
+        return file;
+    }
+}
+
+BOOL WriteFile(HANDLE file, LPCVOID buffer, DWORD bytesToWrite, LPDWORD bytesWritten, OVERLAPPED* /*overlapped*/)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    FileHandle* handle = LookupFile(file);
+    if (handle == nullptr)
+        return FALSE;
+    if (!(handle->access & (GENERIC_WRITE | FILE_APPEND_DATA)))
+    {
+        t_lastError = ERROR_ACCESS_DENIED;
+        return FALSE;
+    }
+
+    std::string& data = *handle->data;
+    if (!(handle->access & GENERIC_WRITE))
+        handle->position = data.size();
+    if (data.size() < handle->position + bytesToWrite)
+        data.resize(handle->position + bytesToWrite);
+    std::memcpy(&data[handle->position], buffer, bytesToWrite);
+    handle->position += bytesToWrite;
+
+    if (bytesWritten != nullptr)
+        *bytesWritten = bytesToWrite;
+    return TRUE;
+}
+
+BOOL ReadFile(HANDLE file, LPVOID buffer, DWORD bytesToRead, LPDWORD bytesRead, OVERLAPPED* /*overlapped*/)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    FileHandle* handle = LookupFile(file);
+    if (handle == nullptr)
+        return FALSE;
+    if (!(handle->access & GENERIC_READ))
+    {
+        t_lastError = ERROR_ACCESS_DENIED;
+        return FALSE;
+    }
+
+    const std::string& data = *handle->data;
+    size_t count = handle->position < data.size() ? std::min<size_t>(bytesToRead, data.size() - handle->position) : 0;
+    std::memcpy(buffer, data.data() + handle->position, count);
+    handle->position += count;
+
+    if (bytesRead != nullptr)
+        *bytesRead = static_cast<DWORD>(count);
+    return TRUE;
+}
+
+BOOL DeleteFileW(LPCWSTR fileName)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    if (g_files.erase(ToFileKey(fileName)) == 0)
+    {
+        t_lastError = ERROR_FILE_NOT_FOUND;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+BOOL MoveFileExW(LPCWSTR existingFileName, LPCWSTR newFileName, DWORD flags)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    auto it = g_files.find(ToFileKey(existingFileName));
+    if (it == g_files.end())
+    {
+        t_lastError = ERROR_FILE_NOT_FOUND;
+        return FALSE;
+    }
+
+    std::wstring newKey = ToFileKey(newFileName);
+    if (g_files.count(newKey) != 0 && !(flags & MOVEFILE_REPLACE_EXISTING))
+    {
+        t_lastError = ERROR_ALREADY_EXISTS;
+        return FALSE;
+    }
+
+    // Handles opened on either file keep their contents, like on NTFS
+    FileEntry entry{ newFileName, it->second.data };
+    g_files.erase(it);
+    g_files[newKey] = std::move(entry);
+    return TRUE;
+}
+
+BOOL FlushFileBuffers(HANDLE file)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    return LookupFile(file) != nullptr;
+}
+
+BOOL CloseHandle(HANDLE object)
+{
+    std::lock_guard<std::recursive_mutex> lock(g_lock);
+    auto handle = static_cast<MockHandle*>(object);
+    if (g_handles.erase(handle) == 0)
+    {
+        t_lastError = ERROR_INVALID_HANDLE;
+        return FALSE;
+    }
+    delete handle;
+    return TRUE;
+}
+
+DWORD GetLastError()
+{
+    return t_lastError;
+}
+
+void SetLastError(DWORD error)
+{
+    t_lastError = error;
+}
+
+// Time and text
+
+void GetLocalTime(SYSTEMTIME* time)
+{
+    std::time_t now = std::time(nullptr);
+    std::tm local = {};
+    localtime_r(&now, &local);
+    time->wYear = static_cast<WORD>(local.tm_year + 1900);
+    time->wMonth = static_cast<WORD>(local.tm_mon + 1);
+    time->wDayOfWeek = static_cast<WORD>(local.tm_wday);
+    time->wDay = static_cast<WORD>(local.tm_mday);
+    time->wHour = static_cast<WORD>(local.tm_hour);
+    time->wMinute = static_cast<WORD>(local.tm_min);
+    time->wSecond = static_cast<WORD>(local.tm_sec);
+    time->wMilliseconds = 0;
+}
+
+// Like GetLocalTime, the real clock
+void GetSystemTimeAsFileTime(FILETIME* time)
+{
+    // 100 ns units since 1601
+    auto sinceEpoch = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch());
+    uint64_t ticks = static_cast<uint64_t>(sinceEpoch.count()) * 10 + 116444736000000000ull;
+    time->dwLowDateTime = static_cast<DWORD>(ticks);
+    time->dwHighDateTime = static_cast<DWORD>(ticks >> 32);
+}
+
+// Follows the virtual clock
+ULONGLONG GetTickCount64()
+{
+    return c_bootTime + g_now;
+}
+
+int WideCharToMultiByte(UINT /*codePage*/, DWORD /*flags*/, LPCWSTR wideStr, int wideLength,
+    LPSTR multiByteStr, int multiByteLength, LPCSTR /*defaultChar*/, LPBOOL /*usedDefaultChar*/)
+{
+    size_t length = wideLength < 0 ? wcslen(wideStr) + 1 : static_cast<size_t>(wideLength);
+    std::string utf8 = MockPlatform::ToUtf8(std::wstring(wideStr, length));
+    if (multiByteLength == 0)
+        return static_cast<int>(utf8.size());
+    if (utf8.size() > static_cast<size_t>(multiByteLength))
+    {
+        t_lastError = ERROR_INSUFFICIENT_BUFFER;
+        return 0;
+    }
+
+    std::memcpy(multiByteStr, utf8.data(), utf8.size());
+    return static_cast<int>(utf8.size());
+}
+
+int MultiByteToWideChar(UINT /*codePage*/, DWORD /*flags*/, LPCSTR multiByteStr, int multiByteLength,
+    LPWSTR wideStr, int wideLength)
+{
+    size_t length = multiByteLength < 0 ? std::strlen(multiByteStr) + 1 : static_cast<size_t>(multiByteLength);
+    std::wstring wide = FromUtf8(multiByteStr, length);
+    if (wideLength == 0)
+        return static_cast<int>(wide.size());
+    if (wide.size() > static_cast<size_t>(wideLength))
+    {
+        t_lastError = ERROR_INSUFFICIENT_BUFFER;
+        return 0;
+    }
+
+    wmemcpy(wideStr, wide.data(), wide.size());
+    return static_cast<int>(wide.size());
+}
+
+int MockVswprintf(wchar_t* buffer, size_t count, const wchar_t* format, va_list args)
+{
+    // %s without a size prefix is a wide string for MSVC and a narrow one here
+    std::wstring translated;
+    for (const wchar_t* p = format; *p != L'\0'; ++p)
+    {
+        translated.push_back(*p);
+        if (*p != L'%')
+            continue;
+        if (p[1] == L'%')
+        {
+            translated.push_back(*++p);
+            continue;
+        }
+
+        bool sized = false;
+        while (p[1] != L'\0' && wcschr(L"-+ #0123456789.*hlLzjt", p[1]) != nullptr)
+        {
+            sized = sized || wcschr(L"hlLzjt", p[1]) != nullptr;
+            translated.push_back(*++p);
+        }
+        if (p[1] == L's' && !sized)
+            translated.push_back(L'l');
+    }
+
+    int result = vswprintf(buffer, count, translated.c_str(), args);
+    if (result < 0 && count > 0)
+        buffer[0] = L'\0';
+    return result;
+}
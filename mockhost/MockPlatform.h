@@ -0,0 +1,60 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "windows.h"
+
+// Drives the emulated Win32 platform the headless host runs on. There is one
+// message queue, shared by posted window messages and by the tasks the mock
+// WebViews post to complete asynchronous calls, and it only runs when the
+// driver asks it to. Time is virtual: timers fire when AdvanceTime moves the
+// clock past them, so a benchmark controls exactly how many frames pass.
+class MockPlatform
+{
+public:
+    // Runs posted messages and tasks, including those they post, until the
+    // queue is empty. Returns how many ran.
+    static size_t RunUntilIdle();
+    // Fires the timers due in the next ms milliseconds, running the queue
+    // after each one
+    static void AdvanceTime(uint32_t ms);
+    static uint64_t GetTime();
+    static bool HasTimers();
+    static void PostTask(std::function<void()> task);
+    // Runs whenever the queue is empty, before RunUntilIdle returns. Waits
+    // for the work on other threads, which can post to the queue.
+    static void SetIdleHandler(std::function<void()> handler);
+    static bool IsQuitPosted();
+
+    // Windows created outside the host, like the ones the browser process
+    // owns. They use DefWindowProc.
+    static HWND CreateForeignWindow(LPCWSTR className, LPCWSTR title, DWORD style, HWND parent, DWORD processId);
+    // Resizes like the user dragging the frame
+    static void ResizeWindow(HWND hWnd, int width, int height);
+    static void SetDpi(UINT dpi);
+    static void SetKeyState(int virtKey, bool down);
+
+    // Adds a process to what CreateToolhelp32Snapshot reports
+    static DWORD CreateProcess(DWORD parentProcessId, LPCWSTR exeFile);
+    static void ExitProcess(DWORD processId);
+    // What GetProcessMemoryInfo and GetProcessTimes report for a process,
+    // CPU time in microseconds
+    static void SetProcessCounters(DWORD processId, uint64_t workingSet, uint64_t cpuTime);
+
+    // Files written through CreateFileW, keyed by their path
+    static bool GetFileContents(const std::wstring& path, std::string& contents);
+    static std::vector<std::wstring> GetFilePaths();
+
+    // MessageBoxW is how the host reports failures, each call is counted
+    static size_t GetFailureCount();
+    // OutputDebugStringW goes to stderr when this is on
+    static void SetDebugOutput(bool enabled);
+
+    static std::wstring PathToFileUri(const std::wstring& path);
+    static std::string ToUtf8(const std::wstring& text);
+};
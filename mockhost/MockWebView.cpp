@@ -0,0 +1,974 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "MockWebView.h"
+#include <algorithm>
+#include "MockPlatform.h"
+
+using namespace Microsoft::WRL;
+
+namespace
+{
+    MockHost::DocumentCreatedHandler g_documentCreatedHandler;
+    MockHost::MessagePostedHandler g_messagePostedHandler;
+    std::vector<MockWebView*> g_webViews;
+    uint64_t g_lastNavigationId = 0;
+
+    HRESULT CopyToCoTaskMem(const std::wstring& value, LPWSTR* result)
+    {
+        *result = static_cast<LPWSTR>(CoTaskMemAlloc((value.size() + 1) * sizeof(wchar_t)));
+        if (*result == nullptr)
+            return E_OUTOFMEMORY;
+
+        wmemcpy(*result, value.c_str(), value.size() + 1);
+        return S_OK;
+    }
+
+    // Accepts what the runtime would: absolute URIs and file paths
+    bool ToNavigableUri(LPCWSTR uri, std::wstring& result)
+    {
+        if (uri == nullptr)
+            return false;
+
+        result = MockPlatform::PathToFileUri(uri);
+        size_t colon = result.find(L':');
+        if (colon == 0 || colon == std::wstring::npos)
+            return false;
+        for (size_t i = 0; i < colon; ++i)
+        {
+            if (!iswalnum(result[i]) && result[i] != L'+' && result[i] != L'-' && result[i] != L'.')
+                return false;
+        }
+
+        std::wstring scheme = result.substr(0, colon);
+        return result.compare(colon, 3, L"://") == 0 || scheme == L"about" || scheme == L"data";
+    }
+
+    class MockWebMessageReceivedEventArgs : public MockObject<ICoreWebView2WebMessageReceivedEventArgs>
+    {
+    public:
+        MockWebMessageReceivedEventArgs(const std::wstring& source, const std::wstring& json) :
+            m_source(source), m_json(json) {}
+
+        HRESULT STDMETHODCALLTYPE get_Source(LPWSTR* source) override { return CopyToCoTaskMem(m_source, source); }
+        HRESULT STDMETHODCALLTYPE get_WebMessageAsJson(LPWSTR* json) override { return CopyToCoTaskMem(m_json, json); }
+        HRESULT STDMETHODCALLTYPE TryGetWebMessageAsString(LPWSTR* value) override
+        {
+            *value = nullptr;
+            if (m_json.size() < 2 || m_json.front() != L'"' || m_json.find(L'\\') != std::wstring::npos)
+                return E_INVALIDARG;
+            return CopyToCoTaskMem(m_json.substr(1, m_json.size() - 2), value);
+        }
+
+    private:
+        std::wstring m_source;
+        std::wstring m_json;
+    };
+
+    class MockNavigationStartingEventArgs : public MockObject<ICoreWebView2NavigationStartingEventArgs>
+    {
+    public:
+        MockNavigationStartingEventArgs(const std::wstring& uri, uint64_t navigationId) :
+            m_uri(uri), m_navigationId(navigationId) {}
+
+        HRESULT STDMETHODCALLTYPE get_Uri(LPWSTR* uri) override { return CopyToCoTaskMem(m_uri, uri); }
+        HRESULT STDMETHODCALLTYPE get_IsUserInitiated(BOOL* isUserInitiated) override
+        {
+            *isUserInitiated = FALSE;
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE get_Cancel(BOOL* cancel) override
+        {
+            *cancel = m_cancel;
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE put_Cancel(BOOL cancel) override
+        {
+            m_cancel = cancel;
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE get_NavigationId(UINT64* navigationId) override
+        {
+            *navigationId = m_navigationId;
+            return S_OK;
+        }
+
+    private:
+        std::wstring m_uri;
+        uint64_t m_navigationId;
+        BOOL m_cancel = FALSE;
+    };
+
+    class MockNavigationCompletedEventArgs : public MockObject<ICoreWebView2NavigationCompletedEventArgs>
+    {
+    public:
+        MockNavigationCompletedEventArgs(bool isSuccess, uint64_t navigationId) :
+            m_isSuccess(isSuccess), m_navigationId(navigationId) {}
+
+        HRESULT STDMETHODCALLTYPE get_IsSuccess(BOOL* isSuccess) override
+        {
+            *isSuccess = m_isSuccess ? TRUE : FALSE;
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE get_WebErrorStatus(COREWEBVIEW2_WEB_ERROR_STATUS* webErrorStatus) override
+        {
+            *webErrorStatus = m_isSuccess ? COREWEBVIEW2_WEB_ERROR_STATUS_UNKNOWN : COREWEBVIEW2_WEB_ERROR_STATUS_OPERATION_CANCELED;
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE get_NavigationId(UINT64* navigationId) override
+        {
+            *navigationId = m_navigationId;
+            return S_OK;
+        }
+
+    private:
+        bool m_isSuccess;
+        uint64_t m_navigationId;
+    };
+
+    class MockSourceChangedEventArgs : public MockObject<ICoreWebView2SourceChangedEventArgs>
+    {
+    public:
+        HRESULT STDMETHODCALLTYPE get_IsNewDocument(BOOL* isNewDocument) override
+        {
+            *isNewDocument = TRUE;
+            return S_OK;
+        }
+    };
+
+    class MockDevToolsProtocolEventReceivedEventArgs : public MockObject<ICoreWebView2DevToolsProtocolEventReceivedEventArgs>
+    {
+    public:
+        explicit MockDevToolsProtocolEventReceivedEventArgs(const std::wstring& json) : m_json(json) {}
+
+        HRESULT STDMETHODCALLTYPE get_ParameterObjectAsJson(LPWSTR* json) override { return CopyToCoTaskMem(m_json, json); }
+
+    private:
+        std::wstring m_json;
+    };
+
+    class MockAcceleratorKeyPressedEventArgs : public MockObject<ICoreWebView2AcceleratorKeyPressedEventArgs>
+    {
+    public:
+        explicit MockAcceleratorKeyPressedEventArgs(UINT virtualKey) : m_virtualKey(virtualKey) {}
+
+        HRESULT STDMETHODCALLTYPE get_KeyEventKind(COREWEBVIEW2_KEY_EVENT_KIND* keyEventKind) override
+        {
+            *keyEventKind = COREWEBVIEW2_KEY_EVENT_KIND_KEY_DOWN;
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE get_VirtualKey(UINT* virtualKey) override
+        {
+            *virtualKey = m_virtualKey;
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE get_KeyEventLParam(INT* lParam) override
+        {
+            *lParam = 1;
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE get_PhysicalKeyStatus(COREWEBVIEW2_PHYSICAL_KEY_STATUS* physicalKeyStatus) override
+        {
+            *physicalKeyStatus = { 1, 0, FALSE, FALSE, FALSE, FALSE };
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE get_Handled(BOOL* handled) override
+        {
+            *handled = m_handled;
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE put_Handled(BOOL handled) override
+        {
+            m_handled = handled;
+            return S_OK;
+        }
+
+    private:
+        UINT m_virtualKey;
+        BOOL m_handled = FALSE;
+    };
+
+    class MockSettings : public MockObject<ICoreWebView2Settings>
+    {
+    public:
+        HRESULT STDMETHODCALLTYPE get_IsScriptEnabled(BOOL* value) override
+        {
+            *value = m_isScriptEnabled;
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE put_IsScriptEnabled(BOOL value) override
+        {
+            m_isScriptEnabled = value;
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE get_IsWebMessageEnabled(BOOL* value) override
+        {
+            *value = m_isWebMessageEnabled;
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE put_IsWebMessageEnabled(BOOL value) override
+        {
+            m_isWebMessageEnabled = value;
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE get_AreDevToolsEnabled(BOOL* value) override
+        {
+            *value = m_areDevToolsEnabled;
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE put_AreDevToolsEnabled(BOOL value) override
+        {
+            m_areDevToolsEnabled = value;
+            return S_OK;
+        }
+
+    private:
+        BOOL m_isScriptEnabled = TRUE;
+        BOOL m_isWebMessageEnabled = TRUE;
+        BOOL m_areDevToolsEnabled = TRUE;
+    };
+}
+
+class MockDevToolsProtocolEventReceiver : public MockObject<ICoreWebView2DevToolsProtocolEventReceiver>
+{
+public:
+    HRESULT STDMETHODCALLTYPE add_DevToolsProtocolEventReceived(
+        ICoreWebView2DevToolsProtocolEventReceivedEventHandler* handler, EventRegistrationToken* token) override
+    {
+        return m_eventReceived.Add(handler, token);
+    }
+    HRESULT STDMETHODCALLTYPE remove_DevToolsProtocolEventReceived(EventRegistrationToken token) override
+    {
+        return m_eventReceived.Remove(token);
+    }
+
+    void Raise(ICoreWebView2* webview, const std::wstring& json)
+    {
+        auto args = Make<MockDevToolsProtocolEventReceivedEventArgs>(json);
+        m_eventReceived.Raise(webview, args.Get());
+    }
+
+    void Clear() { m_eventReceived.Clear(); }
+
+private:
+    MockEventSource<ICoreWebView2DevToolsProtocolEventReceivedEventHandler> m_eventReceived;
+};
+
+// MockWebView
+
+MockWebView::MockWebView(MockEnvironment* environment, MockController* controller) :
+    m_environment(environment), m_controller(controller), m_settings(Make<MockSettings>())
+{
+    MockHost::Register(this);
+}
+
+MockWebView::~MockWebView()
+{
+    MockHost::Unregister(this);
+}
+
+void MockWebView::Close()
+{
+    if (m_controller == nullptr)
+        return;
+
+    // The host's handlers capture the objects that own this WebView
+    m_controller = nullptr;
+    m_navigationId = 0;
+    m_navigationStarting.Clear();
+    m_sourceChanged.Clear();
+    m_historyChanged.Clear();
+    m_navigationCompleted.Clear();
+    m_webMessageReceived.Clear();
+    m_documentTitleChanged.Clear();
+    for (auto& receiver : m_devToolsReceivers)
+        receiver.second->Clear();
+    MockHost::Unregister(this);
+}
+
+HRESULT MockWebView::get_Settings(ICoreWebView2Settings** settings)
+{
+    if (IsClosed())
+        return c_closedError;
+    return m_settings.CopyTo(settings);
+}
+
+HRESULT MockWebView::get_Source(LPWSTR* uri)
+{
+    return CopyToCoTaskMem(m_source, uri);
+}
+
+HRESULT MockWebView::Navigate(LPCWSTR uri)
+{
+    if (IsClosed())
+        return c_closedError;
+
+    std::wstring navigableUri;
+    if (!ToNavigableUri(uri, navigableUri))
+        return E_INVALIDARG;
+
+    StartNavigation(navigableUri, true);
+    return S_OK;
+}
+
+HRESULT MockWebView::NavigateToString(LPCWSTR /*htmlContent*/)
+{
+    if (IsClosed())
+        return c_closedError;
+
+    StartNavigation(L"about:blank", true);
+    return S_OK;
+}
+
+void MockWebView::StartNavigation(const std::wstring& uri, bool addToHistory)
+{
+    uint64_t navigationId = ++g_lastNavigationId;
+    m_navigationId = navigationId;
+
+    ComPtr<MockWebView> self(this);
+    MockPlatform::PostTask([self, navigationId, uri, addToHistory]()
+    {
+        if (self->m_navigationId != navigationId)
+            return;
+
+        auto args = Make<MockNavigationStartingEventArgs>(uri, navigationId);
+        self->m_navigationStarting.Raise(self.Get(), args.Get());
+
+        BOOL cancel = FALSE;
+        args->get_Cancel(&cancel);
+        if (cancel)
+        {
+            self->CompleteNavigation(navigationId, false);
+            return;
+        }
+
+        MockPlatform::PostTask([self, navigationId, uri, addToHistory]()
+        {
+            self->CommitNavigation(navigationId, uri, addToHistory);
+        });
+    });
+}
+
+void MockWebView::CommitNavigation(uint64_t navigationId, const std::wstring& uri, bool addToHistory)
+{
+    if (m_navigationId != navigationId)
+        return;
+
+    if (addToHistory)
+    {
+        if (!m_history.empty())
+            m_history.resize(m_historyIndex + 1);
+        m_history.push_back(uri);
+        m_historyIndex = m_history.size() - 1;
+    }
+    m_source = uri;
+    m_title = uri;
+
+    auto args = Make<MockSourceChangedEventArgs>();
+    m_sourceChanged.Raise(this, args.Get());
+    m_historyChanged.Raise(this, nullptr);
+    m_documentTitleChanged.Raise(this, nullptr);
+    MockHost::OnDocumentCreated(*this);
+
+    ComPtr<MockWebView> self(this);
+    MockPlatform::PostTask([self, navigationId]()
+    {
+        self->CompleteNavigation(navigationId, true);
+    });
+}
+
+void MockWebView::CompleteNavigation(uint64_t navigationId, bool isSuccess)
+{
+    if (m_navigationId != navigationId)
+        return;
+
+    m_navigationId = 0;
+    auto args = Make<MockNavigationCompletedEventArgs>(isSuccess, navigationId);
+    m_navigationCompleted.Raise(this, args.Get());
+}
+
+HRESULT MockWebView::add_NavigationStarting(ICoreWebView2NavigationStartingEventHandler* eventHandler, EventRegistrationToken* token)
+{
+    return m_navigationStarting.Add(eventHandler, token);
+}
+
+HRESULT MockWebView::remove_NavigationStarting(EventRegistrationToken token)
+{
+    return m_navigationStarting.Remove(token);
+}
+
+HRESULT MockWebView::add_SourceChanged(ICoreWebView2SourceChangedEventHandler* eventHandler, EventRegistrationToken* token)
+{
+    return m_sourceChanged.Add(eventHandler, token);
+}
+
+HRESULT MockWebView::remove_SourceChanged(EventRegistrationToken token)
+{
+    return m_sourceChanged.Remove(token);
+}
+
+HRESULT MockWebView::add_NavigationCompleted(ICoreWebView2NavigationCompletedEventHandler* eventHandler, EventRegistrationToken* token)
+{
+    return m_navigationCompleted.Add(eventHandler, token);
+}
+
+HRESULT MockWebView::remove_NavigationCompleted(EventRegistrationToken token)
+{
+    return m_navigationCompleted.Remove(token);
+}
+
+HRESULT MockWebView::AddScriptToExecuteOnDocumentCreated(LPCWSTR javaScript, ICoreWebView2AddScriptToExecuteOnDocumentCreatedCompletedHandler* handler)
+{
+    if (IsClosed())
+        return c_closedError;
+
+    m_documentScripts.push_back(javaScript);
+    if (handler != nullptr)
+    {
+        ComPtr<ICoreWebView2AddScriptToExecuteOnDocumentCreatedCompletedHandler> completed(handler);
+        std::wstring id = std::to_wstring(m_documentScripts.size());
+        MockPlatform::PostTask([completed, id]() { completed->Invoke(S_OK, id.c_str()); });
+    }
+    return S_OK;
+}
+
+HRESULT MockWebView::RemoveScriptToExecuteOnDocumentCreated(LPCWSTR id)
+{
+    size_t index = static_cast<size_t>(wcstoul(id, nullptr, 10));
+    if (index == 0 || index > m_documentScripts.size())
+        return E_INVALIDARG;
+
+    // Ids stay valid, the script is only emptied
+    m_documentScripts[index - 1].clear();
+    return S_OK;
+}
+
+HRESULT MockWebView::ExecuteScript(LPCWSTR /*javaScript*/, ICoreWebView2ExecuteScriptCompletedHandler* handler)
+{
+    if (IsClosed())
+        return c_closedError;
+
+    if (handler != nullptr)
+    {
+        ComPtr<ICoreWebView2ExecuteScriptCompletedHandler> completed(handler);
+        MockPlatform::PostTask([completed]() { completed->Invoke(S_OK, L"null"); });
+    }
+    return S_OK;
+}
+
+HRESULT MockWebView::Reload()
+{
+    if (IsClosed())
+        return c_closedError;
+
+    StartNavigation(m_source, false);
+    return S_OK;
+}
+
+HRESULT MockWebView::PostWebMessageAsJson(LPCWSTR webMessageAsJson)
+{
+    if (IsClosed())
+        return c_closedError;
+
+    m_postedMessages.emplace_back(webMessageAsJson);
+    if (g_messagePostedHandler)
+    {
+        // The page receives it from its own event loop
+        ComPtr<MockWebView> self(this);
+        std::wstring json(webMessageAsJson);
+        MockPlatform::PostTask([self, json]()
+        {
+            if (!self->IsClosed())
+                MockHost::OnMessagePosted(*self.Get(), json);
+        });
+    }
+    return S_OK;
+}
+
+HRESULT MockWebView::PostWebMessageAsString(LPCWSTR webMessageAsString)
+{
+    std::wstring json = L"\"";
+    json.append(webMessageAsString);
+    json.push_back(L'"');
+    return PostWebMessageAsJson(json.c_str());
+}
+
+HRESULT MockWebView::add_WebMessageReceived(ICoreWebView2WebMessageReceivedEventHandler* handler, EventRegistrationToken* token)
+{
+    return m_webMessageReceived.Add(handler, token);
+}
+
+HRESULT MockWebView::remove_WebMessageReceived(EventRegistrationToken token)
+{
+    return m_webMessageReceived.Remove(token);
+}
+
+HRESULT MockWebView::CallDevToolsProtocolMethod(LPCWSTR /*methodName*/, LPCWSTR /*parametersAsJson*/, ICoreWebView2CallDevToolsProtocolMethodCompletedHandler* handler)
+{
+    if (IsClosed())
+        return c_closedError;
+
+    if (handler != nullptr)
+    {
+        ComPtr<ICoreWebView2CallDevToolsProtocolMethodCompletedHandler> completed(handler);
+        MockPlatform::PostTask([completed]() { completed->Invoke(S_OK, L"{}"); });
+    }
+    return S_OK;
+}
+
+HRESULT MockWebView::get_BrowserProcessId(UINT32* value)
+{
+    *value = m_environment->GetBrowserProcessId();
+    return S_OK;
+}
+
+HRESULT MockWebView::get_CanGoBack(BOOL* canGoBack)
+{
+    *canGoBack = m_historyIndex > 0 ? TRUE : FALSE;
+    return S_OK;
+}
+
+HRESULT MockWebView::get_CanGoForward(BOOL* canGoForward)
+{
+    *canGoForward = m_historyIndex + 1 < m_history.size() ? TRUE : FALSE;
+    return S_OK;
+}
+
+HRESULT MockWebView::GoBack()
+{
+    if (IsClosed())
+        return c_closedError;
+
+    if (m_historyIndex > 0)
+        StartNavigation(m_history[--m_historyIndex], false);
+    return S_OK;
+}
+
+HRESULT MockWebView::GoForward()
+{
+    if (IsClosed())
+        return c_closedError;
+
+    if (m_historyIndex + 1 < m_history.size())
+        StartNavigation(m_history[++m_historyIndex], false);
+    return S_OK;
+}
+
+HRESULT MockWebView::GetDevToolsProtocolEventReceiver(LPCWSTR eventName, ICoreWebView2DevToolsProtocolEventReceiver** receiver)
+{
+    if (IsClosed())
+        return c_closedError;
+
+    auto& entry = m_devToolsReceivers[eventName];
+    if (!entry)
+        entry = Make<MockDevToolsProtocolEventReceiver>();
+    *receiver = entry.Get();
+    (*receiver)->AddRef();
+    return S_OK;
+}
+
+HRESULT MockWebView::Stop()
+{
+    if (IsClosed())
+        return c_closedError;
+
+    if (m_navigationId != 0)
+    {
+        ComPtr<MockWebView> self(this);
+        uint64_t navigationId = m_navigationId;
+        MockPlatform::PostTask([self, navigationId]() { self->CompleteNavigation(navigationId, false); });
+    }
+    return S_OK;
+}
+
+HRESULT MockWebView::add_HistoryChanged(ICoreWebView2HistoryChangedEventHandler* eventHandler, EventRegistrationToken* token)
+{
+    return m_historyChanged.Add(eventHandler, token);
+}
+
+HRESULT MockWebView::remove_HistoryChanged(EventRegistrationToken token)
+{
+    return m_historyChanged.Remove(token);
+}
+
+HRESULT MockWebView::get_DocumentTitle(LPWSTR* title)
+{
+    return CopyToCoTaskMem(m_title, title);
+}
+
+HRESULT MockWebView::add_DocumentTitleChanged(ICoreWebView2DocumentTitleChangedEventHandler* eventHandler, EventRegistrationToken* token)
+{
+    return m_documentTitleChanged.Add(eventHandler, token);
+}
+
+HRESULT MockWebView::remove_DocumentTitleChanged(EventRegistrationToken token)
+{
+    return m_documentTitleChanged.Remove(token);
+}
+
+// The window belongs to the browser process, like the real DevTools
+HRESULT MockWebView::OpenDevToolsWindow()
+{
+    if (IsClosed())
+        return c_closedError;
+
+    ComPtr<MockWebView> self(this);
+    MockPlatform::PostTask([self]()
+    {
+        std::wstring title = L"DevTools - " + self->m_source;
+        MockPlatform::CreateForeignWindow(L"Chrome_WidgetWin_1", title.c_str(), WS_OVERLAPPEDWINDOW | WS_VISIBLE,
+            nullptr, self->m_environment->GetBrowserProcessId());
+    });
+    return S_OK;
+}
+
+HRESULT MockWebView::TrySuspend(ICoreWebView2TrySuspendCompletedHandler* handler)
+{
+    if (IsClosed() || m_controller->IsVisible())
+        return c_closedError;
+
+    ComPtr<MockWebView> self(this);
+    ComPtr<ICoreWebView2TrySuspendCompletedHandler> completed(handler);
+    MockPlatform::PostTask([self, completed]()
+    {
+        // Showing the WebView in between cancels it
+        bool suspended = !self->IsClosed() && !self->m_controller->IsVisible();
+        self->m_isSuspended = suspended;
+        if (completed)
+            completed->Invoke(suspended ? S_OK : c_closedError, suspended);
+    });
+    return S_OK;
+}
+
+HRESULT MockWebView::Resume()
+{
+    if (IsClosed())
+        return c_closedError;
+
+    m_isSuspended = false;
+    return S_OK;
+}
+
+HRESULT MockWebView::get_IsSuspended(BOOL* isSuspended)
+{
+    *isSuspended = m_isSuspended;
+    return S_OK;
+}
+
+void MockWebView::PostMessageFromPage(const std::wstring& json)
+{
+    ComPtr<MockWebView> self(this);
+    MockPlatform::PostTask([self, json]() { self->DispatchMessageFromPage(json); });
+}
+
+void MockWebView::DispatchMessageFromPage(const std::wstring& json)
+{
+    if (IsClosed())
+        return;
+
+    auto args = Make<MockWebMessageReceivedEventArgs>(m_source, json);
+    m_webMessageReceived.Raise(this, args.Get());
+}
+
+void MockWebView::RaiseDevToolsProtocolEvent(const std::wstring& eventName, const std::wstring& parameterObjectAsJson)
+{
+    auto it = m_devToolsReceivers.find(eventName);
+    if (it != m_devToolsReceivers.end())
+        it->second->Raise(this, parameterObjectAsJson);
+}
+
+void MockWebView::SetDocumentTitle(const std::wstring& title)
+{
+    m_title = title;
+    m_documentTitleChanged.Raise(this, nullptr);
+}
+
+// MockController
+
+MockController* MockController::s_focused = nullptr;
+
+MockController::MockController(MockEnvironment* environment, HWND parentWindow) :
+    m_environment(environment), m_parentWindow(parentWindow)
+{
+    m_webView = Make<MockWebView>(environment, this);
+    m_hWnd = MockPlatform::CreateForeignWindow(L"Chrome_WidgetWin_0", L"", WS_CHILD | WS_VISIBLE,
+        parentWindow, GetCurrentProcessId());
+}
+
+MockController::~MockController()
+{
+    Close();
+}
+
+HRESULT MockController::get_IsVisible(BOOL* isVisible)
+{
+    *isVisible = m_isVisible ? TRUE : FALSE;
+    return S_OK;
+}
+
+HRESULT MockController::put_IsVisible(BOOL isVisible)
+{
+    if (m_webView->IsClosed())
+        return MockWebView::c_closedError;
+
+    m_isVisible = isVisible != FALSE;
+    if (m_isVisible)
+        m_webView->Resume();
+    ShowWindow(m_hWnd, m_isVisible ? SW_SHOW : SW_HIDE);
+    return S_OK;
+}
+
+HRESULT MockController::get_Bounds(RECT* bounds)
+{
+    *bounds = m_bounds;
+    return S_OK;
+}
+
+HRESULT MockController::put_Bounds(RECT bounds)
+{
+    if (m_webView->IsClosed())
+        return MockWebView::c_closedError;
+
+    m_bounds = bounds;
+    ++m_boundsCount;
+    MoveWindow(m_hWnd, bounds.left, bounds.top, bounds.right - bounds.left, bounds.bottom - bounds.top, TRUE);
+    return S_OK;
+}
+
+HRESULT MockController::get_ZoomFactor(double* zoomFactor)
+{
+    *zoomFactor = m_zoomFactor;
+    return S_OK;
+}
+
+HRESULT MockController::put_ZoomFactor(double zoomFactor)
+{
+    if (zoomFactor <= 0)
+        return E_INVALIDARG;
+    if (zoomFactor == m_zoomFactor)
+        return S_OK;
+
+    m_zoomFactor = zoomFactor;
+    m_zoomFactorChanged.Raise(this, nullptr);
+    return S_OK;
+}
+
+HRESULT MockController::add_ZoomFactorChanged(ICoreWebView2ZoomFactorChangedEventHandler* eventHandler, EventRegistrationToken* token)
+{
+    return m_zoomFactorChanged.Add(eventHandler, token);
+}
+
+HRESULT MockController::remove_ZoomFactorChanged(EventRegistrationToken token)
+{
+    return m_zoomFactorChanged.Remove(token);
+}
+
+// Focus events are raised from the queue, after the call returns
+HRESULT MockController::MoveFocus(COREWEBVIEW2_MOVE_FOCUS_REASON /*reason*/)
+{
+    if (m_webView->IsClosed())
+        return MockWebView::c_closedError;
+
+    SetFocus(m_hWnd);
+    if (s_focused == this)
+        return S_OK;
+
+    ComPtr<MockController> previous(s_focused);
+    ComPtr<MockController> self(this);
+    s_focused = this;
+    MockPlatform::PostTask([previous, self]()
+    {
+        if (previous)
+            previous->m_lostFocus.Raise(previous.Get(), nullptr);
+        self->m_gotFocus.Raise(self.Get(), nullptr);
+    });
+    return S_OK;
+}
+
+HRESULT MockController::add_GotFocus(ICoreWebView2FocusChangedEventHandler* eventHandler, EventRegistrationToken* token)
+{
+    return m_gotFocus.Add(eventHandler, token);
+}
+
+HRESULT MockController::remove_GotFocus(EventRegistrationToken token)
+{
+    return m_gotFocus.Remove(token);
+}
+
+HRESULT MockController::add_LostFocus(ICoreWebView2FocusChangedEventHandler* eventHandler, EventRegistrationToken* token)
+{
+    return m_lostFocus.Add(eventHandler, token);
+}
+
+HRESULT MockController::remove_LostFocus(EventRegistrationToken token)
+{
+    return m_lostFocus.Remove(token);
+}
+
+HRESULT MockController::add_AcceleratorKeyPressed(ICoreWebView2AcceleratorKeyPressedEventHandler* eventHandler, EventRegistrationToken* token)
+{
+    return m_acceleratorKeyPressed.Add(eventHandler, token);
+}
+
+HRESULT MockController::remove_AcceleratorKeyPressed(EventRegistrationToken token)
+{
+    return m_acceleratorKeyPressed.Remove(token);
+}
+
+HRESULT MockController::get_ParentWindow(HWND* parentWindow)
+{
+    *parentWindow = m_parentWindow;
+    return S_OK;
+}
+
+HRESULT MockController::put_ParentWindow(HWND parentWindow)
+{
+    if (m_webView->IsClosed())
+        return MockWebView::c_closedError;
+    if (!IsWindow(parentWindow))
+        return E_INVALIDARG;
+
+    m_parentWindow = parentWindow;
+    SetParent(m_hWnd, parentWindow);
+    return S_OK;
+}
+
+HRESULT MockController::NotifyParentWindowPositionChanged()
+{
+    return S_OK;
+}
+
+HRESULT MockController::Close()
+{
+    if (m_webView->IsClosed())
+        return S_OK;
+
+    m_webView->Close();
+    m_zoomFactorChanged.Clear();
+    m_gotFocus.Clear();
+    m_lostFocus.Clear();
+    m_acceleratorKeyPressed.Clear();
+    if (s_focused == this)
+        s_focused = nullptr;
+    DestroyWindow(m_hWnd);
+    m_hWnd = nullptr;
+    return S_OK;
+}
+
+HRESULT MockController::get_CoreWebView2(ICoreWebView2** coreWebView2)
+{
+    if (m_webView->IsClosed())
+    {
+        *coreWebView2 = nullptr;
+        return MockWebView::c_closedError;
+    }
+    return ComPtr<ICoreWebView2>(m_webView.Get()).CopyTo(coreWebView2);
+}
+
+void MockController::PressKey(UINT virtualKey)
+{
+    auto args = Make<MockAcceleratorKeyPressedEventArgs>(virtualKey);
+    m_acceleratorKeyPressed.Raise(this, args.Get());
+}
+
+// MockEnvironment
+
+MockEnvironment::MockEnvironment(std::wstring userDataFolder) :
+    m_userDataFolder(std::move(userDataFolder)),
+    m_browserProcessId(MockPlatform::CreateProcess(GetCurrentProcessId(), L"msedgewebview2.exe"))
+{
+}
+
+HRESULT MockEnvironment::CreateCoreWebView2Controller(HWND parentWindow, ICoreWebView2CreateCoreWebView2ControllerCompletedHandler* handler)
+{
+    if (!IsWindow(parentWindow) || handler == nullptr)
+        return E_INVALIDARG;
+
+    ComPtr<MockEnvironment> self(this);
+    ComPtr<ICoreWebView2CreateCoreWebView2ControllerCompletedHandler> completed(handler);
+    MockPlatform::PostTask([self, completed, parentWindow]()
+    {
+        if (!IsWindow(parentWindow))
+        {
+            completed->Invoke(HRESULT_FROM_WIN32(ERROR_INVALID_WINDOW_HANDLE), nullptr);
+            return;
+        }
+
+        auto controller = Make<MockController>(self.Get(), parentWindow);
+        completed->Invoke(S_OK, controller.Get());
+    });
+    return S_OK;
+}
+
+HRESULT MockEnvironment::get_BrowserVersionString(LPWSTR* versionInfo)
+{
+    return CopyToCoTaskMem(L"0.0.0.0 mock", versionInfo);
+}
+
+HRESULT CreateCoreWebView2EnvironmentWithOptions(PCWSTR /*browserExecutableFolder*/, PCWSTR userDataFolder,
+    ICoreWebView2EnvironmentOptions* /*environmentOptions*/,
+    ICoreWebView2CreateCoreWebView2EnvironmentCompletedHandler* environmentCreatedHandler)
+{
+    if (environmentCreatedHandler == nullptr)
+        return E_INVALIDARG;
+
+    ComPtr<ICoreWebView2CreateCoreWebView2EnvironmentCompletedHandler> completed(environmentCreatedHandler);
+    std::wstring folder = userDataFolder != nullptr ? userDataFolder : L"";
+    MockPlatform::PostTask([completed, folder]()
+    {
+        auto environment = Make<MockEnvironment>(folder);
+        completed->Invoke(S_OK, environment.Get());
+    });
+    return S_OK;
+}
+
+// MockHost
+
+void MockHost::SetDocumentCreatedHandler(DocumentCreatedHandler handler)
+{
+    g_documentCreatedHandler = std::move(handler);
+}
+
+void MockHost::SetMessagePostedHandler(MessagePostedHandler handler)
+{
+    g_messagePostedHandler = std::move(handler);
+}
+
+void MockHost::OnDocumentCreated(MockWebView& webview)
+{
+    if (g_documentCreatedHandler)
+        g_documentCreatedHandler(webview);
+}
+
+void MockHost::OnMessagePosted(MockWebView& webview, const std::wstring& json)
+{
+    if (g_messagePostedHandler)
+        g_messagePostedHandler(webview, json);
+}
+
+const std::vector<MockWebView*>& MockHost::GetWebViews()
+{
+    return g_webViews;
+}
+
+MockWebView* MockHost::FindWebView(const std::wstring& suffix)
+{
+    for (MockWebView* webview : g_webViews)
+    {
+        const std::wstring& source = webview->GetSource();
+        if (source.size() >= suffix.size() && source.compare(source.size() - suffix.size(), suffix.size(), suffix) == 0)
+            return webview;
+    }
+    return nullptr;
+}
+
+void MockHost::Register(MockWebView* webview)
+{
+    g_webViews.push_back(webview);
+}
+
+void MockHost::Unregister(MockWebView* webview)
+{
+    g_webViews.erase(std::remove(g_webViews.begin(), g_webViews.end(), webview), g_webViews.end());
+}
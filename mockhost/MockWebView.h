@@ -0,0 +1,290 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "webview2.h"
+#include "wrl.h"
+
+// In-process stand-ins for the WebView2 environment, controller and
+// webview. Calls that complete asynchronously in the runtime complete from
+// the MockPlatform queue here, and a navigation raises NavigationStarting,
+// SourceChanged, HistoryChanged and NavigationCompleted as separate tasks so
+// the events of many tabs interleave the way they would for real.
+
+// TBases are the interfaces TInterface derives from, which it answers for too
+template <typename TInterface, typename... TBases>
+class MockObject : public TInterface
+{
+public:
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+    {
+        if (riid == __uuidof(TInterface) || ((riid == __uuidof(TBases)) || ...) || riid == __uuidof(IUnknown))
+        {
+            this->AddRef();
+            *object = static_cast<TInterface*>(this);
+            return S_OK;
+        }
+        *object = nullptr;
+        return E_NOINTERFACE;
+    }
+    ULONG STDMETHODCALLTYPE AddRef() override { return ++m_refCount; }
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        ULONG count = --m_refCount;
+        if (count == 0)
+            delete this;
+        return count;
+    }
+
+private:
+    std::atomic<ULONG> m_refCount = 0;
+};
+
+template <typename THandler>
+class MockEventSource
+{
+public:
+    HRESULT Add(THandler* handler, EventRegistrationToken* token)
+    {
+        if (handler == nullptr || token == nullptr)
+            return E_INVALIDARG;
+
+        token->value = ++s_lastToken;
+        m_handlers.emplace_back(token->value, handler);
+        return S_OK;
+    }
+
+    HRESULT Remove(EventRegistrationToken token)
+    {
+        for (auto it = m_handlers.begin(); it != m_handlers.end(); ++it)
+        {
+            if (it->first == token.value)
+            {
+                m_handlers.erase(it);
+                break;
+            }
+        }
+        return S_OK;
+    }
+
+    // Handlers added or removed by a handler take effect on the next event
+    template <typename... TArgs>
+    void Raise(TArgs... args)
+    {
+        auto handlers = m_handlers;
+        for (auto& handler : handlers)
+            handler.second->Invoke(args...);
+    }
+
+    void Clear() { m_handlers.clear(); }
+    bool IsEmpty() const { return m_handlers.empty(); }
+
+private:
+    static inline int64_t s_lastToken = 0;
+    std::vector<std::pair<int64_t, Microsoft::WRL::ComPtr<THandler>>> m_handlers;
+};
+
+class MockController;
+class MockEnvironment;
+class MockDevToolsProtocolEventReceiver;
+
+class MockWebView : public MockObject<ICoreWebView2_3, ICoreWebView2>
+{
+public:
+    MockWebView(MockEnvironment* environment, MockController* controller);
+    ~MockWebView();
+
+    // ICoreWebView2
+    HRESULT STDMETHODCALLTYPE get_Settings(ICoreWebView2Settings** settings) override;
+    HRESULT STDMETHODCALLTYPE get_Source(LPWSTR* uri) override;
+    HRESULT STDMETHODCALLTYPE Navigate(LPCWSTR uri) override;
+    HRESULT STDMETHODCALLTYPE NavigateToString(LPCWSTR htmlContent) override;
+    HRESULT STDMETHODCALLTYPE add_NavigationStarting(ICoreWebView2NavigationStartingEventHandler* eventHandler, EventRegistrationToken* token) override;
+    HRESULT STDMETHODCALLTYPE remove_NavigationStarting(EventRegistrationToken token) override;
+    HRESULT STDMETHODCALLTYPE add_SourceChanged(ICoreWebView2SourceChangedEventHandler* eventHandler, EventRegistrationToken* token) override;
+    HRESULT STDMETHODCALLTYPE remove_SourceChanged(EventRegistrationToken token) override;
+    HRESULT STDMETHODCALLTYPE add_NavigationCompleted(ICoreWebView2NavigationCompletedEventHandler* eventHandler, EventRegistrationToken* token) override;
+    HRESULT STDMETHODCALLTYPE remove_NavigationCompleted(EventRegistrationToken token) override;
+    HRESULT STDMETHODCALLTYPE AddScriptToExecuteOnDocumentCreated(LPCWSTR javaScript, ICoreWebView2AddScriptToExecuteOnDocumentCreatedCompletedHandler* handler) override;
+    HRESULT STDMETHODCALLTYPE RemoveScriptToExecuteOnDocumentCreated(LPCWSTR id) override;
+    HRESULT STDMETHODCALLTYPE ExecuteScript(LPCWSTR javaScript, ICoreWebView2ExecuteScriptCompletedHandler* handler) override;
+    HRESULT STDMETHODCALLTYPE Reload() override;
+    HRESULT STDMETHODCALLTYPE PostWebMessageAsJson(LPCWSTR webMessageAsJson) override;
+    HRESULT STDMETHODCALLTYPE PostWebMessageAsString(LPCWSTR webMessageAsString) override;
+    HRESULT STDMETHODCALLTYPE add_WebMessageReceived(ICoreWebView2WebMessageReceivedEventHandler* handler, EventRegistrationToken* token) override;
+    HRESULT STDMETHODCALLTYPE remove_WebMessageReceived(EventRegistrationToken token) override;
+    HRESULT STDMETHODCALLTYPE CallDevToolsProtocolMethod(LPCWSTR methodName, LPCWSTR parametersAsJson, ICoreWebView2CallDevToolsProtocolMethodCompletedHandler* handler) override;
+    HRESULT STDMETHODCALLTYPE get_BrowserProcessId(UINT32* value) override;
+    HRESULT STDMETHODCALLTYPE get_CanGoBack(BOOL* canGoBack) override;
+    HRESULT STDMETHODCALLTYPE get_CanGoForward(BOOL* canGoForward) override;
+    HRESULT STDMETHODCALLTYPE GoBack() override;
+    HRESULT STDMETHODCALLTYPE GoForward() override;
+    HRESULT STDMETHODCALLTYPE GetDevToolsProtocolEventReceiver(LPCWSTR eventName, ICoreWebView2DevToolsProtocolEventReceiver** receiver) override;
+    HRESULT STDMETHODCALLTYPE Stop() override;
+    HRESULT STDMETHODCALLTYPE add_HistoryChanged(ICoreWebView2HistoryChangedEventHandler* eventHandler, EventRegistrationToken* token) override;
+    HRESULT STDMETHODCALLTYPE remove_HistoryChanged(EventRegistrationToken token) override;
+    HRESULT STDMETHODCALLTYPE get_DocumentTitle(LPWSTR* title) override;
+    HRESULT STDMETHODCALLTYPE add_DocumentTitleChanged(ICoreWebView2DocumentTitleChangedEventHandler* eventHandler, EventRegistrationToken* token) override;
+    HRESULT STDMETHODCALLTYPE remove_DocumentTitleChanged(EventRegistrationToken token) override;
+    HRESULT STDMETHODCALLTYPE OpenDevToolsWindow() override;
+
+    // ICoreWebView2_3
+    HRESULT STDMETHODCALLTYPE TrySuspend(ICoreWebView2TrySuspendCompletedHandler* handler) override;
+    HRESULT STDMETHODCALLTYPE Resume() override;
+    HRESULT STDMETHODCALLTYPE get_IsSuspended(BOOL* isSuspended) override;
+
+    // What the page does. PostMessageFromPage raises WebMessageReceived from
+    // the queue like window.chrome.webview.postMessage, DispatchMessageFromPage
+    // raises it right away so the host's handling can be timed.
+    void PostMessageFromPage(const std::wstring& json);
+    void DispatchMessageFromPage(const std::wstring& json);
+    void RaiseDevToolsProtocolEvent(const std::wstring& eventName, const std::wstring& parameterObjectAsJson);
+    void SetDocumentTitle(const std::wstring& title);
+
+    const std::wstring& GetSource() const { return m_source; }
+    bool IsLoading() const { return m_navigationId != 0; }
+    bool IsClosed() const { return m_controller == nullptr; }
+    bool IsSuspended() const { return m_isSuspended; }
+    // Set for the UI and for tabs, not for pooled WebViews yet to be used
+    bool HasWebMessageHandler() const { return !m_webMessageReceived.IsEmpty(); }
+    MockController* GetController() const { return m_controller; }
+    const std::vector<std::wstring>& GetDocumentScripts() const { return m_documentScripts; }
+
+    // Everything the host posted with PostWebMessageAsJson
+    const std::vector<std::wstring>& GetPostedMessages() const { return m_postedMessages; }
+    void ClearPostedMessages() { m_postedMessages.clear(); }
+
+    // Called by the controller when it's closed
+    void Close();
+
+    static const HRESULT c_closedError = HRESULT_FROM_WIN32(ERROR_INVALID_STATE);
+
+private:
+    void StartNavigation(const std::wstring& uri, bool addToHistory);
+    void CommitNavigation(uint64_t navigationId, const std::wstring& uri, bool addToHistory);
+    void CompleteNavigation(uint64_t navigationId, bool isSuccess);
+
+    Microsoft::WRL::ComPtr<MockEnvironment> m_environment;
+    MockController* m_controller; // Cleared when the controller is closed
+    Microsoft::WRL::ComPtr<ICoreWebView2Settings> m_settings;
+    std::wstring m_source = L"about:blank";
+    std::wstring m_title;
+    std::vector<std::wstring> m_history;
+    size_t m_historyIndex = 0;
+    uint64_t m_navigationId = 0; // Of the navigation in progress, or 0
+    bool m_isSuspended = false;
+    std::vector<std::wstring> m_documentScripts;
+    std::vector<std::wstring> m_postedMessages;
+    std::map<std::wstring, Microsoft::WRL::ComPtr<MockDevToolsProtocolEventReceiver>> m_devToolsReceivers;
+
+    MockEventSource<ICoreWebView2NavigationStartingEventHandler> m_navigationStarting;
+    MockEventSource<ICoreWebView2SourceChangedEventHandler> m_sourceChanged;
+    MockEventSource<ICoreWebView2HistoryChangedEventHandler> m_historyChanged;
+    MockEventSource<ICoreWebView2NavigationCompletedEventHandler> m_navigationCompleted;
+    MockEventSource<ICoreWebView2WebMessageReceivedEventHandler> m_webMessageReceived;
+    MockEventSource<ICoreWebView2DocumentTitleChangedEventHandler> m_documentTitleChanged;
+};
+
+class MockController : public MockObject<ICoreWebView2Controller>
+{
+public:
+    MockController(MockEnvironment* environment, HWND parentWindow);
+    ~MockController();
+
+    // ICoreWebView2Controller
+    HRESULT STDMETHODCALLTYPE get_IsVisible(BOOL* isVisible) override;
+    HRESULT STDMETHODCALLTYPE put_IsVisible(BOOL isVisible) override;
+    HRESULT STDMETHODCALLTYPE get_Bounds(RECT* bounds) override;
+    HRESULT STDMETHODCALLTYPE put_Bounds(RECT bounds) override;
+    HRESULT STDMETHODCALLTYPE get_ZoomFactor(double* zoomFactor) override;
+    HRESULT STDMETHODCALLTYPE put_ZoomFactor(double zoomFactor) override;
+    HRESULT STDMETHODCALLTYPE add_ZoomFactorChanged(ICoreWebView2ZoomFactorChangedEventHandler* eventHandler, EventRegistrationToken* token) override;
+    HRESULT STDMETHODCALLTYPE remove_ZoomFactorChanged(EventRegistrationToken token) override;
+    HRESULT STDMETHODCALLTYPE MoveFocus(COREWEBVIEW2_MOVE_FOCUS_REASON reason) override;
+    HRESULT STDMETHODCALLTYPE add_GotFocus(ICoreWebView2FocusChangedEventHandler* eventHandler, EventRegistrationToken* token) override;
+    HRESULT STDMETHODCALLTYPE remove_GotFocus(EventRegistrationToken token) override;
+    HRESULT STDMETHODCALLTYPE add_LostFocus(ICoreWebView2FocusChangedEventHandler* eventHandler, EventRegistrationToken* token) override;
+    HRESULT STDMETHODCALLTYPE remove_LostFocus(EventRegistrationToken token) override;
+    HRESULT STDMETHODCALLTYPE add_AcceleratorKeyPressed(ICoreWebView2AcceleratorKeyPressedEventHandler* eventHandler, EventRegistrationToken* token) override;
+    HRESULT STDMETHODCALLTYPE remove_AcceleratorKeyPressed(EventRegistrationToken token) override;
+    HRESULT STDMETHODCALLTYPE get_ParentWindow(HWND* parentWindow) override;
+    HRESULT STDMETHODCALLTYPE put_ParentWindow(HWND parentWindow) override;
+    HRESULT STDMETHODCALLTYPE NotifyParentWindowPositionChanged() override;
+    HRESULT STDMETHODCALLTYPE Close() override;
+    HRESULT STDMETHODCALLTYPE get_CoreWebView2(ICoreWebView2** coreWebView2) override;
+
+    // Raises AcceleratorKeyPressed for a key down, as the focused page would
+    void PressKey(UINT virtualKey);
+
+    MockWebView* GetWebView() const { return m_webView.Get(); }
+    HWND GetWindow() const { return m_hWnd; }
+    bool IsVisible() const { return m_isVisible; }
+    const RECT& GetBounds() const { return m_bounds; }
+    // Calls to put_Bounds, unchanged bounds included
+    size_t GetBoundsCount() const { return m_boundsCount; }
+
+private:
+    Microsoft::WRL::ComPtr<MockEnvironment> m_environment;
+    Microsoft::WRL::ComPtr<MockWebView> m_webView;
+    HWND m_parentWindow;
+    HWND m_hWnd = nullptr; // The window the page renders to
+    RECT m_bounds = {};
+    size_t m_boundsCount = 0;
+    bool m_isVisible = true;
+    double m_zoomFactor = 1.0;
+
+    MockEventSource<ICoreWebView2ZoomFactorChangedEventHandler> m_zoomFactorChanged;
+    MockEventSource<ICoreWebView2FocusChangedEventHandler> m_gotFocus;
+    MockEventSource<ICoreWebView2FocusChangedEventHandler> m_lostFocus;
+    MockEventSource<ICoreWebView2AcceleratorKeyPressedEventHandler> m_acceleratorKeyPressed;
+
+    static MockController* s_focused;
+};
+
+class MockEnvironment : public MockObject<ICoreWebView2Environment>
+{
+public:
+    explicit MockEnvironment(std::wstring userDataFolder);
+
+    // ICoreWebView2Environment
+    HRESULT STDMETHODCALLTYPE CreateCoreWebView2Controller(HWND parentWindow, ICoreWebView2CreateCoreWebView2ControllerCompletedHandler* handler) override;
+    HRESULT STDMETHODCALLTYPE get_BrowserVersionString(LPWSTR* versionInfo) override;
+
+    const std::wstring& GetUserDataFolder() const { return m_userDataFolder; }
+    DWORD GetBrowserProcessId() const { return m_browserProcessId; }
+
+private:
+    std::wstring m_userDataFolder;
+    DWORD m_browserProcessId;
+};
+
+// Scripts the pages and finds the WebViews the host created
+class MockHost
+{
+public:
+    // Runs when a document is created in any WebView, where the scripts
+    // added with AddScriptToExecuteOnDocumentCreated would run
+    using DocumentCreatedHandler = std::function<void(MockWebView& webview)>;
+    // Runs when the host posts a message to a page
+    using MessagePostedHandler = std::function<void(MockWebView& webview, const std::wstring& json)>;
+
+    static void SetDocumentCreatedHandler(DocumentCreatedHandler handler);
+    static void SetMessagePostedHandler(MessagePostedHandler handler);
+    static void OnDocumentCreated(MockWebView& webview);
+    static void OnMessagePosted(MockWebView& webview, const std::wstring& json);
+
+    // WebViews that haven't been closed, in creation order
+    static const std::vector<MockWebView*>& GetWebViews();
+    // The first open WebView whose source ends with suffix
+    static MockWebView* FindWebView(const std::wstring& suffix);
+
+    static void Register(MockWebView* webview);
+    static void Unregister(MockWebView* webview);
+};
@@ -0,0 +1,318 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// TrafficReplay.cpp : Replays a traffic log recorded from browser://metrics,
+// or a synthetic one, through the browser host on the mock WebView2. The
+// messages the pages sent are dispatched in order on the virtual clock, so
+// the frame timers fire as they did, but without waiting in between. The
+// messages the host posted are not replayed, but the replay must post at
+// least as many to the tabs and the options UI, which only get replies.
+// Controls updates are batched per frame, so those counts are only shown.
+//
+// traffic_replay <log.bin>
+// traffic_replay --synthetic [--tabs N] [--interval ms] [--duration ms] [--save log.bin]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+#include "HeadlessBrowser.h"
+#include "MessageSchema.h"
+#include "MockPlatform.h"
+#include "TrafficRecorder.h"
+
+namespace
+{
+    struct SyntheticOptions
+    {
+        size_t tabCount = 500;
+        uint64_t interval = 2000; // ms between two navigations in a tab
+        uint64_t duration = 60000; // ms
+    };
+
+    std::wstring MakeMessage(int message, const std::wstring& args)
+    {
+        return L"{\"message\":" + std::to_wstring(message) + L",\"args\":{" + args + L"}}";
+    }
+
+    // Opens all tabs at once, then every tab navigates once per interval,
+    // spread evenly over it, and reports its new title
+    void GenerateTraffic(const SyntheticOptions& options, TrafficRecorder& recorder)
+    {
+        TrafficRecord record;
+        for (size_t tabId = 1; tabId <= options.tabCount; ++tabId)
+        {
+            record.json = MakeMessage(MG_CREATE_TAB, L"\"tabId\":" + std::to_wstring(tabId) +
+                L",\"active\":" + (tabId == 1 ? L"true" : L"false"));
+            recorder.Append(record);
+        }
+
+        for (uint64_t round = 1; round * options.interval <= options.duration; ++round)
+        {
+            for (size_t tabId = 1; tabId <= options.tabCount; ++tabId)
+            {
+                std::wstring id = std::to_wstring(tabId);
+                record.time = (round * options.interval * 1000) + (tabId - 1) * options.interval * 1000 / options.tabCount;
+                record.endpoint = TrafficEndpoint::Controls;
+                record.tabId = INVALID_TAB_ID;
+                record.json = MakeMessage(MG_SWITCH_TAB, L"\"tabId\":" + id);
+                recorder.Append(record);
+
+                record.json = MakeMessage(MG_NAVIGATE, L"\"uri\":\"https://example.com/" + id + L"/" +
+                    std::to_wstring(round) + L"\"");
+                recorder.Append(record);
+
+                record.endpoint = TrafficEndpoint::Tab;
+                record.tabId = tabId;
+                record.json = MakeMessage(MG_PAGE_METADATA, L"\"title\":\"Page " + id + L"\"");
+                recorder.Append(record);
+            }
+        }
+    }
+
+    bool ReadFile(const char* path, std::vector<uint8_t>& contents)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    bool WriteFile(const char* path, const std::vector<uint8_t>& contents)
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+        return static_cast<bool>(file);
+    }
+
+    // The id of a message from the controls UI, and the tab it creates or
+    // closes
+    int GetControlsMessage(const TrafficRecord& record, size_t& tabId)
+    {
+        if (record.endpoint != TrafficEndpoint::Controls)
+            return 0;
+
+        std::wstring json = record.json; // Decoded in place
+        int message = 0;
+        JsonValue args;
+        if (!JsonReader::ReadMessage(&json[0], message, args))
+            return 0;
+
+        TabArgs tab;
+        if ((message == MG_CREATE_TAB || message == MG_CLOSE_TAB) && DecodeArgs(args, tab))
+            tabId = tab.tabId;
+        return message;
+    }
+
+    TrafficEndpoint GetEndpoint(const HeadlessBrowser& browser, const MockWebView& webview)
+    {
+        if (&webview == browser.GetControls())
+            return TrafficEndpoint::Controls;
+        if (&webview == browser.GetOptions())
+            return TrafficEndpoint::Options;
+        return TrafficEndpoint::Tab;
+    }
+
+    void PrintUsage()
+    {
+        fprintf(stderr, "usage: traffic_replay <log.bin>\n"
+            "       traffic_replay --synthetic [--tabs N] [--interval ms] [--duration ms] [--save log.bin]\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* logPath = nullptr;
+    const char* savePath = nullptr;
+    bool synthetic = false;
+    bool valid = true;
+    SyntheticOptions options;
+    for (int i = 1; i < argc && valid; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--synthetic") == 0)
+            synthetic = true;
+        else if (strcmp(argv[i], "--tabs") == 0 && hasValue)
+            options.tabCount = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--interval") == 0 && hasValue)
+            options.interval = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--duration") == 0 && hasValue)
+            options.duration = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--save") == 0 && hasValue)
+            savePath = argv[++i];
+        else if (argv[i][0] != '-' && logPath == nullptr)
+            logPath = argv[i];
+        else
+            valid = false;
+    }
+    if (!valid || synthetic == (logPath != nullptr) || options.tabCount == 0 || options.interval == 0)
+    {
+        PrintUsage();
+        return 2;
+    }
+    MockPlatform::SetDebugOutput(getenv("HEADLESS_BENCH_DEBUG") != nullptr);
+
+    std::vector<uint8_t> log;
+    if (synthetic)
+    {
+        TrafficRecorder recorder;
+        GenerateTraffic(options, recorder);
+        log = recorder.TakeLog();
+        if (savePath != nullptr && !WriteFile(savePath, log))
+        {
+            fprintf(stderr, "Could not write %s\n", savePath);
+            return 1;
+        }
+    }
+    else if (!ReadFile(logPath, log))
+    {
+        fprintf(stderr, "Could not read %s\n", logPath);
+        return 1;
+    }
+
+    std::vector<TrafficRecord> records;
+    if (!TrafficRecorder::ReadLog(log, records))
+    {
+        fprintf(stderr, "Not a traffic log\n");
+        return 1;
+    }
+
+    HeadlessBrowser browser;
+    if (!browser.Launch())
+    {
+        fprintf(stderr, "Could not launch the browser\n");
+        return 1;
+    }
+
+    // Tabs are matched to the WebViews created for them while replaying
+    std::unordered_map<size_t, MockWebView*> tabs;
+    LatencyHistogram latency;
+    LatencyHistogram endpointLatency[3];
+    size_t skipped = 0;
+    size_t recordedPosts[3] = {};
+    size_t replayedPosts[3] = {};
+    MockHost::SetMessagePostedHandler([&browser, &replayedPosts](MockWebView& webview, const std::wstring&)
+    {
+        ++replayedPosts[static_cast<size_t>(GetEndpoint(browser, webview))];
+    });
+    uint64_t origin = MockPlatform::GetTime();
+    bool closed = false; // By the log
+    bool settled = true;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const TrafficRecord& record : records)
+    {
+        if (record.posted)
+        {
+            ++recordedPosts[static_cast<size_t>(record.endpoint)];
+            continue;
+        }
+
+        browser.RunUntil(origin + record.time / 1000);
+
+        MockWebView* webview = nullptr;
+        switch (record.endpoint)
+        {
+        case TrafficEndpoint::Controls:
+            webview = browser.GetControls();
+            break;
+        case TrafficEndpoint::Options:
+            webview = browser.GetOptions();
+            break;
+        case TrafficEndpoint::Tab:
+        {
+            auto it = tabs.find(record.tabId);
+            webview = it != tabs.end() ? it->second : nullptr;
+        }
+        break;
+        }
+        if (webview == nullptr)
+        {
+            ++skipped;
+            continue;
+        }
+
+        size_t tabId = INVALID_TAB_ID;
+        int controlsMessage = GetControlsMessage(record, tabId);
+        std::vector<MockWebView*> attached; // WebViews already in use
+        if (controlsMessage == MG_CREATE_TAB)
+        {
+            for (MockWebView* existing : MockHost::GetWebViews())
+            {
+                if (existing->HasWebMessageHandler())
+                    attached.push_back(existing);
+            }
+        }
+
+        auto dispatchStart = std::chrono::steady_clock::now();
+        webview->DispatchMessageFromPage(record.json);
+        uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - dispatchStart).count();
+        latency.Record(elapsed);
+        endpointLatency[static_cast<size_t>(record.endpoint)].Record(elapsed);
+
+        if (controlsMessage == MG_CREATE_TAB)
+        {
+            // The tab either took a pooled WebView or waits for a new one,
+            // either way it's the only one that just got a message handler
+            MockPlatform::RunUntilIdle();
+            for (MockWebView* created : MockHost::GetWebViews())
+            {
+                if (created->HasWebMessageHandler() && std::find(attached.begin(), attached.end(), created) == attached.end())
+                    tabs[tabId] = created;
+            }
+        }
+        else if (controlsMessage == MG_CLOSE_TAB)
+        {
+            tabs.erase(tabId);
+        }
+        else if (controlsMessage == MG_CLOSE_WINDOW)
+        {
+            closed = true;
+            break;
+        }
+        browser.GetControls()->ClearPostedMessages();
+    }
+    if (!closed)
+        settled = browser.RunUntilSettled();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("replayed   %llu messages (%zu skipped) from %.1f s of traffic in %.1f ms\n",
+        static_cast<unsigned long long>(latency.GetCount()), skipped,
+        records.empty() ? 0.0 : records.back().time / 1e6, seconds * 1000);
+    PrintLatency("all", latency, seconds);
+    PrintLatency("controls", endpointLatency[static_cast<size_t>(TrafficEndpoint::Controls)], seconds);
+    PrintLatency("options", endpointLatency[static_cast<size_t>(TrafficEndpoint::Options)], seconds);
+    PrintLatency("tabs", endpointLatency[static_cast<size_t>(TrafficEndpoint::Tab)], seconds);
+
+    const size_t toControls = static_cast<size_t>(TrafficEndpoint::Controls);
+    const size_t toOptions = static_cast<size_t>(TrafficEndpoint::Options);
+    const size_t toTabs = static_cast<size_t>(TrafficEndpoint::Tab);
+    printf("posted     controls %zu, options %zu, tabs %zu (recorded %zu, %zu, %zu)\n",
+        replayedPosts[toControls], replayedPosts[toOptions], replayedPosts[toTabs],
+        recordedPosts[toControls], recordedPosts[toOptions], recordedPosts[toTabs]);
+
+    if (closed)
+        MockPlatform::RunUntilIdle();
+    else
+        browser.Close();
+    MockHost::SetMessagePostedHandler(nullptr);
+
+    // A synthetic log creates every tab it sends from, and a recorded one
+    // starts with the tabs that were already open, so nothing is skipped
+    bool complete = skipped == 0 && replayedPosts[toOptions] >= recordedPosts[toOptions] &&
+        replayedPosts[toTabs] >= recordedPosts[toTabs];
+    size_t failures = MockPlatform::GetFailureCount();
+    if (!settled || !complete || failures > 0)
+    {
+        fprintf(stderr, "failed: settled %d, %zu skipped, %zu options and %zu tab replies of %zu and %zu, %zu host errors\n",
+            settled, skipped, replayedPosts[toOptions], replayedPosts[toTabs], recordedPosts[toOptions], recordedPosts[toTabs], failures);
+        return 1;
+    }
+    return 0;
+}
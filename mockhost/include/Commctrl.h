@@ -0,0 +1,14 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include "windows.h"
+
+typedef LRESULT (CALLBACK* SUBCLASSPROC)(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam,
+    UINT_PTR idSubclass, DWORD_PTR refData);
+
+BOOL SetWindowSubclass(HWND hWnd, SUBCLASSPROC subclassProc, UINT_PTR idSubclass, DWORD_PTR refData);
+BOOL RemoveWindowSubclass(HWND hWnd, SUBCLASSPROC subclassProc, UINT_PTR idSubclass);
+LRESULT DefSubclassProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
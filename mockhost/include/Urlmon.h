@@ -0,0 +1,17 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include "windows.h"
+
+#define Uri_CREATE_ALLOW_IMPLICIT_FILE_SCHEME 0x00000004
+
+struct IUri : public IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE GetAbsoluteUri(BSTR* absoluteUri) = 0;
+};
+
+// Only paths and file URIs are understood
+HRESULT CreateUri(LPCWSTR uri, DWORD flags, DWORD_PTR reserved, IUri** result);
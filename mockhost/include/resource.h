@@ -0,0 +1,8 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+// The resource ids of WebViewBrowserApp.rc
+#include "../../Resource.h"
@@ -0,0 +1,13 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include "windows.h"
+
+#define CSIDL_APPDATA 0x001a
+
+HRESULT SHGetFolderPathW(HWND hWnd, int csidl, HANDLE token, DWORD flags, LPWSTR path);
+
+#define SHGetFolderPath SHGetFolderPathW
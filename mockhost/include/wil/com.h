@@ -0,0 +1,83 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include "../windows.h"
+#include "../wrl.h"
+
+// The wil smart pointers the host uses
+namespace wil
+{
+    template <typename T>
+    using com_ptr = Microsoft::WRL::ComPtr<T>;
+
+    template <typename T, void (*Close)(T), T (*Invalid)()>
+    class unique_any
+    {
+    public:
+        unique_any() = default;
+        explicit unique_any(T value) : m_value(value) {}
+        unique_any(unique_any&& other) noexcept : m_value(other.release()) {}
+        unique_any(const unique_any&) = delete;
+        ~unique_any() { reset(); }
+
+        unique_any& operator=(unique_any&& other) noexcept
+        {
+            if (this != &other)
+                reset(other.release());
+            return *this;
+        }
+        unique_any& operator=(const unique_any&) = delete;
+
+        T get() const { return m_value; }
+        explicit operator bool() const { return m_value != Invalid(); }
+
+        void reset(T value = Invalid())
+        {
+            if (m_value != Invalid())
+                Close(m_value);
+            m_value = value;
+        }
+        T release()
+        {
+            T value = m_value;
+            m_value = Invalid();
+            return value;
+        }
+        T* put()
+        {
+            reset();
+            return &m_value;
+        }
+        T* operator&() { return put(); }
+
+    private:
+        T m_value = Invalid();
+    };
+
+    namespace details
+    {
+        inline void CloseHandleValue(HANDLE h) { ::CloseHandle(h); }
+        inline void FreeCoTaskMem(wchar_t* p) { ::CoTaskMemFree(p); }
+        inline void FreeBstr(wchar_t* p) { ::SysFreeString(p); }
+        inline HANDLE NullHandle() { return nullptr; }
+        inline HANDLE InvalidHandle() { return INVALID_HANDLE_VALUE; }
+        inline wchar_t* NullString() { return nullptr; }
+    }
+
+    using unique_handle = unique_any<HANDLE, details::CloseHandleValue, details::NullHandle>;
+    using unique_hfile = unique_any<HANDLE, details::CloseHandleValue, details::InvalidHandle>;
+    using unique_cotaskmem_string = unique_any<wchar_t*, details::FreeCoTaskMem, details::NullString>;
+    using unique_bstr = unique_any<wchar_t*, details::FreeBstr, details::NullString>;
+
+    inline unique_cotaskmem_string make_cotaskmem_string(PCWSTR source)
+    {
+        size_t length = wcslen(source) + 1;
+        auto copy = static_cast<wchar_t*>(::CoTaskMemAlloc(length * sizeof(wchar_t)));
+        if (copy != nullptr)
+            wmemcpy(copy, source, length);
+        return unique_cotaskmem_string(copy);
+    }
+}
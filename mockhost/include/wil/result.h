@@ -0,0 +1,25 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include "../windows.h"
+
+// The wil error macros the host uses, without logging
+#define RETURN_HR(hr) return (hr)
+#define RETURN_LAST_ERROR() return HRESULT_FROM_WIN32(GetLastError() != 0 ? GetLastError() : ERROR_INVALID_PARAMETER)
+
+#define RETURN_IF_FAILED(hr) \
+    do { HRESULT __hrRet = (hr); if (FAILED(__hrRet)) return __hrRet; } while (0)
+#define RETURN_HR_IF(hr, condition) \
+    do { if (condition) return (hr); } while (0)
+#define RETURN_HR_IF_NULL(hr, ptr) \
+    do { if ((ptr) == nullptr) return (hr); } while (0)
+#define RETURN_IF_NULL_ALLOC(ptr) \
+    do { if ((ptr) == nullptr) return E_OUTOFMEMORY; } while (0)
+#define RETURN_LAST_ERROR_IF(condition) \
+    do { if (condition) RETURN_LAST_ERROR(); } while (0)
+#define RETURN_IF_WIN32_BOOL_FALSE(win32BOOL) \
+    do { if (!(win32BOOL)) RETURN_LAST_ERROR(); } while (0)
+#define LOG_IF_FAILED(hr) (hr)
@@ -0,0 +1,479 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+// The part of the Win32 API the browser host uses, declared the way the SDK
+// does and implemented in-process by mockhost/MockPlatform.cpp. Windows,
+// messages, timers, processes and files are all emulated, nothing here talks
+// to a real window system.
+
+#include <cmath>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <cwctype>
+#include <string>
+#include <utility>
+
+#define CALLBACK
+#define APIENTRY
+#define WINAPI
+#define STDMETHODCALLTYPE
+#define _In_
+#define _In_opt_
+#define _In_z_
+#define _Out_
+#define _Out_opt_
+#define _Inout_
+
+typedef int32_t HRESULT;
+typedef int BOOL;
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef int16_t SHORT;
+typedef int INT;
+typedef unsigned int UINT;
+typedef uint32_t UINT32;
+typedef uint64_t UINT64;
+typedef int64_t LONGLONG;
+typedef uint64_t ULONGLONG;
+typedef size_t SIZE_T;
+typedef uint16_t ATOM;
+typedef uintptr_t WPARAM;
+typedef intptr_t LPARAM;
+typedef intptr_t LRESULT;
+typedef intptr_t LONG_PTR;
+typedef uintptr_t UINT_PTR;
+typedef uintptr_t ULONG_PTR;
+typedef uintptr_t DWORD_PTR;
+typedef DWORD* LPDWORD;
+typedef void* LPVOID;
+typedef void* PVOID;
+typedef const void* LPCVOID;
+typedef char CHAR;
+typedef char* LPSTR;
+typedef const char* LPCSTR;
+typedef bool* LPBOOL;
+typedef wchar_t WCHAR;
+typedef wchar_t TCHAR;
+typedef wchar_t* LPWSTR;
+typedef wchar_t* PWSTR;
+typedef const wchar_t* LPCWSTR;
+typedef const wchar_t* PCWSTR;
+typedef wchar_t* BSTR;
+
+struct HWND__;
+typedef HWND__* HWND;
+struct HINSTANCE__;
+typedef HINSTANCE__* HINSTANCE;
+typedef HINSTANCE HMODULE;
+typedef void* HANDLE;
+typedef void* HMENU;
+typedef void* HDC;
+typedef void* HBRUSH;
+typedef void* HICON;
+typedef void* HCURSOR;
+typedef void* HPEN;
+typedef void* HGDIOBJ;
+
+struct RECT { LONG left, top, right, bottom; };
+typedef RECT* LPRECT;
+typedef RECT* PRECT;
+typedef const RECT* LPCRECT;
+struct POINT { LONG x, y; };
+typedef POINT* LPPOINT;
+struct MSG { HWND hwnd; UINT message; WPARAM wParam; LPARAM lParam; DWORD time; POINT pt; };
+typedef MSG* LPMSG;
+struct MINMAXINFO { POINT ptReserved, ptMaxSize, ptMaxPosition, ptMinTrackSize, ptMaxTrackSize; };
+struct PAINTSTRUCT { HDC hdc; BOOL fErase; RECT rcPaint; };
+struct CREATESTRUCTW { LPVOID lpCreateParams; HINSTANCE hInstance; HMENU hMenu; HWND hwndParent; int cy, cx, y, x; LONG style; LPCWSTR lpszName, lpszClass; DWORD dwExStyle; };
+struct WINDOWPOS { HWND hwnd, hwndInsertAfter; int x, y, cx, cy; UINT flags; };
+struct NCCALCSIZE_PARAMS { RECT rgrc[3]; WINDOWPOS* lppos; };
+struct SYSTEMTIME { WORD wYear, wMonth, wDayOfWeek, wDay, wHour, wMinute, wSecond, wMilliseconds; };
+struct FILETIME { DWORD dwLowDateTime, dwHighDateTime; };
+struct SECURITY_ATTRIBUTES;
+struct OVERLAPPED;
+
+typedef LRESULT (CALLBACK* WNDPROC)(HWND, UINT, WPARAM, LPARAM);
+typedef BOOL (CALLBACK* WNDENUMPROC)(HWND, LPARAM);
+typedef void (CALLBACK* TIMERPROC)(HWND, UINT, UINT_PTR, DWORD);
+struct HWINEVENTHOOK__;
+typedef HWINEVENTHOOK__* HWINEVENTHOOK;
+typedef void (CALLBACK* WINEVENTPROC)(HWINEVENTHOOK, DWORD, HWND, LONG, LONG, DWORD, DWORD);
+
+struct WNDCLASSEXW
+{
+    UINT cbSize;
+    UINT style;
+    WNDPROC lpfnWndProc;
+    int cbClsExtra;
+    int cbWndExtra;
+    HINSTANCE hInstance;
+    HICON hIcon;
+    HCURSOR hCursor;
+    HBRUSH hbrBackground;
+    LPCWSTR lpszMenuName;
+    LPCWSTR lpszClassName;
+    HICON hIconSm;
+};
+typedef WNDCLASSEXW WNDCLASSEX;
+
+struct WNDCLASSW
+{
+    UINT style;
+    WNDPROC lpfnWndProc;
+    int cbClsExtra;
+    int cbWndExtra;
+    HINSTANCE hInstance;
+    HICON hIcon;
+    HCURSOR hCursor;
+    HBRUSH hbrBackground;
+    LPCWSTR lpszMenuName;
+    LPCWSTR lpszClassName;
+};
+typedef WNDCLASSW WNDCLASS;
+
+// COM
+struct GUID
+{
+    uint32_t Data1;
+    uint16_t Data2;
+    uint16_t Data3;
+    uint8_t Data4[8];
+};
+typedef GUID IID;
+typedef const IID& REFIID;
+
+inline bool operator==(const GUID& a, const GUID& b) { return std::memcmp(&a, &b, sizeof(GUID)) == 0; }
+inline bool operator!=(const GUID& a, const GUID& b) { return !(a == b); }
+
+// Interfaces have no __declspec(uuid) here, each one gets a process-unique
+// IID from its type instead.
+namespace MockCom
+{
+    uint32_t NextInterfaceId();
+
+    template <typename T>
+    const IID& IidOf()
+    {
+        static const IID iid = { NextInterfaceId(), 0, 0, { 0 } };
+        return iid;
+    }
+}
+#define __uuidof(T) MockCom::IidOf<T>()
+#define IID_PPV_ARGS(pp) __uuidof(**(pp)), reinterpret_cast<void**>(pp)
+
+struct IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) = 0;
+    virtual ULONG STDMETHODCALLTYPE AddRef() = 0;
+    virtual ULONG STDMETHODCALLTYPE Release() = 0;
+    virtual ~IUnknown() = default;
+};
+
+LPVOID CoTaskMemAlloc(size_t size);
+void CoTaskMemFree(LPVOID p);
+BSTR SysAllocString(const wchar_t* s);
+void SysFreeString(BSTR s);
+
+#define TRUE 1
+#define FALSE 0
+#define MAX_PATH 260
+#define INFINITE 0xFFFFFFFF
+
+#define S_OK ((HRESULT)0)
+#define S_FALSE ((HRESULT)1)
+#define E_NOTIMPL ((HRESULT)0x80004001L)
+#define E_NOINTERFACE ((HRESULT)0x80004002L)
+#define E_POINTER ((HRESULT)0x80004003L)
+#define E_ABORT ((HRESULT)0x80004004L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_UNEXPECTED ((HRESULT)0x8000FFFFL)
+#define E_ACCESSDENIED ((HRESULT)0x80070005L)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000EL)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define HRESULT_FROM_WIN32(x) ((HRESULT)(x) <= 0 ? ((HRESULT)(x)) : ((HRESULT)(((x) & 0x0000FFFF) | 0x80070000)))
+
+#define ERROR_SUCCESS 0L
+#define ERROR_FILE_NOT_FOUND 2L
+#define ERROR_ACCESS_DENIED 5L
+#define ERROR_INVALID_HANDLE 6L
+#define ERROR_NO_MORE_FILES 18L
+#define ERROR_FILE_EXISTS 80L
+#define ERROR_INVALID_PARAMETER 87L
+#define ERROR_INSUFFICIENT_BUFFER 122L
+#define ERROR_ALREADY_EXISTS 183L
+#define ERROR_INVALID_WINDOW_HANDLE 1400L
+#define ERROR_CANNOT_FIND_WND_CLASS 1407L
+#define ERROR_CLASS_ALREADY_EXISTS 1410L
+#define ERROR_INVALID_STATE 5023L
+
+#define MAKEINTRESOURCEW(i) ((LPWSTR)((ULONG_PTR)((WORD)(i))))
+#define MAKEINTRESOURCE MAKEINTRESOURCEW
+#define UNREFERENCED_PARAMETER(P) (void)(P)
+#define RGB(r, g, b) ((DWORD)(((BYTE)(r) | ((WORD)((BYTE)(g)) << 8)) | (((DWORD)(BYTE)(b)) << 16)))
+#define LOWORD(l) ((WORD)(((DWORD_PTR)(l)) & 0xffff))
+#define HIWORD(l) ((WORD)((((DWORD_PTR)(l)) >> 16) & 0xffff))
+#define MAKELONG(a, b) ((LONG)(((WORD)(((DWORD_PTR)(a)) & 0xffff)) | ((DWORD)((WORD)(((DWORD_PTR)(b)) & 0xffff))) << 16))
+#define MAKELPARAM(l, h) ((LPARAM)(DWORD)MAKELONG(l, h))
+#define MAKEWPARAM(l, h) ((WPARAM)(DWORD)MAKELONG(l, h))
+#define ARRAYSIZE(a) (sizeof(a) / sizeof((a)[0]))
+#define _countof ARRAYSIZE
+
+#define INVALID_HANDLE_VALUE ((HANDLE)(LONG_PTR)-1)
+#define HWND_TOP ((HWND)0)
+#define HWND_BOTTOM ((HWND)1)
+#define HWND_TOPMOST ((HWND)-1)
+#define IDC_ARROW MAKEINTRESOURCEW(32512)
+
+#define CS_VREDRAW 0x0001
+#define CS_HREDRAW 0x0002
+#define COLOR_WINDOW 5
+#define CW_USEDEFAULT ((int)0x80000000)
+
+#define WS_OVERLAPPED 0x00000000L
+#define WS_SIZEBOX 0x00040000L
+#define WS_VISIBLE 0x10000000L
+#define WS_CHILD 0x40000000L
+#define WS_OVERLAPPEDWINDOW 0x00CF0000L
+
+#define GWL_STYLE (-16)
+#define GWLP_USERDATA (-21)
+#define GW_HWNDNEXT 2
+#define GW_HWNDPREV 3
+#define GW_CHILD 5
+
+#define SW_HIDE 0
+#define SW_SHOWNORMAL 1
+#define SW_SHOW 5
+
+#define SWP_NOSIZE 0x0001
+#define SWP_NOMOVE 0x0002
+#define SWP_NOZORDER 0x0004
+#define SWP_NOREDRAW 0x0008
+#define SWP_NOACTIVATE 0x0010
+#define SWP_FRAMECHANGED 0x0020
+#define SWP_SHOWWINDOW 0x0040
+#define SWP_HIDEWINDOW 0x0080
+
+#define WM_NULL 0x0000
+#define WM_CREATE 0x0001
+#define WM_DESTROY 0x0002
+#define WM_MOVE 0x0003
+#define WM_SIZE 0x0005
+#define WM_ACTIVATE 0x0006
+#define WM_PAINT 0x000F
+#define WM_CLOSE 0x0010
+#define WM_QUIT 0x0012
+#define WM_SHOWWINDOW 0x0018
+#define WM_GETMINMAXINFO 0x0024
+#define WM_WINDOWPOSCHANGED 0x0047
+#define WM_NCCREATE 0x0081
+#define WM_NCDESTROY 0x0082
+#define WM_NCHITTEST 0x0084
+#define WM_NCCALCSIZE 0x0083
+#define WM_TIMER 0x0113
+#define WM_SIZING 0x0214
+#define WM_ENTERSIZEMOVE 0x0231
+#define WM_EXITSIZEMOVE 0x0232
+#define WM_DPICHANGED 0x02E0
+#define WM_USER 0x0400
+#define WM_APP 0x8000
+
+#define HTCLIENT 1
+#define HTLEFT 10
+#define HTRIGHT 11
+#define HTTOP 12
+#define HTBOTTOM 15
+#define HTBOTTOMRIGHT 17
+#define WMSZ_LEFT 1
+#define WMSZ_RIGHT 2
+#define WMSZ_TOP 3
+#define WMSZ_BOTTOM 6
+
+#define VK_LBUTTON 0x01
+#define VK_SHIFT 0x10
+#define VK_CONTROL 0x11
+#define MOUSEEVENTF_LEFTDOWN 0x0002
+#define MOUSEEVENTF_LEFTUP 0x0004
+
+#define SM_CXSCREEN 0
+#define SM_CYSCREEN 1
+#define SM_CYCAPTION 4
+#define SM_CXSIZEFRAME 32
+#define SM_CYSIZEFRAME 33
+#define SM_CXEDGE 45
+#define SM_CYEDGE 46
+
+#define PS_SOLID 0
+#define NULL_BRUSH 5
+
+#define MB_OK 0x00000000L
+#define IDOK 1
+
+#define CP_ACP 0
+#define CP_UTF8 65001
+
+#define GENERIC_READ 0x80000000L
+#define GENERIC_WRITE 0x40000000L
+#define FILE_APPEND_DATA 0x0004
+#define FILE_SHARE_READ 0x00000001
+#define FILE_SHARE_WRITE 0x00000002
+#define CREATE_NEW 1
+#define CREATE_ALWAYS 2
+#define OPEN_EXISTING 3
+#define OPEN_ALWAYS 4
+#define TRUNCATE_EXISTING 5
+#define FILE_ATTRIBUTE_NORMAL 0x00000080
+#define MOVEFILE_REPLACE_EXISTING 0x00000001
+#define MOVEFILE_WRITE_THROUGH 0x00000008
+
+// Window classes and windows
+ATOM RegisterClassExW(const WNDCLASSEXW* wndClass);
+ATOM RegisterClassW(const WNDCLASSW* wndClass);
+HWND CreateWindowExW(DWORD exStyle, LPCWSTR className, LPCWSTR windowName, DWORD style,
+    int x, int y, int width, int height, HWND parent, HMENU menu, HINSTANCE instance, LPVOID param);
+BOOL DestroyWindow(HWND hWnd);
+BOOL IsWindow(HWND hWnd);
+LRESULT DefWindowProcW(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
+LONG_PTR GetWindowLongPtrW(HWND hWnd, int index);
+LONG_PTR SetWindowLongPtrW(HWND hWnd, int index, LONG_PTR value);
+LONG GetWindowLongW(HWND hWnd, int index);
+LONG SetWindowLongW(HWND hWnd, int index, LONG value);
+int GetClassNameW(HWND hWnd, LPWSTR className, int maxCount);
+HWND GetWindow(HWND hWnd, UINT command);
+HWND GetParent(HWND hWnd);
+HWND SetParent(HWND child, HWND newParent);
+BOOL EnumWindows(WNDENUMPROC enumProc, LPARAM lParam);
+DWORD GetWindowThreadProcessId(HWND hWnd, LPDWORD processId);
+
+// Window events, only out of context ones for windows being created and
+// destroyed. They're posted like messages.
+#define EVENT_OBJECT_CREATE 0x8000
+#define EVENT_OBJECT_DESTROY 0x8001
+#define OBJID_WINDOW 0
+#define CHILDID_SELF 0
+#define WINEVENT_OUTOFCONTEXT 0x0000
+HWINEVENTHOOK SetWinEventHook(DWORD eventMin, DWORD eventMax, HMODULE module, WINEVENTPROC proc,
+    DWORD processId, DWORD threadId, DWORD flags);
+BOOL UnhookWinEvent(HWINEVENTHOOK hook);
+
+// Geometry and visibility
+BOOL ShowWindow(HWND hWnd, int cmdShow);
+BOOL IsWindowVisible(HWND hWnd);
+BOOL UpdateWindow(HWND hWnd);
+BOOL SetWindowPos(HWND hWnd, HWND insertAfter, int x, int y, int cx, int cy, UINT flags);
+BOOL MoveWindow(HWND hWnd, int x, int y, int width, int height, BOOL repaint);
+BOOL GetClientRect(HWND hWnd, LPRECT rect);
+BOOL GetWindowRect(HWND hWnd, LPRECT rect);
+int MapWindowPoints(HWND from, HWND to, LPPOINT points, UINT count);
+BOOL OffsetRect(LPRECT rect, int dx, int dy);
+UINT GetDpiForWindow(HWND hWnd);
+int GetSystemMetrics(int index);
+
+// Messages and timers
+LRESULT SendMessageW(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
+BOOL PostMessageW(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
+void PostQuitMessage(int exitCode);
+#define USER_TIMER_MAXIMUM 0x7FFFFFFF
+UINT_PTR SetTimer(HWND hWnd, UINT_PTR id, UINT elapse, TIMERPROC timerFunc);
+BOOL KillTimer(HWND hWnd, UINT_PTR id);
+
+// Input
+SHORT GetKeyState(int virtKey);
+void mouse_event(DWORD flags, DWORD dx, DWORD dy, DWORD data, ULONG_PTR extraInfo);
+HWND SetFocus(HWND hWnd);
+HWND GetFocus();
+
+// Painting is accepted and ignored
+HDC BeginPaint(HWND hWnd, PAINTSTRUCT* paint);
+BOOL EndPaint(HWND hWnd, const PAINTSTRUCT* paint);
+HDC GetWindowDC(HWND hWnd);
+int ReleaseDC(HWND hWnd, HDC hdc);
+HPEN CreatePen(int style, int width, DWORD color);
+HGDIOBJ SelectObject(HDC hdc, HGDIOBJ object);
+HGDIOBJ GetStockObject(int object);
+BOOL DeleteObject(HGDIOBJ object);
+BOOL MoveToEx(HDC hdc, int x, int y, LPPOINT point);
+BOOL LineTo(HDC hdc, int x, int y);
+
+// Resources, modules and processes
+int LoadStringW(HINSTANCE instance, UINT id, LPWSTR buffer, int bufferMax);
+HICON LoadIconW(HINSTANCE instance, LPCWSTR name);
+HCURSOR LoadCursorW(HINSTANCE instance, LPCWSTR name);
+HMODULE GetModuleHandleW(LPCWSTR moduleName);
+DWORD GetModuleFileNameW(HMODULE module, LPWSTR fileName, DWORD size);
+DWORD GetCurrentProcessId();
+DWORD GetCurrentThreadId();
+#define PROCESS_QUERY_LIMITED_INFORMATION 0x1000
+// Processes added with MockPlatform::CreateProcess
+HANDLE OpenProcess(DWORD access, BOOL inheritHandle, DWORD processId);
+BOOL GetProcessTimes(HANDLE process, FILETIME* creationTime, FILETIME* exitTime, FILETIME* kernelTime, FILETIME* userTime);
+int MessageBoxW(HWND hWnd, LPCWSTR text, LPCWSTR caption, UINT type);
+void OutputDebugStringW(LPCWSTR outputString);
+
+// Files, kept in memory
+HANDLE CreateFileW(LPCWSTR fileName, DWORD access, DWORD shareMode, SECURITY_ATTRIBUTES* security,
+    DWORD creationDisposition, DWORD flags, HANDLE templateFile);
+BOOL WriteFile(HANDLE file, LPCVOID buffer, DWORD bytesToWrite, LPDWORD bytesWritten, OVERLAPPED* overlapped);
+BOOL ReadFile(HANDLE file, LPVOID buffer, DWORD bytesToRead, LPDWORD bytesRead, OVERLAPPED* overlapped);
+BOOL DeleteFileW(LPCWSTR fileName);
+BOOL MoveFileExW(LPCWSTR existingFileName, LPCWSTR newFileName, DWORD flags);
+BOOL FlushFileBuffers(HANDLE file);
+BOOL CloseHandle(HANDLE object);
+DWORD GetLastError();
+void SetLastError(DWORD error);
+
+// Time and text
+void GetLocalTime(SYSTEMTIME* time);
+void GetSystemTimeAsFileTime(FILETIME* time);
+ULONGLONG GetTickCount64();
+int WideCharToMultiByte(UINT codePage, DWORD flags, LPCWSTR wideStr, int wideLength,
+    LPSTR multiByteStr, int multiByteLength, LPCSTR defaultChar, LPBOOL usedDefaultChar);
+int MultiByteToWideChar(UINT codePage, DWORD flags, LPCSTR multiByteStr, int multiByteLength,
+    LPWSTR wideStr, int wideLength);
+
+// The MSVC format functions take %s as a wide string in wide formats
+int MockVswprintf(wchar_t* buffer, size_t count, const wchar_t* format, va_list args);
+
+template <size_t N>
+int swprintf_s(wchar_t (&buffer)[N], const wchar_t* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int result = MockVswprintf(buffer, N, format, args);
+    va_end(args);
+    return result;
+}
+
+#define RegisterClass RegisterClassW
+#define CreateWindowEx CreateWindowExW
+#define CreateWindowW(className, windowName, style, x, y, width, height, parent, menu, instance, param) \
+    CreateWindowExW(0L, className, windowName, style, x, y, width, height, parent, menu, instance, param)
+#define DefWindowProc DefWindowProcW
+#define GetWindowLongPtr GetWindowLongPtrW
+#define SetWindowLongPtr SetWindowLongPtrW
+#define GetWindowLong GetWindowLongW
+#define SetWindowLong SetWindowLongW
+#define GetClassName GetClassNameW
+#define SendMessage SendMessageW
+#define PostMessage PostMessageW
+#define LoadString LoadStringW
+#define LoadIcon LoadIconW
+#define LoadCursor LoadCursorW
+#define GetModuleHandle GetModuleHandleW
+#define GetModuleFileName GetModuleFileNameW
+#define MessageBox MessageBoxW
+#define OutputDebugString OutputDebugStringW
+#define CreateFile CreateFileW
+#define DeleteFile DeleteFileW
+#define MoveFileEx MoveFileExW
@@ -0,0 +1,191 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include "windows.h"
+
+// ComPtr and Callback as the host uses them. Callback wraps a lambda in a
+// reference counted object implementing the handler interface's Invoke.
+namespace Microsoft
+{
+namespace WRL
+{
+    template <typename T>
+    class ComPtr
+    {
+    public:
+        using InterfaceType = T;
+
+        ComPtr() = default;
+        ComPtr(std::nullptr_t) {}
+        ComPtr(T* p) : m_ptr(p) { InternalAddRef(); }
+        ComPtr(const ComPtr& other) : m_ptr(other.m_ptr) { InternalAddRef(); }
+        ComPtr(ComPtr&& other) noexcept : m_ptr(other.m_ptr) { other.m_ptr = nullptr; }
+        template <typename U>
+        ComPtr(const ComPtr<U>& other) : m_ptr(other.Get()) { InternalAddRef(); }
+        ~ComPtr() { InternalRelease(); }
+
+        ComPtr& operator=(std::nullptr_t)
+        {
+            InternalRelease();
+            return *this;
+        }
+        ComPtr& operator=(T* p)
+        {
+            if (m_ptr != p)
+                ComPtr(p).Swap(*this);
+            return *this;
+        }
+        ComPtr& operator=(const ComPtr& other)
+        {
+            if (m_ptr != other.m_ptr)
+                ComPtr(other).Swap(*this);
+            return *this;
+        }
+        ComPtr& operator=(ComPtr&& other) noexcept
+        {
+            ComPtr(std::move(other)).Swap(*this);
+            return *this;
+        }
+
+        void Swap(ComPtr& other) { std::swap(m_ptr, other.m_ptr); }
+
+        T* Get() const { return m_ptr; }
+        T* operator->() const { return m_ptr; }
+        explicit operator bool() const { return m_ptr != nullptr; }
+
+        // Like WRL, taking the address releases what is held
+        T** operator&() { return ReleaseAndGetAddressOf(); }
+        T* const* GetAddressOf() const { return &m_ptr; }
+        T** GetAddressOf() { return &m_ptr; }
+        T** ReleaseAndGetAddressOf()
+        {
+            InternalRelease();
+            return &m_ptr;
+        }
+
+        void Reset() { InternalRelease(); }
+        void Attach(T* p)
+        {
+            InternalRelease();
+            m_ptr = p;
+        }
+        T* Detach()
+        {
+            T* p = m_ptr;
+            m_ptr = nullptr;
+            return p;
+        }
+
+        HRESULT CopyTo(T** out) const
+        {
+            InternalAddRef();
+            *out = m_ptr;
+            return S_OK;
+        }
+
+        template <typename U>
+        HRESULT As(ComPtr<U>* out) const
+        {
+            if (m_ptr == nullptr)
+                return E_POINTER;
+            return m_ptr->QueryInterface(__uuidof(U), reinterpret_cast<void**>(out->ReleaseAndGetAddressOf()));
+        }
+        // WRL's operator& converts to either, so As(&ptr) works too
+        template <typename U>
+        HRESULT As(U** out) const
+        {
+            if (m_ptr == nullptr)
+                return E_POINTER;
+            return m_ptr->QueryInterface(__uuidof(U), reinterpret_cast<void**>(out));
+        }
+
+    private:
+        void InternalAddRef() const
+        {
+            if (m_ptr != nullptr)
+                m_ptr->AddRef();
+        }
+        void InternalRelease()
+        {
+            T* p = m_ptr;
+            if (p != nullptr)
+            {
+                m_ptr = nullptr;
+                p->Release();
+            }
+        }
+
+        T* m_ptr = nullptr;
+    };
+
+    template <typename T, typename U>
+    bool operator==(const ComPtr<T>& a, const ComPtr<U>& b) { return a.Get() == b.Get(); }
+    template <typename T>
+    bool operator==(const ComPtr<T>& a, std::nullptr_t) { return a.Get() == nullptr; }
+    template <typename T>
+    bool operator==(std::nullptr_t, const ComPtr<T>& a) { return a.Get() == nullptr; }
+    template <typename T, typename U>
+    bool operator!=(const ComPtr<T>& a, const ComPtr<U>& b) { return a.Get() != b.Get(); }
+    template <typename T>
+    bool operator!=(const ComPtr<T>& a, std::nullptr_t) { return a.Get() != nullptr; }
+    template <typename T>
+    bool operator!=(std::nullptr_t, const ComPtr<T>& a) { return a.Get() != nullptr; }
+
+    namespace Details
+    {
+        template <typename TInterface, typename TCallback, typename TInvoke = decltype(&TInterface::Invoke)>
+        class CallbackImpl;
+
+        template <typename TInterface, typename TCallback, typename... TArgs>
+        class CallbackImpl<TInterface, TCallback, HRESULT (STDMETHODCALLTYPE TInterface::*)(TArgs...)> : public TInterface
+        {
+        public:
+            explicit CallbackImpl(TCallback callback) : m_callback(std::move(callback)) {}
+
+            HRESULT STDMETHODCALLTYPE Invoke(TArgs... args) override { return m_callback(args...); }
+
+            HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+            {
+                if (riid == __uuidof(TInterface) || riid == __uuidof(IUnknown))
+                {
+                    AddRef();
+                    *object = static_cast<TInterface*>(this);
+                    return S_OK;
+                }
+                *object = nullptr;
+                return E_NOINTERFACE;
+            }
+            ULONG STDMETHODCALLTYPE AddRef() override { return ++m_refCount; }
+            ULONG STDMETHODCALLTYPE Release() override
+            {
+                ULONG count = --m_refCount;
+                if (count == 0)
+                    delete this;
+                return count;
+            }
+
+        private:
+            TCallback m_callback;
+            std::atomic<ULONG> m_refCount = 0;
+        };
+    }
+
+    template <typename TInterface, typename TCallback>
+    ComPtr<TInterface> Callback(TCallback&& callback)
+    {
+        using Impl = Details::CallbackImpl<TInterface, std::decay_t<TCallback>>;
+        return ComPtr<TInterface>(new Impl(std::forward<TCallback>(callback)));
+    }
+
+    template <typename T, typename... TArgs>
+    ComPtr<T> Make(TArgs&&... args)
+    {
+        return ComPtr<T>(new T(std::forward<TArgs>(args)...));
+    }
+}
+}
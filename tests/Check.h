@@ -0,0 +1,37 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstdio>
+
+// Just enough of a test harness for the portable host code: CHECK reports
+// the failed condition and keeps going, the test's main returns
+// CheckResult() so ctest sees the failures.
+
+inline int& CheckFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++CheckFailures(); \
+        } \
+    } while (false)
+
+inline int CheckResult()
+{
+    if (CheckFailures() != 0)
+    {
+        fprintf(stderr, "%d checks failed\n", CheckFailures());
+        return 1;
+    }
+    return 0;
+}
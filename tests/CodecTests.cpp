@@ -0,0 +1,324 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// CodecTests.cpp : Round trips through JsonWriter and the schema decoders:
+// escapes, surrogate pairs, numbers and malformed input, plus the generated
+// encoders and dispatch table.
+
+#include <climits>
+#include <string>
+#include "Check.h"
+#include "MessageSchema.h"
+
+namespace
+{
+    // Decodes a whole message the way the host does, from a mutable copy
+    template <typename T>
+    bool Decode(std::wstring& json, int expectedMessage, T& args)
+    {
+        int message = 0;
+        JsonValue value;
+        return JsonReader::ReadMessage(&json[0], message, value) && message == expectedMessage && DecodeArgs(value, args);
+    }
+
+    std::wstring EncodeUri(std::wstring_view uri)
+    {
+        JsonWriter writer;
+        writer.BeginMessage(MG_NAVIGATE);
+        writer.WriteString(L"uri", uri);
+        writer.EndMessage();
+        return writer.GetString();
+    }
+
+    bool RoundTrips(std::wstring_view uri)
+    {
+        std::wstring json = EncodeUri(uri);
+        NavigateArgs args;
+        return Decode(json, MG_NAVIGATE, args) && args.uri == uri;
+    }
+
+    void TestEscapes()
+    {
+        CHECK(RoundTrips(L""));
+        CHECK(RoundTrips(L"plain"));
+        CHECK(RoundTrips(L"quote \" backslash \\ slash /"));
+        CHECK(RoundTrips(L"line\nfeed\rreturn\ttab"));
+        CHECK(RoundTrips(std::wstring(L"control \x01\x1f end")));
+        CHECK(RoundTrips(L"\\\\\"\"\\"));
+
+        // Control characters never reach the output unescaped
+        std::wstring json = EncodeUri(std::wstring(L"a\x01" L"b"));
+        CHECK(json.find(L"\\u0001") != std::wstring::npos);
+
+        // Every escape JSON allows, written by a page instead of JsonWriter
+        std::wstring page = L"{\"message\":1,\"args\":{\"uri\":\"\\b\\f\\/\\u0041\\u00e9\\\"\"}}";
+        NavigateArgs args;
+        CHECK(Decode(page, MG_NAVIGATE, args));
+        CHECK(args.uri == L"\b\f/A\u00e9\"");
+
+        // Unescaping happens in place and leaves the view null-terminated
+        CHECK(args.uri.data()[args.uri.size()] == L'\0');
+
+        const wchar_t* malformed[] = {
+            L"{\"message\":1,\"args\":{\"uri\":\"\\x\"}}",
+            L"{\"message\":1,\"args\":{\"uri\":\"\\u12G4\"}}",
+            L"{\"message\":1,\"args\":{\"uri\":\"\\u12\"}}",
+            L"{\"message\":1,\"args\":{\"uri\":\"unterminated}}",
+        };
+        for (const wchar_t* text : malformed)
+        {
+            std::wstring copy = text;
+            NavigateArgs rejected;
+            CHECK(!Decode(copy, MG_NAVIGATE, rejected));
+        }
+    }
+
+    void TestSurrogates()
+    {
+        // Pages escape characters outside the BMP as a pair of UTF-16 code
+        // units, which are kept as they are
+        std::wstring page = L"{\"message\":1,\"args\":{\"uri\":\"\\ud83d\\ude00!\"}}";
+        NavigateArgs args;
+        CHECK(Decode(page, MG_NAVIGATE, args));
+        CHECK(args.uri.size() == 3);
+        CHECK(args.uri.size() == 3 && args.uri[0] == 0xD83D && args.uri[1] == 0xDE00 && args.uri[2] == L'!');
+
+        // and written back verbatim, so the page gets the same pair
+        std::wstring pair(args.uri);
+        CHECK(RoundTrips(pair));
+
+        // A lone surrogate is passed on rather than rejected
+        CHECK(RoundTrips(std::wstring(1, static_cast<wchar_t>(0xDC00))));
+
+        // Unescaped characters beyond ASCII go through untouched
+        CHECK(RoundTrips(L"caf\u00e9 \u4e2d\u6587"));
+    }
+
+    bool DecodeTabId(const std::wstring& value, size_t& tabId)
+    {
+        std::wstring json = L"{\"message\":12,\"args\":{\"tabId\":" + value + L"}}";
+        TabArgs args;
+        bool decoded = Decode(json, MG_SWITCH_TAB, args);
+        tabId = args.tabId;
+        return decoded;
+    }
+
+    void TestNumbers()
+    {
+        for (long long value : { 0ll, 1ll, -1ll, 42ll, 1ll << 40, LLONG_MAX, LLONG_MIN })
+        {
+            JsonWriter writer;
+            writer.BeginMessage(MG_SET_TAB_POLICY);
+            writer.WriteNumber(L"suspendAfter", value);
+            writer.EndMessage();
+            std::wstring json = writer.GetString();
+            CHECK(json.find(std::to_wstring(value)) != std::wstring::npos);
+
+            // Doubles are exact up to 2^53, past that the text still is
+            if (value > -(1ll << 53) && value < (1ll << 53))
+            {
+                TabPolicyArgs args;
+                CHECK(Decode(json, MG_SET_TAB_POLICY, args) && args.suspendAfter == value);
+            }
+        }
+
+        size_t tabId = 0;
+        CHECK(DecodeTabId(L"7", tabId) && tabId == 7);
+        CHECK(DecodeTabId(L"1e3", tabId) && tabId == 1000);
+        CHECK(DecodeTabId(L"4294967296", tabId) && tabId == 4294967296ull);
+        CHECK(DecodeTabId(L" 9 ", tabId) && tabId == 9);
+        CHECK(!DecodeTabId(L"-1", tabId));
+        CHECK(!DecodeTabId(L"1.5", tabId));
+        CHECK(!DecodeTabId(L"1-2", tabId));
+        CHECK(!DecodeTabId(L"\"3\"", tabId));
+        CHECK(!DecodeTabId(L"true", tabId));
+    }
+
+    // Numbers an integer field can't hold exactly make the message malformed
+    void TestIntegerRange()
+    {
+        const wchar_t* rejected[] = { L"1e300", L"-1e300", L"1.5", L"9007199254740993" };
+        for (const wchar_t* number : rejected)
+        {
+            std::wstring value = number;
+            size_t tabId = 0;
+            CHECK(!DecodeTabId(value, tabId));
+
+            std::wstring settings = L"{\"message\":21,\"args\":{\"tabId\":" + value + L"}}";
+            SettingsArgs optionalSize;
+            CHECK(!Decode(settings, MG_GET_SETTINGS, optionalSize));
+
+            std::wstring remove = L"{\"message\":27,\"args\":{\"id\":" + value + L"}}";
+            RemoveHistoryItemArgs integer;
+            CHECK(!Decode(remove, MG_REMOVE_HISTORY_ITEM, integer));
+
+            std::wstring history = L"{\"message\":26,\"args\":{\"count\":" + value + L"}}";
+            HistoryArgs optionalInteger;
+            CHECK(!Decode(history, MG_GET_HISTORY, optionalInteger));
+
+            // The message id goes through JsonValue::GetInt
+            std::wstring id = L"{\"message\":" + value + L",\"args\":{}}";
+            int message = 0;
+            JsonValue args;
+            CHECK(!JsonReader::ReadMessage(&id[0], message, args));
+        }
+
+        // Negative numbers only fit the int fields
+        size_t tabId = 0;
+        CHECK(!DecodeTabId(L"-1", tabId));
+        std::wstring settings = L"{\"message\":21,\"args\":{\"tabId\":-1}}";
+        SettingsArgs optionalSize;
+        CHECK(!Decode(settings, MG_GET_SETTINGS, optionalSize));
+        std::wstring remove = L"{\"message\":27,\"args\":{\"id\":-1}}";
+        RemoveHistoryItemArgs integer;
+        CHECK(Decode(remove, MG_REMOVE_HISTORY_ITEM, integer) && integer.id == -1);
+        std::wstring history = L"{\"message\":26,\"args\":{\"count\":-1}}";
+        HistoryArgs optionalInteger;
+        CHECK(Decode(history, MG_GET_HISTORY, optionalInteger) && optionalInteger.count == -1);
+
+        // The largest integers a double holds exactly still go through
+        std::wstring largest = L"{\"message\":27,\"args\":{\"id\":-9007199254740991}}";
+        CHECK(Decode(largest, MG_REMOVE_HISTORY_ITEM, integer) && integer.id == -9007199254740991ll);
+        CHECK(DecodeTabId(L"9007199254740991", tabId) && tabId == 9007199254740991ull);
+    }
+
+    void TestFields()
+    {
+        // Required fields must be there, null counts as absent
+        std::wstring missing = L"{\"message\":10,\"args\":{\"tabId\":3}}";
+        CreateTabArgs createTab;
+        CHECK(!Decode(missing, MG_CREATE_TAB, createTab));
+        std::wstring null = L"{\"message\":10,\"args\":{\"tabId\":3,\"active\":null}}";
+        CHECK(!Decode(null, MG_CREATE_TAB, createTab));
+
+        // Unknown keys are skipped, whatever they hold, in any order
+        std::wstring extra = L"{\"args\":{\"x\":[{\"y\":\"}\"}],\"active\":true,\"tabId\":3},\"message\":10}";
+        CHECK(Decode(extra, MG_CREATE_TAB, createTab));
+        CHECK(createTab.tabId == 3 && createTab.active);
+
+        // Json fields keep the raw text
+        std::wstring metadata = L"{\"message\":33,\"args\":{\"title\":\"a\\\"b\",\"favicon\":null}}";
+        PageMetadataArgs page;
+        CHECK(Decode(metadata, MG_PAGE_METADATA, page));
+        CHECK(page.title.GetRaw() == L"\"a\\\"b\"");
+        CHECK(page.favicon.GetType() == JsonType::Invalid);
+
+        const wchar_t* malformed[] = {
+            L"{\"message\":10}",
+            L"{\"message\":10,\"args\":[]}",
+            L"{\"message\":\"10\",\"args\":{}}",
+            L"{\"message\":10,\"args\":{\"tabId\":3,,\"active\":true}}",
+            L"{\"message\":10,\"args\":{\"tabId\" 3,\"active\":true}}",
+            L"{\"message\":10,\"args\":{\"tabId\":3,\"active\":tru}}",
+            L"{\"message\":10,\"args\":{\"tabId\":3,\"active\":true}",
+            L"",
+        };
+        for (const wchar_t* text : malformed)
+        {
+            std::wstring copy = text;
+            CHECK(!Decode(copy, MG_CREATE_TAB, createTab));
+        }
+
+        // Nesting is skipped without recursion
+        std::wstring deep = L"{\"message\":10,\"args\":{\"tabId\":3,\"active\":true,\"deep\":" +
+            std::wstring(100000, L'[') + std::wstring(100000, L']') + L"}}";
+        CHECK(Decode(deep, MG_CREATE_TAB, createTab));
+    }
+
+    void TestRelay()
+    {
+        // Replies are forwarded to the requesting tab without the tag, every
+        // other member verbatim
+        std::wstring reply = L"{\"message\":26,\"args\":{\"tabId\":4,\"items\":[{\"title\":\"\\u00e9\"}],\"from\":20}}";
+        int message = 0;
+        JsonValue args;
+        CHECK(JsonReader::ReadMessage(&reply[0], message, args));
+        TabReplyMessage relay;
+        CHECK(relay.Decode(message, args) && relay.tabId == 4);
+        JsonWriter writer;
+        relay.Encode(writer);
+        CHECK(std::wstring(writer.GetString()) == L"{\"message\":26,\"args\":{\"items\":[{\"title\":\"\\u00e9\"}],\"from\":20}}");
+    }
+
+    void TestEncoders()
+    {
+        // Optional fields are only written once set, false and 0 included
+        UpdateUriMessage uri;
+        uri.tabId = 5;
+        uri.uri = L"https://example.com/";
+        JsonWriter writer;
+        uri.Encode(writer);
+        CHECK(std::wstring(writer.GetString()) == L"{\"message\":2,\"args\":{\"tabId\":5,\"uri\":\"https://example.com/\"}}");
+
+        uri.uriToShow = L"browser://history";
+        uri.canGoForward = false;
+        uri.canGoBack = true;
+        uri.Encode(writer);
+        std::wstring json = writer.GetString();
+        UpdateUriArgs decoded;
+        CHECK(Decode(json, MG_UPDATE_URI, decoded));
+        CHECK(decoded.tabId == 5 && decoded.uri == L"https://example.com/" && decoded.uriToShow == L"browser://history");
+        CHECK(decoded.canGoForward == false && decoded.canGoBack == true);
+
+        // Raw fields are written and read back as JSON text
+        UpdateTabMessage title;
+        title.tabId = 2;
+        title.title = L"\"a\\\"b\"";
+        title.Encode(writer);
+        json = writer.GetString();
+        UpdateTabArgs decodedTitle;
+        CHECK(Decode(json, MG_UPDATE_TAB, decodedTitle) && decodedTitle.title == title.title);
+
+        // The keys are the schema's
+        CHECK(FieldName<&SessionArgs::tabs>::value == L"tabs");
+        CHECK(FieldName<&TabArgs::tabId>::value == L"tabId");
+    }
+
+    struct TestHandler
+    {
+        size_t switchedTo = INVALID_TAB_ID;
+        std::wstring relayed;
+
+        void OnMessage(const SwitchTabMessage& message) { switchedTo = message.tabId; }
+        void OnMessage(const RelayedMessage<MG_GET_SETTINGS>& message) { relayed = message.args.GetRaw(); }
+    };
+
+    DispatchResult Dispatch(TestHandler& handler, std::wstring json)
+    {
+        int message = 0;
+        JsonValue args;
+        if (!JsonReader::ReadMessage(&json[0], message, args))
+            return DispatchResult::Malformed;
+        return MessageDispatcher<TestHandler>::Dispatch(handler, message, args);
+    }
+
+    void TestDispatch()
+    {
+        TestHandler handler;
+        CHECK(Dispatch(handler, L"{\"message\":12,\"args\":{\"tabId\":3}}") == DispatchResult::Handled);
+        CHECK(handler.switchedTo == 3);
+        CHECK(Dispatch(handler, L"{\"message\":12,\"args\":{}}") == DispatchResult::Malformed);
+        CHECK(Dispatch(handler, L"{\"message\":13,\"args\":{\"tabId\":3}}") == DispatchResult::Unhandled);
+        CHECK(Dispatch(handler, L"{\"message\":9,\"args\":{}}") == DispatchResult::Unhandled);
+        CHECK(Dispatch(handler, L"{\"message\":1000,\"args\":{}}") == DispatchResult::Unhandled);
+
+        // Relayed args are checked against the schema but left escaped
+        CHECK(Dispatch(handler, L"{\"message\":21,\"args\":{\"frame\":\"a\\\"b\"}}") == DispatchResult::Handled);
+        CHECK(handler.relayed == L"{\"frame\":\"a\\\"b\"}");
+        CHECK(Dispatch(handler, L"{\"message\":21,\"args\":{\"tabId\":\"x\"}}") == DispatchResult::Malformed);
+    }
+}
+
+int main()
+{
+    TestEscapes();
+    TestSurrogates();
+    TestNumbers();
+    TestIntegerRange();
+    TestFields();
+    TestRelay();
+    TestEncoders();
+    TestDispatch();
+    return CheckResult();
+}
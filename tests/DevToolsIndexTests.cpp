@@ -0,0 +1,163 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// DevToolsIndexTests.cpp : Windows are indexed for known processes only,
+// seeded once and then kept up to date from events, and a lookup skips the
+// windows other tabs own.
+
+#include <map>
+#include "Check.h"
+#include "DevToolsIndex.h"
+
+namespace
+{
+    // Windows are ints, in the order EnumWindows would report them
+    class FakeWindows : public WindowEnumerator
+    {
+    public:
+        struct Window
+        {
+            uint32_t processId = 0;
+            bool isCandidate = true;
+        };
+
+        WindowHandle Add(uint32_t processId, bool isCandidate = true)
+        {
+            WindowHandle window = reinterpret_cast<WindowHandle>(++m_lastWindow);
+            m_windows[window] = { processId, isCandidate };
+            return window;
+        }
+        void Remove(WindowHandle window) { m_windows.erase(window); }
+        // The handle reused by a window of another process
+        void Recycle(WindowHandle window, uint32_t processId) { m_windows[window] = { processId, true }; }
+
+        void ForEachTopLevelWindow(const std::function<bool(WindowHandle window)>& fn) override
+        {
+            ++enumerations;
+            for (const auto& [window, info] : m_windows)
+            {
+                if (!fn(window))
+                    return;
+            }
+        }
+        uint32_t GetProcessId(WindowHandle window) override
+        {
+            auto it = m_windows.find(window);
+            return it != m_windows.end() ? it->second.processId : 0;
+        }
+        bool IsDevToolsCandidate(WindowHandle window) override
+        {
+            auto it = m_windows.find(window);
+            return it != m_windows.end() && it->second.isCandidate;
+        }
+
+        size_t enumerations = 0;
+
+    private:
+        std::map<WindowHandle, Window> m_windows;
+        uintptr_t m_lastWindow = 0x1000;
+    };
+
+    bool NoneClaimed(WindowHandle)
+    {
+        return false;
+    }
+
+    void TestSeed()
+    {
+        FakeWindows windows;
+        WindowHandle other = windows.Add(5);
+        WindowHandle popup = windows.Add(10, false);
+        WindowHandle devTools = windows.Add(10);
+
+        DevToolsIndex index;
+        CHECK(index.Find(10, NoneClaimed) == nullptr);
+        CHECK(index.AddProcess(10, windows));
+        CHECK(index.Find(10, NoneClaimed) == devTools);
+        CHECK(index.GetWindowCount() == 1);
+        CHECK(index.Find(5, NoneClaimed) == nullptr);
+        (void)other;
+        (void)popup;
+
+        // Known processes aren't enumerated again
+        CHECK(!index.AddProcess(10, windows));
+        CHECK(!index.AddProcess(0, windows));
+        CHECK(windows.enumerations == 1);
+    }
+
+    void TestEvents()
+    {
+        FakeWindows windows;
+        DevToolsIndex index;
+        index.AddProcess(10, windows);
+
+        WindowHandle first = windows.Add(10);
+        WindowHandle stranger = windows.Add(5);
+        WindowHandle popup = windows.Add(10, false);
+        index.OnWindowCreated(first, windows);
+        index.OnWindowCreated(stranger, windows);
+        index.OnWindowCreated(popup, windows);
+        CHECK(index.GetWindowCount() == 1);
+        CHECK(index.Find(10, NoneClaimed) == first);
+
+        WindowHandle second = windows.Add(10);
+        index.OnWindowCreated(second, windows);
+        // Created twice, indexed once
+        index.OnWindowCreated(second, windows);
+        CHECK(index.GetWindowCount() == 2);
+
+        // Destroyed, whether or not it still exists by the time the event runs
+        windows.Remove(first);
+        index.OnWindowDestroyed(first);
+        index.OnWindowDestroyed(stranger);
+        CHECK(index.Find(10, NoneClaimed) == second);
+        CHECK(index.GetWindowCount() == 1);
+        CHECK(windows.enumerations == 1);
+    }
+
+    void TestClaimed()
+    {
+        FakeWindows windows;
+        WindowHandle first = windows.Add(10);
+        WindowHandle second = windows.Add(10);
+        WindowHandle otherProcess = windows.Add(20);
+        DevToolsIndex index;
+        index.AddProcess(10, windows);
+        index.AddProcess(20, windows);
+
+        auto firstClaimed = [first](WindowHandle window) { return window == first; };
+        CHECK(index.Find(10, firstClaimed) == second);
+        auto processClaimed = [first, second](WindowHandle window) { return window == first || window == second; };
+        CHECK(index.Find(10, processClaimed) == nullptr);
+        // Without a process id, any known process
+        CHECK(index.Find(0, processClaimed) == otherProcess);
+        CHECK(index.Find(30, NoneClaimed) == nullptr);
+    }
+
+    void TestRecycledHandle()
+    {
+        FakeWindows windows;
+        DevToolsIndex index;
+        index.AddProcess(10, windows);
+        index.AddProcess(20, windows);
+
+        WindowHandle window = windows.Add(10);
+        index.OnWindowCreated(window, windows);
+        // The destroy event is still queued when the handle is reused
+        windows.Recycle(window, 20);
+        index.OnWindowCreated(window, windows);
+        CHECK(index.Find(10, NoneClaimed) == nullptr);
+        CHECK(index.Find(20, NoneClaimed) == window);
+        CHECK(index.GetWindowCount() == 1);
+    }
+}
+
+int main()
+{
+    TestSeed();
+    TestEvents();
+    TestClaimed();
+    TestRecycledHandle();
+    return CheckResult();
+}
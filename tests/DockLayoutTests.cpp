@@ -0,0 +1,149 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// DockLayoutTests.cpp : The bars sit on top at the window's scale, the tab
+// and its docked DevTools split what's left without gaps or overlap, and the
+// DevTools window is stretched past its frame.
+
+#include "Check.h"
+#include "DockLayout.h"
+
+namespace
+{
+    // What BrowserWindow caches, at dpi
+    LayoutMetrics GetMetrics(unsigned int dpi)
+    {
+        auto scale = [dpi](int bound) { return static_cast<int>(bound * dpi / 96); };
+        LayoutMetrics metrics;
+        metrics.dpi = dpi;
+        metrics.barHeight = scale(70);
+        metrics.optionsTop = scale(40);
+        metrics.optionsWidth = scale(300);
+        metrics.optionsHeight = scale(208);
+        metrics.titleBarHeight = 31;
+        return metrics;
+    }
+
+    DockLayoutInput GetInput(int width, int height, DockState state, int dockSize = 0)
+    {
+        DockLayoutInput input;
+        input.clientWidth = width;
+        input.clientHeight = height;
+        input.state = state;
+        input.dockSize = dockSize;
+        input.frameWidth = 16;
+        input.frameHeight = 8;
+        return input;
+    }
+
+    // The content and the holder cover the area under the bar exactly
+    bool Tiles(const DockLayout& layout, int width, int height)
+    {
+        long area = static_cast<long>(layout.content.Width()) * layout.content.Height() +
+            static_cast<long>(layout.holder.Width()) * layout.holder.Height();
+        bool touches = layout.content.right == layout.holder.left || layout.holder.right == layout.content.left ||
+            layout.content.bottom == layout.holder.top;
+        return touches && area == static_cast<long>(width) * (height - layout.controls.bottom);
+    }
+
+    void TestBars()
+    {
+        DockLayout layout = DockLayoutSolver::Solve(GetMetrics(96), GetInput(1000, 700, DockState::DS_UNKNOWN));
+        CHECK(layout.controls == (LayoutRect{ 0, 0, 1000, 70 }));
+        CHECK(layout.options == (LayoutRect{ 700, 40, 1000, 248 }));
+        CHECK(layout.content == (LayoutRect{ 0, 70, 1000, 700 }));
+        CHECK(layout.holder == LayoutRect());
+        CHECK(layout.dockSize == 0);
+
+        layout = DockLayoutSolver::Solve(GetMetrics(144), GetInput(1000, 700, DockState::DS_UNKNOWN));
+        CHECK(layout.controls == (LayoutRect{ 0, 0, 1000, 105 }));
+        CHECK(layout.options == (LayoutRect{ 550, 60, 1000, 372 }));
+        CHECK(layout.content.top == 105);
+
+        // Undocked DevTools aren't laid out
+        layout = DockLayoutSolver::Solve(GetMetrics(96), GetInput(1000, 700, DockState::DS_UNDOCK, 200));
+        CHECK(layout.content == (LayoutRect{ 0, 70, 1000, 700 }));
+        CHECK(layout.holder == LayoutRect());
+        CHECK(layout.devTools == LayoutRect());
+
+        // Smaller than the bar, nothing is inverted
+        layout = DockLayoutSolver::Solve(GetMetrics(96), GetInput(50, 30, DockState::DS_UNKNOWN));
+        CHECK(layout.controls == (LayoutRect{ 0, 0, 50, 30 }));
+        CHECK(layout.content.Height() == 0);
+    }
+
+    void TestDefaultDock()
+    {
+        LayoutMetrics metrics = GetMetrics(96);
+        DockLayout right = DockLayoutSolver::Solve(metrics, GetInput(1000, 700, DockState::DS_DOCK_RIGHT));
+        CHECK(right.dockSize == 300);
+        CHECK(right.content == (LayoutRect{ 0, 70, 696, 700 }));
+        CHECK(right.holder == (LayoutRect{ 696, 70, 1000, 700 }));
+        CHECK(Tiles(right, 1000, 700));
+
+        DockLayout left = DockLayoutSolver::Solve(metrics, GetInput(1000, 700, DockState::DS_DOCK_LEFT));
+        CHECK(left.dockSize == 300);
+        CHECK(left.holder == (LayoutRect{ 0, 70, 304, 700 }));
+        CHECK(left.content == (LayoutRect{ 304, 70, 1000, 700 }));
+        CHECK(Tiles(left, 1000, 700));
+
+        // 30% of the height under the bar
+        DockLayout bottom = DockLayoutSolver::Solve(metrics, GetInput(1000, 700, DockState::DS_DOCK_BOTTOM));
+        CHECK(bottom.dockSize == 189);
+        CHECK(bottom.content == (LayoutRect{ 0, 70, 1000, 507 }));
+        CHECK(bottom.holder == (LayoutRect{ 0, 507, 1000, 700 }));
+        CHECK(Tiles(bottom, 1000, 700));
+    }
+
+    void TestDockSize()
+    {
+        LayoutMetrics metrics = GetMetrics(96);
+        DockLayout layout = DockLayoutSolver::Solve(metrics, GetInput(1000, 700, DockState::DS_DOCK_RIGHT, 420));
+        CHECK(layout.dockSize == 420);
+        CHECK(layout.content.right == 576);
+        CHECK(Tiles(layout, 1000, 700));
+
+        // Kept as the window grows
+        layout = DockLayoutSolver::Solve(metrics, GetInput(1600, 900, DockState::DS_DOCK_RIGHT, 420));
+        CHECK(layout.holder == (LayoutRect{ 1176, 70, 1600, 900 }));
+
+        // Never wider than the window, the border stays in it
+        layout = DockLayoutSolver::Solve(metrics, GetInput(400, 700, DockState::DS_DOCK_LEFT, 420));
+        CHECK(layout.dockSize == 396);
+        CHECK(layout.content == (LayoutRect{ 400, 70, 400, 700 }));
+        CHECK(Tiles(layout, 400, 700));
+
+        layout = DockLayoutSolver::Solve(metrics, GetInput(1000, 300, DockState::DS_DOCK_BOTTOM, 500));
+        CHECK(layout.dockSize == 226);
+        CHECK(layout.content.Height() == 0);
+        CHECK(layout.holder == (LayoutRect{ 0, 70, 1000, 300 }));
+
+        CHECK(DockLayoutSolver::ClampDockSize(metrics, GetInput(0, 0, DockState::DS_DOCK_RIGHT), 100) == 0);
+    }
+
+    void TestDevToolsWindow()
+    {
+        LayoutMetrics metrics = GetMetrics(96);
+        // The frame and the title bar are moved out of the holder, half the
+        // border is left to the splitter
+        DockLayout right = DockLayoutSolver::Solve(metrics, GetInput(1000, 700, DockState::DS_DOCK_RIGHT, 300));
+        CHECK(right.devTools.left == -8);
+        CHECK(right.devTools.top == -31);
+        CHECK(right.devTools.Width() == 300 + 16 + 2);
+        CHECK(right.devTools.Height() == 630 + 8 + 31 + 2);
+
+        DockLayout bottom = DockLayoutSolver::Solve(metrics, GetInput(1000, 700, DockState::DS_DOCK_BOTTOM, 200));
+        CHECK(bottom.devTools.Width() == 1000 + 16);
+        CHECK(bottom.devTools.Height() == 200 + 8 + 31 + 2);
+    }
+}
+
+int main()
+{
+    TestBars();
+    TestDefaultDock();
+    TestDockSize();
+    TestDevToolsWindow();
+    return CheckResult();
+}
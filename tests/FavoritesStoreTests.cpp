@@ -0,0 +1,128 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// FavoritesStoreTests.cpp : URIs that only differ in case, default port or
+// an empty path are the same favorite, favorites keep their order, and the
+// log reads back as it was written, up to a record cut short.
+
+#include "Check.h"
+#include "FavoritesStore.h"
+
+namespace
+{
+    std::wstring Canonicalize(std::wstring_view uri)
+    {
+        std::wstring canonical;
+        FavoritesStore::Canonicalize(uri, canonical);
+        return canonical;
+    }
+
+    std::vector<std::wstring> GetUris(const FavoritesStore& store)
+    {
+        std::vector<std::wstring> uris;
+        for (const Favorite& favorite : store.GetFavorites())
+            uris.push_back(favorite.uri);
+        return uris;
+    }
+
+    void TestCanonicalize()
+    {
+        CHECK(Canonicalize(L"HTTPS://Example.COM") == L"https://example.com/");
+        CHECK(Canonicalize(L"https://example.com:443/Path?Q=1#Top") == L"https://example.com/Path?Q=1#Top");
+        CHECK(Canonicalize(L"http://example.com:80?q") == L"http://example.com/?q");
+        CHECK(Canonicalize(L"http://example.com:8080/") == L"http://example.com:8080/");
+        CHECK(Canonicalize(L"https://example.com:80/") == L"https://example.com:80/");
+        CHECK(Canonicalize(L"http://User@Host:/") == L"http://User@host/");
+        CHECK(Canonicalize(L"http://[::1]:80/") == L"http://[::1]/");
+        CHECK(Canonicalize(L"http://[::1]/") == L"http://[::1]/");
+        CHECK(Canonicalize(L"file:///C:/Pages/Index.html") == L"file:///C:/Pages/Index.html");
+        CHECK(Canonicalize(L"About:Blank") == L"about:Blank");
+        CHECK(Canonicalize(L"no scheme") == L"no scheme");
+    }
+
+    void TestMembership()
+    {
+        FavoritesStore store;
+        CHECK(store.Add(L"https://example.com", L"\"Example\"", L""));
+        CHECK(store.Add(L"https://docs.example.com/guide", L"\"Guide\"", L"\"https://docs.example.com/favicon.ico\""));
+        CHECK(store.Contains(L"HTTPS://EXAMPLE.COM:443/"));
+        CHECK(!store.Contains(L"https://example.com/other"));
+        CHECK(!store.Contains(L"https://docs.example.com/GUIDE"));
+
+        // The same favorite, updated in place
+        CHECK(!store.Add(L"https://example.com", L"\"Example\"", L""));
+        CHECK(store.Add(L"https://example.com/", L"\"Renamed\"", L""));
+        CHECK(store.GetFavorites().size() == 2 && store.GetFavorites()[0].titleJson == L"\"Renamed\"");
+
+        CHECK(store.Add(L"https://third.example.com/", L"", L""));
+        CHECK(store.Remove(L"https://EXAMPLE.com"));
+        CHECK(!store.Remove(L"https://example.com/"));
+        CHECK(GetUris(store) == (std::vector<std::wstring>{ L"https://docs.example.com/guide", L"https://third.example.com/" }));
+        // Indices of the ones that moved up still hold
+        CHECK(store.Remove(L"https://third.example.com/"));
+        CHECK(store.Contains(L"https://docs.example.com/guide") && !store.Contains(L"https://third.example.com/"));
+    }
+
+    void TestLog()
+    {
+        FavoritesStore store;
+        std::vector<uint8_t> log;
+        store.WriteSnapshot(log);
+        store.Add(L"https://a.example/", L"\"A\"", L"\"https://a.example/icon.png\"");
+        store.Add(L"https://b.example/", L"\"B\"", L"");
+        store.Add(L"https://c.example/", L"\"C\"", L"");
+        store.Remove(L"https://b.example/");
+        CHECK(store.HasRecords());
+        std::vector<uint8_t> records;
+        store.TakeRecords(records);
+        CHECK(!store.HasRecords());
+        log.insert(log.end(), records.begin(), records.end());
+        CHECK(store.GetLogSize() == log.size());
+
+        FavoritesStore loaded;
+        CHECK(loaded.Load(log));
+        CHECK(GetUris(loaded) == (std::vector<std::wstring>{ L"https://a.example/", L"https://c.example/" }));
+        CHECK(loaded.GetFavorites()[0].titleJson == L"\"A\"" && loaded.GetFavorites()[0].faviconJson == L"\"https://a.example/icon.png\"");
+        CHECK(loaded.GetLogSize() == log.size() && !loaded.HasRecords());
+
+        // A record cut short by a crash is dropped with what follows
+        std::vector<uint8_t> cut(log.begin(), log.end() - 1);
+        CHECK(loaded.Load(cut));
+        CHECK(GetUris(loaded) == (std::vector<std::wstring>{ L"https://a.example/", L"https://b.example/", L"https://c.example/" }));
+        CHECK(loaded.GetLogSize() < cut.size());
+
+        // The snapshot of the state reads back the same
+        std::vector<uint8_t> snapshot;
+        loaded.WriteSnapshot(snapshot);
+        FavoritesStore compacted;
+        CHECK(compacted.Load(snapshot) && GetUris(compacted) == GetUris(loaded));
+
+        std::vector<uint8_t> other = { 'W', 'S', 1 };
+        CHECK(!loaded.Load(other) && loaded.GetFavorites().empty() && !loaded.Contains(L"https://a.example/"));
+    }
+
+    void TestCompaction()
+    {
+        FavoritesStore store;
+        std::vector<uint8_t> log;
+        store.WriteSnapshot(log);
+        for (int i = 0; !store.ShouldCompact(); ++i)
+        {
+            CHECK(i < 10000);
+            store.Add(L"https://toggled.example/", L"\"Toggled\"", L"");
+            store.Remove(L"https://toggled.example/");
+        }
+        store.WriteSnapshot(log);
+        CHECK(!store.ShouldCompact() && !store.HasRecords() && store.GetLogSize() == log.size());
+    }
+}
+
+int main()
+{
+    TestCanonicalize();
+    TestMembership();
+    TestLog();
+    TestCompaction();
+    return CheckResult();
+}
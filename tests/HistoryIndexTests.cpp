@@ -0,0 +1,122 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// HistoryIndexTests.cpp : Queries are folded and split into words, the
+// candidates have every trigram of them whatever order the ids came in, and
+// the lists read back as they were written.
+
+#include <algorithm>
+#include "Check.h"
+#include "HistoryIndex.h"
+
+namespace
+{
+    std::vector<uint64_t> Find(const HistoryIndex& index, std::wstring_view query, bool* isNarrowed = nullptr, size_t maxCount = SIZE_MAX)
+    {
+        std::vector<std::wstring> words;
+        HistoryIndex::SplitQuery(query, words);
+        std::vector<uint64_t> ids;
+        bool narrowed = index.FindCandidates(words, maxCount, ids);
+        if (isNarrowed != nullptr)
+            *isNarrowed = narrowed;
+        return ids;
+    }
+
+    void TestQueries()
+    {
+        std::wstring folded;
+        HistoryIndex::Fold(L"WebView ÀÉ×Þ ß", folded);
+        CHECK(folded == L"webview àé×þ ß");
+
+        std::vector<std::wstring> words;
+        HistoryIndex::SplitQuery(L"  Edge\tBROWSER  ", words);
+        CHECK(words == (std::vector<std::wstring>{ L"edge", L"browser" }));
+        HistoryIndex::SplitQuery(L" \t ", words);
+        CHECK(words.empty());
+    }
+
+    void TestCandidates()
+    {
+        HistoryIndex index;
+        index.Add(1, L"https://www.bing.com/");
+        index.Add(1, L"Bing");
+        index.Add(2, L"https://example.com/sing/Bin/ngo");
+        index.Add(3, L"https://example.com/news");
+        index.Add(3, L"Breaking News");
+
+        CHECK(Find(index, L"EXAMPLE") == (std::vector<uint64_t>{ 2, 3 }));
+        CHECK(Find(index, L"com news") == (std::vector<uint64_t>{ 3 }));
+        CHECK(Find(index, L"example www").empty());
+        // Trigrams of the word, not the word: "bin", "ing" and "ngo" are all
+        // in 2, which HistoryStore weeds out
+        CHECK(Find(index, L"bing") == (std::vector<uint64_t>{ 1, 2 }));
+        CHECK(Find(index, L"bingo") == (std::vector<uint64_t>{ 2 }));
+
+        bool isNarrowed = true;
+        CHECK(Find(index, L"zzz", &isNarrowed).empty() && isNarrowed);
+        CHECK(Find(index, L"go b", &isNarrowed).empty() && !isNarrowed);
+
+        index.Clear();
+        CHECK(index.GetTrigramCount() == 0 && Find(index, L"bing").empty());
+    }
+
+    void TestOrder()
+    {
+        // Past a few blocks, then earlier ids, enough to rewrite the list
+        HistoryIndex index;
+        for (uint64_t id = 1000; id < 1500; ++id)
+            index.Add(id, id % 2 == 0 ? L"even page" : L"odd page");
+        for (uint64_t id = 1; id <= 100; ++id)
+            index.Add(id, L"old page");
+        index.Add(1200, L"old page");
+
+        std::vector<uint64_t> ids = Find(index, L"page");
+        CHECK(ids.size() == 600 && ids.front() == 1 && ids.back() == 1499);
+        CHECK(std::is_sorted(ids.begin(), ids.end()));
+        ids = Find(index, L"old page");
+        CHECK(ids.size() == 101 && ids.back() == 1200);
+        ids = Find(index, L"even");
+        CHECK(ids.size() == 250 && ids[100] == 1200);
+
+        // Pending ids are found too
+        index.Add(500, L"old page");
+        CHECK(Find(index, L"old").size() == 102);
+    }
+
+    void TestReadWrite()
+    {
+        HistoryIndex index;
+        for (uint64_t id = 1; id <= 1000; ++id)
+            index.Add(id, L"https://site" + std::to_wstring(id % 10) + L".example/");
+        index.Add(7, L"Seventh");
+
+        std::vector<uint8_t> bytes = { 0xFF };
+        index.Write(bytes);
+        HistoryIndex loaded;
+        CHECK(loaded.Read(bytes, 1, bytes.size()));
+        CHECK(loaded.GetTrigramCount() == index.GetTrigramCount());
+        CHECK(Find(loaded, L"site3") == Find(index, L"site3") && Find(loaded, L"site3").size() == 100);
+        CHECK(Find(loaded, L"seventh") == (std::vector<uint64_t>{ 7 }));
+
+        // Appended to after reading back
+        loaded.Add(1001, L"https://site3.example/");
+        CHECK(Find(loaded, L"site3").back() == 1001);
+
+        CHECK(!loaded.Read(bytes, 1, bytes.size() - 1));
+        CHECK(loaded.GetTrigramCount() == 0);
+        // More lists than there are
+        CHECK(bytes[1] < 0x7F);
+        ++bytes[1];
+        CHECK(!loaded.Read(bytes, 1, bytes.size()));
+    }
+}
+
+int main()
+{
+    TestQueries();
+    TestCandidates();
+    TestOrder();
+    TestReadWrite();
+    return CheckResult();
+}
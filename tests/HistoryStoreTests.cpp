@@ -0,0 +1,459 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// HistoryStoreTests.cpp : Visits are merged per URI and day, pages follow
+// their cursor past revisits and removals, searches find the words of the
+// current titles and URIs only, and the log replays to the same history up
+// to the first damaged record, with the index saved for it or rebuilt.
+// Changes made between writes are merged into a record per entry.
+
+#include <algorithm>
+#include "ByteCodec.h"
+#include "Check.h"
+#include "HistoryStore.h"
+
+namespace
+{
+    const int64_t c_day = 20000;
+    const int64_t c_time = c_day * 86400000;
+
+    std::vector<uint64_t> GetIds(const HistoryStore& history, const std::optional<HistoryCursor>& after, size_t count, bool* hasMore = nullptr)
+    {
+        std::vector<const HistoryEntry*> page;
+        bool more = history.GetPage(after, count, page);
+        if (hasMore != nullptr)
+            *hasMore = more;
+        std::vector<uint64_t> ids;
+        for (const HistoryEntry* entry : page)
+            ids.push_back(entry->id);
+        return ids;
+    }
+
+    HistoryCursor GetCursor(const HistoryStore& history, uint64_t id)
+    {
+        HistoryCursor cursor;
+        CHECK(HistoryStore::ParseCursor(HistoryStore::FormatCursor(*history.Find(id)), cursor));
+        return cursor;
+    }
+
+    void TestDays()
+    {
+        CHECK(HistoryStore::GetDay(1970, 1, 1) == 0);
+        CHECK(HistoryStore::GetDay(1969, 12, 31) == -1);
+        CHECK(HistoryStore::GetDay(2000, 3, 1) == 11017);
+        CHECK(HistoryStore::GetDay(2024, 2, 29) + 1 == HistoryStore::GetDay(2024, 3, 1));
+    }
+
+    void TestVisits()
+    {
+        HistoryStore history;
+        uint64_t a = history.AddVisit(L"https://a.example/", c_time, c_day);
+        uint64_t b = history.AddVisit(L"https://b.example/", c_time + 10, c_day);
+        CHECK(a != 0 && b != a);
+
+        // Again the same day, the entry moves up
+        CHECK(history.AddVisit(L"https://a.example/", c_time + 20, c_day) == a);
+        CHECK(history.GetCount() == 2);
+        CHECK(history.Find(a)->timestamp == c_time + 20);
+        CHECK(GetIds(history, std::nullopt, 10) == (std::vector<uint64_t>{ a, b }));
+
+        // An earlier clock doesn't move it back
+        CHECK(history.AddVisit(L"https://a.example/", c_time + 5, c_day) == a);
+        CHECK(history.Find(a)->timestamp == c_time + 20);
+
+        // Another day is another entry
+        uint64_t c = history.AddVisit(L"https://a.example/", c_time + 86400000, c_day + 1);
+        CHECK(c != a && history.GetCount() == 3);
+
+        history.SetTitle(c, L"\"A\"");
+        history.SetFavicon(c, L"\"https://a.example/favicon.ico\"");
+        CHECK(history.Find(c)->titleJson == L"\"A\"");
+
+        history.Remove(a);
+        CHECK(history.Find(a) == nullptr && history.GetCount() == 2);
+        CHECK(GetIds(history, std::nullopt, 10) == (std::vector<uint64_t>{ c, b }));
+        // Removed ids aren't handed out again
+        uint64_t d = history.AddVisit(L"https://a.example/", c_time + 30, c_day);
+        CHECK(d > c);
+
+        history.Clear();
+        CHECK(history.GetCount() == 0 && GetIds(history, std::nullopt, 10).empty());
+        CHECK(history.AddVisit(L"https://b.example/", c_time, c_day) > d);
+    }
+
+    void TestPages()
+    {
+        HistoryStore history;
+        std::vector<uint64_t> ids;
+        for (int i = 0; i < 50; ++i)
+            ids.push_back(history.AddVisit(L"https://example.com/" + std::to_wstring(i), c_time + i / 2, c_day));
+
+        // Equal times are ordered by id
+        bool hasMore = false;
+        std::vector<uint64_t> page = GetIds(history, std::nullopt, 20, &hasMore);
+        CHECK(page.size() == 20 && hasMore && page[0] == ids[49] && page[1] == ids[48]);
+
+        // Revisits and removals between pages neither repeat nor skip entries
+        history.AddVisit(L"https://example.com/10", c_time + 100, c_day);
+        history.Remove(ids[25]);
+        page = GetIds(history, GetCursor(history, page.back()), 20, &hasMore);
+        CHECK(page.size() == 20 && hasMore && page[0] == ids[29] && page[3] == ids[26] && page[4] == ids[24]);
+        page = GetIds(history, GetCursor(history, page.back()), 20, &hasMore);
+        CHECK(page.size() == 8 && !hasMore && page.back() == ids[0]);
+
+        // A page that ends with the last entry says so
+        page = GetIds(history, GetCursor(history, ids[20]), 20, &hasMore);
+        CHECK(page.size() == 19 && !hasMore);
+
+        HistoryCursor cursor;
+        CHECK(!HistoryStore::ParseCursor(L"12", cursor));
+        CHECK(!HistoryStore::ParseCursor(L"12:", cursor));
+        CHECK(!HistoryStore::ParseCursor(L"-1:2", cursor));
+        CHECK(!HistoryStore::ParseCursor(L"99999999999999999999:2", cursor));
+    }
+
+    // Everything a page shows
+    bool IsSame(const HistoryStore& a, const HistoryStore& b)
+    {
+        std::vector<const HistoryEntry*> pageA, pageB;
+        a.GetPage(std::nullopt, a.GetCount() + 1, pageA);
+        b.GetPage(std::nullopt, b.GetCount() + 1, pageB);
+        if (pageA.size() != pageB.size())
+            return false;
+        for (size_t i = 0; i < pageA.size(); ++i)
+        {
+            if (pageA[i]->id != pageB[i]->id || pageA[i]->timestamp != pageB[i]->timestamp || pageA[i]->day != pageB[i]->day ||
+                pageA[i]->uri != pageB[i]->uri || pageA[i]->titleJson != pageB[i]->titleJson || pageA[i]->faviconJson != pageB[i]->faviconJson)
+                return false;
+        }
+        return true;
+    }
+
+    void TestLog()
+    {
+        HistoryStore history;
+        std::vector<uint8_t> log;
+        history.WriteSnapshot(log);
+        uint64_t a = history.AddVisit(L"https://a.example/é", c_time, c_day);
+        uint64_t b = history.AddVisit(L"https://b.example/", c_time + 1, c_day);
+        history.SetTitle(a, L"\"À \\\"quoted\\\"\"");
+        history.AddVisit(L"https://a.example/é", c_time + 2, c_day);
+        history.Remove(b);
+        std::vector<uint8_t> records;
+        history.TakeRecords(records);
+        log.insert(log.end(), records.begin(), records.end());
+        size_t cStart = log.size();
+        uint64_t c = history.AddVisit(L"https://c.example/", c_time + 3, c_day);
+        history.SetFavicon(c, L"\"https://c.example/icon.png\"");
+        history.TakeRecords(records);
+        log.insert(log.end(), records.begin(), records.end());
+
+        HistoryStore loaded;
+        CHECK(loaded.Load(log));
+        CHECK(IsSame(history, loaded));
+        CHECK(loaded.AddVisit(L"https://a.example/é", c_time + 4, c_day) == a);
+        CHECK(loaded.AddVisit(L"https://d.example/", c_time + 5, c_day) == c + 1);
+
+        // The snapshot keeps the ids, the removed one included
+        std::vector<uint8_t> snapshot;
+        history.WriteSnapshot(snapshot);
+        CHECK(!history.HasRecords());
+        HistoryStore compacted;
+        CHECK(compacted.Load(snapshot));
+        CHECK(IsSame(history, compacted));
+        CHECK(compacted.AddVisit(L"https://d.example/", c_time + 5, c_day) == c + 1);
+
+        // A torn last record and whatever follows a damaged one are dropped
+        history.SetTitle(c, L"\"C\"");
+        history.TakeRecords(records);
+        std::vector<uint8_t> torn = log;
+        torn.insert(torn.end(), records.begin(), records.end() - 1);
+        CHECK(loaded.Load(torn));
+        CHECK(loaded.Find(c)->titleJson.empty());
+
+        std::vector<uint8_t> damaged = log;
+        damaged[cStart + 4] ^= 0xFF;
+        CHECK(loaded.Load(damaged));
+        CHECK(loaded.Find(c) == nullptr && loaded.Find(a) != nullptr);
+
+        // Titles are written out verbatim, so only JSON strings are read back
+        HistoryStore raw;
+        raw.WriteSnapshot(log);
+        raw.SetTitle(raw.AddVisit(L"https://a.example/", c_time, c_day), L"1}, {\"id\": 2");
+        raw.TakeRecords(records);
+        log.insert(log.end(), records.begin(), records.end());
+        CHECK(loaded.Load(log));
+        CHECK(loaded.GetCount() == 1 && loaded.Find(1)->titleJson.empty());
+
+        std::vector<uint8_t> other = { 'W', 'S', 1 };
+        CHECK(!loaded.Load(other));
+        CHECK(loaded.GetCount() == 0);
+    }
+
+    std::vector<uint64_t> Search(HistoryStore& history, std::wstring_view query, const std::optional<HistoryCursor>& after = std::nullopt,
+        size_t count = 100, bool* hasMore = nullptr)
+    {
+        std::vector<const HistoryEntry*> page;
+        bool more = history.Search(query, after, count, page);
+        if (hasMore != nullptr)
+            *hasMore = more;
+        std::vector<uint64_t> ids;
+        for (const HistoryEntry* entry : page)
+            ids.push_back(entry->id);
+        return ids;
+    }
+
+    void TestSearch()
+    {
+        HistoryStore history;
+        uint64_t bing = history.AddVisit(L"https://www.bing.com/", c_time, c_day);
+        history.SetTitle(bing, L"\"Bing\"");
+        uint64_t bingo = history.AddVisit(L"https://example.com/sing/bin/ngo", c_time + 1, c_day);
+        uint64_t news = history.AddVisit(L"https://example.com/news", c_time + 2, c_day);
+        history.SetTitle(news, L"\"Breaking \\u004Eews from \\\"Example\\\"\"");
+
+        // Most recent first, in the title or the URI, ignoring case
+        CHECK(Search(history, L"EXAMPLE") == (std::vector<uint64_t>{ news, bingo }));
+        CHECK(Search(history, L"breaking news") == (std::vector<uint64_t>{ news }));
+        CHECK(Search(history, L"\"example\"") == (std::vector<uint64_t>{ news }));
+        // Only whole words match, and not across the title and URI
+        CHECK(Search(history, L"bing") == (std::vector<uint64_t>{ bing }));
+        CHECK(Search(history, L"bingo").empty());
+        CHECK(Search(history, L"news.com").empty());
+        // Words too short for the index are looked for anyway
+        CHECK(Search(history, L"ng") == (std::vector<uint64_t>{ news, bingo, bing }));
+        CHECK(Search(history, L"  ") == (std::vector<uint64_t>{ news, bingo, bing }));
+
+        // Replaced titles and removed entries aren't found
+        history.SetTitle(news, L"\"Weather\"");
+        CHECK(Search(history, L"breaking").empty());
+        CHECK(Search(history, L"weather") == (std::vector<uint64_t>{ news }));
+        history.Remove(bingo);
+        CHECK(Search(history, L"example") == (std::vector<uint64_t>{ news }));
+        // A revisit moves the entry up
+        history.AddVisit(L"https://www.bing.com/", c_time + 3, c_day);
+        CHECK(Search(history, L"com") == (std::vector<uint64_t>{ bing, news }));
+
+        history.Clear();
+        CHECK(Search(history, L"bing").empty());
+    }
+
+    void TestSearchPages()
+    {
+        // Few matches are sorted by time, many are found walking the time
+        // index, both page by the same cursors
+        HistoryStore history;
+        std::vector<uint64_t> rare;
+        std::vector<uint64_t> common;
+        for (int i = 0; i < 1000; ++i)
+        {
+            bool isRare = i % 100 == 7;
+            uint64_t id = history.AddVisit(L"https://example.com/" + std::wstring(isRare ? L"rare/" : L"page/") + std::to_wstring(i),
+                c_time + (i * 7919) % 1000, c_day);
+            (isRare ? rare : common).push_back(id);
+        }
+        auto byTime = [&history](uint64_t a, uint64_t b)
+        {
+            return history.Find(a)->timestamp > history.Find(b)->timestamp;
+        };
+        std::sort(rare.begin(), rare.end(), byTime);
+        std::sort(common.begin(), common.end(), byTime);
+
+        for (const auto& [query, expected] : { std::make_pair(L"rare", &rare), std::make_pair(L"page", &common) })
+        {
+            std::vector<uint64_t> found;
+            std::optional<HistoryCursor> after;
+            bool hasMore = true;
+            while (hasMore)
+            {
+                std::vector<uint64_t> page = Search(history, query, after, 4, &hasMore);
+                CHECK(page.size() == 4 || !hasMore);
+                found.insert(found.end(), page.begin(), page.end());
+                if (!page.empty())
+                    after = GetCursor(history, page.back());
+            }
+            CHECK(found == *expected);
+        }
+    }
+
+    void TestIndexFile()
+    {
+        HistoryStore history;
+        std::vector<uint8_t> log;
+        history.WriteSnapshot(log);
+        uint64_t a = history.AddVisit(L"https://a.example/", c_time, c_day);
+        history.SetTitle(a, L"\"Alpha\"");
+        uint64_t b = history.AddVisit(L"https://b.example/", c_time + 1, c_day);
+        std::vector<uint8_t> records;
+        history.TakeRecords(records);
+        log.insert(log.end(), records.begin(), records.end());
+        CHECK(history.HasIndexChanges());
+        std::vector<uint8_t> index;
+        history.WriteIndex(index);
+        CHECK(!history.HasIndexChanges());
+
+        // Read back for the log it was written for
+        HistoryStore loaded;
+        CHECK(loaded.Load(log, index));
+        CHECK(!loaded.HasIndexChanges());
+        CHECK(Search(loaded, L"alpha") == (std::vector<uint64_t>{ a }));
+
+        // The records written after it are indexed as they're replayed
+        history.SetTitle(a, L"\"Gamma\"");
+        history.Remove(b);
+        uint64_t c = history.AddVisit(L"https://c.example/", c_time + 2, c_day);
+        history.SetTitle(c, L"\"Beta\"");
+        history.TakeRecords(records);
+        log.insert(log.end(), records.begin(), records.end());
+        CHECK(loaded.Load(log, index));
+        CHECK(loaded.HasIndexChanges());
+        CHECK(Search(loaded, L"alpha").empty() && Search(loaded, L"gamma") == (std::vector<uint64_t>{ a }));
+        CHECK(Search(loaded, L"example") == (std::vector<uint64_t>{ c, a }));
+        CHECK(Search(loaded, L"beta") == (std::vector<uint64_t>{ c }));
+
+        // An index of another log, or a damaged one, is rebuilt
+        std::vector<uint8_t> other;
+        HistoryStore empty;
+        empty.WriteSnapshot(other);
+        empty.WriteIndex(other);
+        std::vector<uint8_t> damaged = index;
+        damaged[damaged.size() / 2] ^= 0xFF;
+        for (const std::vector<uint8_t>* ignored : { &other, &damaged })
+        {
+            CHECK(loaded.Load(log, *ignored));
+            CHECK(loaded.HasIndexChanges());
+            CHECK(Search(loaded, L"example") == (std::vector<uint64_t>{ c, a }));
+        }
+
+        // A history cleared after the index was written
+        history.Clear();
+        history.AddVisit(L"https://d.example/", c_time + 3, c_day);
+        history.TakeRecords(records);
+        log.insert(log.end(), records.begin(), records.end());
+        CHECK(loaded.Load(log, index));
+        CHECK(Search(loaded, L"example").size() == 1 && Search(loaded, L"d.example").size() == 1);
+    }
+
+    size_t CountRecords(const std::vector<uint8_t>& records)
+    {
+        size_t count = 0;
+        size_t position = 0;
+        const uint8_t* payload = nullptr;
+        size_t length = 0;
+        while (ReadChecksummedRecord(records, position, payload, length))
+            ++count;
+        CHECK(position == records.size());
+        return count;
+    }
+
+    void TestMerge()
+    {
+        HistoryStore history;
+        std::vector<uint8_t> log;
+        history.WriteSnapshot(log);
+        std::vector<uint8_t> records;
+
+        // A visit, its title and favicon and a visit again, one record
+        uint64_t a = history.AddVisit(L"https://a.example/", c_time, c_day);
+        history.SetTitle(a, L"\"Loading\"");
+        history.SetTitle(a, L"\"A\"");
+        history.SetFavicon(a, L"\"https://a.example/icon.png\"");
+        history.AddVisit(L"https://a.example/", c_time + 1, c_day);
+        uint64_t b = history.AddVisit(L"https://b.example/", c_time + 2, c_day);
+        history.TakeRecords(records);
+        CHECK(CountRecords(records) == 2 && !history.HasRecords());
+        log.insert(log.end(), records.begin(), records.end());
+        HistoryStore loaded;
+        CHECK(loaded.Load(log) && IsSame(history, loaded));
+
+        // An entry written before, one record per field
+        HistoryStore before;
+        before.Load(log);
+        history.SetTitle(a, L"\"A1\"");
+        history.AddVisit(L"https://a.example/", c_time + 3, c_day);
+        history.SetTitle(a, L"\"A2\"");
+        history.AddVisit(L"https://a.example/", c_time + 4, c_day);
+        history.SetFavicon(b, L"\"https://b.example/icon.png\"");
+        uint64_t c = history.AddVisit(L"https://c.example/", c_time + 5, c_day);
+        history.SetTitle(c, L"\"C\"");
+        history.TakeRecords(records);
+        CHECK(CountRecords(records) == 4);
+
+        // Cut anywhere, each entry is as it was or as it is
+        for (size_t cut = 0; cut <= records.size(); ++cut)
+        {
+            std::vector<uint8_t> torn = log;
+            torn.insert(torn.end(), records.begin(), records.begin() + cut);
+            CHECK(loaded.Load(torn));
+            for (uint64_t id : { a, b, c })
+            {
+                const HistoryEntry* entry = loaded.Find(id);
+                const HistoryEntry* was = before.Find(id);
+                const HistoryEntry* is = history.Find(id);
+                CHECK(entry == nullptr ? was == nullptr : entry->uri == is->uri);
+                if (entry != nullptr)
+                {
+                    CHECK(entry->titleJson == is->titleJson || entry->titleJson == was->titleJson);
+                    CHECK(entry->timestamp == is->timestamp || entry->timestamp == was->timestamp);
+                }
+            }
+        }
+        log.insert(log.end(), records.begin(), records.end());
+        CHECK(loaded.Load(log) && IsSame(history, loaded));
+
+        // Removed before it was written, nothing is; after, only the removal
+        uint64_t d = history.AddVisit(L"https://d.example/", c_time + 6, c_day);
+        history.SetTitle(d, L"\"D\"");
+        history.Remove(d);
+        CHECK(!history.HasRecords());
+        history.SetTitle(c, L"\"C1\"");
+        history.Remove(c);
+        history.TakeRecords(records);
+        CHECK(CountRecords(records) == 1);
+        log.insert(log.end(), records.begin(), records.end());
+        CHECK(loaded.Load(log) && IsSame(history, loaded));
+
+        // A clear drops what came before it, the entries after it follow
+        history.SetTitle(a, L"\"A3\"");
+        history.Clear();
+        uint64_t e = history.AddVisit(L"https://e.example/", c_time + 7, c_day);
+        history.SetTitle(e, L"\"E\"");
+        history.TakeRecords(records);
+        CHECK(CountRecords(records) == 2);
+        log.insert(log.end(), records.begin(), records.end());
+        CHECK(loaded.Load(log) && IsSame(history, loaded) && loaded.GetCount() == 1);
+        CHECK(loaded.AddVisit(L"https://f.example/", c_time + 8, c_day) == e + 1);
+    }
+
+    void TestCompaction()
+    {
+        HistoryStore history;
+        std::vector<uint8_t> log;
+        history.WriteSnapshot(log);
+        uint64_t id = history.AddVisit(L"https://example.com/", c_time, c_day);
+        std::vector<uint8_t> records;
+        for (int i = 0; !history.ShouldCompact(); ++i)
+        {
+            history.SetTitle(id, L"\"" + std::to_wstring(i) + L"\"");
+            history.TakeRecords(records);
+            CHECK(i < 200000);
+        }
+        history.WriteSnapshot(log);
+        CHECK(!history.ShouldCompact() && log.size() < 100);
+    }
+}
+
+int main()
+{
+    TestDays();
+    TestVisits();
+    TestPages();
+    TestLog();
+    TestSearch();
+    TestSearchPages();
+    TestIndexFile();
+    TestMerge();
+    TestCompaction();
+    return CheckResult();
+}
@@ -0,0 +1,208 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// SuggestionIndexTests.cpp : Queries match the start of hosts, their
+// domains, path segments or whole URIs, suggestions come best first by
+// frecency whatever order the visits came in, removed history stops being
+// suggested, and open tabs and favorites are suggested and lifted.
+
+#include <algorithm>
+#include <set>
+#include "Check.h"
+#include "SuggestionIndex.h"
+
+namespace
+{
+    const int64_t c_day = 86400000;
+    const int64_t c_now = 20000 * c_day;
+
+    std::vector<std::wstring> Find(SuggestionIndex& index, std::wstring_view query, size_t count = 8, const std::vector<KnownPage>& tabs = {})
+    {
+        std::vector<Suggestion> suggestions;
+        index.Find(query, tabs, {}, c_now, count, suggestions);
+        std::vector<std::wstring> uris;
+        for (const Suggestion& suggestion : suggestions)
+            uris.emplace_back(suggestion.uri);
+        return uris;
+    }
+
+    void TestMatches()
+    {
+        const wchar_t* uri = L"https://www.News.Example.com/World/2024/Story-One?id=Query#Part";
+        SuggestionIndex index;
+        index.AddVisit(uri, c_now, 1, true);
+        for (const wchar_t* query : { L"n", L"NEWS", L"exa", L"example.com", L"world", L"story-", L"  WWW.news ",
+            L"https://www.news.ex", L"http://news", L"news.example.com/world/2", L"news.example.com/world/2024/story-one?id" })
+        {
+            CHECK(Find(index, query) == (std::vector<std::wstring>{ uri }));
+        }
+        // The top level domain, ids, the query, starts of nothing and other
+        // hosts' paths
+        for (const wchar_t* query : { L"com", L"2024", L"query", L"part", L"orld", L"example.com/world", L"news.example.com/2024", L"", L"https://" })
+        {
+            CHECK(Find(index, query).empty());
+        }
+
+        // Long tokens are indexed by their start, the rest is checked
+        const wchar_t* longUri = L"https://example.org/a-rather-long-segment-name";
+        index.AddVisit(longUri, c_now, 2, true);
+        CHECK(Find(index, L"a-rather-long-segment") == (std::vector<std::wstring>{ longUri }));
+        CHECK(Find(index, L"a-rather-long-segment-other").empty());
+        // Addresses are whole
+        index.AddVisit(L"http://192.168.1.1/", c_now, 3, true);
+        CHECK(Find(index, L"192.168") == (std::vector<std::wstring>{ L"http://192.168.1.1/" }));
+        CHECK(Find(index, L"168.1").empty());
+    }
+
+    void TestRanking()
+    {
+        SuggestionIndex index;
+        // Three visits a half life ago weigh one and a half of today's
+        for (uint64_t id = 1; id <= 3; ++id)
+            index.AddVisit(L"https://often.example.org/", c_now - SuggestionIndex::c_halfLife, id, true);
+        index.AddVisit(L"https://lately.example.org/", c_now, 4, true);
+        index.AddVisit(L"https://once.example.org/", c_now - 2 * SuggestionIndex::c_halfLife, 5, true);
+        CHECK(Find(index, L"example") == (std::vector<std::wstring>{ L"https://often.example.org/", L"https://lately.example.org/", L"https://once.example.org/" }));
+        CHECK(Find(index, L"example", 2).size() == 2);
+
+        // Visited again the same day, the history entry is updated
+        index.AddVisit(L"https://lately.example.org/", c_now, 4, false);
+        CHECK(Find(index, L"exam") == (std::vector<std::wstring>{ L"https://lately.example.org/", L"https://often.example.org/", L"https://once.example.org/" }));
+        CHECK(index.GetCount() == 3);
+        CHECK(index.GetScore(L"https://lately.example.org/") == 2 * SuggestionIndex::GetWeight(c_now));
+    }
+
+    void TestRemove()
+    {
+        SuggestionIndex index;
+        index.AddVisit(L"https://a.example.org/", c_now - c_day, 1, true);
+        index.AddVisit(L"https://a.example.org/", c_now, 2, true);
+        index.AddVisit(L"https://b.example.org/", c_now - c_day / 2, 3, true);
+        CHECK(Find(index, L"example").front() == L"https://a.example.org/");
+
+        // One of its days goes, then the other
+        index.RemoveEntry(L"https://a.example.org/", c_now, 2);
+        CHECK(Find(index, L"example") == (std::vector<std::wstring>{ L"https://b.example.org/", L"https://a.example.org/" }));
+        std::vector<Suggestion> suggestions;
+        index.Find(L"a.ex", {}, {}, c_now, 8, suggestions);
+        CHECK(suggestions.size() == 1 && suggestions[0].historyId == 0);
+        index.RemoveEntry(L"https://a.example.org/", c_now - c_day, 1);
+        CHECK(Find(index, L"example") == (std::vector<std::wstring>{ L"https://b.example.org/" }));
+        CHECK(index.GetCount() == 1 && index.GetScore(L"https://a.example.org/") == 0);
+        index.RemoveEntry(L"https://unknown.example.org/", c_now, 7);
+
+        // Visited again, from scratch
+        index.AddVisit(L"https://a.example.org/", c_now - 2 * c_day, 4, true);
+        CHECK(Find(index, L"example") == (std::vector<std::wstring>{ L"https://b.example.org/", L"https://a.example.org/" }));
+
+        index.Clear();
+        CHECK(index.GetCount() == 0 && Find(index, L"example").empty());
+    }
+
+    // Many URIs sharing hosts and segments, visited in no particular order
+    // and some removed, against ranking them all
+    void TestOrder()
+    {
+        SuggestionIndex index;
+        std::vector<std::pair<std::wstring, int64_t>> visits;
+        for (uint64_t i = 0; i < 3000; ++i)
+        {
+            std::wstring uri = L"https://site" + std::to_wstring(i % 37) + L".example.com/topic" + std::to_wstring(i % 11) + L"/" + std::to_wstring(i % 500);
+            int64_t timestamp = c_now - static_cast<int64_t>((i * 7919) % 1000) * c_day / 10;
+            index.AddVisit(uri, timestamp, i + 1, true);
+            visits.emplace_back(uri, timestamp);
+        }
+        for (uint64_t i = 0; i < 3000; i += 7)
+            index.RemoveEntry(visits[i].first, visits[i].second, i + 1);
+
+        for (const wchar_t* query : { L"site1", L"topic3", L"example", L"site22.example.com/topic", L"s", L"t" })
+        {
+            std::vector<std::pair<double, std::wstring>> expected;
+            std::set<std::wstring> seen;
+            for (const auto& [uri, timestamp] : visits)
+            {
+                if (!seen.insert(uri).second)
+                    continue;
+                std::wstring_view trimmed = std::wstring_view(uri).substr(8);
+                std::wstring_view host = trimmed.substr(0, trimmed.find(L'/'));
+                std::wstring_view segment = trimmed.substr(host.size() + 1);
+                segment = segment.substr(0, segment.find(L'/'));
+                std::wstring_view text = query;
+                bool isMatch = text.find(L'/') != std::wstring_view::npos ? trimmed.substr(0, text.size()) == text :
+                    host.substr(0, text.size()) == text || segment.substr(0, text.size()) == text || text == L"example";
+                if (isMatch && index.GetScore(uri) > 0)
+                    expected.emplace_back(index.GetScore(uri), uri);
+            }
+            std::sort(expected.begin(), expected.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+            std::vector<std::wstring> found = Find(index, query, 10);
+            CHECK(found.size() == std::min<size_t>(10, expected.size()));
+            for (size_t i = 0; i < found.size() && i < expected.size(); ++i)
+                CHECK(index.GetScore(found[i]) == expected[i].first);
+        }
+    }
+
+    void TestOpenTabs()
+    {
+        SuggestionIndex index;
+        index.AddVisit(L"https://docs.example/", c_now - 20 * c_day, 1, true);
+        index.AddVisit(L"https://docs.example/", c_now - c_day, 2, true);
+        index.AddVisit(L"https://dev.example/", c_now - 10 * c_day, 3, true);
+        std::vector<KnownPage> tabs = {
+            { L"https://dev.example/", L"\"Dev\"" },
+            { L"https://drafts.example/", L"\"Drafts\"" },
+            { L"https://other.example/", L"\"Other\"" }
+        };
+
+        std::vector<Suggestion> suggestions;
+        index.Find(L"d", tabs, {}, c_now, 8, suggestions);
+        CHECK(suggestions.size() == 3);
+        CHECK(suggestions[0].uri == L"https://dev.example/" && suggestions[0].tab == &tabs[0] && suggestions[0].historyId == 3);
+        CHECK(suggestions[1].uri == L"https://docs.example/" && suggestions[1].tab == nullptr);
+        CHECK(suggestions[2].uri == L"https://drafts.example/" && suggestions[2].tab == &tabs[1] && suggestions[2].historyId == 0);
+
+        // The tab takes the place of a URI that was found
+        index.Find(L"d", tabs, {}, c_now, 1, suggestions);
+        CHECK(suggestions.size() == 1 && suggestions[0].tab == &tabs[0]);
+        index.Find(L"docs", tabs, {}, c_now, 8, suggestions);
+        CHECK(suggestions.size() == 1 && suggestions[0].tab == nullptr);
+    }
+
+    void TestFavorites()
+    {
+        SuggestionIndex index;
+        index.AddVisit(L"https://news.example/", c_now - c_day, 1, true);
+        index.AddVisit(L"https://notes.example/", c_now - 30 * c_day, 2, true);
+        std::vector<KnownPage> tabs = { { L"https://notes.example/", L"\"Notes tab\"" } };
+        std::vector<KnownPage> favorites = {
+            { L"https://notes.example/", L"\"Notes\"" },
+            { L"https://nowhere.example/", L"\"Nowhere\"" },
+            { L"https://other.example/", L"\"Other\"" }
+        };
+
+        // A favorite lifts its URI above a later visit, and one never visited
+        // is suggested too
+        std::vector<Suggestion> suggestions;
+        index.Find(L"n", {}, favorites, c_now, 8, suggestions);
+        CHECK(suggestions.size() == 3);
+        CHECK(suggestions[0].uri == L"https://notes.example/" && suggestions[0].favorite == &favorites[0] && suggestions[0].historyId == 2);
+        CHECK(suggestions[1].uri == L"https://nowhere.example/" && suggestions[1].favorite == &favorites[1] && suggestions[1].tab == nullptr);
+        CHECK(suggestions[2].uri == L"https://news.example/" && suggestions[2].favorite == nullptr);
+
+        // Open and a favorite, it counts twice
+        index.Find(L"n", tabs, favorites, c_now, 8, suggestions);
+        CHECK(suggestions[0].tab == &tabs[0] && suggestions[0].favorite == &favorites[0]);
+        CHECK(suggestions[0].score == index.GetScore(L"https://notes.example/") + 2 * SuggestionIndex::GetWeight(c_now));
+    }
+}
+
+int main()
+{
+    TestMatches();
+    TestRanking();
+    TestRemove();
+    TestOrder();
+    TestOpenTabs();
+    TestFavorites();
+    return CheckResult();
+}
@@ -0,0 +1,114 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// TabHibernationTests.cpp : Tabs are found by id whatever order they were
+// added and removed in, the memory estimate follows their lifecycles and the
+// budget discards the least recently used tabs first, from the measured
+// memory once there is one.
+
+#include <vector>
+#include "Check.h"
+#include "TabHibernation.h"
+
+namespace
+{
+    std::vector<size_t> GetDiscarded(const std::vector<TabTransition>& transitions)
+    {
+        std::vector<size_t> tabIds;
+        for (const TabTransition& transition : transitions)
+        {
+            if (transition.lifecycle == TabLifecycle::Discarded)
+                tabIds.push_back(transition.tabId);
+        }
+        return tabIds;
+    }
+
+    void TestLookup()
+    {
+        TabHibernation hibernation;
+        for (size_t tabId = 1; tabId <= 1000; ++tabId)
+            hibernation.AddTab(tabId, 0);
+        for (size_t tabId = 2; tabId <= 1000; tabId += 2)
+            hibernation.RemoveTab(tabId);
+        hibernation.SetLifecycle(999, TabLifecycle::Suspended);
+        hibernation.SetLifecycle(2, TabLifecycle::Suspended);
+
+        CHECK(hibernation.GetLifecycle(999) == TabLifecycle::Suspended);
+        CHECK(hibernation.GetLifecycle(2) == TabLifecycle::Live);
+
+        // 499 live and one suspended at the default costs
+        CHECK(hibernation.GetEstimatedMemory() == 499 * 100 + 40);
+        hibernation.RemoveTab(999);
+        hibernation.RemoveTab(999);
+        CHECK(hibernation.GetEstimatedMemory() == 499 * 100);
+
+        // Added again, a tab starts over as live
+        hibernation.SetLifecycle(1, TabLifecycle::Discarded);
+        hibernation.AddTab(1, 0);
+        CHECK(hibernation.GetLifecycle(1) == TabLifecycle::Live);
+        CHECK(hibernation.GetEstimatedMemory() == 499 * 100);
+    }
+
+    void TestBudget()
+    {
+        TabHibernation hibernation;
+        TabHibernationPolicy policy;
+        policy.memoryBudget = 250;
+        hibernation.SetPolicy(policy);
+        hibernation.AddTab(5, 30);
+        hibernation.AddTab(3, 10);
+        hibernation.AddTab(4, 10);
+        hibernation.AddTab(1, 20);
+
+        // 400 MB of live tabs, two of them go, oldest and then lower id first
+        std::vector<TabTransition> transitions;
+        hibernation.Evaluate(40, 5, transitions);
+        CHECK((GetDiscarded(transitions) == std::vector<size_t>{ 3, 4 }));
+
+        // Raising the budget leaves them all
+        policy.memoryBudget = 400;
+        hibernation.SetPolicy(policy);
+        transitions.clear();
+        hibernation.Evaluate(40, 5, transitions);
+        CHECK(transitions.empty());
+    }
+
+    void TestMeasuredMemory()
+    {
+        TabHibernation hibernation;
+        TabHibernationPolicy policy;
+        policy.memoryBudget = 500;
+        hibernation.SetPolicy(policy);
+        hibernation.AddTab(1, 0);
+        hibernation.AddTab(2, 10);
+        hibernation.AddTab(3, 20);
+
+        // 300 MB estimated fits, 700 MB measured doesn't
+        std::vector<TabTransition> transitions;
+        hibernation.Evaluate(30, 3, transitions);
+        CHECK(transitions.empty());
+        hibernation.SetMeasuredMemory(700);
+        CHECK(hibernation.GetMemory() == 700);
+        hibernation.Evaluate(30, 3, transitions);
+        CHECK((GetDiscarded(transitions) == std::vector<size_t>{ 1, 2 }));
+
+        // Lifecycle changes since the measurement adjust it by their cost
+        hibernation.SetLifecycle(1, TabLifecycle::Discarded);
+        CHECK(hibernation.GetMemory() == 600);
+        hibernation.AddTab(4, 40);
+        CHECK(hibernation.GetMemory() == 700);
+        hibernation.SetMeasuredMemory(50);
+        hibernation.RemoveTab(4);
+        hibernation.RemoveTab(3);
+        CHECK(hibernation.GetMemory() == 0);
+    }
+}
+
+int main()
+{
+    TestLookup();
+    TestBudget();
+    TestMeasuredMemory();
+    return CheckResult();
+}
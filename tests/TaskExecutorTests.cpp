@@ -0,0 +1,232 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// TaskExecutorTests.cpp : Work runs on the workers, continuations only on
+// the thread draining the queue and after the wake, and nothing runs for a
+// cancelled token. The stress test opens and closes "tabs" while their work
+// is in flight from many workers.
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+#include "Check.h"
+#include "TaskExecutor.h"
+
+namespace
+{
+    // Stands in for the message loop: the wake posts, Drain waits for it
+    class Loop
+    {
+    public:
+        void Wake()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                ++m_wakes;
+            }
+            m_woken.notify_one();
+        }
+
+        // Runs the continuations after each wake until done() or nothing
+        // came for a while
+        template <typename F>
+        bool RunUntil(TaskExecutor& executor, F&& done)
+        {
+            while (!done())
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                if (!m_woken.wait_for(lock, std::chrono::seconds(10), [this]() { return m_wakes != 0; }))
+                    return false;
+                m_wakes = 0;
+                lock.unlock();
+                executor.RunContinuations();
+            }
+            return true;
+        }
+
+    private:
+        std::mutex m_lock;
+        std::condition_variable m_woken;
+        size_t m_wakes = 0;
+    };
+
+    void TestContinuationThread()
+    {
+        Loop loop;
+        TaskExecutor executor(2, [&loop]() { loop.Wake(); });
+        std::thread::id uiThread = std::this_thread::get_id();
+
+        std::atomic<bool> workOnWorker = false;
+        bool thenOnUI = false;
+        int result = 0;
+        executor.Run<int>([&workOnWorker, uiThread]()
+        {
+            workOnWorker = std::this_thread::get_id() != uiThread;
+            return 42;
+        },
+        [&thenOnUI, &result, uiThread](int& value)
+        {
+            thenOnUI = std::this_thread::get_id() == uiThread;
+            result = value;
+        });
+
+        // Nothing runs before the queue is drained
+        executor.WaitForWork();
+        CHECK(executor.HasContinuations());
+        CHECK(result == 0);
+        CHECK(loop.RunUntil(executor, [&result]() { return result != 0; }));
+        CHECK(workOnWorker);
+        CHECK(thenOnUI);
+        CHECK(result == 42);
+        CHECK(!executor.HasContinuations());
+
+        bool posted = false;
+        executor.Post([&posted]() { posted = true; });
+        CHECK(loop.RunUntil(executor, [&posted]() { return posted; }));
+    }
+
+    void TestCancellation()
+    {
+        Loop loop;
+        TaskExecutor executor(1, [&loop]() { loop.Wake(); });
+
+        // Holds the only worker until released
+        std::mutex gate;
+        gate.lock();
+        executor.Run([&gate]() { gate.lock(); gate.unlock(); }, nullptr);
+
+        bool workRan = false;
+        bool thenRan = false;
+        {
+            CancellationSource tab;
+            executor.Run([&workRan]() { workRan = true; }, [&thenRan]() { thenRan = true; }, tab.GetToken());
+        }
+        gate.unlock();
+        executor.WaitForWork();
+        executor.RunContinuations();
+        CHECK(!workRan);
+        CHECK(!thenRan);
+
+        // Cancelled between the work and its continuation
+        CancellationSource tab;
+        executor.Run([&workRan]() { workRan = true; }, [&thenRan]() { thenRan = true; }, tab.GetToken());
+        executor.WaitForWork();
+        tab.Cancel();
+        executor.RunContinuations();
+        CHECK(workRan);
+        CHECK(!thenRan);
+
+        bool postedRan = false;
+        CancellationSource closed;
+        executor.Post([&postedRan]() { postedRan = true; }, closed.GetToken());
+        closed.Cancel();
+        executor.RunContinuations();
+        CHECK(!postedRan);
+        CHECK(!CancellationToken().IsCancelled());
+    }
+
+    void TestDestroyWithQueuedWork()
+    {
+        std::atomic<size_t> ran = 0;
+        std::atomic<size_t> wakes = 0;
+        {
+            TaskExecutor executor(2, [&wakes]() { ++wakes; });
+            for (size_t i = 0; i < 1000; ++i)
+                executor.Run([&ran]() { ++ran; std::this_thread::sleep_for(std::chrono::microseconds(10)); }, []() {});
+        }
+        // Some ran, the rest was dropped, and the destructor didn't hang
+        CHECK(ran <= 1000);
+    }
+
+    // Tabs are opened and closed while their work runs. Every continuation
+    // of a tab still open runs once, on this thread, none of a closed one.
+    void TestStress()
+    {
+        const size_t jobCount = 20000;
+        const size_t tabCount = 64;
+        Loop loop;
+        TaskExecutor executor(4, [&loop]() { loop.Wake(); });
+        std::thread::id uiThread = std::this_thread::get_id();
+        std::mt19937 random(7);
+
+        struct Job
+        {
+            size_t tab = 0;
+            bool isCancelled = false;
+            std::atomic<int> thens = 0;
+        };
+        std::vector<std::unique_ptr<CancellationSource>> tabs(tabCount);
+        std::vector<std::vector<size_t>> tabJobs(tabCount);
+        std::vector<Job> jobs(jobCount);
+        std::atomic<size_t> workRan = 0;
+        size_t thensOffUI = 0;
+        size_t finished = 0;
+
+        auto closeTab = [&](size_t tab)
+        {
+            tabs[tab].reset();
+            // Continuations only run on this thread, the ones that haven't
+            // yet never will
+            for (size_t job : tabJobs[tab])
+                jobs[job].isCancelled = jobs[job].thens == 0;
+            tabJobs[tab].clear();
+        };
+
+        for (size_t i = 0; i < jobCount; ++i)
+        {
+            size_t tab = random() % tabCount;
+            if (!tabs[tab])
+                tabs[tab] = std::make_unique<CancellationSource>();
+            jobs[i].tab = tab;
+            tabJobs[tab].push_back(i);
+
+            auto then = [&, i]()
+            {
+                thensOffUI += std::this_thread::get_id() != uiThread ? 1 : 0;
+                ++jobs[i].thens;
+                ++finished;
+            };
+            if (i % 5 == 0)
+                executor.Post(then, tabs[tab]->GetToken());
+            else
+                executor.Run([&workRan]() { ++workRan; }, then, tabs[tab]->GetToken());
+
+            if (random() % 50 == 0)
+                closeTab(random() % tabCount);
+            if (i % 256 == 0)
+                executor.RunContinuations();
+        }
+
+        size_t expected = 0;
+        for (const Job& job : jobs)
+            expected += job.isCancelled ? 0 : 1;
+        CHECK(loop.RunUntil(executor, [&]() { executor.WaitForWork(); return finished == expected && !executor.HasContinuations(); }));
+
+        size_t ranTwice = 0;
+        size_t ranCancelled = 0;
+        size_t missed = 0;
+        for (const Job& job : jobs)
+        {
+            ranTwice += job.thens > 1 ? 1 : 0;
+            ranCancelled += job.isCancelled && job.thens != 0 ? 1 : 0;
+            missed += !job.isCancelled && job.thens == 0 ? 1 : 0;
+        }
+        CHECK(ranTwice == 0);
+        CHECK(ranCancelled == 0);
+        CHECK(missed == 0);
+        CHECK(thensOffUI == 0);
+        CHECK(workRan <= jobCount - jobCount / 5);
+    }
+}
+
+int main()
+{
+    TestContinuationThread();
+    TestCancellation();
+    TestDestroyWithQueuedWork();
+    TestStress();
+    return CheckResult();
+}
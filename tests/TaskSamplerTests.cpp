@@ -0,0 +1,85 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// TaskSamplerTests.cpp : The ring keeps the latest samples of each tab, CPU
+// usage spans the samples of the current process only and navigations are
+// counted per tab.
+
+#include <vector>
+#include "Check.h"
+#include "TaskSampler.h"
+
+namespace
+{
+    void TestRing()
+    {
+        TaskSampler sampler;
+        sampler.Record(1, 0, 10, 0, 0);
+        CHECK(sampler.GetLatest(1) == nullptr);
+
+        sampler.AddTab(1);
+        CHECK(sampler.GetLatest(1) == nullptr);
+        for (uint64_t i = 0; i < TaskSampler::c_sampleCount + 5; ++i)
+            sampler.Record(1, i * 1000, 10, i * 4096, i * 1000);
+        CHECK(sampler.GetSampleCount(1) == TaskSampler::c_sampleCount);
+        const TaskSample* latest = sampler.GetLatest(1);
+        CHECK(latest != nullptr && latest->workingSet == (TaskSampler::c_sampleCount + 4) * 4096);
+
+        // 1 ms of CPU per second is 1 permille
+        CHECK(sampler.GetCpuUsage(1) == 1);
+
+        std::vector<size_t> tabIds;
+        sampler.AddTab(2);
+        sampler.ForEach([&tabIds](size_t tabId, const TaskSample&) { tabIds.push_back(tabId); });
+        CHECK((tabIds == std::vector<size_t>{ 1 }));
+
+        // Added again, a tab starts over
+        sampler.AddTab(1);
+        CHECK(sampler.GetSampleCount(1) == 0);
+        sampler.RemoveTab(1);
+        CHECK(sampler.GetLatest(1) == nullptr);
+    }
+
+    void TestCpuUsage()
+    {
+        TaskSampler sampler;
+        sampler.AddTab(1);
+        sampler.Record(1, 0, 10, 0, 0);
+        CHECK(sampler.GetCpuUsage(1) == 0);
+        sampler.Record(1, 1000, 10, 0, 500000);
+        CHECK(sampler.GetCpuUsage(1) == 500);
+
+        // The new process started its counters over
+        sampler.Record(1, 2000, 20, 0, 100000);
+        CHECK(sampler.GetCpuUsage(1) == 0);
+        sampler.Record(1, 4000, 20, 0, 2100000);
+        CHECK(sampler.GetCpuUsage(1) == 1000);
+    }
+
+    void TestNavigations()
+    {
+        TaskSampler sampler;
+        sampler.AddTab(1);
+        sampler.AddNavigation(1);
+        sampler.AddNavigation(2);
+        sampler.Record(1, 0, 10, 0, 0);
+        CHECK(sampler.GetRecentNavigations(1) == 0);
+
+        sampler.AddNavigation(1);
+        sampler.AddNavigation(1);
+        sampler.Record(1, 1000, 10, 0, 0);
+        CHECK(sampler.GetRecentNavigations(1) == 2);
+        CHECK(sampler.GetLatest(1)->navigations == 3);
+        sampler.Record(1, 2000, 10, 0, 0);
+        CHECK(sampler.GetRecentNavigations(1) == 0);
+    }
+}
+
+int main()
+{
+    TestRing();
+    TestCpuUsage();
+    TestNavigations();
+    return CheckResult();
+}
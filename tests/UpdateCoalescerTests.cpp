@@ -0,0 +1,139 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// UpdateCoalescerTests.cpp : Batches keep the order tabs changed in, and
+// every update in them decodes with the schema's TabUpdateArgs.
+
+#include <string>
+#include <vector>
+#include "Check.h"
+#include "MessageSchema.h"
+#include "UpdateCoalescer.h"
+
+namespace
+{
+    // The tab ids of the updates in a batch, in order. Fails the check if
+    // an update doesn't match the schema.
+    std::vector<size_t> ReadBatch(const JsonWriter& writer)
+    {
+        std::vector<size_t> tabIds;
+        std::wstring json = writer.GetString();
+        int message = 0;
+        JsonValue args;
+        BatchArgs batch;
+        CHECK(JsonReader::ReadMessage(&json[0], message, args) && message == MG_BATCH && DecodeArgs(args, batch));
+        CHECK(batch.updates.GetType() == JsonType::Array);
+
+        // Array elements are scanned one by one after the bracket
+        std::wstring_view raw = batch.updates.GetRaw();
+        std::wstring elements(raw.substr(1, raw.size() - 2));
+        wchar_t* p = elements.empty() ? nullptr : &elements[0];
+        wchar_t* end = p + elements.size();
+        while (p != nullptr && p < end)
+        {
+            JsonValue update;
+            p = JsonReader::ScanValue(p, end, update);
+            TabUpdateArgs decoded;
+            CHECK(p != nullptr && DecodeArgs(update, decoded));
+            if (p == nullptr)
+                break;
+            tabIds.push_back(decoded.tabId);
+            if (p < end && *p == L',')
+                ++p;
+        }
+        return tabIds;
+    }
+
+    void Touch(UpdateCoalescer& coalescer, size_t tabId)
+    {
+        NavStartingMessage update;
+        update.tabId = tabId;
+        coalescer.Add(update);
+    }
+
+    void TestRemovePreservesOrder()
+    {
+        UpdateCoalescer coalescer;
+        for (size_t tabId = 1; tabId <= 6; ++tabId)
+            Touch(coalescer, tabId);
+        coalescer.RemoveTab(2);
+        coalescer.RemoveTab(9);
+
+        JsonWriter writer;
+        coalescer.Flush(writer, INVALID_TAB_ID, 100);
+        CHECK((ReadBatch(writer) == std::vector<size_t>{ 1, 3, 4, 5, 6 }));
+        CHECK(coalescer.IsEmpty());
+
+        // The removed entry is reused without bringing stale fields along
+        Touch(coalescer, 7);
+        coalescer.Flush(writer, INVALID_TAB_ID, 100);
+        CHECK((ReadBatch(writer) == std::vector<size_t>{ 7 }));
+    }
+
+    void TestPriorityAndLimit()
+    {
+        UpdateCoalescer coalescer;
+        for (size_t tabId = 1; tabId <= 5; ++tabId)
+            Touch(coalescer, tabId);
+
+        JsonWriter writer;
+        coalescer.Flush(writer, 4, 2);
+        CHECK((ReadBatch(writer) == std::vector<size_t>{ 4, 1, 2 }));
+        coalescer.RemoveTab(3);
+        Touch(coalescer, 1);
+        coalescer.Flush(writer, INVALID_TAB_ID, 2);
+        CHECK((ReadBatch(writer) == std::vector<size_t>{ 5, 1 }));
+    }
+
+    void TestEveryField()
+    {
+        UpdateCoalescer coalescer;
+        UpdateUriMessage uri;
+        uri.tabId = 1;
+        uri.uri = L"https://example.com/\"quoted\"";
+        uri.uriToShow = L"browser://history";
+        uri.canGoForward = false;
+        uri.canGoBack = true;
+        uri.isFavorite = true;
+        coalescer.Add(uri);
+        NavCompletedMessage completed;
+        completed.tabId = 1;
+        completed.isError = false;
+        coalescer.Add(completed);
+        UpdateTabMessage title;
+        title.tabId = 1;
+        title.title = L"\"Title\"";
+        coalescer.Add(title);
+        UpdateFaviconMessage favicon;
+        favicon.tabId = 1;
+        favicon.uri = L"\"https://example.com/favicon.ico\"";
+        coalescer.Add(favicon);
+        SecurityUpdateMessage security;
+        security.tabId = 1;
+        security.state = L"secure";
+        coalescer.Add(security);
+        TabLifecycleMessage lifecycle;
+        lifecycle.tabId = 1;
+        lifecycle.lifecycle = L"live";
+        coalescer.Add(lifecycle);
+
+        JsonWriter writer;
+        coalescer.Flush(writer, 1, 0);
+        CHECK((ReadBatch(writer) == std::vector<size_t>{ 1 }));
+        std::wstring json = writer.GetString();
+        for (const wchar_t* key : { L"\"uriToShow\"", L"\"canGoBack\"", L"\"isFavorite\"", L"\"isLoading\"", L"\"isError\"",
+            L"\"title\"", L"\"favicon\"", L"\"state\"", L"\"lifecycle\"" })
+        {
+            CHECK(json.find(key) != std::wstring::npos);
+        }
+    }
+}
+
+int main()
+{
+    TestRemovePreservesOrder();
+    TestPriorityAndLimit();
+    TestEveryField();
+    return CheckResult();
+}
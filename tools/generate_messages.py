@@ -0,0 +1,296 @@
+# Copyright (C) Microsoft Corporation. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+# Generates the message definitions shared by the host and the browser UI
+# from messages.json:
+#   messages.h               message ids
+#   MessageSchema.h          args structs, their field layouts and encoders,
+#                            message types and the dispatch table
+#   wvbrowser_ui/commands.js message ids for the UI
+#
+# Usage: python tools/generate_messages.py [repository root] [--stamp file]
+#
+# Outputs are only rewritten when their content changes, so the stamp file
+# is what build systems should compare against messages.json.
+
+import json
+import os
+import sys
+
+HEADER = """// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Generated from messages.json by tools/generate_messages.py. Do not edit.
+"""
+
+# Schema type -> (FieldType, C++ type, default value)
+FIELD_TYPES = {
+    "string": ("String", "std::wstring_view", ' = L""'),
+    "size": ("Size", "size_t", " = 0"),
+    "int": ("Int", "long long", " = 0"),
+    "bool": ("Bool", "bool", " = false"),
+    "json": ("Json", "JsonValue", ""),
+    "raw": ("Raw", "std::wstring_view", ' = L""'),
+}
+
+# Optional scalars are std::optional, so encoders can tell false and 0 from
+# absent. Optional strings are omitted when empty.
+OPTIONAL_SCALARS = {
+    "size": ("OptionalSize", "std::optional<size_t>"),
+    "int": ("OptionalInt", "std::optional<long long>"),
+    "bool": ("OptionalBool", "std::optional<bool>"),
+}
+
+# Schema type -> JsonWriter method
+WRITERS = {
+    "string": "WriteString",
+    "size": "WriteNumber",
+    "int": "WriteNumber",
+    "bool": "WriteBool",
+    "raw": "WriteRaw",
+}
+
+MAX_FIELDS = 32  # Fields are tracked in a 32-bit mask while decoding
+
+
+def load_schema(path):
+    with open(path, "r", encoding="utf-8") as file:
+        schema = json.load(file)
+
+    structs = schema["structs"]
+    for name, fields in structs.items():
+        if len(fields) > MAX_FIELDS:
+            sys.exit("%s has more than %d fields" % (name, MAX_FIELDS))
+        seen = set()
+        for field in fields:
+            if field["type"] not in FIELD_TYPES:
+                sys.exit("%s.%s has unknown type %s" % (name, field["name"], field["type"]))
+            if field["name"] in seen:
+                sys.exit("%s.%s is declared twice" % (name, field["name"]))
+            if "items" in field and (field["type"] != "json" or field["items"] not in structs):
+                sys.exit("%s.%s has items but isn't a json array of a known struct" % (name, field["name"]))
+            seen.add(field["name"])
+
+    ids = set()
+    for message in schema["messages"]:
+        if message["id"] <= 0 or message["id"] in ids:
+            sys.exit("%s has an invalid or duplicate id" % message["name"])
+        if message["args"] not in structs:
+            sys.exit("%s uses unknown args %s" % (message["name"], message["args"]))
+        ids.add(message["id"])
+
+    return schema
+
+
+def generate_ids(schema):
+    lines = [HEADER, "#pragma once", ""]
+    for name, value in schema["constants"].items():
+        lines.append("#define %s %s" % (name, value))
+    lines.append("")
+    lines.append("// Message codes shared with the browser UI")
+    lines.append("enum MessageId : int")
+    lines.append("{")
+    messages = schema["messages"]
+    for i, message in enumerate(messages):
+        separator = "," if i + 1 < len(messages) else ""
+        lines.append("    %s = %d%s" % (message["name"], message["id"], separator))
+    lines.append("};")
+    lines.append("")
+    lines.append("constexpr int c_maxMessageId = %d;" % max(m["id"] for m in messages))
+    return "\n".join(lines) + "\n"
+
+
+def field_type(field):
+    if field.get("optional", False) and field["type"] in OPTIONAL_SCALARS:
+        return OPTIONAL_SCALARS[field["type"]]
+    field_type, cpp_type, _ = FIELD_TYPES[field["type"]]
+    return field_type, cpp_type
+
+
+def message_alias(name):
+    # MG_UPDATE_URI -> UpdateUriMessage
+    return "".join(part.capitalize() for part in name[len("MG_"):].split("_")) + "Message"
+
+
+def generate_struct(name, fields):
+    lines = ["struct %s" % name, "{"]
+    for field in fields:
+        _, cpp_type = field_type(field)
+        default = FIELD_TYPES[field["type"]][2]
+        if cpp_type.startswith("std::optional"):
+            default = ""
+        elif field["name"] == "tabId":
+            default = " = INVALID_TAB_ID"
+        comment = " // Array of %s" % field["items"] if "items" in field else ""
+        lines.append("    %s %s%s;%s" % (cpp_type, field["name"], default, comment))
+    lines.append("};")
+    lines.append("")
+
+    lines.append("template <>")
+    lines.append("struct ArgsLayout<%s>" % name)
+    lines.append("{")
+    if fields:
+        required = 0
+        lines.append("    static constexpr FieldLayout Fields[] = {")
+        for i, field in enumerate(fields):
+            lines.append('        { L"%s", HashFieldName(L"%s"), FieldType::%s, offsetof(%s, %s) },' % (
+                field["name"], field["name"], field_type(field)[0], name, field["name"]))
+            if not field.get("optional", False):
+                required |= 1 << i
+        lines.append("    };")
+        lines.append("    static constexpr MessageLayout Layout = { Fields, %d, 0x%Xu };" % (
+            len(fields), required))
+    else:
+        lines.append("    static constexpr MessageLayout Layout = { nullptr, 0, 0 };")
+    lines.append("};")
+    lines.append("")
+
+    for field in fields:
+        lines.append('template <> struct FieldName<&%s::%s> { static constexpr std::wstring_view value = L"%s"; };' % (
+            name, field["name"], field["name"]))
+    if fields:
+        lines.append("")
+
+    # Arrays are written element by element by the caller, see FieldName
+    if not fields:
+        lines.append("inline void EncodeFields(JsonWriter&, const %s&)" % name)
+        lines.append("{")
+        lines.append("}")
+        lines.append("")
+        return lines
+
+    lines.append("inline void EncodeFields(JsonWriter& writer, const %s& args)" % name)
+    lines.append("{")
+    for field in fields:
+        key = 'L"%s"' % field["name"]
+        member = "args." + field["name"]
+        optional = field.get("optional", False)
+        if field["type"] == "json":
+            lines.append("    if (%s.GetType() != JsonType::Invalid)" % member)
+            lines.append("        writer.WriteRaw(%s, %s.GetRaw());" % (key, member))
+        elif optional and field["type"] in OPTIONAL_SCALARS:
+            lines.append("    if (%s)" % member)
+            lines.append("        writer.%s(%s, *%s);" % (WRITERS[field["type"]], key, member))
+        elif optional:
+            lines.append("    if (!%s.empty())" % member)
+            lines.append("        writer.%s(%s, %s);" % (WRITERS[field["type"]], key, member))
+        else:
+            lines.append("    writer.%s(%s, %s);" % (WRITERS[field["type"]], key, member))
+    lines.append("}")
+    lines.append("")
+    return lines
+
+
+def generate_schema(schema):
+    lines = [HEADER, "#pragma once", "", "#include <cstddef>", "#include <optional>", '#include "MessageCodec.h"', ""]
+
+    for name, fields in schema["structs"].items():
+        lines.extend(generate_struct(name, fields))
+
+    messages = schema["messages"]
+    lines.append("// Args of each message, Message<id> derives from them")
+    for message in messages:
+        lines.append("template <>")
+        lines.append("struct MessageArgs<%s>" % message["name"])
+        lines.append("{")
+        lines.append("    using Type = %s;" % message["args"])
+        lines.append("};")
+        lines.append("")
+    for message in messages:
+        lines.append("using %s = Message<%s>;" % (message_alias(message["name"]), message["name"]))
+    lines.append("")
+
+    by_id = {m["id"]: m for m in messages}
+    max_id = max(by_id)
+    lines.append("// Indexed by message id, nullptr for unused ids")
+    lines.append("constexpr const MessageLayout* c_messageLayouts[%d] = {" % (max_id + 1))
+    for i in range(max_id + 1):
+        message = by_id.get(i)
+        if message:
+            lines.append("    &ArgsLayout<%s>::Layout, // %s" % (message["args"], message["name"]))
+        else:
+            lines.append("    nullptr,")
+    lines.append("};")
+    lines.append("")
+    lines.append("constexpr const MessageLayout* GetMessageLayout(int message)")
+    lines.append("{")
+    lines.append("    return message >= 0 && message <= c_maxMessageId ? c_messageLayouts[message] : nullptr;")
+    lines.append("}")
+    lines.append("")
+
+    lines.append("// Calls the OnMessage overload Handler has for a message, through a table")
+    lines.append("// built at compile time and indexed by message id")
+    lines.append("template <typename Handler>")
+    lines.append("class MessageDispatcher")
+    lines.append("{")
+    lines.append("public:")
+    lines.append("    static DispatchResult Dispatch(Handler& handler, int message, JsonValue& args)")
+    lines.append("    {")
+    lines.append("        Entry entry = message >= 0 && message <= c_maxMessageId ? c_entries[message] : nullptr;")
+    lines.append("        return entry == nullptr ? DispatchResult::Unhandled : entry(handler, args);")
+    lines.append("    }")
+    lines.append("")
+    lines.append("private:")
+    lines.append("    using Table = MessageHandlerTable<Handler>;")
+    lines.append("    using Entry = typename Table::Entry;")
+    lines.append("")
+    lines.append("    static constexpr Entry c_entries[%d] = {" % (max_id + 1))
+    for i in range(max_id + 1):
+        message = by_id.get(i)
+        if message:
+            lines.append("        Table::template GetEntry<%s>()," % message["name"])
+        else:
+            lines.append("        nullptr,")
+    lines.append("    };")
+    lines.append("};")
+    return "\n".join(lines) + "\n"
+
+
+def generate_commands(schema):
+    lines = [HEADER, "const commands = {"]
+    messages = schema["messages"]
+    for i, message in enumerate(messages):
+        separator = "," if i + 1 < len(messages) else ""
+        lines.append("    %s: %d%s" % (message["name"], message["id"], separator))
+    lines.append("};")
+    return "\n".join(lines) + "\n"
+
+
+def write_if_changed(path, content):
+    # Leaving unchanged outputs alone keeps incremental builds incremental
+    if os.path.exists(path):
+        with open(path, "r", encoding="utf-8", newline="") as file:
+            if file.read() == content:
+                return
+    with open(path, "w", encoding="utf-8", newline="") as file:
+        file.write(content)
+    print("Generated " + path)
+
+
+def main():
+    args = sys.argv[1:]
+    stamp = None
+    if "--stamp" in args:
+        index = args.index("--stamp")
+        if index + 1 >= len(args):
+            sys.exit("--stamp needs a file name")
+        stamp = args[index + 1]
+        del args[index:index + 2]
+    root = args[0] if args else os.path.join(os.path.dirname(__file__), "..")
+    schema = load_schema(os.path.join(root, "messages.json"))
+
+    write_if_changed(os.path.join(root, "messages.h"), generate_ids(schema))
+    write_if_changed(os.path.join(root, "MessageSchema.h"), generate_schema(schema))
+    write_if_changed(os.path.join(root, "wvbrowser_ui", "commands.js"), generate_commands(schema))
+
+    # Always written, so the build sees the generator ran even when none of
+    # the outputs changed
+    if stamp:
+        with open(stamp, "w", encoding="utf-8") as file:
+            file.write("")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,3 +1,9 @@
+// Copyright (C) Microsoft Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Generated from messages.json by tools/generate_messages.py. Do not edit.
+
 const commands = {
     MG_NAVIGATE: 1,
     MG_UPDATE_URI: 2,
@@ -25,5 +31,20 @@ const commands = {
     MG_CLEAR_COOKIES: 25,
     MG_GET_HISTORY: 26,
     MG_REMOVE_HISTORY_ITEM: 27,
-    MG_CLEAR_HISTORY: 28
+    MG_CLEAR_HISTORY: 28,
+    MG_BATCH: 29,
+    MG_GET_METRICS: 30,
+    MG_DUMP_METRICS: 31,
+    MG_SET_TRACING: 32,
+    MG_PAGE_METADATA: 33,
+    MG_SET_RECORDING: 34,
+    MG_SET_TAB_POLICY: 35,
+    MG_TAB_LIFECYCLE: 36,
+    MG_RESTORE_SESSION: 37,
+    MG_GET_TASKS: 38,
+    MG_MOVE_TAB: 39,
+    MG_SEARCH_HISTORY: 40,
+    MG_GET_SUGGESTIONS: 41,
+    MG_ADD_FAVORITE: 42,
+    MG_MIGRATE_FAVORITES: 43
 };
@@ -4,7 +4,7 @@ const messageHandler = event => {
 
     switch (message) {
         case commands.MG_GET_FAVORITES:
-            loadFavorites(args.favorites);
+            loadFavorites(args.items || []);
             break;
         default:
             console.log(`Unexpected message: ${JSON.stringify(event.data)}`);
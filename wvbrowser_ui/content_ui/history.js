@@ -1,7 +1,12 @@
 const DEFAULT_HISTORY_ITEM_COUNT = 20;
 const EMPTY_HISTORY_MESSAGE = `You haven't visited any sites yet.`;
-let requestedTop = 0;
-let lastRequestSize = 0;
+const NO_MATCHES_MESSAGE = 'No history matches your search.';
+const DEFAULT_FAVICON = '../controls_ui/img/favicon.png';
+// The host hands out a cursor with each page but the last
+let nextCursor;
+let isFirstPage = true;
+// Searched for by the host, the whole history while empty
+let currentQuery = '';
 let itemHeight = 48;
 
 const dateStringFormat = new Intl.DateTimeFormat('default', {
@@ -22,16 +27,25 @@ const messageHandler = event => {
 
     switch (message) {
         case commands.MG_GET_HISTORY:
+        case commands.MG_SEARCH_HISTORY:
+            // Replies to a query typed over since are dropped
+            if ((args.query || '') != currentQuery) {
+                break;
+            }
+
             let entriesContainer = document.getElementById('entries-container');
-            if (args.from == 0 && args.items.length) {
+            if (isFirstPage) {
                 entriesContainer.textContent = '';
-
-                let clearButton = document.getElementById('btn-clear');
-                clearButton.classList.remove('hidden');
+                if (args.items.length) {
+                    let clearButton = document.getElementById('btn-clear');
+                    clearButton.classList.remove('hidden');
+                }
             }
+            isFirstPage = false;
 
             loadItems(args.items);
-            if (args.items.length == lastRequestSize) {
+            nextCursor = args.cursor;
+            if (nextCursor) {
                 document.addEventListener('scroll', requestTrigger);
             } else if (entriesContainer.childElementCount == 0) {
                 loadUIForEmptyHistory();
@@ -53,14 +67,19 @@ const requestTrigger = function(event) {
     }
 };
 
-function requestHistoryItems(from, count) {
+function requestHistoryItems(cursor, count) {
     let message = {
-        message: commands.MG_GET_HISTORY,
+        message: currentQuery ? commands.MG_SEARCH_HISTORY : commands.MG_GET_HISTORY,
         args: {
-            from: from,
             count: count || DEFAULT_HISTORY_ITEM_COUNT
         }
     };
+    if (cursor) {
+        message.args.cursor = cursor;
+    }
+    if (currentQuery) {
+        message.args.query = currentQuery;
+    }
 
     window.chrome.webview.postMessage(message);
 }
@@ -159,7 +178,12 @@ function loadItems(items) {
 
     items.map((entry) => {
         let id = entry.id;
-        let item = entry.item;
+        let item = {
+            uri: entry.uri,
+            title: entry.title || entry.uri,
+            favicon: entry.favicon || DEFAULT_FAVICON,
+            timestamp: entry.timestamp
+        };
         let itemContainerId = `item-${id}`;
 
         // Skip the item if already loaded. This could happen if the user
@@ -203,12 +227,21 @@ function loadItems(items) {
     }
 }
 
+function searchHistory(query) {
+    currentQuery = query.trim();
+    nextCursor = undefined;
+    isFirstPage = true;
+    getMoreHistoryItems(getViewportItemsCapacity());
+}
+
+function getViewportItemsCapacity() {
+    return Math.round(window.innerHeight / itemHeight);
+}
+
 function getMoreHistoryItems(n) {
     n = n ? n : DEFAULT_HISTORY_ITEM_COUNT;
 
-    requestHistoryItems(requestedTop, n);
-    requestedTop += n;
-    lastRequestSize = n;
+    requestHistoryItems(nextCursor, n);
     document.removeEventListener('scroll', requestTrigger);
 }
 
@@ -235,6 +268,11 @@ function addUIListeners() {
 
     let clearButton = document.getElementById('btn-clear');
     clearButton.addEventListener('click', toggleClearPrompt);
+
+    let searchBox = document.getElementById('search-box');
+    searchBox.addEventListener('input', function(event) {
+        searchHistory(searchBox.value);
+    });
 }
 
 function toggleClearPrompt() {
@@ -244,6 +282,10 @@ function toggleClearPrompt() {
 
 function loadUIForEmptyHistory() {
     let entriesContainer = document.getElementById('entries-container');
+    if (currentQuery) {
+        entriesContainer.textContent = NO_MATCHES_MESSAGE;
+        return;
+    }
     entriesContainer.textContent = EMPTY_HISTORY_MESSAGE;
 
     let clearButton = document.getElementById('btn-clear');
@@ -252,6 +294,8 @@ function loadUIForEmptyHistory() {
 
 function clearHistory() {
     toggleClearPrompt();
+    currentQuery = '';
+    document.getElementById('search-box').value = '';
     loadUIForEmptyHistory();
 
     let message = {
@@ -265,9 +309,8 @@ function clearHistory() {
 function init() {
     window.chrome.webview.addEventListener('message', messageHandler);
 
-    let viewportItemsCapacity = Math.round(window.innerHeight / itemHeight);
     addUIListeners();
-    getMoreHistoryItems(viewportItemsCapacity);
+    getMoreHistoryItems(getViewportItemsCapacity());
 }
 
 init();
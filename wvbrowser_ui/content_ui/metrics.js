@@ -0,0 +1,165 @@
+const METRICS_REFRESH_INTERVAL = 2000;
+
+var tracing = false;
+var recording = false;
+
+// Message names by id, from the generated commands table
+const messageNames = new Map(Object.entries(commands).map(([name, id]) => [id, name]));
+
+const messageHandler = event => {
+    var message = event.data.message;
+    var args = event.data.args;
+
+    switch (message) {
+        case commands.MG_GET_METRICS:
+            loadMetrics(args);
+            break;
+        case commands.MG_DUMP_METRICS:
+            let result = document.getElementById('dump-result');
+            result.textContent = args.succeeded ? `Saved to ${args.path}` : 'Could not save the metrics';
+            break;
+        case commands.MG_SET_TRACING:
+            tracing = args.enabled;
+            loadCapture(args, 'trace', 'tracing', 'Trace');
+            break;
+        case commands.MG_SET_RECORDING:
+            recording = args.enabled;
+            loadCapture(args, 'record', 'recording', 'Traffic log');
+            break;
+        default:
+            console.log(`Unexpected message: ${JSON.stringify(event.data)}`);
+            break;
+    }
+};
+
+function requestMetrics() {
+    let message = {
+        message: commands.MG_GET_METRICS,
+        args: {}
+    };
+
+    window.chrome.webview.postMessage(message);
+}
+
+function dumpMetrics() {
+    let message = {
+        message: commands.MG_DUMP_METRICS,
+        args: {}
+    };
+
+    window.chrome.webview.postMessage(message);
+}
+
+function toggleTracing() {
+    let message = {
+        message: commands.MG_SET_TRACING,
+        args: {
+            enabled: !tracing
+        }
+    };
+
+    window.chrome.webview.postMessage(message);
+}
+
+function toggleRecording() {
+    let message = {
+        message: commands.MG_SET_RECORDING,
+        args: {
+            enabled: !recording
+        }
+    };
+
+    window.chrome.webview.postMessage(message);
+}
+
+// Updates the button and result text for tracing ('trace') or recording ('record')
+function loadCapture(args, id, verb, noun) {
+    document.getElementById(`btn-${id}`).textContent = args.enabled ? `Stop ${verb}` : `Start ${verb}`;
+
+    let result = document.getElementById(`${id}-result`);
+    if (!args.succeeded) {
+        result.textContent = `Could not save the ${noun.toLowerCase()}`;
+    } else if (args.enabled) {
+        result.textContent = `${verb.charAt(0).toUpperCase()}${verb.slice(1)}...`;
+    } else {
+        result.textContent = args.path ? `${noun} saved to ${args.path}` : '';
+    }
+}
+
+// Latencies are reported in nanoseconds
+function formatDuration(ns) {
+    if (ns < 1000) {
+        return `${ns} ns`;
+    } else if (ns < 1000000) {
+        return `${(ns / 1000).toFixed(1)} µs`;
+    }
+    return `${(ns / 1000000).toFixed(1)} ms`;
+}
+
+function formatBytes(bytes) {
+    if (bytes < 1024) {
+        return `${bytes} B`;
+    } else if (bytes < 1024 * 1024) {
+        return `${(bytes / 1024).toFixed(1)} KB`;
+    }
+    return `${(bytes / (1024 * 1024)).toFixed(1)} MB`;
+}
+
+function createRow(cells) {
+    let row = document.createElement('tr');
+    cells.forEach((text) => {
+        let cell = document.createElement('td');
+        cell.textContent = text;
+        row.append(cell);
+    });
+    return row;
+}
+
+function loadMetrics(metrics) {
+    document.getElementById('uptime').textContent =
+        `Recording for ${Math.round(metrics.uptime / 1000)} s`;
+
+    let messages = metrics.messages.slice().sort((a, b) => b.count - a.count);
+    let messagesBody = document.querySelector('#messages-table tbody');
+    let messagesFragment = document.createDocumentFragment();
+    messages.forEach((entry) => {
+        messagesFragment.append(createRow([
+            messageNames.get(entry.message) || `Unknown (${entry.message})`,
+            entry.direction,
+            entry.count,
+            formatBytes(entry.bytes),
+            formatDuration(entry.mean),
+            formatDuration(entry.p50),
+            formatDuration(entry.p90),
+            formatDuration(entry.p99),
+            formatDuration(entry.max)
+        ]));
+    });
+    messagesBody.textContent = '';
+    messagesBody.append(messagesFragment);
+
+    let tabsBody = document.querySelector('#tabs-table tbody');
+    let tabsFragment = document.createDocumentFragment();
+    metrics.tabs.forEach((entry) => {
+        tabsFragment.append(createRow([
+            entry.tabId,
+            entry.messages,
+            formatBytes(entry.bytes),
+            entry.updates
+        ]));
+    });
+    tabsBody.textContent = '';
+    tabsBody.append(tabsFragment);
+}
+
+function init() {
+    window.chrome.webview.addEventListener('message', messageHandler);
+    document.getElementById('btn-dump').addEventListener('click', dumpMetrics);
+    document.getElementById('btn-trace').addEventListener('click', toggleTracing);
+    document.getElementById('btn-record').addEventListener('click', toggleRecording);
+
+    requestMetrics();
+    setInterval(requestMetrics, METRICS_REFRESH_INTERVAL);
+}
+
+init();
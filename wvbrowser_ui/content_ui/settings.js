@@ -1,3 +1,7 @@
+// MB for all tabs, 0 for no budget
+const MEMORY_BUDGETS = [0, 1024, 2048, 4096, 8192];
+let memoryBudget = 0;
+
 const messageHandler = event => {
     var message = event.data.message;
     var args = event.data.args;
@@ -56,6 +60,31 @@ function addEntriesListeners() {
     popupsEntry.addEventListener('click', function(e) {
         // Toggle popups
     });
+
+    let memoryEntry = document.getElementById('entry-tab-memory');
+    memoryEntry.addEventListener('click', function(e) {
+        // Cycle through the budgets, the controls UI applies and keeps it
+        let next = MEMORY_BUDGETS.find(budget => budget > memoryBudget);
+        showMemoryBudget(next === undefined ? MEMORY_BUDGETS[0] : next);
+
+        let message = {
+            message: commands.MG_SET_TAB_POLICY,
+            args: {
+                memoryBudget: memoryBudget
+            }
+        };
+
+        window.chrome.webview.postMessage(message);
+    });
+}
+
+function showMemoryBudget(budget) {
+    memoryBudget = budget;
+    if (budget) {
+        updateLabelForEntry('entry-tab-memory', `${budget} MB`);
+    } else {
+        updateLabelForEntry('entry-tab-memory', 'No limit');
+    }
 }
 
 function requestBrowserSettings() {
@@ -79,6 +108,8 @@ function loadSettings(settings) {
     } else {
         updateLabelForEntry('entry-popups', 'Allowed');
     }
+
+    showMemoryBudget(settings.tabPolicy.memoryBudget);
 }
 
 function updateLabelForEntry(elementId, label) {
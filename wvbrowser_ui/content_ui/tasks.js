@@ -0,0 +1,113 @@
+const TASKS_REFRESH_INTERVAL = 2000;
+
+var tasks = [];
+var sortKey = 'workingSet';
+var sortDescending = true;
+
+const messageHandler = event => {
+    var message = event.data.message;
+    var args = event.data.args;
+
+    switch (message) {
+        case commands.MG_GET_TASKS:
+            tasks = args.tasks;
+            loadTasks();
+            break;
+        default:
+            console.log(`Unexpected message: ${JSON.stringify(event.data)}`);
+            break;
+    }
+};
+
+function requestTasks() {
+    let message = {
+        message: commands.MG_GET_TASKS,
+        args: {}
+    };
+
+    window.chrome.webview.postMessage(message);
+}
+
+function formatBytes(bytes) {
+    if (bytes < 1024 * 1024) {
+        return `${(bytes / 1024).toFixed(0)} KB`;
+    }
+    return `${(bytes / (1024 * 1024)).toFixed(1)} MB`;
+}
+
+// CPU is reported in permille of one core
+function formatCpu(permille) {
+    return `${(permille / 10).toFixed(1)}%`;
+}
+
+function getTitle(task) {
+    return task.title || task.uri;
+}
+
+function compareTasks(a, b) {
+    let first = sortKey == 'title' ? getTitle(a) : a[sortKey];
+    let second = sortKey == 'title' ? getTitle(b) : b[sortKey];
+    let order = typeof first == 'string' ? first.localeCompare(second) : first - second;
+    // Ties keep the tabs in the order they were opened
+    if (order == 0) {
+        return a.tabId - b.tabId;
+    }
+    return sortDescending ? -order : order;
+}
+
+function createRow(cells) {
+    let row = document.createElement('tr');
+    cells.forEach((text) => {
+        let cell = document.createElement('td');
+        cell.textContent = text;
+        row.append(cell);
+    });
+    return row;
+}
+
+function loadTasks() {
+    document.querySelectorAll('#tasks-table th').forEach((header) => {
+        header.classList.toggle('sorted-up', header.dataset.key == sortKey && !sortDescending);
+        header.classList.toggle('sorted-down', header.dataset.key == sortKey && sortDescending);
+    });
+
+    let body = document.querySelector('#tasks-table tbody');
+    let fragment = document.createDocumentFragment();
+    tasks.slice().sort(compareTasks).forEach((task) => {
+        let row = createRow([
+            getTitle(task),
+            task.lifecycle,
+            task.processId || '',
+            task.processId ? formatBytes(task.workingSet) : '',
+            task.processId ? formatCpu(task.cpu) : '',
+            task.navigations
+        ]);
+        row.firstChild.title = task.uri;
+        fragment.append(row);
+    });
+    body.textContent = '';
+    body.append(fragment);
+}
+
+// Clicking the sorted column again flips the order
+function sortBy(key) {
+    if (key == sortKey) {
+        sortDescending = !sortDescending;
+    } else {
+        sortKey = key;
+        sortDescending = key != 'title' && key != 'lifecycle';
+    }
+    loadTasks();
+}
+
+function init() {
+    window.chrome.webview.addEventListener('message', messageHandler);
+    document.querySelectorAll('#tasks-table th').forEach((header) => {
+        header.addEventListener('click', () => sortBy(header.dataset.key));
+    });
+
+    requestTasks();
+    setInterval(requestTasks, TASKS_REFRESH_INTERVAL);
+}
+
+init();
@@ -2,9 +2,18 @@ const WORD_REGEX = /^[^//][^.]*$/;
 const VALID_URI_REGEX = /^[-:.&#+()[\]$'*;@~!,?%=\/\w]+$/; // Will check that only RFC3986 allowed characters are included
 const SCHEMED_URI_REGEX = /^\w+:.+$/;
 
+// Address bar suggestions from the host, for the latest keystroke only
+let suggestionRequestId = 0;
+let suggestions = [];
+
 let settings = {
     scriptsEnabled: true,
-    blockPopups: true
+    blockPopups: true,
+    tabPolicy: {
+        suspendAfter: 5 * 60, // Seconds in the background
+        discardAfter: 30 * 60,
+        memoryBudget: 4096 // MB for all tabs, 0 for no budget
+    }
 };
 
 const messageHandler = event => {
@@ -12,46 +21,17 @@ const messageHandler = event => {
     var args = event.data.args;
 
     switch (message) {
+        case commands.MG_BATCH:
+            applyBatchedUpdates(args.updates);
+            break;
         case commands.MG_UPDATE_URI:
             if (isValidTabId(args.tabId)) {
-                const tab = tabs.get(args.tabId);
-                let previousURI = tab.uri;
-
-                // Update the tab state
-                tab.uri = args.uri;
-                tab.uriToShow = args.uriToShow;
-                tab.canGoBack = args.canGoBack;
-                tab.canGoForward = args.canGoForward;
+                updateTabURI(args.tabId, args);
 
                 // If the tab is active, update the controls UI
                 if (args.tabId == activeTabId) {
                     updateNavigationUI(message);
                 }
-
-                isFavorite(tab.uri, (isFavorite) => {
-                    tab.isFavorite = isFavorite;
-                    updateFavoriteIcon();
-                });
-
-                // Don't add history entry if URI has not changed
-                if (tab.uri == previousURI) {
-                    break;
-                }
-
-                // Filter URIs that should not appear in history
-                if (!tab.uri || tab.uri == 'about:blank') {
-                    tab.historyItemId = INVALID_HISTORY_ID;
-                    break;
-                }
-
-                if (tab.uriToShow && tab.uriToShow.substring(0, 10) == 'browser://') {
-                    tab.historyItemId = INVALID_HISTORY_ID;
-                    break;
-                }
-
-                addHistoryItem(historyItemFromTab(args.tabId), (id) => {
-                    tab.historyItemId = id;
-                });
             }
             break;
         case commands.MG_NAV_STARTING:
@@ -78,26 +58,7 @@ const messageHandler = event => {
             break;
         case commands.MG_UPDATE_TAB:
             if (isValidTabId(args.tabId)) {
-                const tab = tabs.get(args.tabId);
-                const tabElement = document.getElementById(`tab-${args.tabId}`);
-
-                if (!tabElement) {
-                    refreshTabs();
-                    return;
-                }
-
-                // Update tab label
-                // Use given title or fall back to a generic tab title
-                tab.title = args.title || 'Tab';
-                const tabLabel = tabElement.firstChild;
-                const tabLabelSpan = tabLabel.firstChild;
-                tabLabelSpan.textContent = tab.title;
-
-                // Update title in history item
-                // Browser pages will keep an invalid history ID
-                if (tab.historyItemId != INVALID_HISTORY_ID) {
-                    updateHistoryItem(tab.historyItemId, historyItemFromTab(args.tabId));
-                }
+                updateTabTitle(args.tabId, args.title);
             }
             break;
         case commands.MG_OPTIONS_LOST_FOCUS:
@@ -123,19 +84,25 @@ const messageHandler = event => {
                 updateFaviconURI(args.tabId, args.uri);
             }
             break;
+        case commands.MG_TAB_LIFECYCLE:
+            if (isValidTabId(args.tabId)) {
+                updateTabLifecycle(args.tabId, args.lifecycle);
+            }
+            break;
         case commands.MG_CLOSE_WINDOW:
             closeWindow();
             break;
-        case commands.MG_GET_FAVORITES:
-            if (isValidTabId(args.tabId)) {
-                getFavoritesAsJson((payload) => {
-                    args.favorites = payload;
-                    window.chrome.webview.postMessage(event.data);
-                });
+        case commands.MG_RESTORE_SESSION:
+            if (args.tabs.length > 0) {
+                restoreTabs(args);
+            } else {
+                createNewTab(true);
             }
             break;
-        case commands.MG_REMOVE_FAVORITE:
-            removeFavorite(args.uri);
+        case commands.MG_MOVE_TAB:
+            if (isValidTabId(args.tabId)) {
+                removeTab(args.tabId);
+            }
             break;
         case commands.MG_GET_SETTINGS:
             if (isValidTabId(args.tabId)) {
@@ -143,30 +110,161 @@ const messageHandler = event => {
                 window.chrome.webview.postMessage(event.data);
             }
             break;
-        case commands.MG_GET_HISTORY:
-            if (isValidTabId(args.tabId)) {
-                getHistoryItems(args.from, args.count, (payload) => {
-                    args.items = payload;
-                    window.chrome.webview.postMessage(event.data);
-                });
+        case commands.MG_GET_SUGGESTIONS:
+            // A reply to an earlier keystroke is out of date
+            if (args.requestId == suggestionRequestId) {
+                showSuggestions(args.items || []);
             }
             break;
-        case commands.MG_REMOVE_HISTORY_ITEM:
-            removeHistoryItem(args.id);
+        case commands.MG_SET_TAB_POLICY:
+            if (isValidTabId(args.tabId)) {
+                setMemoryBudget(args.memoryBudget);
+            }
             break;
-        case commands.MG_CLEAR_HISTORY:
-            clearHistory();
+        case commands.MG_MIGRATE_FAVORITES:
+            onFavoritesMigrated(args.count);
             break;
         default:
             console.log(`Received unexpected message: ${JSON.stringify(event.data)}`);
     }
 };
 
+// Apply the tab state updates merged by the host during a frame. Each update
+// only carries the fields that changed, and each part of the controls UI is
+// refreshed at most once per batch.
+function applyBatchedUpdates(updates) {
+    let reasons = new Set();
+
+    updates.forEach((update) => {
+        const tabId = update.tabId;
+        if (!isValidTabId(tabId)) {
+            return;
+        }
+
+        const tab = tabs.get(tabId);
+        const isActive = tabId == activeTabId;
+
+        if ('uri' in update) {
+            updateTabURI(tabId, update);
+            if (isActive) {
+                reasons.add(commands.MG_UPDATE_URI);
+            }
+        }
+
+        if ('isLoading' in update) {
+            tab.isLoading = update.isLoading;
+            if (isActive) {
+                reasons.add(commands.MG_NAV_STARTING);
+            }
+        }
+
+        if ('state' in update) {
+            tab.securityState = update.state;
+            if (isActive) {
+                reasons.add(commands.MG_SECURITY_UPDATE);
+            }
+        }
+
+        if ('title' in update) {
+            updateTabTitle(tabId, update.title);
+        }
+
+        if ('favicon' in update) {
+            updateFaviconURI(tabId, update.favicon);
+        }
+
+        if ('lifecycle' in update) {
+            updateTabLifecycle(tabId, update.lifecycle);
+        }
+    });
+
+    reasons.forEach((reason) => {
+        updateNavigationUI(reason);
+    });
+}
+
+function updateTabURI(tabId, args) {
+    const tab = tabs.get(tabId);
+
+    // Update the tab state
+    tab.uri = args.uri;
+    tab.uriToShow = args.uriToShow;
+    if ('canGoBack' in args) {
+        tab.canGoBack = args.canGoBack;
+        tab.canGoForward = args.canGoForward;
+    }
+
+    if ('isFavorite' in args) {
+        tab.isFavorite = args.isFavorite;
+    }
+}
+
+function updateTabTitle(tabId, title) {
+    const tab = tabs.get(tabId);
+    const tabElement = document.getElementById(`tab-${tabId}`);
+
+    if (!tabElement) {
+        refreshTabs();
+        return;
+    }
+
+    // Update tab label
+    // Use given title or fall back to a generic tab title
+    tab.title = title || 'Tab';
+    const tabLabel = tabElement.firstChild;
+    const tabLabelSpan = tabLabel.firstChild;
+    tabLabelSpan.textContent = tab.title;
+}
+
 function processAddressBarInput() {
     var text = document.querySelector('#address-field').value;
+
+    // A suggested tab of this window is switched to rather than loaded again
+    let openTab = suggestions.find((suggestion) => suggestion.uri == text && isValidTabId(suggestion.tabId));
+    clearSuggestions();
+    if (openTab) {
+        switchToTab(openTab.tabId, true);
+        return;
+    }
     tryNavigate(text);
 }
 
+function requestSuggestions(text) {
+    suggestionRequestId++;
+    if (!text.trim()) {
+        showSuggestions([]);
+        return;
+    }
+
+    var message = {
+        message: commands.MG_GET_SUGGESTIONS,
+        args: {
+            query: text,
+            requestId: suggestionRequestId
+        }
+    };
+
+    window.chrome.webview.postMessage(message);
+}
+
+function clearSuggestions() {
+    // Replies still on their way are dropped too
+    suggestionRequestId++;
+    showSuggestions([]);
+}
+
+function showSuggestions(items) {
+    suggestions = items;
+    let list = document.getElementById('address-suggestions');
+    list.replaceChildren(...items.map((item) => {
+        let option = document.createElement('option');
+        option.value = item.uri;
+        let title = item.title || item.uri;
+        option.label = isValidTabId(item.tabId) ? `${title} (switch to tab)` : title;
+        return option;
+    }));
+}
+
 function tryNavigate(text) {
     try {
         var uriParser = new URL(text);
@@ -353,23 +451,17 @@ function updateFavoriteIcon() {
         return;
     }
 
-    let activeTab = tabs.get(activeTabId);
-    isFavorite(activeTab.uri, (isFavorite) => {
-        let favoriteElement = document.getElementById('btn-fav');
-        if (!favoriteElement) {
-            refreshControls();
-            return;
-        }
-
-        if (isFavorite) {
-            favoriteElement.classList.add('favorited');
-            activeTab.isFavorite = true;
-        } else {
-            favoriteElement.classList.remove('favorited');
-            activeTab.isFavorite = false;
-        }
-    });
+    let favoriteElement = document.getElementById('btn-fav');
+    if (!favoriteElement) {
+        refreshControls();
+        return;
+    }
 
+    if (tabs.get(activeTabId).isFavorite) {
+        favoriteElement.classList.add('favorited');
+    } else {
+        favoriteElement.classList.remove('favorited');
+    }
 }
 
 function updateNavigationUI(reason) {
@@ -410,6 +502,7 @@ function loadTabUI(tabId) {
         let tabElement = document.createElement('div');
         tabElement.className = tabId == activeTabId ? 'tab-active' : 'tab';
         tabElement.id = `tab-${tabId}`;
+        tabElement.dataset.lifecycle = tab.lifecycle;
 
         let tabLabel = document.createElement('div');
         tabLabel.className = 'tab-label';
@@ -426,6 +519,7 @@ function loadTabUI(tabId) {
 
         tabElement.appendChild(tabLabel);
         tabElement.appendChild(closeButton);
+        addTabDragListeners(tabElement, tabId);
 
         var createTabButton = document.getElementById('btn-new-tab');
         document.getElementById('tabs-strip').insertBefore(tabElement, createTabButton);
@@ -528,8 +622,14 @@ function refreshControls() {
     addressInput.placeholder = 'Search or enter web address';
     addressInput.type = 'text';
     addressInput.spellcheck = false;
+    addressInput.autocomplete = 'off';
+    addressInput.setAttribute('list', 'address-suggestions');
     addressBar.append(addressInput);
 
+    let suggestionList = document.createElement('datalist');
+    suggestionList.id = 'address-suggestions';
+    addressBar.append(suggestionList);
+
     let clearButton = document.createElement('button');
     clearButton.id = 'btn-clear';
     addressBar.append(clearButton);
@@ -595,16 +695,14 @@ function refreshTabs() {
 function toggleFavorite() {
     activeTab = tabs.get(activeTabId);
     if (activeTab.isFavorite) {
-        removeFavorite(activeTab.uri, () => {
-            activeTab.isFavorite = false;
-            updateFavoriteIcon();
-        });
+        removeFavorite(activeTab.uri);
     } else {
-        addFavorite(favoriteFromTab(activeTabId), () => {
-            activeTab.isFavorite = true;
-            updateFavoriteIcon();
-        });
+        addFavorite(favoriteFromTab(activeTabId));
     }
+
+    // The host confirms with an update of every tab showing the page
+    activeTab.isFavorite = !activeTab.isFavorite;
+    updateFavoriteIcon();
 }
 
 function addControlsListeners() {
@@ -619,11 +717,16 @@ function addControlsListeners() {
         }
     });
 
+    inputField.addEventListener('input', function(e) {
+        requestSuggestions(inputField.value);
+    });
+
     inputField.addEventListener('focus', function(e) {
         e.target.select();
     });
 
     inputField.addEventListener('blur', function(e) {
+        clearSuggestions();
         inputField.setSelectionRange(0, 0);
         if (!inputField.value) {
             updateURI();
@@ -632,6 +735,7 @@ function addControlsListeners() {
 
     clearButton.addEventListener('click', function(e) {
         inputField.value = '';
+        clearSuggestions();
         inputField.focus();
         e.preventDefault();
     });
@@ -715,17 +819,49 @@ function addTabsListeners() {
         createNewTab(true);
     });
 
+    addTabDropListeners();
+
     document.querySelector('#btn-fav').addEventListener('click', function(e) {
         toggleFavorite();
     });
 }
 
+function loadTabPolicy() {
+    let saved = parseInt(window.localStorage.getItem('memoryBudget'), 10);
+    if (saved >= 0) {
+        settings.tabPolicy.memoryBudget = saved;
+    }
+}
+
+// Set from browser://settings, kept for the next start
+function setMemoryBudget(memoryBudget) {
+    if (!Number.isInteger(memoryBudget) || memoryBudget < 0) {
+        return;
+    }
+
+    settings.tabPolicy.memoryBudget = memoryBudget;
+    window.localStorage.setItem('memoryBudget', memoryBudget);
+    sendTabPolicy();
+}
+
+function sendTabPolicy() {
+    let message = {
+        message: commands.MG_SET_TAB_POLICY,
+        args: settings.tabPolicy
+    };
+
+    window.chrome.webview.postMessage(message);
+}
+
 function init() {
     window.chrome.webview.addEventListener('message', messageHandler);
     refreshControls();
     refreshTabs();
 
-    createNewTab(true);
+    loadTabPolicy();
+    sendTabPolicy();
+    requestSession();
+    migrateFavorites();
 }
 
 init();
@@ -1,72 +1,76 @@
-function isFavorite(uri, callback) {
-    queryDB((db) => {
-        let transaction = db.transaction(['favorites']);
-        let favoritesStore = transaction.objectStore('favorites');
-        let favoriteStatusRequest = favoritesStore.get(uri);
-
-        favoriteStatusRequest.onerror = function(event) {
-            console.log(`Could not query for ${uri}: ${event.target.error.message}`);
-        };
+// Favorites are kept by the host, which tells whether a tab's page is one
+// with each URI update.
+function addFavorite(favorite) {
+    let message = {
+        message: commands.MG_ADD_FAVORITE,
+        args: {
+            uri: favorite.uri,
+            title: favorite.title,
+            favicon: favorite.favicon
+        }
+    };
 
-        favoriteStatusRequest.onsuccess = function() {
-            callback(favoriteStatusRequest.result);
-        };
-    });
+    window.chrome.webview.postMessage(message);
 }
 
-function addFavorite(favorite, callback) {
-    queryDB((db) => {
-        let transaction = db.transaction(['favorites'], 'readwrite');
-        let favoritesStore = transaction.objectStore('favorites');
-        let addFavoriteRequest = favoritesStore.add(favorite);
+function removeFavorite(uri) {
+    let message = {
+        message: commands.MG_REMOVE_FAVORITE,
+        args: {
+            uri: uri
+        }
+    };
 
-        addFavoriteRequest.onerror = function(event) {
-            console.log(`Could not add favorite with key: ${favorite.uri}`);
-            console.log(event.target.error.message);
-        };
-
-        addFavoriteRequest.onsuccess = function(event) {
-            if (callback) {
-                callback();
-            }
-        };
-    });
+    window.chrome.webview.postMessage(message);
 }
 
-function removeFavorite(key, callback) {
+// Favorites used to be kept in IndexedDB, any left there are handed over to
+// the host, and cleared once it replies that they're written
+function migrateFavorites() {
     queryDB((db) => {
-        let transaction = db.transaction(['favorites'], 'readwrite');
+        let transaction = db.transaction(['favorites']);
         let favoritesStore = transaction.objectStore('favorites');
-        let removeFavoriteRequest = favoritesStore.delete(key);
+        let getFavoritesRequest = favoritesStore.getAll();
 
-        removeFavoriteRequest.onerror = function(event) {
-            console.log(`Could not remove favorite with key: ${key}`);
+        getFavoritesRequest.onerror = function(event) {
+            console.log(`Could not retrieve favorites to migrate`);
             console.log(event.target.error.message);
         };
 
-        removeFavoriteRequest.onsuccess = function(event) {
-            if (callback) {
-                callback();
+        getFavoritesRequest.onsuccess = function(event) {
+            let favorites = getFavoritesRequest.result;
+            if (favorites.length == 0) {
+                return;
             }
+            favorites.forEach(addFavorite);
+
+            let message = {
+                message: commands.MG_MIGRATE_FAVORITES,
+                args: {
+                    count: favorites.length
+                }
+            };
+
+            window.chrome.webview.postMessage(message);
         };
     });
 }
 
-function getFavoritesAsJson(callback) {
+// Keys come in the order getAll read the rows, so these are the ones the
+// host has
+function onFavoritesMigrated(count) {
     queryDB((db) => {
-        let transaction = db.transaction(['favorites']);
+        let transaction = db.transaction(['favorites'], 'readwrite');
         let favoritesStore = transaction.objectStore('favorites');
-        let getFavoritesRequest = favoritesStore.getAll();
+        let getKeysRequest = favoritesStore.getAllKeys(null, count);
 
-        getFavoritesRequest.onerror = function(event) {
-            console.log(`Could retrieve favorites`);
+        getKeysRequest.onerror = function(event) {
+            console.log(`Could not clear migrated favorites`);
             console.log(event.target.error.message);
         };
 
-        getFavoritesRequest.onsuccess = function(event) {
-            if (callback) {
-                callback(getFavoritesRequest.result);
-            }
+        getKeysRequest.onsuccess = function(event) {
+            getKeysRequest.result.forEach((key) => favoritesStore.delete(key));
         };
     });
 }
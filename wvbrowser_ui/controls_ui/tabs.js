@@ -1,7 +1,9 @@
 var tabs = new Map();
 var tabIdCounter = 0;
 var activeTabId = 0;
+var windowId = 0;
 const INVALID_TAB_ID = 0;
+const TAB_DRAG_TYPE = 'application/x-wvbrowser-tab';
 
 function getNewTabId() {
     return ++tabIdCounter;
@@ -11,6 +13,21 @@ function isValidTabId(tabId) {
     return tabId != INVALID_TAB_ID && tabs.has(tabId);
 }
 
+function newTabState() {
+    return {
+        title: 'New Tab',
+        uri: '',
+        uriToShow: '',
+        favicon: 'img/favicon.png',
+        isFavorite: false,
+        isLoading: false,
+        canGoBack: false,
+        canGoForward: false,
+        securityState: 'unknown',
+        lifecycle: 'live'
+    };
+}
+
 function createNewTab(shouldBeActive) {
     const tabId = getNewTabId();
 
@@ -24,18 +41,7 @@ function createNewTab(shouldBeActive) {
 
     window.chrome.webview.postMessage(message);
 
-    tabs.set(parseInt(tabId), {
-        title: 'New Tab',
-        uri: '',
-        uriToShow: '',
-        favicon: 'img/favicon.png',
-        isFavorite: false,
-        isLoading: false,
-        canGoBack: false,
-        canGoForward: false,
-        securityState: 'unknown',
-        historyItemId: INVALID_HISTORY_ID
-    });
+    tabs.set(parseInt(tabId), newTabState());
 
     loadTabUI(tabId);
 
@@ -44,6 +50,38 @@ function createNewTab(shouldBeActive) {
     }
 }
 
+// Asks the host for the tabs of the previous session, it replies with
+// MG_RESTORE_SESSION
+function requestSession() {
+    var message = {
+        message: commands.MG_RESTORE_SESSION,
+        args: {}
+    };
+
+    window.chrome.webview.postMessage(message);
+}
+
+// Rebuilds the tab strip from the saved session. The host only loads the
+// active tab, the others are loaded when first switched to.
+function restoreTabs(session) {
+    windowId = session.windowId || windowId;
+    for (const saved of session.tabs) {
+        let tab = newTabState();
+        tab.title = saved.title || tab.title;
+        tab.uri = saved.uri;
+        tab.uriToShow = saved.uriToShow || '';
+        tab.favicon = saved.favicon || tab.favicon;
+        tab.isFavorite = saved.isFavorite || false;
+        tab.lifecycle = saved.lifecycle;
+        tabs.set(saved.tabId, tab);
+        tabIdCounter = Math.max(tabIdCounter, saved.tabId);
+
+        loadTabUI(saved.tabId);
+    }
+
+    switchToTab(session.activeTabId, false);
+}
+
 function switchToTab(id, updateOnHost) {
     if (!id) {
         console.log('ID not provided');
@@ -97,13 +135,30 @@ function switchToTab(id, updateOnHost) {
 }
 
 function closeTab(id) {
-    // If closing tab was active, switch tab or close window
+    if (!removeTab(id)) {
+        return;
+    }
+
+    var message = {
+        message: commands.MG_CLOSE_TAB,
+        args: {
+            tabId: id
+        }
+    };
+
+    window.chrome.webview.postMessage(message);
+}
+
+// Takes the tab off the strip, returns false if it was the last one and the
+// window is closing
+function removeTab(id) {
+    // If the removed tab was active, switch tab or close window
     if (id == activeTabId) {
         if (tabs.size == 1) {
-            // Last tab is closing, shut window down
+            // Last tab is going, shut window down
             tabs.delete(id);
             closeWindow();
-            return;
+            return false;
         }
 
         // Other tabs are open, switch to rightmost tab
@@ -122,17 +177,77 @@ function closeTab(id) {
     }
     // Remove tab from map
     tabs.delete(id);
+    return true;
+}
 
+// A tab dropped on another window's strip moves there, dropped outside of
+// any window it gets one of its own. The host replies with MG_MOVE_TAB to
+// the window it left.
+function moveTab(tabId, fromWindowId) {
     var message = {
-        message: commands.MG_CLOSE_TAB,
+        message: commands.MG_MOVE_TAB,
         args: {
-            tabId: id
+            tabId: tabId
         }
     };
+    if (fromWindowId) {
+        message.args.windowId = fromWindowId;
+        message.args.newTabId = getNewTabId();
+    }
 
     window.chrome.webview.postMessage(message);
 }
 
+function addTabDragListeners(tabElement, tabId) {
+    tabElement.draggable = true;
+    tabElement.addEventListener('dragstart', function(e) {
+        e.dataTransfer.setData(TAB_DRAG_TYPE, JSON.stringify({ windowId: windowId, tabId: tabId }));
+        e.dataTransfer.effectAllowed = 'move';
+    });
+    tabElement.addEventListener('dragend', function(e) {
+        const isOutside = e.screenX < window.screenX || e.screenY < window.screenY ||
+            e.screenX > window.screenX + window.outerWidth ||
+            e.screenY > window.screenY + window.outerHeight;
+        if (e.dataTransfer.dropEffect == 'none' && isOutside && isValidTabId(tabId)) {
+            moveTab(tabId);
+        }
+    });
+}
+
+function addTabDropListeners() {
+    let strip = document.getElementById('tabs-strip');
+    strip.addEventListener('dragover', function(e) {
+        if (e.dataTransfer.types.includes(TAB_DRAG_TYPE)) {
+            e.preventDefault();
+            e.dataTransfer.dropEffect = 'move';
+        }
+    });
+    strip.addEventListener('drop', function(e) {
+        const data = e.dataTransfer.getData(TAB_DRAG_TYPE);
+        if (!data) {
+            return;
+        }
+        e.preventDefault();
+
+        const dragged = JSON.parse(data);
+        if (dragged.windowId != windowId) {
+            moveTab(dragged.tabId, dragged.windowId);
+        }
+    });
+}
+
+// Background tabs are suspended and then discarded by the host, a discarded
+// tab is re-created when switched to
+function updateTabLifecycle(tabId, lifecycle) {
+    let tab = tabs.get(tabId);
+    tab.lifecycle = lifecycle;
+
+    let tabElement = document.getElementById(`tab-${tabId}`);
+    if (tabElement) {
+        tabElement.dataset.lifecycle = lifecycle;
+    }
+}
+
 function updateFaviconURI(tabId, src) {
     let tab = tabs.get(tabId);
     if (tab.favicon != src) {
@@ -176,11 +291,6 @@ function updateFaviconURI(tabId, src) {
 
 function updatedFaviconURIHandler(tabId, tab) {
     updateNavigationUI(commands.MG_UPDATE_FAVICON);
-
-    // Update favicon in history item
-    if (tab.historyItemId != INVALID_HISTORY_ID) {
-        updateHistoryItem(tab.historyItemId, historyItemFromTab(tabId));
-    }
 }
 
 function favoriteFromTab(tabId) {
@@ -193,24 +303,7 @@ function favoriteFromTab(tabId) {
     let favicon = tab.favicon == 'img/favicon.png' ? '../controls_ui/' + tab.favicon : tab.favicon;
     return {
         uri: tab.uri,
-        uriToShow: tab.uriToShow,
         title: tab.title,
         favicon: favicon
     };
 }
-
-function historyItemFromTab(tabId) {
-    if (!isValidTabId(tabId)) {
-        console.log('Invalid tab ID');
-        return;
-    }
-
-    let tab = tabs.get(tabId);
-    let favicon = tab.favicon == 'img/favicon.png' ? '../controls_ui/' + tab.favicon : tab.favicon;
-    return {
-        uri: tab.uri,
-        title: tab.title,
-        favicon: favicon,
-        timestamp: new Date()
-    }
-}